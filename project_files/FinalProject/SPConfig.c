@@ -1,4 +1,5 @@
 #include <stdlib.h>
+#include <limits.h>
 #include <assert.h>
 #include <stdio.h>
 #include <ctype.h>
@@ -8,11 +9,36 @@
 
 #define DEFAULT_PCA_DIMENSION	20
 #define DEFAULT_PCA_FILENAME	"pca.yml"
+#define DEFAULT_MANIFEST_FILENAME	"features.manifest"
 #define DEFAULT_NUM_OF_FEATURES	100
 #define DEFAULT_NUM_OF_SIM_IMGS	1
 #define DEFAULT_KNN				1
 #define DEFAULT_LOGGER_LEVEL	SP_LOGGER_INFO_WARNING_ERROR_LEVEL
 #define DEFAULT_LOGGER_FILENAME	"stdout"
+#define DEFAULT_PQ_SUBSPACES	4
+#define DEFAULT_PQ_CENTROIDS	256
+#define DEFAULT_PQ_TRAINING		20000
+#define DEFAULT_PQ_RERANK		0
+#define DEFAULT_IVF_LISTS		256
+#define DEFAULT_IVF_PROBES		8
+#define DEFAULT_IVF_TRAINING	20000
+#define DEFAULT_HNSW_M			16
+#define DEFAULT_HNSW_EF_CONS	200
+#define DEFAULT_HNSW_EF_SEARCH	64
+#define DEFAULT_HNSW_THREADS	1
+#define DEFAULT_BOVW_BRANCHING	10
+#define DEFAULT_BOVW_DEPTH		4
+#define DEFAULT_BOVW_TRAINING	100000
+#define DEFAULT_BRUTE_THREADS	1
+#define DEFAULT_NUM_OF_SHARDS	1
+#define DEFAULT_LOAD_THREADS	1
+#define DEFAULT_SAVE_THREADS	1
+#define DEFAULT_QUERY_CACHE_SIZE	16
+#define DEFAULT_MAX_IMAGE_DIMENSION	0
+#define DEFAULT_DETECTION_TILE_SIZE	0
+#define DEFAULT_DETECTION_TILE_OVERLAP	32
+#define DEFAULT_DETECTION_THREADS	4
+#define DEFAULT_QUERY_DEADLINE	0
 #define FILE_TEMPLATE_FOR_ERROR	"File: %s\n"
 #define LINE_TEMPLATE_FOR_ERROR	"Line: %d\n"
 #define INVALID_CONF_MSG		"Message: Invalid configuration line\n"
@@ -31,6 +57,15 @@
 #define RAND_SPLIT_METHOD		"RANDOM"
 #define MAX_SPREAD_SPLIT_METHOD	"MAX_SPREAD"
 #define INC_SPLIT_METHOD		"INCREMENTAL"
+#define DOUBLE_PRECISION		"double"
+#define FLOAT_PRECISION			"float"
+#define HALF_PRECISION			"float16"
+#define KD_TREE_INDEX			"KD_TREE"
+#define PQ_INDEX				"PQ"
+#define IVF_INDEX				"IVF"
+#define HNSW_INDEX				"HNSW"
+#define BOVW_INDEX				"BOVW"
+#define BRUTE_FORCE_INDEX		"BRUTE"
 #define SP_IMAGES_DIRECTORY		"spImagesDirectory"
 #define SP_IMAGES_PREFIX		"spImagesPrefix"
 #define SP_IMAGES_SUFFIX		"spImagesSuffix"
@@ -45,10 +80,43 @@
 #define SP_MINIMAL_GUI			"spMinimalGUI"
 #define SP_LOGGER_LVL			"spLoggerLevel"
 #define SP_LOGGER_FILENAME		"spLoggerFilename"
+#define SP_LOGGER_ASYNC			"spLoggerAsync"
+#define SP_INSTRUMENTATION_FILENAME	"spInstrumentationFilename"
+#define SP_DESCRIPTOR_PRECISION	"spDescriptorPrecision"
+#define SP_INDEX_TYPE			"spIndexType"
+#define SP_PQ_SUBSPACES			"spPQSubspaces"
+#define SP_PQ_CENTROIDS			"spPQCentroids"
+#define SP_PQ_TRAINING_SIZE		"spPQTrainingSize"
+#define SP_PQ_RERANK			"spPQReRank"
+#define SP_IVF_LISTS			"spIVFLists"
+#define SP_IVF_PROBES			"spIVFProbes"
+#define SP_IVF_TRAINING_SIZE	"spIVFTrainingSize"
+#define SP_HNSW_M				"spHNSWM"
+#define SP_HNSW_EF_CONSTRUCTION	"spHNSWEfConstruction"
+#define SP_HNSW_EF_SEARCH		"spHNSWEfSearch"
+#define SP_HNSW_BUILD_THREADS	"spHNSWBuildThreads"
+#define SP_HNSW_FILENAME		"spHNSWFilename"
+#define SP_BOVW_BRANCHING		"spBoVWBranching"
+#define SP_BOVW_DEPTH			"spBoVWDepth"
+#define SP_BOVW_TRAINING_SIZE	"spBoVWTrainingSize"
+#define SP_BRUTE_FORCE_THREADS	"spBruteForceThreads"
+#define SP_NUM_OF_SHARDS		"spNumOfShards"
+#define SP_LOAD_THREADS			"spLoadThreads"
+#define SP_SAVE_THREADS			"spSaveThreads"
+#define SP_MANIFEST_FILENAME	"spManifestFilename"
+#define SP_QUERY_CACHE_SIZE		"spQueryCacheSize"
+#define SP_QUERY_CACHE_DIRECTORY	"spQueryCacheDirectory"
+#define SP_MAX_IMAGE_DIMENSION	"spMaxImageDimension"
+#define SP_DETECTION_TILE_SIZE	"spDetectionTileSize"
+#define SP_DETECTION_TILE_OVERLAP	"spDetectionTileOverlap"
+#define SP_DETECTION_THREADS	"spDetectionThreads"
+#define SP_QUERY_DEADLINE		"spQueryDeadline"
 #define MAX_LINE_LENGTH			1025 // 1024 from project specs + 1 for '\0'
 #define OPEN_FILE_READ_MODE		"r"
 #define IMAGE_PATH_FORMAT		"%s%s%d%s"
 #define PCA_PATH_FORMAT			"%s%s"
+#define HNSW_PATH_FORMAT		"%s%s"
+#define MANIFEST_PATH_FORMAT	"%s%s"
 #define MISSING_DIR_MSG			"SP_CONFIG_MISSING_DIR"
 #define MISSING_PREFIX_MSG		"SP_CONFIG_MISSING_PREFIX"
 #define MISSING_SUFFIX_MSG		"SP_CONFIG_MISSING_SUFFIX"
@@ -63,16 +131,37 @@
 #define INVALID_LINE_MSG		"SP_CONFIG_INVALID_LINE"
 #define INVALID_BOOL_MSG		"SP_CONFIG_INVALID_BOOLEAN"
 #define INVALID_SPLIT_MTD_MSG	"SP_CONFIG_INVALID_KDTREE_SPLIT_METHOD"
+#define INVALID_PRECISION_MSG	"SP_CONFIG_INVALID_DESCRIPTOR_PRECISION"
+#define INVALID_INDEX_TYPE_MSG	"SP_CONFIG_INVALID_INDEX_TYPE"
 #define SIGNATURE_FORMAT		"==[%s][%d][%d][%d]==\n"
+#define CAPPED_SIGNATURE_FORMAT	"==[%s][%d][%d][%d][%d]==\n"
 #define ERROR_CREATING_SIGN     "Error creating config signature"
 #define ERROR_INVALID_CONF_ARG	"The given configuration instance is not valid"
 #define ERROR_INVALID_PATH_PTR	"The given path pointer is not valid"
 #define ERROR_OUT_OF_RANGE		"The given index is bigger than the number of images"
+#define ERROR_HNSW_FILENAME_NOT_SET "The HNSW index filename is not set"
 #define WARNING_CROP_NOT_NEEDED "Warning - crop similar images is called while not needed"
 #define PCA_DIM_MIN_VALID_VAL	10
 #define PCA_DIM_MAX_VALID_VAL	28
 #define LOG_LVL_MIN_VALID_VAL	1
 #define LOG_LVL_MAX_VALID_VAL	4
+#define PQ_CENTROIDS_MAX_VAL	256 // codes are stored as a single byte
+#define HNSW_M_MIN_VAL			2
+#define HNSW_M_MAX_VAL			256
+#define HNSW_THREADS_MAX_VAL	64
+#define BOVW_BRANCHING_MIN_VAL	2
+#define BOVW_BRANCHING_MAX_VAL	64
+#define BOVW_DEPTH_MAX_VAL		20 // 2^20 words, the vocabulary size limit
+#define BRUTE_THREADS_MAX_VAL	64
+#define SHARDS_MAX_VAL			64
+#define LOAD_THREADS_MAX_VAL	64
+#define SAVE_THREADS_MAX_VAL	64
+#define QUERY_CACHE_SIZE_MAX_VAL	4096 // megabytes
+#define MAX_IMAGE_DIMENSION_MAX_VAL	65535 // the largest JPEG side
+#define DETECTION_TILE_SIZE_MAX_VAL	65535
+#define DETECTION_TILE_OVERLAP_MAX_VAL	1024
+#define DETECTION_THREADS_MAX_VAL	64
+#define QUERY_DEADLINE_MAX_VAL	3600000 // milliseconds
 
 #define VALIDATE_INT(condition)	do { \
                 if(!isValidInt(value, &tmpInt) || (condition)) { \
@@ -109,6 +198,37 @@ struct sp_config_t {
 	bool spMinimalGUI;
 	SP_LOGGER_LEVEL spLoggerLevel;
 	char* spLoggerFilename;
+	bool spLoggerAsync;
+	char* spInstrumentationFilename;
+	SP_POINT_PRECISION spDescriptorPrecision;
+	SP_SEARCH_INDEX_TYPE spIndexType;
+	int spPQSubspaces;
+	int spPQCentroids;
+	int spPQTrainingSize;
+	int spPQReRank;
+	int spIVFLists;
+	int spIVFProbes;
+	int spIVFTrainingSize;
+	int spHNSWM;
+	int spHNSWEfConstruction;
+	int spHNSWEfSearch;
+	int spHNSWBuildThreads;
+	char* spHNSWFilename;
+	int spBoVWBranching;
+	int spBoVWDepth;
+	int spBoVWTrainingSize;
+	int spBruteForceThreads;
+	int spNumOfShards;
+	int spLoadThreads;
+	int spSaveThreads;
+	char* spManifestFilename;
+	int spQueryCacheSize;
+	char* spQueryCacheDirectory;
+	int spMaxImageDimension;
+	int spDetectionTileSize;
+	int spDetectionTileOverlap;
+	int spDetectionThreads;
+	int spQueryDeadline;
 };
 
 char* duplicateString(const char *str) {
@@ -145,6 +265,37 @@ void initConfigToDefault(SPConfig config) {
 	config->spMinimalGUI = false;
 	config->spLoggerLevel = DEFAULT_LOGGER_LEVEL;
 	config->spLoggerFilename = NULL;
+	config->spLoggerAsync = false;
+	config->spInstrumentationFilename = NULL;
+	config->spDescriptorPrecision = SP_POINT_PRECISION_DOUBLE;
+	config->spIndexType = SP_INDEX_KD_TREE;
+	config->spPQSubspaces = DEFAULT_PQ_SUBSPACES;
+	config->spPQCentroids = DEFAULT_PQ_CENTROIDS;
+	config->spPQTrainingSize = DEFAULT_PQ_TRAINING;
+	config->spPQReRank = DEFAULT_PQ_RERANK;
+	config->spIVFLists = DEFAULT_IVF_LISTS;
+	config->spIVFProbes = DEFAULT_IVF_PROBES;
+	config->spIVFTrainingSize = DEFAULT_IVF_TRAINING;
+	config->spHNSWM = DEFAULT_HNSW_M;
+	config->spHNSWEfConstruction = DEFAULT_HNSW_EF_CONS;
+	config->spHNSWEfSearch = DEFAULT_HNSW_EF_SEARCH;
+	config->spHNSWBuildThreads = DEFAULT_HNSW_THREADS;
+	config->spHNSWFilename = NULL;
+	config->spBoVWBranching = DEFAULT_BOVW_BRANCHING;
+	config->spBoVWDepth = DEFAULT_BOVW_DEPTH;
+	config->spBoVWTrainingSize = DEFAULT_BOVW_TRAINING;
+	config->spBruteForceThreads = DEFAULT_BRUTE_THREADS;
+	config->spNumOfShards = DEFAULT_NUM_OF_SHARDS;
+	config->spLoadThreads = DEFAULT_LOAD_THREADS;
+	config->spSaveThreads = DEFAULT_SAVE_THREADS;
+	config->spManifestFilename = NULL;
+	config->spQueryCacheSize = DEFAULT_QUERY_CACHE_SIZE;
+	config->spQueryCacheDirectory = NULL;
+	config->spMaxImageDimension = DEFAULT_MAX_IMAGE_DIMENSION;
+	config->spDetectionTileSize = DEFAULT_DETECTION_TILE_SIZE;
+	config->spDetectionTileOverlap = DEFAULT_DETECTION_TILE_OVERLAP;
+	config->spDetectionThreads = DEFAULT_DETECTION_THREADS;
+	config->spQueryDeadline = DEFAULT_QUERY_DEADLINE;
 }
 
 void printErrorMessage(const char* filename, int lineNum, ERROR_MSG_TYPE errorMsgType,
@@ -267,6 +418,14 @@ bool handlePCADimension(SPConfig config, const char* filename, int lineNum, char
 	return true;
 }
 
+bool handleIntFieldInRange(int* intField, const char* filename, int lineNum, char* value,
+		SP_CONFIG_MSG* msg, int minValue, int maxValue) {
+	int tmpInt;
+	VALIDATE_INT(tmpInt < minValue || tmpInt > maxValue);
+	*intField = tmpInt;
+	return true;
+}
+
 bool handleBoolField(bool* boolField, const char* filename, int lineNum, char* value,
 		SP_CONFIG_MSG* msg) {
 	if (!strcmp(value, TRUE_AS_STR))
@@ -304,6 +463,55 @@ bool handleKDTreeSplitMethod(SPConfig config, const char* filename, int lineNum,
 	return true;
 }
 
+bool handleDescriptorPrecision(SPConfig config, const char* filename, int lineNum,
+		char* value, SP_CONFIG_MSG* msg) {
+	if (!strcmp(value, DOUBLE_PRECISION))
+		config->spDescriptorPrecision = SP_POINT_PRECISION_DOUBLE;
+
+	else if (!strcmp(value, FLOAT_PRECISION))
+		config->spDescriptorPrecision = SP_POINT_PRECISION_FLOAT;
+
+	else if (!strcmp(value, HALF_PRECISION))
+		config->spDescriptorPrecision = SP_POINT_PRECISION_HALF;
+
+	else {
+		*msg = SP_CONFIG_INVALID_DESCRIPTOR_PRECISION;
+		printErrorMessage(filename, lineNum, INVALID_VALUE, NULL);
+		return false;
+	}
+
+	return true;
+}
+
+bool handleIndexType(SPConfig config, const char* filename, int lineNum,
+		char* value, SP_CONFIG_MSG* msg) {
+	if (!strcmp(value, KD_TREE_INDEX))
+		config->spIndexType = SP_INDEX_KD_TREE;
+
+	else if (!strcmp(value, PQ_INDEX))
+		config->spIndexType = SP_INDEX_PQ;
+
+	else if (!strcmp(value, IVF_INDEX))
+		config->spIndexType = SP_INDEX_IVF;
+
+	else if (!strcmp(value, HNSW_INDEX))
+		config->spIndexType = SP_INDEX_HNSW;
+
+	else if (!strcmp(value, BOVW_INDEX))
+		config->spIndexType = SP_INDEX_BOVW;
+
+	else if (!strcmp(value, BRUTE_FORCE_INDEX))
+		config->spIndexType = SP_INDEX_BRUTE_FORCE;
+
+	else {
+		*msg = SP_CONFIG_INVALID_INDEX_TYPE;
+		printErrorMessage(filename, lineNum, INVALID_VALUE, NULL);
+		return false;
+	}
+
+	return true;
+}
+
 bool handleLoggerLevel(SPConfig config, const char* filename, int lineNum, char* value,
 		SP_CONFIG_MSG* msg) {
 	int tmpInt;
@@ -383,6 +591,128 @@ bool handleVariable(SPConfig config, const char* filename, int lineNum, char* va
 		return handleStringField(&(config->spLoggerFilename), filename,
 				lineNum, value, msg, false);
 
+	if (!strcmp(varName, SP_LOGGER_ASYNC))
+		return handleBoolField(&(config->spLoggerAsync), filename, lineNum,
+				value, msg);
+
+	if (!strcmp(varName, SP_INSTRUMENTATION_FILENAME))
+		return handleStringField(&(config->spInstrumentationFilename), filename, lineNum,
+				value, msg, false);
+
+	if (!strcmp(varName, SP_DESCRIPTOR_PRECISION))
+		return handleDescriptorPrecision(config, filename, lineNum, value, msg);
+
+	if (!strcmp(varName, SP_INDEX_TYPE))
+		return handleIndexType(config, filename, lineNum, value, msg);
+
+	if (!strcmp(varName, SP_PQ_SUBSPACES))
+		return handlePositiveIntField(&(config->spPQSubspaces), filename, lineNum,
+				value, msg);
+
+	if (!strcmp(varName, SP_PQ_CENTROIDS))
+		return handleIntFieldInRange(&(config->spPQCentroids), filename, lineNum,
+				value, msg, 1, PQ_CENTROIDS_MAX_VAL);
+
+	if (!strcmp(varName, SP_PQ_TRAINING_SIZE))
+		return handlePositiveIntField(&(config->spPQTrainingSize), filename, lineNum,
+				value, msg);
+
+	if (!strcmp(varName, SP_PQ_RERANK))
+		return handleIntFieldInRange(&(config->spPQReRank), filename, lineNum,
+				value, msg, 0, INT_MAX);
+
+	if (!strcmp(varName, SP_IVF_LISTS))
+		return handlePositiveIntField(&(config->spIVFLists), filename, lineNum,
+				value, msg);
+
+	if (!strcmp(varName, SP_IVF_PROBES))
+		return handlePositiveIntField(&(config->spIVFProbes), filename, lineNum,
+				value, msg);
+
+	if (!strcmp(varName, SP_IVF_TRAINING_SIZE))
+		return handlePositiveIntField(&(config->spIVFTrainingSize), filename, lineNum,
+				value, msg);
+
+	if (!strcmp(varName, SP_HNSW_M))
+		return handleIntFieldInRange(&(config->spHNSWM), filename, lineNum,
+				value, msg, HNSW_M_MIN_VAL, HNSW_M_MAX_VAL);
+
+	if (!strcmp(varName, SP_HNSW_EF_CONSTRUCTION))
+		return handlePositiveIntField(&(config->spHNSWEfConstruction), filename, lineNum,
+				value, msg);
+
+	if (!strcmp(varName, SP_HNSW_EF_SEARCH))
+		return handlePositiveIntField(&(config->spHNSWEfSearch), filename, lineNum,
+				value, msg);
+
+	if (!strcmp(varName, SP_HNSW_BUILD_THREADS))
+		return handleIntFieldInRange(&(config->spHNSWBuildThreads), filename, lineNum,
+				value, msg, 1, HNSW_THREADS_MAX_VAL);
+
+	if (!strcmp(varName, SP_HNSW_FILENAME))
+		return handleStringField(&(config->spHNSWFilename), filename, lineNum,
+				value, msg, false);
+
+	if (!strcmp(varName, SP_BOVW_BRANCHING))
+		return handleIntFieldInRange(&(config->spBoVWBranching), filename, lineNum,
+				value, msg, BOVW_BRANCHING_MIN_VAL, BOVW_BRANCHING_MAX_VAL);
+
+	if (!strcmp(varName, SP_BOVW_DEPTH))
+		return handleIntFieldInRange(&(config->spBoVWDepth), filename, lineNum,
+				value, msg, 1, BOVW_DEPTH_MAX_VAL);
+
+	if (!strcmp(varName, SP_BOVW_TRAINING_SIZE))
+		return handlePositiveIntField(&(config->spBoVWTrainingSize), filename, lineNum,
+				value, msg);
+
+	if (!strcmp(varName, SP_BRUTE_FORCE_THREADS))
+		return handleIntFieldInRange(&(config->spBruteForceThreads), filename, lineNum,
+				value, msg, 1, BRUTE_THREADS_MAX_VAL);
+
+	if (!strcmp(varName, SP_NUM_OF_SHARDS))
+		return handleIntFieldInRange(&(config->spNumOfShards), filename, lineNum,
+				value, msg, 1, SHARDS_MAX_VAL);
+
+	if (!strcmp(varName, SP_LOAD_THREADS))
+		return handleIntFieldInRange(&(config->spLoadThreads), filename, lineNum,
+				value, msg, 1, LOAD_THREADS_MAX_VAL);
+
+	if (!strcmp(varName, SP_SAVE_THREADS))
+		return handleIntFieldInRange(&(config->spSaveThreads), filename, lineNum,
+				value, msg, 1, SAVE_THREADS_MAX_VAL);
+
+	if (!strcmp(varName, SP_MANIFEST_FILENAME))
+		return handleStringField(&(config->spManifestFilename), filename, lineNum,
+				value, msg, false);
+
+	if (!strcmp(varName, SP_QUERY_CACHE_SIZE))
+		return handleIntFieldInRange(&(config->spQueryCacheSize), filename, lineNum,
+				value, msg, 0, QUERY_CACHE_SIZE_MAX_VAL);
+
+	if (!strcmp(varName, SP_QUERY_CACHE_DIRECTORY))
+		return handleStringField(&(config->spQueryCacheDirectory), filename, lineNum,
+				value, msg, false);
+
+	if (!strcmp(varName, SP_MAX_IMAGE_DIMENSION))
+		return handleIntFieldInRange(&(config->spMaxImageDimension), filename, lineNum,
+				value, msg, 0, MAX_IMAGE_DIMENSION_MAX_VAL);
+
+	if (!strcmp(varName, SP_DETECTION_TILE_SIZE))
+		return handleIntFieldInRange(&(config->spDetectionTileSize), filename, lineNum,
+				value, msg, 0, DETECTION_TILE_SIZE_MAX_VAL);
+
+	if (!strcmp(varName, SP_DETECTION_TILE_OVERLAP))
+		return handleIntFieldInRange(&(config->spDetectionTileOverlap), filename, lineNum,
+				value, msg, 0, DETECTION_TILE_OVERLAP_MAX_VAL);
+
+	if (!strcmp(varName, SP_DETECTION_THREADS))
+		return handleIntFieldInRange(&(config->spDetectionThreads), filename, lineNum,
+				value, msg, 1, DETECTION_THREADS_MAX_VAL);
+
+	if (!strcmp(varName, SP_QUERY_DEADLINE))
+		return handleIntFieldInRange(&(config->spQueryDeadline), filename, lineNum,
+				value, msg, 0, QUERY_DEADLINE_MAX_VAL);
+
 	*msg = SP_CONFIG_INVALID_LINE;
 	printErrorMessage(filename, lineNum, INVALID_CONF_FILE, NULL);
 	return false;
@@ -397,7 +727,7 @@ SPConfig onError(SPConfig config, FILE* configFile) {
 
 SPConfig parameterSetCheck(SPConfig config, SP_CONFIG_MSG* msg, const char* filename,
 		int lineNum, FILE* configFile) {
-	const char* parameterName;
+	const char* parameterName = NULL;
 
 	if (!config->spImagesDirectory) {
 		parameterName = SP_IMAGES_DIRECTORY;
@@ -469,7 +799,9 @@ SPConfig spConfigCreate(const char* filename, SP_CONFIG_MSG* msg) {
 	}
 
 	if (!checkAndSetDefIfNeeded(&(config->spPCAFilename), DEFAULT_PCA_FILENAME, msg) ||
-		!checkAndSetDefIfNeeded(&(config->spLoggerFilename), DEFAULT_LOGGER_FILENAME, msg)) {
+		!checkAndSetDefIfNeeded(&(config->spLoggerFilename), DEFAULT_LOGGER_FILENAME, msg) ||
+		!checkAndSetDefIfNeeded(&(config->spManifestFilename), DEFAULT_MANIFEST_FILENAME,
+				msg)) {
 		return onError(config, configFile);
 	}
 
@@ -521,6 +853,127 @@ SP_KDTREE_SPLIT_METHOD spConfigGetSplitMethod(const SPConfig config, SP_CONFIG_M
 			MAX_SPREAD;
 }
 
+SP_POINT_PRECISION spConfigGetDescriptorPrecision(const SPConfig config,
+		SP_CONFIG_MSG* msg) {
+	return isValid(config, msg, __FUNCTION__, __LINE__) ? config->spDescriptorPrecision :
+			SP_POINT_PRECISION_DOUBLE;
+}
+
+SP_SEARCH_INDEX_TYPE spConfigGetIndexType(const SPConfig config, SP_CONFIG_MSG* msg) {
+	return isValid(config, msg, __FUNCTION__, __LINE__) ? config->spIndexType :
+			SP_INDEX_KD_TREE;
+}
+
+int spConfigGetPQSubspaces(const SPConfig config, SP_CONFIG_MSG* msg) {
+	return isValid(config, msg, __FUNCTION__, __LINE__) ? config->spPQSubspaces : -1;
+}
+
+int spConfigGetPQCentroids(const SPConfig config, SP_CONFIG_MSG* msg) {
+	return isValid(config, msg, __FUNCTION__, __LINE__) ? config->spPQCentroids : -1;
+}
+
+int spConfigGetPQTrainingSize(const SPConfig config, SP_CONFIG_MSG* msg) {
+	return isValid(config, msg, __FUNCTION__, __LINE__) ? config->spPQTrainingSize : -1;
+}
+
+int spConfigGetPQReRank(const SPConfig config, SP_CONFIG_MSG* msg) {
+	return isValid(config, msg, __FUNCTION__, __LINE__) ? config->spPQReRank : -1;
+}
+
+int spConfigGetIVFLists(const SPConfig config, SP_CONFIG_MSG* msg) {
+	return isValid(config, msg, __FUNCTION__, __LINE__) ? config->spIVFLists : -1;
+}
+
+int spConfigGetIVFProbes(const SPConfig config, SP_CONFIG_MSG* msg) {
+	return isValid(config, msg, __FUNCTION__, __LINE__) ? config->spIVFProbes : -1;
+}
+
+int spConfigGetIVFTrainingSize(const SPConfig config, SP_CONFIG_MSG* msg) {
+	return isValid(config, msg, __FUNCTION__, __LINE__) ? config->spIVFTrainingSize : -1;
+}
+
+int spConfigGetHNSWM(const SPConfig config, SP_CONFIG_MSG* msg) {
+	return isValid(config, msg, __FUNCTION__, __LINE__) ? config->spHNSWM : -1;
+}
+
+int spConfigGetHNSWEfConstruction(const SPConfig config, SP_CONFIG_MSG* msg) {
+	return isValid(config, msg, __FUNCTION__, __LINE__) ? config->spHNSWEfConstruction :
+			-1;
+}
+
+int spConfigGetHNSWEfSearch(const SPConfig config, SP_CONFIG_MSG* msg) {
+	return isValid(config, msg, __FUNCTION__, __LINE__) ? config->spHNSWEfSearch : -1;
+}
+
+int spConfigGetHNSWBuildThreads(const SPConfig config, SP_CONFIG_MSG* msg) {
+	return isValid(config, msg, __FUNCTION__, __LINE__) ? config->spHNSWBuildThreads : -1;
+}
+
+char* spConfigGetHNSWFilename(const SPConfig config, SP_CONFIG_MSG* msg) {
+	return isValid(config, msg, __FUNCTION__, __LINE__) ? config->spHNSWFilename : NULL;
+}
+
+int spConfigGetBoVWBranching(const SPConfig config, SP_CONFIG_MSG* msg) {
+	return isValid(config, msg, __FUNCTION__, __LINE__) ? config->spBoVWBranching : -1;
+}
+
+int spConfigGetBoVWDepth(const SPConfig config, SP_CONFIG_MSG* msg) {
+	return isValid(config, msg, __FUNCTION__, __LINE__) ? config->spBoVWDepth : -1;
+}
+
+int spConfigGetBoVWTrainingSize(const SPConfig config, SP_CONFIG_MSG* msg) {
+	return isValid(config, msg, __FUNCTION__, __LINE__) ? config->spBoVWTrainingSize : -1;
+}
+
+int spConfigGetBruteForceThreads(const SPConfig config, SP_CONFIG_MSG* msg) {
+	return isValid(config, msg, __FUNCTION__, __LINE__) ? config->spBruteForceThreads : -1;
+}
+
+int spConfigGetNumOfShards(const SPConfig config, SP_CONFIG_MSG* msg) {
+	return isValid(config, msg, __FUNCTION__, __LINE__) ? config->spNumOfShards : -1;
+}
+
+int spConfigGetLoadThreads(const SPConfig config, SP_CONFIG_MSG* msg) {
+	return isValid(config, msg, __FUNCTION__, __LINE__) ? config->spLoadThreads : -1;
+}
+
+int spConfigGetSaveThreads(const SPConfig config, SP_CONFIG_MSG* msg) {
+	return isValid(config, msg, __FUNCTION__, __LINE__) ? config->spSaveThreads : -1;
+}
+
+char* spConfigGetManifestFilename(const SPConfig config, SP_CONFIG_MSG* msg) {
+	return isValid(config, msg, __FUNCTION__, __LINE__) ? config->spManifestFilename : NULL;
+}
+
+int spConfigGetQueryCacheSize(const SPConfig config, SP_CONFIG_MSG* msg) {
+	return isValid(config, msg, __FUNCTION__, __LINE__) ? config->spQueryCacheSize : -1;
+}
+
+char* spConfigGetQueryCacheDirectory(const SPConfig config, SP_CONFIG_MSG* msg) {
+	return isValid(config, msg, __FUNCTION__, __LINE__) ? config->spQueryCacheDirectory :
+			NULL;
+}
+
+int spConfigGetMaxImageDimension(const SPConfig config, SP_CONFIG_MSG* msg) {
+	return isValid(config, msg, __FUNCTION__, __LINE__) ? config->spMaxImageDimension : -1;
+}
+
+int spConfigGetDetectionTileSize(const SPConfig config, SP_CONFIG_MSG* msg) {
+	return isValid(config, msg, __FUNCTION__, __LINE__) ? config->spDetectionTileSize : -1;
+}
+
+int spConfigGetDetectionTileOverlap(const SPConfig config, SP_CONFIG_MSG* msg) {
+	return isValid(config, msg, __FUNCTION__, __LINE__) ? config->spDetectionTileOverlap : -1;
+}
+
+int spConfigGetDetectionThreads(const SPConfig config, SP_CONFIG_MSG* msg) {
+	return isValid(config, msg, __FUNCTION__, __LINE__) ? config->spDetectionThreads : -1;
+}
+
+int spConfigGetQueryDeadline(const SPConfig config, SP_CONFIG_MSG* msg) {
+	return isValid(config, msg, __FUNCTION__, __LINE__) ? config->spQueryDeadline : -1;
+}
+
 SP_LOGGER_LEVEL spConfigGetLoggerLevel(const SPConfig config, SP_CONFIG_MSG* msg) {
 	return isValid(config, msg, __FUNCTION__, __LINE__) ? config->spLoggerLevel :
 			SP_LOGGER_INFO_WARNING_ERROR_LEVEL;
@@ -530,6 +983,15 @@ char* spConfigGetLoggerFilename(const SPConfig config, SP_CONFIG_MSG* msg) {
 	return isValid(config, msg, __FUNCTION__, __LINE__) ? config->spLoggerFilename : NULL;
 }
 
+bool spConfigIsLoggerAsync(const SPConfig config, SP_CONFIG_MSG* msg) {
+	return isValid(config, msg, __FUNCTION__, __LINE__) ? config->spLoggerAsync : false;
+}
+
+char* spConfigGetInstrumentationFilename(const SPConfig config, SP_CONFIG_MSG* msg) {
+	return isValid(config, msg, __FUNCTION__, __LINE__) ? config->spInstrumentationFilename :
+			NULL;
+}
+
 SP_CONFIG_MSG spConfigGetImagePathFeats(char* imagePath, const SPConfig config, int index,
 		bool isFeats) {
 	spVerifyArguments(imagePath != NULL, ERROR_INVALID_PATH_PTR,
@@ -563,6 +1025,28 @@ SP_CONFIG_MSG spConfigGetPCAPath(char* pcaPath, const SPConfig config) {
 	return SP_CONFIG_SUCCESS;
 }
 
+SP_CONFIG_MSG spConfigGetHNSWPath(char* hnswPath, const SPConfig config) {
+	spVerifyArguments(hnswPath != NULL, ERROR_INVALID_PATH_PTR, SP_CONFIG_INVALID_ARGUMENT);
+	spVerifyArguments(config != NULL, ERROR_INVALID_CONF_ARG, SP_CONFIG_INVALID_ARGUMENT);
+	spVerifyArguments(config->spHNSWFilename != NULL, ERROR_HNSW_FILENAME_NOT_SET,
+			SP_CONFIG_INVALID_ARGUMENT);
+
+	sprintf(hnswPath, HNSW_PATH_FORMAT, config->spImagesDirectory,
+			config->spHNSWFilename);
+	return SP_CONFIG_SUCCESS;
+}
+
+SP_CONFIG_MSG spConfigGetManifestPath(char* manifestPath, const SPConfig config) {
+	spVerifyArguments(manifestPath != NULL, ERROR_INVALID_PATH_PTR,
+			SP_CONFIG_INVALID_ARGUMENT);
+	spVerifyArguments(config != NULL, ERROR_INVALID_CONF_ARG, SP_CONFIG_INVALID_ARGUMENT);
+
+	// if config is valid, then so are config->spImagesDirectory and config->spManifestFilename
+	sprintf(manifestPath, MANIFEST_PATH_FORMAT, config->spImagesDirectory,
+			config->spManifestFilename);
+	return SP_CONFIG_SUCCESS;
+}
+
 char* getSignature(const SPConfig config) {
 	char lastImagePath[MAX_PATH_LEN], *signature = NULL;
 	int PCADim, numOfImages, numOfFeatures;
@@ -582,8 +1066,15 @@ char* getSignature(const SPConfig config) {
 
 	spCallocEr(signature, char, (MAX_PATH_LEN*2), ERROR_CREATING_SIGN, NULL);
 
-	spValRn(sprintf(signature, SIGNATURE_FORMAT, lastImagePath, numOfImages,
-			numOfFeatures, PCADim) >= 0, ERROR_CREATING_SIGN);
+	// the images are extracted at full resolution unless they are capped, so the files of
+	// an uncapped configuration keep their signature
+	if (config->spMaxImageDimension > 0)
+		spValWcRn(sprintf(signature, CAPPED_SIGNATURE_FORMAT, lastImagePath, numOfImages,
+				numOfFeatures, PCADim, config->spMaxImageDimension) >= 0,
+				ERROR_CREATING_SIGN, free(signature));
+	else
+		spValWcRn(sprintf(signature, SIGNATURE_FORMAT, lastImagePath, numOfImages,
+				numOfFeatures, PCADim) >= 0, ERROR_CREATING_SIGN, free(signature));
 
 	return signature;
 }
@@ -595,6 +1086,10 @@ void spConfigDestroy(SPConfig config) {
 		spFree(config->spImagesSuffix);
 		spFree(config->spPCAFilename);
 		spFree(config->spLoggerFilename);
+		spFree(config->spHNSWFilename);
+		spFree(config->spManifestFilename);
+		spFree(config->spQueryCacheDirectory);
+		spFree(config->spInstrumentationFilename);
 		free(config);
 	}
 }
@@ -629,6 +1124,10 @@ const char* configMsgToStr(SP_CONFIG_MSG msg) {
 		return INVALID_BOOL_MSG;
 	case SP_CONFIG_INVALID_KDTREE_SPLIT_METHOD:
 		return INVALID_SPLIT_MTD_MSG;
+	case SP_CONFIG_INVALID_DESCRIPTOR_PRECISION:
+		return INVALID_PRECISION_MSG;
+	case SP_CONFIG_INVALID_INDEX_TYPE:
+		return INVALID_INDEX_TYPE_MSG;
 	}
 	return NULL;
 }
@@ -643,6 +1142,12 @@ SP_CONFIG_MSG spConfigCropSimilarImages(const SPConfig config) {
 	return SP_CONFIG_SUCCESS;
 }
 
+SP_CONFIG_MSG spConfigSetExtractionMode(const SPConfig config, bool extractionMode) {
+	spVerifyArguments(config != NULL, ERROR_INVALID_CONF_ARG, SP_CONFIG_INVALID_ARGUMENT);
+	config->spExtractionMode = extractionMode;
+	return SP_CONFIG_SUCCESS;
+}
+
 char* spConfigGetImagesDirectory(const SPConfig config, SP_CONFIG_MSG* msg) {
 	return isValid(config, msg, __FUNCTION__, __LINE__) ? config->spImagesDirectory : NULL;
 }
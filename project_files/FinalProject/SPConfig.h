@@ -4,6 +4,7 @@
 #include <stdbool.h>
 #include <stdio.h>
 #include "SPLogger.h"
+#include "SPPoint.h"
 
 /*
  * An enum for the messages that can be returned
@@ -23,7 +24,9 @@ typedef enum sp_config_msg_t {
 	SP_CONFIG_SUCCESS,
 	SP_CONFIG_INVALID_LINE,
 	SP_CONFIG_INVALID_BOOLEAN,
-	SP_CONFIG_INVALID_KDTREE_SPLIT_METHOD
+	SP_CONFIG_INVALID_KDTREE_SPLIT_METHOD,
+	SP_CONFIG_INVALID_DESCRIPTOR_PRECISION,
+	SP_CONFIG_INVALID_INDEX_TYPE
 } SP_CONFIG_MSG;
 
 /*
@@ -44,6 +47,18 @@ typedef enum sp_kdtree_split_method_t {
 	INCREMENTAL
 } SP_KDTREE_SPLIT_METHOD;
 
+/*
+ * An enum for the available nearest neighbours search indices
+ */
+typedef enum sp_search_index_type_t {
+	SP_INDEX_KD_TREE,
+	SP_INDEX_PQ,
+	SP_INDEX_IVF,
+	SP_INDEX_HNSW,
+	SP_INDEX_BOVW,
+	SP_INDEX_BRUTE_FORCE
+} SP_SEARCH_INDEX_TYPE;
+
 typedef struct sp_config_t* SPConfig;
 
 /*
@@ -207,6 +222,25 @@ bool handlePCADimension(SPConfig config, const char* filename, int lineNum, char
 bool handleBoolField(bool* boolField, const char* filename, int lineNum, char* value,
 		SP_CONFIG_MSG* msg);
 
+/*
+ * Checks if the given value is an integer between minValue and maxValue (inclusive)
+ * and if so sets the given integer field value to the given value
+ *
+ * pre assumptions - all pointer arguments are valid
+ *
+ * @param intField - pointer to integer field to set the value to
+ * @param filename - the configuration filename
+ * @param lineNum - the number of the invalid line or the number of lines in the
+ * configuration file in case of parameter not set error
+ * @param value - a string which contains the value to set
+ * @param msg - pointer in which the msg returned by the function is stored
+ * @param minValue - the minimal valid value
+ * @param maxValue - the maximal valid value
+ * @return true if the given value is an integer in range, otherwise returns false
+ */
+bool handleIntFieldInRange(int* intField, const char* filename, int lineNum, char* value,
+		SP_CONFIG_MSG* msg, int minValue, int maxValue);
+
 /*
  * Checks if the given value is a KDTree split method
  * and if so sets config->spKDTreeSplitMethod value to the given KDTree split method
@@ -224,6 +258,40 @@ bool handleBoolField(bool* boolField, const char* filename, int lineNum, char* v
 bool handleKDTreeSplitMethod(SPConfig config, const char* filename, int lineNum,
 		char* value, SP_CONFIG_MSG* msg);
 
+/*
+ * Checks if the given value is a descriptor precision ("double", "float" or "float16")
+ * and if so sets config->spDescriptorPrecision value to the given precision
+ *
+ * pre assumptions - config, filename, value and msg are all valid
+ *
+ * @param config - pointer to the configuration structure instance
+ * @param filename - the configuration filename
+ * @param lineNum - the number of the invalid line or the number of lines in the
+ * configuration file in case of parameter not set error
+ * @param value - a string which contains the value to set
+ * @param msg - pointer in which the msg returned by the function is stored
+ * @return true if the given value is a descriptor precision, otherwise returns false
+ */
+bool handleDescriptorPrecision(SPConfig config, const char* filename, int lineNum,
+		char* value, SP_CONFIG_MSG* msg);
+
+/*
+ * Checks if the given value is a search index type
+ * and if so sets config->spIndexType value to the given search index type
+ *
+ * pre assumptions - config, filename, value and msg are all valid
+ *
+ * @param config - pointer to the configuration structure instance
+ * @param filename - the configuration filename
+ * @param lineNum - the number of the invalid line or the number of lines in the
+ * configuration file in case of parameter not set error
+ * @param value - a string which contains the value to set
+ * @param msg - pointer in which the msg returned by the function is stored
+ * @return true if the given value is a search index type, otherwise returns false
+ */
+bool handleIndexType(SPConfig config, const char* filename, int lineNum,
+		char* value, SP_CONFIG_MSG* msg);
+
 /*
  * Checks if the given value is a positive integer between 1 and 4
  * and if so sets config->spLoggerLevel accordingly
@@ -315,6 +383,10 @@ SPConfig parameterSetCheck(SPConfig config, SP_CONFIG_MSG* msg, const char* file
  * - SP_CONFIG_INVALID_BOOLEAN - if a line in the config file contains invalid boolean
  * - SP_CONFIG_INVALID_KDTREE_SPLIT_METHOD - if a line in the config file contains invalid
  * 											 KDTree split method
+ * - SP_CONFIG_INVALID_DESCRIPTOR_PRECISION - if a line in the config file contains invalid
+ * 											  descriptor precision
+ * - SP_CONFIG_INVALID_INDEX_TYPE - if a line in the config file contains invalid
+ * 									search index type
  *
  *
  */
@@ -464,6 +536,483 @@ int spConfigGetKNN(const SPConfig config, SP_CONFIG_MSG* msg);
  */
 SP_KDTREE_SPLIT_METHOD spConfigGetSplitMethod(const SPConfig config, SP_CONFIG_MSG* msg);
 
+/*
+ * Returns the storage precision of the descriptors as configured in the configuration
+ * file, i.e the SP_POINT_PRECISION represented by the value of spDescriptorPrecision.
+ *
+ * @param config - the configuration structure
+ * @assert msg != NULL
+ * @param msg - pointer in which the msg returned by the function is stored
+ * @return the SP_POINT_PRECISION represented by the value of spDescriptorPrecision in
+ * success, SP_POINT_PRECISION_DOUBLE otherwise.
+ *
+ * - SP_CONFIG_INVALID_ARGUMENT - if config == NULL
+ * - SP_CONFIG_SUCCESS - in case of success
+ *
+ * @logger - in case config is NULL a relevant error is written to the logger
+ */
+SP_POINT_PRECISION spConfigGetDescriptorPrecision(const SPConfig config,
+		SP_CONFIG_MSG* msg);
+
+/*
+ * Returns the nearest neighbours search index type as configured in the configuration
+ * file, i.e the SP_SEARCH_INDEX_TYPE represented by the value of spIndexType.
+ *
+ * @param config - the configuration structure
+ * @assert msg != NULL
+ * @param msg - pointer in which the msg returned by the function is stored
+ * @return the SP_SEARCH_INDEX_TYPE represented by the value of spIndexType in success,
+ * SP_INDEX_KD_TREE otherwise.
+ *
+ * - SP_CONFIG_INVALID_ARGUMENT - if config == NULL
+ * - SP_CONFIG_SUCCESS - in case of success
+ *
+ * @logger - in case config is NULL a relevant error is written to the logger
+ */
+SP_SEARCH_INDEX_TYPE spConfigGetIndexType(const SPConfig config, SP_CONFIG_MSG* msg);
+
+/*
+ * Returns the number of product quantization sub-vectors, i.e the value of
+ * spPQSubspaces.
+ *
+ * @param config - the configuration structure
+ * @assert msg != NULL
+ * @param msg - pointer in which the msg returned by the function is stored
+ * @return positive integer in success, negative integer otherwise.
+ *
+ * - SP_CONFIG_INVALID_ARGUMENT - if config == NULL
+ * - SP_CONFIG_SUCCESS - in case of success
+ *
+ * @logger - in case config is NULL a relevant error is written to the logger
+ */
+int spConfigGetPQSubspaces(const SPConfig config, SP_CONFIG_MSG* msg);
+
+/*
+ * Returns the product quantization codebook size of each sub-vector, i.e the value of
+ * spPQCentroids.
+ *
+ * @param config - the configuration structure
+ * @assert msg != NULL
+ * @param msg - pointer in which the msg returned by the function is stored
+ * @return positive integer in success, negative integer otherwise.
+ *
+ * - SP_CONFIG_INVALID_ARGUMENT - if config == NULL
+ * - SP_CONFIG_SUCCESS - in case of success
+ *
+ * @logger - in case config is NULL a relevant error is written to the logger
+ */
+int spConfigGetPQCentroids(const SPConfig config, SP_CONFIG_MSG* msg);
+
+/*
+ * Returns the number of descriptors sampled for the product quantization training,
+ * i.e the value of spPQTrainingSize.
+ *
+ * @param config - the configuration structure
+ * @assert msg != NULL
+ * @param msg - pointer in which the msg returned by the function is stored
+ * @return positive integer in success, negative integer otherwise.
+ *
+ * - SP_CONFIG_INVALID_ARGUMENT - if config == NULL
+ * - SP_CONFIG_SUCCESS - in case of success
+ *
+ * @logger - in case config is NULL a relevant error is written to the logger
+ */
+int spConfigGetPQTrainingSize(const SPConfig config, SP_CONFIG_MSG* msg);
+
+/*
+ * Returns the number of product quantization candidates that are re-ranked by their
+ * exact distance, i.e the value of spPQReRank (0 means no re-rank).
+ *
+ * @param config - the configuration structure
+ * @assert msg != NULL
+ * @param msg - pointer in which the msg returned by the function is stored
+ * @return non-negative integer in success, negative integer otherwise.
+ *
+ * - SP_CONFIG_INVALID_ARGUMENT - if config == NULL
+ * - SP_CONFIG_SUCCESS - in case of success
+ *
+ * @logger - in case config is NULL a relevant error is written to the logger
+ */
+int spConfigGetPQReRank(const SPConfig config, SP_CONFIG_MSG* msg);
+
+/*
+ * Returns the number of inverted file lists (coarse centroids), i.e the value of
+ * spIVFLists.
+ *
+ * @param config - the configuration structure
+ * @assert msg != NULL
+ * @param msg - pointer in which the msg returned by the function is stored
+ * @return positive integer in success, negative integer otherwise.
+ *
+ * - SP_CONFIG_INVALID_ARGUMENT - if config == NULL
+ * - SP_CONFIG_SUCCESS - in case of success
+ *
+ * @logger - in case config is NULL a relevant error is written to the logger
+ */
+int spConfigGetIVFLists(const SPConfig config, SP_CONFIG_MSG* msg);
+
+/*
+ * Returns the number of inverted file lists scanned per query, i.e the value of
+ * spIVFProbes.
+ *
+ * @param config - the configuration structure
+ * @assert msg != NULL
+ * @param msg - pointer in which the msg returned by the function is stored
+ * @return positive integer in success, negative integer otherwise.
+ *
+ * - SP_CONFIG_INVALID_ARGUMENT - if config == NULL
+ * - SP_CONFIG_SUCCESS - in case of success
+ *
+ * @logger - in case config is NULL a relevant error is written to the logger
+ */
+int spConfigGetIVFProbes(const SPConfig config, SP_CONFIG_MSG* msg);
+
+/*
+ * Returns the number of descriptors sampled for the inverted file
+ * coarse quantizer training, i.e the value of
+ * spIVFTrainingSize.
+ *
+ * @param config - the configuration structure
+ * @assert msg != NULL
+ * @param msg - pointer in which the msg returned by the function is stored
+ * @return positive integer in success, negative integer otherwise.
+ *
+ * - SP_CONFIG_INVALID_ARGUMENT - if config == NULL
+ * - SP_CONFIG_SUCCESS - in case of success
+ *
+ * @logger - in case config is NULL a relevant error is written to the logger
+ */
+int spConfigGetIVFTrainingSize(const SPConfig config, SP_CONFIG_MSG* msg);
+
+/*
+ * Returns the maximal number of links of an HNSW node at the upper layers (twice
+ * as many at the bottom layer), i.e the value of spHNSWM.
+ *
+ * @param config - the configuration structure
+ * @assert msg != NULL
+ * @param msg - pointer in which the msg returned by the function is stored
+ * @return positive integer in success, negative integer otherwise.
+ *
+ * - SP_CONFIG_INVALID_ARGUMENT - if config == NULL
+ * - SP_CONFIG_SUCCESS - in case of success
+ *
+ * @logger - in case config is NULL a relevant error is written to the logger
+ */
+int spConfigGetHNSWM(const SPConfig config, SP_CONFIG_MSG* msg);
+
+/*
+ * Returns the size of the HNSW candidates list used while building the graph,
+ * i.e the value of spHNSWEfConstruction.
+ *
+ * @param config - the configuration structure
+ * @assert msg != NULL
+ * @param msg - pointer in which the msg returned by the function is stored
+ * @return positive integer in success, negative integer otherwise.
+ *
+ * - SP_CONFIG_INVALID_ARGUMENT - if config == NULL
+ * - SP_CONFIG_SUCCESS - in case of success
+ *
+ * @logger - in case config is NULL a relevant error is written to the logger
+ */
+int spConfigGetHNSWEfConstruction(const SPConfig config, SP_CONFIG_MSG* msg);
+
+/*
+ * Returns the size of the HNSW candidates list used while searching,
+ * i.e the value of spHNSWEfSearch.
+ *
+ * @param config - the configuration structure
+ * @assert msg != NULL
+ * @param msg - pointer in which the msg returned by the function is stored
+ * @return positive integer in success, negative integer otherwise.
+ *
+ * - SP_CONFIG_INVALID_ARGUMENT - if config == NULL
+ * - SP_CONFIG_SUCCESS - in case of success
+ *
+ * @logger - in case config is NULL a relevant error is written to the logger
+ */
+int spConfigGetHNSWEfSearch(const SPConfig config, SP_CONFIG_MSG* msg);
+
+/*
+ * Returns the number of threads that build the HNSW graph,
+ * i.e the value of spHNSWBuildThreads.
+ *
+ * @param config - the configuration structure
+ * @assert msg != NULL
+ * @param msg - pointer in which the msg returned by the function is stored
+ * @return positive integer in success, negative integer otherwise.
+ *
+ * - SP_CONFIG_INVALID_ARGUMENT - if config == NULL
+ * - SP_CONFIG_SUCCESS - in case of success
+ *
+ * @logger - in case config is NULL a relevant error is written to the logger
+ */
+int spConfigGetHNSWBuildThreads(const SPConfig config, SP_CONFIG_MSG* msg);
+
+/*
+ * Returns the filename of the saved HNSW index, i.e the value of spHNSWFilename.
+ * The parameter is optional, if it is not set the graph is not saved.
+ *
+ * @param config - the configuration structure
+ * @assert msg != NULL
+ * @param msg - pointer in which the msg returned by the function is stored
+ * @return spHNSWFilename in success (NULL if it is not set), NULL otherwise.
+ *
+ * - SP_CONFIG_INVALID_ARGUMENT - if config == NULL
+ * - SP_CONFIG_SUCCESS - in case of success
+ *
+ * @logger - in case config is NULL a relevant error is written to the logger
+ */
+char* spConfigGetHNSWFilename(const SPConfig config, SP_CONFIG_MSG* msg);
+
+/*
+ * Returns the number of children of each visual vocabulary tree node,
+ * i.e the value of spBoVWBranching.
+ *
+ * @param config - the configuration structure
+ * @assert msg != NULL
+ * @param msg - pointer in which the msg returned by the function is stored
+ * @return positive integer in success, negative integer otherwise.
+ *
+ * - SP_CONFIG_INVALID_ARGUMENT - if config == NULL
+ * - SP_CONFIG_SUCCESS - in case of success
+ *
+ * @logger - in case config is NULL a relevant error is written to the logger
+ */
+int spConfigGetBoVWBranching(const SPConfig config, SP_CONFIG_MSG* msg);
+
+/*
+ * Returns the number of levels of the visual vocabulary tree,
+ * i.e the value of spBoVWDepth.
+ *
+ * @param config - the configuration structure
+ * @assert msg != NULL
+ * @param msg - pointer in which the msg returned by the function is stored
+ * @return positive integer in success, negative integer otherwise.
+ *
+ * - SP_CONFIG_INVALID_ARGUMENT - if config == NULL
+ * - SP_CONFIG_SUCCESS - in case of success
+ *
+ * @logger - in case config is NULL a relevant error is written to the logger
+ */
+int spConfigGetBoVWDepth(const SPConfig config, SP_CONFIG_MSG* msg);
+
+/*
+ * Returns the number of descriptors sampled for the visual vocabulary training,
+ * i.e the value of spBoVWTrainingSize.
+ *
+ * @param config - the configuration structure
+ * @assert msg != NULL
+ * @param msg - pointer in which the msg returned by the function is stored
+ * @return positive integer in success, negative integer otherwise.
+ *
+ * - SP_CONFIG_INVALID_ARGUMENT - if config == NULL
+ * - SP_CONFIG_SUCCESS - in case of success
+ *
+ * @logger - in case config is NULL a relevant error is written to the logger
+ */
+int spConfigGetBoVWTrainingSize(const SPConfig config, SP_CONFIG_MSG* msg);
+
+/*
+ * Returns the number of threads that scan the database of the brute force index,
+ * i.e the value of spBruteForceThreads.
+ *
+ * @param config - the configuration structure
+ * @assert msg != NULL
+ * @param msg - pointer in which the msg returned by the function is stored
+ * @return positive integer in success, negative integer otherwise.
+ *
+ * - SP_CONFIG_INVALID_ARGUMENT - if config == NULL
+ * - SP_CONFIG_SUCCESS - in case of success
+ *
+ * @logger - in case config is NULL a relevant error is written to the logger
+ */
+int spConfigGetBruteForceThreads(const SPConfig config, SP_CONFIG_MSG* msg);
+
+/*
+ * Returns the number of shards the KD-tree index is partitioned into, i.e the value of
+ * spNumOfShards. Each shard is built and searched by its own worker process, 1 means the
+ * KD-tree is built in the main process.
+ *
+ * @param config - the configuration structure
+ * @assert msg != NULL
+ * @param msg - pointer in which the msg returned by the function is stored
+ * @return positive integer in success, negative integer otherwise.
+ *
+ * - SP_CONFIG_INVALID_ARGUMENT - if config == NULL
+ * - SP_CONFIG_SUCCESS - in case of success
+ *
+ * @logger - in case config is NULL a relevant error is written to the logger
+ */
+int spConfigGetNumOfShards(const SPConfig config, SP_CONFIG_MSG* msg);
+
+/*
+ * Returns the number of threads that load the images .feats files in non extraction
+ * mode, i.e the value of spLoadThreads.
+ *
+ * @param config - the configuration structure
+ * @assert msg != NULL
+ * @param msg - pointer in which the msg returned by the function is stored
+ * @return positive integer in success, negative integer otherwise.
+ *
+ * - SP_CONFIG_INVALID_ARGUMENT - if config == NULL
+ * - SP_CONFIG_SUCCESS - in case of success
+ *
+ * @logger - in case config is NULL a relevant error is written to the logger
+ */
+int spConfigGetLoadThreads(const SPConfig config, SP_CONFIG_MSG* msg);
+
+/*
+ * Returns the number of threads that save the images .feats files in extraction mode,
+ * i.e the value of spSaveThreads.
+ *
+ * @param config - the configuration structure
+ * @assert msg != NULL
+ * @param msg - pointer in which the msg returned by the function is stored
+ * @return positive integer in success, negative integer otherwise.
+ *
+ * - SP_CONFIG_INVALID_ARGUMENT - if config == NULL
+ * - SP_CONFIG_SUCCESS - in case of success
+ *
+ * @logger - in case config is NULL a relevant error is written to the logger
+ */
+int spConfigGetSaveThreads(const SPConfig config, SP_CONFIG_MSG* msg);
+
+/*
+ * Returns the filename of the features manifest, i.e the value of spManifestFilename
+ * (default "features.manifest"). The manifest records the image files that the .feats
+ * files were extracted from, so an update run re-extracts only the changed images.
+ *
+ * @param config - the configuration structure
+ * @assert msg != NULL
+ * @param msg - pointer in which the msg returned by the function is stored
+ * @return spManifestFilename in success, NULL otherwise.
+ *
+ * - SP_CONFIG_INVALID_ARGUMENT - if config == NULL
+ * - SP_CONFIG_SUCCESS - in case of success
+ *
+ * @logger - in case config is NULL a relevant error is written to the logger
+ */
+char* spConfigGetManifestFilename(const SPConfig config, SP_CONFIG_MSG* msg);
+
+/*
+ * Returns the memory budget in megabytes of the descriptors of the recent query images,
+ * i.e the value of spQueryCacheSize (0 means the query images are not cached).
+ *
+ * @param config - the configuration structure
+ * @assert msg != NULL
+ * @param msg - pointer in which the msg returned by the function is stored
+ * @return non-negative integer in success, negative integer otherwise.
+ *
+ * - SP_CONFIG_INVALID_ARGUMENT - if config == NULL
+ * - SP_CONFIG_SUCCESS - in case of success
+ *
+ * @logger - in case config is NULL a relevant error is written to the logger
+ */
+int spConfigGetQueryCacheSize(const SPConfig config, SP_CONFIG_MSG* msg);
+
+/*
+ * Returns the directory (ending with '/') that the query cache spills its descriptors
+ * to, i.e the value of spQueryCacheDirectory.
+ * The parameter is optional, if it is not set the query cache is kept in memory only.
+ *
+ * @param config - the configuration structure
+ * @assert msg != NULL
+ * @param msg - pointer in which the msg returned by the function is stored
+ * @return spQueryCacheDirectory in success (NULL if it is not set), NULL otherwise.
+ *
+ * - SP_CONFIG_INVALID_ARGUMENT - if config == NULL
+ * - SP_CONFIG_SUCCESS - in case of success
+ *
+ * @logger - in case config is NULL a relevant error is written to the logger
+ */
+char* spConfigGetQueryCacheDirectory(const SPConfig config, SP_CONFIG_MSG* msg);
+
+/*
+ * Returns the maximal width and height that the images are decoded and their features
+ * extracted at, i.e the value of spMaxImageDimension. A larger image is decoded at a
+ * reduced resolution and downscaled to fit, the same way in extraction and at query time.
+ * 0 means the images are extracted at full resolution.
+ *
+ * @param config - the configuration structure
+ * @assert msg != NULL
+ * @param msg - pointer in which the msg returned by the function is stored
+ * @return non-negative integer in success, negative integer otherwise.
+ *
+ * - SP_CONFIG_INVALID_ARGUMENT - if config == NULL
+ * - SP_CONFIG_SUCCESS - in case of success
+ *
+ * @logger - in case config is NULL a relevant error is written to the logger
+ */
+int spConfigGetMaxImageDimension(const SPConfig config, SP_CONFIG_MSG* msg);
+
+/*
+ * Returns the side of the tiles that the keypoints of a large query image are detected
+ * in, i.e the value of spDetectionTileSize. A query image whose width or height is
+ * larger is split into tiles that are detected concurrently. 0 means query images are
+ * never split.
+ *
+ * @param config - the configuration structure
+ * @assert msg != NULL
+ * @param msg - pointer in which the msg returned by the function is stored
+ * @return non-negative integer in success, negative integer otherwise.
+ *
+ * - SP_CONFIG_INVALID_ARGUMENT - if config == NULL
+ * - SP_CONFIG_SUCCESS - in case of success
+ *
+ * @logger - in case config is NULL a relevant error is written to the logger
+ */
+int spConfigGetDetectionTileSize(const SPConfig config, SP_CONFIG_MSG* msg);
+
+/*
+ * Returns the number of pixels that a detection tile extends into its neighbours on
+ * every side, i.e the value of spDetectionTileOverlap.
+ *
+ * @param config - the configuration structure
+ * @assert msg != NULL
+ * @param msg - pointer in which the msg returned by the function is stored
+ * @return non-negative integer in success, negative integer otherwise.
+ *
+ * - SP_CONFIG_INVALID_ARGUMENT - if config == NULL
+ * - SP_CONFIG_SUCCESS - in case of success
+ *
+ * @logger - in case config is NULL a relevant error is written to the logger
+ */
+int spConfigGetDetectionTileOverlap(const SPConfig config, SP_CONFIG_MSG* msg);
+
+/*
+ * Returns the number of threads that detect the tiles of a query image,
+ * i.e the value of spDetectionThreads.
+ *
+ * @param config - the configuration structure
+ * @assert msg != NULL
+ * @param msg - pointer in which the msg returned by the function is stored
+ * @return positive integer in success, negative integer otherwise.
+ *
+ * - SP_CONFIG_INVALID_ARGUMENT - if config == NULL
+ * - SP_CONFIG_SUCCESS - in case of success
+ *
+ * @logger - in case config is NULL a relevant error is written to the logger
+ */
+int spConfigGetDetectionThreads(const SPConfig config, SP_CONFIG_MSG* msg);
+
+/*
+ * Returns the latency budget of a query in milliseconds, i.e the value of
+ * spQueryDeadline. A query that is not done when its budget is spent stops searching,
+ * and its images are ranked by the query features that were searched until then.
+ * 0 means queries have no deadline.
+ *
+ * @param config - the configuration structure
+ * @assert msg != NULL
+ * @param msg - pointer in which the msg returned by the function is stored
+ * @return non-negative integer in success, negative integer otherwise.
+ *
+ * - SP_CONFIG_INVALID_ARGUMENT - if config == NULL
+ * - SP_CONFIG_SUCCESS - in case of success
+ *
+ * @logger - in case config is NULL a relevant error is written to the logger
+ */
+int spConfigGetQueryDeadline(const SPConfig config, SP_CONFIG_MSG* msg);
+
 /*
  * Returns the logger level as configured in the configuration file,
  * i.e the SP_LOGGER_LEVEL represented by the value of spLoggerLevel.
@@ -497,6 +1046,39 @@ SP_LOGGER_LEVEL spConfigGetLoggerLevel(const SPConfig config, SP_CONFIG_MSG* msg
  */
 char* spConfigGetLoggerFilename(const SPConfig config, SP_CONFIG_MSG* msg);
 
+/*
+ * Returns true if spLoggerAsync = true, false otherwise.
+ * An asynchronous logger writes the messages from a writer thread (see spLoggerCreateAsync).
+ *
+ * @param config - the configuration structure
+ * @assert msg != NULL
+ * @param msg - pointer in which the msg returned by the function is stored
+ * @return true if spLoggerAsync = true, false otherwise.
+ *
+ * - SP_CONFIG_INVALID_ARGUMENT - if config == NULL
+ * - SP_CONFIG_SUCCESS - in case of success
+ *
+ * @logger - in case config is NULL a relevant error is written to the logger
+ */
+bool spConfigIsLoggerAsync(const SPConfig config, SP_CONFIG_MSG* msg);
+
+/*
+ * Returns the filename the instrumentation statistics are written to at exit, i.e the
+ * value of spInstrumentationFilename. The parameter is optional, and it is used only by a
+ * program built with SP_INSTRUMENTATION (see SPInstrumentation.h).
+ *
+ * @param config - the configuration structure
+ * @assert msg != NULL
+ * @param msg - pointer in which the msg returned by the function is stored
+ * @return spInstrumentationFilename in success (NULL if it is not set), NULL otherwise.
+ *
+ * - SP_CONFIG_INVALID_ARGUMENT - if config == NULL
+ * - SP_CONFIG_SUCCESS - in case of success
+ *
+ * @logger - in case config is NULL a relevant error is written to the logger
+ */
+char* spConfigGetInstrumentationFilename(const SPConfig config, SP_CONFIG_MSG* msg);
+
 /**
  * Given an index 'index' the function stores in imagePath the full path of the
  * i'th image if 'isFeats' is false, and the full path of the i'th image with ".feats"
@@ -567,6 +1149,47 @@ SP_CONFIG_MSG spConfigGetImagePath(char* imagePath, const SPConfig config, int i
  */
 SP_CONFIG_MSG spConfigGetPCAPath(char* pcaPath, const SPConfig config);
 
+/**
+ * The function stores in hnswPath the full path of the saved HNSW index.
+ * For example given the values of:
+ *  spImagesDirectory = "./images/"
+ *  spHNSWFilename = "hnsw.idx"
+ *
+ * The functions stores "./images/hnsw.idx" to the address given by hnswPath.
+ * Thus the address given by hnswPath must contain enough space to
+ * store the resulting string.
+ *
+ * @param hnswPath - an address to store the result in, it must contain enough space.
+ * @param config - the configuration structure
+ * @return
+ *  - SP_CONFIG_INVALID_ARGUMENT - if hnswPath == NULL or config == NULL or
+ *    spHNSWFilename is not set
+ *  - SP_CONFIG_SUCCESS - in case of success
+ *
+ * @logger - in case of any type of failure the relevant error is written to the logger
+ */
+SP_CONFIG_MSG spConfigGetHNSWPath(char* hnswPath, const SPConfig config);
+
+/**
+ * The function stores in manifestPath the full path of the features manifest.
+ * For example given the values of:
+ *  spImagesDirectory = "./images/"
+ *  spManifestFilename = "features.manifest"
+ *
+ * The functions stores "./images/features.manifest" to the address given by
+ * manifestPath. Thus the address given by manifestPath must contain enough space to
+ * store the resulting string.
+ *
+ * @param manifestPath - an address to store the result in, it must contain enough space.
+ * @param config - the configuration structure
+ * @return
+ *  - SP_CONFIG_INVALID_ARGUMENT - if manifestPath == NULL or config == NULL
+ *  - SP_CONFIG_SUCCESS - in case of success
+ *
+ * @logger - in case of any type of failure the relevant error is written to the logger
+ */
+SP_CONFIG_MSG spConfigGetManifestPath(char* manifestPath, const SPConfig config);
+
 /*
  * Creates a string signature of some of the configuration settings
  * that are relevant for features loading and verifications
@@ -577,6 +1200,8 @@ SP_CONFIG_MSG spConfigGetPCAPath(char* pcaPath, const SPConfig config);
  * NULL in case of an error occurred otherwise returns a string representing
  * the config data as following:
  * '==[last image path][number of images][number of features][PCA dimension]=='
+ * and if spMaxImageDimension is set, the features depend on it too:
+ * '==[last image path][number of images][number of features][PCA dimension][max dimension]=='
  *
  * @logger - the method logs relevant errors
  */
@@ -609,6 +1234,21 @@ const char* configMsgToStr(SP_CONFIG_MSG msg);
  */
 SP_CONFIG_MSG spConfigCropSimilarImages(const SPConfig config);
 
+/*
+ * The method overrides the value of spExtractionMode, e.g. an update run
+ * loads the PCA from its file and extracts only the changed images.
+ *
+ * @param config - the configurations item
+ * @param extractionMode - the new value of spExtractionMode
+ *
+ * @returns
+ * SP_CONFIG_INVALID_ARGUMENT - in case config is NULL
+ * SP_CONFIG_SUCCESS - otherwise
+ *
+ * @logger - the method logs relevant errors
+ */
+SP_CONFIG_MSG spConfigSetExtractionMode(const SPConfig config, bool extractionMode);
+
 
 
 /********************** FOR TESTING PURPOSES ONLY **********************/
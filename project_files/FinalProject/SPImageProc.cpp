@@ -1,25 +1,118 @@
 #include <cstdlib>
 #include <cassert>
 #include <cstring>
+#include <cctype>
+#include <cmath>
+#include <algorithm>
+#include <deque>
 #include <opencv2/xfeatures2d.hpp>
 #include <opencv2/core.hpp>
 #include <opencv2/imgproc.hpp>
 #include <opencv2/imgcodecs.hpp>
 #include <opencv2/highgui.hpp>
 #include <cstdio>
+#include <sys/stat.h>
 #include "SPImageProc.h"
 extern "C" {
 #include "SPLogger.h"
+#include "image_parsing/SPManifest.h"
+#include "general_utils/SPInstrumentation.h"
 }
 
 using namespace cv;
 using namespace std;
 
+/*
+ * The SIFT detector and scratch buffers of a thread, reused by all its extractions
+ * numOfFeatures - the number of features the detector was created with, -1 if none was
+ */
+struct ExtractionScratch {
+	int numOfFeatures = -1;
+	Ptr<xfeatures2d::SiftDescriptorExtractor> detector;
+	vector<KeyPoint> keypoints;
+	Mat descriptor;
+};
+
+static thread_local ExtractionScratch threadScratch;
+
+/*
+ * A tile of a large query image
+ * region - the tile with the overlap, the keypoints are detected in it
+ * core - the part of the image the tile owns, only the keypoints in it are kept
+ * keypoints, descriptors - the kept keypoints (in image coordinates) and their descriptors
+ */
+struct DetectionTile {
+	Rect region;
+	Rect core;
+	vector<KeyPoint> keypoints;
+	Mat descriptors;
+};
+
+/*
+ * The tiles of an image that the detection threads take one by one, guarded by the lock
+ * of the detection pool
+ */
+struct TileDetection {
+	const Mat* image = NULL;
+	vector<DetectionTile> tiles;
+	int numOfFeatures = 0;
+	int nextTile = 0;
+	int numOfDetectedTiles = 0;
+	bool isFailed = false;
+};
+
+/*
+ * The detection threads of an ImageProc, started with it and stopped when it is destroyed,
+ * so every thread keeps its scratch and SIFT detector for the tiles of all the queries.
+ * The detections of concurrent queries are queued, the tiles of the oldest are taken first.
+ * lock - guards the pool and the queued detections
+ * hasWork - signaled when a detection is queued or the pool is stopped
+ * hasDetectedTile - broadcast when a tile was detected
+ * detections - the detections with tiles that were not taken yet
+ * threads - the started threads
+ * isStopping - true once the pool is stopped
+ */
+struct sp::DetectionPool {
+	pthread_mutex_t lock;
+	pthread_cond_t hasWork;
+	pthread_cond_t hasDetectedTile;
+	deque<TileDetection*> detections;
+	vector<pthread_t> threads;
+	bool isStopping = false;
+};
+
+/*
+ * A keypoint of a tile, ranked by its response
+ */
+struct TileCandidate {
+	float response;
+	int tile;
+	int row;
+};
+
+// highgui windows are not thread safe
+static pthread_mutex_t guiLock = PTHREAD_MUTEX_INITIALIZER;
+
+/*
+ * Returns the scratch of the calling thread, with a detector of numOfFeatures features
+ */
+static ExtractionScratch& getThreadScratch(int numOfFeatures) {
+	if (threadScratch.numOfFeatures != numOfFeatures || !threadScratch.detector) {
+		threadScratch.detector = xfeatures2d::SIFT::create(numOfFeatures);
+		threadScratch.numOfFeatures = numOfFeatures;
+	}
+	return threadScratch;
+}
+
 #define PCA_MEAN_STR "mean"
 #define PCA_EIGEN_VEC_STR "e_vectors"
 #define PCA_EIGEN_VAL_STR "e_values"
 #define STRING_LENGTH 1024
+#define MAX_DECODE_REDUCTION_LEVEL 3 // IMREAD_REDUCED_*_8 decodes at 1/2^3 of the size
 #define WARNING_MSG_LENGTH 2048
+#define QUERY_IMAGE_INDEX 0
+#define TILE_DUPLICATE_DISTANCE 1.5f // pixels between the same keypoint found by two tiles
+#define TILE_DUPLICATE_SIZE_RATIO 0.1f
 
 #define GENERAL_ERROR_MSG "An error occurred"
 #define PCA_DIM_ERROR_MSG "PCA dimension couldn't be resolved"
@@ -28,10 +121,17 @@ using namespace std;
 #define NUM_OF_IMAGES_ERROR "Number of images couldn't be resolved"
 #define NUM_OF_FEATS_ERROR "Number of features couldn't be resolved"
 #define MINIMAL_GUI_ERROR "Minimal GUI mode couldn't be resolved"
+#define MAX_IMAGE_DIMENSION_ERROR "Maximal image dimension couldn't be resolved"
 #define IMAGE_PATH_ERROR "Image path couldn't be resolved"
 #define IMAGE_NOT_EXIST_MSG ": Images doesn't exist"
 #define MINIMAL_GUI_NOT_SET_WARNING "Cannot display images in non-Minimal-GUI mode"
 #define ALLOC_ERROR_MSG "Allocation error"
+#define PCA_PROJECTION_ERROR "PCA projection couldn't be created"
+#define TILE_DETECTION_ERROR "Keypoints couldn't be detected in the tiles of the image"
+#define DETECTION_THREADS_WARNING "Not all the detection threads were created"
+#define DETECTION_TILES_ERROR "Detection tiles couldn't be resolved"
+#define PCA_BINARY_NOT_SAVED_WARNING "Binary PCA file couldn't be saved, the PCA is loaded from YAML"
+#define PCA_FILE_NOT_HASHED_WARNING "PCA file couldn't be hashed, the binary PCA file isn't used"
 #define INVALID_ARG_ERROR "Invalid arguments"
 
 void sp::ImageProc::initFromConfig(const SPConfig config) {
@@ -56,9 +156,72 @@ void sp::ImageProc::initFromConfig(const SPConfig config) {
 		spLoggerPrintError(MINIMAL_GUI_ERROR, __FILE__, __func__, __LINE__);
 		throw Exception();
 	}
+	maxImageDimension = spConfigGetMaxImageDimension(config, &msg);
+	if (msg != SP_CONFIG_SUCCESS) {
+		spLoggerPrintError(MAX_IMAGE_DIMENSION_ERROR, __FILE__, __func__, __LINE__);
+		throw Exception();
+	}
+	tileSize = spConfigGetDetectionTileSize(config, &msg);
+	tileOverlap = spConfigGetDetectionTileOverlap(config, &msg);
+	detectionThreads = spConfigGetDetectionThreads(config, &msg);
+	if (msg != SP_CONFIG_SUCCESS) {
+		spLoggerPrintError(DETECTION_TILES_ERROR, __FILE__, __func__, __LINE__);
+		throw Exception();
+	}
 }
 
-void sp::ImageProc::getImagesMat(vector<Mat>& images, const SPConfig config) {
+/*
+ * Returns true if OpenCV decodes the image format at a reduced size without decoding the
+ * full image first (JPEG scales its DCT blocks), otherwise the reduced modes only resize
+ * the full image after it is decoded.
+ */
+static bool isReducedOnDecode(const char* imagePath) {
+	const char* extension = strrchr(imagePath, '.');
+	char lowered[STRING_LENGTH] = { '\0' };
+	if (!extension)
+		return false;
+	for (int i = 0; extension[i] != '\0' && i < STRING_LENGTH - 1; i++)
+		lowered[i] = (char) tolower((unsigned char) extension[i]);
+	return !strcmp(lowered, ".jpg") || !strcmp(lowered, ".jpeg") || !strcmp(lowered, ".jpe");
+}
+
+/*
+ * Decodes an image in grayscale. If it is larger than maxImageDimension, it is decoded at
+ * the smallest reduced resolution that is still at least maxImageDimension, and
+ * downscaled to fit maxImageDimension, so a large photo is never decoded at full size.
+ */
+Mat sp::ImageProc::readImage(const char* imagePath) const {
+	static const int reducedModes[MAX_DECODE_REDUCTION_LEVEL + 1] = { IMREAD_GRAYSCALE,
+			IMREAD_REDUCED_GRAYSCALE_2, IMREAD_REDUCED_GRAYSCALE_4, IMREAD_REDUCED_GRAYSCALE_8 };
+	Mat img;
+	int level = MAX_DECODE_REDUCTION_LEVEL, side;
+	if (maxImageDimension <= 0)
+		return imread(imagePath, IMREAD_GRAYSCALE);
+	if (isReducedOnDecode(imagePath)) {
+		// decoding at 1/8 is cheap, and tells the size to pick the reduction by
+		img = imread(imagePath, reducedModes[MAX_DECODE_REDUCTION_LEVEL]);
+		if (img.empty())
+			return img;
+		side = max(img.cols, img.rows);
+		while (level > 0 && (side << (MAX_DECODE_REDUCTION_LEVEL - level)) < maxImageDimension)
+			level--;
+		if (level < MAX_DECODE_REDUCTION_LEVEL)
+			img = imread(imagePath, reducedModes[level]);
+	} else {
+		img = imread(imagePath, IMREAD_GRAYSCALE);
+	}
+	if (!img.empty() && max(img.cols, img.rows) > maxImageDimension) {
+		// INTER_AREA averages the pixels of the downscale, so no aliasing reaches SIFT
+		Size capped = img.cols >= img.rows ?
+				Size(maxImageDimension, max(1, cvRound((double) img.rows * maxImageDimension / img.cols))) :
+				Size(max(1, cvRound((double) img.cols * maxImageDimension / img.rows)), maxImageDimension);
+		resize(img, img, capped, 0, 0, INTER_AREA);
+	}
+	return img;
+}
+
+void sp::ImageProc::getImagesMat(vector<Mat>& images, vector<int>& imageIndices,
+		vector<string>& imagePaths, const SPConfig config) const {
 	char warningMSG[WARNING_MSG_LENGTH] = { '\0' };
 	for (int i = 0; i < numOfImages; i++) {
 		char imagePath[STRING_LENGTH + 1] = { '\0' };
@@ -66,45 +229,45 @@ void sp::ImageProc::getImagesMat(vector<Mat>& images, const SPConfig config) {
 			spLoggerPrintError(IMAGE_PATH_ERROR, __FILE__, __func__, __LINE__);
 			throw Exception();
 		}
-		Mat img = imread(imagePath, IMREAD_GRAYSCALE);
+		Mat img = readImage(imagePath);
 		if (img.empty()) {
 			sprintf(warningMSG, "%s %s", imagePath, IMAGE_NOT_EXIST_MSG);
 			spLoggerPrintWarning(warningMSG, __FILE__, __func__, __LINE__);
 			continue;
 		}
 		images.push_back(img);
+		imageIndices.push_back(i);
+		imagePaths.push_back(imagePath);
 	}
 }
 
-void sp::ImageProc::getFeatures(vector<Mat>& images, Mat& features) {
-	//To store the keypoints that will be extracted by SIFT
-	vector<KeyPoint> keypoints;
-	//To store the SIFT descriptor of current image
-	Mat descriptor;
-	//To store all the descriptors that are extracted from all the images.
-
-	//The SIFT feature extractor and descriptor
-	Ptr<xfeatures2d::SiftDescriptorExtractor> detector =
-			xfeatures2d::SIFT::create(numOfFeatures);
+void sp::ImageProc::getFeatures(vector<Mat>& images, Mat& features,
+		vector<int>& rowCounts) const {
+	//The SIFT feature extractor and descriptor, with the keypoints and descriptor buffers
+	ExtractionScratch& scratch = getThreadScratch(numOfFeatures);
 
 	//feature descriptors and build the vocabulary
 	for (int i = 0; i < static_cast<int>(images.size()); i++) {
 		//detect feature points
-		detector->detect(images[i], keypoints);
+		scratch.detector->detect(images[i], scratch.keypoints);
 		//compute the descriptors for each keypoint
-		detector->compute(images[i], keypoints, descriptor);
+		scratch.detector->compute(images[i], scratch.keypoints, scratch.descriptor);
 		//put the all feature descriptors in a single Mat object
-		features.push_back(descriptor);
+		features.push_back(scratch.descriptor);
+		rowCounts.push_back(scratch.descriptor.rows);
 	}
 }
 
-void sp::ImageProc::preprocess(const SPConfig config) {
+void sp::ImageProc::preprocess(const SPConfig config, PCA& pca) {
 	try {
 		vector<Mat> images;
+		vector<int> imageIndices, rowCounts;
+		vector<string> imagePaths;
 		Mat features;
 		char pcaPath[STRING_LENGTH + 1] = { '\0' };
-		getImagesMat(images, config);
-		getFeatures(images, features);
+		getImagesMat(images, imageIndices, imagePaths, config);
+		getFeatures(images, features, rowCounts);
+		images.clear();
 		pca = PCA(features, Mat(), CV_PCA_DATA_AS_ROW, pcaDim);
 		if (spConfigGetPCAPath(pcaPath, config) != SP_CONFIG_SUCCESS) {
 			spLoggerPrintError(PCA_FILE_NOT_RESOLVED, __FILE__, __func__,
@@ -116,13 +279,16 @@ void sp::ImageProc::preprocess(const SPConfig config) {
 		fs << PCA_EIGEN_VAL_STR << pca.eigenvalues;
 		fs << PCA_MEAN_STR << pca.mean;
 		fs.release();
+		saveBinaryPCA(pca, pcaPath);
+		initProjection(pca);
+		prepareFeatures(features, imageIndices, imagePaths, rowCounts);
 	} catch (...) {
 		spLoggerPrintError(GENERAL_ERROR_MSG, __FILE__, __func__, __LINE__);
 		throw Exception();
 	}
 }
 
-void sp::ImageProc::initPCAFromFile(const SPConfig config) {
+void sp::ImageProc::initPCAFromFile(const SPConfig config, PCA& pca) {
 	if (!config) {
 		spLoggerPrintError(GENERAL_ERROR_MSG, __FILE__, __func__, __LINE__);
 		throw Exception();
@@ -143,7 +309,149 @@ void sp::ImageProc::initPCAFromFile(const SPConfig config) {
 	fs.release();
 }
 
+/*
+ * Saves the PCA next to its YAML file as a binary PCA file with the hash of the YAML
+ * file, a failure is only a warning since the YAML file can be loaded instead
+ */
+void sp::ImageProc::saveBinaryPCA(const PCA& pca, const char* pcaPath) const {
+	Mat eigenvectors, eigenvalues, mean;
+	string binaryPath = string(pcaPath) + SP_PCA_BINARY_SUFFIX;
+	unsigned long long yamlHash;
+	if (spManifestHashFile(pcaPath, &yamlHash) != SP_DP_SUCCESS) {
+		spLoggerPrintWarning(PCA_FILE_NOT_HASHED_WARNING, __FILE__, __func__, __LINE__);
+		return;
+	}
+	pca.eigenvectors.convertTo(eigenvectors, CV_32F);
+	pca.eigenvalues.convertTo(eigenvalues, CV_32F);
+	pca.mean.convertTo(mean, CV_32F);
+	if (eigenvectors.empty() || !eigenvectors.isContinuous() || !eigenvalues.isContinuous() ||
+			!mean.isContinuous() || static_cast<int>(eigenvalues.total()) != eigenvectors.rows ||
+			static_cast<int>(mean.total()) != eigenvectors.cols ||
+			!spPCAFileSave(binaryPath.c_str(), mean.ptr<float>(0), eigenvectors.ptr<float>(0),
+					eigenvalues.ptr<float>(0), eigenvectors.cols, eigenvectors.rows, yamlHash))
+		spLoggerPrintWarning(PCA_BINARY_NOT_SAVED_WARNING, __FILE__, __func__, __LINE__);
+}
+
+/*
+ * Creates the projection from the binary PCA file, if it exists and was saved with the
+ * current YAML file
+ *
+ * @returns true if the projection was created, false if the YAML file should be loaded
+ */
+bool sp::ImageProc::initProjectionFromBinary(const SPConfig config) {
+	char pcaPath[STRING_LENGTH + 1] = { '\0' };
+	struct stat binaryStat;
+	unsigned long long yamlHash;
+	if (spConfigGetPCAPath(pcaPath, config) != SP_CONFIG_SUCCESS)
+		return false;
+	string binaryPath = string(pcaPath) + SP_PCA_BINARY_SUFFIX;
+	if (stat(binaryPath.c_str(), &binaryStat) != 0)
+		return false;
+	if (spManifestHashFile(pcaPath, &yamlHash) != SP_DP_SUCCESS) {
+		spLoggerPrintWarning(PCA_FILE_NOT_HASHED_WARNING, __FILE__, __func__, __LINE__);
+		return false;
+	}
+	// a YAML file that was replaced after the binary file was saved is loaded instead, it is
+	// recognized by its hash since a copied or restored file can keep an older time
+	projection = spPCAFileLoad(binaryPath.c_str(), pcaDim, yamlHash);
+	return projection != NULL;
+}
+
+/*
+ * Creates the projection from the float eigenvectors and mean of the PCA
+ */
+void sp::ImageProc::initProjection(const PCA& pca) {
+	Mat eigenvectors, mean;
+	pca.eigenvectors.convertTo(eigenvectors, CV_32F);
+	pca.mean.convertTo(mean, CV_32F);
+	if (eigenvectors.rows < pcaDim || !eigenvectors.isContinuous() || !mean.isContinuous() ||
+			static_cast<int>(mean.total()) != eigenvectors.cols) {
+		spLoggerPrintError(PCA_DIM_ERROR_MSG, __FILE__, __func__, __LINE__);
+		throw Exception();
+	}
+	projection = spPCAProjectionCreate(eigenvectors.ptr<float>(0), mean.ptr<float>(0),
+			eigenvectors.cols, pcaDim);
+	if (!projection) {
+		spLoggerPrintError(PCA_PROJECTION_ERROR, __FILE__, __func__, __LINE__);
+		throw Exception();
+	}
+}
+
+/*
+ * Projects the descriptors of all the extracted images in a single batch, so
+ * getImageFeatures does not extract and project the images one by one again
+ */
+void sp::ImageProc::prepareFeatures(const Mat& features, const vector<int>& imageIndices,
+		const vector<string>& imagePaths, const vector<int>& rowCounts) {
+	Mat descriptors;
+	int firstRow = 0;
+	if (features.empty())
+		return;
+	features.convertTo(descriptors, CV_32F);
+	if (!descriptors.isContinuous())
+		descriptors = descriptors.clone();
+	preparedRows.resize(static_cast<size_t>(descriptors.rows) * pcaDim);
+	spInstrTimerStart(projectionTimer);
+	bool isProjected = spPCAProjectionProject(projection, descriptors.ptr<float>(0),
+			descriptors.rows, preparedRows.data());
+	spInstrTimerStop(projectionTimer, SP_INSTR_PCA_PROJECTION);
+	if (!isProjected) {
+		// the images are extracted again one by one
+		vector<float>().swap(preparedRows);
+		return;
+	}
+	preparedImages.assign(numOfImages, PreparedImage { string(), 0, -1 });
+	for (size_t i = 0; i < imageIndices.size(); i++) {
+		preparedImages[imageIndices[i]] = PreparedImage { imagePaths[i], firstRow, rowCounts[i] };
+		firstRow += rowCounts[i];
+	}
+	numOfUnservedImages = static_cast<int>(imageIndices.size());
+}
+
+/*
+ * Returns the prepared descriptors of an image as points, NULL if they were not prepared.
+ * The prepared descriptors are freed once all the prepared images were returned.
+ */
+SPPoint* sp::ImageProc::getPreparedFeatures(const char* imagePath, int index, int* numOfFeats) {
+	SPPoint* resPoints = NULL;
+	// the rows are copied under the lock, since the last image served frees them
+	pthread_mutex_lock(&preparedLock);
+	if (index < 0 || index >= static_cast<int>(preparedImages.size()) ||
+			preparedImages[index].numOfRows < 0 || preparedImages[index].path != imagePath) {
+		pthread_mutex_unlock(&preparedLock);
+		return NULL;
+	}
+	PreparedImage& image = preparedImages[index];
+	resPoints = (SPPoint*) calloc(max(image.numOfRows, 1), sizeof(*resPoints));
+	if (!resPoints) {
+		pthread_mutex_unlock(&preparedLock);
+		spLoggerPrintError(ALLOC_ERROR_MSG, __FILE__, __func__, __LINE__);
+		return NULL;
+	}
+	for (int i = 0; i < image.numOfRows; i++) {
+		resPoints[i] = spPointCreateFromFloat(
+				&preparedRows[static_cast<size_t>(image.firstRow + i) * pcaDim], pcaDim, index);
+		if (!resPoints[i]) {
+			pthread_mutex_unlock(&preparedLock);
+			spLoggerPrintError(ALLOC_ERROR_MSG, __FILE__, __func__, __LINE__);
+			while (i-- > 0)
+				spPointDestroy(resPoints[i]);
+			free(resPoints);
+			return NULL;
+		}
+	}
+	*numOfFeats = image.numOfRows;
+	image.numOfRows = -1;
+	if (--numOfUnservedImages == 0) {
+		vector<float>().swap(preparedRows);
+		vector<PreparedImage>().swap(preparedImages);
+	}
+	pthread_mutex_unlock(&preparedLock);
+	return resPoints;
+}
+
 sp::ImageProc::ImageProc(const SPConfig config) {
+	pthread_mutex_init(&preparedLock, NULL);
 	try {
 		if (!config) {
 			spLoggerPrintError(INVALID_ARG_ERROR, __FILE__, __func__, __LINE__);
@@ -151,62 +459,311 @@ sp::ImageProc::ImageProc(const SPConfig config) {
 		}
 		SP_CONFIG_MSG msg;
 		bool preprocMode = false;
+		// only the projection of the PCA is kept, and it is never changed afterwards
+		PCA pca;
 		initFromConfig(config);
 		if ((preprocMode = spConfigIsExtractionMode(config, &msg))) {
-			preprocess(config);
+			preprocess(config, pca);
 		} else {
-			initPCAFromFile(config);
+			spInstrTimerStart(pcaTimer);
+			if (!initProjectionFromBinary(config)) {
+				initPCAFromFile(config, pca);
+				initProjection(pca);
+			}
+			spInstrTimerStop(pcaTimer, SP_INSTR_PCA_LOAD);
 		}
+		// only query images are detected in tiles
+		if (tileSize > 0)
+			startDetectionPool(detectionThreads - 1);
 	} catch (...) {
+		// the destructor is not called for a constructor that throws
+		stopDetectionPool();
+		spPCAProjectionDestroy(projection);
+		projection = NULL;
+		pthread_mutex_destroy(&preparedLock);
 		spLoggerPrintError(GENERAL_ERROR_MSG, __FILE__, __func__, __LINE__);
 		throw Exception();
 	}
 }
 
-SPPoint* sp::ImageProc::getImageFeatures(const char* imagePath, int index,
-		int* numOfFeats) {
-	vector<KeyPoint> keypoints;
-	Mat descriptor, img, points;
-	double* pcaSift = NULL;
-	char errorMSG[STRING_LENGTH * 2];
-	Ptr<xfeatures2d::SiftDescriptorExtractor> detector;
-	if (!imagePath || !numOfFeats) {
-		spLoggerPrintError(INVALID_ARG_ERROR, __FILE__, __func__, __LINE__);
-		return NULL;
+sp::ImageProc::~ImageProc() {
+	stopDetectionPool();
+	spPCAProjectionDestroy(projection);
+	pthread_mutex_destroy(&preparedLock);
+}
+
+/*
+ * Detects the keypoints of a tile and computes their descriptors, keeping only the
+ * keypoints in the core of the tile, in the coordinates of the image
+ */
+static void detectTile(DetectionTile& tile, const Mat& image, int numOfFeatures) {
+	ExtractionScratch& scratch = getThreadScratch(numOfFeatures);
+	Mat region = image(tile.region);
+	scratch.detector->detect(region, scratch.keypoints);
+	tile.keypoints.clear();
+	for (size_t i = 0; i < scratch.keypoints.size(); i++) {
+		// a keypoint of the overlap belongs to the tile whose core it is in
+		float x = scratch.keypoints[i].pt.x + tile.region.x;
+		float y = scratch.keypoints[i].pt.y + tile.region.y;
+		if (x >= tile.core.x && x < tile.core.x + tile.core.width &&
+				y >= tile.core.y && y < tile.core.y + tile.core.height)
+			tile.keypoints.push_back(scratch.keypoints[i]);
+	}
+	scratch.detector->compute(region, tile.keypoints, tile.descriptors);
+	if (tile.descriptors.rows != static_cast<int>(tile.keypoints.size()))
+		throw Exception();
+	for (size_t i = 0; i < tile.keypoints.size(); i++) {
+		tile.keypoints[i].pt.x += tile.region.x;
+		tile.keypoints[i].pt.y += tile.region.y;
+	}
+}
+
+/*
+ * Takes the next tile of a queued detection and detects it, the pool lock is held when
+ * it is called and when it returns, but not while the tile is detected. A detection
+ * whose last tile is taken leaves the queue.
+ */
+static void detectNextTile(sp::DetectionPool* pool, TileDetection* detection) {
+	int tile = detection->nextTile++;
+	bool isDetected = true;
+	if (detection->nextTile == static_cast<int>(detection->tiles.size()))
+		pool->detections.erase(find(pool->detections.begin(), pool->detections.end(),
+				detection));
+	pthread_mutex_unlock(&(pool->lock));
+	try {
+		detectTile(detection->tiles[tile], *(detection->image), detection->numOfFeatures);
+	} catch (...) {
+		// an exception must not leave the thread
+		isDetected = false;
+	}
+	pthread_mutex_lock(&(pool->lock));
+	detection->isFailed = detection->isFailed || !isDetected;
+	detection->numOfDetectedTiles++;
+	pthread_cond_broadcast(&(pool->hasDetectedTile));
+}
+
+/*
+ * Detects the tiles of the queued detections until the pool is stopped
+ */
+static void* detectionPoolWorker(void* data) {
+	sp::DetectionPool* pool = (sp::DetectionPool*) data;
+	pthread_mutex_lock(&(pool->lock));
+	while (true) {
+		while (pool->detections.empty() && !pool->isStopping)
+			pthread_cond_wait(&(pool->hasWork), &(pool->lock));
+		if (pool->isStopping)
+			break;
+		detectNextTile(pool, pool->detections.front());
+	}
+	pthread_mutex_unlock(&(pool->lock));
+	return NULL;
+}
+
+/*
+ * Detects all the tiles of a detection with the pool threads, the calling thread detects
+ * the tiles of its own detection as well, so a pool without threads detects them all
+ */
+static void runDetection(sp::DetectionPool* pool, TileDetection& detection) {
+	pthread_mutex_lock(&(pool->lock));
+	pool->detections.push_back(&detection);
+	pthread_cond_broadcast(&(pool->hasWork));
+	while (detection.nextTile < static_cast<int>(detection.tiles.size()))
+		detectNextTile(pool, &detection);
+	while (detection.numOfDetectedTiles < static_cast<int>(detection.tiles.size()))
+		pthread_cond_wait(&(pool->hasDetectedTile), &(pool->lock));
+	pthread_mutex_unlock(&(pool->lock));
+}
+
+/*
+ * Starts the detection pool with numOfThreads threads besides the querying threads
+ */
+void sp::ImageProc::startDetectionPool(int numOfThreads) {
+	pthread_t thread;
+	detectionPool = new DetectionPool();
+	pthread_mutex_init(&(detectionPool->lock), NULL);
+	pthread_cond_init(&(detectionPool->hasWork), NULL);
+	pthread_cond_init(&(detectionPool->hasDetectedTile), NULL);
+	for (int t = 0; t < numOfThreads; t++) {
+		if (pthread_create(&thread, NULL, detectionPoolWorker, detectionPool) != 0)
+			break;
+		detectionPool->threads.push_back(thread);
+	}
+	// the tiles of the threads that were not created are detected by the others
+	if (static_cast<int>(detectionPool->threads.size()) < numOfThreads)
+		spLoggerPrintWarning(DETECTION_THREADS_WARNING, __FILE__, __func__, __LINE__);
+}
+
+/*
+ * Stops the detection pool threads and frees the pool, no detection may be running
+ */
+void sp::ImageProc::stopDetectionPool() {
+	if (!detectionPool)
+		return;
+	pthread_mutex_lock(&(detectionPool->lock));
+	detectionPool->isStopping = true;
+	pthread_cond_broadcast(&(detectionPool->hasWork));
+	pthread_mutex_unlock(&(detectionPool->lock));
+	for (size_t t = 0; t < detectionPool->threads.size(); t++)
+		pthread_join(detectionPool->threads[t], NULL);
+	pthread_cond_destroy(&(detectionPool->hasDetectedTile));
+	pthread_cond_destroy(&(detectionPool->hasWork));
+	pthread_mutex_destroy(&(detectionPool->lock));
+	delete detectionPool;
+	detectionPool = NULL;
+}
+
+/*
+ * Returns true if a keypoint is within TILE_DUPLICATE_DISTANCE of the border of its core,
+ * where the keypoint of a neighbour tile may duplicate it
+ */
+static bool isNearCoreBorder(const KeyPoint& keypoint, const Rect& core) {
+	return keypoint.pt.x - core.x < TILE_DUPLICATE_DISTANCE ||
+			core.x + core.width - keypoint.pt.x < TILE_DUPLICATE_DISTANCE ||
+			keypoint.pt.y - core.y < TILE_DUPLICATE_DISTANCE ||
+			core.y + core.height - keypoint.pt.y < TILE_DUPLICATE_DISTANCE;
+}
+
+/*
+ * Returns true if two keypoints of neighbour tiles are the same keypoint of the image
+ */
+static bool isDuplicate(const KeyPoint& first, const KeyPoint& second) {
+	float dx = first.pt.x - second.pt.x, dy = first.pt.y - second.pt.y;
+	return dx * dx + dy * dy < TILE_DUPLICATE_DISTANCE * TILE_DUPLICATE_DISTANCE &&
+			fabs(first.size - second.size) <= TILE_DUPLICATE_SIZE_RATIO * max(first.size, second.size);
+}
+
+/*
+ * Splits the image into tiles of tileSize with tileOverlap pixels of their neighbours,
+ * detects them on the detection pool, and keeps the strongest numOfFeatures keypoints
+ * of all the tiles, without the duplicates of the overlaps
+ */
+bool sp::ImageProc::detectInTiles(const Mat& img, Mat& descriptor) const {
+	TileDetection detection;
+	vector<TileCandidate> candidates;
+	vector<TileCandidate> kept, keptNearBorder;
+	detection.image = &img;
+	detection.numOfFeatures = numOfFeatures;
+	for (int y = 0; y < img.rows; y += tileSize) {
+		for (int x = 0; x < img.cols; x += tileSize) {
+			DetectionTile tile;
+			tile.core = Rect(x, y, min(tileSize, img.cols - x), min(tileSize, img.rows - y));
+			int left = max(0, x - tileOverlap), top = max(0, y - tileOverlap);
+			tile.region = Rect(left, top,
+					min(img.cols, x + tile.core.width + tileOverlap) - left,
+					min(img.rows, y + tile.core.height + tileOverlap) - top);
+			detection.tiles.push_back(tile);
+		}
+	}
+	runDetection(detectionPool, detection);
+	if (detection.isFailed)
+		return false;
+
+	for (int t = 0; t < static_cast<int>(detection.tiles.size()); t++)
+		for (int r = 0; r < static_cast<int>(detection.tiles[t].keypoints.size()); r++)
+			candidates.push_back(TileCandidate { detection.tiles[t].keypoints[r].response, t, r });
+	// the strongest first, in the order of the tiles for equal responses
+	sort(candidates.begin(), candidates.end(),
+			[](const TileCandidate& a, const TileCandidate& b) {
+				return a.response != b.response ? a.response > b.response :
+						(a.tile != b.tile ? a.tile < b.tile : a.row < b.row);
+			});
+	for (size_t i = 0; i < candidates.size() &&
+			static_cast<int>(kept.size()) < numOfFeatures; i++) {
+		const DetectionTile& tile = detection.tiles[candidates[i].tile];
+		const KeyPoint& keypoint = tile.keypoints[candidates[i].row];
+		bool isNearBorder = isNearCoreBorder(keypoint, tile.core), isKept = true;
+		for (size_t j = 0; isNearBorder && isKept && j < keptNearBorder.size(); j++)
+			isKept = keptNearBorder[j].tile == candidates[i].tile ||
+					!isDuplicate(keypoint,
+							detection.tiles[keptNearBorder[j].tile].keypoints[keptNearBorder[j].row]);
+		if (!isKept)
+			continue;
+		kept.push_back(candidates[i]);
+		if (isNearBorder)
+			keptNearBorder.push_back(candidates[i]);
 	}
-	img = imread(imagePath, IMREAD_GRAYSCALE);
+
+	descriptor = Mat();
+	for (size_t i = 0; i < kept.size(); i++)
+		descriptor.push_back(detection.tiles[kept[i].tile].descriptors.row(kept[i].row));
+	return true;
+}
+
+/*
+ * Decodes an image, detects its keypoints and projects their descriptors. The keypoints
+ * of a query image are detected in tiles if it is larger than a tile, and are ordered
+ * by descending response, so a search that is stopped at its deadline has searched the
+ * strongest ones.
+ */
+SPPoint* sp::ImageProc::extractImageFeatures(const char* imagePath, int index,
+		int* numOfFeats, bool isQuery) const {
+	Mat img;
+	SPPoint* resPoints = NULL;
+	char errorMSG[STRING_LENGTH * 2];
+	spInstrTimerStart(decodeTimer);
+	img = readImage(imagePath);
+	spInstrTimerStop(decodeTimer, SP_INSTR_IMAGE_DECODE);
 	if (img.empty()) {
 		sprintf(errorMSG, "%s %s", imagePath, IMAGE_NOT_EXIST_MSG);
 		spLoggerPrintError(errorMSG, __FILE__, __func__, __LINE__);
 		return NULL;
 	}
-	detector = xfeatures2d::SIFT::create(numOfFeatures);
-	detector->detect(img, keypoints);
-	detector->compute(img, keypoints, descriptor);
-	points = pca.project(descriptor);
-	pcaSift = (double*) malloc(sizeof(double) * pcaDim);
-	if (!pcaSift) {
-		spLoggerPrintError(ALLOC_ERROR_MSG, __FILE__, __func__, __LINE__);
-		return NULL;
+	spInstrTimerStart(extractionTimer);
+	ExtractionScratch& scratch = getThreadScratch(numOfFeatures);
+	Mat& descriptor = scratch.descriptor;
+	if (isQuery && tileSize > 0 && max(img.cols, img.rows) > tileSize) {
+		// the tiles keypoints are already the strongest first
+		if (!detectInTiles(img, descriptor)) {
+			spInstrTimerStop(extractionTimer, SP_INSTR_FEATURES_EXTRACTION);
+			spLoggerPrintError(TILE_DETECTION_ERROR, __FILE__, __func__, __LINE__);
+			return NULL;
+		}
+	} else {
+		scratch.detector->detect(img, scratch.keypoints);
+		if (isQuery)
+			stable_sort(scratch.keypoints.begin(), scratch.keypoints.end(),
+					[](const KeyPoint& a, const KeyPoint& b) {
+						return a.response > b.response;
+					});
+		scratch.detector->compute(img, scratch.keypoints, descriptor);
 	}
-	*numOfFeats = points.rows;
-	SPPoint* resPoints = (SPPoint*) malloc(sizeof(*resPoints) * points.rows);
+	spInstrTimerStop(extractionTimer, SP_INSTR_FEATURES_EXTRACTION);
+	if (!descriptor.empty() && descriptor.type() != CV_32F)
+		descriptor.convertTo(descriptor, CV_32F);
+	spInstrTimerStart(projectionTimer);
+	// the projected rows are stored directly at the configured precision
+	resPoints = spPCAProjectionCreatePoints(projection,
+			descriptor.empty() ? NULL : descriptor.ptr<float>(0), descriptor.rows, index);
+	spInstrTimerStop(projectionTimer, SP_INSTR_PCA_PROJECTION);
 	if (!resPoints) {
-		free(pcaSift);
 		spLoggerPrintError(ALLOC_ERROR_MSG, __FILE__, __func__, __LINE__);
 		return NULL;
 	}
-	for (int i = 0; i < points.rows; i++) {
-		for (int j = 0; j < points.cols; j++) {
-			pcaSift[j] = (double) points.at<float>(i, j);
-		}
-		resPoints[i] = spPointCreate(pcaSift, pcaDim, index);
-	}
-	free(pcaSift);
+	*numOfFeats = descriptor.rows;
 	return resPoints;
 }
 
-void sp::ImageProc::showImage(const char* imgPath) {
+SPPoint* sp::ImageProc::getImageFeatures(const char* imagePath, int index,
+		int* numOfFeats) {
+	SPPoint* resPoints = NULL;
+	if (!imagePath || !numOfFeats) {
+		spLoggerPrintError(INVALID_ARG_ERROR, __FILE__, __func__, __LINE__);
+		return NULL;
+	}
+	if ((resPoints = getPreparedFeatures(imagePath, index, numOfFeats)))
+		return resPoints;
+	return extractImageFeatures(imagePath, index, numOfFeats, false);
+}
+
+SPPoint* sp::ImageProc::getQueryImageFeatures(const char* imagePath, int* numOfFeats) {
+	if (!imagePath || !numOfFeats) {
+		spLoggerPrintError(INVALID_ARG_ERROR, __FILE__, __func__, __LINE__);
+		return NULL;
+	}
+	return extractImageFeatures(imagePath, QUERY_IMAGE_INDEX, numOfFeats, true);
+}
+
+void sp::ImageProc::showImage(const char* imgPath) const {
 	if (minimalGui) {
 		Mat img = imread(imgPath, cv::IMREAD_COLOR);
 		if (img.empty()) {
@@ -214,9 +771,11 @@ void sp::ImageProc::showImage(const char* imgPath) {
 			__LINE__);
 			return;
 		}
+		pthread_mutex_lock(&guiLock);
 		imshow(windowName, img);
 		waitKey(0);
 		destroyAllWindows();
+		pthread_mutex_unlock(&guiLock);
 	} else {
 		spLoggerPrintWarning(MINIMAL_GUI_NOT_SET_WARNING, __FILE__, __func__,
 		__LINE__);
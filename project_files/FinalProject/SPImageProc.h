@@ -3,31 +3,89 @@
 #include <opencv2/core.hpp>
 #include <opencv2/imgcodecs.hpp>
 #include <vector>
+#include <string>
+#include <pthread.h>
 
 extern "C" {
 #include "SPConfig.h"
 #include "SPPoint.h"
+#include "SPPCAProjection.h"
+#include "SPPCAFile.h"
 }
 
 namespace sp {
 
+struct DetectionPool;
+
 /**
  * A class which supports different image processing functionalites.
+ * The descriptors are projected on the PCA by an SPPCAProjection in float blocks.
+ * In extraction mode the descriptors that were extracted to compute the PCA are
+ * projected together, and getImageFeatures returns them instead of extracting the
+ * images again.
+ *
+ * The object is reentrant: after it is constructed its PCA and configuration are never
+ * changed, every thread extracts with its own cached SIFT detector and scratch buffers,
+ * and the prepared descriptors are guarded by a lock. So a single object can extract
+ * the features of several images concurrently.
+ *
+ * A query image that is larger than spDetectionTileSize is split into overlapping tiles
+ * that are detected by spDetectionThreads threads, and the strongest keypoints of the
+ * tiles are kept, so the latency of a large query is spread over the cores. The
+ * detection threads are started with the object and keep their SIFT detectors between
+ * the queries.
+ *
+ * The PCA is saved both as YAML and as a binary PCA file (see SPPCAFile), and is loaded
+ * from the binary file unless it is missing, invalid or older than the YAML file.
  */
 class ImageProc {
 private:
+	/**
+	 * The projected descriptors of an image that were prepared in extraction mode
+	 * path - the image path
+	 * firstRow - the first row of the image in preparedRows
+	 * numOfRows - the number of descriptors of the image, -1 if it was not prepared
+	 */
+	struct PreparedImage {
+		std::string path;
+		int firstRow;
+		int numOfRows;
+	};
+
 	const char* windowName = "Software Project CBIR";
 	int pcaDim;
 	int numOfImages;
 	int numOfFeatures;
-	cv::PCA pca;
+	int maxImageDimension;
+	int tileSize;
+	int tileOverlap;
+	int detectionThreads;
+	SPPCAProjection projection = NULL;
+	DetectionPool* detectionPool = NULL; // detects the tiles, NULL if there is no tiling
+	pthread_mutex_t preparedLock; // guards the prepared descriptors
+	std::vector<PreparedImage> preparedImages;
+	std::vector<float> preparedRows;
+	int numOfUnservedImages = 0;
 	bool minimalGui;
 	void initFromConfig(const SPConfig);
-	void getImagesMat(std::vector<cv::Mat>&, const SPConfig);
+	cv::Mat readImage(const char* imagePath) const;
+	void getImagesMat(std::vector<cv::Mat>&, std::vector<int>&,
+			std::vector<std::string>&, const SPConfig) const;
 	void getFeatures(std::vector<cv::Mat>&,
-			cv::Mat&);
-	void preprocess(const SPConfig config);
-	void initPCAFromFile(const SPConfig config);
+			cv::Mat&, std::vector<int>&) const;
+	void preprocess(const SPConfig config, cv::PCA& pca);
+	void initPCAFromFile(const SPConfig config, cv::PCA& pca);
+	void initProjection(const cv::PCA& pca);
+	void saveBinaryPCA(const cv::PCA& pca, const char* pcaPath) const;
+	bool initProjectionFromBinary(const SPConfig config);
+	void prepareFeatures(const cv::Mat& features, const std::vector<int>& imageIndices,
+			const std::vector<std::string>& imagePaths, const std::vector<int>& rowCounts);
+	SPPoint* getPreparedFeatures(const char* imagePath, int index, int* numOfFeats);
+	void startDetectionPool(int numOfThreads);
+	void stopDetectionPool();
+	bool detectInTiles(const cv::Mat& img, cv::Mat& descriptor) const;
+	SPPoint* extractImageFeatures(const char* imagePath, int index, int* numOfFeats,
+			bool isQuery) const;
 public:
 
 	/**
@@ -37,10 +95,24 @@ public:
 	 */
 	ImageProc(const SPConfig config);
 
+	/**
+	 * Stops the detection threads, and frees the PCA projection and the prepared
+	 * descriptors.
+	 */
+	~ImageProc();
+
+	ImageProc(const ImageProc&) = delete;
+	ImageProc& operator=(const ImageProc&) = delete;
+
 	/**
 	 * Returns an array of features for the image imagePath. All SPPoint elements
 	 * will have the index given by index. The actual number of features extracted
 	 * for this image will be stored in the pointer given by numOfFeats.
+	 * If spMaxImageDimension is set, a larger image is decoded at a reduced
+	 * resolution and downscaled to fit it before its features are extracted.
+	 * In extraction mode, the descriptors of a database image (by its index and path)
+	 * that were projected with the PCA are returned once without extracting it again.
+	 * It may be called by several threads concurrently.
 	 *
 	 * @param imagePath - the target imagePath
 	 * @param index - the index  of the image in the database
@@ -52,13 +124,32 @@ public:
 	 */
 	SPPoint* getImageFeatures(const char* imagePath,int index,int* numOfFeats);
 
+	/**
+	 * Returns an array of features for the query image imagePath, like getImageFeatures
+	 * with index 0. If spDetectionTileSize is set and the image is larger, its keypoints
+	 * are detected in overlapping tiles by several threads: the keypoints of the overlaps
+	 * are deduplicated, and the strongest spNumOfFeatures keypoints by response are kept.
+	 * The result approximates the keypoints of a single detection on the whole image.
+	 * The features are ordered by descending keypoint response, the strongest first.
+	 * It may be called by several threads concurrently.
+	 *
+	 * @param imagePath - the query image path
+	 * @param numOfFeats - a pointer in which the actual number of feats extracted
+	 * 					   will be stored
+	 * @return
+	 * An array of the actual features extracted. NULL is returned in case of
+	 * an error.
+	 */
+	SPPoint* getQueryImageFeatures(const char* imagePath, int* numOfFeats);
+
 	/**
 	 *	Displays the image given by imagePath. Notice that this function works
 	 *	only in MinimalGUI mode (otherwise a warnning message is printed).
+	 *	The GUI is shared, so concurrent calls display their images one at a time.
 	 *
 	 *	@param imagePath - the path of the image to be displayed
 	 */
-	void showImage(const char* imagePath);
+	void showImage(const char* imagePath) const;
 };
 
 }
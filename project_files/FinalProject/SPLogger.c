@@ -1,3 +1,6 @@
+#define _POSIX_C_SOURCE 200809L // flockfile, localtime_r, asctime_r and pthread under -std=c99
+#define SP_LOGGER_IMPLEMENTATION // the print functions are defined here, not their level checks
+
 #include "SPLogger.h"
 #include <stdio.h>
 #include <stdlib.h>
@@ -5,6 +8,9 @@
 #include <stdarg.h>
 #include <string.h>
 #include <time.h>
+#include <limits.h>
+#include <pthread.h>
+#include <sched.h>
 #include "general_utils/SPUtils.h"
 
 #define ERROR_MSG 									"---ERROR---\n"
@@ -12,7 +18,13 @@
 #define INFO_MSG  									"---INFO---\n"
 #define DEBUG_MSG  									"---DEBUG---\n"
 #define TIMESTAMP_MAX_LEN							100
+#define ASCTIME_BUFFER_LEN							26 // the asctime_r format length
 #define LOGGER_ERROR_EXIT_CODE						-4
+#define ASYNC_RING_SIZE								512 // must be a power of 2
+#define ASYNC_MSG_MAX_LEN							1024 // longer messages are truncated
+#define ASYNC_LOCATION_MAX_LEN						256 // for the file and function names
+#define ASYNC_WRITER_WAIT_NSEC						10000000L // the writer polls every 10ms
+#define NSEC_PER_SEC								1000000000L
 
 #define GENERAL_MESSAGE_SKELETON					"%s- file: %s\n- function: %s\n- line: %d\n- message: %s"
 #define SHORT_MESSAGE_SKELETON						"%s- message: %s"
@@ -29,20 +41,89 @@
 //File open mode
 #define SP_LOGGER_OPEN_MODE 						"w"
 
+/** The kind of message a record of the asynchronous ring holds **/
+typedef enum sp_logger_record_type_t {
+	GENERAL_RECORD, // printed with GENERAL_MESSAGE_SKELETON
+	INFO_RECORD, // printed with SHORT_MESSAGE_SKELETON
+	MSG_RECORD // printed as is
+} SP_LOGGER_RECORD_TYPE;
+
+/** A message waiting in the asynchronous ring to be written **/
+typedef struct sp_logger_record_t {
+	size_t sequence; // the ring position the slot is ready for (see enqueueRecord)
+	SP_LOGGER_RECORD_TYPE type;
+	SP_LOGGER_LEVEL level;
+	int line;
+	bool hasTimestamp; // the writer prepends the time of the print call to the message
+	time_t time;
+	char file[ASYNC_LOCATION_MAX_LEN];
+	char function[ASYNC_LOCATION_MAX_LEN];
+	char msg[ASYNC_MSG_MAX_LEN];
+} SPLoggerRecord;
+
 // Global variable holding the logger
 SPLogger logger = NULL;
 
+// The level checked inline by the print macros, every level passes while the logger is
+// undefined so the print functions still report it
+int spLoggerEnabledLevel = INT_MAX;
+
+static pthread_once_t forkHandlersOnce = PTHREAD_ONCE_INIT;
+
 struct sp_logger_t {
 	FILE* outputChannel; //The logger file
 	bool isStdOut; //Indicates if the logger is stdout
 	SP_LOGGER_LEVEL level; //Indicates the level
+	bool isAsync; //Indicates if the messages are written by the writer thread
+	SPLoggerRecord* ring; //The asynchronous ring of ASYNC_RING_SIZE records
+	size_t enqueuePos; //The next ring position to be claimed by a print call
+	size_t dequeuePos; //The next ring position to be written, used by the writer only
+	bool isStopping; //Set by spLoggerDestroy, the writer exits once the ring is empty
+	bool isWriteFailed; //Set by the writer once a write failed
+	pthread_t writer;
+	pthread_mutex_t writerLock; //Guards the writer waiting for records
+	pthread_cond_t writerCond;
 };
 
-SP_LOGGER_MSG spLoggerCreate(const char* filename, SP_LOGGER_LEVEL level) {
+/*
+ * The fork handlers keep the output channel consistent in a forked child: the
+ * channel is locked across the fork so the writer thread is not in the middle of
+ * a write, and its buffer is flushed so the child does not write the parent's
+ * messages again. Since the writer thread does not exist in the child the child
+ * logger prints synchronously.
+ */
+static void lockChannelBeforeFork() {
+	if (logger != NULL && logger->isAsync) {
+		flockfile(logger->outputChannel);
+		fflush(logger->outputChannel);
+	}
+}
+
+static void unlockChannelInParent() {
+	if (logger != NULL && logger->isAsync)
+		funlockfile(logger->outputChannel);
+}
+
+static void unlockChannelInChild() {
+	if (logger != NULL && logger->isAsync) {
+		funlockfile(logger->outputChannel);
+		logger->isAsync = false;
+	}
+}
+
+static void registerForkHandlers() {
+	pthread_atfork(lockChannelBeforeFork, unlockChannelInParent, unlockChannelInChild);
+}
+
+/*
+ * Opens the output channel of a new logger and sets it as the global logger.
+ * (as documented at spLoggerCreate)
+ */
+static SP_LOGGER_MSG createLogger(const char* filename, SP_LOGGER_LEVEL level) {
 	if (logger != NULL) { //Already defined
 		return SP_LOGGER_DEFINED;
 	}
-	logger = (SPLogger) malloc(sizeof(*logger));
+	logger = (SPLogger) calloc(1, sizeof(*logger));
 	if (logger == NULL) { //Allocation failure
 		return SP_LOGGER_OUT_OF_MEMORY;
 	}
@@ -62,10 +143,194 @@ SP_LOGGER_MSG spLoggerCreate(const char* filename, SP_LOGGER_LEVEL level) {
 	return SP_LOGGER_SUCCESS;
 }
 
+/*
+ * Frees the logger when its creation failed after the output channel was opened
+ */
+static SP_LOGGER_MSG onCreateError(SP_LOGGER_MSG msg) {
+	if (!logger->isStdOut)
+		fclose(logger->outputChannel);
+	free(logger->ring);
+	free(logger);
+	logger = NULL;
+	return msg;
+}
+
+SP_LOGGER_MSG spLoggerCreate(const char* filename, SP_LOGGER_LEVEL level) {
+	SP_LOGGER_MSG msg = createLogger(filename, level);
+	if (msg == SP_LOGGER_SUCCESS)
+		spLoggerEnabledLevel = level;
+	return msg;
+}
+
+/*
+ * This method translate log level enum to its name as a String
+ * assumption - logType not null
+ * @param logType - the enum item to be translated
+ */
+const char* getLoggerNameFromType(enum sp_logger_level_t logType) {
+	switch(logType) {
+		case SP_LOGGER_ERROR_LEVEL:
+			return ERROR_MSG;
+		case SP_LOGGER_WARNING_ERROR_LEVEL:
+			return WARNING_MSG;
+		case SP_LOGGER_INFO_WARNING_ERROR_LEVEL:
+			return INFO_MSG;
+		case SP_LOGGER_DEBUG_INFO_WARNING_ERROR_LEVEL:
+			return DEBUG_MSG;
+		default:
+			return NULL;
+	}
+}
+
+/*
+ * Writes the record to the output channel with the skeleton of its type.
+ *
+ * @return false if the write failed, true otherwise
+ */
+static bool writeRecord(const SPLoggerRecord* record) {
+	char message[ASCTIME_BUFFER_LEN + ASYNC_MSG_MAX_LEN];
+	char timestamp[ASCTIME_BUFFER_LEN] = "";
+	struct tm localTime;
+
+	// as tryAddTimestamp, a message whose time cannot be converted is written without it
+	if (record->hasTimestamp && (localtime_r(&record->time, &localTime) == NULL ||
+			asctime_r(&localTime, timestamp) == NULL))
+		timestamp[0] = '\0';
+	snprintf(message, sizeof(message), "%s%s", timestamp, record->msg);
+
+	switch (record->type) {
+	case GENERAL_RECORD:
+		return fprintf(logger->outputChannel, GENERAL_MESSAGE_SKELETON "\n",
+				getLoggerNameFromType(record->level), record->file, record->function,
+				record->line, message) >= 0;
+	case INFO_RECORD:
+		return fprintf(logger->outputChannel, SHORT_MESSAGE_SKELETON "\n", INFO_MSG,
+				message) >= 0;
+	default:
+		return fprintf(logger->outputChannel, "%s\n", message) >= 0;
+	}
+}
+
+/*
+ * Writes all the records that are ready in the ring, in the order their positions were
+ * claimed, and flushes the output channel once for the whole batch.
+ *
+ * @return the number of records written
+ */
+static int writeReadyRecords() {
+	SPLoggerRecord* record;
+	int written = 0;
+
+	while (true) {
+		record = &(logger->ring[logger->dequeuePos & (ASYNC_RING_SIZE - 1)]);
+		if (__atomic_load_n(&(record->sequence), __ATOMIC_ACQUIRE) != logger->dequeuePos + 1)
+			break; // the next record is not ready yet
+		if (!writeRecord(record))
+			__atomic_store_n(&(logger->isWriteFailed), true, __ATOMIC_RELEASE);
+		// frees the slot for the print call of the position one lap ahead
+		__atomic_store_n(&(record->sequence), logger->dequeuePos + ASYNC_RING_SIZE,
+				__ATOMIC_RELEASE);
+		logger->dequeuePos++;
+		written++;
+	}
+	if (written > 0 && fflush(logger->outputChannel) != 0)
+		__atomic_store_n(&(logger->isWriteFailed), true, __ATOMIC_RELEASE);
+	return written;
+}
+
+/*
+ * Blocks the writer until it is woken up or ASYNC_WRITER_WAIT_NSEC passed
+ */
+static void waitForRecords() {
+	struct timespec deadline;
+
+	clock_gettime(CLOCK_REALTIME, &deadline);
+	deadline.tv_nsec += ASYNC_WRITER_WAIT_NSEC;
+	if (deadline.tv_nsec >= NSEC_PER_SEC) {
+		deadline.tv_sec++;
+		deadline.tv_nsec -= NSEC_PER_SEC;
+	}
+	pthread_mutex_lock(&(logger->writerLock));
+	if (!__atomic_load_n(&(logger->isStopping), __ATOMIC_ACQUIRE))
+		pthread_cond_timedwait(&(logger->writerCond), &(logger->writerLock), &deadline);
+	pthread_mutex_unlock(&(logger->writerLock));
+}
+
+/*
+ * The writer thread, writes the ring records in batches until the logger is destroyed
+ */
+static void* writerThread(void* arg) {
+	bool isStopping;
+	(void) arg;
+
+	do {
+		// read before the last batch, so every record enqueued before destroy is written
+		isStopping = __atomic_load_n(&(logger->isStopping), __ATOMIC_ACQUIRE);
+		if (writeReadyRecords() == 0 && !isStopping)
+			waitForRecords();
+	} while (!isStopping);
+	return NULL;
+}
+
+/*
+ * Wakes the writer thread up
+ */
+static void signalWriter() {
+	pthread_mutex_lock(&(logger->writerLock));
+	pthread_cond_signal(&(logger->writerCond));
+	pthread_mutex_unlock(&(logger->writerLock));
+}
+
+SP_LOGGER_MSG spLoggerCreateAsync(const char* filename, SP_LOGGER_LEVEL level) {
+	size_t i;
+	SP_LOGGER_MSG msg = createLogger(filename, level);
+	if (msg != SP_LOGGER_SUCCESS)
+		return msg;
+
+	pthread_once(&forkHandlersOnce, registerForkHandlers);
+	logger->ring = (SPLoggerRecord*) malloc(ASYNC_RING_SIZE * sizeof(SPLoggerRecord));
+	if (logger->ring == NULL)
+		return onCreateError(SP_LOGGER_OUT_OF_MEMORY);
+	for (i = 0; i < ASYNC_RING_SIZE; i++)
+		logger->ring[i].sequence = i; // every slot is free for the first lap
+	if (pthread_mutex_init(&(logger->writerLock), NULL) != 0)
+		return onCreateError(SP_LOGGER_OUT_OF_MEMORY);
+	if (pthread_cond_init(&(logger->writerCond), NULL) != 0) {
+		pthread_mutex_destroy(&(logger->writerLock));
+		return onCreateError(SP_LOGGER_OUT_OF_MEMORY);
+	}
+	logger->isAsync = true;
+	if (pthread_create(&(logger->writer), NULL, writerThread, NULL) != 0) {
+		pthread_cond_destroy(&(logger->writerCond));
+		pthread_mutex_destroy(&(logger->writerLock));
+		return onCreateError(SP_LOGGER_OUT_OF_MEMORY);
+	}
+	spLoggerEnabledLevel = level;
+	return SP_LOGGER_SUCCESS;
+}
+
+/*
+ * Stops the writer thread once all the records in the ring are written
+ */
+static void stopWriter() {
+	pthread_mutex_lock(&(logger->writerLock));
+	__atomic_store_n(&(logger->isStopping), true, __ATOMIC_RELEASE);
+	pthread_cond_signal(&(logger->writerCond));
+	pthread_mutex_unlock(&(logger->writerLock));
+	pthread_join(logger->writer, NULL);
+	pthread_cond_destroy(&(logger->writerCond));
+	pthread_mutex_destroy(&(logger->writerLock));
+}
+
 void spLoggerDestroy() {
 	if (!logger) {
 		return;
 	}
+	spLoggerEnabledLevel = INT_MAX;
+	if (logger->isAsync) {
+		stopWriter();
+	}
+	free(logger->ring);
 	if (!logger->isStdOut) {//Close file only if not stdout
 		fclose(logger->outputChannel);
 	}
@@ -73,6 +338,54 @@ void spLoggerDestroy() {
 	logger = NULL;
 }
 
+/*
+ * Copies the message into a free slot of the asynchronous ring, the writer thread formats
+ * and writes it later. A print call claims the next ring position with a compare and swap
+ * and then publishes the slot through its sequence (the bounded queue of D. Vyukov), so
+ * print calls of several threads do not wait for each other. A print call waits only
+ * while the ring is full, until the writer frees a slot, thus no message is dropped.
+ *
+ * @return
+ * SP_LOGGER_WRITE_FAIL			- If a previous write of the writer thread failed
+ * SP_LOGGER_SUCCESS			- otherwise
+ */
+static SP_LOGGER_MSG enqueueRecord(SP_LOGGER_RECORD_TYPE type, SP_LOGGER_LEVEL level,
+		const char* msg, const char* file, const char* function, int line, bool hasTimestamp) {
+	SPLoggerRecord* record;
+	size_t sequence, pos = __atomic_load_n(&(logger->enqueuePos), __ATOMIC_RELAXED);
+
+	if (__atomic_load_n(&(logger->isWriteFailed), __ATOMIC_ACQUIRE))
+		return SP_LOGGER_WRITE_FAIL;
+
+	while (true) {
+		record = &(logger->ring[pos & (ASYNC_RING_SIZE - 1)]);
+		sequence = __atomic_load_n(&(record->sequence), __ATOMIC_ACQUIRE);
+		if (sequence == pos) { // the slot is free, try to claim its position
+			if (__atomic_compare_exchange_n(&(logger->enqueuePos), &pos, pos + 1, true,
+					__ATOMIC_RELAXED, __ATOMIC_RELAXED))
+				break;
+		} else if ((long) (sequence - pos) < 0) { // the ring is full
+			signalWriter();
+			sched_yield();
+			pos = __atomic_load_n(&(logger->enqueuePos), __ATOMIC_RELAXED);
+		} else { // another print call claimed the position first
+			pos = __atomic_load_n(&(logger->enqueuePos), __ATOMIC_RELAXED);
+		}
+	}
+
+	record->type = type;
+	record->level = level;
+	record->line = line;
+	record->hasTimestamp = hasTimestamp;
+	if (hasTimestamp)
+		record->time = time(NULL);
+	snprintf(record->file, ASYNC_LOCATION_MAX_LEN, "%s", file ? file : "");
+	snprintf(record->function, ASYNC_LOCATION_MAX_LEN, "%s", function ? function : "");
+	snprintf(record->msg, ASYNC_MSG_MAX_LEN, "%s", msg);
+	__atomic_store_n(&(record->sequence), pos + 1, __ATOMIC_RELEASE); // ready to be written
+	return SP_LOGGER_SUCCESS;
+}
+
 /*
  * The given message is printed as string format.
  * A new line is printed at the end of msg
@@ -87,6 +400,7 @@ void spLoggerDestroy() {
  */
 SP_LOGGER_MSG spLoggerPrintFormmatedString(const char* msg, ...) {
     va_list args;
+    bool isWritten;
 
 	if (logger == NULL)
 		return SP_LOGGER_UNDIFINED;
@@ -95,41 +409,23 @@ SP_LOGGER_MSG spLoggerPrintFormmatedString(const char* msg, ...) {
 
     va_start(args, msg);
 
-	if (vfprintf(logger->outputChannel, msg, args) < 0)
-		return SP_LOGGER_WRITE_FAIL;
+	// the message and its new line are not interleaved with messages of other threads
+	flockfile(logger->outputChannel);
+	isWritten = vfprintf(logger->outputChannel, msg, args) >= 0 &&
+			fprintf(logger->outputChannel, "\n") >= 0; // prints a new line
+	funlockfile(logger->outputChannel);
 
 	va_end(args);
 
-	if (fprintf(logger->outputChannel, "\n") < 0) // prints a new line
-		return SP_LOGGER_WRITE_FAIL;
-
-	return SP_LOGGER_SUCCESS;
+	return isWritten ? SP_LOGGER_SUCCESS : SP_LOGGER_WRITE_FAIL;
 }
 
 SP_LOGGER_MSG spLoggerPrintMsg(const char* msg) {
+	if (logger != NULL && msg != NULL && logger->isAsync)
+		return enqueueRecord(MSG_RECORD, SP_LOGGER_ERROR_LEVEL, msg, NULL, NULL, 0, false);
 	return spLoggerPrintFormmatedString(msg);
 }
 
-/*
- * This method translate log level enum to its name as a String
- * assumption - logType not null
- * @param logType - the enum item to be translated
- */
-const char* getLoggerNameFromType(enum sp_logger_level_t logType) {
-	switch(logType) {
-		case SP_LOGGER_ERROR_LEVEL:
-			return ERROR_MSG;
-		case SP_LOGGER_WARNING_ERROR_LEVEL:
-			return WARNING_MSG;
-		case SP_LOGGER_INFO_WARNING_ERROR_LEVEL:
-			return INFO_MSG;
-		case SP_LOGGER_DEBUG_INFO_WARNING_ERROR_LEVEL:
-			return DEBUG_MSG;
-		default:
-			return NULL;
-	}
-}
-
 /*
  * This method gets log level enum and returns true iff it should write the log to the file
  * assumption - logger is not null, enum sp_logger_level_t is ordered according to write priviliges
@@ -168,14 +464,16 @@ bool verifyWritePrivileges(enum sp_logger_level_t logType) {
  * @param file    	- A string representing the filename in which spLoggerPrintWarning call occurred
  * @param function 	- A string representing the function name in which spLoggerPrintWarning call ocurred
  * @param line		- A string representing the line in which the spLoggerPrintWarning call occurred
+ * @param hasTimestamp - in asynchronous mode, the writer thread prepends the time of the
+ * 						 call to the message
  * @return
  * SP_LOGGER_UNDIFINED 			- If the logger is undefined
  * SP_LOGGER_INVAlID_ARGUMENT	- If any of msg or file or function are null or line is negative
  * SP_LOGGER_WRITE_FAIL			- If write failure occurred
  * SP_LOGGER_SUCCESS			- otherwise
  */
-SP_LOGGER_MSG spLoggerPrint(enum sp_logger_level_t logType, const char* msg,
-		const char* file, const char* function, const int line) {
+static SP_LOGGER_MSG printGeneral(enum sp_logger_level_t logType, const char* msg,
+		const char* file, const char* function, const int line, bool hasTimestamp) {
 	if (logger == NULL)
 		return SP_LOGGER_UNDIFINED;
 
@@ -185,10 +483,22 @@ SP_LOGGER_MSG spLoggerPrint(enum sp_logger_level_t logType, const char* msg,
 	if (!verifyWritePrivileges(logType))
 		return SP_LOGGER_SUCCESS;
 
+	if (logger->isAsync)
+		return enqueueRecord(GENERAL_RECORD, logType, msg, file, function, line,
+				hasTimestamp);
+
 	return spLoggerPrintFormmatedString(GENERAL_MESSAGE_SKELETON,
 			getLoggerNameFromType(logType), file,function,line,msg);
 }
 
+/*
+ * Prints general message by type, as documented at printGeneral (without a timestamp)
+ */
+SP_LOGGER_MSG spLoggerPrint(enum sp_logger_level_t logType, const char* msg,
+		const char* file, const char* function, const int line) {
+	return printGeneral(logType, msg, file, function, line, false);
+}
+
 SP_LOGGER_MSG spLoggerPrintError(const char* msg, const char* file,
 		const char* function, const int line) {
 	return spLoggerPrint(SP_LOGGER_ERROR_LEVEL, msg,file,function,line);
@@ -200,7 +510,11 @@ SP_LOGGER_MSG spLoggerPrintWarning(const char* msg, const char* file,
 			function,line);
 }
 
-SP_LOGGER_MSG spLoggerPrintInfo(const char* msg) {
+/*
+ * Prints info message as documented at spLoggerPrintInfo, in asynchronous mode with
+ * hasTimestamp the writer thread prepends the time of the call to the message
+ */
+static SP_LOGGER_MSG printInfo(const char* msg, bool hasTimestamp) {
 	if (logger == NULL)
 		return SP_LOGGER_UNDIFINED;
 
@@ -210,9 +524,17 @@ SP_LOGGER_MSG spLoggerPrintInfo(const char* msg) {
 	if (!verifyWritePrivileges(SP_LOGGER_INFO_WARNING_ERROR_LEVEL))
 		return SP_LOGGER_SUCCESS;
 
+	if (logger->isAsync)
+		return enqueueRecord(INFO_RECORD, SP_LOGGER_INFO_WARNING_ERROR_LEVEL, msg, NULL,
+				NULL, 0, hasTimestamp);
+
 	return spLoggerPrintFormmatedString(SHORT_MESSAGE_SKELETON,INFO_MSG,msg);
 }
 
+SP_LOGGER_MSG spLoggerPrintInfo(const char* msg) {
+	return printInfo(msg, false);
+}
+
 SP_LOGGER_MSG spLoggerPrintDebug(const char* msg, const char* file,
 		const char* function, const int line) {
 	return spLoggerPrint(SP_LOGGER_DEBUG_INFO_WARNING_ERROR_LEVEL, msg,file,
@@ -263,9 +585,10 @@ void spLoggerSafePrintWarning(const char* msg, const char* file,
 void spLoggerSafePrintInfo(const char* msg) {
 	SP_LOGGER_MSG message;
 	char* tempMessage = NULL;
-	tempMessage = tryAddTimestamp(msg);
 
-	if (tempMessage != NULL){
+	if (logger != NULL && logger->isAsync) // the timestamp is added by the writer thread
+		message = printInfo(msg, true);
+	else if ((tempMessage = tryAddTimestamp(msg)) != NULL){
 		message = spLoggerPrintInfo(tempMessage);
 		free(tempMessage);
 	}
@@ -283,9 +606,11 @@ void spLoggerSafePrintDebug(const char* msg, const char* file,
 		const char* function, const int line) {
 	SP_LOGGER_MSG message;
 	char* tempMessage = NULL;
-	tempMessage = tryAddTimestamp(msg);
 
-	if (tempMessage != NULL){
+	if (logger != NULL && logger->isAsync) // the timestamp is added by the writer thread
+		message = printGeneral(SP_LOGGER_DEBUG_INFO_WARNING_ERROR_LEVEL, msg, file,
+				function, line, true);
+	else if ((tempMessage = tryAddTimestamp(msg)) != NULL){
 		message = spLoggerPrintDebug(tempMessage, file, function, line);
 		free(tempMessage);
 	}
@@ -328,12 +653,16 @@ void spLoggerSafePrintDebugWithIndex(const char* msg,int index, const char* file
 
 char* tryAddTimestamp(const char* message){
 	char* updatedMessage = NULL;
+	char timestamp[ASCTIME_BUFFER_LEN];
+	struct tm localTime;
 	time_t ltime = time(NULL);
 	spMinimalVerifyArgumentsRn(message != NULL);
 	spCallocWc(updatedMessage, char, strlen(message) + TIMESTAMP_MAX_LEN,
 			printf(ERROR_PRINTING_TO_LOGGER_EXITING_PROGRAM);
 			exit(LOGGER_ERROR_EXIT_CODE));
-	if (sprintf(updatedMessage, "%s%s",asctime(localtime(&ltime)),message) < 0){
+	// the reentrant versions, the static buffers of localtime and asctime are shared
+	if (localtime_r(&ltime, &localTime) == NULL || asctime_r(&localTime, timestamp) == NULL ||
+			sprintf(updatedMessage, "%s%s", timestamp, message) < 0){
 		spLoggerSafePrintWarning(FAILED_TO_CREATE_TIMESTAMP,
 				__FILE__, __FUNCTION__, __LINE__);
 		free(updatedMessage);
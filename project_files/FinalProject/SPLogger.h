@@ -13,9 +13,20 @@
  * 	
  * The logger supports another printing function which can be called at any level
  * The user must destroy the logger at end of usage
- *	
+ *
+ * The print functions may be called by several threads at once, each message is written
+ * as a whole. The logger must be created before and destroyed after the threads use it.
+ *
+ * An asynchronous logger (see spLoggerCreateAsync) does not write in the print calls: the
+ * messages are copied into a ring buffer, and a writer thread formats and writes them in
+ * batches, so a print call does not wait for the file or for print calls of other threads.
+ *
+ * The safe warning, info and debug prints are macros that check the level of the logger
+ * inline, so a disabled message costs a comparison and its arguments are not evaluated.
+ *
  * The following functions are supported:
  * spLoggerCreate 		- Creates and initializes the logger
+ * spLoggerCreateAsync	- Creates and initializes a logger with a writer thread
  * spLoggerDestroy		- Closes are frees all resources of the logger
  * spLoggerPrintError   - Prints error messages at leves {Error, Warning, Info, Debug}
  * spLoggerPrintWarning - Prints warnning messages at levels {Warning, Info, Debug}
@@ -63,9 +74,34 @@ typedef struct sp_logger_t* SPLogger;
  */
 SP_LOGGER_MSG spLoggerCreate(const char* filename, SP_LOGGER_LEVEL level);
 
+/**
+ * Creates an asynchronous logger, as spLoggerCreate does. The print functions of the
+ * logger copy their message into a ring buffer and return, and a writer thread writes the
+ * messages (in the order they were printed) and flushes the file after each batch.
+ * A print call waits only when the ring is full, until the writer frees a slot.
+ * Messages longer than 1023 characters are truncated, and the timestamp of a safe info or
+ * debug message is the time of the print call.
+ *
+ * A print call reports SP_LOGGER_WRITE_FAIL once a write of the writer thread failed, the
+ * messages are written by the time spLoggerDestroy returns. A process forked from the
+ * logger process logs synchronously.
+ *
+ * @param filename - The name of the log file, if not specified stdout is used
+ * 					 as default.
+ * @param level - The level of the logger prints
+ * @return
+ * SP_LOGGER_DEFINED 			- The logger has been defined
+ * SP_LOGGER_OUT_OF_MEMORY 		- In case of memory allocation failure, or if the writer
+ * 								  thread could not be started
+ * SP_LOGGER_CANNOT_OPEN_FILE 	- If the file given by filename cannot be opened
+ * SP_LOGGER_SUCCESS 			- In case the logger has been successfully opened
+ */
+SP_LOGGER_MSG spLoggerCreateAsync(const char* filename, SP_LOGGER_LEVEL level);
+
 /**
  * Frees all memory allocated for the logger. If the logger is not defined
  * then nothing happens.
+ * An asynchronous logger writes all the messages in its ring before it is freed.
  */
 void spLoggerDestroy();
 
@@ -353,4 +389,39 @@ void spLoggerSafePrintDebugWithIndex(const char* msg,int index, const char* file
  */
 char* tryAddTimestamp(const char* msg);
 
+/*
+ * The level of the logger, or INT_MAX if the logger is undefined (thus a print call on an
+ * undefined logger is not skipped, and it reports the error as the print functions do).
+ * Use spLoggerIsLevelEnabled rather than reading it.
+ */
+extern int spLoggerEnabledLevel;
+
+/*
+ * true if messages of the given level are printed by the logger, e.g. to skip building
+ * a debug message that would not be printed
+ */
+#define spLoggerIsLevelEnabled(level) ((int) (level) <= spLoggerEnabledLevel)
+
+// the safe prints check the level before the call, error prints and messages are always
+// printed and call the functions directly
+#ifndef SP_LOGGER_IMPLEMENTATION
+
+#define spLoggerSafePrintWarning(msg, file, function, line) \
+	((void) (spLoggerIsLevelEnabled(SP_LOGGER_WARNING_ERROR_LEVEL) && \
+			((spLoggerSafePrintWarning)(msg, file, function, line), 1)))
+
+#define spLoggerSafePrintInfo(msg) \
+	((void) (spLoggerIsLevelEnabled(SP_LOGGER_INFO_WARNING_ERROR_LEVEL) && \
+			((spLoggerSafePrintInfo)(msg), 1)))
+
+#define spLoggerSafePrintDebug(msg, file, function, line) \
+	((void) (spLoggerIsLevelEnabled(SP_LOGGER_DEBUG_INFO_WARNING_ERROR_LEVEL) && \
+			((spLoggerSafePrintDebug)(msg, file, function, line), 1)))
+
+#define spLoggerSafePrintDebugWithIndex(msg, index, file, function, line) \
+	((void) (spLoggerIsLevelEnabled(SP_LOGGER_DEBUG_INFO_WARNING_ERROR_LEVEL) && \
+			((spLoggerSafePrintDebugWithIndex)(msg, index, file, function, line), 1)))
+
+#endif
+
 #endif
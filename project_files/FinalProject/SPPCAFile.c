@@ -0,0 +1,201 @@
+#include "SPPCAFile.h"
+#include "SPLogger.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include "general_utils/SPUtils.h"
+
+#define PCA_BINARY_MAGIC_LENGTH		8
+#define PCA_BINARY_HEADER_NUMBERS	5 // version, byte order, input dimension, dimension, type
+#define PCA_BINARY_HEADER_LENGTH	(PCA_BINARY_MAGIC_LENGTH + \
+		PCA_BINARY_HEADER_NUMBERS * sizeof(uint32_t) + sizeof(uint64_t)) // and the source hash
+#define PCA_BINARY_BYTE_ORDER		0x01020304
+#define PCA_BINARY_TYPE_FLOAT32		1
+#define TEMP_FILE_SUFFIX			".tmp"
+#define FNV_OFFSET_BASIS			14695981039346656037ULL
+#define FNV_PRIME					1099511628211ULL
+
+#define FAILED_SAVING_PCA_FILE		"Failed saving the binary PCA file"
+#define FAILED_WRITING_PCA_FILE		"Failed writing the binary PCA file"
+#define FAILED_LOADING_PCA_FILE		"Failed loading the binary PCA file"
+#define WARNING_PCA_FILE_NOT_READ	"The binary PCA file could not be read"
+#define WARNING_PCA_FILE_INVALID	"The binary PCA file is of another format or corrupted"
+#define WARNING_PCA_FILE_OUTDATED	"The binary PCA file was saved with another YAML PCA file"
+#define WARNING_PCA_FILE_DIM		"The binary PCA file has less principal components than the PCA dimension"
+
+/*
+ * Returns the FNV-1a hash of a buffer
+ */
+static uint64_t hashBuffer(const unsigned char* buffer, size_t length) {
+	uint64_t hash = FNV_OFFSET_BASIS;
+	size_t i;
+	for (i = 0; i < length; i++)
+		hash = (hash ^ buffer[i]) * FNV_PRIME;
+	return hash;
+}
+
+/*
+ * Returns the length of a binary PCA file of the given dimensions
+ */
+static size_t getFileLength(int inputDim, int dim) {
+	return PCA_BINARY_HEADER_LENGTH +
+			((size_t) inputDim + (size_t) dim * inputDim + dim) * sizeof(float) +
+			sizeof(uint64_t);
+}
+
+/*
+ * Writes a buffer to a temporary file that is renamed over path
+ *
+ * @returns false if the file could not be written or renamed, true otherwise
+ */
+static bool writeFileAtomically(const char* path, const unsigned char* buffer, size_t length) {
+	char* tempPath = NULL;
+	FILE* file = NULL;
+	bool isWritten = false;
+	spCallocEr(tempPath, char, strlen(path) + strlen(TEMP_FILE_SUFFIX) + 1,
+			FAILED_WRITING_PCA_FILE, false);
+	strcpy(tempPath, path);
+	strcat(tempPath, TEMP_FILE_SUFFIX);
+
+	if ((file = fopen(tempPath, "wb")) != NULL) {
+		isWritten = fwrite(buffer, 1, length, file) == length;
+		isWritten = fclose(file) == 0 && isWritten;
+	}
+	// the binary PCA file is replaced only by a fully written file
+	isWritten = isWritten && rename(tempPath, path) == 0;
+	if (!isWritten) {
+		spLoggerSafePrintError(FAILED_WRITING_PCA_FILE, __FILE__, __FUNCTION__, __LINE__);
+		remove(tempPath);
+	}
+	free(tempPath);
+	return isWritten;
+}
+
+bool spPCAFileSave(const char* path, const float* mean, const float* eigenvectors,
+		const float* eigenvalues, int inputDim, int dim, unsigned long long sourceHash) {
+	const uint32_t header[PCA_BINARY_HEADER_NUMBERS] = { SP_PCA_BINARY_VERSION,
+			PCA_BINARY_BYTE_ORDER, (uint32_t) inputDim, (uint32_t) dim, PCA_BINARY_TYPE_FLOAT32 };
+	unsigned char *buffer = NULL, *position = NULL;
+	const uint64_t hash = (uint64_t) sourceHash;
+	size_t length;
+	uint64_t checksum;
+	bool isSaved;
+	spVerifyArgumentsNc(path != NULL && mean != NULL && eigenvectors != NULL &&
+			eigenvalues != NULL && inputDim > 0 && dim > 0, FAILED_SAVING_PCA_FILE, false);
+
+	length = getFileLength(inputDim, dim);
+	spCallocEr(buffer, unsigned char, length, FAILED_SAVING_PCA_FILE, false);
+	position = buffer;
+	memcpy(position, SP_PCA_BINARY_MAGIC, PCA_BINARY_MAGIC_LENGTH);
+	position += PCA_BINARY_MAGIC_LENGTH;
+	memcpy(position, header, sizeof(header));
+	position += sizeof(header);
+	memcpy(position, &hash, sizeof(hash));
+	position += sizeof(hash);
+	memcpy(position, mean, inputDim * sizeof(float));
+	position += inputDim * sizeof(float);
+	memcpy(position, eigenvectors, (size_t) dim * inputDim * sizeof(float));
+	position += (size_t) dim * inputDim * sizeof(float);
+	memcpy(position, eigenvalues, dim * sizeof(float));
+	position += dim * sizeof(float);
+	checksum = hashBuffer(buffer, position - buffer);
+	memcpy(position, &checksum, sizeof(checksum));
+
+	isSaved = writeFileAtomically(path, buffer, length);
+	free(buffer);
+	return isSaved;
+}
+
+/*
+ * Reads a whole file by a single read
+ *
+ * @returns NULL if the file could not be read or allocated, otherwise its content, and
+ * its length is written to *length
+ */
+static unsigned char* readFile(const char* path, size_t* length) {
+	unsigned char* buffer = NULL;
+	FILE* file = NULL;
+	long fileLength;
+	if ((file = fopen(path, "rb")) == NULL)
+		return NULL;
+	if (fseek(file, 0, SEEK_END) != 0 || (fileLength = ftell(file)) <= 0 ||
+			fseek(file, 0, SEEK_SET) != 0 ||
+			(buffer = (unsigned char*) malloc(fileLength)) == NULL ||
+			fread(buffer, 1, fileLength, file) != (size_t) fileLength) {
+		free(buffer);
+		fclose(file);
+		return NULL;
+	}
+	fclose(file);
+	*length = (size_t) fileLength;
+	return buffer;
+}
+
+/*
+ * Checks the header, the length and the checksum of the content of a binary PCA file
+ *
+ * @returns false if the content is of another format or corrupted, otherwise true, and
+ * the dimensions and the source hash of the file are written to *inputDim, *dim and
+ * *sourceHash
+ */
+static bool isValidContent(const unsigned char* buffer, size_t length, int* inputDim,
+		int* dim, uint64_t* sourceHash) {
+	uint32_t header[PCA_BINARY_HEADER_NUMBERS];
+	uint64_t checksum;
+	if (length < PCA_BINARY_HEADER_LENGTH ||
+			memcmp(buffer, SP_PCA_BINARY_MAGIC, PCA_BINARY_MAGIC_LENGTH) != 0)
+		return false;
+	memcpy(header, buffer + PCA_BINARY_MAGIC_LENGTH, sizeof(header));
+	if (header[0] != SP_PCA_BINARY_VERSION || header[1] != PCA_BINARY_BYTE_ORDER ||
+			header[4] != PCA_BINARY_TYPE_FLOAT32 || header[2] == 0 || header[3] == 0 ||
+			header[2] > length || header[3] > length) // so the length computation cannot overflow
+		return false;
+	*inputDim = (int) header[2];
+	*dim = (int) header[3];
+	memcpy(sourceHash, buffer + PCA_BINARY_MAGIC_LENGTH + sizeof(header), sizeof(*sourceHash));
+	// the dimensions are checked before the length is computed from them
+	if (length != getFileLength(*inputDim, *dim))
+		return false;
+	memcpy(&checksum, buffer + length - sizeof(checksum), sizeof(checksum));
+	return checksum == hashBuffer(buffer, length - sizeof(checksum));
+}
+
+SPPCAProjection spPCAFileLoad(const char* path, int dim, unsigned long long sourceHash) {
+	unsigned char* buffer = NULL;
+	const unsigned char* data = NULL;
+	SPPCAProjection projection = NULL;
+	size_t length;
+	uint64_t fileHash;
+	int inputDim, fileDim;
+	spVerifyArgumentsRn(path != NULL && dim > 0, FAILED_LOADING_PCA_FILE);
+
+	if ((buffer = readFile(path, &length)) == NULL) {
+		spLoggerSafePrintWarning(WARNING_PCA_FILE_NOT_READ, __FILE__, __FUNCTION__, __LINE__);
+		return NULL;
+	}
+	if (!isValidContent(buffer, length, &inputDim, &fileDim, &fileHash)) {
+		spLoggerSafePrintWarning(WARNING_PCA_FILE_INVALID, __FILE__, __FUNCTION__, __LINE__);
+		free(buffer);
+		return NULL;
+	}
+	// a YAML PCA file that was replaced after the binary file was saved is loaded instead
+	if (fileHash != (uint64_t) sourceHash) {
+		spLoggerSafePrintWarning(WARNING_PCA_FILE_OUTDATED, __FILE__, __FUNCTION__, __LINE__);
+		free(buffer);
+		return NULL;
+	}
+	if (fileDim < dim) {
+		spLoggerSafePrintWarning(WARNING_PCA_FILE_DIM, __FILE__, __FUNCTION__, __LINE__);
+		free(buffer);
+		return NULL;
+	}
+
+	// the data is aligned to 4 bytes, the header is 36 bytes long
+	data = buffer + PCA_BINARY_HEADER_LENGTH;
+	projection = spPCAProjectionCreate((const float*) (data + inputDim * sizeof(float)),
+			(const float*) data, inputDim, dim);
+	free(buffer);
+	spValRn(projection != NULL, FAILED_LOADING_PCA_FILE);
+	return projection;
+}
@@ -0,0 +1,81 @@
+#ifndef SPPCAFILE_H_
+#define SPPCAFILE_H_
+
+#include <stdbool.h>
+#include "SPPCAProjection.h"
+
+/**
+ * SP PCA File summary
+ *
+ * Reads and writes the binary PCA file, which is saved next to the YAML PCA file (its
+ * path with SP_PCA_BINARY_SUFFIX), and is loaded by a single read instead of parsing
+ * the YAML text. The file is:
+ *
+ * magic			- 8 bytes, SP_PCA_BINARY_MAGIC
+ * version			- uint32, SP_PCA_BINARY_VERSION
+ * byte order		- uint32, 0x01020304 as written by the saving machine
+ * input dimension	- uint32, the dimension of the descriptors
+ * dimension		- uint32, the number of principal components
+ * data type		- uint32, 1 for float32
+ * source hash		- uint64, the hash of the YAML PCA file the file was saved with
+ * mean				- input dimension floats
+ * eigenvectors		- dimension rows of input dimension floats
+ * eigenvalues		- dimension floats
+ * checksum			- uint64, FNV-1a of all the preceding bytes
+ *
+ * A file of another version, byte order or data type, of the wrong size or with a wrong
+ * checksum is not loaded, and so is a file whose source hash is not the hash of the
+ * current YAML PCA file (which was replaced after the binary file was saved).
+ *
+ * The following functions are supported:
+ *
+ * spPCAFileSave			- Saves a PCA to a binary PCA file
+ * spPCAFileLoad			- Loads the projection of a binary PCA file
+ */
+
+/** The suffix added to the PCA file path for the binary PCA file **/
+#define SP_PCA_BINARY_SUFFIX	".bin"
+
+/** The magic number the binary PCA file starts with **/
+#define SP_PCA_BINARY_MAGIC		"SPPCABIN"
+
+/** The version of the binary PCA file format **/
+#define SP_PCA_BINARY_VERSION	2
+
+/*
+ * Saves a PCA to a binary PCA file, by writing a temporary file (the path with a ".tmp"
+ * suffix) that is renamed over the file, so a reader never sees a partly written file.
+ *
+ * @param path - the binary PCA file path
+ * @param mean - the inputDim coordinates of the mean descriptor
+ * @param eigenvectors - dim rows of inputDim coordinates, the principal components
+ * @param eigenvalues - the dim eigenvalues of the principal components
+ * @param inputDim - the dimension of the descriptors
+ * @param dim - the number of principal components
+ * @param sourceHash - the hash of the YAML PCA file the PCA was saved to
+ *
+ * @returns false in case of invalid argument, memory allocation error or a write
+ * failure, true otherwise
+ *
+ * @logger - Prints relevant errors to the logger.
+ */
+bool spPCAFileSave(const char* path, const float* mean, const float* eigenvectors,
+		const float* eigenvalues, int inputDim, int dim, unsigned long long sourceHash);
+
+/*
+ * Loads the projection on the first dim principal components of a binary PCA file
+ *
+ * @param path - the binary PCA file path
+ * @param dim - the number of principal components to project on, the file must have
+ * dim principal components at least
+ * @param sourceHash - the hash of the current YAML PCA file, the file must have been
+ * saved with it
+ *
+ * @returns NULL in case of invalid argument, memory allocation error, a read failure,
+ * an invalid file or a file of another YAML PCA file, otherwise the projection
+ *
+ * @logger - Prints relevant errors and warnings to the logger.
+ */
+SPPCAProjection spPCAFileLoad(const char* path, int dim, unsigned long long sourceHash);
+
+#endif /* SPPCAFILE_H_ */
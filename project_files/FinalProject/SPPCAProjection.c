@@ -0,0 +1,164 @@
+#include "SPPCAProjection.h"
+#include "SPLogger.h"
+#include <stdlib.h>
+#include <string.h>
+#include "general_utils/SPUtils.h"
+
+#define PROJECTION_ROW_BLOCK	32 // rows centered and projected together
+#define PROJECTION_INPUT_BLOCK	64 // input coordinates whose eigenvector rows stay cached
+
+#define ERROR_PROJECTION_CREATE "Could not allocate the PCA projection"
+#define ERROR_PROJECTION_TILE "Could not allocate the centered descriptors block"
+#define ERROR_PROJECTION_ROWS "Could not allocate the projected points"
+
+/*
+ * A structure used for the PCA projection
+ * transposedEigenvectors - inputDim rows of dim coordinates, the eigenvectors transposed
+ * mean - the inputDim coordinates of the mean descriptor
+ * inputDim - the dimension of the descriptors
+ * dim - the number of principal components
+ */
+struct sp_pca_projection_t {
+	float* transposedEigenvectors;
+	float* mean;
+	int inputDim;
+	int dim;
+};
+
+SPPCAProjection spPCAProjectionCreate(const float* eigenvectors, const float* mean,
+		int inputDim, int dim) {
+	SPPCAProjection projection = NULL;
+	int i, j;
+	spMinimalVerifyArgumentsRn(eigenvectors != NULL && mean != NULL && inputDim > 0 && dim > 0);
+
+	spCalloc(projection, struct sp_pca_projection_t, 1);
+	projection->inputDim = inputDim;
+	projection->dim = dim;
+	spCallocErWc(projection->transposedEigenvectors, float, (size_t) inputDim * dim,
+			ERROR_PROJECTION_CREATE, spPCAProjectionDestroy(projection));
+	spCallocErWc(projection->mean, float, inputDim,
+			ERROR_PROJECTION_CREATE, spPCAProjectionDestroy(projection));
+
+	for (i = 0; i < dim; i++)
+		for (j = 0; j < inputDim; j++)
+			projection->transposedEigenvectors[(size_t) j * dim + i] =
+					eigenvectors[(size_t) i * inputDim + j];
+	memcpy(projection->mean, mean, inputDim * sizeof(float));
+	return projection;
+}
+
+int spPCAProjectionGetInputDim(SPPCAProjection projection) {
+	spMinimalVerifyArguments(projection != NULL, -1);
+	return projection->inputDim;
+}
+
+int spPCAProjectionGetDim(SPPCAProjection projection) {
+	spMinimalVerifyArguments(projection != NULL, -1);
+	return projection->dim;
+}
+
+/*
+ * Adds the projection of a panel of input coordinates of a centered row to its output
+ * row. The output row is contiguous, so the loop over it is vectorized.
+ *
+ * @param centered - the panel coordinates of the centered row
+ * @param panel - the transposed eigenvectors rows of the panel coordinates
+ * @param panelSize - the number of coordinates in the panel
+ * @param dim - the number of principal components
+ * @param projected - the output row
+ */
+static void projectPanel(const float* restrict centered, const float* restrict panel,
+		int panelSize, int dim, float* restrict projected) {
+	int i, k;
+	for (i = 0; i < panelSize; i++) {
+		const float x = centered[i];
+		const float* restrict eigenRow = panel + (size_t) i * dim;
+		for (k = 0; k < dim; k++)
+			projected[k] += x * eigenRow[k];
+	}
+}
+
+bool spPCAProjectionProject(SPPCAProjection projection, const float* descriptors,
+		int numOfRows, float* projected) {
+	float* tile = NULL;
+	int first, rows, r, j, panel, panelSize, inputDim, dim;
+	spMinimalVerifyArguments(projection != NULL && numOfRows >= 0 &&
+			(numOfRows == 0 || (descriptors != NULL && projected != NULL)), false);
+	if (numOfRows == 0)
+		return true;
+
+	inputDim = projection->inputDim;
+	dim = projection->dim;
+	spCallocEr(tile, float, (size_t) PROJECTION_ROW_BLOCK * inputDim, ERROR_PROJECTION_TILE, false);
+
+	for (first = 0; first < numOfRows; first += PROJECTION_ROW_BLOCK) {
+		rows = numOfRows - first < PROJECTION_ROW_BLOCK ? numOfRows - first : PROJECTION_ROW_BLOCK;
+
+		// center the block once, instead of once per panel
+		for (r = 0; r < rows; r++) {
+			const float* row = descriptors + (size_t) (first + r) * inputDim;
+			float* centered = tile + (size_t) r * inputDim;
+			for (j = 0; j < inputDim; j++)
+				centered[j] = row[j] - projection->mean[j];
+		}
+		memset(projected + (size_t) first * dim, 0, (size_t) rows * dim * sizeof(float));
+
+		// every panel of eigenvectors is used by all the rows of the block while it is cached
+		for (panel = 0; panel < inputDim; panel += PROJECTION_INPUT_BLOCK) {
+			panelSize = inputDim - panel < PROJECTION_INPUT_BLOCK ?
+					inputDim - panel : PROJECTION_INPUT_BLOCK;
+			for (r = 0; r < rows; r++)
+				projectPanel(tile + (size_t) r * inputDim + panel,
+						projection->transposedEigenvectors + (size_t) panel * dim,
+						panelSize, dim, projected + (size_t) (first + r) * dim);
+		}
+	}
+
+	free(tile);
+	return true;
+}
+
+SPPoint* spPCAProjectionCreatePoints(SPPCAProjection projection, const float* descriptors,
+		int numOfRows, int index) {
+	SPPoint* points = NULL;
+	float* projected = NULL;
+	int i;
+	spMinimalVerifyArgumentsRn(projection != NULL && numOfRows >= 0 && index >= 0 &&
+			(numOfRows == 0 || descriptors != NULL));
+
+	spCalloc(points, SPPoint, numOfRows > 0 ? numOfRows : 1);
+	if (numOfRows == 0)
+		return points;
+
+	spCallocErWc(projected, float, (size_t) numOfRows * projection->dim,
+			ERROR_PROJECTION_ROWS, free(points));
+	if (!spPCAProjectionProject(projection, descriptors, numOfRows, projected)) {
+		free(projected);
+		free(points);
+		return NULL;
+	}
+
+	for (i = 0; i < numOfRows; i++) {
+		points[i] = spPointCreateFromFloat(projected + (size_t) i * projection->dim,
+				projection->dim, index);
+		if (points[i] == NULL) {
+			spLoggerSafePrintError(ERROR_PROJECTION_ROWS, __FILE__, __FUNCTION__, __LINE__);
+			while (i-- > 0)
+				spPointDestroy(points[i]);
+			free(projected);
+			free(points);
+			return NULL;
+		}
+	}
+
+	free(projected);
+	return points;
+}
+
+void spPCAProjectionDestroy(SPPCAProjection projection) {
+	if (projection == NULL)
+		return;
+	free(projection->transposedEigenvectors);
+	free(projection->mean);
+	free(projection);
+}
@@ -0,0 +1,98 @@
+#ifndef SPPCAPROJECTION_H_
+#define SPPCAPROJECTION_H_
+
+#include <stdbool.h>
+#include "SPPoint.h"
+
+/**
+ * SP PCA Projection summary
+ *
+ * Projects blocks of descriptors on the principal components of a PCA, i.e. computes
+ * (descriptor - mean) * eigenvectors^T for every row of a block, in float.
+ *
+ * The eigenvectors are kept transposed, so a descriptor coordinate multiplies a
+ * contiguous row of the output dimension, which the compiler vectorizes. The rows are
+ * projected in blocks: the rows of a block are centered into a small tile (the mean
+ * subtraction is fused into the block), and the tile is multiplied by panels of the
+ * transposed eigenvectors that stay in the cache for all the rows of the block.
+ *
+ * A projection is immutable after it is created, so it can be used by several threads.
+ *
+ * The following functions are supported:
+ *
+ * spPCAProjectionCreate		- Creates a projection of a PCA
+ * spPCAProjectionGetInputDim	- Returns the dimension of the descriptors
+ * spPCAProjectionGetDim		- Returns the dimension of the projected descriptors
+ * spPCAProjectionProject		- Projects a block of descriptors into a float block
+ * spPCAProjectionCreatePoints	- Projects a block of descriptors into points
+ * spPCAProjectionDestroy		- Frees a projection
+ */
+
+/** Type for defining the PCA projection **/
+typedef struct sp_pca_projection_t* SPPCAProjection;
+
+/*
+ * Creates the projection of a PCA
+ *
+ * @param eigenvectors - dim rows of inputDim coordinates, the principal components
+ * @param mean - the inputDim coordinates of the mean descriptor
+ * @param inputDim - the dimension of the descriptors
+ * @param dim - the number of principal components
+ *
+ * @returns NULL in case of invalid argument or memory allocation error, otherwise the
+ * projection
+ *
+ * @logger - Prints relevant errors to the logger.
+ */
+SPPCAProjection spPCAProjectionCreate(const float* eigenvectors, const float* mean,
+		int inputDim, int dim);
+
+/*
+ * Returns the dimension of the descriptors, -1 if projection is NULL
+ */
+int spPCAProjectionGetInputDim(SPPCAProjection projection);
+
+/*
+ * Returns the dimension of the projected descriptors, -1 if projection is NULL
+ */
+int spPCAProjectionGetDim(SPPCAProjection projection);
+
+/*
+ * Projects a block of descriptors
+ *
+ * @param projection - the projection
+ * @param descriptors - numOfRows rows of inputDim coordinates
+ * @param numOfRows - the number of descriptors
+ * @param projected - numOfRows rows of dim coordinates, the projected descriptors are
+ * written to it
+ *
+ * @returns false in case of invalid argument or memory allocation error, true otherwise
+ *
+ * @logger - Prints relevant errors to the logger.
+ */
+bool spPCAProjectionProject(SPPCAProjection projection, const float* descriptors,
+		int numOfRows, float* projected);
+
+/*
+ * Projects a block of descriptors into points at the default storage precision
+ * (see spPointCreateFromFloat)
+ *
+ * @param projection - the projection
+ * @param descriptors - numOfRows rows of inputDim coordinates
+ * @param numOfRows - the number of descriptors, may be 0
+ * @param index - the index of the points
+ *
+ * @returns NULL in case of invalid argument or memory allocation error, otherwise an
+ * array of numOfRows points (with one slot at least), which the caller should free
+ *
+ * @logger - Prints relevant errors to the logger.
+ */
+SPPoint* spPCAProjectionCreatePoints(SPPCAProjection projection, const float* descriptors,
+		int numOfRows, int index);
+
+/*
+ * Frees all the resources of the projection. If projection is NULL nothing happens.
+ */
+void spPCAProjectionDestroy(SPPCAProjection projection);
+
+#endif /* SPPCAPROJECTION_H_ */
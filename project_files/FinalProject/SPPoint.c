@@ -1,8 +1,11 @@
 #include "SPPoint.h"
 #include "SPLogger.h"
 #include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
 #include <assert.h>
 #include "general_utils/SPUtils.h"
+#include "general_utils/SPInstrumentation.h"
 
 
 bool isEqual(double x,double y)
@@ -13,59 +16,212 @@ bool isEqual(double x,double y)
 
 #define WARNING_POINT_NULL "Point is null when free is called"
 
+#define HALF_SIGN_MASK			0x8000
+#define HALF_EXP_MASK			0x7C00
+#define HALF_NAN_MANTISSA		0x0200
+#define HALF_MANTISSA_MASK		0x03FF
+#define HALF_SUBNORMAL_SCALE	(1.0f / 16777216.0f) // 2^-24
+#define FLOAT_EXP_MASK			0x7F800000
+#define FLOAT_MANTISSA_MASK		0x007FFFFF
+#define FLOAT_IMPLICIT_BIT		0x00800000
+#define FLOAT_TO_HALF_EXP_BIAS	112 // 127 - 15
+
 /*
  * A structure used for the point data type
- * data - an array of the axis data of the point
+ * data - an array of the axis data of the point, its type is set by precision
  * dim - an integer representing the dimension of the point
  * index -  an integer representing the image index related to the point
+ * precision - the storage precision of data
  */
 typedef struct sp_point_t {
-	double* data;
+	union {
+		double* asDouble;
+		float* asFloat;
+		uint16_t* asHalf;
+		void* raw;
+	} data;
 	int dim;
 	int index;
+	SP_POINT_PRECISION precision;
 } sp_point_t;
 
+// the precision used by spPointCreate, set once at startup from the configuration
+static SP_POINT_PRECISION defaultPrecision = SP_POINT_PRECISION_DOUBLE;
+
+void spPointSetDefaultPrecision(SP_POINT_PRECISION precision) {
+	defaultPrecision = precision;
+}
+
+SP_POINT_PRECISION spPointGetDefaultPrecision() {
+	return defaultPrecision;
+}
+
 /*
- * creates a new double array with the same values of the given array
- * @data - the source array to be copied
- * @size - the size of the array
+ * Converts a float to an IEEE-754 binary16 value, rounding to nearest even
+ *
+ * @param value - the float to convert
+ *
+ * @returns the binary16 representation of value (saturates to +-inf)
+ */
+static uint16_t floatToHalf(float value) {
+	uint32_t bits, mantissa, remainder, halfway;
+	uint16_t sign, half;
+	int exp, shift;
+
+	memcpy(&bits, &value, sizeof(bits));
+	sign = (uint16_t) ((bits >> 16) & HALF_SIGN_MASK);
+	mantissa = bits & FLOAT_MANTISSA_MASK;
+
+	if ((bits & FLOAT_EXP_MASK) == FLOAT_EXP_MASK) //inf or nan
+		return sign | HALF_EXP_MASK | (mantissa ? HALF_NAN_MANTISSA : 0);
+
+	exp = (int) ((bits & FLOAT_EXP_MASK) >> 23) - FLOAT_TO_HALF_EXP_BIAS;
+	if (exp >= 31) //overflow
+		return sign | HALF_EXP_MASK;
+
+	if (exp <= 0) { //subnormal half or zero
+		if (exp < -10)
+			return sign;
+		mantissa |= FLOAT_IMPLICIT_BIT;
+		shift = 14 - exp;
+		half = (uint16_t) (mantissa >> shift);
+		remainder = mantissa & ((1u << shift) - 1);
+		halfway = 1u << (shift - 1);
+		if (remainder > halfway || (remainder == halfway && (half & 1)))
+			half++;
+		return sign | half;
+	}
+
+	half = (uint16_t) ((exp << 10) | (mantissa >> 13));
+	remainder = mantissa & 0x1FFF;
+	if (remainder > 0x1000 || (remainder == 0x1000 && (half & 1)))
+		half++; //a carry to the exponent is the correct rounding result
+	return sign | half;
+}
+
+/*
+ * Converts an IEEE-754 binary16 value to a float (exact)
+ *
+ * @param half - the binary16 value
+ *
+ * @returns the float value of half
+ */
+static float halfToFloat(uint16_t half) {
+	uint32_t bits, sign = ((uint32_t) (half & HALF_SIGN_MASK)) << 16;
+	uint32_t exp = (half & HALF_EXP_MASK) >> 10, mantissa = half & HALF_MANTISSA_MASK;
+	float value;
+
+	if (exp == 0) { //zero or subnormal
+		value = (float) mantissa * HALF_SUBNORMAL_SCALE;
+		return sign ? -value : value;
+	}
+	if (exp == 0x1F) //inf or nan
+		bits = sign | FLOAT_EXP_MASK | (mantissa << 13);
+	else
+		bits = sign | ((exp + FLOAT_TO_HALF_EXP_BIAS) << 23) | (mantissa << 13);
+	memcpy(&value, &bits, sizeof(value));
+	return value;
+}
+
+size_t spPointGetCoorSize(SP_POINT_PRECISION precision) {
+	switch (precision) {
+	case SP_POINT_PRECISION_FLOAT:
+		return sizeof(float);
+	case SP_POINT_PRECISION_HALF:
+		return sizeof(uint16_t);
+	default:
+		return sizeof(double);
+	}
+}
+
+/*
+ * Allocates a new point without setting its coordinates
  *
  * @returns
- * NULL if data is NULL or size < 0, otherwise a hard copy of the given array
+ * NULL in case of memory allocation error, otherwise the new point
+ */
+static SPPoint allocatePoint(int dim, int index, SP_POINT_PRECISION precision) {
+	SPPoint item = NULL;
+
+	spCalloc(item, sp_point_t, 1);
+	item->data.raw = calloc(dim, spPointGetCoorSize(precision));
+	if (item->data.raw == NULL) {
+		spLoggerSafePrintError(ERROR_ALLOCATING_MEMORY, __FILE__, __FUNCTION__, __LINE__);
+		free(item);
+		return NULL;
+	}
+
+	item->dim = dim;
+	item->index = index;
+	item->precision = precision;
+	return item;
+}
+
+/*
+ * Stores the given value at the point's axis coordinate, rounding to the point's precision
  */
-double* copyData(double* data, int size) {
+static void setAxisCoor(SPPoint point, int axis, double value) {
+	switch (point->precision) {
+	case SP_POINT_PRECISION_FLOAT:
+		point->data.asFloat[axis] = (float) value;
+		break;
+	case SP_POINT_PRECISION_HALF:
+		point->data.asHalf[axis] = floatToHalf((float) value);
+		break;
+	default:
+		point->data.asDouble[axis] = value;
+	}
+}
+
+SPPoint spPointCreateWithPrecision(double* data, int dim, int index,
+		SP_POINT_PRECISION precision) {
 	int i;
-	double* newData;
-	spMinimalVerifyArgumentsRn(data != NULL && size >= 0);
+	SPPoint item = NULL;
+	spMinimalVerifyArgumentsRn(data != NULL && index >= 0 && dim >0);
 
-	spCalloc(newData, double, size);
+	if ((item = allocatePoint(dim, index, precision)) == NULL)
+		return NULL; //allocation error
 
-	for (i = 0; i < size; i++)
-		newData[i] = data[i];
+	for (i = 0; i < dim; i++)
+		setAxisCoor(item, i, data[i]);
 
-	return newData;
+	return item;
 }
 
 SPPoint spPointCreate(double* data, int dim, int index) {
-	spMinimalVerifyArgumentsRn(data != NULL && index >= 0 && dim >0);
-	SPPoint item = NULL;
+	return spPointCreateWithPrecision(data, dim, index, defaultPrecision);
+}
 
-	spCalloc(item, sp_point_t, 1);
+SPPoint spPointCreateFromFloat(const float* data, int dim, int index) {
+	int i;
+	SPPoint item = NULL;
+	spMinimalVerifyArgumentsRn(data != NULL && index >= 0 && dim >0);
 
-	item->data = copyData(data,dim);
-	if (item->data == NULL)
+	if ((item = allocatePoint(dim, index, defaultPrecision)) == NULL)
 		return NULL; //allocation error
 
-	item->dim = dim;
-	item->index = index;
+	if (item->precision == SP_POINT_PRECISION_FLOAT) {
+		memcpy(item->data.asFloat, data, dim * sizeof(float));
+	}
+	else {
+		for (i = 0; i < dim; i++)
+			setAxisCoor(item, i, (double) data[i]);
+	}
 
 	return item;
 }
 
 SPPoint spPointCopy(SPPoint source) {
+	SPPoint item = NULL;
 	assert (source != NULL);
-	spMinimalVerifyArgumentsRn(source->data != NULL);
-	return spPointCreate(source->data,source->dim,source->index);
+	spMinimalVerifyArgumentsRn(source->data.raw != NULL);
+
+	if ((item = allocatePoint(source->dim, source->index, source->precision)) == NULL)
+		return NULL; //allocation error
+
+	memcpy(item->data.raw, source->data.raw,
+			source->dim * spPointGetCoorSize(source->precision));
+	return item;
 }
 
 bool spPointCompare(SPPoint p1, SPPoint p2){
@@ -78,7 +234,7 @@ bool spPointCompare(SPPoint p1, SPPoint p2){
 		return false;
 
 	for (i = 0; i< p1->dim;i++){
-		if (!isEqual(p1->data[i],p2->data[i]))
+		if (!isEqual(spPointGetAxisCoor(p1, i), spPointGetAxisCoor(p2, i)))
 			return false;
 	}
 	return true;
@@ -86,7 +242,7 @@ bool spPointCompare(SPPoint p1, SPPoint p2){
 
 void spPointDestroy(SPPoint point) {
 	if (point != NULL) {
-		spFree(point->data);
+		spFree(point->data.raw);
 		free(point);
 		point = NULL;
 	}
@@ -105,9 +261,51 @@ int spPointGetIndex(SPPoint point) {
 	return point->index;
 }
 
+SP_POINT_PRECISION spPointGetPrecision(SPPoint point) {
+	assert(point != NULL);
+	return point->precision;
+}
+
 double spPointGetAxisCoor(SPPoint point, int axis) {
 	assert(point != NULL && axis < point->dim && axis >= 0);
-	return point->data[axis];
+	switch (point->precision) {
+	case SP_POINT_PRECISION_FLOAT:
+		return (double) point->data.asFloat[axis];
+	case SP_POINT_PRECISION_HALF:
+		return (double) halfToFloat(point->data.asHalf[axis]);
+	default:
+		return point->data.asDouble[axis];
+	}
+}
+
+/*
+ * L2 squared distance kernel of two float arrays, accumulated in float
+ */
+static double floatL2SquaredDistance(const float* p, const float* q, int dim) {
+	int dimIndex;
+	float l2Dist = 0, currentDist;
+
+	for (dimIndex = 0; dimIndex < dim; dimIndex++) {
+		currentDist = p[dimIndex] - q[dimIndex];
+		l2Dist += currentDist * currentDist;
+	}
+
+	return (double) l2Dist;
+}
+
+/*
+ * L2 squared distance kernel of two float16 arrays, accumulated in float
+ */
+static double halfL2SquaredDistance(const uint16_t* p, const uint16_t* q, int dim) {
+	int dimIndex;
+	float l2Dist = 0, currentDist;
+
+	for (dimIndex = 0; dimIndex < dim; dimIndex++) {
+		currentDist = halfToFloat(p[dimIndex]) - halfToFloat(q[dimIndex]);
+		l2Dist += currentDist * currentDist;
+	}
+
+	return (double) l2Dist;
 }
 
 double spPointL2SquaredDistance(SPPoint p, SPPoint q) {
@@ -115,12 +313,97 @@ double spPointL2SquaredDistance(SPPoint p, SPPoint q) {
 	double l2Dist = 0, currentDist;
 
 	assert(p != NULL && q != NULL && p->dim == q->dim);
+	spInstrCount(SP_INSTR_DISTANCE_EVALS);
 
+	if (p->precision == q->precision) {
+		switch (p->precision) {
+		case SP_POINT_PRECISION_FLOAT:
+			return floatL2SquaredDistance(p->data.asFloat, q->data.asFloat, p->dim);
+		case SP_POINT_PRECISION_HALF:
+			return halfL2SquaredDistance(p->data.asHalf, q->data.asHalf, p->dim);
+		default:
+			for (dimIndex = 0;dimIndex < p->dim ; dimIndex++) {
+				currentDist = p->data.asDouble[dimIndex]-q->data.asDouble[dimIndex];
+				l2Dist += currentDist * currentDist;
+			}
+			return l2Dist;
+		}
+	}
+
+	//mixed precisions - accumulate in double
 	for (dimIndex = 0;dimIndex < p->dim ; dimIndex++) {
-		currentDist = p->data[dimIndex]-q->data[dimIndex];
+		currentDist = spPointGetAxisCoor(p, dimIndex) - spPointGetAxisCoor(q, dimIndex);
 		l2Dist += currentDist * currentDist;
 	}
 
 	return l2Dist;
 }
 
+void spPointCopyToRow(SPPoint point, void* row, SP_POINT_PRECISION precision) {
+	int i;
+	assert(point != NULL && row != NULL);
+
+	if (precision == point->precision) {
+		memcpy(row, point->data.raw, point->dim * spPointGetCoorSize(precision));
+		return;
+	}
+	for (i = 0; i < point->dim; i++) {
+		switch (precision) {
+		case SP_POINT_PRECISION_FLOAT:
+			((float*) row)[i] = (float) spPointGetAxisCoor(point, i);
+			break;
+		case SP_POINT_PRECISION_HALF:
+			((uint16_t*) row)[i] = floatToHalf((float) spPointGetAxisCoor(point, i));
+			break;
+		default:
+			((double*) row)[i] = spPointGetAxisCoor(point, i);
+		}
+	}
+}
+
+void spPointRowToVector(const void* row, int dim, SP_POINT_PRECISION precision,
+		double* vector) {
+	int i;
+	assert(row != NULL && vector != NULL);
+
+	switch (precision) {
+	case SP_POINT_PRECISION_FLOAT:
+		for (i = 0; i < dim; i++)
+			vector[i] = (double) ((const float*) row)[i];
+		break;
+	case SP_POINT_PRECISION_HALF:
+		for (i = 0; i < dim; i++)
+			vector[i] = (double) halfToFloat(((const uint16_t*) row)[i]);
+		break;
+	default:
+		memcpy(vector, row, dim * sizeof(double));
+	}
+}
+
+double spPointRowL2SquaredDistance(const double* vector, const void* row, int dim,
+		SP_POINT_PRECISION precision) {
+	int i;
+	double l2Dist = 0, currentDist;
+	assert(vector != NULL && row != NULL);
+
+	switch (precision) {
+	case SP_POINT_PRECISION_FLOAT:
+		for (i = 0; i < dim; i++) {
+			currentDist = vector[i] - (double) ((const float*) row)[i];
+			l2Dist += currentDist * currentDist;
+		}
+		break;
+	case SP_POINT_PRECISION_HALF:
+		for (i = 0; i < dim; i++) {
+			currentDist = vector[i] - (double) halfToFloat(((const uint16_t*) row)[i]);
+			l2Dist += currentDist * currentDist;
+		}
+		break;
+	default:
+		for (i = 0; i < dim; i++) {
+			currentDist = vector[i] - ((const double*) row)[i];
+			l2Dist += currentDist * currentDist;
+		}
+	}
+	return l2Dist;
+}
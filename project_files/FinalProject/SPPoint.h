@@ -1,27 +1,59 @@
 #ifndef SPPOINT_H_
 #define SPPOINT_H_
 #include <stdbool.h>
+#include <stddef.h>
 /**
  * SPPoint Summary
  * Encapsulates a point with variable length dimension. The coordinates
- * values are double types, and each point has a non-negative index which
- * represents the image index to which the point belongs.
+ * values are given and returned as double types, yet they are stored at a
+ * selectable precision (double, float or float16), and each point has a
+ * non-negative index which represents the image index to which the point belongs.
  *
  * The following functions are supported:
  *
- * spPointCreate        	- Creates a new point
+ * spPointCreate        	- Creates a new point (at the default storage precision)
+ * spPointCreateWithPrecision - Creates a new point at a given storage precision
+ * spPointCreateFromFloat	- Creates a new point from a float array
  * spPointCopy				- Create a new copy of a given point
  * spPointDestroy 			- Free all resources associated with a point
  * spPointGetDimension		- A getter of the dimension of a point
  * spPointGetIndex			- A getter of the index of a point
  * spPointGetAxisCoor		- A getter of a given coordinate of the point
  * spPointL2SquaredDistance	- Calculates the L2 squared distance between two points
+ * spPointSetDefaultPrecision - Sets the storage precision used by spPointCreate
+ * spPointCopyToRow		- Stores the coordinates of a point into a row of a matrix
+ * spPointRowToVector	- Converts a row of a matrix into a double array
+ * spPointRowL2SquaredDistance - Calculates the L2 squared distance to a row of a matrix
  *
  */
 
 /** Type for defining the point **/
 typedef struct sp_point_t* SPPoint;
 
+/** A type used to define the storage precision of the point's coordinates **/
+typedef enum sp_point_precision_t {
+	SP_POINT_PRECISION_DOUBLE, //8 bytes per coordinate
+	SP_POINT_PRECISION_FLOAT, //4 bytes per coordinate
+	SP_POINT_PRECISION_HALF //2 bytes per coordinate (IEEE-754 binary16)
+} SP_POINT_PRECISION;
+
+/**
+ * Sets the storage precision of all the points that will be created
+ * by spPointCreate from now on, points that were already created are not changed.
+ * The initial default precision is SP_POINT_PRECISION_DOUBLE.
+ *
+ * @param precision - the new default storage precision
+ */
+void spPointSetDefaultPrecision(SP_POINT_PRECISION precision);
+
+/**
+ * A getter for the current default storage precision
+ *
+ * @return
+ * The storage precision used by spPointCreate
+ */
+SP_POINT_PRECISION spPointGetDefaultPrecision();
+
 /**
  * Allocates a new point in the memory.
  * Given data array, dimension dim and an index.
@@ -32,6 +64,9 @@ typedef struct sp_point_t* SPPoint;
  * - p_i = data[i]
  * - The index of P = index
  *
+ * The coordinates are stored at the default storage precision
+ * (see spPointSetDefaultPrecision).
+ *
  * @return
  * NULL in case allocation failure ocurred OR data is NULL OR dim <=0 OR index <0
  * Otherwise, the new point is returned
@@ -40,6 +75,41 @@ typedef struct sp_point_t* SPPoint;
  */
 SPPoint spPointCreate(double* data, int dim, int index);
 
+/**
+ * Allocates a new point in the memory, acts as spPointCreate besides that
+ * the coordinates are stored at the given precision (and rounded to it).
+ *
+ * @param data - the coordinates of the point
+ * @param dim - the dimension of the point
+ * @param index - the image index of the point
+ * @param precision - the storage precision of the coordinates
+ *
+ * @return
+ * NULL in case allocation failure ocurred OR data is NULL OR dim <=0 OR index <0
+ * Otherwise, the new point is returned
+ *
+ * @logger - the method logs allocation and arguments errors if needed
+ */
+SPPoint spPointCreateWithPrecision(double* data, int dim, int index,
+		SP_POINT_PRECISION precision);
+
+/**
+ * Allocates a new point in the memory from a float array (as returned by the
+ * PCA projection), the coordinates are stored at the default storage precision
+ * without widening them into a temporary double array.
+ *
+ * @param data - the coordinates of the point
+ * @param dim - the dimension of the point
+ * @param index - the image index of the point
+ *
+ * @return
+ * NULL in case allocation failure ocurred OR data is NULL OR dim <=0 OR index <0
+ * Otherwise, the new point is returned
+ *
+ * @logger - the method logs allocation and arguments errors if needed
+ */
+SPPoint spPointCreateFromFloat(const float* data, int dim, int index);
+
 /**
  * Allocates a copy of the given point.
  *
@@ -48,6 +118,7 @@ SPPoint spPointCreate(double* data, int dim, int index);
  * - P_i = source_i (The ith coordinate of source and P are the same)
  * - dim(P) = dim(source) (P and source have the same dimension)
  * - index(P) = index(source) (P and source have the same index)
+ * - precision(P) = precision(source) (P and source have the same storage precision)
  *
  * @param source - The source point
  * @assert (source != NUlL)
@@ -87,6 +158,16 @@ int spPointGetDimension(SPPoint point);
  */
 int spPointGetIndex(SPPoint point);
 
+/**
+ * A getter for the storage precision of the point
+ *
+ * @param point - The source point
+ * @assert point != NULL
+ * @return
+ * The storage precision of the point's coordinates
+ */
+SP_POINT_PRECISION spPointGetPrecision(SPPoint point);
+
 /**
  * A getter for specific coordinate value
  *
@@ -104,6 +185,9 @@ double spPointGetAxisCoor(SPPoint point, int axis);
  * The L2-squared distance is defined as:
  * (p_1 - q_1)^2 + (p_2 - q_1)^2 + ... + (p_dim - q_dim)^2
  *
+ * Points that are both stored as float, or both as float16, are accumulated in float.
+ * Any other pair, a float point and a float16 point included, is accumulated in double.
+ *
  * @param p - The first point
  * @param q - The second point
  * @assert p!=NULL AND q!=NULL AND dim(p) == dim(q)
@@ -112,6 +196,54 @@ double spPointGetAxisCoor(SPPoint point, int axis);
  */
 double spPointL2SquaredDistance(SPPoint p, SPPoint q);
 
+/**
+ * Returns the size in bytes of a single coordinate stored at the given precision.
+ * The indexes keep their descriptors as row-major matrices of such coordinates
+ * (rows), so the descriptors take the same memory as they do as points.
+ *
+ * @param precision - the storage precision
+ * @return
+ * The size in bytes of a coordinate at the given precision
+ */
+size_t spPointGetCoorSize(SP_POINT_PRECISION precision);
+
+/**
+ * Stores the coordinates of the point into a row, rounding them to the row precision.
+ * The row values are exactly the point values if the precisions are the same.
+ *
+ * @param point - The source point
+ * @param row - the row, dim(point) coordinates at the given precision
+ * @param precision - the storage precision of the row
+ * @assert point != NULL && row != NULL
+ */
+void spPointCopyToRow(SPPoint point, void* row, SP_POINT_PRECISION precision);
+
+/**
+ * Converts the coordinates of a row into doubles
+ *
+ * @param row - the row, dim coordinates at the given precision
+ * @param dim - the dimension of the row
+ * @param precision - the storage precision of the row
+ * @param vector - the converted coordinates, an array of dim doubles
+ * @assert row != NULL && vector != NULL
+ */
+void spPointRowToVector(const void* row, int dim, SP_POINT_PRECISION precision,
+		double* vector);
+
+/**
+ * Calculates the L2-squared distance between a vector and a row, accumulated in double
+ *
+ * @param vector - an array of dim doubles
+ * @param row - the row, dim coordinates at the given precision
+ * @param dim - the dimension of the vector and the row
+ * @param precision - the storage precision of the row
+ * @assert vector != NULL && row != NULL
+ * @return
+ * The L2-Squared distance between the vector and the row
+ */
+double spPointRowL2SquaredDistance(const double* vector, const void* row, int dim,
+		SP_POINT_PRECISION precision);
+
 /*
  * The method returns true iff both points has the same values
  *
@@ -0,0 +1,153 @@
+#define _POSIX_C_SOURCE 200809L // getrusage under -std=c99
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <inttypes.h>
+#include <math.h>
+#include <sys/resource.h>
+#include "SPBenchmarkUtils.h"
+#include "../SPLogger.h"
+#include "../general_utils/SPUtils.h"
+
+#define NSEC_PER_USEC					1000.0
+#define NSEC_PER_SEC					1000000000.0
+#define TWO_PI							6.28318530717958647692
+
+#define REPORT_FORMAT					"bench=%s %s ops=%" PRId64 " ops_per_sec=%.1f p50_us=%.3f " \
+										"p90_us=%.3f p99_us=%.3f max_us=%.3f peak_rss_kb=%ld\n"
+
+#define ERROR_CREATING_SAMPLES			"Could not create the benchmark samples"
+#define ERROR_GENERATING_POINTS			"Could not generate the benchmark descriptors"
+
+struct sp_bench_samples_t {
+	double* latencies; // nanoseconds per operation of every sample
+	int numOfSamples;
+	int maxSamples;
+	int64_t numOfOps;
+	uint64_t totalTime;
+};
+
+SPBenchSamples spBenchSamplesCreate(int maxSamples) {
+	SPBenchSamples ret = NULL;
+	spVerifyArgumentsRn(maxSamples > 0, ERROR_CREATING_SAMPLES);
+
+	spCalloc(ret, struct sp_bench_samples_t, 1);
+	spCallocErWc(ret->latencies, double, maxSamples, ERROR_CREATING_SAMPLES, free(ret));
+	ret->maxSamples = maxSamples;
+	return ret;
+}
+
+void spBenchSamplesAdd(SPBenchSamples samples, uint64_t nanoseconds, int numOfOps) {
+	if (samples == NULL || numOfOps < 1 || samples->numOfSamples == samples->maxSamples)
+		return;
+	samples->latencies[samples->numOfSamples++] = (double) nanoseconds / numOfOps;
+	samples->numOfOps += numOfOps;
+	samples->totalTime += nanoseconds;
+}
+
+static int compareLatencies(const void* a, const void* b) {
+	double first = *(const double*) a, second = *(const double*) b;
+	return (first > second) - (first < second);
+}
+
+/*
+ * Returns the nearest rank percentile of the sorted latencies, in microseconds
+ */
+static double getPercentile(double* sortedLatencies, int size, double percentile) {
+	int rank = (int) ceil(percentile / 100.0 * size);
+	if (size == 0)
+		return 0.0;
+	rank = rank < 1 ? 1 : rank;
+	return sortedLatencies[rank - 1] / NSEC_PER_USEC;
+}
+
+void spBenchSamplesReport(SPBenchSamples samples, const char* name, const char* params) {
+	int size;
+	if (samples == NULL || name == NULL || params == NULL)
+		return;
+
+	size = samples->numOfSamples;
+	qsort(samples->latencies, size, sizeof(double), compareLatencies);
+	printf(REPORT_FORMAT, name, params, samples->numOfOps,
+			samples->totalTime > 0 ? samples->numOfOps * NSEC_PER_SEC / samples->totalTime : 0.0,
+			getPercentile(samples->latencies, size, 50),
+			getPercentile(samples->latencies, size, 90),
+			getPercentile(samples->latencies, size, 99),
+			getPercentile(samples->latencies, size, 100), spBenchGetPeakRSS());
+	fflush(stdout);
+}
+
+void spBenchSamplesDestroy(SPBenchSamples samples) {
+	if (samples == NULL)
+		return;
+	free(samples->latencies);
+	free(samples);
+}
+
+long spBenchGetPeakRSS() {
+	struct rusage usage;
+	if (getrusage(RUSAGE_SELF, &usage) != 0)
+		return -1;
+	return usage.ru_maxrss; // kilobytes on Linux
+}
+
+/*
+ * Returns a number uniformly distributed in [0, 1)
+ */
+static double getUniform() {
+	return (double) rand() / ((double) RAND_MAX + 1.0);
+}
+
+/*
+ * Returns a standard normal number (Box-Muller transform)
+ */
+static double getNormal() {
+	double u = 1.0 - getUniform(); // in (0, 1]
+	return sqrt(-2.0 * log(u)) * cos(TWO_PI * getUniform());
+}
+
+SPPoint* spBenchGenerateUniform(int size, int dim, int numOfImages) {
+	return spBenchGenerateClustered(size, dim, 0, 0.0, numOfImages);
+}
+
+SPPoint* spBenchGenerateClustered(int size, int dim, int numOfClusters, double deviation,
+		int numOfImages) {
+	SPPoint* ret = NULL;
+	double *centers = NULL, *data = NULL;
+	int i, j;
+	spVerifyArgumentsRn(size > 0 && dim > 0 && numOfClusters >= 0 && deviation >= 0.0 &&
+			numOfImages > 0, ERROR_GENERATING_POINTS);
+
+	spCallocEr(data, double, dim, ERROR_GENERATING_POINTS, NULL);
+	spCallocErWc(ret, SPPoint, size, ERROR_GENERATING_POINTS, free(data));
+	if (numOfClusters > 0) {
+		spCallocErWc(centers, double, numOfClusters * dim, ERROR_GENERATING_POINTS,
+				free(data); free(ret));
+		for (i = 0; i < numOfClusters * dim; i++)
+			centers[i] = getUniform();
+	}
+
+	for (i = 0; i < size; i++) {
+		for (j = 0; j < dim; j++) {
+			data[j] = numOfClusters > 0 ?
+					centers[(i % numOfClusters) * dim + j] + deviation * getNormal() :
+					getUniform();
+		}
+		spValWcRn((ret[i] = spPointCreate(data, dim, i % numOfImages)) != NULL,
+				ERROR_GENERATING_POINTS,
+				spBenchDestroyPoints(ret, i); free(centers); free(data));
+	}
+
+	free(centers);
+	free(data);
+	return ret;
+}
+
+void spBenchDestroyPoints(SPPoint* points, int size) {
+	int i;
+	if (points == NULL)
+		return;
+	for (i = 0; i < size; i++)
+		spPointDestroy(points[i]);
+	free(points);
+}
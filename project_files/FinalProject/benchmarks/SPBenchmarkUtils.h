@@ -0,0 +1,120 @@
+#ifndef SPBENCHMARKUTILS_H_
+#define SPBENCHMARKUTILS_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "../SPPoint.h"
+
+/**
+ * SP Benchmark Utils summary
+ *
+ * Latency samples with a stable one line report, and the generation of the synthetic
+ * descriptor sets used by the benchmarks.
+ *
+ * A report line is made of space separated key=value fields in a fixed order:
+ * 		bench=<name> <params> ops=<num> ops_per_sec=<num> p50_us=<num> p90_us=<num>
+ * 		p99_us=<num> max_us=<num> peak_rss_kb=<num>
+ * where the percentiles are of the latency of a single operation, and peak_rss_kb is the
+ * peak resident set size of the process so far. The lines of two runs with the same
+ * arguments are of the same benchmarks at the same order, so the runs can be diffed.
+ *
+ * The following functions are supported:
+ *
+ * spBenchSamplesCreate		- Creates an empty samples set
+ * spBenchSamplesAdd		- Adds the time of a batch of operations
+ * spBenchSamplesReport		- Writes the report line of the samples
+ * spBenchSamplesDestroy	- Frees a samples set
+ * spBenchGetPeakRSS		- Returns the peak resident set size of the process
+ * spBenchGenerateUniform	- Generates uniformly distributed descriptors
+ * spBenchGenerateClustered	- Generates descriptors of Gaussian clusters
+ * spBenchDestroyPoints		- Frees a descriptors array
+ */
+
+/** Type for defining the samples set **/
+typedef struct sp_bench_samples_t* SPBenchSamples;
+
+/*
+ * Creates an empty samples set
+ *
+ * @param maxSamples - the maximal number of samples (batches) that will be added
+ *
+ * @returns NULL in case of invalid arguments or memory allocation error, otherwise
+ * the new samples set
+ *
+ * @logger - the method logs allocation and arguments errors if needed
+ */
+SPBenchSamples spBenchSamplesCreate(int maxSamples);
+
+/*
+ * Adds a sample of a batch of operations, the latency of every operation of the batch
+ * is taken as the mean latency of the batch (a batch is used when a single operation is
+ * too short to be timed by itself).
+ * A sample beyond maxSamples is ignored.
+ *
+ * @param samples - the samples set
+ * @param nanoseconds - the time of the batch
+ * @param numOfOps - the number of operations in the batch, at least 1
+ */
+void spBenchSamplesAdd(SPBenchSamples samples, uint64_t nanoseconds, int numOfOps);
+
+/*
+ * Writes the report line of the samples (as described above) to stdout
+ *
+ * @param samples - the samples set
+ * @param name - the benchmark name
+ * @param params - the benchmark parameters, as space separated key=value fields
+ */
+void spBenchSamplesReport(SPBenchSamples samples, const char* name, const char* params);
+
+/*
+ * Frees all the resources of the samples set, if samples is NULL nothing happens
+ */
+void spBenchSamplesDestroy(SPBenchSamples samples);
+
+/*
+ * Returns the peak resident set size of the process in kilobytes, or -1 on failure
+ */
+long spBenchGetPeakRSS();
+
+/*
+ * Generates descriptors with coordinates uniformly distributed in [0, 1), by rand().
+ * The descriptors are assigned to numOfImages images in turn.
+ *
+ * @param size - the number of descriptors
+ * @param dim - the dimension of the descriptors
+ * @param numOfImages - the number of images
+ *
+ * @returns NULL in case of invalid arguments or memory allocation error, otherwise the
+ * descriptors array
+ *
+ * @logger - the method logs allocation and arguments errors if needed
+ */
+SPPoint* spBenchGenerateUniform(int size, int dim, int numOfImages);
+
+/*
+ * Generates descriptors of numOfClusters Gaussian clusters, by rand(). The cluster
+ * centers are uniformly distributed in [0, 1), and every coordinate is drawn from a
+ * normal distribution around the center of its cluster. The descriptors are assigned
+ * to the clusters and to numOfImages images in turn.
+ *
+ * @param size - the number of descriptors
+ * @param dim - the dimension of the descriptors
+ * @param numOfClusters - the number of clusters, 0 for uniformly distributed descriptors
+ * @param deviation - the standard deviation of the clusters
+ * @param numOfImages - the number of images
+ *
+ * @returns NULL in case of invalid arguments or memory allocation error, otherwise the
+ * descriptors array
+ *
+ * @logger - the method logs allocation and arguments errors if needed
+ */
+SPPoint* spBenchGenerateClustered(int size, int dim, int numOfClusters, double deviation,
+		int numOfImages);
+
+/*
+ * Destroys the first size descriptors of the array and frees it, if points is NULL
+ * nothing happens
+ */
+void spBenchDestroyPoints(SPPoint* points, int size);
+
+#endif /* SPBENCHMARKUTILS_H_ */
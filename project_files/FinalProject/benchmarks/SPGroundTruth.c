@@ -0,0 +1,281 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "SPGroundTruth.h"
+#include "../SPLogger.h"
+#include "../data_structures/bpqueue_ds/SPBPriorityQueue.h"
+#include "../data_structures/index_ds/SPBruteForceIndex.h"
+#include "../main_and_ui/SPImageQuery.h"
+#include "../general_utils/SPUtils.h"
+
+#define NO_NEIGHBOUR					-1
+#define WRITE_MODE						"w"
+#define READ_MODE						"r"
+#define SIZES_FORMAT					"%d %d %d\n"
+#define ITEM_FORMAT						"%d%c"
+
+#define ERROR_CREATING_GROUND_TRUTH		"Could not compute the ground truth"
+#define WARNING_SAVING_GROUND_TRUTH		"Could not write the ground truth cache file"
+#define WARNING_OTHER_GROUND_TRUTH		"The ground truth cache file is of other queries or settings, it is ignored"
+#define WARNING_LOADING_GROUND_TRUTH	"The ground truth cache file is malformed, it is ignored"
+
+/*
+ * Allocates a ground truth with the given sizes and no queries results yet
+ */
+static SPGroundTruth allocateGroundTruth(int numOfQueries, int knn, int numOfSimilarImages) {
+	SPGroundTruth ret = NULL;
+
+	spCalloc(ret, struct sp_ground_truth_t, 1);
+	ret->numOfQueries = numOfQueries;
+	ret->knn = knn;
+	ret->numOfSimilarImages = numOfSimilarImages;
+	spCallocErWc(ret->numOfFeatures, int, numOfQueries, ERROR_CREATING_GROUND_TRUTH,
+			spGroundTruthDestroy(ret));
+	spCallocErWc(ret->neighbours, int*, numOfQueries, ERROR_CREATING_GROUND_TRUTH,
+			spGroundTruthDestroy(ret));
+	spCallocErWc(ret->rankings, int*, numOfQueries, ERROR_CREATING_GROUND_TRUTH,
+			spGroundTruthDestroy(ret));
+	return ret;
+}
+
+/*
+ * Finds the exact neighbours and the exact ranking of a single query image
+ *
+ * @return false in case of memory allocation error or search error, true otherwise
+ */
+static bool computeQuery(SPGroundTruth groundTruth, int query, SPBruteForceIndex index,
+		SPImageData image, int numOfImages) {
+	SPBPQueue* bpqs = NULL;
+	int *counterArray = NULL, *neighbours, i, j, knn = groundTruth->knn;
+	bool isSuccess;
+
+	groundTruth->numOfFeatures[query] = image->numOfFeatures;
+	isSuccess = (counterArray = initializeCounterArray(numOfImages)) != NULL &&
+			(groundTruth->neighbours[query] = (int*) calloc(
+					image->numOfFeatures * knn + 1, sizeof(int))) != NULL &&
+			(bpqs = (SPBPQueue*) calloc(image->numOfFeatures + 1, sizeof(SPBPQueue))) != NULL;
+	for (i = 0; isSuccess && i < image->numOfFeatures; i++)
+		isSuccess = (bpqs[i] = spBPQueueCreate(knn)) != NULL;
+
+	isSuccess = isSuccess && (image->numOfFeatures == 0 || spBruteForceIndexKNNBatch(index,
+			bpqs, image->featuresArray, image->numOfFeatures));
+	for (i = 0; isSuccess && i < image->numOfFeatures; i++) {
+		neighbours = groundTruth->neighbours[query] + i * knn;
+		for (j = 0; j < knn; j++) {
+			neighbours[j] = NO_NEIGHBOUR;
+			if (!spBPQueueIsEmpty(bpqs[i])) {
+				neighbours[j] = spBPQueueMinIndex(bpqs[i]);
+				counterArray[neighbours[j]]++;
+				spBPQueueDequeue(bpqs[i]);
+			}
+		}
+	}
+
+	// ranked as getSimilarImages ranks the images of the approximate neighbours
+	isSuccess = isSuccess && (groundTruth->rankings[query] = getTopItems(counterArray,
+			numOfImages, groundTruth->numOfSimilarImages)) != NULL;
+
+	for (i = 0; bpqs != NULL && i < image->numOfFeatures; i++)
+		spBPQueueDestroy(bpqs[i]);
+	free(bpqs);
+	free(counterArray);
+	return isSuccess;
+}
+
+SPGroundTruth spGroundTruthCreate(SPPoint* database, int size, int numOfImages,
+		SPImageData* queries, int numOfQueries, int knn, int numOfSimilarImages,
+		int numOfThreads) {
+	SPGroundTruth ret = NULL;
+	SPBruteForceIndex index = NULL;
+	SPPoint* copies = NULL;
+	int i;
+	spVerifyArgumentsRn(database != NULL && size > 0 && numOfImages > 0 && queries != NULL &&
+			numOfQueries > 0 && knn > 0 && numOfSimilarImages > 0 &&
+			numOfSimilarImages <= numOfImages && numOfThreads > 0, ERROR_CREATING_GROUND_TRUTH);
+
+	spCallocEr(copies, SPPoint, size, ERROR_CREATING_GROUND_TRUTH, NULL);
+	for (i = 0; i < size; i++) {
+		spValWcRn((copies[i] = spPointCopy(database[i])) != NULL, ERROR_CREATING_GROUND_TRUTH,
+				freeFeatures(copies, i); free(copies));
+	}
+
+	// the index destroys the copies once they are in its matrix
+	spValWcRn((index = spBruteForceIndexCreate(copies, size, numOfThreads)) != NULL,
+			ERROR_CREATING_GROUND_TRUTH, freeFeatures(copies, size); free(copies));
+	free(copies);
+
+	spValWcRn((ret = allocateGroundTruth(numOfQueries, knn, numOfSimilarImages)) != NULL,
+			ERROR_CREATING_GROUND_TRUTH, spBruteForceIndexDestroy(index));
+	for (i = 0; i < numOfQueries; i++) {
+		spValWcRn(computeQuery(ret, i, index, queries[i], numOfImages),
+				ERROR_CREATING_GROUND_TRUTH,
+				spBruteForceIndexDestroy(index); spGroundTruthDestroy(ret));
+	}
+
+	spBruteForceIndexDestroy(index);
+	return ret;
+}
+
+/*
+ * Writes size items as a single line
+ *
+ * @return false if the write failed, true otherwise
+ */
+static bool writeItems(FILE* file, const int* items, int size) {
+	int i;
+	bool isWritten = true;
+	for (i = 0; isWritten && i < size; i++)
+		isWritten = fprintf(file, ITEM_FORMAT, items[i], i < size - 1 ? ' ' : '\n') >= 0;
+	return isWritten;
+}
+
+bool spGroundTruthSave(SPGroundTruth groundTruth, const char* filename, const char* key) {
+	FILE* file = NULL;
+	bool isWritten;
+	int i, j, knn;
+
+	if (groundTruth == NULL || filename == NULL || key == NULL ||
+			(file = fopen(filename, WRITE_MODE)) == NULL) {
+		spLoggerSafePrintWarning(WARNING_SAVING_GROUND_TRUTH, __FILE__, __FUNCTION__, __LINE__);
+		return false;
+	}
+
+	knn = groundTruth->knn;
+	isWritten = fputs(key, file) >= 0 && fprintf(file, SIZES_FORMAT,
+			groundTruth->numOfQueries, knn, groundTruth->numOfSimilarImages) >= 0;
+	for (i = 0; isWritten && i < groundTruth->numOfQueries; i++) {
+		isWritten = fprintf(file, "%d\n", groundTruth->numOfFeatures[i]) >= 0;
+		for (j = 0; isWritten && j < groundTruth->numOfFeatures[i]; j++)
+			isWritten = writeItems(file, groundTruth->neighbours[i] + j * knn, knn);
+		isWritten = isWritten && writeItems(file, groundTruth->rankings[i],
+				groundTruth->numOfSimilarImages);
+	}
+	isWritten = fclose(file) == 0 && isWritten;
+
+	spValWarning(isWritten, WARNING_SAVING_GROUND_TRUTH, , );
+	return isWritten;
+}
+
+/*
+ * Reads size whitespace separated items
+ *
+ * @return false if the read failed, true otherwise
+ */
+static bool readItems(FILE* file, int* items, int size) {
+	int i;
+	for (i = 0; i < size; i++) {
+		if (fscanf(file, "%d", items + i) != 1)
+			return false;
+	}
+	return true;
+}
+
+/*
+ * Reads the queries results of a cache file whose key was already read
+ *
+ * @return NULL if the file is malformed or in case of memory allocation error,
+ * otherwise the ground truth
+ */
+static SPGroundTruth readGroundTruth(FILE* file) {
+	SPGroundTruth ret = NULL;
+	int i, numOfQueries, knn, numOfSimilarImages, numOfFeatures = 0;
+	bool isSuccess;
+
+	if (fscanf(file, "%d %d %d", &numOfQueries, &knn, &numOfSimilarImages) != 3 ||
+			numOfQueries <= 0 || knn <= 0 || numOfSimilarImages <= 0 ||
+			(ret = allocateGroundTruth(numOfQueries, knn, numOfSimilarImages)) == NULL)
+		return NULL;
+
+	isSuccess = true;
+	for (i = 0; isSuccess && i < numOfQueries; i++) {
+		isSuccess = fscanf(file, "%d", &numOfFeatures) == 1 && numOfFeatures >= 0 &&
+				(ret->neighbours[i] = (int*) calloc(numOfFeatures * knn + 1,
+						sizeof(int))) != NULL &&
+				(ret->rankings[i] = (int*) calloc(numOfSimilarImages, sizeof(int))) != NULL &&
+				readItems(file, ret->neighbours[i], numOfFeatures * knn) &&
+				readItems(file, ret->rankings[i], numOfSimilarImages);
+		ret->numOfFeatures[i] = numOfFeatures;
+	}
+
+	if (!isSuccess) {
+		spGroundTruthDestroy(ret);
+		return NULL;
+	}
+	return ret;
+}
+
+SPGroundTruth spGroundTruthLoad(const char* filename, const char* key) {
+	SPGroundTruth ret = NULL;
+	FILE* file = NULL;
+	char* fileKey = NULL;
+	size_t keyLength;
+	bool isSameKey;
+
+	if (filename == NULL || key == NULL || (file = fopen(filename, READ_MODE)) == NULL)
+		return NULL; // nothing was cached yet
+
+	keyLength = strlen(key);
+	spCallocErWc(fileKey, char, keyLength + 1, WARNING_LOADING_GROUND_TRUTH, fclose(file));
+	isSameKey = fread(fileKey, sizeof(char), keyLength, file) == keyLength &&
+			strcmp(fileKey, key) == 0;
+	free(fileKey);
+
+	if (!isSameKey)
+		spLoggerSafePrintWarning(WARNING_OTHER_GROUND_TRUTH, __FILE__, __FUNCTION__, __LINE__);
+	else if ((ret = readGroundTruth(file)) == NULL)
+		spLoggerSafePrintWarning(WARNING_LOADING_GROUND_TRUTH, __FILE__, __FUNCTION__,
+				__LINE__);
+	fclose(file);
+	return ret;
+}
+
+static int compareItems(const void* a, const void* b) {
+	int first = *(const int*) a, second = *(const int*) b;
+	return (first > second) - (first < second);
+}
+
+int spGroundTruthCountMatches(const int* exact, const int* found, int size) {
+	int *sortedExact = NULL, *sortedFound = NULL, i = 0, j = 0, ret = 0;
+	if (exact == NULL || found == NULL || size < 0)
+		return -1;
+
+	if ((sortedExact = (int*) malloc((size + 1) * sizeof(int))) == NULL ||
+			(sortedFound = (int*) malloc((size + 1) * sizeof(int))) == NULL) {
+		free(sortedExact);
+		return -1;
+	}
+	memcpy(sortedExact, exact, size * sizeof(int));
+	memcpy(sortedFound, found, size * sizeof(int));
+	qsort(sortedExact, size, sizeof(int), compareItems);
+	qsort(sortedFound, size, sizeof(int), compareItems);
+
+	while (i < size && j < size) {
+		if (sortedExact[i] < sortedFound[j]) {
+			i++;
+		} else if (sortedExact[i] > sortedFound[j]) {
+			j++;
+		} else {
+			ret += sortedExact[i] != NO_NEIGHBOUR;
+			i++;
+			j++;
+		}
+	}
+
+	free(sortedExact);
+	free(sortedFound);
+	return ret;
+}
+
+void spGroundTruthDestroy(SPGroundTruth groundTruth) {
+	int i;
+	if (groundTruth == NULL)
+		return;
+	for (i = 0; groundTruth->neighbours != NULL && i < groundTruth->numOfQueries; i++)
+		free(groundTruth->neighbours[i]);
+	for (i = 0; groundTruth->rankings != NULL && i < groundTruth->numOfQueries; i++)
+		free(groundTruth->rankings[i]);
+	free(groundTruth->neighbours);
+	free(groundTruth->rankings);
+	free(groundTruth->numOfFeatures);
+	free(groundTruth);
+}
@@ -0,0 +1,110 @@
+#ifndef SPGROUNDTRUTH_H_
+#define SPGROUNDTRUTH_H_
+
+#include <stdbool.h>
+#include "../SPPoint.h"
+#include "../image_parsing/SPImageData.h"
+
+/**
+ * SP Ground Truth summary
+ *
+ * The exact search results of a set of query images against a database of descriptors,
+ * found by a brute force scan: the images of the k nearest database descriptors of every
+ * query descriptor, and the N most similar images of every query image as ranked by
+ * getSimilarImages (by the number of nearest descriptors in every image).
+ * The results of an approximate index are measured against them, and since computing
+ * them takes a full scan per query descriptor, they are cached in a text file.
+ *
+ * A cache file starts with a key given by the caller (which should identify the database,
+ * the queries, k and N), and a file with a different key is not loaded. The key is
+ * followed by the results of every query: its number of descriptors, the k neighbour
+ * images of every descriptor (one line per descriptor) and the N ranked images.
+ *
+ * The following functions are supported:
+ *
+ * spGroundTruthCreate		- Computes the ground truth by a brute force scan
+ * spGroundTruthSave		- Writes the ground truth to a cache file
+ * spGroundTruthLoad		- Reads the ground truth from a cache file
+ * spGroundTruthCountMatches	- Counts the common items of two results
+ * spGroundTruthDestroy		- Frees the ground truth
+ */
+
+/** Type for defining the ground truth **/
+typedef struct sp_ground_truth_t {
+	int numOfQueries;
+	int knn;
+	int numOfSimilarImages;
+	int* numOfFeatures; // of every query
+	int** neighbours; // of every query, knn image indices per descriptor, nearest first
+	int** rankings; // of every query, numOfSimilarImages image indices, most similar first
+} *SPGroundTruth;
+
+/*
+ * Computes the ground truth of the queries by a brute force scan of the database.
+ * The database points are not changed (the scan is of copies of them).
+ * A neighbour that does not exist (a database of less than knn descriptors) is -1.
+ *
+ * @param database - the database descriptors
+ * @param size - the size of database
+ * @param numOfImages - the number of database images, the descriptors indices are below it
+ * @param queries - the query images
+ * @param numOfQueries - the size of queries
+ * @param knn - the number of nearest descriptors of every query descriptor
+ * @param numOfSimilarImages - the number of ranked images of every query image, at most
+ * numOfImages
+ * @param numOfThreads - the number of threads that scan the database, at least 1
+ *
+ * @returns NULL in case of invalid arguments, memory allocation error or search error,
+ * otherwise the ground truth
+ *
+ * @logger - the method logs allocation and arguments errors if needed
+ */
+SPGroundTruth spGroundTruthCreate(SPPoint* database, int size, int numOfImages,
+		SPImageData* queries, int numOfQueries, int knn, int numOfSimilarImages,
+		int numOfThreads);
+
+/*
+ * Writes the ground truth to a cache file, after the given key
+ *
+ * @param groundTruth - the ground truth
+ * @param filename - the cache file, replaced if it exists
+ * @param key - the key of the cache file
+ *
+ * @returns false if the file could not be written, true otherwise
+ *
+ * @logger - a warning is logged if the file could not be written
+ */
+bool spGroundTruthSave(SPGroundTruth groundTruth, const char* filename, const char* key);
+
+/*
+ * Reads the ground truth from a cache file
+ *
+ * @param filename - the cache file
+ * @param key - the expected key of the cache file
+ *
+ * @returns NULL if the file does not exist, has a different key, is malformed or in case of
+ * memory allocation error, otherwise the ground truth
+ *
+ * @logger - a warning is logged if the file exists but was not loaded
+ */
+SPGroundTruth spGroundTruthLoad(const char* filename, const char* key);
+
+/*
+ * Returns the number of common items of two results of the same size, as multisets
+ * (an item that appears twice in both results is counted twice). -1 items are ignored.
+ *
+ * @param exact - the ground truth result
+ * @param found - the result of an approximate search
+ * @param size - the size of both results
+ *
+ * @returns -1 in case of invalid arguments or memory allocation error, otherwise the
+ * number of common items
+ */
+int spGroundTruthCountMatches(const int* exact, const int* found, int size);
+
+/*
+ * Frees all the resources of the ground truth, if groundTruth is NULL nothing happens
+ */
+void spGroundTruthDestroy(SPGroundTruth groundTruth);
+
+#endif /* SPGROUNDTRUTH_H_ */
@@ -0,0 +1,569 @@
+/* ------------------------------------------------------------README-----------------------------------------------------------------
+Please read the following regarding the benchmarks:
+
+* In order to run the benchmarks run 'benchmark_makefile' (make -f benchmark_makefile) and then
+  './SPCBIR_BENCHMARK [options] [file.feats ...]', see BENCH_USAGE below for the options.
+
+* If you are working with an IDE, you should exclude the '/benchmarks' directory from the project build, since this
+  file has its own main function.
+
+* The results are written to stdout, one line per benchmark (see SPBenchmarkUtils.h), so the results of two
+  versions can be compared with diff. Errors are written to the logger (stdout unless -l is given).
+ -----------------------------------------------------------------------------------------------------------------------------------*/
+
+#define _POSIX_C_SOURCE 200809L // getopt under -std=c99
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "SPBenchmarkUtils.h"
+#include "../SPPoint.h"
+#include "../SPConfig.h"
+#include "../SPLogger.h"
+#include "../data_structures/bpqueue_ds/SPBPriorityQueue.h"
+#include "../data_structures/kd_ds/SPKDArray.h"
+#include "../data_structures/kd_ds/SPKDTreeNode.h"
+#include "../data_structures/kd_ds/SPKDTreeNodeKNN.h"
+#include "../image_parsing/SPImagesParser.h"
+#include "../image_parsing/SPImageData.h"
+#include "../general_utils/SPInstrumentation.h"
+#include "../general_utils/SPUtils.h"
+
+#define BENCH_FAILURE_RET_VAL			-1
+#define BENCH_OPTIONS					"n:d:q:k:c:r:b:i:s:t:l:"
+#define BENCH_USAGE						"Usage: %s [-n size] [-d dim] [-q queries] [-k k1,k2,...] " \
+										"[-c clusters] [-r reps] [-b build_reps] [-i features_per_image] " \
+										"[-s seed] [-t tmp_dir] [-l log_file] [file.feats ...]\n"
+#define BENCH_HEADER					"# spcbir benchmark seed=%u n=%d dim=%d queries=%d clusters=%d " \
+										"reps=%d build_reps=%d features_per_image=%d\n"
+#define BENCH_FOOTER					"# peak_rss_kb=%ld\n"
+#define BENCH_FAILED					"bench=%s %s failed\n"
+
+#define DEFAULT_SIZE					10000
+#define DEFAULT_DIM						128
+#define DEFAULT_NUM_OF_QUERIES			200
+#define DEFAULT_K_VALUES				"1,5,10,50"
+#define DEFAULT_NUM_OF_CLUSTERS			16
+#define DEFAULT_REPS					200
+#define DEFAULT_BUILD_REPS				5
+#define DEFAULT_FEATURES_PER_IMAGE		100
+#define DEFAULT_SEED					1
+#define DEFAULT_TMP_DIR					"./benchmarks"
+
+#define MAX_K_VALUES					16
+#define MAX_PARAMS_LEN					256
+#define BATCH_SIZE						1000 // operations per sample of the short operations
+#define CLUSTERS_DEVIATION				0.05
+#define FEATS_SIGNATURE					"spcbir benchmark\n"
+#define FEATS_FILE_FORMAT				"%s/bench_%d.feats"
+#define WRITE_MODE						"w"
+#define READ_MODE						"r"
+
+#define RANDOM_DATA_NAME				"random"
+#define UNIFORM_DATA_NAME				"uniform"
+#define CLUSTERED_DATA_NAME				"clustered"
+#define FEATS_DATA_NAME					"feats"
+
+#define ERROR_BENCHMARK_DATA			"Could not create the benchmark descriptors"
+#define ERROR_READING_FEATS				"Could not read the benchmark .feats file"
+#define ERROR_TOO_FEW_FEATS				"The .feats files have no more descriptors than the queries"
+
+/** The command line options of the benchmarks **/
+typedef struct sp_bench_options_t {
+	int size; // of the database descriptors, not including the queries
+	int dim;
+	int numOfQueries;
+	int kValues[MAX_K_VALUES];
+	int numOfKValues;
+	int numOfClusters;
+	int reps; // samples of the short operations
+	int buildReps; // samples of the build operations
+	int featuresPerImage;
+	unsigned int seed;
+	const char* tmpDir;
+	const char* logFile;
+	char** featsFiles;
+	int numOfFeatsFiles;
+} SPBenchOptions;
+
+/** A descriptors set, where the queries are held out of the database descriptors **/
+typedef struct sp_bench_data_t {
+	const char* name;
+	SPPoint* points; // size database descriptors followed by numOfQueries queries
+	int size;
+	int numOfQueries;
+	int dim;
+} SPBenchData;
+
+static const char* splitMethodNames[] = { "RANDOM", "MAX_SPREAD", "INCREMENTAL" };
+static const SP_KDTREE_SPLIT_METHOD splitMethods[] = { RANDOM, MAX_SPREAD, INCREMENTAL };
+#define NUM_OF_SPLIT_METHODS			3
+
+/*
+ * Prevents the compiler from dropping the computed distances
+ */
+static volatile double distancesSink;
+
+/*
+ * Parses a positive int, returns false if value is not a positive int
+ */
+static bool parsePositive(const char* value, int* result) {
+	char* end = NULL;
+	long parsed = strtol(value, &end, 10);
+	if (end == value || *end != '\0' || parsed <= 0 || parsed > 1000000000L)
+		return false;
+	*result = (int) parsed;
+	return true;
+}
+
+/*
+ * Parses a comma separated list of positive ints into the k values of options
+ */
+static bool parseKValues(const char* value, SPBenchOptions* options) {
+	char list[MAX_PARAMS_LEN], *token = NULL;
+	if (strlen(value) >= MAX_PARAMS_LEN)
+		return false;
+	strcpy(list, value);
+
+	options->numOfKValues = 0;
+	for (token = strtok(list, ","); token != NULL; token = strtok(NULL, ",")) {
+		if (options->numOfKValues == MAX_K_VALUES ||
+				!parsePositive(token, &(options->kValues[options->numOfKValues++])))
+			return false;
+	}
+	return options->numOfKValues > 0;
+}
+
+/*
+ * Fills options by the command line arguments
+ *
+ * @return false if the arguments are invalid, true otherwise
+ */
+static bool parseOptions(int argc, char* argv[], SPBenchOptions* options) {
+	int option, seed;
+	bool isValid = true;
+
+	options->size = DEFAULT_SIZE;
+	options->dim = DEFAULT_DIM;
+	options->numOfQueries = DEFAULT_NUM_OF_QUERIES;
+	options->numOfClusters = DEFAULT_NUM_OF_CLUSTERS;
+	options->reps = DEFAULT_REPS;
+	options->buildReps = DEFAULT_BUILD_REPS;
+	options->featuresPerImage = DEFAULT_FEATURES_PER_IMAGE;
+	options->seed = DEFAULT_SEED;
+	options->tmpDir = DEFAULT_TMP_DIR;
+	options->logFile = NULL;
+	parseKValues(DEFAULT_K_VALUES, options);
+
+	while (isValid && (option = getopt(argc, argv, BENCH_OPTIONS)) != -1) {
+		switch (option) {
+		case 'n': isValid = parsePositive(optarg, &(options->size)); break;
+		case 'd': isValid = parsePositive(optarg, &(options->dim)); break;
+		case 'q': isValid = parsePositive(optarg, &(options->numOfQueries)); break;
+		case 'k': isValid = parseKValues(optarg, options); break;
+		case 'c': isValid = parsePositive(optarg, &(options->numOfClusters)); break;
+		case 'r': isValid = parsePositive(optarg, &(options->reps)); break;
+		case 'b': isValid = parsePositive(optarg, &(options->buildReps)); break;
+		case 'i': isValid = parsePositive(optarg, &(options->featuresPerImage)); break;
+		case 's':
+			isValid = parsePositive(optarg, &seed);
+			options->seed = (unsigned int) seed;
+			break;
+		case 't': options->tmpDir = optarg; break;
+		case 'l': options->logFile = optarg; break;
+		default: isValid = false; break;
+		}
+	}
+
+	options->featsFiles = argv + optind;
+	options->numOfFeatsFiles = argc - optind;
+	return isValid;
+}
+
+/*
+ * Times spPointL2SquaredDistance between database descriptors and queries
+ */
+static bool benchDistance(SPBenchData* data, SPBenchOptions* options, const char* params) {
+	SPBenchSamples samples = spBenchSamplesCreate(options->reps);
+	SPPoint* queries = data->points + data->size;
+	double sum = 0.0;
+	uint64_t start;
+	int rep, i;
+	if (samples == NULL)
+		return false;
+
+	for (rep = 0; rep < options->reps; rep++) {
+		start = spInstrumentationNow();
+		for (i = 0; i < BATCH_SIZE; i++) {
+			sum += spPointL2SquaredDistance(data->points[(rep * BATCH_SIZE + i) % data->size],
+					queries[i % data->numOfQueries]);
+		}
+		spBenchSamplesAdd(samples, spInstrumentationNow() - start, BATCH_SIZE);
+	}
+	distancesSink = sum;
+
+	spBenchSamplesReport(samples, "point_distance", params);
+	spBenchSamplesDestroy(samples);
+	return true;
+}
+
+/*
+ * Times spBPQueueEnqueue of random values into a queue of capacity k, for every k
+ */
+static bool benchEnqueue(SPBenchOptions* options, const char* params) {
+	char kParams[MAX_PARAMS_LEN];
+	SPListElement elements[BATCH_SIZE] = { NULL };
+	SPBenchSamples samples = NULL;
+	SPBPQueue queue = NULL;
+	bool isSuccess = true;
+	uint64_t start;
+	int k, rep, i;
+
+	for (i = 0; isSuccess && i < BATCH_SIZE; i++)
+		isSuccess = (elements[i] = spListElementCreate(i, (double) rand() / RAND_MAX)) != NULL;
+
+	for (k = 0; isSuccess && k < options->numOfKValues; k++) {
+		samples = spBenchSamplesCreate(options->reps);
+		queue = spBPQueueCreate(options->kValues[k]);
+		isSuccess = samples != NULL && queue != NULL;
+		for (rep = 0; isSuccess && rep < options->reps; rep++) {
+			spBPQueueClear(queue);
+			start = spInstrumentationNow();
+			for (i = 0; i < BATCH_SIZE; i++) {
+				if (spBPQueueEnqueue(queue, elements[i]) == SP_BPQUEUE_OUT_OF_MEMORY)
+					isSuccess = false;
+			}
+			spBenchSamplesAdd(samples, spInstrumentationNow() - start, BATCH_SIZE);
+		}
+
+		isSuccess = isSuccess && snprintf(kParams, MAX_PARAMS_LEN, "%s k=%d", params,
+				options->kValues[k]) < MAX_PARAMS_LEN;
+		if (isSuccess)
+			spBenchSamplesReport(samples, "bpqueue_enqueue", kParams);
+		spBPQueueDestroy(queue);
+		spBenchSamplesDestroy(samples);
+	}
+
+	for (i = 0; i < BATCH_SIZE; i++)
+		spListElementDestroy(elements[i]);
+	return isSuccess;
+}
+
+/*
+ * Times Init of the database descriptors
+ */
+static bool benchKDArrayInit(SPBenchData* data, SPBenchOptions* options, const char* params) {
+	SPBenchSamples samples = spBenchSamplesCreate(options->buildReps);
+	SPKDArray array = NULL;
+	uint64_t start;
+	int rep;
+	if (samples == NULL)
+		return false;
+
+	for (rep = 0; rep < options->buildReps; rep++) {
+		start = spInstrumentationNow();
+		array = Init(data->points, data->size);
+		spBenchSamplesAdd(samples, spInstrumentationNow() - start, 1);
+		if (array == NULL) {
+			spBenchSamplesDestroy(samples);
+			return false;
+		}
+		spKDArrayDestroy(array);
+	}
+
+	spBenchSamplesReport(samples, "kdarray_init", params);
+	spBenchSamplesDestroy(samples);
+	return true;
+}
+
+/*
+ * Times Split of the database descriptors KD array, by a different coordinate every time
+ */
+static bool benchKDArraySplit(SPBenchData* data, SPBenchOptions* options, const char* params) {
+	SPBenchSamples samples = spBenchSamplesCreate(options->buildReps);
+	SPKDArray array = Init(data->points, data->size);
+	SPKDArrayPair pair = NULL;
+	bool isSuccess = samples != NULL && array != NULL;
+	uint64_t start;
+	int rep;
+
+	for (rep = 0; isSuccess && rep < options->buildReps; rep++) {
+		start = spInstrumentationNow();
+		pair = Split(array, rep % data->dim);
+		spBenchSamplesAdd(samples, spInstrumentationNow() - start, 1);
+		isSuccess = pair != NULL;
+		spKDArrayPairDestroy(pair);
+	}
+
+	if (isSuccess)
+		spBenchSamplesReport(samples, "kdarray_split", params);
+	if (array != NULL)
+		spKDArrayDestroy(array);
+	spBenchSamplesDestroy(samples);
+	return isSuccess;
+}
+
+/*
+ * Times kNearestNeighbors of every query at every k on the given tree
+ */
+static bool benchKNN(SPBenchData* data, SPBenchOptions* options, SPKDTreeNode tree,
+		const char* params) {
+	char kParams[MAX_PARAMS_LEN];
+	SPBenchSamples samples = NULL;
+	SPBPQueue queue = NULL;
+	bool isSuccess = true;
+	uint64_t start;
+	int k, i;
+
+	for (k = 0; isSuccess && k < options->numOfKValues; k++) {
+		samples = spBenchSamplesCreate(data->numOfQueries);
+		queue = spBPQueueCreate(options->kValues[k]);
+		isSuccess = samples != NULL && queue != NULL;
+		for (i = 0; isSuccess && i < data->numOfQueries; i++) {
+			spBPQueueClear(queue);
+			start = spInstrumentationNow();
+			isSuccess = kNearestNeighbors(tree, queue, data->points[data->size + i]);
+			spBenchSamplesAdd(samples, spInstrumentationNow() - start, 1);
+		}
+
+		isSuccess = isSuccess && snprintf(kParams, MAX_PARAMS_LEN, "%s k=%d", params,
+				options->kValues[k]) < MAX_PARAMS_LEN;
+		if (isSuccess)
+			spBenchSamplesReport(samples, "kdtree_knn", kParams);
+		spBPQueueDestroy(queue);
+		spBenchSamplesDestroy(samples);
+	}
+	return isSuccess;
+}
+
+/*
+ * Times InitKDTree by every split method, and the searches of the tree of every method
+ */
+static bool benchKDTree(SPBenchData* data, SPBenchOptions* options, const char* params) {
+	char methodParams[MAX_PARAMS_LEN];
+	SPKDArray array = Init(data->points, data->size);
+	SPBenchSamples samples = NULL;
+	SPKDTreeNode tree = NULL;
+	bool isSuccess = array != NULL;
+	uint64_t start;
+	int method, rep;
+
+	for (method = 0; isSuccess && method < NUM_OF_SPLIT_METHODS; method++) {
+		isSuccess = snprintf(methodParams, MAX_PARAMS_LEN, "%s split=%s", params,
+				splitMethodNames[method]) < MAX_PARAMS_LEN &&
+				(samples = spBenchSamplesCreate(options->buildReps)) != NULL;
+		for (rep = 0; isSuccess && rep < options->buildReps; rep++) {
+			spKDTreeDestroy(tree, false);
+			start = spInstrumentationNow();
+			tree = InitKDTree(array, splitMethods[method]);
+			spBenchSamplesAdd(samples, spInstrumentationNow() - start, 1);
+			isSuccess = tree != NULL;
+		}
+
+		if (isSuccess) {
+			spBenchSamplesReport(samples, "kdtree_init", methodParams);
+			isSuccess = benchKNN(data, options, tree, methodParams);
+		}
+		spKDTreeDestroy(tree, false);
+		tree = NULL;
+		spBenchSamplesDestroy(samples);
+	}
+
+	if (array != NULL)
+		spKDArrayDestroy(array);
+	return isSuccess;
+}
+
+/*
+ * Times writeImageDataToFile and loadKnownImageData of the database descriptors, as
+ * images of featuresPerImage descriptors, one .feats file per image
+ */
+static bool benchFeats(SPBenchData* data, SPBenchOptions* options, const char* params) {
+	char path[MAX_PATH_LEN], featsParams[MAX_PARAMS_LEN];
+	int numOfImages = (data->size + options->featuresPerImage - 1) / options->featuresPerImage;
+	SPBenchSamples saveSamples = spBenchSamplesCreate(numOfImages);
+	SPBenchSamples loadSamples = spBenchSamplesCreate(numOfImages);
+	bool isSuccess = saveSamples != NULL && loadSamples != NULL;
+	sp_image_data image;
+	SPImageData loadedImage = NULL;
+	FILE* file = NULL;
+	uint64_t start;
+	int i;
+
+	for (i = 0; isSuccess && i < numOfImages; i++) {
+		image.index = i;
+		image.featuresArray = data->points + i * options->featuresPerImage;
+		image.numOfFeatures = i < numOfImages - 1 ? options->featuresPerImage :
+				data->size - i * options->featuresPerImage;
+		file = NULL;
+		isSuccess = snprintf(path, MAX_PATH_LEN, FEATS_FILE_FORMAT, options->tmpDir, i) <
+				MAX_PATH_LEN;
+
+		start = spInstrumentationNow();
+		isSuccess = isSuccess && (file = fopen(path, WRITE_MODE)) != NULL &&
+				writeImageDataToFile(file, &image, FEATS_SIGNATURE) == SP_DP_SUCCESS;
+		isSuccess = file != NULL && fclose(file) == 0 && isSuccess;
+		spBenchSamplesAdd(saveSamples, spInstrumentationNow() - start, 1);
+	}
+
+	for (i = 0; isSuccess && i < numOfImages; i++) {
+		isSuccess = snprintf(path, MAX_PATH_LEN, FEATS_FILE_FORMAT, options->tmpDir, i) <
+				MAX_PATH_LEN && (loadedImage = createImageData(i)) != NULL;
+
+		start = spInstrumentationNow();
+		isSuccess = isSuccess && loadKnownImageData(FEATS_SIGNATURE, path, loadedImage) ==
+				SP_DP_SUCCESS;
+		spBenchSamplesAdd(loadSamples, spInstrumentationNow() - start, 1);
+		if (isSuccess)
+			freeImageData(loadedImage, true, true);
+		else
+			free(loadedImage); // a failed load frees the features it read (or NULL)
+	}
+
+	isSuccess = isSuccess && snprintf(featsParams, MAX_PARAMS_LEN, "%s features_per_image=%d",
+			params, options->featuresPerImage) < MAX_PARAMS_LEN;
+	if (isSuccess) {
+		spBenchSamplesReport(saveSamples, "feats_save", featsParams);
+		spBenchSamplesReport(loadSamples, "feats_load", featsParams);
+	}
+
+	for (i = 0; i < numOfImages; i++) {
+		if (snprintf(path, MAX_PATH_LEN, FEATS_FILE_FORMAT, options->tmpDir, i) < MAX_PATH_LEN)
+			remove(path);
+	}
+	spBenchSamplesDestroy(saveSamples);
+	spBenchSamplesDestroy(loadSamples);
+	return isSuccess;
+}
+
+/*
+ * Runs all the benchmarks on a descriptors set
+ */
+static bool runBenchmarks(SPBenchData* data, SPBenchOptions* options) {
+	char params[MAX_PARAMS_LEN];
+	bool isSuccess;
+
+	isSuccess = snprintf(params, MAX_PARAMS_LEN, "data=%s n=%d dim=%d", data->name,
+			data->size, data->dim) < MAX_PARAMS_LEN &&
+			benchDistance(data, options, params) &&
+			benchKDArrayInit(data, options, params) &&
+			benchKDArraySplit(data, options, params) &&
+			benchKDTree(data, options, params) &&
+			benchFeats(data, options, params);
+	if (!isSuccess)
+		fprintf(stderr, BENCH_FAILED, data->name, params);
+	return isSuccess;
+}
+
+/*
+ * Loads the descriptors of the .feats files of the options into data, and times
+ * loadKnownImageData of every file. The signature and the image index of a file are
+ * taken from the file itself.
+ */
+static bool loadFeatsData(SPBenchData* data, SPBenchOptions* options) {
+	SPBenchSamples samples = spBenchSamplesCreate(options->numOfFeatsFiles);
+	SPImageData image = NULL;
+	SPPoint* points = NULL;
+	char *signature = NULL, *header = NULL;
+	FILE* file = NULL;
+	bool isSuccess = samples != NULL;
+	uint64_t start;
+	int i, j, index, totalSize = 0;
+
+	data->points = NULL;
+	for (i = 0; isSuccess && i < options->numOfFeatsFiles; i++) {
+		isSuccess = (file = fopen(options->featsFiles[i], READ_MODE)) != NULL &&
+				(signature = getLine(file)) != NULL && (header = getLine(file)) != NULL &&
+				sscanf(header, "%d", &index) == 1 && (image = createImageData(index)) != NULL;
+		if (file != NULL)
+			fclose(file);
+		free(header);
+		header = NULL;
+
+		if (isSuccess) {
+			start = spInstrumentationNow();
+			isSuccess = loadKnownImageData(signature, options->featsFiles[i], image) ==
+					SP_DP_SUCCESS;
+			spBenchSamplesAdd(samples, spInstrumentationNow() - start, 1);
+		}
+		free(signature);
+		signature = NULL;
+
+		if (isSuccess && (points = (SPPoint*) realloc(data->points,
+				(totalSize + image->numOfFeatures) * sizeof(SPPoint))) != NULL) {
+			data->points = points;
+			for (j = 0; j < image->numOfFeatures; j++)
+				data->points[totalSize++] = image->featuresArray[j];
+			freeImageData(image, true, false);
+		} else if (isSuccess) {
+			freeImageData(image, true, true);
+			isSuccess = false;
+		} else {
+			free(image); // a failed load frees the features it read
+		}
+		image = NULL;
+	}
+
+	if (!isSuccess)
+		spLoggerSafePrintError(ERROR_READING_FEATS, __FILE__, __FUNCTION__, __LINE__);
+	else if (totalSize > options->numOfQueries)
+		spBenchSamplesReport(samples, "feats_load", "data=files");
+	else
+		spLoggerSafePrintError(ERROR_TOO_FEW_FEATS, __FILE__, __FUNCTION__, __LINE__);
+	spBenchSamplesDestroy(samples);
+
+	data->name = FEATS_DATA_NAME;
+	data->numOfQueries = totalSize > options->numOfQueries ? options->numOfQueries : 0;
+	data->size = totalSize - data->numOfQueries;
+	data->dim = totalSize > 0 ? spPointGetDimension(data->points[0]) : 0;
+	return isSuccess && data->numOfQueries > 0;
+}
+
+int main(int argc, char* argv[]) {
+	SPBenchOptions options;
+	SPBenchData data;
+	bool isSuccess;
+	int dataSet;
+
+	if (!parseOptions(argc, argv, &options)) {
+		fprintf(stderr, BENCH_USAGE, argv[0]);
+		return BENCH_FAILURE_RET_VAL;
+	}
+	if (spLoggerCreate(options.logFile, SP_LOGGER_ERROR_LEVEL) != SP_LOGGER_SUCCESS)
+		return BENCH_FAILURE_RET_VAL;
+
+	srand(options.seed);
+	printf(BENCH_HEADER, options.seed, options.size, options.dim, options.numOfQueries,
+			options.numOfClusters, options.reps, options.buildReps, options.featuresPerImage);
+
+	// the queue does not depend on the descriptors
+	isSuccess = benchEnqueue(&options, "data=" RANDOM_DATA_NAME);
+
+	// uniform and clustered synthetic descriptors
+	for (dataSet = 0; isSuccess && dataSet < 2; dataSet++) {
+		data.name = dataSet == 0 ? UNIFORM_DATA_NAME : CLUSTERED_DATA_NAME;
+		data.size = options.size;
+		data.numOfQueries = options.numOfQueries;
+		data.dim = options.dim;
+		srand(options.seed + dataSet); // the RANDOM split method reseeds rand()
+		data.points = spBenchGenerateClustered(data.size + data.numOfQueries, data.dim,
+				dataSet == 0 ? 0 : options.numOfClusters, CLUSTERS_DEVIATION,
+				(data.size + options.featuresPerImage - 1) / options.featuresPerImage);
+		isSuccess = data.points != NULL && runBenchmarks(&data, &options);
+		spBenchDestroyPoints(data.points, data.size + data.numOfQueries);
+		if (data.points == NULL)
+			spLoggerSafePrintError(ERROR_BENCHMARK_DATA, __FILE__, __FUNCTION__, __LINE__);
+	}
+
+	// real descriptors
+	if (isSuccess && options.numOfFeatsFiles > 0) {
+		isSuccess = loadFeatsData(&data, &options) && runBenchmarks(&data, &options);
+		spBenchDestroyPoints(data.points, data.size + data.numOfQueries);
+	}
+
+	printf(BENCH_FOOTER, spBenchGetPeakRSS());
+	spLoggerDestroy();
+	return isSuccess ? 0 : BENCH_FAILURE_RET_VAL;
+}
@@ -0,0 +1,572 @@
+/* ------------------------------------------------------------README-----------------------------------------------------------------
+Please read the following regarding the evaluation:
+
+* In order to run the evaluation run 'evaluation_makefile' (make -f evaluation_makefile) and then
+  './SPCBIR_EVALUATION [options] database.config [index.config ...]', see EVAL_USAGE below for the options.
+
+* The first configuration file defines the database (its .feats files are loaded, so spExtractionMode is ignored),
+  spKNN (k) and spNumOfSimilarImages (N). Every configuration file (including the first) is then evaluated:
+  its index is built over the database and searched by the query images. All the configuration files must
+  have the same database, k and N, and may differ in the index settings (spIndexType, the PQ/IVF/HNSW/BoVW
+  settings, spDescriptorPrecision and so on).
+
+* The query images are .feats files given by -q, or the database images themselves if none is given.
+
+* The exact results (see SPGroundTruth.h) are computed by a brute force scan once, and cached in the -g file,
+  they are computed again only if the database, the queries, k or N changed.
+
+* The results are written to stdout, as the report lines of SPBenchmarkUtils.h:
+  - bench=evaluation_knn - the latency of a single descriptor search, and recall_at_k, the fraction of the
+    images of the exact k nearest descriptors that were found (as multisets, since the indices return the
+    image of every neighbour rather than the descriptor itself). Not written for image level indices.
+  - bench=evaluation_query - the latency of a whole query image (getSimilarImages), and precision_at_n, the
+    fraction of the exact N most similar images that were found.
+  Errors are written to the logger (stdout unless -l is given).
+
+* If you are working with an IDE, you should exclude the '/benchmarks' directory from the project build, since this
+  file has its own main function.
+ -----------------------------------------------------------------------------------------------------------------------------------*/
+
+#define _POSIX_C_SOURCE 200809L // getopt and sysconf under -std=c99
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "SPBenchmarkUtils.h"
+#include "SPGroundTruth.h"
+#include "../SPPoint.h"
+#include "../SPConfig.h"
+#include "../SPLogger.h"
+#include "../data_structures/bpqueue_ds/SPBPriorityQueue.h"
+#include "../data_structures/index_ds/SPSearchIndex.h"
+#include "../image_parsing/SPImagesParser.h"
+#include "../image_parsing/SPImageData.h"
+#include "../main_and_ui/SPImageQuery.h"
+#include "../main_and_ui/SPMainAux.h"
+#include "../general_utils/SPInstrumentation.h"
+#include "../general_utils/SPUtils.h"
+
+#define EVAL_FAILURE_RET_VAL			-1
+#define EVAL_OPTIONS					"q:g:t:l:"
+#define EVAL_USAGE						"Usage: %s [-q query.feats ...] [-g ground_truth_file] [-t threads] " \
+										"[-l log_file] database.config [index.config ...]\n"
+#define EVAL_HEADER						"# spcbir evaluation database=%s images=%d descriptors=%d queries=%d " \
+										"k=%d n=%d ground_truth=%s ground_truth_ms=%.1f\n"
+#define EVAL_FOOTER						"# peak_rss_kb=%ld\n"
+#define EVAL_FAILED						"bench=evaluation config=%s failed\n"
+#define KNN_PARAMS						"config=%s index=%s shards=%d k=%d recall_at_k=%.4f"
+#define QUERY_PARAMS					"config=%s index=%s shards=%d n=%d build_ms=%.1f recall_at_k=%s " \
+										"precision_at_n=%.4f"
+#define RECALL_FORMAT					"%.4f"
+#define NO_RECALL						"na"
+
+#define DEFAULT_GROUND_TRUTH_FILE		"./benchmarks/spcbir.gt"
+#define GROUND_TRUTH_KEY_HEADER			"# spcbir ground truth\n"
+#define GROUND_TRUTH_KEY_SIZES			"k=%d n=%d queries=%d\n"
+#define GROUND_TRUTH_KEY_QUERY			"%s\n"
+#define DATABASE_QUERIES				"database"
+#define GROUND_TRUTH_LOADED				"loaded"
+#define GROUND_TRUTH_COMPUTED			"computed"
+#define NO_NEIGHBOUR					-1
+#define MAX_PARAMS_LEN					(MAX_PATH_LEN + 256)
+#define MAX_SIZES_LEN					64
+#define READ_MODE						"r"
+#define NSEC_PER_MSEC					1000000.0
+
+#define ERROR_LOADING_DATABASE			"Could not load the database of the first configuration file"
+#define ERROR_LOADING_QUERY				"Could not load a query .feats file"
+#define ERROR_OTHER_DATABASE			"The configuration file has another database, spKNN or spNumOfSimilarImages than the first one"
+#define ERROR_EVALUATING_CONFIG			"Could not evaluate the configuration file"
+
+static const char* indexTypeNames[] = { "KD_TREE", "PQ", "IVF", "HNSW", "BOVW", "BRUTE" };
+
+/** The command line options of the evaluation **/
+typedef struct sp_eval_options_t {
+	char** queryFiles;
+	int numOfQueryFiles;
+	const char* groundTruthFile;
+	int numOfThreads; // of the ground truth scan
+	const char* logFile;
+	char** configFiles;
+	int numOfConfigFiles;
+} SPEvalOptions;
+
+/** The database, the queries and their exact results **/
+typedef struct sp_eval_data_t {
+	char* signature; // of the database
+	int numOfImages;
+	int knn;
+	int numOfSimilarImages;
+	SPImageData* images; // the database images
+	SPPoint* points; // the features of all the images (shared with images)
+	int size;
+	SPImageData* queries;
+	int numOfQueries;
+	bool isQueriesOwned; // false if the queries are the database images
+	SPGroundTruth groundTruth;
+} SPEvalData;
+
+/*
+ * Fills options by the command line arguments
+ */
+static bool parseOptions(int argc, char* argv[], SPEvalOptions* options) {
+	char* end = NULL;
+	long threads = sysconf(_SC_NPROCESSORS_ONLN);
+	int option;
+
+	options->queryFiles = NULL;
+	options->numOfQueryFiles = 0;
+	options->groundTruthFile = DEFAULT_GROUND_TRUTH_FILE;
+	options->numOfThreads = threads > 0 ? (int) threads : 1;
+	options->logFile = NULL;
+
+	// a query file is kept as a pointer into argv
+	if ((options->queryFiles = (char**) calloc(argc, sizeof(char*))) == NULL)
+		return false;
+
+	while ((option = getopt(argc, argv, EVAL_OPTIONS)) != -1) {
+		switch (option) {
+		case 'q':
+			options->queryFiles[options->numOfQueryFiles++] = optarg;
+			break;
+		case 'g':
+			options->groundTruthFile = optarg;
+			break;
+		case 't':
+			threads = strtol(optarg, &end, 10);
+			if (end == optarg || *end != '\0' || threads <= 0 || threads > 1024)
+				return false;
+			options->numOfThreads = (int) threads;
+			break;
+		case 'l':
+			options->logFile = optarg;
+			break;
+		default:
+			return false;
+		}
+	}
+
+	options->configFiles = argv + optind;
+	options->numOfConfigFiles = argc - optind;
+	return options->numOfConfigFiles > 0;
+}
+
+/*
+ * Loads a query .feats file, its signature and image index are read from the file itself
+ *
+ * @return NULL if the file could not be loaded, otherwise the query image
+ */
+static SPImageData loadQuery(char* filename) {
+	SPImageData image = NULL;
+	char *signature = NULL, *header = NULL;
+	FILE* file = NULL;
+	bool isSuccess;
+	int index;
+
+	isSuccess = (file = fopen(filename, READ_MODE)) != NULL &&
+			(signature = getLine(file)) != NULL && (header = getLine(file)) != NULL &&
+			sscanf(header, "%d", &index) == 1 && (image = createImageData(index)) != NULL;
+	if (file != NULL)
+		fclose(file);
+	free(header);
+
+	if (isSuccess && loadKnownImageData(signature, filename, image) != SP_DP_SUCCESS) {
+		free(image); // a failed load frees the features it read
+		image = NULL;
+	}
+	free(signature);
+
+	spValRn(image != NULL, ERROR_LOADING_QUERY);
+	return image;
+}
+
+/*
+ * Loads the database of the first configuration file and the query images
+ */
+static bool loadData(SPEvalData* data, SPEvalOptions* options, SPConfig config) {
+	SP_CONFIG_MSG msg = SP_CONFIG_SUCCESS;
+	int i;
+
+	data->numOfImages = spConfigGetNumOfImages(config, &msg);
+	data->knn = spConfigGetKNN(config, &msg);
+	data->numOfSimilarImages = spConfigGetNumOfSimilarImages(config, &msg);
+	spVal(msg == SP_CONFIG_SUCCESS && data->numOfSimilarImages <= data->numOfImages,
+			ERROR_LOADING_DATABASE, false);
+
+	// the exact results are of the stored descriptors, at double precision
+	spPointSetDefaultPrecision(SP_POINT_PRECISION_DOUBLE);
+	spVal((data->signature = getSignature(config)) != NULL &&
+			(data->images = initializeImagesDataList(data->numOfImages)) != NULL &&
+			loadAllImagesData(config, data->signature, data->images) == SP_DP_SUCCESS,
+			ERROR_LOADING_DATABASE, false);
+	data->size = calculateTotalNumOfFeatures(data->images, data->numOfImages);
+	spVal(data->size > 0 && (data->points = initializeAllFeaturesArray(data->images,
+			data->numOfImages, data->size)) != NULL, ERROR_LOADING_DATABASE, false);
+
+	if (options->numOfQueryFiles == 0) {
+		data->queries = data->images;
+		data->numOfQueries = data->numOfImages;
+		return true;
+	}
+
+	data->isQueriesOwned = true;
+	spCallocWr(data->queries, SPImageData, options->numOfQueryFiles, false);
+	for (i = 0; i < options->numOfQueryFiles; i++) {
+		if ((data->queries[i] = loadQuery(options->queryFiles[i])) == NULL)
+			return false;
+		data->numOfQueries++;
+	}
+	return true;
+}
+
+/*
+ * Frees all the resources of the data
+ */
+static void destroyData(SPEvalData* data) {
+	if (data->isQueriesOwned && data->queries != NULL)
+		freeAllImagesData(data->queries, data->numOfQueries, true);
+	if (data->images != NULL)
+		freeAllImagesData(data->images, data->numOfImages, true);
+	free(data->points);
+	free(data->signature);
+	spGroundTruthDestroy(data->groundTruth);
+}
+
+/*
+ * Returns the cache key of the ground truth of the data, or NULL in case of memory
+ * allocation error. The key has the database signature, k, N and the query files.
+ */
+static char* createGroundTruthKey(SPEvalData* data, SPEvalOptions* options) {
+	char* key = NULL;
+	size_t length;
+	int i;
+
+	length = strlen(GROUND_TRUTH_KEY_HEADER) + strlen(data->signature) + MAX_SIZES_LEN +
+			strlen(DATABASE_QUERIES) + 2;
+	for (i = 0; i < options->numOfQueryFiles; i++)
+		length += strlen(options->queryFiles[i]) + 1;
+	spCalloc(key, char, length);
+
+	strcpy(key, GROUND_TRUTH_KEY_HEADER);
+	strcat(key, data->signature);
+	sprintf(key + strlen(key), GROUND_TRUTH_KEY_SIZES, data->knn, data->numOfSimilarImages,
+			data->numOfQueries);
+	if (options->numOfQueryFiles == 0)
+		sprintf(key + strlen(key), GROUND_TRUTH_KEY_QUERY, DATABASE_QUERIES);
+	for (i = 0; i < options->numOfQueryFiles; i++)
+		sprintf(key + strlen(key), GROUND_TRUTH_KEY_QUERY, options->queryFiles[i]);
+	return key;
+}
+
+/*
+ * Returns true iff the ground truth is of the data (a cache file may have been edited)
+ */
+static bool isGroundTruthOfData(SPGroundTruth groundTruth, SPEvalData* data) {
+	int i;
+	if (groundTruth->numOfQueries != data->numOfQueries || groundTruth->knn != data->knn ||
+			groundTruth->numOfSimilarImages != data->numOfSimilarImages)
+		return false;
+	for (i = 0; i < data->numOfQueries; i++) {
+		if (groundTruth->numOfFeatures[i] != data->queries[i]->numOfFeatures)
+			return false;
+	}
+	return true;
+}
+
+/*
+ * Loads the ground truth of the data from the cache file, or computes it and writes it to
+ * the cache file
+ */
+static bool initGroundTruth(SPEvalData* data, SPEvalOptions* options, const char* databaseFile) {
+	char* key = NULL;
+	uint64_t start = spInstrumentationNow();
+	bool isLoaded = false;
+
+	if ((key = createGroundTruthKey(data, options)) == NULL)
+		return false;
+
+	data->groundTruth = spGroundTruthLoad(options->groundTruthFile, key);
+	if (data->groundTruth != NULL && !isGroundTruthOfData(data->groundTruth, data)) {
+		spGroundTruthDestroy(data->groundTruth);
+		data->groundTruth = NULL;
+	}
+
+	isLoaded = data->groundTruth != NULL;
+	if (!isLoaded && (data->groundTruth = spGroundTruthCreate(data->points, data->size,
+			data->numOfImages, data->queries, data->numOfQueries, data->knn,
+			data->numOfSimilarImages, options->numOfThreads)) != NULL)
+		spGroundTruthSave(data->groundTruth, options->groundTruthFile, key); // best effort
+	free(key);
+
+	if (data->groundTruth != NULL)
+		printf(EVAL_HEADER, databaseFile, data->numOfImages, data->size, data->numOfQueries,
+				data->knn, data->numOfSimilarImages,
+				isLoaded ? GROUND_TRUTH_LOADED : GROUND_TRUTH_COMPUTED,
+				(spInstrumentationNow() - start) / NSEC_PER_MSEC);
+	return data->groundTruth != NULL;
+}
+
+/*
+ * Returns a copy of the given features at the given storage precision, or NULL in case of
+ * memory allocation error
+ */
+static SPPoint* copyFeatures(SPPoint* features, int size, SP_POINT_PRECISION precision) {
+	SPPoint* ret = NULL;
+	double* data = NULL;
+	int i, j, dim;
+
+	spCallocEr(ret, SPPoint, size + 1, ERROR_EVALUATING_CONFIG, NULL);
+	for (i = 0; i < size; i++) {
+		dim = spPointGetDimension(features[i]);
+		spValWcRn((data = (double*) malloc(dim * sizeof(double))) != NULL,
+				ERROR_EVALUATING_CONFIG, freeFeatures(ret, i); free(ret));
+		for (j = 0; j < dim; j++)
+			data[j] = spPointGetAxisCoor(features[i], j);
+		ret[i] = spPointCreateWithPrecision(data, dim, spPointGetIndex(features[i]), precision);
+		free(data);
+		spValWcRn(ret[i] != NULL, ERROR_EVALUATING_CONFIG, freeFeatures(ret, i); free(ret));
+	}
+	return ret;
+}
+
+/*
+ * Returns copies of the query images at the given storage precision (as main stores the
+ * query features at the configured precision), or NULL in case of memory allocation error
+ */
+static SPImageData* copyQueries(SPEvalData* data, SP_POINT_PRECISION precision) {
+	SPImageData* ret = NULL;
+	int i;
+
+	spCallocEr(ret, SPImageData, data->numOfQueries, ERROR_EVALUATING_CONFIG, NULL);
+	for (i = 0; i < data->numOfQueries; i++) {
+		spValWcRn((ret[i] = createImageData(data->queries[i]->index)) != NULL &&
+				(ret[i]->featuresArray = copyFeatures(data->queries[i]->featuresArray,
+						data->queries[i]->numOfFeatures, precision)) != NULL,
+				ERROR_EVALUATING_CONFIG, freeAllImagesData(ret, i + (ret[i] != NULL), true));
+		ret[i]->numOfFeatures = data->queries[i]->numOfFeatures;
+	}
+	return ret;
+}
+
+/*
+ * Searches the nearest descriptors of every query descriptor, adds the latencies to samples
+ * and returns the recall at k, or -1 in case of a search error
+ */
+static double evaluateKNN(SPSearchIndex index, SPEvalData* data, SPImageData* queries,
+		SPBenchSamples samples) {
+	SPGroundTruth groundTruth = data->groundTruth;
+	SPBPQueue bpq = NULL;
+	int *found = NULL, *exact, q, i, j, matches, totalMatches = 0, totalExact = 0;
+	int knn = data->knn;
+	uint64_t start;
+	bool isSuccess;
+
+	isSuccess = (bpq = spBPQueueCreate(knn)) != NULL &&
+			(found = (int*) malloc(knn * sizeof(int))) != NULL;
+	for (q = 0; isSuccess && q < data->numOfQueries; q++) {
+		for (i = 0; isSuccess && i < queries[q]->numOfFeatures; i++) {
+			spBPQueueClear(bpq);
+			start = spInstrumentationNow();
+			isSuccess = spSearchIndexKNN(index, bpq, queries[q]->featuresArray[i]);
+			spBenchSamplesAdd(samples, spInstrumentationNow() - start, 1);
+
+			for (j = 0; j < knn; j++) {
+				found[j] = NO_NEIGHBOUR;
+				if (!spBPQueueIsEmpty(bpq)) {
+					found[j] = spBPQueueMinIndex(bpq);
+					spBPQueueDequeue(bpq);
+				}
+			}
+
+			exact = groundTruth->neighbours[q] + i * knn;
+			matches = spGroundTruthCountMatches(exact, found, knn);
+			isSuccess = isSuccess && matches >= 0;
+			totalMatches += matches;
+			for (j = 0; j < knn; j++)
+				totalExact += exact[j] != NO_NEIGHBOUR;
+		}
+	}
+
+	free(found);
+	spBPQueueDestroy(bpq);
+	if (!isSuccess)
+		return -1.0;
+	return totalExact > 0 ? (double) totalMatches / totalExact : 1.0;
+}
+
+/*
+ * Ranks the similar images of every query image, adds the latencies to samples and returns
+ * the precision at N, or -1 in case of a search error
+ */
+static double evaluateQueries(SPSearchIndex index, SPEvalData* data, SPImageData* queries,
+		SPBenchSamples samples) {
+	SPQueryContext context = NULL;
+	int *similarImages = NULL, q, matches, totalMatches = 0;
+	uint64_t start;
+	bool isSuccess;
+
+	isSuccess = (context = createQueryContext(data->knn, data->numOfImages)) != NULL;
+	for (q = 0; isSuccess && q < data->numOfQueries; q++) {
+		start = spInstrumentationNow();
+		similarImages = searchSimilarImages(queries[q], index, data->numOfImages,
+				data->numOfSimilarImages, context, SP_SEARCH_INDEX_NO_DEADLINE, NULL);
+		spBenchSamplesAdd(samples, spInstrumentationNow() - start, 1);
+
+		matches = similarImages == NULL ? -1 : spGroundTruthCountMatches(
+				data->groundTruth->rankings[q], similarImages, data->numOfSimilarImages);
+		isSuccess = matches >= 0;
+		totalMatches += matches;
+		free(similarImages);
+	}
+
+	destroyQueryContext(context);
+	if (!isSuccess)
+		return -1.0;
+	return (double) totalMatches / ((double) data->numOfSimilarImages * data->numOfQueries);
+}
+
+/*
+ * Returns true iff the configuration has the database, k and N of the data
+ */
+static bool isConfigOfData(SPConfig config, SPEvalData* data) {
+	SP_CONFIG_MSG msg = SP_CONFIG_SUCCESS;
+	char* signature = getSignature(config);
+	bool ret = signature != NULL && strcmp(signature, data->signature) == 0 &&
+			spConfigGetKNN(config, &msg) == data->knn &&
+			spConfigGetNumOfSimilarImages(config, &msg) == data->numOfSimilarImages &&
+			msg == SP_CONFIG_SUCCESS;
+	free(signature);
+	return ret;
+}
+
+/*
+ * Builds the index of the configuration over the database
+ *
+ * @return NULL in case of a configuration error or a build error, otherwise the index
+ */
+static SPSearchIndex buildIndex(SPConfig config, SPEvalData* data,
+		SP_POINT_PRECISION precision, double* buildTime) {
+	SPSearchIndex index = NULL;
+	SPPoint* points = NULL;
+	uint64_t start;
+
+	// the index takes ownership of the copies of the database features
+	if ((points = copyFeatures(data->points, data->size, precision)) == NULL)
+		return NULL;
+	start = spInstrumentationNow();
+	index = spSearchIndexCreate(config, points, data->size);
+	*buildTime = (spInstrumentationNow() - start) / NSEC_PER_MSEC;
+	if (index == NULL)
+		freeFeatures(points, data->size);
+	free(points);
+	return index;
+}
+
+/*
+ * Builds the index of the configuration over the database, searches it by the queries and
+ * writes the report lines
+ */
+static bool evaluateConfig(const char* configFile, SPEvalData* data) {
+	SP_CONFIG_MSG msg = SP_CONFIG_SUCCESS;
+	SPConfig config = NULL;
+	SPSearchIndex index = NULL;
+	SPImageData* queries = NULL;
+	SPBenchSamples knnSamples = NULL, querySamples = NULL;
+	SP_POINT_PRECISION precision = SP_POINT_PRECISION_DOUBLE;
+	SP_SEARCH_INDEX_TYPE indexType = SP_INDEX_KD_TREE;
+	char params[MAX_PARAMS_LEN], recall[MAX_SIZES_LEN];
+	double buildTime = 0.0, recallAtK = -1.0, precisionAtN = -1.0;
+	int i, numOfShards = 1, totalQueryFeatures = 0;
+	bool isSuccess, isImageLevel = false;
+
+	isSuccess = (config = spConfigCreate(configFile, &msg)) != NULL &&
+			isConfigOfData(config, data);
+	if (isSuccess) {
+		precision = spConfigGetDescriptorPrecision(config, &msg);
+		indexType = spConfigGetIndexType(config, &msg);
+		numOfShards = spConfigGetNumOfShards(config, &msg);
+		isSuccess = msg == SP_CONFIG_SUCCESS;
+	} else if (config != NULL) {
+		spLoggerSafePrintError(ERROR_OTHER_DATABASE, __FILE__, __FUNCTION__, __LINE__);
+	}
+
+	for (i = 0; i < data->numOfQueries; i++)
+		totalQueryFeatures += data->queries[i]->numOfFeatures;
+	isSuccess = isSuccess && (index = buildIndex(config, data, precision, &buildTime)) != NULL &&
+			(queries = copyQueries(data, precision)) != NULL &&
+			(knnSamples = spBenchSamplesCreate(totalQueryFeatures + 1)) != NULL &&
+			(querySamples = spBenchSamplesCreate(data->numOfQueries)) != NULL;
+
+	// an image level index ranks whole images and has no nearest descriptors
+	if (isSuccess && !(isImageLevel = spSearchIndexIsImageLevel(index))) {
+		recallAtK = evaluateKNN(index, data, queries, knnSamples);
+		isSuccess = recallAtK >= 0.0 && snprintf(params, MAX_PARAMS_LEN, KNN_PARAMS,
+				configFile, indexTypeNames[indexType], numOfShards, data->knn, recallAtK) <
+				MAX_PARAMS_LEN;
+		if (isSuccess)
+			spBenchSamplesReport(knnSamples, "evaluation_knn", params);
+	}
+
+	if (isSuccess) {
+		precisionAtN = evaluateQueries(index, data, queries, querySamples);
+		if (isImageLevel)
+			strcpy(recall, NO_RECALL);
+		else
+			snprintf(recall, MAX_SIZES_LEN, RECALL_FORMAT, recallAtK);
+		isSuccess = precisionAtN >= 0.0 && snprintf(params, MAX_PARAMS_LEN, QUERY_PARAMS,
+				configFile, indexTypeNames[indexType], numOfShards, data->numOfSimilarImages,
+				buildTime, recall, precisionAtN) < MAX_PARAMS_LEN;
+		if (isSuccess)
+			spBenchSamplesReport(querySamples, "evaluation_query", params);
+	}
+
+	if (!isSuccess) {
+		spLoggerSafePrintError(ERROR_EVALUATING_CONFIG, __FILE__, __FUNCTION__, __LINE__);
+		printf(EVAL_FAILED, configFile);
+	}
+	spBenchSamplesDestroy(knnSamples);
+	spBenchSamplesDestroy(querySamples);
+	if (queries != NULL)
+		freeAllImagesData(queries, data->numOfQueries, true);
+	spSearchIndexDestroy(index);
+	spConfigDestroy(config);
+	return isSuccess;
+}
+
+int main(int argc, char* argv[]) {
+	SP_CONFIG_MSG msg = SP_CONFIG_SUCCESS;
+	SPEvalOptions options;
+	SPEvalData data;
+	SPConfig config = NULL;
+	bool isSuccess, isLoaded;
+	int i;
+
+	memset(&data, 0, sizeof(data));
+	if (!parseOptions(argc, argv, &options)) {
+		fprintf(stderr, EVAL_USAGE, argv[0]);
+		free(options.queryFiles);
+		return EVAL_FAILURE_RET_VAL;
+	}
+	if (spLoggerCreate(options.logFile, SP_LOGGER_ERROR_LEVEL) != SP_LOGGER_SUCCESS) {
+		free(options.queryFiles);
+		return EVAL_FAILURE_RET_VAL;
+	}
+
+	isLoaded = (config = spConfigCreate(options.configFiles[0], &msg)) != NULL &&
+			loadData(&data, &options, config) &&
+			initGroundTruth(&data, &options, options.configFiles[0]);
+	spConfigDestroy(config);
+
+	// a configuration that fails does not stop the evaluation of the others
+	isSuccess = isLoaded;
+	for (i = 0; isLoaded && i < options.numOfConfigFiles; i++)
+		isSuccess = evaluateConfig(options.configFiles[i], &data) && isSuccess;
+
+	printf(EVAL_FOOTER, spBenchGetPeakRSS());
+	destroyData(&data);
+	free(options.queryFiles);
+	spLoggerDestroy();
+	return isSuccess ? 0 : EVAL_FAILURE_RET_VAL;
+}
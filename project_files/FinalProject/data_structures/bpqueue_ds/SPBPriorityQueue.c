@@ -3,22 +3,35 @@
 #include <stdlib.h>
 #include <assert.h>
 #include "../../general_utils/SPUtils.h"
+#include "../../general_utils/SPInstrumentation.h"
 
 #define DEFAULT_INVALID_NUMBER -1
 
 /*
  * A structure used in order to handle the queue data type
- * maxElement - a list element representing the maximum element in the queue
+ * maxElement - a list element representing the maximum element in the queue (its value
+ * 				is meaningless while the queue is empty)
  * capacity - an integer representing a size limit for the queue
  * queue - a list used to store the queue items
+ * newElement - a list element used by spBPQueueEnqueueValues to hold the new item
+ *
+ * Both elements are allocated once with the queue and are updated in place, so an
+ * enqueue of a queue that has reached its largest size allocates no memory.
  */
 typedef struct sp_bp_queue_t {
 	SPListElement maxElement;
 	int capacity;
 	SPList queue;
+	SPListElement newElement;
 } sp_bp_queue_t;
 
-
+/*
+ * Sets the maximum element of the queue to the index and value of the given element
+ */
+static void setMaxElement(SPBPQueue source, SPListElement element) {
+	spListElementSetIndex(source->maxElement, spListElementGetIndex(element));
+	spListElementSetValue(source->maxElement, spListElementGetValue(element));
+}
 
 SPBPQueue spBPQueueCreateWrapper(int maxSize, SPBPQueue source_queue, bool createNewList) {
 	SPBPQueue newQueue;
@@ -31,16 +44,20 @@ SPBPQueue spBPQueueCreateWrapper(int maxSize, SPBPQueue source_queue, bool creat
 
 	if (createNewList) {
 		newQueue->queue = spListCreate();
-		newQueue->maxElement = NULL;
+		newQueue->maxElement = spListElementCreate(0, 0.0);
 	}
-	else {
+	else if (source_queue != NULL) {
 		newQueue->queue = spListCopy(source_queue->queue);
 		newQueue->maxElement = spListElementCopy(source_queue->maxElement);
 	}
+	newQueue->newElement = spListElementCreate(0, 0.0);
 
 	//allocation error, or given source queue is NULL and createNewList if false
-	if (newQueue->queue == NULL)
+	if (newQueue->queue == NULL || newQueue->maxElement == NULL ||
+			newQueue->newElement == NULL) {
+		spBPQueueDestroy(newQueue);
 		return NULL;
+	}
 
 	return newQueue;
 }
@@ -63,19 +80,15 @@ void spBPQueueDestroy(SPBPQueue source) {
 			spListDestroy(source->queue);
 		spListElementDestroy(source->maxElement);
 		source->maxElement = NULL;
+		spListElementDestroy(source->newElement);
 		free(source);
 		source = NULL;
 	}
 }
 
 void spBPQueueClear(SPBPQueue source) {
-	if (source != NULL && source->queue != NULL) {
+	if (source != NULL && source->queue != NULL)
 		spListClear(source->queue);
-		if (source->maxElement) {
-			spListElementDestroy(source->maxElement);
-			source->maxElement = NULL;
-		}
-	}
 }
 
 int spBPQueueSize(SPBPQueue source) {
@@ -96,10 +109,7 @@ SP_BPQUEUE_MSG spBPQueueInsertIfEmpty(SPBPQueue source, SPListElement newElement
 	if (retVal == SP_LIST_OUT_OF_MEMORY)
 		return SP_BPQUEUE_OUT_OF_MEMORY;
 
-	source->maxElement = spListElementCopy(newElement);
-
-	if (source->maxElement == NULL)
-		return SP_BPQUEUE_OUT_OF_MEMORY;
+	setMaxElement(source, newElement);
 
 	return SP_BPQUEUE_SUCCESS;
 }
@@ -120,10 +130,7 @@ SP_BPQUEUE_MSG spBPQueueHandleFullCapacity(SPBPQueue source) {
 	// because we assume spBPQueueSize is valid
 	spListRemoveCurrent(source->queue);
 
-	spListElementDestroy(source->maxElement);
-	source->maxElement = spListElementCopy(prevElemInQueue);
-	if (source->maxElement == NULL)
-		return SP_BPQUEUE_OUT_OF_MEMORY;
+	setMaxElement(source, prevElemInQueue);
 
 	return SP_BPQUEUE_SUCCESS;
 
@@ -154,11 +161,7 @@ SP_BPQUEUE_MSG spBPQueueInsertNotEmptyButLast(SPBPQueue source, SPListElement el
 	if (retVal == SP_LIST_OUT_OF_MEMORY)
 		return SP_BPQUEUE_OUT_OF_MEMORY;
 
-	spListElementDestroy(source->maxElement);
-	source->maxElement = spListElementCopy(element);
-
-	if (source->maxElement == NULL)
-		return SP_BPQUEUE_OUT_OF_MEMORY;
+	setMaxElement(source, element);
 
 	return SP_BPQUEUE_SUCCESS;
 }
@@ -185,14 +188,18 @@ SP_BPQUEUE_MSG spBPQueueEnqueue(SPBPQueue source, SPListElement element) {
 	spMinimalVerifyArguments(source != NULL && source->queue != NULL && element != NULL,
 			SP_BPQUEUE_INVALID_ARGUMENT);
 
-	if (spBPQueueGetMaxSize(source) == 0)
+	if (spBPQueueGetMaxSize(source) == 0) {
+		spInstrCount(SP_INSTR_QUEUE_REJECTIONS);
 		return SP_BPQUEUE_FULL;
+	}
 
 
 	// the list is full and the element is greater than all the current items
 	if (spBPQueueIsFull(source) && spListElementCompare(element, source->maxElement) >= 0) {
+		spInstrCount(SP_INSTR_QUEUE_REJECTIONS);
 		return SP_BPQUEUE_FULL;
 	}
+	spInstrCount(SP_INSTR_QUEUE_INSERTS);
 
 	if (spBPQueueIsEmpty(source))
 		return spBPQueueInsertIfEmpty(source,element);
@@ -201,6 +208,27 @@ SP_BPQUEUE_MSG spBPQueueEnqueue(SPBPQueue source, SPListElement element) {
 	return spBPQueueInsertNotEmpty(source, element);
 }
 
+SP_BPQUEUE_MSG spBPQueueEnqueueValues(SPBPQueue source, int index, double value) {
+	double maxValue;
+	spMinimalVerifyArguments(source != NULL && source->queue != NULL && index >= 0 &&
+			value >= 0.0, SP_BPQUEUE_INVALID_ARGUMENT);
+
+	// same order as spListElementCompare - by value and then by index
+	if (spBPQueueIsFull(source)) {
+		maxValue = spListElementGetValue(source->maxElement);
+		if (value > maxValue ||
+				(value == maxValue && index >= spListElementGetIndex(source->maxElement))) {
+			spInstrCount(SP_INSTR_QUEUE_REJECTIONS);
+			return SP_BPQUEUE_FULL;
+		}
+	}
+
+	// the queue element is updated instead of creating a new one
+	spListElementSetIndex(source->newElement, index);
+	spListElementSetValue(source->newElement, value);
+	return spBPQueueEnqueue(source, source->newElement);
+}
+
 SP_BPQUEUE_MSG spBPQueueDequeue(SPBPQueue source) {
 	SPListElement first;
 	SP_LIST_MSG actionStatus;
@@ -214,12 +242,6 @@ SP_BPQUEUE_MSG spBPQueueDequeue(SPBPQueue source) {
 	if (first == NULL)
 		return SP_BPQUEUE_EMPTY;
 
-	// if we have 1 items -> last is first -> we should free its pointer
-	if (spBPQueueSize(source) == 1) {
-		spListElementDestroy(source->maxElement);
-		source->maxElement = NULL;
-	}
-
 	actionStatus = spListRemoveCurrent(source->queue);
 
 	if (actionStatus != SP_LIST_SUCCESS)
@@ -239,6 +261,8 @@ SPListElement spBPQueuePeek(SPBPQueue source) {
 
 SPListElement spBPQueuePeekLast(SPBPQueue source) {
 	spMinimalVerifyArgumentsRn(source != NULL);
+	if (spBPQueueIsEmpty(source))
+		return NULL;
 	return spListElementCopy(source->maxElement);
 }
 
@@ -255,12 +279,27 @@ double returnValueFrom(SPBPQueue source, SPListElement (*func)(SPBPQueue)) {
 	return returnValue;
 }
 
+// the extreme items are read in place, these are called for every step of a search
+
 double spBPQueueMinValue(SPBPQueue source) {
-	return returnValueFrom(source, &spBPQueuePeek);
+	spMinimalVerifyArguments(source != NULL, DEFAULT_INVALID_NUMBER);
+	if (spBPQueueIsEmpty(source))
+		return DEFAULT_INVALID_NUMBER;
+	return spListElementGetValue(spListGetFirst(source->queue));
+}
+
+int spBPQueueMinIndex(SPBPQueue source) {
+	spMinimalVerifyArguments(source != NULL, DEFAULT_INVALID_NUMBER);
+	if (spBPQueueIsEmpty(source))
+		return DEFAULT_INVALID_NUMBER;
+	return spListElementGetIndex(spListGetFirst(source->queue));
 }
 
 double spBPQueueMaxValue(SPBPQueue source) {
-	return returnValueFrom(source, &spBPQueuePeekLast);
+	spMinimalVerifyArguments(source != NULL, DEFAULT_INVALID_NUMBER);
+	if (spBPQueueIsEmpty(source))
+		return DEFAULT_INVALID_NUMBER;
+	return spListElementGetValue(source->maxElement);
 }
 
 bool spBPQueueIsEmpty(SPBPQueue source) {
@@ -11,8 +11,8 @@
  * the invariant of - the list is ordered (first item is smallest)
  * The queue supports storing similar items, and as the
  * enqueue action copy's the content of the given item, the internal order of identical items is not relevant
- * The type also stores a pointer to the last element in the queue, which is also the largest one
- * if the queue is empty, the pointer is NULL
+ * The type also stores a copy of the last element in the queue, which is also the largest one
+ * (it is updated in place, and ignored while the queue is empty)
  *
  * The following functions are available:
  *
@@ -25,10 +25,13 @@
  *   spBPQueueEnqueue           - Inserts a new item to the queue, the inserted item is a copy of the given one,
  *                                the item would not be inserted if it is larger than the maximum
  *                                item of the queue, and the queue is at full capacity
+ *   spBPQueueEnqueueValues     - Inserts a new item given by its index and value, without
+ *                                creating an item
  *   spBPQueueDequeue           - Removes the minimal item from the queue
  *   spBPQueuePeek              - Returns a copy of the minimal item in the queue
  *   spBPQueuePeekLast          - Returns a copy of the maximal item in the queue
  *   spBPQueueMinValue          - Returns the value of the minimal item in the queue
+ *   spBPQueueMinIndex          - Returns the index of the minimal item in the queue
  *   spBPQueueMaxValue          - Returns the value of the maximal item in the queue
  *   spBPQueueIsEmpty           - Returns true if and only if the queue is empty
  *   spBPQueueIsFull            - Returns true if and only if the queue is full
@@ -135,6 +138,28 @@ int spBPQueueGetMaxSize(SPBPQueue source);
  */
 SP_BPQUEUE_MSG spBPQueueEnqueue(SPBPQueue source, SPListElement element);
 
+/**
+ * Insert a new item, given by its index and value, to the queue.
+ * Acts as spBPQueueEnqueue, yet no list element is created for the new item (the queue
+ * holds one for that), and an item that would be rejected because the queue is at full
+ * capacity is rejected right away, which makes this the preferred method for search
+ * loops that offer many candidates.
+ *
+ * @param source - The target which the enqueue is requested on.
+ * @param index - the index of the new item
+ * @param value - the value of the new item
+ *
+ * @return
+ * 	SP_BPQUEUE_OUT_OF_MEMORY - in case of memory allocation error
+ *	SP_BPQUEUE_FULL - in case the queue is at full capacity and the requested
+ *					  item is greater than or equal to the maximal element in the queue.
+ *	SP_BPQUEUE_INVALID_ARGUMENT - in case source is NULL or index < 0 or value < 0
+ *	SP_BPQUEUE_SUCCESS - in case the item was successfully inserted to the queue
+ *
+ *	@logger - the method logs allocation and arguments errors if needed
+ */
+SP_BPQUEUE_MSG spBPQueueEnqueueValues(SPBPQueue source, int index, double value);
+
 /**
  * Removes the minimal item from the queue
  *
@@ -180,6 +205,18 @@ SPListElement spBPQueuePeekLast(SPBPQueue source);
  */
 double spBPQueueMinValue(SPBPQueue source);
 
+/**
+ * The method is used to get the index of the minimum item in the queue, without copying
+ * the item as spBPQueuePeek does.
+ * @param source - The target which the check is requested on.
+ * @return
+ * -1 if source is NULL or queue is empty, otherwise returns the
+ * index of the minimum item in the queue.
+ *
+ * @logger - the method logs arguments errors if needed
+ */
+int spBPQueueMinIndex(SPBPQueue source);
+
 /**
  * The method is used to get the maximum value of the items in the queue.
  * @param source - The target which the check is requested on.
@@ -8,22 +8,38 @@ typedef struct node_t {
 	struct node_t* previous;
 }*Node;
 
-Node createNode(Node previous, Node next, SPListElement element);
-void destroyNode(Node node);
-
+/*
+ * freeNodes - the removed nodes (with their elements), linked by next, they are reused
+ * 			   by the following insertions instead of allocating new nodes
+ */
 typedef struct sp_list_t {
 	Node head;
 	Node tail;
 	Node current;
 	int size;
+	Node freeNodes;
 } sp_list_t;
 
-Node createNode(Node previous, Node next, SPListElement element) {
+Node createNode(SPList list, Node previous, Node next, SPListElement element);
+void destroyNode(Node node);
+void releaseNode(SPList list, Node node);
+
+Node createNode(SPList list, Node previous, Node next, SPListElement element) {
+	Node newNode = list->freeNodes;
+	if (newNode != NULL) { // a removed node, no allocation is needed
+		list->freeNodes = newNode->next;
+		spListElementSetIndex(newNode->data, spListElementGetIndex(element));
+		spListElementSetValue(newNode->data, spListElementGetValue(element));
+		newNode->previous = previous;
+		newNode->next = next;
+		return newNode;
+	}
+
 	SPListElement newElement = spListElementCopy(element);
 	if (newElement == NULL) {
 		return NULL;
 	}
-	Node newNode = (Node) malloc(sizeof(*newNode));
+	newNode = (Node) malloc(sizeof(*newNode));
 	if (newNode == NULL) {
 		spListElementDestroy(newElement);
 		return NULL;
@@ -44,6 +60,15 @@ void destroyNode(Node node) {
 	free(node);
 }
 
+/*
+ * Keeps the removed node (and its element) for the following insertions
+ */
+void releaseNode(SPList list, Node node) {
+	node->previous = NULL;
+	node->next = list->freeNodes;
+	list->freeNodes = node;
+}
+
 SPList spListCreate() {
 	SPList list = NULL;
 	spCalloc(list, sp_list_t , 1);
@@ -66,6 +91,7 @@ SPList spListCreate() {
 	list->tail->previous = list->head;
 	list->current = NULL;
 	list->size = 0;
+	list->freeNodes = NULL;
 	return list;
 }
 
@@ -132,7 +158,7 @@ SP_LIST_MSG spListInsertFirst(SPList list, SPListElement element) {
 	spMinimalVerifyArguments(list != NULL && element != NULL,
 			SP_LIST_NULL_ARGUMENT);
 
-	Node newNode = createNode(list->head, list->head->next, element);
+	Node newNode = createNode(list, list->head, list->head->next, element);
 	if (newNode == NULL) {
 		spLoggerSafePrintError(ERROR_ALLOCATING_MEMORY,
 				__FILE__, __FUNCTION__, __LINE__);
@@ -148,7 +174,7 @@ SP_LIST_MSG spListInsertLast(SPList list, SPListElement element) {
 	spMinimalVerifyArguments(list != NULL && element != NULL,
 			SP_LIST_NULL_ARGUMENT);
 
-	Node newNode = createNode(list->tail->previous, list->tail, element);
+	Node newNode = createNode(list, list->tail->previous, list->tail, element);
 	if (newNode == NULL) {
 		spLoggerSafePrintError(ERROR_ALLOCATING_MEMORY,
 				__FILE__, __FUNCTION__, __LINE__);
@@ -167,7 +193,7 @@ SP_LIST_MSG spListInsertBeforeCurrent(SPList list, SPListElement element) {
 	if (list->current == NULL) {
 		return SP_LIST_INVALID_CURRENT;
 	}
-	Node newNode = createNode(list->current->previous, list->current, element);
+	Node newNode = createNode(list, list->current->previous, list->current, element);
 	if (newNode == NULL) {
 		spLoggerSafePrintError(ERROR_ALLOCATING_MEMORY,
 				__FILE__, __FUNCTION__, __LINE__);
@@ -204,7 +230,7 @@ SP_LIST_MSG spListRemoveCurrent(SPList list) {
 	}
 	list->current->previous->next = list->current->next;
 	list->current->next->previous = list->current->previous;
-	destroyNode(list->current);
+	releaseNode(list, list->current);
 	list->current = NULL;
 	list->size--;
 	return SP_LIST_SUCCESS;
@@ -213,17 +239,28 @@ SP_LIST_MSG spListRemoveCurrent(SPList list) {
 SP_LIST_MSG spListClear(SPList list) {
 	spMinimalVerifyArguments(list != NULL,	SP_LIST_NULL_ARGUMENT);
 
-	while (spListGetFirst(list)) {
-		spListRemoveCurrent(list);
+	// all the nodes are kept for the following insertions at once
+	if (list->size > 0) {
+		list->tail->previous->next = list->freeNodes;
+		list->freeNodes = list->head->next;
+		list->head->next = list->tail;
+		list->tail->previous = list->head;
+		list->size = 0;
 	}
+	list->current = NULL;
 	return SP_LIST_SUCCESS;
 }
 
 void spListDestroy(SPList list) {
+	Node node;
 	if (list == NULL) {
 		return;
 	}
 	spListClear(list);
+	while ((node = list->freeNodes) != NULL) {
+		list->freeNodes = node->next;
+		destroyNode(node);
+	}
 	destroyNode(list->head);
 	destroyNode(list->tail);
 	free(list);
@@ -12,6 +12,10 @@
  * The list has an internal iterator for external use. For all functions
  * where the state of the iterator after calling that function is not stated,
  * the state of the iterator is undefined. That is you cannot assume anything about it.
+ * The nodes of removed elements are kept by the list and reused by the following
+ * insertions, so a list that is filled and emptied repeatedly (a bounded priority queue
+ * for instance) allocates memory only until it reaches its largest size. They are freed
+ * when the list is destroyed.
  *
  * The following functions are available:
  *
@@ -228,7 +232,8 @@ SP_LIST_MSG spListRemoveCurrent(SPList list);
 /**
  * Removes all elements from target list. The state of the current element will not be defined afterwards.
  *
- * The elements are deallocated using the stored freeing function
+ * The nodes of the elements are kept for the following insertions, this takes constant
+ * time
  * @param list Target list to remove all element from
  * @return
  * SP_LIST_NULL_ARGUMENT - if a NULL pointer was sent.
@@ -0,0 +1,408 @@
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "SPBoVWIndex.h"
+#include "SPKMeans.h"
+#include "../../general_utils/SPUtils.h"
+
+#define BOVW_KMEANS_ITERATIONS						10
+#define BOVW_MAX_BRANCHING							64
+#define BOVW_MAX_WORDS								(1 << 20)
+
+#define ERROR_CREATING_BOVW_INDEX					"Could not create the bag of visual words index"
+#define ERROR_TRAINING_BOVW_VOCABULARY				"Could not train the visual vocabulary"
+#define ERROR_BUILDING_BOVW_POSTINGS				"Could not build the visual words inverted index"
+#define ERROR_BOVW_QUANTIZE							"Could not quantize the descriptor"
+#define ERROR_BOVW_SCORING							"Could not score the images"
+
+#define DEBUG_BOVW_VOCABULARY_TRAINED				"Visual vocabulary trained, number of words:"
+#define DEBUG_BOVW_POSTINGS_BUILT					"Visual words inverted index built, number of postings:"
+
+/*
+ * A (visual word, image) pair of a single descriptor
+ */
+typedef struct bovw_occurrence_t {
+	int word;
+	int image;
+} BoVWOccurrence;
+
+/*
+ * A structure used for the bag of visual words index
+ * dim - the dimension of the descriptors
+ * numOfImages - the number of indexed images
+ * branching, depth - the vocabulary tree shape
+ * numOfWords - branching ^ depth, the number of leaves
+ * numOfNodes - the number of vocabulary tree nodes, in level order (node 0 is the root,
+ * 				the children of node n are n * branching + 1 ... n * branching + branching)
+ * centroids - numOfNodes row-major centroids (the root centroid is not used)
+ * idf - the inverse document frequency of each word, log(numOfImages / images with word)
+ * postingOffsets - numOfWords + 1 offsets, word w holds the postings at positions
+ * 					[postingOffsets[w], postingOffsets[w + 1])
+ * postingImages, postingWeights - the images that contain each word (in ascending order)
+ * 					and their normalized TF-IDF weight of the word
+ */
+struct sp_bovw_index_t {
+	int dim;
+	int numOfImages;
+	int branching;
+	int depth;
+	int numOfWords;
+	int numOfNodes;
+	double* centroids;
+	double* idf;
+	int* postingOffsets;
+	int* postingImages;
+	double* postingWeights;
+};
+
+void spBoVWIndexDestroy(SPBoVWIndex index) {
+	if (index == NULL)
+		return;
+	spFree(index->centroids);
+	spFree(index->idf);
+	spFree(index->postingOffsets);
+	spFree(index->postingImages);
+	spFree(index->postingWeights);
+	free(index);
+}
+
+//---------------------------------------------vocabulary----------------------------------------------
+
+/*
+ * Trains the children of the node over the given sample vectors, then partitions the
+ * vectors by their nearest child and trains each child over its own part
+ *
+ * @param vectors - n row-major sample vectors, reordered by the method
+ * @param scratch - a buffer of at least n vectors
+ * @param assignment - a buffer of at least n integers
+ * @returns false in case of memory allocation error, true otherwise
+ */
+static bool trainNode(SPBoVWIndex index, int node, int level, double* vectors, int n,
+		double* scratch, int* assignment) {
+	int i, c, firstChild = node * index->branching + 1, dim = index->dim;
+	int counts[BOVW_MAX_BRANCHING], offsets[BOVW_MAX_BRANCHING];
+	double* childCentroids = index->centroids + (size_t) firstChild * dim;
+	double* trained;
+
+	if (level == index->depth)
+		return true;
+
+	if (n == 0) { // an empty cluster, its subtree repeats its centroid
+		for (c = 0; c < index->branching; c++)
+			memcpy(childCentroids + (size_t) c * dim,
+					index->centroids + (size_t) node * dim, dim * sizeof(double));
+	}
+	else {
+		spVal((trained = spKMeansTrain(vectors, n, dim, index->branching,
+				BOVW_KMEANS_ITERATIONS)), ERROR_TRAINING_BOVW_VOCABULARY, false);
+		memcpy(childCentroids, trained, (size_t) index->branching * dim * sizeof(double));
+		free(trained);
+	}
+
+	// partition the vectors by their nearest child (a counting sort)
+	memset(counts, 0, sizeof(counts));
+	for (i = 0; i < n; i++) {
+		assignment[i] = spKMeansNearestCentroid(childCentroids, index->branching, dim,
+				vectors + (size_t) i * dim, NULL);
+		counts[assignment[i]]++;
+	}
+	for (c = 0, offsets[0] = 0; c + 1 < index->branching; c++)
+		offsets[c + 1] = offsets[c] + counts[c];
+	for (i = 0; i < n; i++)
+		memcpy(scratch + (size_t) (offsets[assignment[i]]++) * dim,
+				vectors + (size_t) i * dim, dim * sizeof(double));
+	memcpy(vectors, scratch, (size_t) n * dim * sizeof(double));
+
+	for (c = 0, i = 0; c < index->branching; i += counts[c], c++) {
+		if (!trainNode(index, firstChild + c, level + 1, vectors + (size_t) i * dim,
+				counts[c], scratch, assignment))
+			return false;
+	}
+	return true;
+}
+
+/*
+ * Trains the vocabulary tree over a strided sample of the points
+ *
+ * @returns false in case of memory allocation error, true otherwise
+ */
+static bool trainVocabulary(SPBoVWIndex index, SPPoint* pointsArray, int size,
+		int trainingSize) {
+	int sampleSize, *assignment = NULL;
+	double *sample = NULL, *scratch = NULL;
+	bool success;
+
+	spVal((sample = spKMeansSamplePoints(pointsArray, size, trainingSize, 0, index->dim,
+			&sampleSize)), ERROR_TRAINING_BOVW_VOCABULARY, false);
+	spCallocErWcRCb(scratch, double, (size_t) sampleSize * index->dim,
+			ERROR_TRAINING_BOVW_VOCABULARY, free(sample), false);
+	spCallocErWcRCb(assignment, int, sampleSize, ERROR_TRAINING_BOVW_VOCABULARY,
+			free(sample); free(scratch), false);
+
+	success = trainNode(index, 0, 0, sample, sampleSize, scratch, assignment);
+
+	free(sample);
+	free(scratch);
+	free(assignment);
+	spVal(success, ERROR_TRAINING_BOVW_VOCABULARY, false);
+
+	spLoggerSafePrintDebugWithIndex(DEBUG_BOVW_VOCABULARY_TRAINED, index->numOfWords,
+			__FILE__, __FUNCTION__, __LINE__);
+	return true;
+}
+
+/*
+ * Returns the visual word of a vector, by descending the vocabulary tree
+ */
+static int quantizeVector(SPBoVWIndex index, const double* vector) {
+	int level, node = 0;
+	for (level = 0; level < index->depth; level++)
+		node = node * index->branching + 1 + spKMeansNearestCentroid(index->centroids +
+				(size_t) (node * index->branching + 1) * index->dim, index->branching,
+				index->dim, vector, NULL);
+	return node - (index->numOfNodes - index->numOfWords);
+}
+
+/*
+ * Returns the visual word of a descriptor, buffer holds at least dim doubles
+ */
+static int quantizePoint(SPBoVWIndex index, SPPoint point, double* buffer) {
+	int j;
+	for (j = 0; j < index->dim; j++)
+		buffer[j] = spPointGetAxisCoor(point, j);
+	return quantizeVector(index, buffer);
+}
+
+//----------------------------------------------postings-----------------------------------------------
+
+static int occurrenceComparator(const void* first, const void* second) {
+	const BoVWOccurrence* a = (const BoVWOccurrence*) first;
+	const BoVWOccurrence* b = (const BoVWOccurrence*) second;
+	if (a->word != b->word)
+		return a->word - b->word;
+	return a->image - b->image;
+}
+
+/*
+ * Fills the postings from the (word, image) occurrences sorted by word and image:
+ * every run of equal pairs is a single posting, whose term frequency is the run length
+ * divided by the number of descriptors of the image
+ *
+ * @returns false in case of memory allocation error, true otherwise
+ */
+static bool fillPostings(SPBoVWIndex index, const BoVWOccurrence* occurrences, int size,
+		const int* imageSizes) {
+	int i, run, numOfPostings = 0, posting;
+	double *norms = NULL;
+
+	for (i = 0; i < size; i++) {
+		if (i == 0 || occurrenceComparator(occurrences + i, occurrences + i - 1) != 0) {
+			numOfPostings++;
+			index->postingOffsets[occurrences[i].word + 1]++;
+		}
+	}
+	for (i = 0; i < index->numOfWords; i++) {
+		index->idf[i] = index->postingOffsets[i + 1] > 0 ? log((double) index->numOfImages
+				/ index->postingOffsets[i + 1]) : 0;
+		index->postingOffsets[i + 1] += index->postingOffsets[i];
+	}
+
+	spCallocWr(index->postingImages, int, numOfPostings, false);
+	spCallocWr(index->postingWeights, double, numOfPostings, false);
+	spCallocWr(norms, double, index->numOfImages, false);
+
+	for (i = 0, posting = 0; i < size; i += run, posting++) {
+		for (run = 1; i + run < size &&
+				occurrenceComparator(occurrences + i, occurrences + i + run) == 0; run++);
+		index->postingImages[posting] = occurrences[i].image;
+		index->postingWeights[posting] = ((double) run / imageSizes[occurrences[i].image])
+				* index->idf[occurrences[i].word];
+		norms[occurrences[i].image] += index->postingWeights[posting] *
+				index->postingWeights[posting];
+	}
+
+	// every image vector is normalized to unit length
+	for (i = 0; i < numOfPostings; i++) {
+		if (norms[index->postingImages[i]] > 0)
+			index->postingWeights[i] /= sqrt(norms[index->postingImages[i]]);
+	}
+
+	free(norms);
+	spLoggerSafePrintDebugWithIndex(DEBUG_BOVW_POSTINGS_BUILT, numOfPostings, __FILE__,
+			__FUNCTION__, __LINE__);
+	return true;
+}
+
+/*
+ * Quantizes all the points and builds the inverted index
+ *
+ * @returns false in case of invalid image indices or memory allocation error,
+ * true otherwise
+ */
+static bool buildPostings(SPBoVWIndex index, SPPoint* pointsArray, int size) {
+	int i, *imageSizes = NULL;
+	double* buffer = NULL;
+	BoVWOccurrence* occurrences = NULL;
+	bool success;
+
+	spCallocWr(buffer, double, index->dim, false);
+	spCallocErWcRCb(imageSizes, int, index->numOfImages, ERROR_BUILDING_BOVW_POSTINGS,
+			free(buffer), false);
+	spCallocErWcRCb(occurrences, BoVWOccurrence, size, ERROR_BUILDING_BOVW_POSTINGS,
+			free(buffer); free(imageSizes), false);
+
+	for (i = 0, success = true; i < size && success; i++) {
+		occurrences[i].image = spPointGetIndex(pointsArray[i]);
+		success = occurrences[i].image >= 0 && occurrences[i].image < index->numOfImages;
+		if (success) {
+			occurrences[i].word = quantizePoint(index, pointsArray[i], buffer);
+			imageSizes[occurrences[i].image]++;
+		}
+	}
+
+	if (success) {
+		qsort(occurrences, size, sizeof(BoVWOccurrence), occurrenceComparator);
+		success = fillPostings(index, occurrences, size, imageSizes);
+	}
+
+	free(buffer);
+	free(imageSizes);
+	free(occurrences);
+	spVal(success, ERROR_BUILDING_BOVW_POSTINGS, false);
+	return true;
+}
+
+/*
+ * Returns the number of words of a vocabulary tree, or -1 if it exceeds BOVW_MAX_WORDS
+ */
+static int countWords(int branching, int depth) {
+	int level, numOfWords = 1;
+	for (level = 0; level < depth; level++) {
+		if (numOfWords > BOVW_MAX_WORDS / branching)
+			return -1;
+		numOfWords *= branching;
+	}
+	return numOfWords;
+}
+
+SPBoVWIndex spBoVWIndexCreate(SPPoint* pointsArray, int size, int numOfImages,
+		int branching, int depth, int trainingSize) {
+	int i, numOfWords = branching >= 2 && branching <= BOVW_MAX_BRANCHING && depth > 0 ?
+			countWords(branching, depth) : -1;
+	SPBoVWIndex index = NULL;
+	spVerifyArgumentsRn(pointsArray != NULL && size > 0 && pointsArray[0] != NULL &&
+			numOfImages > 0 && numOfWords > 0 && trainingSize > 0,
+			ERROR_CREATING_BOVW_INDEX);
+
+	spCalloc(index, struct sp_bovw_index_t, 1);
+	index->dim = spPointGetDimension(pointsArray[0]);
+	index->numOfImages = numOfImages;
+	index->branching = branching;
+	index->depth = depth;
+	index->numOfWords = numOfWords;
+	// 1 + b + ... + b^depth, without overflow since b^depth <= BOVW_MAX_WORDS
+	index->numOfNodes = (numOfWords * branching - 1) / (branching - 1);
+
+	spCallocWc(index->centroids, double, (size_t) index->numOfNodes * index->dim,
+			spBoVWIndexDestroy(index));
+	spCallocWc(index->idf, double, numOfWords, spBoVWIndexDestroy(index));
+	spCallocWc(index->postingOffsets, int, numOfWords + 1, spBoVWIndexDestroy(index));
+
+	spValWcRn(trainVocabulary(index, pointsArray, size, trainingSize) &&
+			buildPostings(index, pointsArray, size), ERROR_CREATING_BOVW_INDEX,
+			spBoVWIndexDestroy(index));
+
+	// the descriptors are no longer needed once they are indexed
+	for (i = 0; i < size; i++)
+		spPointDestroy(pointsArray[i]);
+	return index;
+}
+
+//-----------------------------------------------query-------------------------------------------------
+
+int spBoVWIndexGetNumOfWords(SPBoVWIndex index) {
+	return index == NULL ? -1 : index->numOfWords;
+}
+
+int spBoVWIndexQuantize(SPBoVWIndex index, SPPoint descriptor) {
+	int word;
+	double* buffer = NULL;
+	spVerifyArguments(index != NULL && descriptor != NULL &&
+			spPointGetDimension(descriptor) == index->dim, ERROR_BOVW_QUANTIZE, -1);
+
+	spCallocWr(buffer, double, index->dim, -1);
+	word = quantizePoint(index, descriptor, buffer);
+	free(buffer);
+	return word;
+}
+
+static int wordComparator(const void* first, const void* second) {
+	return *((const int*) first) - *((const int*) second);
+}
+
+bool spBoVWIndexScoreImages(SPBoVWIndex index, SPPoint* features, int numOfFeatures,
+		double* scores) {
+	int i, run, p, *words = NULL;
+	double weight, *buffer = NULL;
+	spVerifyArguments(index != NULL && (features != NULL || numOfFeatures == 0) &&
+			numOfFeatures >= 0 && scores != NULL, ERROR_BOVW_SCORING, false);
+
+	memset(scores, 0, index->numOfImages * sizeof(double));
+	if (numOfFeatures == 0)
+		return true;
+
+	spCallocWr(buffer, double, index->dim, false);
+	spCallocErWcRCb(words, int, numOfFeatures, ERROR_BOVW_SCORING, free(buffer), false);
+
+	for (i = 0; i < numOfFeatures; i++) {
+		if (features[i] == NULL || spPointGetDimension(features[i]) != index->dim) {
+			free(buffer);
+			free(words);
+			spLoggerSafePrintError(ERROR_BOVW_SCORING, __FILE__, __FUNCTION__, __LINE__);
+			return false;
+		}
+		words[i] = quantizePoint(index, features[i], buffer);
+	}
+	qsort(words, numOfFeatures, sizeof(int), wordComparator);
+
+	// one sparse dot product term per distinct query word
+	for (i = 0; i < numOfFeatures; i += run) {
+		for (run = 1; i + run < numOfFeatures && words[i + run] == words[i]; run++);
+		weight = ((double) run / numOfFeatures) * index->idf[words[i]];
+		for (p = index->postingOffsets[words[i]]; p < index->postingOffsets[words[i] + 1];
+				p++)
+			scores[index->postingImages[p]] += weight * index->postingWeights[p];
+	}
+
+	free(buffer);
+	free(words);
+	return true;
+}
+
+int* spBoVWIndexSimilarImages(SPBoVWIndex index, SPPoint* features, int numOfFeatures,
+		int numOfSimilarImages) {
+	int i, j, count = 0, *topImages = NULL;
+	double* scores = NULL;
+	spVerifyArgumentsRn(index != NULL && numOfSimilarImages > 0 &&
+			numOfSimilarImages <= index->numOfImages, ERROR_BOVW_SCORING);
+
+	spCallocEr(scores, double, index->numOfImages, ERROR_BOVW_SCORING, NULL);
+	spCallocErWcRCb(topImages, int, numOfSimilarImages, ERROR_BOVW_SCORING,
+			free(scores), NULL);
+	spValWcRn(spBoVWIndexScoreImages(index, features, numOfFeatures, scores),
+			ERROR_BOVW_SCORING, free(scores); free(topImages));
+
+	// insertion into the sorted top list, a later image enters only with a higher score
+	for (i = 0; i < index->numOfImages; i++) {
+		if (count == numOfSimilarImages &&
+				scores[i] <= scores[topImages[numOfSimilarImages - 1]])
+			continue;
+		j = count < numOfSimilarImages ? count++ : numOfSimilarImages - 1;
+		for (; j > 0 && scores[topImages[j - 1]] < scores[i]; j--)
+			topImages[j] = topImages[j - 1];
+		topImages[j] = i;
+	}
+
+	free(scores);
+	return topImages;
+}
@@ -0,0 +1,114 @@
+#ifndef SPBOVWINDEX_H_
+#define SPBOVWINDEX_H_
+
+#include <stdbool.h>
+#include "../../SPPoint.h"
+
+/**
+ * SP Bag Of Visual Words Index summary
+ *
+ * An image level retrieval index. A visual vocabulary is trained by hierarchical k-means
+ * (a vocabulary tree): the descriptors are clustered into 'branching' clusters, each
+ * cluster is clustered again, down to 'depth' levels, and the leaves are the visual
+ * words. A descriptor is quantized by descending the tree to its nearest child at each
+ * level, thus it costs branching * depth distance computations.
+ *
+ * Every image is represented by a sparse TF-IDF vector over the words (normalized to
+ * unit length), stored as an inverted index from each word to the (image, weight)
+ * postings of the images that contain it. A query image is scored against all the
+ * images by sparse dot products, visiting only the postings of its own words.
+ *
+ * The following functions are supported:
+ *
+ * spBoVWIndexCreate			- Trains the vocabulary and indexes the given points
+ * spBoVWIndexGetNumOfWords		- Returns the number of visual words
+ * spBoVWIndexQuantize			- Returns the visual word of a descriptor
+ * spBoVWIndexScoreImages		- Scores all the images against a query image
+ * spBoVWIndexSimilarImages		- Returns the most similar images to a query image
+ * spBoVWIndexDestroy			- Frees all the resources of the index
+ */
+
+/** Type for defining the bag of visual words index **/
+typedef struct sp_bovw_index_t* SPBoVWIndex;
+
+/*
+ * The method trains the vocabulary tree on a strided sample of the given points and
+ * indexes all of them by their image index (spPointGetIndex).
+ * The index takes ownership of the points: they are destroyed once indexed
+ * (on failure the points are not destroyed).
+ *
+ * @param pointsArray - the database descriptors (all at the same dimension)
+ * @param size - the size of pointsArray
+ * @param numOfImages - the number of images, the image indices are in [0, numOfImages)
+ * @param branching - the number of children of each vocabulary tree node, in [2, 64]
+ * @param depth - the number of levels of the vocabulary tree, the number of words is
+ * 				  branching ^ depth (at most 2^20)
+ * @param trainingSize - the number of descriptors sampled for the training
+ *
+ * @returns
+ * NULL in case of invalid arguments (including a too large vocabulary) or memory
+ * allocation error, otherwise the new index
+ *
+ * @logger - the method logs allocation and arguments errors if needed
+ * debug prints are also printed to the logger
+ */
+SPBoVWIndex spBoVWIndexCreate(SPPoint* pointsArray, int size, int numOfImages,
+		int branching, int depth, int trainingSize);
+
+/*
+ * Returns the number of visual words of the index, or -1 if index is NULL
+ */
+int spBoVWIndexGetNumOfWords(SPBoVWIndex index);
+
+/*
+ * The method returns the visual word of the given descriptor.
+ *
+ * @returns -1 in case of invalid arguments, otherwise the word in [0, number of words)
+ *
+ * @logger - the method logs arguments errors if needed
+ */
+int spBoVWIndexQuantize(SPBoVWIndex index, SPPoint descriptor);
+
+/*
+ * The method computes the similarity of the query image, given by its descriptors, to
+ * every indexed image: the dot product of their TF-IDF vectors.
+ * The query vector is not normalized, since this does not change the ranking.
+ *
+ * @param index - the index
+ * @param features - the descriptors of the query image (may be NULL if numOfFeatures is 0)
+ * @param numOfFeatures - the size of features
+ * @param scores - an array of numOfImages scores to fill, image i gets scores[i]
+ *
+ * @returns false in case of invalid arguments or memory allocation error, true otherwise
+ *
+ * @logger - the method logs allocation and arguments errors if needed
+ */
+bool spBoVWIndexScoreImages(SPBoVWIndex index, SPPoint* features, int numOfFeatures,
+		double* scores);
+
+/*
+ * The method returns the indices of the numOfSimilarImages images with the highest
+ * scores (see spBoVWIndexScoreImages), ordered by descending score. Images with equal
+ * scores are ordered by their index.
+ *
+ * @param index - the index
+ * @param features - the descriptors of the query image
+ * @param numOfFeatures - the size of features
+ * @param numOfSimilarImages - the size of the returned array, at most the number of images
+ *
+ * @returns
+ * NULL in case of invalid arguments or memory allocation error,
+ * otherwise an array of numOfSimilarImages image indices
+ *
+ * @logger - the method logs allocation and arguments errors if needed
+ */
+int* spBoVWIndexSimilarImages(SPBoVWIndex index, SPPoint* features, int numOfFeatures,
+		int numOfSimilarImages);
+
+/*
+ * Frees all the resources of the index.
+ * If index is NULL nothing happens.
+ */
+void spBoVWIndexDestroy(SPBoVWIndex index);
+
+#endif /* SPBOVWINDEX_H_ */
@@ -0,0 +1,546 @@
+#include <stdlib.h>
+#include <limits.h>
+#include <pthread.h>
+#include "SPBruteForceIndex.h"
+#include "../../general_utils/SPUtils.h"
+#include "../../general_utils/SPInstrumentation.h"
+
+#define BRUTE_FORCE_QUERY_BLOCK						8 // queries scored together against a row
+#define BRUTE_FORCE_ROW_BLOCK						64 // rows scored against every query block
+#define BRUTE_FORCE_THREAD_CHUNK					16 // row blocks a scan thread takes at once
+
+#define ERROR_CREATING_BRUTE_FORCE_INDEX			"Could not create the brute force index"
+#define ERROR_BRUTE_FORCE_KNN						"Brute force k-NN search failed"
+#define ERROR_ADDING_BRUTE_FORCE_POINTS				"Could not add the points to the brute force index"
+
+#define WARNING_BRUTE_FORCE_THREADS_NOT_CREATED		"Not all the brute force scan threads could be created"
+
+/*
+ * A database row and its distance to a query
+ */
+typedef struct brute_force_candidate_t {
+	double distance;
+	int imageIndex;
+	int row;
+} BruteForceCandidate;
+
+/*
+ * The k best rows of a query found so far, a bounded binary max heap (the top is the
+ * worst row) ordered as the queue orders its elements - by distance and then by index
+ */
+typedef struct brute_force_heap_t {
+	BruteForceCandidate* items;
+	int size;
+	int capacity;
+} BruteForceHeap;
+
+/*
+ * The queries of a search, prepared for the scan
+ * numOfQueries - the number of queries
+ * numOfBlocks - the number of query blocks
+ * totalCapacity - the sum of the k of all the queries
+ * vectors - numOfQueries row-major query vectors
+ * packedBlocks - per query block, dim rows of BRUTE_FORCE_QUERY_BLOCK coordinates (the
+ * 				  block transposed, padded by zero queries)
+ * norms - the squared norm of each query
+ * capacities - the k of each query
+ */
+typedef struct brute_force_batch_t {
+	int numOfQueries;
+	int numOfBlocks;
+	int totalCapacity;
+	double* vectors;
+	double* packedBlocks;
+	double* norms;
+	int* capacities;
+} BruteForceBatch;
+
+/*
+ * A scan thread data
+ * heaps - the thread own heap of each query, stored in items
+ * rowVector - the coordinates of the scanned row as doubles (dim entries)
+ * nextRowBlock - the first row block no thread has taken yet
+ */
+typedef struct brute_force_worker_t {
+	SPBruteForceIndex index;
+	const BruteForceBatch* batch;
+	BruteForceHeap* heaps;
+	BruteForceCandidate* items;
+	double* rowVector;
+	int* nextRowBlock;
+	pthread_mutex_t* nextRowBlockLock;
+} BruteForceWorker;
+
+/*
+ * A structure used for the brute force index
+ * size, dim - the number and the dimension of the indexed descriptors
+ * capacity - the number of descriptors the allocated arrays can hold
+ * numOfThreads - the maximal number of threads that scan the database
+ * precision - the storage precision of the descriptors (that of the indexed points)
+ * vectors - size row-major descriptors, stored at precision
+ * norms - the squared norm of each descriptor
+ * imageIndices - the image index of each descriptor
+ */
+struct sp_brute_force_index_t {
+	int size;
+	int dim;
+	int capacity;
+	int numOfThreads;
+	SP_POINT_PRECISION precision;
+	void* vectors;
+	double* norms;
+	int* imageIndices;
+};
+
+static void* getRow(SPBruteForceIndex index, int row) {
+	return (char*) index->vectors + (size_t) row * index->dim *
+			spPointGetCoorSize(index->precision);
+}
+
+//-------------------------------------------------heap------------------------------------------------
+
+static bool isWorse(BruteForceCandidate a, BruteForceCandidate b) {
+	if (a.distance != b.distance)
+		return a.distance > b.distance;
+	return a.imageIndex > b.imageIndex;
+}
+
+/*
+ * Adds the row to the heap if the heap is not full or the row is better than its worst
+ */
+static void heapOffer(BruteForceHeap* heap, double distance, int imageIndex, int row) {
+	int i, child, parent;
+	BruteForceCandidate item;
+	item.distance = distance;
+	item.imageIndex = imageIndex;
+	item.row = row;
+
+	if (heap->size < heap->capacity) {
+		for (i = heap->size++; i > 0; i = parent) {
+			parent = (i - 1) / 2;
+			if (!isWorse(item, heap->items[parent]))
+				break;
+			heap->items[i] = heap->items[parent];
+		}
+		heap->items[i] = item;
+		return;
+	}
+
+	if (!isWorse(heap->items[0], item))
+		return;
+	// the row replaces the worst one
+	for (i = 0; (child = 2 * i + 1) < heap->size; i = child) {
+		if (child + 1 < heap->size && isWorse(heap->items[child + 1], heap->items[child]))
+			child++;
+		if (!isWorse(heap->items[child], item))
+			break;
+		heap->items[i] = heap->items[child];
+	}
+	heap->items[i] = item;
+}
+
+//-------------------------------------------------scan------------------------------------------------
+
+/*
+ * Computes the dot products of vector with the BRUTE_FORCE_QUERY_BLOCK queries of a
+ * packed block. The queries are interleaved per coordinate and the pointers don't alias,
+ * so the loop over the block is vectorized by the compiler (the makefiles build at -O3).
+ */
+static void dotBlock(const double* restrict packed, const double* restrict vector,
+		int dim, double* restrict dots) {
+	int b, j;
+	double x;
+
+	for (b = 0; b < BRUTE_FORCE_QUERY_BLOCK; b++)
+		dots[b] = 0;
+	for (j = 0; j < dim; j++) {
+		x = vector[j];
+		for (b = 0; b < BRUTE_FORCE_QUERY_BLOCK; b++)
+			dots[b] += packed[j * BRUTE_FORCE_QUERY_BLOCK + b] * x;
+	}
+}
+
+/*
+ * Scores the rows [start, end) against all the queries of the batch, a query block at
+ * a time - the dot products of a row with the queries of a block are accumulated
+ * together (in double), so the row is read once per block. Rows that are not stored as
+ * doubles are converted into rowVector first.
+ */
+static void scanRows(SPBruteForceIndex index, const BruteForceBatch* batch,
+		BruteForceHeap* heaps, double* rowVector, int start, int end) {
+	int block, b, row, query, count;
+	double dots[BRUTE_FORCE_QUERY_BLOCK];
+	const double *vector, *packed;
+
+	for (block = 0; block < batch->numOfBlocks; block++) {
+		packed = batch->packedBlocks + (size_t) block * index->dim * BRUTE_FORCE_QUERY_BLOCK;
+		query = block * BRUTE_FORCE_QUERY_BLOCK;
+		count = batch->numOfQueries - query < BRUTE_FORCE_QUERY_BLOCK ?
+				batch->numOfQueries - query : BRUTE_FORCE_QUERY_BLOCK;
+
+		for (row = start; row < end; row++) {
+			if (index->precision == SP_POINT_PRECISION_DOUBLE) {
+				vector = (const double*) getRow(index, row);
+			}
+			else {
+				spPointRowToVector(getRow(index, row), index->dim, index->precision,
+						rowVector);
+				vector = rowVector;
+			}
+			dotBlock(packed, vector, index->dim, dots);
+			for (b = 0; b < count; b++) {
+				heapOffer(&(heaps[query + b]), batch->norms[query + b] + index->norms[row]
+						- 2 * dots[b], index->imageIndices[row], row);
+			}
+		}
+	}
+}
+
+/*
+ * Scans row blocks until all of them are taken, the calling thread is one of the
+ * scan threads
+ */
+static void* scanRowsWorker(void* data) {
+	BruteForceWorker* worker = (BruteForceWorker*) data;
+	SPBruteForceIndex index = worker->index;
+	int block, first, start, end;
+	int numOfRowBlocks = (index->size + BRUTE_FORCE_ROW_BLOCK - 1) / BRUTE_FORCE_ROW_BLOCK;
+
+	while (true) {
+		pthread_mutex_lock(worker->nextRowBlockLock);
+		first = *(worker->nextRowBlock);
+		*(worker->nextRowBlock) += BRUTE_FORCE_THREAD_CHUNK;
+		pthread_mutex_unlock(worker->nextRowBlockLock);
+		if (first >= numOfRowBlocks)
+			break;
+
+		for (block = first; block < first + BRUTE_FORCE_THREAD_CHUNK &&
+				block < numOfRowBlocks; block++) {
+			start = block * BRUTE_FORCE_ROW_BLOCK;
+			end = start + BRUTE_FORCE_ROW_BLOCK < index->size ?
+					start + BRUTE_FORCE_ROW_BLOCK : index->size;
+			scanRows(index, worker->batch, worker->heaps, worker->rowVector, start, end);
+		}
+	}
+	return NULL;
+}
+
+//-------------------------------------------------batch-----------------------------------------------
+
+static void freeBatch(BruteForceBatch* batch) {
+	spFree(batch->vectors);
+	spFree(batch->packedBlocks);
+	spFree(batch->norms);
+	spFree(batch->capacities);
+}
+
+/*
+ * Copies the query points into the batch and packs them into blocks
+ *
+ * @returns false in case of memory allocation error, true otherwise
+ */
+static bool initBatch(BruteForceBatch* batch, SPBruteForceIndex index, SPBPQueue* bpqs,
+		SPPoint* queryPoints, int numOfQueries) {
+	int q, j;
+	double coordinate;
+	double* packed;
+
+	batch->numOfQueries = numOfQueries;
+	batch->numOfBlocks = (numOfQueries + BRUTE_FORCE_QUERY_BLOCK - 1) /
+			BRUTE_FORCE_QUERY_BLOCK;
+	batch->totalCapacity = 0;
+	spCallocWr(batch->vectors, double, (size_t) numOfQueries * index->dim, false);
+	spCallocWr(batch->packedBlocks, double, (size_t) batch->numOfBlocks *
+			BRUTE_FORCE_QUERY_BLOCK * index->dim, false);
+	spCallocWr(batch->norms, double, numOfQueries, false);
+	spCallocWr(batch->capacities, int, numOfQueries, false);
+
+	for (q = 0; q < numOfQueries; q++) {
+		packed = batch->packedBlocks + (size_t) (q / BRUTE_FORCE_QUERY_BLOCK) *
+				BRUTE_FORCE_QUERY_BLOCK * index->dim + q % BRUTE_FORCE_QUERY_BLOCK;
+		for (j = 0; j < index->dim; j++) {
+			coordinate = spPointGetAxisCoor(queryPoints[q], j);
+			batch->vectors[(size_t) q * index->dim + j] = coordinate;
+			packed[j * BRUTE_FORCE_QUERY_BLOCK] = coordinate;
+			batch->norms[q] += coordinate * coordinate;
+		}
+		batch->capacities[q] = spBPQueueGetMaxSize(bpqs[q]);
+		batch->totalCapacity += batch->capacities[q];
+	}
+	return true;
+}
+
+/*
+ * Allocates the heaps of every scan thread
+ *
+ * @returns false in case of memory allocation error, true otherwise
+ */
+static bool initWorkers(BruteForceWorker* workers, int numOfWorkers,
+		SPBruteForceIndex index, const BruteForceBatch* batch, int* nextRowBlock,
+		pthread_mutex_t* nextRowBlockLock) {
+	int t, q, offset;
+	for (t = 0; t < numOfWorkers; t++) {
+		workers[t].index = index;
+		workers[t].batch = batch;
+		workers[t].nextRowBlock = nextRowBlock;
+		workers[t].nextRowBlockLock = nextRowBlockLock;
+		spCallocWr(workers[t].heaps, BruteForceHeap, batch->numOfQueries, false);
+		spCallocWr(workers[t].items, BruteForceCandidate, batch->totalCapacity, false);
+		spCallocWr(workers[t].rowVector, double, index->dim, false);
+		for (q = 0, offset = 0; q < batch->numOfQueries; q++) {
+			workers[t].heaps[q].items = workers[t].items + offset;
+			workers[t].heaps[q].capacity = batch->capacities[q];
+			offset += batch->capacities[q];
+		}
+	}
+	return true;
+}
+
+static void freeWorkers(BruteForceWorker* workers, int numOfWorkers) {
+	int t;
+	if (workers == NULL)
+		return;
+	for (t = 0; t < numOfWorkers; t++) {
+		spFree(workers[t].heaps);
+		spFree(workers[t].items);
+		spFree(workers[t].rowVector);
+	}
+	free(workers);
+}
+
+/*
+ * Runs the scan threads, the calling thread is one of them
+ */
+static void runWorkers(BruteForceWorker* workers, int numOfWorkers) {
+	int t, numOfCreated = 0;
+	pthread_t* threads = NULL;
+
+	if (numOfWorkers > 1 && (threads = (pthread_t*) calloc(numOfWorkers,
+			sizeof(pthread_t))) != NULL) {
+		for (t = 1; t < numOfWorkers; t++) {
+			if (pthread_create(&(threads[t]), NULL, scanRowsWorker, &(workers[t])) != 0)
+				break;
+			numOfCreated++;
+		}
+	}
+	scanRowsWorker(&(workers[0]));
+	for (t = 1; t <= numOfCreated; t++)
+		pthread_join(threads[t], NULL);
+
+	// the rows of the threads that were not created were scanned by the others
+	if (numOfCreated < numOfWorkers - 1)
+		spLoggerSafePrintWarning(WARNING_BRUTE_FORCE_THREADS_NOT_CREATED, __FILE__,
+				__FUNCTION__, __LINE__);
+	free(threads);
+}
+
+/*
+ * Enqueues the rows of all the threads heaps into the queues, with their distances
+ * recomputed directly
+ *
+ * @returns false in case of memory allocation error, true otherwise
+ */
+static bool enqueueResults(SPBruteForceIndex index, const BruteForceBatch* batch,
+		BruteForceWorker* workers, int numOfWorkers, SPBPQueue* bpqs) {
+	int q, t, i, row;
+	double distance;
+	BruteForceHeap* heap;
+	SP_BPQUEUE_MSG msg;
+
+	for (q = 0; q < batch->numOfQueries; q++) {
+		for (t = 0; t < numOfWorkers; t++) {
+			heap = &(workers[t].heaps[q]);
+			for (i = 0; i < heap->size; i++) {
+				row = heap->items[i].row;
+				distance = spPointRowL2SquaredDistance(batch->vectors +
+						(size_t) q * index->dim, getRow(index, row), index->dim,
+						index->precision);
+				if (distance <= epsilon) // same precision rule as the KD-tree search
+					distance = 0;
+				msg = spBPQueueEnqueueValues(bpqs[q], index->imageIndices[row], distance);
+				spVal(msg == SP_BPQUEUE_SUCCESS || msg == SP_BPQUEUE_FULL,
+						ERROR_BRUTE_FORCE_KNN, false);
+			}
+		}
+	}
+	return true;
+}
+
+//-------------------------------------------------index-----------------------------------------------
+
+/*
+ * Copies the points into the rows [index->size, index->size + size), the arrays must
+ * have room for them
+ */
+static void copyPoints(SPBruteForceIndex index, SPPoint* pointsArray, int size) {
+	int i, j, row;
+	double coordinate;
+	size_t coorSize = spPointGetCoorSize(index->precision);
+	for (i = 0; i < size; i++) {
+		row = index->size + i;
+		spPointCopyToRow(pointsArray[i], getRow(index, row), index->precision);
+		// the norm of the stored coordinates, which may be rounded to the index precision
+		index->norms[row] = 0;
+		for (j = 0; j < index->dim; j++) {
+			spPointRowToVector((char*) getRow(index, row) + j * coorSize, 1,
+					index->precision, &coordinate);
+			index->norms[row] += coordinate * coordinate;
+		}
+		index->imageIndices[row] = spPointGetIndex(pointsArray[i]);
+	}
+	index->size += size;
+}
+
+/*
+ * Returns true iff all the points are not NULL and at the index dimension
+ */
+static bool isValidPointsArray(SPBruteForceIndex index, SPPoint* pointsArray, int size) {
+	int i;
+	for (i = 0; i < size; i++) {
+		if (pointsArray[i] == NULL || spPointGetDimension(pointsArray[i]) != index->dim)
+			return false;
+	}
+	return true;
+}
+
+/*
+ * Grows the arrays to hold at least 'capacity' descriptors, the capacity is at least
+ * doubled so appending points one image at a time is amortized linear
+ *
+ * @returns false in case of memory allocation error, true otherwise
+ */
+static bool growCapacity(SPBruteForceIndex index, int capacity) {
+	void* vectors;
+	double* norms;
+	int* imageIndices;
+
+	if (capacity <= index->capacity)
+		return true;
+	if (capacity < 2 * index->capacity)
+		capacity = 2 * index->capacity;
+
+	// each array is replaced as soon as it is reallocated, so a failure leaves
+	// a consistent index of the old size
+	vectors = realloc(index->vectors, (size_t) capacity * index->dim *
+			spPointGetCoorSize(index->precision));
+	spVal(vectors != NULL, ERROR_ALLOCATING_MEMORY, false);
+	index->vectors = vectors;
+	norms = (double*) realloc(index->norms, (size_t) capacity * sizeof(double));
+	spVal(norms != NULL, ERROR_ALLOCATING_MEMORY, false);
+	index->norms = norms;
+	imageIndices = (int*) realloc(index->imageIndices, (size_t) capacity * sizeof(int));
+	spVal(imageIndices != NULL, ERROR_ALLOCATING_MEMORY, false);
+	index->imageIndices = imageIndices;
+
+	index->capacity = capacity;
+	return true;
+}
+
+/*
+ * Frees the index internal allocations
+ */
+static void freeBruteForceIndexData(SPBruteForceIndex index) {
+	spFree(index->vectors);
+	spFree(index->norms);
+	spFree(index->imageIndices);
+	free(index);
+}
+
+SPBruteForceIndex spBruteForceIndexCreate(SPPoint* pointsArray, int size,
+		int numOfThreads) {
+	int i;
+	SPBruteForceIndex index = NULL;
+	spVerifyArgumentsRn(pointsArray != NULL && size > 0 && pointsArray[0] != NULL &&
+			numOfThreads > 0, ERROR_CREATING_BRUTE_FORCE_INDEX);
+
+	spCalloc(index, struct sp_brute_force_index_t, 1);
+	index->capacity = size;
+	index->dim = spPointGetDimension(pointsArray[0]);
+	index->numOfThreads = numOfThreads;
+	index->precision = spPointGetPrecision(pointsArray[0]);
+
+	spCallocWc(index->vectors, char, (size_t) size * index->dim *
+			spPointGetCoorSize(index->precision), freeBruteForceIndexData(index));
+	spCallocWc(index->norms, double, size, freeBruteForceIndexData(index));
+	spCallocWc(index->imageIndices, int, size, freeBruteForceIndexData(index));
+
+	spValWcRn(isValidPointsArray(index, pointsArray, size),
+			ERROR_CREATING_BRUTE_FORCE_INDEX, freeBruteForceIndexData(index));
+	copyPoints(index, pointsArray, size);
+
+	// the database matrix replaces the original descriptors
+	for (i = 0; i < size; i++)
+		spPointDestroy(pointsArray[i]);
+
+	return index;
+}
+
+bool spBruteForceIndexAddPoints(SPBruteForceIndex index, SPPoint* pointsArray,
+		int size) {
+	int i;
+	spVerifyArguments(index != NULL && pointsArray != NULL && size > 0,
+			ERROR_ADDING_BRUTE_FORCE_POINTS, false);
+	spVerifyArguments(isValidPointsArray(index, pointsArray, size),
+			ERROR_ADDING_BRUTE_FORCE_POINTS, false);
+
+	spVal(size <= INT_MAX - index->size && growCapacity(index, index->size + size),
+			ERROR_ADDING_BRUTE_FORCE_POINTS, false);
+	copyPoints(index, pointsArray, size);
+
+	for (i = 0; i < size; i++)
+		spPointDestroy(pointsArray[i]);
+	return true;
+}
+
+bool spBruteForceIndexKNN(SPBruteForceIndex index, SPBPQueue bpq, SPPoint queryPoint) {
+	return spBruteForceIndexKNNBatch(index, &bpq, &queryPoint, 1);
+}
+
+bool spBruteForceIndexKNNBatch(SPBruteForceIndex index, SPBPQueue* bpqs,
+		SPPoint* queryPoints, int numOfQueries) {
+	int q, numOfWorkers, nextRowBlock = 0;
+	bool rslt;
+	BruteForceBatch batch = { 0 };
+	BruteForceWorker* workers = NULL;
+	pthread_mutex_t nextRowBlockLock;
+	spVerifyArguments(index != NULL && bpqs != NULL && queryPoints != NULL &&
+			numOfQueries > 0, ERROR_BRUTE_FORCE_KNN, false);
+	for (q = 0; q < numOfQueries; q++) {
+		spVerifyArguments(bpqs[q] != NULL && queryPoints[q] != NULL &&
+				spPointGetDimension(queryPoints[q]) == index->dim,
+				ERROR_BRUTE_FORCE_KNN, false);
+	}
+
+	// a thread is worth creating only if it gets at least one chunk of rows
+	numOfWorkers = (index->size + BRUTE_FORCE_ROW_BLOCK * BRUTE_FORCE_THREAD_CHUNK - 1) /
+			(BRUTE_FORCE_ROW_BLOCK * BRUTE_FORCE_THREAD_CHUNK);
+	if (numOfWorkers > index->numOfThreads)
+		numOfWorkers = index->numOfThreads;
+
+	spValWc(initBatch(&batch, index, bpqs, queryPoints, numOfQueries),
+			ERROR_BRUTE_FORCE_KNN, freeBatch(&batch), false);
+	spCallocErWcRCb(workers, BruteForceWorker, numOfWorkers, ERROR_BRUTE_FORCE_KNN,
+			freeBatch(&batch), false);
+	pthread_mutex_init(&nextRowBlockLock, NULL);
+
+	rslt = initWorkers(workers, numOfWorkers, index, &batch, &nextRowBlock,
+			&nextRowBlockLock);
+	if (rslt) {
+		runWorkers(workers, numOfWorkers);
+		// counted here, the scan threads do not end queries (see SPInstrumentation.h)
+		spInstrCountN(SP_INSTR_DISTANCE_EVALS, (uint64_t) index->size * numOfQueries);
+		rslt = enqueueResults(index, &batch, workers, numOfWorkers, bpqs);
+	}
+
+	pthread_mutex_destroy(&nextRowBlockLock);
+	freeWorkers(workers, numOfWorkers);
+	freeBatch(&batch);
+	spVal(rslt, ERROR_BRUTE_FORCE_KNN, false);
+	return true;
+}
+
+void spBruteForceIndexDestroy(SPBruteForceIndex index) {
+	if (index == NULL)
+		return;
+	freeBruteForceIndexData(index);
+}
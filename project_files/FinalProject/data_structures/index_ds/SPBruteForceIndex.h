@@ -0,0 +1,112 @@
+#ifndef SPBRUTEFORCEINDEX_H_
+#define SPBRUTEFORCEINDEX_H_
+
+#include <stdbool.h>
+#include "../../SPPoint.h"
+#include "../bpqueue_ds/SPBPriorityQueue.h"
+
+/**
+ * SP Brute Force Index summary
+ *
+ * An exact nearest neighbours index that scans the whole database. The descriptors are
+ * kept as one contiguous row-major matrix, at the storage precision of the indexed
+ * points, together with their squared norms, so the distance of a query q to a row x is
+ * computed as ||q||^2 + ||x||^2 - 2 * q.x and the scan is a sequence of dot products
+ * (accumulated in double).
+ *
+ * The scan is cache blocked: a block of queries is scored against a block of database
+ * rows at a time (as a small matrix product), so every row that is loaded is used by
+ * all the queries of the block. Each query keeps its k best rows in a bounded heap, and
+ * the database blocks can be split between several threads, each with its own heaps.
+ * The distances of the final k rows of each query are recomputed directly, so the
+ * results hold the same distances as the KD-tree search.
+ *
+ * Since it is exact, the index also serves as the ground truth of the approximate
+ * indices.
+ *
+ * The following functions are supported:
+ *
+ * spBruteForceIndexCreate		- Copies the given points into the index
+ * spBruteForceIndexAddPoints	- Appends more points to the index
+ * spBruteForceIndexKNN			- Finds the k nearest neighbours of a query point
+ * spBruteForceIndexKNNBatch	- Finds the k nearest neighbours of several query points
+ * spBruteForceIndexDestroy		- Frees all the resources of the index
+ */
+
+/** Type for defining the brute force index **/
+typedef struct sp_brute_force_index_t* SPBruteForceIndex;
+
+/*
+ * The method creates a new brute force index from the given points.
+ * The index takes ownership of the points: their coordinates are copied into the
+ * database matrix and the points are destroyed (on failure the points are not destroyed).
+ *
+ * @param pointsArray - the database descriptors (all at the same dimension), the matrix
+ * 		  is stored at the precision of the first point
+ * @param size - the size of pointsArray
+ * @param numOfThreads - the number of threads that scan the database, at least 1
+ *
+ * @returns
+ * NULL in case of invalid arguments or memory allocation error,
+ * otherwise the new index
+ *
+ * @logger - the method logs allocation and arguments errors if needed
+ */
+SPBruteForceIndex spBruteForceIndexCreate(SPPoint* pointsArray, int size,
+		int numOfThreads);
+
+/*
+ * The method appends the given points to the database matrix, they are searched by
+ * the following queries. The matrix grows geometrically, so adding points in small
+ * groups is amortized linear.
+ * The index takes ownership of the points as spBruteForceIndexCreate does.
+ *
+ * @param index - the index to add the points to
+ * @param pointsArray - the new descriptors, at the dimension of the index
+ * @param size - the size of pointsArray
+ *
+ * @returns false in case of invalid arguments or memory allocation error (the index is
+ * not changed), true otherwise
+ *
+ * @logger - the method logs allocation and arguments errors if needed
+ */
+bool spBruteForceIndexAddPoints(SPBruteForceIndex index, SPPoint* pointsArray,
+		int size);
+
+/*
+ * The method finds the nearest neighbours of the query point, and enqueues their image
+ * indices and squared distances into bpq, as kNearestNeighbors does for the KD-tree.
+ *
+ * @param index - the index to search
+ * @param bpq - the queue that is filled with the nearest neighbours, its capacity is k
+ * @param queryPoint - the query point
+ *
+ * @returns false in case of invalid arguments or memory allocation error, true otherwise
+ *
+ * @logger - the method logs allocation and arguments errors if needed
+ */
+bool spBruteForceIndexKNN(SPBruteForceIndex index, SPBPQueue bpq, SPPoint queryPoint);
+
+/*
+ * The method finds the nearest neighbours of every query point in a single scan of the
+ * database, the neighbours of queryPoints[i] are enqueued into bpqs[i].
+ *
+ * @param index - the index to search
+ * @param bpqs - numOfQueries queues, the capacity of each queue is its k
+ * @param queryPoints - the query points
+ * @param numOfQueries - the size of bpqs and of queryPoints
+ *
+ * @returns false in case of invalid arguments or memory allocation error, true otherwise
+ *
+ * @logger - the method logs allocation and arguments errors if needed
+ */
+bool spBruteForceIndexKNNBatch(SPBruteForceIndex index, SPBPQueue* bpqs,
+		SPPoint* queryPoints, int numOfQueries);
+
+/*
+ * Frees all the resources of the index.
+ * If index is NULL nothing happens.
+ */
+void spBruteForceIndexDestroy(SPBruteForceIndex index);
+
+#endif /* SPBRUTEFORCEINDEX_H_ */
@@ -0,0 +1,1122 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include "SPHNSWIndex.h"
+#include "../../general_utils/SPUtils.h"
+
+#define HNSW_FILE_MAGIC								"SPHNSW02"
+#define HNSW_FILE_MAGIC_LENGTH						8
+#define HNSW_WRITE_FILE_MODE						"wb"
+#define HNSW_READ_FILE_MODE							"rb"
+#define HNSW_MAX_LEVEL								16
+#define HNSW_RANDOM_SEED							2654435769u
+#define HNSW_INSERT_CHUNK							64 // nodes a build thread takes at once
+
+#define ERROR_CREATING_HNSW_INDEX					"Could not create the HNSW index"
+#define ERROR_BUILDING_HNSW_GRAPH					"Could not build the HNSW graph"
+#define ERROR_ADDING_HNSW_POINTS					"Could not add the points to the HNSW index"
+#define ERROR_LOADING_HNSW_INDEX					"Could not load the HNSW index"
+#define ERROR_SAVING_HNSW_INDEX						"Could not save the HNSW index"
+#define ERROR_HNSW_KNN								"HNSW k-NN search failed"
+
+#define WARNING_HNSW_FILE_NOT_LOADED				"The HNSW index file could not be used, the index is rebuilt"
+#define WARNING_HNSW_FILE_NOT_SAVED					"The HNSW index file could not be written"
+#define WARNING_HNSW_THREADS_NOT_CREATED			"Not all the HNSW build threads could be created"
+
+#define DEBUG_HNSW_GRAPH_BUILT						"HNSW graph built, max level:"
+#define DEBUG_HNSW_INDEX_LOADED						"HNSW index loaded from file"
+
+/*
+ * The header of a saved index, following the magic string
+ */
+typedef enum hnsw_header_field_t {
+	HNSW_HEADER_SIZE,
+	HNSW_HEADER_DIM,
+	HNSW_HEADER_M,
+	HNSW_HEADER_EF_CONSTRUCTION,
+	HNSW_HEADER_MAX_LEVEL,
+	HNSW_HEADER_ENTRY_POINT,
+	HNSW_HEADER_PRECISION,
+	HNSW_HEADER_FIELDS_COUNT
+} HNSW_HEADER_FIELD;
+
+/*
+ * A node and its distance to the vector that is searched
+ */
+typedef struct hnsw_candidate_t {
+	double distance;
+	int id;
+} HNSWCandidate;
+
+/*
+ * A binary heap of candidates, the top is the nearest candidate (min heap)
+ * or the farthest candidate (max heap)
+ */
+typedef struct hnsw_heap_t {
+	HNSWCandidate* items;
+	int size;
+	int capacity;
+	bool isMax;
+} HNSWHeap;
+
+/*
+ * The working memory of a single search, used by one thread at a time
+ * visited - node i was visited by the current search iff visited[i] == visitTag
+ * candidates - the nodes that are yet to be expanded (min heap)
+ * results - the ef nearest nodes found so far (max heap)
+ * neighbors - a copy of the links of the node that is expanded
+ * selection - the candidates of a neighbours selection (maxM0 + 1 entries)
+ * selected - the result of a neighbours selection (maxM0 + 1 entries)
+ * vector - the coordinates of the searched vector (the query or the inserted node)
+ * linkedVector - the coordinates of the node whose links are selected again
+ * candidateVector - the coordinates of the candidate of a neighbours selection
+ * next - the next free working memory of the index
+ */
+typedef struct hnsw_context_t {
+	unsigned int* visited;
+	unsigned int visitTag;
+	HNSWHeap candidates;
+	HNSWHeap results;
+	int* neighbors;
+	HNSWCandidate* selection;
+	int* selected;
+	double* vector;
+	double* linkedVector;
+	double* candidateVector;
+	struct hnsw_context_t* next;
+} HNSWContext;
+
+/*
+ * A structure used for the HNSW index
+ * size, dim - the number and the dimension of the indexed descriptors
+ * M - the maximal number of links of a node at the upper layers
+ * maxM0 - the maximal number of links of a node at the bottom layer (2 * M)
+ * efConstruction, efSearch - the candidates list sizes of the insertion and the search
+ * maxLevel, entryPoint - the top layer of the graph and its single node
+ * precision - the storage precision of the descriptors (that of the indexed points)
+ * vectors - size row-major descriptors, stored at precision
+ * imageIndices - the image index of each descriptor
+ * levels - the top layer of each node
+ * linkOffsets - the links of node i start at links[linkOffsets[i]]
+ * links - per node and per layer (bottom first) a links count followed by the links
+ * isBuilding - true while nodes are inserted, the links are locked only while building
+ * nodeLocks - guards the links of each node while building
+ * globalLock - guards maxLevel and entryPoint while building
+ * freeContexts - the search working memories that are not used by any query, a query
+ * 		takes one (or allocates one if none is free) and returns it when done, thus the
+ * 		working memories are allocated once per concurrent query
+ * freeContextsLock - guards freeContexts
+ */
+struct sp_hnsw_index_t {
+	int size;
+	int dim;
+	int M;
+	int maxM0;
+	int efConstruction;
+	int efSearch;
+	int maxLevel;
+	int entryPoint;
+	SP_POINT_PRECISION precision;
+	void* vectors;
+	int* imageIndices;
+	int* levels;
+	size_t* linkOffsets;
+	int* links;
+	bool isBuilding;
+	int numOfNodeLocks;
+	pthread_mutex_t* nodeLocks;
+	pthread_mutex_t globalLock;
+	HNSWContext* freeContexts;
+	pthread_mutex_t freeContextsLock;
+};
+
+/*
+ * A build thread data
+ */
+typedef struct hnsw_build_worker_t {
+	SPHNSWIndex index;
+	int* nextNode;
+	pthread_mutex_t* nextNodeLock;
+	bool success;
+} HNSWBuildWorker;
+
+//-------------------------------------------------heap------------------------------------------------
+
+static bool isBefore(const HNSWHeap* heap, HNSWCandidate a, HNSWCandidate b) {
+	if (a.distance != b.distance)
+		return heap->isMax ? a.distance > b.distance : a.distance < b.distance;
+	return heap->isMax ? a.id > b.id : a.id < b.id;
+}
+
+static bool heapInit(HNSWHeap* heap, int capacity, bool isMax) {
+	heap->size = 0;
+	heap->capacity = capacity;
+	heap->isMax = isMax;
+	heap->items = (HNSWCandidate*) malloc(capacity * sizeof(HNSWCandidate));
+	return heap->items != NULL;
+}
+
+static bool heapPush(HNSWHeap* heap, double distance, int id) {
+	int i, parent;
+	HNSWCandidate item, *items;
+
+	if (heap->size == heap->capacity) {
+		items = (HNSWCandidate*) realloc(heap->items,
+				2 * heap->capacity * sizeof(HNSWCandidate));
+		if (items == NULL)
+			return false;
+		heap->items = items;
+		heap->capacity *= 2;
+	}
+
+	item.distance = distance;
+	item.id = id;
+	for (i = heap->size++; i > 0; i = parent) {
+		parent = (i - 1) / 2;
+		if (!isBefore(heap, item, heap->items[parent]))
+			break;
+		heap->items[i] = heap->items[parent];
+	}
+	heap->items[i] = item;
+	return true;
+}
+
+static HNSWCandidate heapPop(HNSWHeap* heap) {
+	int i = 0, child;
+	HNSWCandidate top = heap->items[0], last = heap->items[--heap->size];
+
+	while ((child = 2 * i + 1) < heap->size) {
+		if (child + 1 < heap->size && isBefore(heap, heap->items[child + 1],
+				heap->items[child]))
+			child++;
+		if (!isBefore(heap, heap->items[child], last))
+			break;
+		heap->items[i] = heap->items[child];
+		i = child;
+	}
+	heap->items[i] = last;
+	return top;
+}
+
+static int candidateComparator(const void* first, const void* second) {
+	const HNSWCandidate* a = (const HNSWCandidate*) first;
+	const HNSWCandidate* b = (const HNSWCandidate*) second;
+	if (a->distance != b->distance)
+		return a->distance < b->distance ? -1 : 1;
+	return a->id - b->id;
+}
+
+//-----------------------------------------------context-----------------------------------------------
+
+static void destroyContext(HNSWContext* context) {
+	if (context == NULL)
+		return;
+	spFree(context->visited);
+	spFree(context->candidates.items);
+	spFree(context->results.items);
+	spFree(context->neighbors);
+	spFree(context->selection);
+	spFree(context->selected);
+	spFree(context->vector);
+	spFree(context->linkedVector);
+	spFree(context->candidateVector);
+	free(context);
+}
+
+/*
+ * Allocates a search working memory.
+ * Nothing is logged since the method runs on the build threads.
+ */
+static HNSWContext* createContext(SPHNSWIndex index) {
+	int ef = (index->efConstruction > index->efSearch ?
+			index->efConstruction : index->efSearch) + 1;
+	HNSWContext* context = (HNSWContext*) calloc(1, sizeof(HNSWContext));
+	if (context == NULL)
+		return NULL;
+
+	if ((context->visited = (unsigned int*) calloc(index->size, sizeof(unsigned int)))
+			== NULL || !heapInit(&(context->candidates), ef, false) ||
+			!heapInit(&(context->results), ef, true) ||
+			(context->neighbors = (int*) malloc(index->maxM0 * sizeof(int))) == NULL ||
+			(context->selection = (HNSWCandidate*) malloc((index->maxM0 + 1) *
+					sizeof(HNSWCandidate))) == NULL ||
+			(context->selected = (int*) malloc((index->maxM0 + 1) * sizeof(int)))
+			== NULL ||
+			(context->vector = (double*) malloc(index->dim * sizeof(double))) == NULL ||
+			(context->linkedVector = (double*) malloc(index->dim * sizeof(double)))
+			== NULL ||
+			(context->candidateVector = (double*) malloc(index->dim * sizeof(double)))
+			== NULL) {
+		destroyContext(context);
+		return NULL;
+	}
+	return context;
+}
+
+/*
+ * Takes a free working memory of the index, or allocates one if none is free
+ *
+ * @returns NULL in case of memory allocation error
+ */
+static HNSWContext* acquireContext(SPHNSWIndex index) {
+	HNSWContext* context;
+	pthread_mutex_lock(&(index->freeContextsLock));
+	context = index->freeContexts;
+	if (context != NULL)
+		index->freeContexts = context->next;
+	pthread_mutex_unlock(&(index->freeContextsLock));
+	return context != NULL ? context : createContext(index);
+}
+
+/*
+ * Returns a working memory taken by acquireContext to the free ones
+ */
+static void releaseContext(SPHNSWIndex index, HNSWContext* context) {
+	pthread_mutex_lock(&(index->freeContextsLock));
+	context->next = index->freeContexts;
+	index->freeContexts = context;
+	pthread_mutex_unlock(&(index->freeContextsLock));
+}
+
+static void startVisit(HNSWContext* context, int size) {
+	if (++(context->visitTag) == 0) { // the tags wrapped around
+		memset(context->visited, 0, size * sizeof(unsigned int));
+		context->visitTag = 1;
+	}
+}
+
+//------------------------------------------------graph------------------------------------------------
+
+static void* getRow(SPHNSWIndex index, int node) {
+	return (char*) index->vectors + (size_t) node * index->dim *
+			spPointGetCoorSize(index->precision);
+}
+
+/*
+ * Converts the stored coordinates of the node into vector (dim entries)
+ */
+static void getVector(SPHNSWIndex index, int node, double* vector) {
+	spPointRowToVector(getRow(index, node), index->dim, index->precision, vector);
+}
+
+static double getDistance(SPHNSWIndex index, const double* vector, int node) {
+	return spPointRowL2SquaredDistance(vector, getRow(index, node), index->dim,
+			index->precision);
+}
+
+/*
+ * Returns the links block of the node at the given layer, its first cell is the count
+ */
+static int* getLinks(SPHNSWIndex index, int node, int level) {
+	int* links = index->links + index->linkOffsets[node];
+	return level == 0 ? links :
+			links + (1 + index->maxM0) + (level - 1) * (1 + index->M);
+}
+
+static void lockNode(SPHNSWIndex index, int node) {
+	if (index->isBuilding)
+		pthread_mutex_lock(&(index->nodeLocks[node]));
+}
+
+static void unlockNode(SPHNSWIndex index, int node) {
+	if (index->isBuilding)
+		pthread_mutex_unlock(&(index->nodeLocks[node]));
+}
+
+/*
+ * Copies the links of the node at the given layer into buffer
+ *
+ * @returns the number of links
+ */
+static int copyLinks(SPHNSWIndex index, int node, int level, int* buffer) {
+	int count, *links;
+	lockNode(index, node);
+	links = getLinks(index, node, level);
+	count = links[0];
+	memcpy(buffer, links + 1, count * sizeof(int));
+	unlockNode(index, node);
+	return count;
+}
+
+/*
+ * Moves (*current) greedily to its nearest neighbour at the given layer until no
+ * neighbour is nearer to the vector
+ */
+static void greedySearch(SPHNSWIndex index, HNSWContext* context, const double* vector,
+		int* current, double* currentDistance, int level) {
+	int j, count;
+	double distance;
+	bool changed = true;
+
+	while (changed) {
+		changed = false;
+		count = copyLinks(index, *current, level, context->neighbors);
+		for (j = 0; j < count; j++) {
+			distance = getDistance(index, vector, context->neighbors[j]);
+			if (distance < *currentDistance) {
+				*currentDistance = distance;
+				*current = context->neighbors[j];
+				changed = true;
+			}
+		}
+	}
+}
+
+/*
+ * Best-first search at the given layer, starting at the entry node.
+ * The (up to) ef nearest nodes that were found are left at context->results.
+ *
+ * @returns false in case of memory allocation error, true otherwise
+ */
+static bool searchLayer(SPHNSWIndex index, HNSWContext* context, const double* vector,
+		int entry, double entryDistance, int ef, int level) {
+	int j, count, neighbor;
+	double distance;
+	HNSWCandidate current;
+
+	context->candidates.size = 0;
+	context->results.size = 0;
+	startVisit(context, index->size);
+	context->visited[entry] = context->visitTag;
+	if (!heapPush(&(context->candidates), entryDistance, entry) ||
+			!heapPush(&(context->results), entryDistance, entry))
+		return false;
+
+	while (context->candidates.size > 0) {
+		current = heapPop(&(context->candidates));
+		if (context->results.size >= ef &&
+				current.distance > context->results.items[0].distance)
+			break;
+
+		count = copyLinks(index, current.id, level, context->neighbors);
+		for (j = 0; j < count; j++) {
+			neighbor = context->neighbors[j];
+			if (context->visited[neighbor] == context->visitTag)
+				continue;
+			context->visited[neighbor] = context->visitTag;
+
+			distance = getDistance(index, vector, neighbor);
+			if (context->results.size < ef ||
+					distance < context->results.items[0].distance) {
+				if (!heapPush(&(context->candidates), distance, neighbor) ||
+						!heapPush(&(context->results), distance, neighbor))
+					return false;
+				if (context->results.size > ef)
+					heapPop(&(context->results));
+			}
+		}
+	}
+	return true;
+}
+
+/*
+ * The neighbours selection heuristic: a candidate (scanned from the nearest) is selected
+ * only if it is nearer to the base vector than to every node selected before it, which
+ * keeps links in diverse directions.
+ *
+ * @param candidates - the candidates sorted by their distance to the base vector
+ * @returns the number of nodes written to selected (at most maxCount)
+ */
+static int selectNeighbors(SPHNSWIndex index, HNSWContext* context,
+		const HNSWCandidate* candidates, int count, int maxCount, int* selected) {
+	int i, j, numOfSelected = 0;
+	bool isDiverse;
+
+	for (i = 0; i < count && numOfSelected < maxCount; i++) {
+		isDiverse = true;
+		if (numOfSelected > 0)
+			getVector(index, candidates[i].id, context->candidateVector);
+		for (j = 0; j < numOfSelected && isDiverse; j++)
+			isDiverse = getDistance(index, context->candidateVector,
+					selected[j]) >= candidates[i].distance;
+		if (isDiverse)
+			selected[numOfSelected++] = candidates[i].id;
+	}
+	return numOfSelected;
+}
+
+/*
+ * Adds a link from node to newNode at the given layer, if the node is full its links
+ * are re-selected out of its current links and newNode
+ */
+static void addLink(SPHNSWIndex index, HNSWContext* context, int node, int newNode,
+		int level) {
+	int j, *links, capacity = level == 0 ? index->maxM0 : index->M;
+	double* vector = context->linkedVector;
+
+	lockNode(index, node);
+	links = getLinks(index, node, level);
+	if (links[0] < capacity) {
+		links[1 + links[0]] = newNode;
+		links[0]++;
+	}
+	else {
+		getVector(index, node, vector);
+		for (j = 0; j < capacity; j++) {
+			context->selection[j].id = links[1 + j];
+			context->selection[j].distance = getDistance(index, vector, links[1 + j]);
+		}
+		context->selection[capacity].id = newNode;
+		context->selection[capacity].distance = getDistance(index, vector, newNode);
+		qsort(context->selection, capacity + 1, sizeof(HNSWCandidate),
+				candidateComparator);
+		links[0] = selectNeighbors(index, context, context->selection, capacity + 1,
+				capacity, links + 1);
+	}
+	unlockNode(index, node);
+}
+
+/*
+ * Inserts the node into the graph
+ *
+ * @returns false in case of memory allocation error, true otherwise
+ */
+static bool insertNode(SPHNSWIndex index, HNSWContext* context, int node) {
+	int l, j, count, *links, entry, maxLevel, level = index->levels[node];
+	double entryDistance;
+	double* vector = context->vector;
+
+	pthread_mutex_lock(&(index->globalLock));
+	entry = index->entryPoint;
+	maxLevel = index->maxLevel;
+	pthread_mutex_unlock(&(index->globalLock));
+
+	if (entry == node)
+		return true;
+
+	getVector(index, node, vector);
+	entryDistance = getDistance(index, vector, entry);
+	for (l = maxLevel; l > level; l--)
+		greedySearch(index, context, vector, &entry, &entryDistance, l);
+
+	for (l = level < maxLevel ? level : maxLevel; l >= 0; l--) {
+		if (!searchLayer(index, context, vector, entry, entryDistance,
+				index->efConstruction, l))
+			return false;
+
+		// the results are no longer needed as a heap
+		qsort(context->results.items, context->results.size, sizeof(HNSWCandidate),
+				candidateComparator);
+		entry = context->results.items[0].id;
+		entryDistance = context->results.items[0].distance;
+		count = selectNeighbors(index, context, context->results.items,
+				context->results.size, index->M, context->selected);
+
+		lockNode(index, node);
+		links = getLinks(index, node, l);
+		memcpy(links + 1, context->selected, count * sizeof(int));
+		links[0] = count;
+		unlockNode(index, node);
+
+		for (j = 0; j < count; j++)
+			addLink(index, context, context->selected[j], node, l);
+	}
+
+	if (level > maxLevel) {
+		pthread_mutex_lock(&(index->globalLock));
+		if (level > index->maxLevel) {
+			index->maxLevel = level;
+			index->entryPoint = node;
+		}
+		pthread_mutex_unlock(&(index->globalLock));
+	}
+	return true;
+}
+
+/*
+ * A build thread, inserts chunks of consecutive nodes until all nodes are taken
+ */
+static void* insertNodesWorker(void* data) {
+	int i, first, last;
+	HNSWBuildWorker* worker = (HNSWBuildWorker*) data;
+	SPHNSWIndex index = worker->index;
+	HNSWContext* context = createContext(index);
+
+	worker->success = context != NULL;
+	while (worker->success) {
+		pthread_mutex_lock(worker->nextNodeLock);
+		first = *(worker->nextNode);
+		*(worker->nextNode) += HNSW_INSERT_CHUNK;
+		pthread_mutex_unlock(worker->nextNodeLock);
+
+		if (first >= index->size)
+			break;
+		last = first + HNSW_INSERT_CHUNK < index->size ? first + HNSW_INSERT_CHUNK :
+				index->size;
+		for (i = first; i < last && worker->success; i++)
+			worker->success = insertNode(index, context, i);
+	}
+
+	destroyContext(context);
+	return NULL;
+}
+
+/*
+ * Links the node again at the bottom layer from the nodes that a sequential insertion
+ * into the complete graph would have linked it from
+ *
+ * @returns false in case of memory allocation error, true otherwise
+ */
+static bool relinkNode(SPHNSWIndex index, HNSWContext* context, int node) {
+	int l, j, count, entry = index->entryPoint;
+	double entryDistance, *vector = context->vector;
+
+	getVector(index, node, vector);
+	entryDistance = getDistance(index, vector, entry);
+
+	for (l = index->maxLevel; l > 0; l--)
+		greedySearch(index, context, vector, &entry, &entryDistance, l);
+	if (!searchLayer(index, context, vector, entry, entryDistance,
+			index->efConstruction, 0))
+		return false;
+
+	qsort(context->results.items, context->results.size, sizeof(HNSWCandidate),
+			candidateComparator);
+	count = selectNeighbors(index, context, context->results.items,
+			context->results.size, index->M, context->selected);
+	for (j = 0; j < count; j++)
+		addLink(index, context, context->selected[j], node, 0);
+	return true;
+}
+
+/*
+ * Parallel insertions may leave a node without incoming links at the bottom layer: two
+ * close nodes that are inserted together do not find each other, and their common
+ * neighbours keep only one of them. Such a node can not be reached by any search, thus
+ * every node that is unreachable from the entry point is linked again.
+ * Runs on the calling thread after the build threads were joined.
+ *
+ * @returns false in case of memory allocation error, true otherwise
+ */
+static bool linkUnreachableNodes(SPHNSWIndex index) {
+	int i, j, head = 0, tail = 0, *links, *queue = NULL;
+	bool success = true, *isReachable = NULL;
+	HNSWContext* context = index->freeContexts; // allocated with the graph
+
+	spCallocWr(queue, int, index->size, false);
+	spCallocErWcRCb(isReachable, bool, index->size, ERROR_BUILDING_HNSW_GRAPH,
+			free(queue), false);
+
+	// breadth first search over the bottom layer
+	queue[tail++] = index->entryPoint;
+	isReachable[index->entryPoint] = true;
+	while (head < tail) {
+		links = getLinks(index, queue[head++], 0);
+		for (j = 1; j <= links[0]; j++) {
+			if (!isReachable[links[j]]) {
+				isReachable[links[j]] = true;
+				queue[tail++] = links[j];
+			}
+		}
+	}
+
+	for (i = 0; i < index->size && success; i++) {
+		if (!isReachable[i])
+			success = relinkNode(index, context, i);
+	}
+
+	free(queue);
+	free(isReachable);
+	return success;
+}
+
+/*
+ * Inserts all the nodes, the calling thread is one of the numOfThreads build threads
+ *
+ * @returns false in case of memory allocation error, true otherwise
+ */
+static bool buildGraph(SPHNSWIndex index, int numOfThreads) {
+	int t, numOfCreated = 0, nextNode = 1;
+	bool success = true;
+	pthread_t* threads = NULL;
+	HNSWBuildWorker* workers = NULL;
+	pthread_mutex_t nextNodeLock;
+
+	spCallocWr(workers, HNSWBuildWorker, numOfThreads, false);
+	spCallocErWcRCb(threads, pthread_t, numOfThreads, ERROR_BUILDING_HNSW_GRAPH,
+			free(workers), false);
+	pthread_mutex_init(&nextNodeLock, NULL);
+
+	index->entryPoint = 0;
+	index->maxLevel = index->levels[0];
+	index->isBuilding = true;
+
+	for (t = 0; t < numOfThreads; t++) {
+		workers[t].index = index;
+		workers[t].nextNode = &nextNode;
+		workers[t].nextNodeLock = &nextNodeLock;
+	}
+	for (t = 1; t < numOfThreads; t++) {
+		if (pthread_create(&(threads[t]), NULL, insertNodesWorker, &(workers[t])) != 0)
+			break;
+		numOfCreated++;
+	}
+	insertNodesWorker(&(workers[0]));
+	for (t = 1; t <= numOfCreated; t++)
+		pthread_join(threads[t], NULL);
+
+	index->isBuilding = false;
+	if (numOfCreated < numOfThreads - 1)
+		spLoggerSafePrintWarning(WARNING_HNSW_THREADS_NOT_CREATED, __FILE__, __FUNCTION__,
+				__LINE__);
+	for (t = 0; t <= numOfCreated; t++)
+		success = success && workers[t].success;
+
+	pthread_mutex_destroy(&nextNodeLock);
+	free(threads);
+	free(workers);
+	return success && (numOfCreated == 0 || linkUnreachableNodes(index));
+}
+
+//------------------------------------------------index------------------------------------------------
+
+/*
+ * Allocates an index without its graph
+ *
+ * @returns NULL in case of memory allocation error
+ */
+static SPHNSWIndex allocateIndex(int size, int dim, SP_POINT_PRECISION precision, int M,
+		int efConstruction, int efSearch) {
+	SPHNSWIndex index = NULL;
+	spCalloc(index, struct sp_hnsw_index_t, 1);
+	index->size = size;
+	index->dim = dim;
+	index->precision = precision;
+	index->M = M;
+	index->maxM0 = 2 * M;
+	index->efConstruction = efConstruction;
+	index->efSearch = efSearch;
+	pthread_mutex_init(&(index->globalLock), NULL);
+	pthread_mutex_init(&(index->freeContextsLock), NULL);
+
+	spCallocWc(index->vectors, char, (size_t) size * dim * spPointGetCoorSize(precision),
+			spHNSWIndexDestroy(index));
+	spCallocWc(index->imageIndices, int, size, spHNSWIndexDestroy(index));
+	spCallocWc(index->levels, int, size, spHNSWIndexDestroy(index));
+	return index;
+}
+
+/*
+ * Allocates the links by index->levels, the node locks and the first search working
+ * memory
+ *
+ * @returns false in case of memory allocation error, true otherwise
+ */
+static bool allocateGraph(SPHNSWIndex index) {
+	int i;
+	spCallocWr(index->linkOffsets, size_t, index->size + 1, false);
+	for (i = 0; i < index->size; i++)
+		index->linkOffsets[i + 1] = index->linkOffsets[i] + (1 + index->maxM0) +
+				index->levels[i] * (1 + index->M);
+
+	spCallocWr(index->links, int, index->linkOffsets[index->size], false);
+	spCallocWr(index->nodeLocks, pthread_mutex_t, index->size, false);
+	for (; index->numOfNodeLocks < index->size; index->numOfNodeLocks++)
+		pthread_mutex_init(&(index->nodeLocks[index->numOfNodeLocks]), NULL);
+
+	spVal((index->freeContexts = createContext(index)), ERROR_ALLOCATING_MEMORY, false);
+	return true;
+}
+
+/*
+ * Draws the top layer of a node, each layer is reached with probability 1/M
+ */
+static int drawLevel(unsigned int* state, int M) {
+	int level = 0;
+	unsigned int x;
+	do {
+		// xorshift32
+		x = *state;
+		x ^= x << 13;
+		x ^= x >> 17;
+		x ^= x << 5;
+		*state = x;
+	} while (x % M == 0 && ++level < HNSW_MAX_LEVEL);
+	return level;
+}
+
+SPHNSWIndex spHNSWIndexCreate(SPPoint* pointsArray, int size, int M, int efConstruction,
+		int efSearch, int numOfThreads) {
+	int i;
+	unsigned int randomState = HNSW_RANDOM_SEED;
+	SPHNSWIndex index = NULL;
+	spVerifyArgumentsRn(pointsArray != NULL && size > 0 && pointsArray[0] != NULL &&
+			M >= 2 && efConstruction > 0 && efSearch > 0 && numOfThreads > 0,
+			ERROR_CREATING_HNSW_INDEX);
+
+	spValRn((index = allocateIndex(size, spPointGetDimension(pointsArray[0]),
+			spPointGetPrecision(pointsArray[0]), M, efConstruction, efSearch)),
+			ERROR_CREATING_HNSW_INDEX);
+
+	for (i = 0; i < size; i++) {
+		spPointCopyToRow(pointsArray[i], getRow(index, i), index->precision);
+		index->imageIndices[i] = spPointGetIndex(pointsArray[i]);
+		index->levels[i] = drawLevel(&randomState, M);
+	}
+
+	spValWcRn(allocateGraph(index) && buildGraph(index, numOfThreads),
+			ERROR_BUILDING_HNSW_GRAPH, spHNSWIndexDestroy(index));
+
+	spLoggerSafePrintDebugWithIndex(DEBUG_HNSW_GRAPH_BUILT, index->maxLevel, __FILE__,
+			__FUNCTION__, __LINE__);
+
+	// the index replaces the original descriptors
+	for (i = 0; i < size; i++)
+		spPointDestroy(pointsArray[i]);
+	return index;
+}
+
+/*
+ * Removes the links to the nodes [firstNode, size) from the nodes [0, firstNode), which
+ * are then a valid graph by themselves
+ */
+static void unlinkNodes(SPHNSWIndex index, int firstNode) {
+	int i, l, j, count, *links;
+	for (i = 0; i < firstNode; i++) {
+		for (l = 0; l <= index->levels[i]; l++) {
+			links = getLinks(index, i, l);
+			for (j = 1, count = 0; j <= links[0]; j++) {
+				if (links[j] < firstNode)
+					links[1 + count++] = links[j];
+			}
+			links[0] = count;
+		}
+	}
+}
+
+/*
+ * Grows the index arrays to hold newSize nodes, the added nodes have no links.
+ * The arrays only grow, so the index is not changed on failure.
+ *
+ * @returns false in case of memory allocation error, true otherwise
+ */
+static bool growIndex(SPHNSWIndex index, int newSize, const int* newLevels) {
+	int i;
+	void* grown;
+	size_t rowSize = (size_t) index->dim * spPointGetCoorSize(index->precision);
+
+	if ((grown = realloc(index->vectors, newSize * rowSize)) == NULL)
+		return false;
+	index->vectors = grown;
+	if ((grown = realloc(index->imageIndices, newSize * sizeof(int))) == NULL)
+		return false;
+	index->imageIndices = (int*) grown;
+	if ((grown = realloc(index->levels, newSize * sizeof(int))) == NULL)
+		return false;
+	index->levels = (int*) grown;
+	if ((grown = realloc(index->linkOffsets, (newSize + 1) * sizeof(size_t))) == NULL)
+		return false;
+	index->linkOffsets = (size_t*) grown;
+
+	for (i = index->size; i < newSize; i++) {
+		index->levels[i] = newLevels[i - index->size];
+		index->linkOffsets[i + 1] = index->linkOffsets[i] + (1 + index->maxM0) +
+				index->levels[i] * (1 + index->M);
+	}
+	if ((grown = realloc(index->links, index->linkOffsets[newSize] * sizeof(int)))
+			== NULL)
+		return false;
+	index->links = (int*) grown;
+	memset(index->links + index->linkOffsets[index->size], 0,
+			(index->linkOffsets[newSize] - index->linkOffsets[index->size]) * sizeof(int));
+	return true;
+}
+
+bool spHNSWIndexAddPoints(SPHNSWIndex index, SPPoint* pointsArray, int size) {
+	int i, oldSize, oldMaxLevel, oldEntryPoint, *levels = NULL;
+	unsigned int randomState;
+	bool success;
+	HNSWContext *context, *staleContext;
+	spVerifyArguments(index != NULL && pointsArray != NULL && size > 0,
+			ERROR_ADDING_HNSW_POINTS, false);
+	for (i = 0; i < size; i++) {
+		spVerifyArguments(pointsArray[i] != NULL &&
+				spPointGetDimension(pointsArray[i]) == index->dim,
+				ERROR_ADDING_HNSW_POINTS, false);
+	}
+
+	// the levels of the added nodes are drawn by their own stream
+	randomState = HNSW_RANDOM_SEED ^ (unsigned int) index->size;
+	spCallocWr(levels, int, size, false);
+	for (i = 0; i < size; i++)
+		levels[i] = drawLevel(&randomState, index->M);
+	success = growIndex(index, index->size + size, levels);
+	free(levels);
+	spVal(success, ERROR_ADDING_HNSW_POINTS, false);
+
+	// the working memories are sized by the number of nodes
+	oldSize = index->size;
+	index->size += size;
+	if ((context = createContext(index)) == NULL) {
+		index->size = oldSize;
+		spLoggerSafePrintError(ERROR_ADDING_HNSW_POINTS, __FILE__, __FUNCTION__, __LINE__);
+		return false;
+	}
+	while ((staleContext = index->freeContexts) != NULL) {
+		index->freeContexts = staleContext->next;
+		destroyContext(staleContext);
+	}
+
+	for (i = 0; i < size; i++) {
+		spPointCopyToRow(pointsArray[i], getRow(index, oldSize + i), index->precision);
+		index->imageIndices[oldSize + i] = spPointGetIndex(pointsArray[i]);
+	}
+
+	// the nodes are inserted one after the other, as by a single build thread
+	oldMaxLevel = index->maxLevel;
+	oldEntryPoint = index->entryPoint;
+	for (i = oldSize, success = true; i < index->size && success; i++)
+		success = insertNode(index, context, i);
+	releaseContext(index, context);
+
+	if (!success) {
+		unlinkNodes(index, oldSize);
+		index->size = oldSize;
+		index->maxLevel = oldMaxLevel;
+		index->entryPoint = oldEntryPoint;
+		spLoggerSafePrintError(ERROR_ADDING_HNSW_POINTS, __FILE__, __FUNCTION__, __LINE__);
+		return false;
+	}
+
+	// the index replaces the original descriptors
+	for (i = 0; i < size; i++)
+		spPointDestroy(pointsArray[i]);
+	return true;
+}
+
+//---------------------------------------------persistence---------------------------------------------
+
+bool spHNSWIndexSave(SPHNSWIndex index, const char* path) {
+	FILE* file = NULL;
+	int header[HNSW_HEADER_FIELDS_COUNT];
+	size_t numOfCoordinates, numOfLinks;
+	bool success;
+	spVerifyArguments(index != NULL && path != NULL, ERROR_SAVING_HNSW_INDEX, false);
+
+	header[HNSW_HEADER_SIZE] = index->size;
+	header[HNSW_HEADER_DIM] = index->dim;
+	header[HNSW_HEADER_M] = index->M;
+	header[HNSW_HEADER_EF_CONSTRUCTION] = index->efConstruction;
+	header[HNSW_HEADER_MAX_LEVEL] = index->maxLevel;
+	header[HNSW_HEADER_ENTRY_POINT] = index->entryPoint;
+	header[HNSW_HEADER_PRECISION] = index->precision;
+	numOfCoordinates = (size_t) index->size * index->dim;
+	numOfLinks = index->linkOffsets[index->size];
+
+	spValNc((file = fopen(path, HNSW_WRITE_FILE_MODE)) != NULL,
+			WARNING_HNSW_FILE_NOT_SAVED, false);
+
+	success = fwrite(HNSW_FILE_MAGIC, 1, HNSW_FILE_MAGIC_LENGTH, file)
+			== HNSW_FILE_MAGIC_LENGTH &&
+			fwrite(header, sizeof(int), HNSW_HEADER_FIELDS_COUNT, file)
+			== HNSW_HEADER_FIELDS_COUNT &&
+			fwrite(index->vectors, spPointGetCoorSize(index->precision), numOfCoordinates,
+					file)
+			== numOfCoordinates &&
+			fwrite(index->imageIndices, sizeof(int), index->size, file)
+			== (size_t) index->size &&
+			fwrite(index->levels, sizeof(int), index->size, file) == (size_t) index->size &&
+			fwrite(index->links, sizeof(int), numOfLinks, file) == numOfLinks;
+	success = fclose(file) == 0 && success;
+
+	spValWcNc(success, WARNING_HNSW_FILE_NOT_SAVED, remove(path), false);
+	return true;
+}
+
+/*
+ * Returns true iff the header describes a valid graph over the given points, built with
+ * the given parameters
+ */
+static bool isValidHeader(const int* header, SPPoint* pointsArray, int size, int M,
+		int efConstruction) {
+	return header[HNSW_HEADER_SIZE] == size &&
+			header[HNSW_HEADER_DIM] == spPointGetDimension(pointsArray[0]) &&
+			header[HNSW_HEADER_M] == M &&
+			header[HNSW_HEADER_EF_CONSTRUCTION] == efConstruction &&
+			header[HNSW_HEADER_MAX_LEVEL] >= 0 &&
+			header[HNSW_HEADER_MAX_LEVEL] < HNSW_MAX_LEVEL &&
+			header[HNSW_HEADER_ENTRY_POINT] >= 0 &&
+			header[HNSW_HEADER_ENTRY_POINT] < size &&
+			header[HNSW_HEADER_PRECISION] == (int) spPointGetPrecision(pointsArray[0]);
+}
+
+/*
+ * Returns true iff the index descriptors are exactly the given points (at the index
+ * precision)
+ */
+static bool isMatchingPoints(SPHNSWIndex index, SPPoint* pointsArray) {
+	int i, j;
+	double coordinate;
+	size_t coorSize = spPointGetCoorSize(index->precision);
+	for (i = 0; i < index->size; i++) {
+		if (pointsArray[i] == NULL ||
+				spPointGetDimension(pointsArray[i]) != index->dim ||
+				spPointGetPrecision(pointsArray[i]) != index->precision ||
+				spPointGetIndex(pointsArray[i]) != index->imageIndices[i] ||
+				index->levels[i] < 0 || index->levels[i] >= HNSW_MAX_LEVEL)
+			return false;
+		for (j = 0; j < index->dim; j++) {
+			spPointRowToVector((char*) getRow(index, i) + j * coorSize, 1,
+					index->precision, &coordinate);
+			if (spPointGetAxisCoor(pointsArray[i], j) != coordinate)
+				return false;
+		}
+	}
+	return true;
+}
+
+/*
+ * Returns true iff all the links counts and targets are in range
+ */
+static bool isValidGraph(SPHNSWIndex index) {
+	int i, l, j, *links;
+	for (i = 0; i < index->size; i++) {
+		for (l = 0; l <= index->levels[i]; l++) {
+			links = getLinks(index, i, l);
+			if (links[0] < 0 || links[0] > (l == 0 ? index->maxM0 : index->M))
+				return false;
+			for (j = 1; j <= links[0]; j++) {
+				if (links[j] < 0 || links[j] >= index->size || index->levels[links[j]] < l)
+					return false;
+			}
+		}
+	}
+	return index->levels[index->entryPoint] == index->maxLevel;
+}
+
+/*
+ * Reads a saved index of the given points and parameters from the file
+ *
+ * @returns NULL if the file does not hold a valid index of the given points and
+ * parameters or in case of memory allocation error
+ */
+static SPHNSWIndex readIndex(FILE* file, SPPoint* pointsArray, int size, int M,
+		int efConstruction, int efSearch) {
+	char magic[HNSW_FILE_MAGIC_LENGTH];
+	int header[HNSW_HEADER_FIELDS_COUNT];
+	size_t numOfCoordinates;
+	SPHNSWIndex index;
+
+	if (fread(magic, 1, HNSW_FILE_MAGIC_LENGTH, file) != HNSW_FILE_MAGIC_LENGTH ||
+			memcmp(magic, HNSW_FILE_MAGIC, HNSW_FILE_MAGIC_LENGTH) != 0 ||
+			fread(header, sizeof(int), HNSW_HEADER_FIELDS_COUNT, file)
+			!= HNSW_HEADER_FIELDS_COUNT ||
+			!isValidHeader(header, pointsArray, size, M, efConstruction))
+		return NULL;
+
+	if ((index = allocateIndex(size, header[HNSW_HEADER_DIM],
+			(SP_POINT_PRECISION) header[HNSW_HEADER_PRECISION], header[HNSW_HEADER_M],
+			header[HNSW_HEADER_EF_CONSTRUCTION], efSearch)) == NULL)
+		return NULL;
+	index->maxLevel = header[HNSW_HEADER_MAX_LEVEL];
+	index->entryPoint = header[HNSW_HEADER_ENTRY_POINT];
+	numOfCoordinates = (size_t) size * index->dim;
+
+	if (fread(index->vectors, spPointGetCoorSize(index->precision), numOfCoordinates,
+			file) != numOfCoordinates || fread(index->imageIndices, sizeof(int), size, file) != (size_t) size ||
+			fread(index->levels, sizeof(int), size, file) != (size_t) size ||
+			!isMatchingPoints(index, pointsArray) || !allocateGraph(index) ||
+			fread(index->links, sizeof(int), index->linkOffsets[size], file)
+			!= index->linkOffsets[size] || !isValidGraph(index)) {
+		spHNSWIndexDestroy(index);
+		return NULL;
+	}
+	return index;
+}
+
+SPHNSWIndex spHNSWIndexLoad(const char* path, SPPoint* pointsArray, int size, int M,
+		int efConstruction, int efSearch) {
+	int i;
+	FILE* file = NULL;
+	SPHNSWIndex index = NULL;
+	spVerifyArgumentsRn(path != NULL && pointsArray != NULL && size > 0 &&
+			pointsArray[0] != NULL && M >= 2 && efConstruction > 0 && efSearch > 0,
+			ERROR_LOADING_HNSW_INDEX);
+
+	spValWcRnNc((file = fopen(path, HNSW_READ_FILE_MODE)) != NULL,
+			WARNING_HNSW_FILE_NOT_LOADED, (void) 0);
+
+	index = readIndex(file, pointsArray, size, M, efConstruction, efSearch);
+	fclose(file);
+	spValWcRnNc(index != NULL, WARNING_HNSW_FILE_NOT_LOADED, (void) 0);
+
+	spLoggerSafePrintDebug(DEBUG_HNSW_INDEX_LOADED, __FILE__, __FUNCTION__, __LINE__);
+
+	// the index replaces the original descriptors
+	for (i = 0; i < size; i++)
+		spPointDestroy(pointsArray[i]);
+	return index;
+}
+
+//-----------------------------------------------search------------------------------------------------
+
+/*
+ * Searches the graph and enqueues the results into bpq
+ *
+ * @returns false in case of memory allocation error, true otherwise
+ */
+static bool searchKNN(SPHNSWIndex index, HNSWContext* context, const double* vector,
+		SPBPQueue bpq) {
+	int l, i, entry = index->entryPoint, k = spBPQueueGetMaxSize(bpq);
+	double distance, entryDistance = getDistance(index, vector, entry);
+	SP_BPQUEUE_MSG msg;
+
+	for (l = index->maxLevel; l > 0; l--)
+		greedySearch(index, context, vector, &entry, &entryDistance, l);
+
+	if (!searchLayer(index, context, vector, entry, entryDistance,
+			index->efSearch > k ? index->efSearch : k, 0))
+		return false;
+
+	for (i = 0; i < context->results.size; i++) {
+		distance = context->results.items[i].distance;
+		if (distance <= epsilon) // same precision rule as the KD-tree search
+			distance = 0;
+		msg = spBPQueueEnqueueValues(bpq,
+				index->imageIndices[context->results.items[i].id], distance);
+		if (msg != SP_BPQUEUE_SUCCESS && msg != SP_BPQUEUE_FULL)
+			return false;
+	}
+	return true;
+}
+
+bool spHNSWIndexKNN(SPHNSWIndex index, SPBPQueue bpq, SPPoint queryPoint) {
+	int j;
+	bool success;
+	HNSWContext* context;
+	spVerifyArguments(index != NULL && bpq != NULL && queryPoint != NULL &&
+			spPointGetDimension(queryPoint) == index->dim, ERROR_HNSW_KNN, false);
+
+	spVal((context = acquireContext(index)), ERROR_HNSW_KNN, false);
+	for (j = 0; j < index->dim; j++)
+		context->vector[j] = spPointGetAxisCoor(queryPoint, j);
+
+	success = searchKNN(index, context, context->vector, bpq);
+	releaseContext(index, context);
+
+	spVal(success, ERROR_HNSW_KNN, false);
+	return true;
+}
+
+void spHNSWIndexDestroy(SPHNSWIndex index) {
+	int i;
+	HNSWContext* context;
+	if (index == NULL)
+		return;
+	while ((context = index->freeContexts) != NULL) {
+		index->freeContexts = context->next;
+		destroyContext(context);
+	}
+	for (i = 0; i < index->numOfNodeLocks; i++)
+		pthread_mutex_destroy(&(index->nodeLocks[i]));
+	pthread_mutex_destroy(&(index->globalLock));
+	pthread_mutex_destroy(&(index->freeContextsLock));
+	spFree(index->nodeLocks);
+	spFree(index->vectors);
+	spFree(index->imageIndices);
+	spFree(index->levels);
+	spFree(index->linkOffsets);
+	spFree(index->links);
+	free(index);
+}
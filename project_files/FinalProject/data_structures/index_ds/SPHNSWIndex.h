@@ -0,0 +1,131 @@
+#ifndef SPHNSWINDEX_H_
+#define SPHNSWINDEX_H_
+
+#include <stdbool.h>
+#include "../../SPPoint.h"
+#include "../bpqueue_ds/SPBPriorityQueue.h"
+
+/**
+ * SP Hierarchical Navigable Small World Index summary
+ *
+ * An approximate nearest neighbours graph index. Every descriptor is a node which is
+ * assigned a random top layer (the number of nodes decays exponentially per layer), and
+ * is linked to up to 'M' close nodes at each of its layers (2 * M at the bottom layer).
+ * A search descends greedily from the single entry point through the upper layers,
+ * and runs a best-first search with a candidates list of size 'ef' at the bottom layer.
+ *
+ * The insertion of the nodes may be split between several threads, each node holds its
+ * own lock thus the threads only wait for each other when linking the same nodes.
+ * The graph can be saved to a file and loaded back instead of being rebuilt.
+ *
+ * The following functions are supported:
+ *
+ * spHNSWIndexCreate	- Builds the graph from the given points
+ * spHNSWIndexAddPoints	- Inserts more nodes into the graph
+ * spHNSWIndexLoad		- Loads a graph that was saved for the given points
+ * spHNSWIndexSave		- Saves the graph to a file
+ * spHNSWIndexKNN		- Finds the k nearest neighbours of a query point
+ * spHNSWIndexDestroy	- Frees all the resources of the index
+ */
+
+/** Type for defining the HNSW index **/
+typedef struct sp_hnsw_index_t* SPHNSWIndex;
+
+/*
+ * The method builds a new HNSW index from the given points.
+ * The index takes ownership of the points: their coordinates are copied into the index
+ * and the points are destroyed (on failure the points are not destroyed).
+ *
+ * @param pointsArray - the database descriptors (all at the same dimension), they are
+ * 		  stored at the precision of the first point
+ * @param size - the size of pointsArray
+ * @param M - the number of links per node at the upper layers, M >= 2
+ * @param efConstruction - the size of the candidates list used while inserting
+ * @param efSearch - the size of the candidates list used while searching
+ * @param numOfThreads - the number of threads that insert the nodes
+ *
+ * @returns
+ * NULL in case of invalid arguments, memory allocation error or thread creation error,
+ * otherwise the new index
+ *
+ * @logger - the method logs allocation and arguments errors if needed
+ * debug prints are also printed to the logger
+ */
+SPHNSWIndex spHNSWIndexCreate(SPPoint* pointsArray, int size, int M, int efConstruction,
+		int efSearch, int numOfThreads);
+
+/*
+ * The method inserts the given points into the graph, one after the other, with the M
+ * and efConstruction the index was built with. It must not run concurrently with a
+ * search of the index.
+ * The index takes ownership of the points as spHNSWIndexCreate does.
+ *
+ * @param index - the index to add the points to
+ * @param pointsArray - the new descriptors, at the dimension of the index
+ * @param size - the size of pointsArray
+ *
+ * @returns false in case of invalid arguments or memory allocation error (the points
+ * are not added, though the nodes of the index may be left with fewer links), true
+ * otherwise
+ *
+ * @logger - the method logs allocation and arguments errors if needed
+ */
+bool spHNSWIndexAddPoints(SPHNSWIndex index, SPPoint* pointsArray, int size);
+
+/*
+ * The method loads an index that was saved by spHNSWIndexSave. The index is accepted
+ * only if it was built from exactly the given points (same order, coordinates and
+ * storage precision) with the given M and efConstruction, in which case it takes
+ * ownership of the points and destroys them.
+ *
+ * @param path - the path of the saved index
+ * @param pointsArray - the database descriptors
+ * @param size - the size of pointsArray
+ * @param M - the number of links the graph should have been built with
+ * @param efConstruction - the candidates list size the graph should have been built with
+ * @param efSearch - the size of the candidates list used while searching
+ *
+ * @returns
+ * NULL if the file could not be read, or it does not match the given points, or in case
+ * of memory allocation error, otherwise the loaded index
+ *
+ * @logger - the method logs a warning if the file could not be used
+ */
+SPHNSWIndex spHNSWIndexLoad(const char* path, SPPoint* pointsArray, int size, int M,
+		int efConstruction, int efSearch);
+
+/*
+ * The method saves the index to the given path (an existing file is replaced).
+ *
+ * @param index - the index to save
+ * @param path - the path of the file
+ *
+ * @returns false in case of invalid arguments or a file writing error, true otherwise
+ *
+ * @logger - the method logs a warning if the file could not be written
+ */
+bool spHNSWIndexSave(SPHNSWIndex index, const char* path);
+
+/*
+ * The method finds the (approximate) nearest neighbours of the query point, and
+ * enqueues their image indices and squared distances into bpq,
+ * as kNearestNeighbors does for the KD-tree.
+ * The method may be called concurrently on the same index.
+ *
+ * @param index - the index to search
+ * @param bpq - the queue that is filled with the nearest neighbours, its capacity is k
+ * @param queryPoint - the query point
+ *
+ * @returns false in case of invalid arguments or memory allocation error, true otherwise
+ *
+ * @logger - the method logs allocation and arguments errors if needed
+ */
+bool spHNSWIndexKNN(SPHNSWIndex index, SPBPQueue bpq, SPPoint queryPoint);
+
+/*
+ * Frees all the resources of the index.
+ * If index is NULL nothing happens.
+ */
+void spHNSWIndexDestroy(SPHNSWIndex index);
+
+#endif /* SPHNSWINDEX_H_ */
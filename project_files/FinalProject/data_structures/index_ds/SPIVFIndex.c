@@ -0,0 +1,264 @@
+#include <stdlib.h>
+#include <string.h>
+#include "SPIVFIndex.h"
+#include "SPKMeans.h"
+#include "../../general_utils/SPUtils.h"
+
+#define IVF_KMEANS_ITERATIONS						15
+
+#define ERROR_CREATING_IVF_INDEX					"Could not create the inverted file index"
+#define ERROR_ADDING_IVF_POINTS						"Could not add the points to the inverted file index"
+#define ERROR_TRAINING_IVF_QUANTIZER				"Could not train the inverted file coarse quantizer"
+#define ERROR_IVF_KNN								"Inverted file k-NN search failed"
+
+#define DEBUG_IVF_QUANTIZER_TRAINED					"Inverted file coarse quantizer trained"
+#define DEBUG_IVF_LISTS_FILLED						"Inverted file lists filled, count:"
+
+/*
+ * A structure used for the inverted file index
+ * size - the number of indexed descriptors
+ * dim - the dimension of the descriptors
+ * numOfLists - the number of coarse centroids (inverted lists)
+ * numOfProbes - the number of lists scanned per query
+ * centroids - numOfLists row-major coarse centroids
+ * listOffsets - numOfLists + 1 offsets, list l holds the descriptors at positions
+ * 				 [listOffsets[l], listOffsets[l + 1])
+ * precision - the storage precision of the descriptors (that of the indexed points)
+ * vectors - size row-major descriptors, ordered by list and stored at precision
+ * imageIndices - the image index of each descriptor, ordered by list
+ */
+struct sp_ivf_index_t {
+	int size;
+	int dim;
+	int numOfLists;
+	int numOfProbes;
+	double* centroids;
+	int* listOffsets;
+	SP_POINT_PRECISION precision;
+	void* vectors;
+	int* imageIndices;
+};
+
+/*
+ * Frees the index internal allocations
+ */
+static void freeIVFIndexData(SPIVFIndex index) {
+	spFree(index->centroids);
+	spFree(index->listOffsets);
+	spFree(index->vectors);
+	spFree(index->imageIndices);
+	free(index);
+}
+
+static void* getRow(SPIVFIndex index, int position) {
+	return (char*) index->vectors + (size_t) position * index->dim *
+			spPointGetCoorSize(index->precision);
+}
+
+/*
+ * Trains the coarse quantizer
+ *
+ * @returns false in case of memory allocation error, true otherwise
+ */
+static bool trainQuantizer(SPIVFIndex index, SPPoint* pointsArray, int size,
+		int trainingSize) {
+	int sampleSize;
+	double* sample;
+
+	spVal((sample = spKMeansSamplePoints(pointsArray, size, trainingSize, 0,
+			index->dim, &sampleSize)), ERROR_TRAINING_IVF_QUANTIZER, false);
+
+	index->centroids = spKMeansTrain(sample, sampleSize, index->dim, index->numOfLists,
+			IVF_KMEANS_ITERATIONS);
+	free(sample);
+	spVal(index->centroids != NULL, ERROR_TRAINING_IVF_QUANTIZER, false);
+
+	spLoggerSafePrintDebug(DEBUG_IVF_QUANTIZER_TRAINED, __FILE__, __FUNCTION__, __LINE__);
+	return true;
+}
+
+/*
+ * Assigns every point to its nearest centroid and lays the inverted lists out again,
+ * each list holds its descriptors followed by the points assigned to it (a counting
+ * sort by list). The index is not changed on failure.
+ *
+ * @returns false in case of memory allocation error, true otherwise
+ */
+static bool fillLists(SPIVFIndex index, SPPoint* pointsArray, int size) {
+	int i, j, l, position, count, *assignment = NULL, *listOffsets = NULL,
+			*nextPosition = NULL, *imageIndices = NULL;
+	double* buffer = NULL;
+	char* vectors = NULL;
+	size_t rowSize = (size_t) index->dim * spPointGetCoorSize(index->precision);
+	bool rslt = (assignment = (int*) calloc(size, sizeof(int))) != NULL &&
+			(buffer = (double*) calloc(index->dim, sizeof(double))) != NULL &&
+			(listOffsets = (int*) calloc(index->numOfLists + 1, sizeof(int))) != NULL &&
+			(nextPosition = (int*) calloc(index->numOfLists, sizeof(int))) != NULL &&
+			(vectors = (char*) malloc((index->size + size) * rowSize)) != NULL &&
+			(imageIndices = (int*) malloc((index->size + size) * sizeof(int))) != NULL;
+
+	for (i = 0; rslt && i < size; i++) {
+		for (j = 0; j < index->dim; j++)
+			buffer[j] = spPointGetAxisCoor(pointsArray[i], j);
+		assignment[i] = spKMeansNearestCentroid(index->centroids, index->numOfLists,
+				index->dim, buffer, NULL);
+		listOffsets[assignment[i] + 1]++;
+	}
+
+	// the current descriptors of each list are moved to its new position
+	for (l = 0; rslt && l < index->numOfLists; l++) {
+		count = index->listOffsets[l + 1] - index->listOffsets[l];
+		listOffsets[l + 1] += listOffsets[l] + count;
+		if (count > 0) {
+			memcpy(vectors + listOffsets[l] * rowSize,
+					getRow(index, index->listOffsets[l]), count * rowSize);
+			memcpy(imageIndices + listOffsets[l],
+					index->imageIndices + index->listOffsets[l], count * sizeof(int));
+		}
+		nextPosition[l] = listOffsets[l] + count;
+	}
+
+	for (i = 0; rslt && i < size; i++) {
+		position = nextPosition[assignment[i]]++;
+		spPointCopyToRow(pointsArray[i], vectors + position * rowSize, index->precision);
+		imageIndices[position] = spPointGetIndex(pointsArray[i]);
+	}
+
+	if (rslt) {
+		free(index->listOffsets);
+		free(index->vectors);
+		free(index->imageIndices);
+		index->listOffsets = listOffsets;
+		index->vectors = vectors;
+		index->imageIndices = imageIndices;
+		index->size += size;
+		listOffsets = imageIndices = NULL;
+		vectors = NULL;
+	}
+
+	free(assignment);
+	free(buffer);
+	free(listOffsets);
+	free(nextPosition);
+	free(vectors);
+	free(imageIndices);
+	spVal(rslt, ERROR_ALLOCATING_MEMORY, false);
+	spLoggerSafePrintDebugWithIndex(DEBUG_IVF_LISTS_FILLED, index->numOfLists, __FILE__,
+			__FUNCTION__, __LINE__);
+	return true;
+}
+
+SPIVFIndex spIVFIndexCreate(SPPoint* pointsArray, int size, int numOfLists,
+		int numOfProbes, int trainingSize) {
+	int i;
+	SPIVFIndex index = NULL;
+	spVerifyArgumentsRn(pointsArray != NULL && size > 0 && pointsArray[0] != NULL &&
+			numOfLists > 0 && numOfProbes > 0 && trainingSize > 0,
+			ERROR_CREATING_IVF_INDEX);
+
+	spCalloc(index, struct sp_ivf_index_t, 1);
+	index->dim = spPointGetDimension(pointsArray[0]);
+	index->numOfLists = numOfLists;
+	index->numOfProbes = numOfProbes < numOfLists ? numOfProbes : numOfLists;
+	index->precision = spPointGetPrecision(pointsArray[0]);
+
+	// the lists start empty
+	spCallocWc(index->listOffsets, int, numOfLists + 1, freeIVFIndexData(index));
+
+	spValWcRn(trainQuantizer(index, pointsArray, size, trainingSize) &&
+			fillLists(index, pointsArray, size), ERROR_CREATING_IVF_INDEX,
+			freeIVFIndexData(index));
+
+	// the inverted lists replace the original descriptors
+	for (i = 0; i < size; i++)
+		spPointDestroy(pointsArray[i]);
+
+	return index;
+}
+
+bool spIVFIndexAddPoints(SPIVFIndex index, SPPoint* pointsArray, int size) {
+	int i;
+	spVerifyArguments(index != NULL && pointsArray != NULL && size > 0,
+			ERROR_ADDING_IVF_POINTS, false);
+	for (i = 0; i < size; i++) {
+		spVerifyArguments(pointsArray[i] != NULL &&
+				spPointGetDimension(pointsArray[i]) == index->dim,
+				ERROR_ADDING_IVF_POINTS, false);
+	}
+
+	spVal(fillLists(index, pointsArray, size), ERROR_ADDING_IVF_POINTS, false);
+
+	// the inverted lists replace the original descriptors
+	for (i = 0; i < size; i++)
+		spPointDestroy(pointsArray[i]);
+	return true;
+}
+
+/*
+ * Fills 'probes' with the nearest lists to the query vector
+ *
+ * @returns false in case of memory allocation error, true otherwise
+ */
+static bool findNearestLists(SPIVFIndex index, const double* queryVector, SPBPQueue probes) {
+	int l;
+	SP_BPQUEUE_MSG msg;
+	for (l = 0; l < index->numOfLists; l++) {
+		msg = spBPQueueEnqueueValues(probes, l, spKMeansSquaredDistance(
+				index->centroids + l * index->dim, queryVector, index->dim));
+		spVal(msg == SP_BPQUEUE_SUCCESS || msg == SP_BPQUEUE_FULL, ERROR_IVF_KNN, false);
+	}
+	return true;
+}
+
+/*
+ * Scans the descriptors of list l and enqueues them into bpq
+ *
+ * @returns false in case of memory allocation error, true otherwise
+ */
+static bool scanList(SPIVFIndex index, int l, const double* queryVector, SPBPQueue bpq) {
+	int i;
+	double distance;
+	SP_BPQUEUE_MSG msg;
+	for (i = index->listOffsets[l]; i < index->listOffsets[l + 1]; i++) {
+		distance = spPointRowL2SquaredDistance(queryVector, getRow(index, i), index->dim,
+				index->precision);
+		if (distance <= epsilon) // same precision rule as the KD-tree search
+			distance = 0;
+		msg = spBPQueueEnqueueValues(bpq, index->imageIndices[i], distance);
+		spVal(msg == SP_BPQUEUE_SUCCESS || msg == SP_BPQUEUE_FULL, ERROR_IVF_KNN, false);
+	}
+	return true;
+}
+
+bool spIVFIndexKNN(SPIVFIndex index, SPBPQueue bpq, SPPoint queryPoint) {
+	int j;
+	bool rslt = true;
+	double* queryVector;
+	SPBPQueue probes = NULL;
+	spVerifyArguments(index != NULL && bpq != NULL && queryPoint != NULL &&
+			spPointGetDimension(queryPoint) == index->dim, ERROR_IVF_KNN, false);
+
+	spCallocWr(queryVector, double, index->dim, false);
+	for (j = 0; j < index->dim; j++)
+		queryVector[j] = spPointGetAxisCoor(queryPoint, j);
+
+	spValWc((probes = spBPQueueCreate(index->numOfProbes)), ERROR_IVF_KNN,
+			free(queryVector), false);
+
+	rslt = findNearestLists(index, queryVector, probes);
+	while (rslt && !spBPQueueIsEmpty(probes)) {
+		rslt = scanList(index, spBPQueueMinIndex(probes), queryVector, bpq);
+		spBPQueueDequeue(probes);
+	}
+
+	free(queryVector);
+	spBPQueueDestroy(probes);
+	spVal(rslt, ERROR_IVF_KNN, false);
+	return true;
+}
+
+void spIVFIndexDestroy(SPIVFIndex index) {
+	if (index == NULL)
+		return;
+	freeIVFIndexData(index);
+}
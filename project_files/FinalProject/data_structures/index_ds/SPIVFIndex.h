@@ -0,0 +1,90 @@
+#ifndef SPIVFINDEX_H_
+#define SPIVFINDEX_H_
+
+#include <stdbool.h>
+#include "../../SPPoint.h"
+#include "../bpqueue_ds/SPBPriorityQueue.h"
+
+/**
+ * SP Inverted File Index summary
+ *
+ * An approximate nearest neighbours index. A k-means coarse quantizer of 'numOfLists'
+ * centroids is trained (on a strided sample of the database), and every descriptor is
+ * stored in the inverted list of its nearest centroid. The descriptors of each list are
+ * kept as one contiguous block of coordinates (at the storage precision of the indexed
+ * points), so scanning a list is a linear pass over memory.
+ *
+ * A query ranks the centroids by their distance to the query point and scans only
+ * the 'numOfProbes' nearest lists.
+ *
+ * The following functions are supported:
+ *
+ * spIVFIndexCreate		- Trains the coarse quantizer and fills the inverted lists
+ * spIVFIndexAddPoints	- Adds points to the inverted lists of their nearest centroids
+ * spIVFIndexKNN		- Finds the k nearest neighbours of a query point
+ * spIVFIndexDestroy	- Frees all the resources of the index
+ */
+
+/** Type for defining the inverted file index **/
+typedef struct sp_ivf_index_t* SPIVFIndex;
+
+/*
+ * The method creates a new inverted file index from the given points.
+ * The index takes ownership of the points: their coordinates are copied into the
+ * inverted lists and the points are destroyed (on failure the points are not destroyed).
+ *
+ * @param pointsArray - the database descriptors (all at the same dimension)
+ * @param size - the size of pointsArray
+ * @param numOfLists - the number of coarse centroids (inverted lists)
+ * @param numOfProbes - the number of lists scanned per query
+ * @param trainingSize - the number of descriptors sampled for the quantizer training
+ *
+ * @returns
+ * NULL in case of invalid arguments or memory allocation error,
+ * otherwise the new index
+ *
+ * @logger - the method logs allocation and arguments errors if needed
+ * debug prints are also printed to the logger
+ */
+SPIVFIndex spIVFIndexCreate(SPPoint* pointsArray, int size, int numOfLists,
+		int numOfProbes, int trainingSize);
+
+/*
+ * The method adds the given points to the inverted lists of their nearest centroids
+ * (the quantizer is not trained again). The lists are laid out again, so points are
+ * better added in large groups.
+ * The index takes ownership of the points as spIVFIndexCreate does.
+ *
+ * @param index - the index to add the points to
+ * @param pointsArray - the new descriptors, at the dimension of the index
+ * @param size - the size of pointsArray
+ *
+ * @returns false in case of invalid arguments or memory allocation error (the index is
+ * not changed), true otherwise
+ *
+ * @logger - the method logs allocation and arguments errors if needed
+ */
+bool spIVFIndexAddPoints(SPIVFIndex index, SPPoint* pointsArray, int size);
+
+/*
+ * The method finds the (approximate) nearest neighbours of the query point within the
+ * probed lists, and enqueues their image indices and squared distances into bpq,
+ * as kNearestNeighbors does for the KD-tree.
+ *
+ * @param index - the index to search
+ * @param bpq - the queue that is filled with the nearest neighbours, its capacity is k
+ * @param queryPoint - the query point
+ *
+ * @returns false in case of invalid arguments or memory allocation error, true otherwise
+ *
+ * @logger - the method logs allocation and arguments errors if needed
+ */
+bool spIVFIndexKNN(SPIVFIndex index, SPBPQueue bpq, SPPoint queryPoint);
+
+/*
+ * Frees all the resources of the index.
+ * If index is NULL nothing happens.
+ */
+void spIVFIndexDestroy(SPIVFIndex index);
+
+#endif /* SPIVFINDEX_H_ */
@@ -0,0 +1,115 @@
+#include <stdlib.h>
+#include <string.h>
+#include "SPKMeans.h"
+#include "../../general_utils/SPUtils.h"
+
+#define ERROR_SAMPLING_POINTS				"Could not sample the points for training"
+#define ERROR_TRAINING_KMEANS				"Could not train the k-means centroids"
+
+#define DEBUG_KMEANS_TRAINING_STARTED		"K-means training started, number of centroids:"
+
+
+double* spKMeansSamplePoints(SPPoint* pointsArray, int size, int sampleSize, int fromAxis,
+		int toAxis, int* actualSampleSize) {
+	int i, j, subDim, n;
+	double* sample = NULL;
+	spVerifyArgumentsRn(pointsArray != NULL && size > 0 && sampleSize > 0 &&
+			fromAxis >= 0 && toAxis > fromAxis && actualSampleSize != NULL,
+			ERROR_SAMPLING_POINTS);
+
+	n = sampleSize < size ? sampleSize : size;
+	subDim = toAxis - fromAxis;
+	spCalloc(sample, double, n * subDim);
+
+	for (i = 0; i < n; i++) {
+		// evenly strided sample, the points are ordered by image index
+		SPPoint point = pointsArray[(int) (((long) i * size) / n)];
+		for (j = 0; j < subDim; j++)
+			sample[i * subDim + j] = spPointGetAxisCoor(point, fromAxis + j);
+	}
+
+	*actualSampleSize = n;
+	return sample;
+}
+
+double spKMeansSquaredDistance(const double* a, const double* b, int dim) {
+	int i;
+	double distance = 0, diff;
+	for (i = 0; i < dim; i++) {
+		diff = a[i] - b[i];
+		distance += diff * diff;
+	}
+	return distance;
+}
+
+int spKMeansNearestCentroid(const double* centroids, int k, int dim, const double* vector,
+		double* squaredDistance) {
+	int c, best = 0;
+	double distance, bestDistance = spKMeansSquaredDistance(centroids, vector, dim);
+
+	for (c = 1; c < k; c++) {
+		distance = spKMeansSquaredDistance(centroids + c * dim, vector, dim);
+		if (distance < bestDistance) {
+			bestDistance = distance;
+			best = c;
+		}
+	}
+
+	if (squaredDistance != NULL)
+		*squaredDistance = bestDistance;
+	return best;
+}
+
+double* spKMeansTrain(const double* vectors, int n, int dim, int k, int iterations) {
+	int i, j, c, iter, *assignment = NULL, *counts = NULL;
+	double *centroids = NULL, *sums = NULL;
+	bool changed = true;
+	spVerifyArgumentsRn(vectors != NULL && n > 0 && dim > 0 && k > 0 && iterations >= 0,
+			ERROR_TRAINING_KMEANS);
+
+	spLoggerSafePrintDebugWithIndex(DEBUG_KMEANS_TRAINING_STARTED, k, __FILE__,
+			__FUNCTION__, __LINE__);
+
+	spCalloc(centroids, double, k * dim);
+	spCallocWc(assignment, int, n, free(centroids));
+	spCallocWc(counts, int, k, free(centroids); free(assignment));
+	spCallocWc(sums, double, k * dim, free(centroids); free(assignment); free(counts));
+
+	// deterministic initialization - evenly strided vectors
+	for (c = 0; c < k; c++)
+		memcpy(centroids + c * dim, vectors + (((long) c * n) / k) * dim,
+				dim * sizeof(double));
+	for (i = 0; i < n; i++)
+		assignment[i] = -1;
+
+	for (iter = 0; iter < iterations && changed; iter++) {
+		changed = false;
+		memset(counts, 0, k * sizeof(int));
+		memset(sums, 0, k * dim * sizeof(double));
+
+		// assignment step
+		for (i = 0; i < n; i++) {
+			c = spKMeansNearestCentroid(centroids, k, dim, vectors + i * dim, NULL);
+			if (c != assignment[i]) {
+				assignment[i] = c;
+				changed = true;
+			}
+			counts[c]++;
+			for (j = 0; j < dim; j++)
+				sums[c * dim + j] += vectors[i * dim + j];
+		}
+
+		// update step, empty clusters keep their previous centroid
+		for (c = 0; c < k; c++) {
+			if (counts[c] == 0)
+				continue;
+			for (j = 0; j < dim; j++)
+				centroids[c * dim + j] = sums[c * dim + j] / counts[c];
+		}
+	}
+
+	free(assignment);
+	free(counts);
+	free(sums);
+	return centroids;
+}
@@ -0,0 +1,87 @@
+#ifndef SPKMEANS_H_
+#define SPKMEANS_H_
+
+#include "../../SPPoint.h"
+
+/**
+ * SP K-Means summary
+ *
+ * Lloyd's k-means over contiguous row-major double vectors, used to train the
+ * codebooks and coarse quantizers of the approximate search indices.
+ * The training is deterministic - the initial centroids are evenly strided samples,
+ * thus building the same index twice from the same data gives the same result.
+ *
+ * The following functions are supported:
+ *
+ * spKMeansSamplePoints 		- Copies a strided sample of a points array into a contiguous buffer
+ * spKMeansTrain				- Trains k centroids over a set of vectors
+ * spKMeansNearestCentroid		- Finds the nearest centroid of a given vector
+ * spKMeansSquaredDistance		- The L2 squared distance of two vectors
+ */
+
+/*
+ * The method copies the axes [fromAxis, toAxis) of a strided sample of the given points
+ * into a new contiguous row-major buffer.
+ *
+ * pre assumptions - all the points are not NULL and their dimension >= toAxis
+ *
+ * @param pointsArray - the points to sample
+ * @param size - the size of pointsArray
+ * @param sampleSize - the requested size of the sample, if sampleSize >= size all the
+ * 						points are taken
+ * @param fromAxis - the first axis to copy
+ * @param toAxis - the axis after the last axis to copy
+ * @param actualSampleSize - a pointer to which the number of sampled vectors is written
+ *
+ * @returns
+ * NULL in case of invalid arguments or memory allocation error,
+ * otherwise a buffer of (*actualSampleSize) * (toAxis - fromAxis) doubles
+ *
+ * @logger - the method logs allocation and arguments errors if needed
+ */
+double* spKMeansSamplePoints(SPPoint* pointsArray, int size, int sampleSize, int fromAxis,
+		int toAxis, int* actualSampleSize);
+
+/*
+ * The method trains k centroids over the given vectors.
+ * Empty clusters keep their previous centroid.
+ *
+ * @param vectors - n row-major vectors of dimension dim
+ * @param n - the number of vectors
+ * @param dim - the dimension of the vectors
+ * @param k - the number of centroids (k > n is allowed, some centroids will repeat)
+ * @param iterations - the number of Lloyd iterations
+ *
+ * @returns
+ * NULL in case of invalid arguments or memory allocation error,
+ * otherwise k row-major centroids of dimension dim
+ *
+ * @logger - the method logs allocation and arguments errors if needed
+ */
+double* spKMeansTrain(const double* vectors, int n, int dim, int k, int iterations);
+
+/*
+ * The method returns the index of the nearest centroid to the given vector.
+ *
+ * pre assumptions - all pointers are valid (squaredDistance may be NULL), k > 0
+ *
+ * @param centroids - k row-major centroids of dimension dim
+ * @param k - the number of centroids
+ * @param dim - the dimension of the centroids and vector
+ * @param vector - the vector to quantize
+ * @param squaredDistance - if not NULL, the squared distance to the nearest centroid
+ * 							is written to it
+ *
+ * @returns the index of the nearest centroid (the smallest index on ties)
+ */
+int spKMeansNearestCentroid(const double* centroids, int k, int dim, const double* vector,
+		double* squaredDistance);
+
+/*
+ * The method returns the L2 squared distance of two vectors of the given dimension.
+ *
+ * pre assumptions - a and b are valid
+ */
+double spKMeansSquaredDistance(const double* a, const double* b, int dim);
+
+#endif /* SPKMEANS_H_ */
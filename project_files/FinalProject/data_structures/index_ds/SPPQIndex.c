@@ -0,0 +1,389 @@
+#include <stdlib.h>
+#include <stdint.h>
+#include <pthread.h>
+#include "SPPQIndex.h"
+#include "SPKMeans.h"
+#include "../../general_utils/SPUtils.h"
+
+#define PQ_MAX_CENTROIDS							256 // codes are stored as a single byte
+#define PQ_KMEANS_ITERATIONS						15
+
+#define ERROR_CREATING_PQ_INDEX						"Could not create the product quantization index"
+#define ERROR_ADDING_PQ_POINTS						"Could not add the points to the product quantization index"
+#define ERROR_TRAINING_PQ_CODEBOOK					"Could not train a product quantization codebook"
+#define ERROR_PQ_KNN								"Product quantization k-NN search failed"
+
+#define DEBUG_PQ_CODEBOOKS_TRAINED					"Product quantization codebooks trained"
+#define DEBUG_PQ_POINTS_ENCODED						"Product quantization points encoded, count:"
+
+/*
+ * The working memory of a single query
+ * table - the asymmetric distance lookup table, numOfSubspaces * numOfCentroids entries
+ * buffer - a sub-vector of the query (dim entries)
+ * candidates - the re-rank candidates queue (NULL until a query re-ranks), it is
+ * 				replaced only when a query needs a larger one
+ * next - the next free working memory of the index
+ */
+typedef struct pq_context_t {
+	double* table;
+	double* buffer;
+	SPBPQueue candidates;
+	struct pq_context_t* next;
+} PQContext;
+
+/*
+ * A structure used for the product quantization index
+ * size - the number of encoded descriptors
+ * dim - the dimension of the descriptors
+ * numOfSubspaces - the number of sub-vectors (bytes per code)
+ * numOfCentroids - the codebook size of each sub-vector
+ * reRankSize - the number of candidates re-ranked by exact distance (0 = no re-rank)
+ * subspaceOffsets - numOfSubspaces + 1 axis boundaries of the sub-vectors
+ * codebooks - per sub-vector, numOfCentroids row-major centroids
+ * codes - size * numOfSubspaces bytes, the code of descriptor i starts at i * numOfSubspaces
+ * imageIndices - the image index of each descriptor
+ * points - the original descriptors, kept only when reRankSize > 0
+ * freeContexts - the query working memories that are not used by any query, a query
+ * 		takes one (or allocates one if none is free) and returns it when done
+ * freeContextsLock - guards freeContexts
+ */
+struct sp_pq_index_t {
+	int size;
+	int dim;
+	int numOfSubspaces;
+	int numOfCentroids;
+	int reRankSize;
+	int* subspaceOffsets;
+	double** codebooks;
+	uint8_t* codes;
+	int* imageIndices;
+	SPPoint* points;
+	PQContext* freeContexts;
+	pthread_mutex_t freeContextsLock;
+};
+
+/*
+ * Copies the sub-vector s of the given point into buffer
+ */
+static void getSubVector(SPPQIndex index, SPPoint point, int s, double* buffer) {
+	int j;
+	for (j = index->subspaceOffsets[s]; j < index->subspaceOffsets[s + 1]; j++)
+		buffer[j - index->subspaceOffsets[s]] = spPointGetAxisCoor(point, j);
+}
+
+/*
+ * Trains the codebooks of all the sub-vectors
+ *
+ * @returns false in case of memory allocation error, true otherwise
+ */
+static bool trainCodebooks(SPPQIndex index, SPPoint* pointsArray, int trainingSize) {
+	int s, sampleSize;
+	double* sample;
+
+	for (s = 0; s < index->numOfSubspaces; s++) {
+		spVal((sample = spKMeansSamplePoints(pointsArray, index->size, trainingSize,
+				index->subspaceOffsets[s], index->subspaceOffsets[s + 1], &sampleSize)),
+				ERROR_TRAINING_PQ_CODEBOOK, false);
+
+		index->codebooks[s] = spKMeansTrain(sample, sampleSize,
+				index->subspaceOffsets[s + 1] - index->subspaceOffsets[s],
+				index->numOfCentroids, PQ_KMEANS_ITERATIONS);
+		free(sample);
+		spVal(index->codebooks[s] != NULL, ERROR_TRAINING_PQ_CODEBOOK, false);
+	}
+
+	spLoggerSafePrintDebug(DEBUG_PQ_CODEBOOKS_TRAINED, __FILE__, __FUNCTION__, __LINE__);
+	return true;
+}
+
+/*
+ * Encodes the given points into index->codes, from descriptor position first on
+ *
+ * @returns false in case of memory allocation error, true otherwise
+ */
+static bool encodePoints(SPPQIndex index, SPPoint* pointsArray, int first, int size) {
+	int i, s, subDim;
+	double* buffer;
+
+	spCallocWr(buffer, double, index->dim, false);
+
+	for (i = 0; i < size; i++) {
+		for (s = 0; s < index->numOfSubspaces; s++) {
+			subDim = index->subspaceOffsets[s + 1] - index->subspaceOffsets[s];
+			getSubVector(index, pointsArray[i], s, buffer);
+			index->codes[(first + i) * index->numOfSubspaces + s] =
+					(uint8_t) spKMeansNearestCentroid(index->codebooks[s],
+							index->numOfCentroids, subDim, buffer, NULL);
+		}
+		index->imageIndices[first + i] = spPointGetIndex(pointsArray[i]);
+	}
+
+	free(buffer);
+	spLoggerSafePrintDebugWithIndex(DEBUG_PQ_POINTS_ENCODED, size, __FILE__,
+			__FUNCTION__, __LINE__);
+	return true;
+}
+
+static void destroyContext(PQContext* context) {
+	spFree(context->table);
+	spFree(context->buffer);
+	spBPQueueDestroy(context->candidates);
+	free(context);
+}
+
+/*
+ * Frees the index internal allocations without touching the original points
+ */
+static void freePQIndexData(SPPQIndex index) {
+	int s;
+	PQContext* context;
+	while ((context = index->freeContexts) != NULL) {
+		index->freeContexts = context->next;
+		destroyContext(context);
+	}
+	pthread_mutex_destroy(&(index->freeContextsLock));
+	if (index->codebooks != NULL) {
+		for (s = 0; s < index->numOfSubspaces; s++)
+			spFree(index->codebooks[s]);
+		free(index->codebooks);
+	}
+	spFree(index->subspaceOffsets);
+	spFree(index->codes);
+	spFree(index->imageIndices);
+	spFree(index->points);
+	free(index);
+}
+
+SPPQIndex spPQIndexCreate(SPPoint* pointsArray, int size, int numOfSubspaces,
+		int numOfCentroids, int trainingSize, int reRankSize) {
+	int i, s;
+	SPPQIndex index = NULL;
+	spVerifyArgumentsRn(pointsArray != NULL && size > 0 && pointsArray[0] != NULL &&
+			numOfSubspaces > 0 && numOfSubspaces <= spPointGetDimension(pointsArray[0]) &&
+			numOfCentroids > 0 && numOfCentroids <= PQ_MAX_CENTROIDS && trainingSize > 0 &&
+			reRankSize >= 0, ERROR_CREATING_PQ_INDEX);
+
+	spCalloc(index, struct sp_pq_index_t, 1);
+	index->size = size;
+	index->dim = spPointGetDimension(pointsArray[0]);
+	index->numOfSubspaces = numOfSubspaces;
+	index->numOfCentroids = numOfCentroids;
+	index->reRankSize = reRankSize;
+	pthread_mutex_init(&(index->freeContextsLock), NULL);
+
+	spCallocWc(index->subspaceOffsets, int, numOfSubspaces + 1, freePQIndexData(index));
+	spCallocWc(index->codebooks, double*, numOfSubspaces, freePQIndexData(index));
+	spCallocWc(index->codes, uint8_t, size * numOfSubspaces, freePQIndexData(index));
+	spCallocWc(index->imageIndices, int, size, freePQIndexData(index));
+
+	for (s = 0; s <= numOfSubspaces; s++)
+		index->subspaceOffsets[s] = (s * index->dim) / numOfSubspaces;
+
+	spValWcRn(trainCodebooks(index, pointsArray, trainingSize) &&
+			encodePoints(index, pointsArray, 0, size), ERROR_CREATING_PQ_INDEX,
+			freePQIndexData(index));
+
+	if (reRankSize > 0) {
+		spCallocWc(index->points, SPPoint, size, freePQIndexData(index));
+		for (i = 0; i < size; i++)
+			index->points[i] = pointsArray[i];
+	}
+	else {
+		// the codes replace the original descriptors
+		for (i = 0; i < size; i++)
+			spPointDestroy(pointsArray[i]);
+	}
+
+	return index;
+}
+
+bool spPQIndexAddPoints(SPPQIndex index, SPPoint* pointsArray, int size) {
+	int i, newSize;
+	uint8_t* codes;
+	int* imageIndices;
+	SPPoint* points;
+	spVerifyArguments(index != NULL && pointsArray != NULL && size > 0,
+			ERROR_ADDING_PQ_POINTS, false);
+	for (i = 0; i < size; i++) {
+		spVerifyArguments(pointsArray[i] != NULL &&
+				spPointGetDimension(pointsArray[i]) == index->dim,
+				ERROR_ADDING_PQ_POINTS, false);
+	}
+
+	// the arrays only grow, so the index is not changed until the points are encoded
+	newSize = index->size + size;
+	spVal((codes = (uint8_t*) realloc(index->codes, (size_t) newSize *
+			index->numOfSubspaces)), ERROR_ALLOCATING_MEMORY, false);
+	index->codes = codes;
+	spVal((imageIndices = (int*) realloc(index->imageIndices, newSize * sizeof(int))),
+			ERROR_ALLOCATING_MEMORY, false);
+	index->imageIndices = imageIndices;
+	if (index->reRankSize > 0) {
+		spVal((points = (SPPoint*) realloc(index->points, newSize * sizeof(SPPoint))),
+				ERROR_ALLOCATING_MEMORY, false);
+		index->points = points;
+	}
+	spVal(encodePoints(index, pointsArray, index->size, size), ERROR_ADDING_PQ_POINTS,
+			false);
+
+	for (i = 0; i < size; i++) {
+		if (index->reRankSize > 0)
+			index->points[index->size + i] = pointsArray[i];
+		else
+			spPointDestroy(pointsArray[i]); // the codes replace the original descriptors
+	}
+	index->size = newSize;
+	return true;
+}
+
+/*
+ * Takes a free working memory of the index, or allocates one if none is free
+ *
+ * @returns NULL in case of memory allocation error
+ */
+static PQContext* acquireContext(SPPQIndex index) {
+	PQContext* context;
+	pthread_mutex_lock(&(index->freeContextsLock));
+	context = index->freeContexts;
+	if (context != NULL)
+		index->freeContexts = context->next;
+	pthread_mutex_unlock(&(index->freeContextsLock));
+	if (context != NULL)
+		return context;
+
+	spCalloc(context, PQContext, 1);
+	spCallocWc(context->table, double, index->numOfSubspaces * index->numOfCentroids,
+			destroyContext(context));
+	spCallocWc(context->buffer, double, index->dim, destroyContext(context));
+	return context;
+}
+
+/*
+ * Returns a working memory taken by acquireContext to the free ones
+ */
+static void releaseContext(SPPQIndex index, PQContext* context) {
+	pthread_mutex_lock(&(index->freeContextsLock));
+	context->next = index->freeContexts;
+	index->freeContexts = context;
+	pthread_mutex_unlock(&(index->freeContextsLock));
+}
+
+/*
+ * Returns the empty candidates queue of the context, of the given capacity
+ *
+ * @returns NULL in case of memory allocation error
+ */
+static SPBPQueue getCandidatesQueue(PQContext* context, int capacity) {
+	if (context->candidates != NULL &&
+			spBPQueueGetMaxSize(context->candidates) != capacity) {
+		spBPQueueDestroy(context->candidates);
+		context->candidates = NULL;
+	}
+	if (context->candidates == NULL)
+		context->candidates = spBPQueueCreate(capacity);
+	else
+		spBPQueueClear(context->candidates);
+	return context->candidates;
+}
+
+/*
+ * Fills the asymmetric distance lookup table of the query point:
+ * table[s * numOfCentroids + c] = squared distance of query sub-vector s to centroid c
+ */
+static void fillDistanceTable(SPPQIndex index, SPPoint queryPoint, PQContext* context) {
+	int s, c, subDim;
+
+	for (s = 0; s < index->numOfSubspaces; s++) {
+		subDim = index->subspaceOffsets[s + 1] - index->subspaceOffsets[s];
+		getSubVector(index, queryPoint, s, context->buffer);
+		for (c = 0; c < index->numOfCentroids; c++)
+			context->table[s * index->numOfCentroids + c] = spKMeansSquaredDistance(
+					index->codebooks[s] + c * subDim, context->buffer, subDim);
+	}
+}
+
+/*
+ * Returns the approximate squared distance of descriptor i by the lookup table
+ */
+static double getApproximateDistance(SPPQIndex index, const double* table, int i) {
+	int s;
+	double distance = 0;
+	const uint8_t* code = index->codes + i * index->numOfSubspaces;
+	for (s = 0; s < index->numOfSubspaces; s++)
+		distance += table[s * index->numOfCentroids + code[s]];
+	return distance;
+}
+
+/*
+ * Returns true iff the queue message is a legal enqueue result
+ */
+static bool isEnqueueSuccessful(SP_BPQUEUE_MSG msg) {
+	return msg == SP_BPQUEUE_SUCCESS || msg == SP_BPQUEUE_FULL;
+}
+
+/*
+ * Moves the candidates (descriptor positions) to bpq with their exact distances
+ *
+ * @returns false in case of memory allocation error, true otherwise
+ */
+static bool reRankCandidates(SPPQIndex index, SPBPQueue candidates, SPBPQueue bpq,
+		SPPoint queryPoint) {
+	int position;
+	double distance;
+
+	while (!spBPQueueIsEmpty(candidates)) {
+		position = spBPQueueMinIndex(candidates);
+		spBPQueueDequeue(candidates);
+
+		distance = spPointL2SquaredDistance(index->points[position], queryPoint);
+		if (distance <= epsilon) // same precision rule as the KD-tree search
+			distance = 0;
+		spVal(isEnqueueSuccessful(spBPQueueEnqueueValues(bpq,
+				index->imageIndices[position], distance)), ERROR_PQ_KNN, false);
+	}
+	return true;
+}
+
+bool spPQIndexKNN(SPPQIndex index, SPBPQueue bpq, SPPoint queryPoint) {
+	int i, k;
+	bool isReRank, rslt = true;
+	PQContext* context;
+	SPBPQueue candidates = NULL;
+	spVerifyArguments(index != NULL && bpq != NULL && queryPoint != NULL &&
+			spPointGetDimension(queryPoint) == index->dim, ERROR_PQ_KNN, false);
+
+	spVal((context = acquireContext(index)), ERROR_PQ_KNN, false);
+	fillDistanceTable(index, queryPoint, context);
+
+	// at least k candidates are re-ranked, so a re-ranked query finds k neighbours
+	isReRank = index->reRankSize > 0;
+	k = spBPQueueGetMaxSize(bpq);
+	if (isReRank)
+		rslt = (candidates = getCandidatesQueue(context,
+				index->reRankSize > k ? index->reRankSize : k)) != NULL;
+
+	for (i = 0; rslt && i < index->size; i++) {
+		// with re-rank the candidates are kept by their position, otherwise by image
+		rslt = isEnqueueSuccessful(isReRank ?
+				spBPQueueEnqueueValues(candidates, i,
+						getApproximateDistance(index, context->table, i)) :
+				spBPQueueEnqueueValues(bpq, index->imageIndices[i],
+						getApproximateDistance(index, context->table, i)));
+	}
+	rslt = rslt && (!isReRank || reRankCandidates(index, candidates, bpq, queryPoint));
+
+	releaseContext(index, context);
+	spVal(rslt, ERROR_PQ_KNN, false);
+	return true;
+}
+
+void spPQIndexDestroy(SPPQIndex index) {
+	int i;
+	if (index == NULL)
+		return;
+	if (index->points != NULL) {
+		for (i = 0; i < index->size; i++)
+			spPointDestroy(index->points[i]);
+	}
+	freePQIndexData(index);
+}
@@ -0,0 +1,94 @@
+#ifndef SPPQINDEX_H_
+#define SPPQINDEX_H_
+
+#include <stdbool.h>
+#include "../../SPPoint.h"
+#include "../bpqueue_ds/SPBPriorityQueue.h"
+
+/**
+ * SP Product Quantization Index summary
+ *
+ * A compressed approximate nearest neighbours index. The descriptor space is split into
+ * 'numOfSubspaces' consecutive sub-vectors, a codebook of up to 256 centroids is trained
+ * by k-means per sub-vector (on a strided sample of the database), and each descriptor
+ * is stored as one byte per sub-vector.
+ *
+ * A query builds a lookup table of the squared distances from each of its sub-vectors to
+ * each codebook centroid (asymmetric distance computation), so the approximate distance to
+ * a descriptor is the sum of 'numOfSubspaces' table entries.
+ * Optionally the original descriptors are kept, and the best 'reRankSize' candidates are
+ * re-ranked by their exact distances.
+ *
+ * The following functions are supported:
+ *
+ * spPQIndexCreate		- Trains the codebooks and encodes the given points
+ * spPQIndexAddPoints	- Encodes more points by the trained codebooks
+ * spPQIndexKNN			- Finds the k nearest neighbours of a query point
+ * spPQIndexDestroy		- Frees all the resources of the index
+ */
+
+/** Type for defining the product quantization index **/
+typedef struct sp_pq_index_t* SPPQIndex;
+
+/*
+ * The method creates a new product quantization index from the given points.
+ * The index takes ownership of the points: if reRankSize > 0 they are kept for the
+ * exact re-rank and destroyed with the index, otherwise they are destroyed as soon as
+ * they are encoded (on failure the points are not destroyed).
+ *
+ * @param pointsArray - the database descriptors (all at the same dimension)
+ * @param size - the size of pointsArray
+ * @param numOfSubspaces - the number of sub-vectors, 1 <= numOfSubspaces <= dimension
+ * @param numOfCentroids - the codebook size per sub-vector, 1 <= numOfCentroids <= 256
+ * @param trainingSize - the number of descriptors sampled for the codebooks training
+ * @param reRankSize - the number of candidates that are re-ranked by exact distance
+ * 						(at least k of them), 0 disables the re-rank
+ *
+ * @returns
+ * NULL in case of invalid arguments or memory allocation error,
+ * otherwise the new index
+ *
+ * @logger - the method logs allocation and arguments errors if needed
+ * debug prints are also printed to the logger
+ */
+SPPQIndex spPQIndexCreate(SPPoint* pointsArray, int size, int numOfSubspaces,
+		int numOfCentroids, int trainingSize, int reRankSize);
+
+/*
+ * The method encodes the given points by the trained codebooks (they are not trained
+ * again) and adds them to the index.
+ * The index takes ownership of the points as spPQIndexCreate does.
+ *
+ * @param index - the index to add the points to
+ * @param pointsArray - the new descriptors, at the dimension of the index
+ * @param size - the size of pointsArray
+ *
+ * @returns false in case of invalid arguments or memory allocation error (the index is
+ * not changed), true otherwise
+ *
+ * @logger - the method logs allocation and arguments errors if needed
+ */
+bool spPQIndexAddPoints(SPPQIndex index, SPPoint* pointsArray, int size);
+
+/*
+ * The method finds the (approximate) nearest neighbours of the query point, and
+ * enqueues their image indices and (approximate or re-ranked) squared distances into bpq,
+ * as kNearestNeighbors does for the KD-tree.
+ *
+ * @param index - the index to search
+ * @param bpq - the queue that is filled with the nearest neighbours, its capacity is k
+ * @param queryPoint - the query point
+ *
+ * @returns false in case of invalid arguments or memory allocation error, true otherwise
+ *
+ * @logger - the method logs allocation and arguments errors if needed
+ */
+bool spPQIndexKNN(SPPQIndex index, SPBPQueue bpq, SPPoint queryPoint);
+
+/*
+ * Frees all the resources of the index, including the kept points.
+ * If index is NULL nothing happens.
+ */
+void spPQIndexDestroy(SPPQIndex index);
+
+#endif /* SPPQINDEX_H_ */
@@ -0,0 +1,680 @@
+#define _POSIX_C_SOURCE 200809L // pthread_rwlock_t under -std=c99
+
+#include <stdlib.h>
+#include <pthread.h>
+#include "SPSearchIndex.h"
+#include "SPPQIndex.h"
+#include "SPIVFIndex.h"
+#include "SPHNSWIndex.h"
+#include "SPBoVWIndex.h"
+#include "SPBruteForceIndex.h"
+#include "SPShardedIndex.h"
+#include "../kd_ds/SPKDTreeNode.h"
+#include "../kd_ds/SPKDTreeNodeKNN.h"
+#include "../../general_utils/SPUtils.h"
+#include "../../general_utils/SPInstrumentation.h"
+
+#define ERROR_READING_INDEX_SETTINGS				"Could not read the search index settings"
+#define ERROR_CREATING_SEARCH_INDEX					"Could not create the search index"
+#define ERROR_SEARCH_INDEX_KNN						"Search index k-NN search failed"
+#define ERROR_KNN_NOT_SUPPORTED						"The bag of visual words index does not support k-NN search"
+#define ERROR_IMAGE_RANKING_NOT_SUPPORTED			"Only the bag of visual words index ranks images directly"
+#define ERROR_ADDING_IMAGE							"Could not add the image to the search index"
+#define ERROR_REMOVING_IMAGE						"Could not remove the image from the search index"
+#define ERROR_UPDATES_NOT_SUPPORTED					"The bag of visual words index does not support adding or removing images"
+#define ERROR_CREATING_SEARCH_INDEX_LOCK			"Could not create the search index lock"
+
+#define WARNING_DELTA_NOT_MERGED					"Could not merge the added images into the search index, they are kept apart"
+
+#define DEBUG_KD_TREE_INDEX_SELECTED				"KD-tree search index selected"
+#define DEBUG_SHARDED_INDEX_SELECTED				"Sharded KD-tree search index selected"
+#define DEBUG_PQ_INDEX_SELECTED						"Product quantization search index selected"
+#define DEBUG_IVF_INDEX_SELECTED					"Inverted file search index selected"
+#define DEBUG_HNSW_INDEX_SELECTED					"HNSW graph search index selected"
+#define DEBUG_BOVW_INDEX_SELECTED					"Bag of visual words image index selected"
+#define DEBUG_BRUTE_FORCE_INDEX_SELECTED			"Brute force search index selected"
+#define DEBUG_IMAGE_ADDED							"Image added to the search index"
+#define DEBUG_IMAGE_REMOVED							"Image removed from the search index"
+#define DEBUG_DELTA_MERGED							"The added images were merged into the search index"
+
+#define SEARCH_INDEX_REMOVED_OVERFETCH				2 // scratch queue capacity per k once images are removed
+#define SEARCH_INDEX_DELTA_MERGE_SIZE				4096 // added descriptors that are merged into the index
+
+/*
+ * A structure used for the search index
+ * type - the type of the underlying index
+ * kdTree - the KD-tree, relevant only when type is SP_INDEX_KD_TREE and it is not sharded
+ * shardedIndex - the KD-tree shards, relevant only when type is SP_INDEX_KD_TREE and it
+ * 				  is partitioned into more than one shard
+ * pqIndex - the product quantization index, relevant only when type is SP_INDEX_PQ
+ * ivfIndex - the inverted file index, relevant only when type is SP_INDEX_IVF
+ * hnswIndex - the HNSW graph index, relevant only when type is SP_INDEX_HNSW
+ * bovwIndex - the bag of visual words index, relevant only when type is SP_INDEX_BOVW
+ * bruteForceIndex - the brute force index, relevant only when type is SP_INDEX_BRUTE_FORCE
+ * splitMethod - the split method the KD-tree is rebuilt with when the delta is merged
+ * dim - the dimension of the indexed descriptors
+ * numOfImages - the number of images, the image indices are in [0, numOfImages)
+ * deltaIndex - the descriptors of the images added after the index was built, searched
+ * 				exactly together with the underlying index (NULL if no image was added
+ * 				since the last merge, and always NULL for the brute force index)
+ * deltaPoints - copies of the descriptors of the delta, they are added to the underlying
+ * 				 index once there are SEARCH_INDEX_DELTA_MERGE_SIZE of them
+ * deltaSize - the number of descriptors in the delta
+ * deltaCapacity - the size of deltaPoints
+ * removedImages - per image, true iff the image was removed
+ * numOfRemovedImages - the number of removed images
+ * lock - held for reading by the searches and for writing by the updates
+ */
+struct sp_search_index_t {
+	SP_SEARCH_INDEX_TYPE type;
+	SPKDTreeNode kdTree;
+	SPShardedIndex shardedIndex;
+	SPPQIndex pqIndex;
+	SPIVFIndex ivfIndex;
+	SPHNSWIndex hnswIndex;
+	SPBoVWIndex bovwIndex;
+	SPBruteForceIndex bruteForceIndex;
+	SP_KDTREE_SPLIT_METHOD splitMethod;
+	int dim;
+	int numOfImages;
+	SPBruteForceIndex deltaIndex;
+	SPPoint* deltaPoints;
+	int deltaSize;
+	int deltaCapacity;
+	bool* removedImages;
+	int numOfRemovedImages;
+	pthread_rwlock_t lock;
+};
+
+/*
+ * Builds the product quantization index according to the configuration
+ *
+ * @returns NULL in case of configuration reading error or index creation error
+ */
+static SPPQIndex createPQIndex(const SPConfig config, SPPoint* pointsArray, int size) {
+	SP_CONFIG_MSG msg = SP_CONFIG_SUCCESS;
+	int subspaces, centroids, trainingSize, reRank;
+
+	subspaces = spConfigGetPQSubspaces(config, &msg);
+	spValRn(msg == SP_CONFIG_SUCCESS, ERROR_READING_INDEX_SETTINGS);
+	centroids = spConfigGetPQCentroids(config, &msg);
+	spValRn(msg == SP_CONFIG_SUCCESS, ERROR_READING_INDEX_SETTINGS);
+	trainingSize = spConfigGetPQTrainingSize(config, &msg);
+	spValRn(msg == SP_CONFIG_SUCCESS, ERROR_READING_INDEX_SETTINGS);
+	reRank = spConfigGetPQReRank(config, &msg);
+	spValRn(msg == SP_CONFIG_SUCCESS, ERROR_READING_INDEX_SETTINGS);
+
+	spLoggerSafePrintDebug(DEBUG_PQ_INDEX_SELECTED, __FILE__, __FUNCTION__, __LINE__);
+	return spPQIndexCreate(pointsArray, size, subspaces, centroids, trainingSize, reRank);
+}
+
+/*
+ * Builds the inverted file index according to the configuration
+ *
+ * @returns NULL in case of configuration reading error or index creation error
+ */
+static SPIVFIndex createIVFIndex(const SPConfig config, SPPoint* pointsArray, int size) {
+	SP_CONFIG_MSG msg = SP_CONFIG_SUCCESS;
+	int lists, probes, trainingSize;
+
+	lists = spConfigGetIVFLists(config, &msg);
+	spValRn(msg == SP_CONFIG_SUCCESS, ERROR_READING_INDEX_SETTINGS);
+	probes = spConfigGetIVFProbes(config, &msg);
+	spValRn(msg == SP_CONFIG_SUCCESS, ERROR_READING_INDEX_SETTINGS);
+	trainingSize = spConfigGetIVFTrainingSize(config, &msg);
+	spValRn(msg == SP_CONFIG_SUCCESS, ERROR_READING_INDEX_SETTINGS);
+
+	spLoggerSafePrintDebug(DEBUG_IVF_INDEX_SELECTED, __FILE__, __FUNCTION__, __LINE__);
+	return spIVFIndexCreate(pointsArray, size, lists, probes, trainingSize);
+}
+
+/*
+ * Loads the HNSW index from its file if a filename is configured and the file matches
+ * the points, otherwise builds the index (and saves it if a filename is configured)
+ *
+ * @returns NULL in case of configuration reading error or index creation error
+ */
+static SPHNSWIndex createHNSWIndex(const SPConfig config, SPPoint* pointsArray,
+		int size) {
+	SP_CONFIG_MSG msg = SP_CONFIG_SUCCESS;
+	int M, efConstruction, efSearch, numOfThreads;
+	char path[MAX_PATH_LEN];
+	bool isPersistent;
+	SPHNSWIndex index = NULL;
+
+	M = spConfigGetHNSWM(config, &msg);
+	spValRn(msg == SP_CONFIG_SUCCESS, ERROR_READING_INDEX_SETTINGS);
+	efConstruction = spConfigGetHNSWEfConstruction(config, &msg);
+	spValRn(msg == SP_CONFIG_SUCCESS, ERROR_READING_INDEX_SETTINGS);
+	efSearch = spConfigGetHNSWEfSearch(config, &msg);
+	spValRn(msg == SP_CONFIG_SUCCESS, ERROR_READING_INDEX_SETTINGS);
+	numOfThreads = spConfigGetHNSWBuildThreads(config, &msg);
+	spValRn(msg == SP_CONFIG_SUCCESS, ERROR_READING_INDEX_SETTINGS);
+	isPersistent = spConfigGetHNSWFilename(config, &msg) != NULL;
+	spValRn(msg == SP_CONFIG_SUCCESS, ERROR_READING_INDEX_SETTINGS);
+	if (isPersistent)
+		spValRn(spConfigGetHNSWPath(path, config) == SP_CONFIG_SUCCESS,
+				ERROR_READING_INDEX_SETTINGS);
+
+	spLoggerSafePrintDebug(DEBUG_HNSW_INDEX_SELECTED, __FILE__, __FUNCTION__, __LINE__);
+
+	// a graph built with other parameters is rebuilt (and replaces the file)
+	if (isPersistent && (index = spHNSWIndexLoad(path, pointsArray, size, M,
+			efConstruction, efSearch)))
+		return index;
+
+	index = spHNSWIndexCreate(pointsArray, size, M, efConstruction, efSearch,
+			numOfThreads);
+	if (index != NULL && isPersistent)
+		spHNSWIndexSave(index, path); // on failure the index is used without being saved
+	return index;
+}
+
+/*
+ * Builds the bag of visual words index according to the configuration
+ *
+ * @returns NULL in case of configuration reading error or index creation error
+ */
+static SPBoVWIndex createBoVWIndex(const SPConfig config, SPPoint* pointsArray,
+		int size) {
+	SP_CONFIG_MSG msg = SP_CONFIG_SUCCESS;
+	int numOfImages, branching, depth, trainingSize;
+
+	numOfImages = spConfigGetNumOfImages(config, &msg);
+	spValRn(msg == SP_CONFIG_SUCCESS, ERROR_READING_INDEX_SETTINGS);
+	branching = spConfigGetBoVWBranching(config, &msg);
+	spValRn(msg == SP_CONFIG_SUCCESS, ERROR_READING_INDEX_SETTINGS);
+	depth = spConfigGetBoVWDepth(config, &msg);
+	spValRn(msg == SP_CONFIG_SUCCESS, ERROR_READING_INDEX_SETTINGS);
+	trainingSize = spConfigGetBoVWTrainingSize(config, &msg);
+	spValRn(msg == SP_CONFIG_SUCCESS, ERROR_READING_INDEX_SETTINGS);
+
+	spLoggerSafePrintDebug(DEBUG_BOVW_INDEX_SELECTED, __FILE__, __FUNCTION__, __LINE__);
+	return spBoVWIndexCreate(pointsArray, size, numOfImages, branching, depth,
+			trainingSize);
+}
+
+/*
+ * Builds the brute force index according to the configuration
+ *
+ * @returns NULL in case of configuration reading error or index creation error
+ */
+static SPBruteForceIndex createBruteForceIndex(const SPConfig config,
+		SPPoint* pointsArray, int size) {
+	SP_CONFIG_MSG msg = SP_CONFIG_SUCCESS;
+	int numOfThreads;
+
+	numOfThreads = spConfigGetBruteForceThreads(config, &msg);
+	spValRn(msg == SP_CONFIG_SUCCESS, ERROR_READING_INDEX_SETTINGS);
+
+	spLoggerSafePrintDebug(DEBUG_BRUTE_FORCE_INDEX_SELECTED, __FILE__, __FUNCTION__,
+			__LINE__);
+	return spBruteForceIndexCreate(pointsArray, size, numOfThreads);
+}
+
+/*
+ * Builds the KD-tree according to the configuration, in this process or partitioned
+ * into shards that are built and searched by worker processes
+ *
+ * @returns false in case of configuration reading error or tree creation error
+ */
+static bool createKDTreeIndex(SPSearchIndex index, const SPConfig config,
+		SPPoint* pointsArray, int size) {
+	SP_CONFIG_MSG msg = SP_CONFIG_SUCCESS;
+	SP_KDTREE_SPLIT_METHOD splitMethod;
+	int numOfShards;
+
+	splitMethod = spConfigGetSplitMethod(config, &msg);
+	spVal(msg == SP_CONFIG_SUCCESS, ERROR_READING_INDEX_SETTINGS, false);
+	index->splitMethod = splitMethod;
+	numOfShards = spConfigGetNumOfShards(config, &msg);
+	spVal(msg == SP_CONFIG_SUCCESS, ERROR_READING_INDEX_SETTINGS, false);
+
+	if (numOfShards > 1) {
+		spLoggerSafePrintDebug(DEBUG_SHARDED_INDEX_SELECTED, __FILE__, __FUNCTION__,
+				__LINE__);
+		return (index->shardedIndex = spShardedIndexCreate(pointsArray, size,
+				index->numOfImages, numOfShards, splitMethod)) != NULL;
+	}
+
+	spLoggerSafePrintDebug(DEBUG_KD_TREE_INDEX_SELECTED, __FILE__, __FUNCTION__, __LINE__);
+	return (index->kdTree = InitKDTreeFromPoints(pointsArray, size, splitMethod)) != NULL;
+}
+
+SPSearchIndex spSearchIndexCreate(const SPConfig config, SPPoint* pointsArray, int size) {
+	SP_CONFIG_MSG msg = SP_CONFIG_SUCCESS;
+	SPSearchIndex index = NULL;
+	bool created;
+
+	spVerifyArgumentsRn(config != NULL && pointsArray != NULL && size > 0,
+			ERROR_CREATING_SEARCH_INDEX);
+
+	spCalloc(index, struct sp_search_index_t, 1);
+
+	index->type = spConfigGetIndexType(config, &msg);
+	spValWcRn(msg == SP_CONFIG_SUCCESS, ERROR_READING_INDEX_SETTINGS, free(index));
+	index->numOfImages = spConfigGetNumOfImages(config, &msg);
+	spValWcRn(msg == SP_CONFIG_SUCCESS, ERROR_READING_INDEX_SETTINGS, free(index));
+	spCallocWc(index->removedImages, bool, index->numOfImages, free(index));
+	spValWcRn(pthread_rwlock_init(&index->lock, NULL) == 0,
+			ERROR_CREATING_SEARCH_INDEX_LOCK, free(index->removedImages); free(index));
+
+	// the points are owned by the underlying index once it is built
+	index->dim = spPointGetDimension(pointsArray[0]);
+
+	switch (index->type) {
+	case SP_INDEX_PQ:
+		created = (index->pqIndex = createPQIndex(config, pointsArray, size)) != NULL;
+		break;
+	case SP_INDEX_IVF:
+		created = (index->ivfIndex = createIVFIndex(config, pointsArray, size)) != NULL;
+		break;
+	case SP_INDEX_HNSW:
+		created = (index->hnswIndex = createHNSWIndex(config, pointsArray, size)) != NULL;
+		break;
+	case SP_INDEX_BOVW:
+		created = (index->bovwIndex = createBoVWIndex(config, pointsArray, size)) != NULL;
+		break;
+	case SP_INDEX_BRUTE_FORCE:
+		created = (index->bruteForceIndex = createBruteForceIndex(config, pointsArray,
+				size)) != NULL;
+		break;
+	default:
+		created = createKDTreeIndex(index, config, pointsArray, size);
+		break;
+	}
+
+	spValWcRn(created, ERROR_CREATING_SEARCH_INDEX, pthread_rwlock_destroy(&index->lock);
+			free(index->removedImages); free(index));
+	return index;
+}
+
+/*
+ * Searches the underlying index and the added images, the neighbours of both are
+ * enqueued into bpq. Only the in process KD-tree stops at the deadline, *isExpired is
+ * set to true iff it was stopped.
+ */
+static bool searchAllImages(SPSearchIndex index, SPBPQueue bpq, SPPoint queryPoint,
+		uint64_t deadline, bool* isExpired) {
+	bool rslt;
+
+	switch (index->type) {
+	case SP_INDEX_PQ:
+		rslt = spPQIndexKNN(index->pqIndex, bpq, queryPoint);
+		break;
+	case SP_INDEX_IVF:
+		rslt = spIVFIndexKNN(index->ivfIndex, bpq, queryPoint);
+		break;
+	case SP_INDEX_HNSW:
+		rslt = spHNSWIndexKNN(index->hnswIndex, bpq, queryPoint);
+		break;
+	case SP_INDEX_BOVW:
+		spLoggerSafePrintError(ERROR_KNN_NOT_SUPPORTED, __FILE__, __FUNCTION__, __LINE__);
+		return false;
+	case SP_INDEX_BRUTE_FORCE:
+		rslt = spBruteForceIndexKNN(index->bruteForceIndex, bpq, queryPoint);
+		break;
+	default:
+		rslt = index->shardedIndex != NULL ?
+				spShardedIndexKNN(index->shardedIndex, bpq, queryPoint) :
+				kNearestNeighborsWithDeadline(index->kdTree, bpq, queryPoint, deadline,
+						isExpired);
+		break;
+	}
+
+	// the queue is bounded, so it keeps the best neighbours of both
+	if (rslt && index->deltaIndex != NULL)
+		rslt = spBruteForceIndexKNN(index->deltaIndex, bpq, queryPoint);
+	return rslt;
+}
+
+/*
+ * Searches all the images for more neighbours than bpq holds, and moves only the
+ * neighbours of images that were not removed into bpq
+ */
+static bool searchLiveImages(SPSearchIndex index, SPBPQueue bpq, SPPoint queryPoint,
+		uint64_t deadline, bool* isExpired) {
+	int imageIndex;
+	SPBPQueue candidates;
+	bool rslt;
+
+	spValRn((candidates = spBPQueueCreate(spBPQueueGetMaxSize(bpq) *
+			SEARCH_INDEX_REMOVED_OVERFETCH)), ERROR_SEARCH_INDEX_KNN);
+	rslt = searchAllImages(index, candidates, queryPoint, deadline, isExpired);
+
+	while (rslt && !spBPQueueIsEmpty(candidates) && !spBPQueueIsFull(bpq)) {
+		imageIndex = spBPQueueMinIndex(candidates);
+		if (!index->removedImages[imageIndex])
+			rslt = spBPQueueEnqueueValues(bpq, imageIndex, spBPQueueMinValue(candidates))
+					!= SP_BPQUEUE_OUT_OF_MEMORY;
+		spBPQueueDequeue(candidates);
+	}
+
+	spBPQueueDestroy(candidates);
+	spVal(rslt, ERROR_SEARCH_INDEX_KNN, false);
+	return true;
+}
+
+/*
+ * Searches the neighbours of a single query point until the deadline
+ */
+static bool searchQuery(SPSearchIndex index, SPBPQueue bpq, SPPoint queryPoint,
+		uint64_t deadline, bool* isExpired) {
+	if (index->numOfRemovedImages > 0)
+		return searchLiveImages(index, bpq, queryPoint, deadline, isExpired);
+	return searchAllImages(index, bpq, queryPoint, deadline, isExpired);
+}
+
+bool spSearchIndexKNN(SPSearchIndex index, SPBPQueue bpq, SPPoint queryPoint) {
+	bool isExpired = false, rslt;
+	spVerifyArguments(index != NULL && bpq != NULL && queryPoint != NULL,
+			ERROR_SEARCH_INDEX_KNN, false);
+
+	pthread_rwlock_rdlock(&index->lock);
+	rslt = searchQuery(index, bpq, queryPoint, SP_SEARCH_INDEX_NO_DEADLINE, &isExpired);
+	pthread_rwlock_unlock(&index->lock);
+	return rslt;
+}
+
+/*
+ * Returns true iff a block of queries is searched in a single pass: the brute force
+ * index scores a block of queries in a single pass over the database, and the shards get
+ * a block of queries in a single request, as long as they are the only database to search
+ */
+static bool isSearchedInSinglePass(SPSearchIndex index) {
+	return index->deltaIndex == NULL && index->numOfRemovedImages == 0 &&
+			(index->type == SP_INDEX_BRUTE_FORCE || index->shardedIndex != NULL);
+}
+
+/*
+ * Searches the neighbours of all the query points, the lock is held by the caller
+ */
+static bool searchBatch(SPSearchIndex index, SPBPQueue* bpqs, SPPoint* queryPoints,
+		int numOfQueries) {
+	int i;
+	bool isExpired = false;
+
+	if (isSearchedInSinglePass(index)) {
+		if (index->type == SP_INDEX_BRUTE_FORCE)
+			return spBruteForceIndexKNNBatch(index->bruteForceIndex, bpqs, queryPoints,
+					numOfQueries);
+		return spShardedIndexKNNBatch(index->shardedIndex, bpqs, queryPoints,
+				numOfQueries);
+	}
+
+	for (i = 0; i < numOfQueries; i++) {
+		if (!searchQuery(index, bpqs[i], queryPoints[i], SP_SEARCH_INDEX_NO_DEADLINE,
+				&isExpired))
+			return false;
+	}
+	return true;
+}
+
+bool spSearchIndexKNNBatch(SPSearchIndex index, SPBPQueue* bpqs, SPPoint* queryPoints,
+		int numOfQueries) {
+	bool rslt;
+	spVerifyArguments(index != NULL && bpqs != NULL && queryPoints != NULL &&
+			numOfQueries > 0, ERROR_SEARCH_INDEX_KNN, false);
+
+	pthread_rwlock_rdlock(&index->lock);
+	rslt = searchBatch(index, bpqs, queryPoints, numOfQueries);
+	pthread_rwlock_unlock(&index->lock);
+	return rslt;
+}
+
+/*
+ * Searches the query points in their order until the deadline, the lock is held by the
+ * caller
+ */
+static bool searchBatchUntil(SPSearchIndex index, SPBPQueue* bpqs, SPPoint* queryPoints,
+		int numOfQueries, uint64_t deadline, int* numOfSearched, bool* isExpired) {
+	if (deadline == SP_SEARCH_INDEX_NO_DEADLINE) {
+		spVal(searchBatch(index, bpqs, queryPoints, numOfQueries),
+				ERROR_SEARCH_INDEX_KNN, false);
+		*numOfSearched = numOfQueries;
+		return true;
+	}
+
+	// the clock is read before every query (before the whole block if it is searched in a
+	// single pass), and within the KD-tree search of a query
+	while (*numOfSearched < numOfQueries &&
+			!(*isExpired = spInstrumentationNow() >= deadline)) {
+		if (isSearchedInSinglePass(index)) {
+			spVal(searchBatch(index, bpqs, queryPoints, numOfQueries),
+					ERROR_SEARCH_INDEX_KNN, false);
+			*numOfSearched = numOfQueries;
+		} else {
+			spVal(searchQuery(index, bpqs[*numOfSearched], queryPoints[*numOfSearched],
+					deadline, isExpired), ERROR_SEARCH_INDEX_KNN, false);
+			(*numOfSearched)++;
+		}
+	}
+	return true;
+}
+
+bool spSearchIndexKNNBatchWithDeadline(SPSearchIndex index, SPBPQueue* bpqs,
+		SPPoint* queryPoints, int numOfQueries, uint64_t deadline, int* numOfSearched,
+		bool* isExpired) {
+	bool rslt;
+	spVerifyArguments(index != NULL && bpqs != NULL && queryPoints != NULL &&
+			numOfQueries > 0 && numOfSearched != NULL && isExpired != NULL,
+			ERROR_SEARCH_INDEX_KNN, false);
+
+	*numOfSearched = 0;
+	*isExpired = false;
+	pthread_rwlock_rdlock(&index->lock);
+	rslt = searchBatchUntil(index, bpqs, queryPoints, numOfQueries, deadline,
+			numOfSearched, isExpired);
+	pthread_rwlock_unlock(&index->lock);
+	return rslt;
+}
+
+/*
+ * Returns true iff all the features are not NULL, at the index dimension and belong to
+ * the given image
+ */
+static bool isValidImageFeatures(SPSearchIndex index, int imageIndex, SPPoint* features,
+		int numOfFeatures) {
+	int i;
+	for (i = 0; i < numOfFeatures; i++) {
+		if (features[i] == NULL || spPointGetDimension(features[i]) != index->dim ||
+				spPointGetIndex(features[i]) != imageIndex)
+			return false;
+	}
+	return true;
+}
+
+/*
+ * Adds the descriptors of the delta to the underlying index and empties the delta. On
+ * failure the delta is kept, and it is still searched together with the index.
+ */
+static void mergeDelta(SPSearchIndex index) {
+	SPKDTreeNode kdTree;
+	bool rslt;
+
+	switch (index->type) {
+	case SP_INDEX_PQ:
+		rslt = spPQIndexAddPoints(index->pqIndex, index->deltaPoints, index->deltaSize);
+		break;
+	case SP_INDEX_IVF:
+		rslt = spIVFIndexAddPoints(index->ivfIndex, index->deltaPoints, index->deltaSize);
+		break;
+	case SP_INDEX_HNSW:
+		rslt = spHNSWIndexAddPoints(index->hnswIndex, index->deltaPoints,
+				index->deltaSize);
+		break;
+	default:
+		if (index->shardedIndex != NULL) {
+			rslt = spShardedIndexAddPoints(index->shardedIndex, index->deltaPoints,
+					index->deltaSize);
+		} else if ((rslt = (kdTree = spKDTreeAddPoints(index->kdTree, index->deltaPoints,
+				index->deltaSize, index->splitMethod)) != NULL)) {
+			index->kdTree = kdTree;
+		}
+		break;
+	}
+	if (!rslt) {
+		spLoggerSafePrintWarning(WARNING_DELTA_NOT_MERGED, __FILE__, __FUNCTION__,
+				__LINE__);
+		return;
+	}
+
+	// the descriptors are owned by the underlying index now
+	spBruteForceIndexDestroy(index->deltaIndex);
+	index->deltaIndex = NULL;
+	index->deltaSize = 0;
+	spLoggerSafePrintDebug(DEBUG_DELTA_MERGED, __FILE__, __FUNCTION__, __LINE__);
+}
+
+/*
+ * Adds the features to the delta: copies of them are kept for the merge, and the
+ * features themselves are owned by the delta brute force index
+ *
+ * @returns false in case of memory allocation error (the delta is not changed)
+ */
+static bool addToDelta(SPSearchIndex index, SPPoint* features, int numOfFeatures) {
+	int i, capacity = index->deltaCapacity;
+	SPPoint* deltaPoints;
+	bool rslt = false;
+
+	if (index->deltaSize + numOfFeatures > capacity) {
+		while (index->deltaSize + numOfFeatures > capacity)
+			capacity = capacity == 0 ? numOfFeatures : 2 * capacity;
+		deltaPoints = (SPPoint*) realloc(index->deltaPoints, capacity * sizeof(SPPoint));
+		spVal(deltaPoints != NULL, ERROR_ALLOCATING_MEMORY, false);
+		index->deltaPoints = deltaPoints;
+		index->deltaCapacity = capacity;
+	}
+	for (i = 0; i < numOfFeatures; i++) {
+		if ((index->deltaPoints[index->deltaSize + i] = spPointCopy(features[i])) == NULL)
+			break;
+	}
+
+	if (i == numOfFeatures)
+		rslt = index->deltaIndex == NULL ?
+				(index->deltaIndex = spBruteForceIndexCreate(features, numOfFeatures, 1))
+						!= NULL :
+				spBruteForceIndexAddPoints(index->deltaIndex, features, numOfFeatures);
+	if (!rslt) {
+		for (i--; i >= 0; i--)
+			spPointDestroy(index->deltaPoints[index->deltaSize + i]);
+		spLoggerSafePrintError(ERROR_ADDING_IMAGE, __FILE__, __FUNCTION__, __LINE__);
+		return false;
+	}
+	index->deltaSize += numOfFeatures;
+	return true;
+}
+
+/*
+ * Adds the image, the write lock is held by the caller
+ */
+static bool addImage(SPSearchIndex index, int imageIndex, SPPoint* features,
+		int numOfFeatures) {
+	bool* removedImages;
+	spVerifyArguments(imageIndex == index->numOfImages, ERROR_ADDING_IMAGE, false);
+	spVerifyArguments(isValidImageFeatures(index, imageIndex, features, numOfFeatures),
+			ERROR_ADDING_IMAGE, false);
+	spVal(index->type != SP_INDEX_BOVW, ERROR_UPDATES_NOT_SUPPORTED, false);
+
+	removedImages = (bool*) realloc(index->removedImages, (imageIndex + 1) * sizeof(bool));
+	spVal(removedImages != NULL, ERROR_ALLOCATING_MEMORY, false);
+	index->removedImages = removedImages;
+
+	// the brute force index is exact and appends in place, so it needs no delta
+	if (index->type == SP_INDEX_BRUTE_FORCE) {
+		spVal(spBruteForceIndexAddPoints(index->bruteForceIndex, features, numOfFeatures),
+				ERROR_ADDING_IMAGE, false);
+	} else {
+		if (!addToDelta(index, features, numOfFeatures))
+			return false;
+		if (index->deltaSize >= SEARCH_INDEX_DELTA_MERGE_SIZE)
+			mergeDelta(index);
+	}
+
+	index->removedImages[imageIndex] = false;
+	index->numOfImages++;
+
+	spLoggerSafePrintDebug(DEBUG_IMAGE_ADDED, __FILE__, __FUNCTION__, __LINE__);
+	return true;
+}
+
+bool spSearchIndexAddImage(SPSearchIndex index, int imageIndex, SPPoint* features,
+		int numOfFeatures) {
+	bool rslt;
+	spVerifyArguments(index != NULL && features != NULL && numOfFeatures > 0,
+			ERROR_ADDING_IMAGE, false);
+
+	pthread_rwlock_wrlock(&index->lock);
+	rslt = addImage(index, imageIndex, features, numOfFeatures);
+	pthread_rwlock_unlock(&index->lock);
+	return rslt;
+}
+
+bool spSearchIndexRemoveImage(SPSearchIndex index, int imageIndex) {
+	bool rslt;
+	spVerifyArguments(index != NULL, ERROR_REMOVING_IMAGE, false);
+	spVal(index->type != SP_INDEX_BOVW, ERROR_UPDATES_NOT_SUPPORTED, false);
+
+	pthread_rwlock_wrlock(&index->lock);
+	if ((rslt = imageIndex >= 0 && imageIndex < index->numOfImages) &&
+			!index->removedImages[imageIndex]) {
+		index->removedImages[imageIndex] = true;
+		index->numOfRemovedImages++;
+		spLoggerSafePrintDebug(DEBUG_IMAGE_REMOVED, __FILE__, __FUNCTION__, __LINE__);
+	}
+	pthread_rwlock_unlock(&index->lock);
+	spVerifyArguments(rslt, ERROR_REMOVING_IMAGE, false);
+	return true;
+}
+
+bool spSearchIndexIsImageRemoved(SPSearchIndex index, int imageIndex) {
+	bool rslt;
+	if (index == NULL)
+		return false;
+	pthread_rwlock_rdlock(&index->lock);
+	rslt = imageIndex >= 0 && imageIndex < index->numOfImages &&
+			index->removedImages[imageIndex];
+	pthread_rwlock_unlock(&index->lock);
+	return rslt;
+}
+
+int spSearchIndexGetNumOfImages(SPSearchIndex index) {
+	int numOfImages;
+	if (index == NULL)
+		return -1;
+	pthread_rwlock_rdlock(&index->lock);
+	numOfImages = index->numOfImages;
+	pthread_rwlock_unlock(&index->lock);
+	return numOfImages;
+}
+
+bool spSearchIndexIsImageLevel(SPSearchIndex index) {
+	return index != NULL && index->type == SP_INDEX_BOVW;
+}
+
+int* spSearchIndexSimilarImages(SPSearchIndex index, SPPoint* features, int numOfFeatures,
+		int numOfSimilarImages) {
+	spVerifyArgumentsRn(index != NULL, ERROR_SEARCH_INDEX_KNN);
+	spValRn(index->type == SP_INDEX_BOVW, ERROR_IMAGE_RANKING_NOT_SUPPORTED);
+	return spBoVWIndexSimilarImages(index->bovwIndex, features, numOfFeatures,
+			numOfSimilarImages);
+}
+
+void spSearchIndexDestroy(SPSearchIndex index) {
+	if (index == NULL)
+		return;
+	spKDTreeDestroy(index->kdTree, true);
+	spShardedIndexDestroy(index->shardedIndex);
+	spPQIndexDestroy(index->pqIndex);
+	spIVFIndexDestroy(index->ivfIndex);
+	spHNSWIndexDestroy(index->hnswIndex);
+	spBoVWIndexDestroy(index->bovwIndex);
+	spBruteForceIndexDestroy(index->bruteForceIndex);
+	spBruteForceIndexDestroy(index->deltaIndex);
+	while (index->deltaSize > 0)
+		spPointDestroy(index->deltaPoints[--index->deltaSize]);
+	spFree(index->deltaPoints);
+	spFree(index->removedImages);
+	pthread_rwlock_destroy(&index->lock);
+	free(index);
+}
@@ -0,0 +1,223 @@
+#ifndef SPSEARCHINDEX_H_
+#define SPSEARCHINDEX_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "../../SPPoint.h"
+#include "../../SPConfig.h"
+#include "../bpqueue_ds/SPBPriorityQueue.h"
+
+/**
+ * SP Search Index summary
+ *
+ * A common interface for the nearest neighbours search indices, the concrete index
+ * is selected by the spIndexType configuration key:
+ *
+ * KD_TREE	- the exact KD-tree search (default), with spNumOfShards > 1 the KD-tree is
+ * 			  partitioned into shards searched by worker processes (see SPShardedIndex.h)
+ * PQ		- the product quantization compressed index (see SPPQIndex.h)
+ * IVF		- the inverted file coarse quantizer index (see SPIVFIndex.h)
+ * HNSW		- the hierarchical navigable small world graph index (see SPHNSWIndex.h)
+ * BOVW		- the bag of visual words image index (see SPBoVWIndex.h), it ranks whole
+ * 			  images instead of finding the nearest neighbours of each descriptor
+ * BRUTE	- the exact brute force scan (see SPBruteForceIndex.h)
+ *
+ * Images can be added and removed while the index is in use, without rebuilding it.
+ * The descriptors of added images are kept in a small exact brute force index (the
+ * delta) that is searched together with the underlying index, and the bounded queue
+ * keeps the best neighbours of both. Once the delta holds a few thousand descriptors it
+ * is merged into the underlying index (the brute force index appends them at once).
+ * Removed images are only marked, their neighbours are dropped from the search results.
+ * The bag of visual words index does not support updates.
+ *
+ * The searches may run concurrently with each other and with the updates: the updates
+ * wait for the running searches to end, and the searches wait for a running update.
+ *
+ * The following functions are supported:
+ *
+ * spSearchIndexCreate		- Builds the configured index from the given points
+ * spSearchIndexKNN			- Finds the k nearest neighbours of a query point
+ * spSearchIndexKNNBatch		- Finds the k nearest neighbours of several query points
+ * spSearchIndexKNNBatchWithDeadline	- Same, stops searching at a deadline
+ * spSearchIndexAddImage		- Adds the descriptors of a new image
+ * spSearchIndexRemoveImage	- Removes an image from the search results
+ * spSearchIndexIsImageRemoved	- Returns true iff an image was removed
+ * spSearchIndexGetNumOfImages	- Returns the number of images, including added ones
+ * spSearchIndexIsImageLevel	- Returns true iff the index ranks whole images
+ * spSearchIndexSimilarImages	- Ranks the images by their similarity to a query image
+ * spSearchIndexDestroy		- Frees all the resources of the index
+ */
+
+/** Type for defining the search index **/
+typedef struct sp_search_index_t* SPSearchIndex;
+
+/** A deadline that never passes **/
+#define SP_SEARCH_INDEX_NO_DEADLINE	0
+
+/*
+ * The method builds the index configured in 'config' from the given points.
+ * The index takes ownership of the points (but not of 'pointsArray' itself), they are
+ * destroyed when the index is destroyed.
+ *
+ * @param config - the configuration structure
+ * @param pointsArray - the database descriptors (all at the same dimension)
+ * @param size - the size of pointsArray
+ *
+ * @returns
+ * NULL in case of invalid arguments, configuration reading error or memory
+ * allocation error, otherwise the new index
+ *
+ * @logger - the method logs allocation and arguments errors if needed
+ * debug prints are also printed to the logger
+ */
+SPSearchIndex spSearchIndexCreate(const SPConfig config, SPPoint* pointsArray, int size);
+
+/*
+ * The method finds the nearest neighbours of the query point using the underlying index
+ * and the added images, and enqueues their image indices and squared distances into bpq.
+ * Once images were removed, the search looks for more neighbours than bpq holds and
+ * drops the ones of removed images, so bpq may hold less than k neighbours.
+ *
+ * @param index - the index to search
+ * @param bpq - the queue that is filled with the nearest neighbours, its capacity is k
+ * @param queryPoint - the query point
+ *
+ * @returns false in case of invalid arguments, memory allocation error or an image level
+ * index, true otherwise
+ *
+ * @logger - the method logs allocation and arguments errors if needed
+ */
+bool spSearchIndexKNN(SPSearchIndex index, SPBPQueue bpq, SPPoint queryPoint);
+
+/*
+ * The method finds the nearest neighbours of every query point, as spSearchIndexKNN
+ * does, the neighbours of queryPoints[i] are enqueued into bpqs[i]. The brute force
+ * index searches all the queries in a single pass and the sharded KD-tree sends them to
+ * its shards in a single request (as long as no image was added or removed), the other
+ * indices search the queries one at a time.
+ *
+ * @param index - the index to search
+ * @param bpqs - numOfQueries queues, the capacity of each queue is its k
+ * @param queryPoints - the query points
+ * @param numOfQueries - the size of bpqs and of queryPoints
+ *
+ * @returns false in case of invalid arguments, memory allocation error or an image level
+ * index, true otherwise
+ *
+ * @logger - the method logs allocation and arguments errors if needed
+ */
+bool spSearchIndexKNNBatch(SPSearchIndex index, SPBPQueue* bpqs, SPPoint* queryPoints,
+		int numOfQueries);
+
+/*
+ * The method finds the nearest neighbours of the query points in their order, as
+ * spSearchIndexKNNBatch does, until the given deadline. The clock is read before every
+ * query point, and the in process KD-tree also reads it between batches of scanned
+ * leaves and stops backtracking once the deadline passed, so the neighbours of the last
+ * searched point may be approximate. The indices that search a block of queries in a
+ * single pass (see spSearchIndexKNNBatch) search the whole block or none of it.
+ *
+ * @param index - the index to search
+ * @param bpqs - numOfQueries queues, the capacity of each queue is its k
+ * @param queryPoints - the query points
+ * @param numOfQueries - the size of bpqs and of queryPoints
+ * @param deadline - the spInstrumentationNow time to stop at, SP_SEARCH_INDEX_NO_DEADLINE
+ * if none
+ * @param numOfSearched - set to the number of query points that were searched, the
+ * neighbours of queryPoints[i] are in bpqs[i] for every i < *numOfSearched and the other
+ * queues are not changed
+ * @param isExpired - set to true iff the search was stopped by the deadline
+ *
+ * @returns false in case of invalid arguments, memory allocation error or an image level
+ * index, true otherwise (a search stopped by the deadline is successful)
+ *
+ * @logger - the method logs allocation and arguments errors if needed
+ */
+bool spSearchIndexKNNBatchWithDeadline(SPSearchIndex index, SPBPQueue* bpqs,
+		SPPoint* queryPoints, int numOfQueries, uint64_t deadline, int* numOfSearched,
+		bool* isExpired);
+
+/*
+ * The method adds a new image to the index, its descriptors are found by the following
+ * searches. The new image takes the next image index. An addition that fills the delta
+ * merges it into the underlying index, and takes as long as adding its descriptors (or
+ * rebuilding the tree, for the KD-tree). A failed merge is logged as a warning, and the
+ * delta is kept and searched as before.
+ * The index takes ownership of the features (but not of the 'features' array itself).
+ *
+ * @param index - the index to add the image to
+ * @param imageIndex - the index of the new image, spSearchIndexGetNumOfImages(index)
+ * @param features - the descriptors of the image, at the dimension of the index and with
+ * 					 imageIndex as their index
+ * @param numOfFeatures - the size of features
+ *
+ * @returns false in case of invalid arguments, memory allocation error or an image level
+ * index (the index is not changed), true otherwise
+ *
+ * @logger - the method logs allocation and arguments errors if needed
+ * debug prints are also printed to the logger
+ */
+bool spSearchIndexAddImage(SPSearchIndex index, int imageIndex, SPPoint* features,
+		int numOfFeatures);
+
+/*
+ * The method removes an image from the search results, its descriptors are no longer
+ * returned by spSearchIndexKNN. Removing an image twice has no effect, and the index of
+ * a removed image is not reused.
+ *
+ * @param index - the index to remove the image from
+ * @param imageIndex - the index of the image, in [0, spSearchIndexGetNumOfImages(index))
+ *
+ * @returns false in case of invalid arguments or an image level index, true otherwise
+ *
+ * @logger - the method logs arguments errors if needed
+ * debug prints are also printed to the logger
+ */
+bool spSearchIndexRemoveImage(SPSearchIndex index, int imageIndex);
+
+/*
+ * Returns true iff the image was removed from the index.
+ * Returns false if index is NULL or imageIndex is not an image of the index.
+ */
+bool spSearchIndexIsImageRemoved(SPSearchIndex index, int imageIndex);
+
+/*
+ * Returns the number of images of the index, the images it was built from and the added
+ * ones (including removed images), or -1 if index is NULL
+ */
+int spSearchIndexGetNumOfImages(SPSearchIndex index);
+
+/*
+ * Returns true iff the index ranks whole images (spSearchIndexSimilarImages) rather than
+ * finding the nearest neighbours of single descriptors (spSearchIndexKNN).
+ * Returns false if index is NULL.
+ */
+bool spSearchIndexIsImageLevel(SPSearchIndex index);
+
+/*
+ * The method returns the indices of the images that are the most similar to the query
+ * image, given by its descriptors, ordered by descending similarity.
+ *
+ * pre assumptions - spSearchIndexIsImageLevel(index)
+ *
+ * @param index - the image level index
+ * @param features - the descriptors of the query image
+ * @param numOfFeatures - the size of features
+ * @param numOfSimilarImages - the size of the returned array
+ *
+ * @returns
+ * NULL in case of invalid arguments, a descriptor level index or memory allocation
+ * error, otherwise an array of numOfSimilarImages image indices
+ *
+ * @logger - the method logs allocation and arguments errors if needed
+ */
+int* spSearchIndexSimilarImages(SPSearchIndex index, SPPoint* features, int numOfFeatures,
+		int numOfSimilarImages);
+
+/*
+ * Frees all the resources of the index, including the indexed points.
+ * If index is NULL nothing happens.
+ */
+void spSearchIndexDestroy(SPSearchIndex index);
+
+#endif /* SPSEARCHINDEX_H_ */
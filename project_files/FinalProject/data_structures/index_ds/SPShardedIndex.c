@@ -0,0 +1,614 @@
+#define _POSIX_C_SOURCE 200809L // fork, socketpair and MSG_NOSIGNAL under -std=c99
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include "SPShardedIndex.h"
+#include "../kd_ds/SPKDTreeNode.h"
+#include "../kd_ds/SPKDTreeNodeKNN.h"
+#include "../../general_utils/SPUtils.h"
+
+#define SHARD_READY								1
+#define SHARD_FAILED							0
+#define NO_SHARD_WORKER							-1
+
+#define ERROR_CREATING_SHARDED_INDEX			"Could not create the sharded index"
+#define ERROR_STARTING_SHARD_WORKER				"Could not start a shard worker process"
+#define ERROR_SHARDED_KNN						"Sharded k-NN search failed"
+#define ERROR_ADDING_SHARD_POINTS				"Could not add the points to the sharded index"
+#define ERROR_SHARD_WORKER_FAILED				"A shard worker failed, the sharded index is no longer usable"
+
+#define DEBUG_SHARD_WORKERS_READY				"All the shard workers are ready"
+
+/*
+ * The kind of a request, the first field of every request to a worker
+ */
+typedef enum shard_request_t {
+	SHARD_REQUEST_QUERIES,
+	SHARD_REQUEST_ADD_POINTS
+} SHARD_REQUEST;
+
+/*
+ * A neighbour found by a shard, as sent to the coordinator
+ */
+typedef struct shard_neighbour_t {
+	int imageIndex;
+	double distance;
+} ShardNeighbour;
+
+/*
+ * A structure used for the sharded index
+ * numOfShards - the number of shards
+ * dim - the dimension of the indexed descriptors
+ * precision - the storage precision of the indexed descriptors (that of the first point)
+ * sockets - the coordinator end of the socket pair of each shard, NO_SHARD_WORKER for a
+ * 			 shard with no descriptors
+ * workers - the process id of the worker of each shard
+ * shardSizes - the number of descriptors of each shard
+ * isBroken - true once a worker failed, the streams of the shards may be out of sync
+ * exchangeLock - taken by the query batch that uses the sockets
+ */
+struct sp_sharded_index_t {
+	int numOfShards;
+	int dim;
+	SP_POINT_PRECISION precision;
+	int* sockets;
+	pid_t* workers;
+	int* shardSizes;
+	bool isBroken;
+	pthread_mutex_t exchangeLock;
+};
+
+//-------------------------------------------------stream----------------------------------------------
+
+/*
+ * Sends the whole buffer, a worker that exited fails the send instead of raising SIGPIPE
+ *
+ * @returns false in case of a send error, true otherwise
+ */
+static bool sendAll(int socket, const void* data, size_t size) {
+	const char* buffer = (const char*) data;
+	ssize_t sent;
+	while (size > 0) {
+		sent = send(socket, buffer, size, MSG_NOSIGNAL);
+		if (sent < 0 && errno == EINTR)
+			continue;
+		if (sent <= 0)
+			return false;
+		buffer += sent;
+		size -= (size_t) sent;
+	}
+	return true;
+}
+
+/*
+ * Receives exactly size bytes
+ *
+ * @returns false in case of a receive error or if the stream ended, true otherwise
+ */
+static bool receiveAll(int socket, void* data, size_t size) {
+	char* buffer = (char*) data;
+	ssize_t received;
+	while (size > 0) {
+		received = recv(socket, buffer, size, 0);
+		if (received < 0 && errno == EINTR)
+			continue;
+		if (received <= 0)
+			return false;
+		buffer += received;
+		size -= (size_t) received;
+	}
+	return true;
+}
+
+//-------------------------------------------------worker----------------------------------------------
+
+/*
+ * Searches the shard tree for the k nearest neighbours of a query, they are stored
+ * into neighbours (ordered by distance) and their number into count. The query is
+ * created at the storage precision it was sent at.
+ *
+ * @returns false in case of memory allocation error, true otherwise
+ */
+static bool searchShard(SPKDTreeNode tree, double* coordinates, int dim,
+		SP_POINT_PRECISION precision, int k, ShardNeighbour* neighbours, int* count) {
+	SPPoint query = spPointCreateWithPrecision(coordinates, dim, 0, precision);
+	SPBPQueue bpq = spBPQueueCreate(k);
+	bool rslt = query != NULL && bpq != NULL && kNearestNeighbors(tree, bpq, query);
+
+	for (*count = 0; rslt && !spBPQueueIsEmpty(bpq); (*count)++) {
+		neighbours[*count].imageIndex = spBPQueueMinIndex(bpq);
+		neighbours[*count].distance = spBPQueueMinValue(bpq);
+		spBPQueueDequeue(bpq);
+	}
+
+	spPointDestroy(query);
+	spBPQueueDestroy(bpq);
+	return rslt;
+}
+
+/*
+ * Serves a single query batch: receives the number of queries, their k and their
+ * coordinates (at the storage precision), and sends back the number of neighbours of
+ * each query followed by all the neighbours
+ *
+ * @returns false once the coordinator closed the stream or in case of an error
+ */
+static bool serveQueries(int socket, SPKDTreeNode tree, int dim,
+		SP_POINT_PRECISION precision) {
+	int q, numOfQueries, totalCapacity = 0, *capacities = NULL, *counts = NULL;
+	size_t rowSize = (size_t) dim * spPointGetCoorSize(precision);
+	char* rows = NULL;
+	double* vector = NULL;
+	ShardNeighbour* neighbours = NULL;
+	bool rslt;
+
+	if (!receiveAll(socket, &numOfQueries, sizeof(int)) || numOfQueries <= 0)
+		return false;
+	rslt = (capacities = (int*) calloc(numOfQueries, sizeof(int))) != NULL &&
+			(counts = (int*) calloc(numOfQueries, sizeof(int))) != NULL &&
+			(rows = (char*) calloc(numOfQueries, rowSize)) != NULL &&
+			(vector = (double*) calloc(dim, sizeof(double))) != NULL &&
+			receiveAll(socket, capacities, numOfQueries * sizeof(int)) &&
+			receiveAll(socket, rows, numOfQueries * rowSize);
+
+	for (q = 0; rslt && q < numOfQueries; q++)
+		totalCapacity += capacities[q];
+	rslt = rslt && (neighbours = (ShardNeighbour*) calloc(totalCapacity,
+			sizeof(ShardNeighbour))) != NULL;
+
+	// the neighbours of all the queries are sent as one array, after their counts
+	for (q = 0, totalCapacity = 0; rslt && q < numOfQueries; q++) {
+		spPointRowToVector(rows + q * rowSize, dim, precision, vector);
+		rslt = searchShard(tree, vector, dim, precision, capacities[q],
+				neighbours + totalCapacity, &(counts[q]));
+		totalCapacity += counts[q];
+	}
+	rslt = rslt && sendAll(socket, counts, numOfQueries * sizeof(int)) &&
+			sendAll(socket, neighbours, totalCapacity * sizeof(ShardNeighbour));
+
+	free(capacities);
+	free(counts);
+	free(rows);
+	free(vector);
+	free(neighbours);
+	return rslt;
+}
+
+/*
+ * Serves a points addition: receives the number of points, their image indices and their
+ * coordinates (at the storage precision), rebuilds the shard tree with them and sends
+ * back whether they were added. The tree is kept as it was if they could not be added.
+ *
+ * @returns false once the coordinator closed the stream or in case of an error
+ */
+static bool servePointsAddition(int socket, SPKDTreeNode* tree, int dim,
+		SP_POINT_PRECISION precision, SP_KDTREE_SPLIT_METHOD splitMethod) {
+	int i, size, *imageIndices = NULL;
+	size_t rowSize = (size_t) dim * spPointGetCoorSize(precision);
+	char status, *rows = NULL;
+	double* vector = NULL;
+	SPPoint* points = NULL;
+	SPKDTreeNode grownTree = NULL;
+	bool rslt, isCreated;
+
+	// the stream is out of sync unless the whole request is received
+	if (!receiveAll(socket, &size, sizeof(int)) || size <= 0)
+		return false;
+	rslt = (imageIndices = (int*) calloc(size, sizeof(int))) != NULL &&
+			(rows = (char*) calloc(size, rowSize)) != NULL &&
+			(vector = (double*) calloc(dim, sizeof(double))) != NULL &&
+			(points = (SPPoint*) calloc(size, sizeof(SPPoint))) != NULL &&
+			receiveAll(socket, imageIndices, size * sizeof(int)) &&
+			receiveAll(socket, rows, size * rowSize);
+
+	// the points are created at the precision they were sent at, thus without loss
+	for (i = 0, isCreated = rslt; isCreated && i < size; i++) {
+		spPointRowToVector(rows + i * rowSize, dim, precision, vector);
+		isCreated = (points[i] = spPointCreateWithPrecision(vector, dim, imageIndices[i],
+				precision)) != NULL;
+	}
+	if (isCreated && (grownTree = spKDTreeAddPoints(*tree, points, size, splitMethod)))
+		*tree = grownTree;
+	for (i = 0; grownTree == NULL && points != NULL && i < size; i++) {
+		if (points[i] != NULL)
+			spPointDestroy(points[i]);
+	}
+
+	status = grownTree != NULL ? SHARD_READY : SHARD_FAILED;
+	rslt = rslt && sendAll(socket, &status, sizeof(char));
+
+	free(imageIndices);
+	free(rows);
+	free(vector);
+	free(points);
+	return rslt;
+}
+
+/*
+ * Serves a single request of the coordinator
+ *
+ * @returns false once the coordinator closed the stream or in case of an error
+ */
+static bool serveShardRequest(int socket, SPKDTreeNode* tree, int dim,
+		SP_POINT_PRECISION precision, SP_KDTREE_SPLIT_METHOD splitMethod) {
+	int request;
+	if (!receiveAll(socket, &request, sizeof(int)))
+		return false;
+	if (request == SHARD_REQUEST_ADD_POINTS)
+		return servePointsAddition(socket, tree, dim, precision, splitMethod);
+	return request == SHARD_REQUEST_QUERIES && serveQueries(socket, *tree, dim,
+			precision);
+}
+
+/*
+ * The body of a worker process: builds the KD-tree of the shard, reports whether it is
+ * ready and serves requests until the coordinator closes the stream
+ *
+ * @returns the worker exit status
+ */
+static int runShardWorker(int socket, SPPoint* shardPoints, int size, int dim,
+		SP_POINT_PRECISION precision, SP_KDTREE_SPLIT_METHOD splitMethod) {
+	char status;
+	SPKDTreeNode tree = InitKDTreeFromPoints(shardPoints, size, splitMethod);
+
+	status = tree != NULL ? SHARD_READY : SHARD_FAILED;
+	if (sendAll(socket, &status, sizeof(char)) && tree != NULL) {
+		while (serveShardRequest(socket, &tree, dim, precision, splitMethod))
+			;
+	}
+
+	spKDTreeDestroy(tree, true);
+	close(socket);
+	return tree != NULL ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+//-------------------------------------------------coordinator-----------------------------------------
+
+/*
+ * Returns the shard of the image, the images [s * numOfImages / numOfShards,
+ * (s + 1) * numOfImages / numOfShards) belong to shard s
+ */
+static int getImageShard(int imageIndex, int numOfImages, int numOfShards) {
+	return (int) (((long long) (imageIndex + 1) * numOfShards - 1) / numOfImages);
+}
+
+/*
+ * Returns true iff all the points are not NULL, at the same dimension and with an image
+ * index in [0, numOfImages)
+ */
+static bool isValidPointsArray(SPPoint* pointsArray, int size, int numOfImages) {
+	int i;
+	for (i = 0; i < size; i++) {
+		if (pointsArray[i] == NULL || spPointGetDimension(pointsArray[i]) !=
+				spPointGetDimension(pointsArray[0]) || spPointGetIndex(pointsArray[i]) < 0 ||
+				spPointGetIndex(pointsArray[i]) >= numOfImages)
+			return false;
+	}
+	return true;
+}
+
+/*
+ * Stops the workers of the shards [0, numOfShards) and waits for them to exit, a worker
+ * exits once its stream is shut down (the stream is shut down rather than only closed,
+ * since the workers of other sharded indices may hold copies of the descriptor)
+ */
+static void stopShardWorkers(SPShardedIndex index, int numOfShards) {
+	int s;
+	for (s = 0; s < numOfShards; s++) {
+		if (index->sockets[s] == NO_SHARD_WORKER)
+			continue;
+		shutdown(index->sockets[s], SHUT_RDWR);
+		close(index->sockets[s]);
+		index->sockets[s] = NO_SHARD_WORKER;
+		while (waitpid(index->workers[s], NULL, 0) < 0 && errno == EINTR)
+			;
+	}
+}
+
+static void freeShardedIndexData(SPShardedIndex index) {
+	pthread_mutex_destroy(&(index->exchangeLock));
+	spFree(index->sockets);
+	spFree(index->workers);
+	spFree(index->shardSizes);
+	free(index);
+}
+
+/*
+ * Forks the worker of shard s, the worker gets the points of its shard only.
+ * The forked process never returns from this method.
+ *
+ * @returns false in case the socket pair or the process could not be created
+ */
+static bool startShardWorker(SPShardedIndex index, int s, SPPoint* pointsArray,
+		int* pointsShards, int size, SP_KDTREE_SPLIT_METHOD splitMethod) {
+	int i, t, shardSize = 0, sockets[2];
+	pid_t pid;
+
+	if (socketpair(AF_UNIX, SOCK_STREAM, 0, sockets) < 0)
+		return false;
+
+	// nothing buffered may be written twice, by the coordinator and by the worker
+	fflush(NULL);
+	if ((pid = fork()) < 0) {
+		close(sockets[0]);
+		close(sockets[1]);
+		return false;
+	}
+
+	if (pid == 0) {
+		// the worker keeps only its own stream and its own points
+		close(sockets[0]);
+		for (t = 0; t < s; t++) {
+			if (index->sockets[t] != NO_SHARD_WORKER)
+				close(index->sockets[t]);
+		}
+		for (i = 0; i < size; i++) {
+			if (pointsShards[i] == s)
+				pointsArray[shardSize++] = pointsArray[i];
+			else
+				spPointDestroy(pointsArray[i]);
+		}
+		t = runShardWorker(sockets[1], pointsArray, shardSize, index->dim,
+				index->precision, splitMethod);
+		fflush(NULL);
+		_exit(t);
+	}
+
+	close(sockets[1]);
+	index->sockets[s] = sockets[0];
+	index->workers[s] = pid;
+	return true;
+}
+
+SPShardedIndex spShardedIndexCreate(SPPoint* pointsArray, int size, int numOfImages,
+		int numOfShards, SP_KDTREE_SPLIT_METHOD splitMethod) {
+	int i, s, *pointsShards = NULL;
+	char status;
+	bool rslt = true;
+	SPShardedIndex index = NULL;
+	spVerifyArgumentsRn(pointsArray != NULL && size > 0 && numOfImages > 0 &&
+			numOfShards > 0, ERROR_CREATING_SHARDED_INDEX);
+	spVerifyArgumentsRn(isValidPointsArray(pointsArray, size, numOfImages),
+			ERROR_CREATING_SHARDED_INDEX);
+
+	spCalloc(index, struct sp_sharded_index_t, 1);
+	pthread_mutex_init(&(index->exchangeLock), NULL);
+	index->numOfShards = numOfShards < numOfImages ? numOfShards : numOfImages;
+	index->dim = spPointGetDimension(pointsArray[0]);
+	index->precision = spPointGetPrecision(pointsArray[0]);
+	spCallocWc(index->sockets, int, index->numOfShards, freeShardedIndexData(index));
+	spCallocWc(index->workers, pid_t, index->numOfShards, freeShardedIndexData(index));
+	spCallocWc(index->shardSizes, int, index->numOfShards, freeShardedIndexData(index));
+	spCallocWc(pointsShards, int, size, freeShardedIndexData(index));
+
+	for (i = 0; i < size; i++) {
+		pointsShards[i] = getImageShard(spPointGetIndex(pointsArray[i]), numOfImages,
+				index->numOfShards);
+		index->shardSizes[pointsShards[i]]++;
+	}
+
+	// the workers build their trees in parallel
+	for (s = 0; s < index->numOfShards; s++) {
+		index->sockets[s] = NO_SHARD_WORKER;
+		if (rslt && index->shardSizes[s] > 0)
+			rslt = startShardWorker(index, s, pointsArray, pointsShards, size, splitMethod);
+	}
+	for (s = 0; rslt && s < index->numOfShards; s++) {
+		if (index->sockets[s] != NO_SHARD_WORKER)
+			rslt = receiveAll(index->sockets[s], &status, sizeof(char)) &&
+					status == SHARD_READY;
+	}
+	free(pointsShards);
+
+	if (!rslt) {
+		spLoggerSafePrintError(ERROR_STARTING_SHARD_WORKER, __FILE__, __FUNCTION__,
+				__LINE__);
+		stopShardWorkers(index, index->numOfShards);
+		freeShardedIndexData(index);
+		return NULL;
+	}
+	spLoggerSafePrintDebug(DEBUG_SHARD_WORKERS_READY, __FILE__, __FUNCTION__, __LINE__);
+
+	// the workers hold their own copies of the points
+	for (i = 0; i < size; i++)
+		spPointDestroy(pointsArray[i]);
+
+	return index;
+}
+
+int spShardedIndexGetNumOfShards(SPShardedIndex index) {
+	return index == NULL ? -1 : index->numOfShards;
+}
+
+/*
+ * Sends the query batch to every shard: the request kind, the number of queries, the k
+ * of each query and the coordinates of all the queries. The coordinates are sent at the
+ * storage precision, so the shards search the queries as the in process KD-tree searches
+ * the points it stores.
+ *
+ * @returns false in case of memory allocation error or a failed worker
+ */
+static bool scatterQueries(SPShardedIndex index, SPBPQueue* bpqs, SPPoint* queryPoints,
+		int numOfQueries) {
+	int q, s, request = SHARD_REQUEST_QUERIES, *capacities = NULL;
+	size_t rowSize = (size_t) index->dim * spPointGetCoorSize(index->precision);
+	char* rows = NULL;
+	bool rslt = true;
+
+	spCallocWr(capacities, int, numOfQueries, false);
+	spCallocWc(rows, char, numOfQueries * rowSize, free(capacities); return false);
+	for (q = 0; q < numOfQueries; q++) {
+		capacities[q] = spBPQueueGetMaxSize(bpqs[q]);
+		spPointCopyToRow(queryPoints[q], rows + q * rowSize, index->precision);
+	}
+
+	for (s = 0; rslt && s < index->numOfShards; s++) {
+		if (index->sockets[s] == NO_SHARD_WORKER)
+			continue;
+		rslt = sendAll(index->sockets[s], &request, sizeof(int)) &&
+				sendAll(index->sockets[s], &numOfQueries, sizeof(int)) &&
+				sendAll(index->sockets[s], capacities, numOfQueries * sizeof(int)) &&
+				sendAll(index->sockets[s], rows, numOfQueries * rowSize);
+	}
+
+	free(capacities);
+	free(rows);
+	return rslt;
+}
+
+/*
+ * Receives the neighbours found by a shard and merges them into the queues, the bounded
+ * queues keep the k nearest neighbours of all the shards
+ *
+ * @returns false in case of memory allocation error or a failed worker
+ */
+static bool gatherNeighbours(SPShardedIndex index, int s, SPBPQueue* bpqs,
+		int numOfQueries) {
+	int q, i, total = 0, *counts = NULL;
+	ShardNeighbour* neighbours = NULL;
+	bool rslt;
+
+	spCallocWr(counts, int, numOfQueries, false);
+	rslt = receiveAll(index->sockets[s], counts, numOfQueries * sizeof(int));
+	for (q = 0; rslt && q < numOfQueries; q++) {
+		rslt = counts[q] >= 0 && counts[q] <= spBPQueueGetMaxSize(bpqs[q]);
+		total += counts[q];
+	}
+	rslt = rslt && (total == 0 || ((neighbours = (ShardNeighbour*) calloc(total,
+			sizeof(ShardNeighbour))) != NULL && receiveAll(index->sockets[s], neighbours,
+			total * sizeof(ShardNeighbour))));
+
+	for (q = 0, total = 0; rslt && q < numOfQueries; total += counts[q++]) {
+		for (i = 0; rslt && i < counts[q]; i++) {
+			rslt = spBPQueueEnqueueValues(bpqs[q], neighbours[total + i].imageIndex,
+					neighbours[total + i].distance) != SP_BPQUEUE_OUT_OF_MEMORY;
+		}
+	}
+
+	free(counts);
+	free(neighbours);
+	return rslt;
+}
+
+bool spShardedIndexKNN(SPShardedIndex index, SPBPQueue bpq, SPPoint queryPoint) {
+	return spShardedIndexKNNBatch(index, &bpq, &queryPoint, 1);
+}
+
+bool spShardedIndexKNNBatch(SPShardedIndex index, SPBPQueue* bpqs, SPPoint* queryPoints,
+		int numOfQueries) {
+	int q, s;
+	bool rslt;
+	spVerifyArguments(index != NULL && bpqs != NULL && queryPoints != NULL &&
+			numOfQueries > 0, ERROR_SHARDED_KNN, false);
+	for (q = 0; q < numOfQueries; q++) {
+		spVerifyArguments(bpqs[q] != NULL && queryPoints[q] != NULL &&
+				spPointGetDimension(queryPoints[q]) == index->dim, ERROR_SHARDED_KNN, false);
+	}
+
+	// a request and its response must not interleave with those of another thread
+	pthread_mutex_lock(&(index->exchangeLock));
+	rslt = !index->isBroken;
+
+	// all the shards search the batch at the same time, then their results are merged
+	rslt = rslt && scatterQueries(index, bpqs, queryPoints, numOfQueries);
+	for (s = 0; rslt && s < index->numOfShards; s++) {
+		if (index->sockets[s] != NO_SHARD_WORKER)
+			rslt = gatherNeighbours(index, s, bpqs, numOfQueries);
+	}
+	if (!rslt)
+		index->isBroken = true;
+	pthread_mutex_unlock(&(index->exchangeLock));
+
+	spVal(rslt, ERROR_SHARD_WORKER_FAILED, false);
+	return true;
+}
+
+/*
+ * Returns the shard that gets added points: the shard (that has a worker) with the
+ * fewest descriptors
+ */
+static int getSmallestShard(SPShardedIndex index) {
+	int s, smallest = NO_SHARD_WORKER;
+	for (s = 0; s < index->numOfShards; s++) {
+		if (index->sockets[s] != NO_SHARD_WORKER && (smallest == NO_SHARD_WORKER ||
+				index->shardSizes[s] < index->shardSizes[smallest]))
+			smallest = s;
+	}
+	return smallest;
+}
+
+/*
+ * Sends the points (image indices and rows) to the worker of shard s and receives
+ * whether it added them into status
+ *
+ * @returns false in case of a failed worker
+ */
+static bool sendPoints(SPShardedIndex index, int s, const int* imageIndices,
+		const char* rows, int size, char* status) {
+	int request = SHARD_REQUEST_ADD_POINTS;
+	size_t rowSize = (size_t) index->dim * spPointGetCoorSize(index->precision);
+	return sendAll(index->sockets[s], &request, sizeof(int)) &&
+			sendAll(index->sockets[s], &size, sizeof(int)) &&
+			sendAll(index->sockets[s], imageIndices, size * sizeof(int)) &&
+			sendAll(index->sockets[s], rows, size * rowSize) &&
+			receiveAll(index->sockets[s], status, sizeof(char));
+}
+
+bool spShardedIndexAddPoints(SPShardedIndex index, SPPoint* pointsArray, int size) {
+	int i, s, *imageIndices = NULL;
+	size_t rowSize;
+	char status = SHARD_FAILED, *rows = NULL;
+	bool rslt;
+	spVerifyArguments(index != NULL && pointsArray != NULL && size > 0,
+			ERROR_ADDING_SHARD_POINTS, false);
+	for (i = 0; i < size; i++) {
+		spVerifyArguments(pointsArray[i] != NULL && spPointGetIndex(pointsArray[i]) >= 0 &&
+				spPointGetDimension(pointsArray[i]) == index->dim,
+				ERROR_ADDING_SHARD_POINTS, false);
+	}
+
+	// the points are sent at the storage precision of the shards
+	rowSize = (size_t) index->dim * spPointGetCoorSize(index->precision);
+	spCallocWr(imageIndices, int, size, false);
+	spCallocErWcRCb(rows, char, size * rowSize, ERROR_ADDING_SHARD_POINTS,
+			free(imageIndices), false);
+	for (i = 0; i < size; i++) {
+		imageIndices[i] = spPointGetIndex(pointsArray[i]);
+		spPointCopyToRow(pointsArray[i], rows + i * rowSize, index->precision);
+	}
+
+	// the request and its response must not interleave with a query batch
+	pthread_mutex_lock(&(index->exchangeLock));
+	rslt = !index->isBroken;
+	s = getSmallestShard(index);
+	if (rslt && !sendPoints(index, s, imageIndices, rows, size, &status)) {
+		index->isBroken = true;
+		rslt = false;
+	}
+	if (rslt && status == SHARD_READY)
+		index->shardSizes[s] += size;
+	pthread_mutex_unlock(&(index->exchangeLock));
+
+	free(imageIndices);
+	free(rows);
+	spVal(rslt, ERROR_SHARD_WORKER_FAILED, false);
+	spVal(status == SHARD_READY, ERROR_ADDING_SHARD_POINTS, false);
+
+	// the worker holds its own copies of the points
+	for (i = 0; i < size; i++)
+		spPointDestroy(pointsArray[i]);
+	return true;
+}
+
+void spShardedIndexDestroy(SPShardedIndex index) {
+	if (index == NULL)
+		return;
+	stopShardWorkers(index, index->numOfShards);
+	freeShardedIndexData(index);
+}
@@ -0,0 +1,132 @@
+#ifndef SPSHARDEDINDEX_H_
+#define SPSHARDEDINDEX_H_
+
+#include <stdbool.h>
+#include "../../SPPoint.h"
+#include "../../SPConfig.h"
+#include "../bpqueue_ds/SPBPriorityQueue.h"
+
+/**
+ * SP Sharded Index summary
+ *
+ * An exact nearest neighbours index that is partitioned by image index range into
+ * shards. Each shard is a KD-tree over the descriptors of its images, built and
+ * searched by its own worker process, so no single process holds all the descriptors
+ * and the shards are built in parallel.
+ *
+ * The workers are forked when the index is created and serve the index process (the
+ * coordinator) over local Unix socket pairs. A query batch is scattered to all the
+ * shards, each shard returns the k nearest neighbours of every query among its own
+ * descriptors, and the coordinator gathers them into the bounded queue of each query.
+ * Since every global nearest neighbour is one of the nearest neighbours of its shard,
+ * the merged result is the same as the one of a single KD-tree over all the descriptors.
+ *
+ * The index may be searched by several threads at once, but a query batch is a single
+ * request and response exchange per shard, so the batches of the threads are served one
+ * after the other. Points added to the index are sent to the shard with the fewest
+ * descriptors, whose worker rebuilds its tree with them.
+ *
+ * The following functions are supported:
+ *
+ * spShardedIndexCreate		- Partitions the given points and starts the shard workers
+ * spShardedIndexGetNumOfShards	- Returns the number of shards
+ * spShardedIndexAddPoints		- Adds points to the smallest shard
+ * spShardedIndexKNN			- Finds the k nearest neighbours of a query point
+ * spShardedIndexKNNBatch		- Finds the k nearest neighbours of several query points
+ * spShardedIndexDestroy		- Stops the shard workers and frees the index
+ */
+
+/** Type for defining the sharded index **/
+typedef struct sp_sharded_index_t* SPShardedIndex;
+
+/*
+ * The method partitions the points into numOfShards shards of consecutive image index
+ * ranges (of almost equal numbers of images), and forks a worker process per shard that
+ * builds the KD-tree of the shard. The method returns once all the workers are ready.
+ * A shard with no descriptors has no worker.
+ * The index takes ownership of the points: on success they are destroyed, since the
+ * workers hold their own copies (on failure the points are not destroyed).
+ *
+ * @param pointsArray - the database descriptors (all at the same dimension), with image
+ * 						indices in [0, numOfImages)
+ * @param size - the size of pointsArray
+ * @param numOfImages - the number of images
+ * @param numOfShards - the number of shards, at least 1 (at most numOfImages shards are
+ * 						used)
+ * @param splitMethod - the split method of the shards KD-trees
+ *
+ * @returns
+ * NULL in case of invalid arguments, memory allocation error or a worker that could not
+ * be started, otherwise the new index
+ *
+ * @logger - the method logs allocation and arguments errors if needed
+ * debug prints are also printed to the logger (by the coordinator only)
+ */
+SPShardedIndex spShardedIndexCreate(SPPoint* pointsArray, int size, int numOfImages,
+		int numOfShards, SP_KDTREE_SPLIT_METHOD splitMethod);
+
+/*
+ * Returns the number of shards of the index, or -1 if index is NULL
+ */
+int spShardedIndexGetNumOfShards(SPShardedIndex index);
+
+/*
+ * The method sends the given points (at the storage precision of the index) to the
+ * worker of the shard with the fewest descriptors, which rebuilds its KD-tree with them.
+ * The index takes ownership of the points as spShardedIndexCreate does.
+ *
+ * @param index - the index to add the points to
+ * @param pointsArray - the new descriptors, at the dimension of the index and with
+ * 						non-negative image indices
+ * @param size - the size of pointsArray
+ *
+ * @returns false in case of invalid arguments, memory allocation error (the index is
+ * not changed) or a failed worker, true otherwise
+ *
+ * @logger - the method logs allocation and arguments errors if needed
+ */
+bool spShardedIndexAddPoints(SPShardedIndex index, SPPoint* pointsArray, int size);
+
+/*
+ * The method finds the nearest neighbours of the query point in all the shards, and
+ * enqueues their image indices and squared distances into bpq, as kNearestNeighbors
+ * does for a single KD-tree.
+ *
+ * @param index - the index to search
+ * @param bpq - the queue that is filled with the nearest neighbours, its capacity is k
+ * @param queryPoint - the query point
+ *
+ * @returns false in case of invalid arguments, memory allocation error or a failed
+ * worker, true otherwise
+ *
+ * @logger - the method logs allocation and arguments errors if needed
+ */
+bool spShardedIndexKNN(SPShardedIndex index, SPBPQueue bpq, SPPoint queryPoint);
+
+/*
+ * The method finds the nearest neighbours of every query point, sending all the queries
+ * to each shard in a single request. The neighbours of queryPoints[i] are enqueued into
+ * bpqs[i].
+ * Once a worker fails the index is no longer usable, all the following searches fail.
+ *
+ * @param index - the index to search
+ * @param bpqs - numOfQueries queues, the capacity of each queue is its k
+ * @param queryPoints - the query points
+ * @param numOfQueries - the size of bpqs and of queryPoints
+ *
+ * @returns false in case of invalid arguments, memory allocation error or a failed
+ * worker, true otherwise
+ *
+ * @logger - the method logs allocation and arguments errors if needed
+ */
+bool spShardedIndexKNNBatch(SPShardedIndex index, SPBPQueue* bpqs, SPPoint* queryPoints,
+		int numOfQueries);
+
+/*
+ * Stops the shard workers, waits for them to exit and frees all the resources of the
+ * index.
+ * If index is NULL nothing happens.
+ */
+void spShardedIndexDestroy(SPShardedIndex index);
+
+#endif /* SPSHARDEDINDEX_H_ */
@@ -7,6 +7,7 @@
 #define INVALID_DIM 								-1
 #define ERROR_CREATING_KD_INNER_NODE 				"Could not create inner node for KD tree"
 #define ERROR_INITIALIZING_KD_TREE	 				"Could not create KD tree"
+#define ERROR_ADDING_KD_TREE_POINTS					"Could not add the points to the KD tree"
 
 #define WARNING_KDTREE_NODE_NULL					"KDTreeNode object is null when destroy is called"
 
@@ -95,7 +96,7 @@ SPKDTreeNode createInnerNode(SPKDTreeNode node, SPKDArray array,
 SPKDTreeNode internalInitKDTree(SPKDArray array, SP_KDTREE_SPLIT_METHOD splitMethod,
 		int recDepth) {
 	SPKDTreeNode ret;
-	int splitDim;
+	int splitDim = 0;
 
 	spVerifyArgumentsRn(array, ERROR_INITIALIZING_KD_TREE);
 
@@ -120,6 +121,52 @@ SPKDTreeNode internalInitKDTree(SPKDArray array, SP_KDTREE_SPLIT_METHOD splitMet
 	return createInnerNode(ret, array, splitMethod, recDepth, splitDim);
 }
 
+/*
+ * Returns the number of points at the leafs of the tree
+ */
+static int countLeafs(SPKDTreeNode kdTreeNode) {
+	if (isLeaf(kdTreeNode))
+		return 1;
+	return countLeafs(kdTreeNode->kdtLeft) + countLeafs(kdTreeNode->kdtRight);
+}
+
+/*
+ * Copies the points at the leafs of the tree into pointsArray, from *size on
+ */
+static void collectLeafs(SPKDTreeNode kdTreeNode, SPPoint* pointsArray, int* size) {
+	if (isLeaf(kdTreeNode)) {
+		pointsArray[(*size)++] = kdTreeNode->data;
+		return;
+	}
+	collectLeafs(kdTreeNode->kdtLeft, pointsArray, size);
+	collectLeafs(kdTreeNode->kdtRight, pointsArray, size);
+}
+
+SPKDTreeNode spKDTreeAddPoints(SPKDTreeNode kdTreeNode, SPPoint* pointsArray, int size,
+		SP_KDTREE_SPLIT_METHOD splitMethod) {
+	SPKDTreeNode ret;
+	SPPoint* allPoints = NULL;
+	int i, treeSize;
+
+	spVerifyArgumentsRn(kdTreeNode && pointsArray && size > 0,
+			ERROR_ADDING_KD_TREE_POINTS);
+
+	treeSize = countLeafs(kdTreeNode);
+	spCalloc(allPoints, SPPoint, treeSize + size);
+	treeSize = 0;
+	collectLeafs(kdTreeNode, allPoints, &treeSize);
+	for (i = 0; i < size; i++)
+		allPoints[treeSize + i] = pointsArray[i];
+
+	ret = InitKDTreeFromPoints(allPoints, treeSize + size, splitMethod);
+	free(allPoints);
+	spValRn(ret, ERROR_ADDING_KD_TREE_POINTS);
+
+	// the points moved to the new tree
+	spKDTreeDestroy(kdTreeNode, false);
+	return ret;
+}
+
 void spKDTreeDestroy(SPKDTreeNode kdTreeNode, bool freePointsData) {
 	if (kdTreeNode) {
 		spFree(kdTreeNode->val);
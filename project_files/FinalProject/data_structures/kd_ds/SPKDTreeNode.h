@@ -168,6 +168,25 @@ SPKDTreeNode createInnerNode(SPKDTreeNode node, SPKDArray array,
 SPKDTreeNode internalInitKDTree(SPKDArray array, SP_KDTREE_SPLIT_METHOD splitMethod,
 		int recDepth);
 
+/*
+ * The method rebuilds the kd-tree over its points and the given points, the new tree
+ * takes ownership of all of them (the points of a kd-tree are not copied).
+ *
+ * @param kdTreeNode - the root of the tree to add the points to
+ * @param pointsArray - the new points, at the dimension of the tree points
+ * @param size - the size of pointsArray
+ * @param splitMethod - the split method of the new tree
+ * @returns -
+ *  NULL in case of invalid arguments or memory allocation error, in which case the tree
+ *  and the points are not changed, otherwise the root of the new tree (the nodes of the
+ *  given tree are freed)
+ *
+ * @logger -
+ * in case of any type of failure the relevant error is logged to the logger
+ */
+SPKDTreeNode spKDTreeAddPoints(SPKDTreeNode kdTreeNode, SPPoint* pointsArray, int size,
+		SP_KDTREE_SPLIT_METHOD splitMethod);
+
 /**
  * Frees all memory resources associated with kdTreeNode.
  * If kdTreeNode == NULL nothing is done.
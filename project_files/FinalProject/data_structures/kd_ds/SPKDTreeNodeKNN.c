@@ -1,9 +1,23 @@
 #include "SPKDTreeNodeKNN.h"
 #include "../../general_utils/SPUtils.h"
+#include "../../general_utils/SPInstrumentation.h"
 #include "assert.h"
 
 #define ERROR_PUSHING_LIST_ELEMENT 							    "Could not add list element due to memory issue, k-NN search failed"
-#define ERROR_CREATING_LIST_ELEMENT 							"Could not create list element, k-NN search failed"
+
+#define KNN_DEADLINE_LEAVES_BATCH	32 // leaves scanned between two reads of the clock
+
+/*
+ * The state of a search with a deadline
+ * deadline - the spInstrumentationNow time the search stops at, SP_KNN_NO_DEADLINE if none
+ * leavesUntilCheck - the leaves left to scan until the clock is read again
+ * isExpired - true once the deadline passed
+ */
+typedef struct sp_knn_deadline_t {
+	uint64_t deadline;
+	int leavesUntilCheck;
+	bool isExpired;
+} SPKNNDeadline;
 
 double getSquaredDistance(double a, double b){
 	return (a-b)*(a-b);
@@ -16,16 +30,13 @@ SPKDTreeNode getSecondChild(SPKDTreeNode tree, SPKDTreeNode firstChild){
 
 
 bool pushLeafToQueue(SPPoint currPoint, SPBPQueue bpq, SPPoint queryPoint){
-	SPListElement elem = NULL;
 	SP_BPQUEUE_MSG queueMessage;
 	double distance = spPointL2SquaredDistance(currPoint, queryPoint);
 	if (distance <= epsilon) // this is the most precise we can get => any lesser number should be treated as same point
 		distance = 0;
-	spVal((elem = spListElementCreate(spPointGetIndex(currPoint), distance)),
-			ERROR_CREATING_LIST_ELEMENT, false);
 
-	queueMessage = spBPQueueEnqueue(bpq, elem);
-	spListElementDestroy(elem);
+	// no list element is created for the leaf
+	queueMessage = spBPQueueEnqueueValues(bpq, spPointGetIndex(currPoint), distance);
 
 	spValWc(queueMessage == SP_BPQUEUE_FULL  || queueMessage  == SP_BPQUEUE_SUCCESS,
 			ERROR_PUSHING_LIST_ELEMENT,
@@ -40,16 +51,33 @@ bool isCrossingHypersphere(SPKDTreeNode node, double coorValue, double maxBPQVal
 	return getSquaredDistance(*(node->val),coorValue) <= maxBPQValue;
 }
 
-bool kNearestNeighbors(SPKDTreeNode curr, SPBPQueue bpq, SPPoint queryPoint){
-	assert(queryPoint != NULL && bpq != NULL);
+/*
+ * Reads the clock once every KNN_DEADLINE_LEAVES_BATCH scanned leaves, and marks the
+ * search as expired once its deadline passed
+ */
+static void checkDeadline(SPKNNDeadline* deadline){
+	if (deadline->deadline == SP_KNN_NO_DEADLINE || --(deadline->leavesUntilCheck) > 0)
+		return;
+	deadline->leavesUntilCheck = KNN_DEADLINE_LEAVES_BATCH;
+	deadline->isExpired = spInstrumentationNow() >= deadline->deadline;
+}
+
+/*
+ * Searches the subtree of curr as kNearestNeighbors does, until the search deadline
+ */
+static bool searchSubtree(SPKDTreeNode curr, SPBPQueue bpq, SPPoint queryPoint,
+		SPKNNDeadline* deadline){
 	double relevantAxisValue;
 	SPKDTreeNode candidate;
 
 	if (curr == NULL){
 		return true;
 	}
+	spInstrCount(SP_INSTR_NODES_VISITED);
 	//not null
 	if (isLeaf(curr)){
+		spInstrCount(SP_INSTR_LEAVES_SCANNED);
+		checkDeadline(deadline);
 		return pushLeafToQueue(curr->data,bpq,queryPoint);
 	}
 
@@ -61,14 +89,32 @@ bool kNearestNeighbors(SPKDTreeNode curr, SPBPQueue bpq, SPPoint queryPoint){
 	candidate = (relevantAxisValue <= *(curr->val)) ? curr->kdtLeft : curr->kdtRight;
 
 	//Recursively continue to the next axis process
-	if (!kNearestNeighbors(candidate, bpq, queryPoint))
+	if (!searchSubtree(candidate, bpq, queryPoint, deadline))
 		return false;
 
-	//check the other plane if needed
-	if (!spBPQueueIsFull(bpq) || isCrossingHypersphere(curr, relevantAxisValue, spBPQueueMaxValue(bpq))){
-		return kNearestNeighbors(getSecondChild(curr,candidate) ,bpq,queryPoint);
+	//check the other plane if needed, once the deadline passed the descents that were
+	//started are completed without backtracking
+	if (!deadline->isExpired && (!spBPQueueIsFull(bpq) ||
+			isCrossingHypersphere(curr, relevantAxisValue, spBPQueueMaxValue(bpq)))){
+		return searchSubtree(getSecondChild(curr,candidate), bpq, queryPoint, deadline);
 	}
 
 	return true;
 }
 
+bool kNearestNeighbors(SPKDTreeNode curr, SPBPQueue bpq, SPPoint queryPoint){
+	SPKNNDeadline deadline = { SP_KNN_NO_DEADLINE, KNN_DEADLINE_LEAVES_BATCH, false };
+	assert(queryPoint != NULL && bpq != NULL);
+	return searchSubtree(curr, bpq, queryPoint, &deadline);
+}
+
+bool kNearestNeighborsWithDeadline(SPKDTreeNode curr, SPBPQueue bpq, SPPoint queryPoint,
+		uint64_t deadline, bool* isExpired){
+	SPKNNDeadline searchDeadline = { deadline, KNN_DEADLINE_LEAVES_BATCH, false };
+	bool rslt;
+	assert(queryPoint != NULL && bpq != NULL && isExpired != NULL);
+	rslt = searchSubtree(curr, bpq, queryPoint, &searchDeadline);
+	*isExpired = searchDeadline.isExpired;
+	return rslt;
+}
+
@@ -2,8 +2,12 @@
 #define SPKDTREENODEKNN_H_
 
 #include "SPKDTreeNode.h"
+#include <stdint.h>
 #include "../bpqueue_ds/SPBPriorityQueue.h"
 
+/** A deadline that never passes **/
+#define SP_KNN_NO_DEADLINE	0
+
 /*
  * The method returns a squared distance between 2 real values
  * @param a - first value
@@ -29,6 +33,27 @@ double getSquaredDistance(double a, double b);
  */
 bool kNearestNeighbors(SPKDTreeNode curr, SPBPQueue bpq, SPPoint queryPoint);
 
+/*
+ * The method fills the bpq with the k-nearest points to queryPoint, as kNearestNeighbors
+ * does, until the given deadline. The clock is read between batches of scanned leaves,
+ * and once the deadline passed the search stops backtracking: the descents that were
+ * started are completed and bpq keeps the points found so far, which may be farther
+ * than the k-nearest ones.
+ * Pre assumptions - bpq, queryPoint and isExpired are not NULL
+ *
+ * @param curr - the current tree node that is tested
+ * @param bpq - a pre-initialized priority queue that returns the k-nearest points
+ * @param queryPoint - the query point
+ * @param deadline - the spInstrumentationNow time to stop at, SP_KNN_NO_DEADLINE if none
+ * @param isExpired - set to true iff the search was stopped by the deadline
+ *
+ * @returns true iff the search was successful (a search stopped by the deadline is)
+ *
+ * @logger - the method logs the relevant error to the logger
+ */
+bool kNearestNeighborsWithDeadline(SPKDTreeNode curr, SPBPQueue bpq, SPPoint queryPoint,
+		uint64_t deadline, bool* isExpired);
+
 /*
  * The methods returns the other son of the tree.
  * Pre assumptions - tree != NULL and first child is either the right or
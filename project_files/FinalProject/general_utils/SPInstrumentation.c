@@ -0,0 +1,209 @@
+#define _POSIX_C_SOURCE 200809L // clock_gettime under -std=c99
+
+#include <stdio.h>
+#include <string.h>
+#include <inttypes.h>
+#include <time.h>
+#include <pthread.h>
+#include "SPInstrumentation.h"
+#include "SPUtils.h"
+
+#define NSEC_PER_SEC						1000000000ULL
+#define NSEC_PER_MSEC						1000000.0
+#define INSTRUMENTATION_OPEN_MODE			"w"
+
+#define WARNING_WRITING_INSTRUMENTATION		"Could not write the instrumentation statistics"
+
+#define JSON_START							"{\n\t\"queries\": %" PRIu64 ",\n"
+#define JSON_PHASES_START					"\t\"phases\": {\n"
+#define JSON_PHASE							"\t\t\"%s\": {\"calls\": %" PRIu64 ", \"total_ms\": %.3f, " \
+											"\"mean_ms\": %.3f, \"max_ms\": %.3f}%s\n"
+#define JSON_COUNTERS_START					"\t},\n\t\"counters\": {\n"
+#define JSON_COUNTER						"\t\t\"%s\": {\"total\": %" PRIu64 ", \"per_query_mean\": %.1f, " \
+											"\"per_query_max\": %" PRIu64 "}%s\n"
+#define JSON_END							"\t}\n}\n"
+
+static const char* phaseNames[SP_INSTR_NUM_OF_PHASES] = { "config_load", "pca_load",
+		"feats_parse", "index_build", "image_decode", "features_extraction", "pca_projection",
+		"knn_search", "ranking", "query" };
+
+static const char* counterNames[SP_INSTR_NUM_OF_COUNTERS] = { "nodes_visited",
+		"leaves_scanned", "distance_evals", "queue_inserts", "queue_rejections",
+		"query_cache_hits", "query_cache_misses", "truncated_queries" };
+
+/*
+ * The process statistics, updated by all the threads with atomic operations
+ */
+static uint64_t phaseCalls[SP_INSTR_NUM_OF_PHASES];
+static uint64_t phaseTotalTime[SP_INSTR_NUM_OF_PHASES];
+static uint64_t phaseMaxTime[SP_INSTR_NUM_OF_PHASES];
+static uint64_t counterTotals[SP_INSTR_NUM_OF_COUNTERS];
+static uint64_t counterQueriesTotals[SP_INSTR_NUM_OF_COUNTERS]; // of the ended queries only
+static uint64_t counterQueryMax[SP_INSTR_NUM_OF_COUNTERS];
+static uint64_t numOfQueries;
+
+__thread uint64_t spInstrumentationCounters[SP_INSTR_NUM_OF_COUNTERS];
+__thread bool spInstrumentationIsThreadRegistered = false;
+
+/*
+ * The key whose destructor adds the counters of an exiting registered thread
+ */
+static pthread_key_t threadExitKey;
+static pthread_once_t threadExitKeyOnce = PTHREAD_ONCE_INIT;
+static bool isThreadExitKeyCreated = false;
+
+/*
+ * The state of the calling thread
+ */
+static __thread uint64_t addedCounters[SP_INSTR_NUM_OF_COUNTERS]; // already in counterTotals
+static __thread uint64_t queryStartCounters[SP_INSTR_NUM_OF_COUNTERS];
+static __thread uint64_t queryStartTime;
+static __thread bool isInQuery = false;
+
+/*
+ * Sets *target to value if value is greater
+ */
+static void atomicMax(uint64_t* target, uint64_t value) {
+	uint64_t current = __atomic_load_n(target, __ATOMIC_RELAXED);
+	while (value > current && !__atomic_compare_exchange_n(target, &current, value, true,
+			__ATOMIC_RELAXED, __ATOMIC_RELAXED));
+}
+
+/*
+ * Adds the counters of the calling thread that were not added yet to the process totals
+ */
+static void addThreadCounters() {
+	int i;
+	for (i = 0; i < SP_INSTR_NUM_OF_COUNTERS; i++) {
+		if (spInstrumentationCounters[i] != addedCounters[i])
+			__atomic_fetch_add(&(counterTotals[i]),
+					spInstrumentationCounters[i] - addedCounters[i], __ATOMIC_RELAXED);
+		addedCounters[i] = spInstrumentationCounters[i];
+	}
+}
+
+/*
+ * Adds the counters of an exiting thread, its thread local state is still valid when the
+ * destructors of its keys are called
+ */
+static void threadExit(void* counters) {
+	addThreadCounters();
+}
+
+static void createThreadExitKey() {
+	isThreadExitKeyCreated = pthread_key_create(&threadExitKey, threadExit) == 0;
+}
+
+bool spInstrumentationRegisterThread() {
+	pthread_once(&threadExitKeyOnce, createThreadExitKey);
+	// the destructor is called only for a thread whose key value is not NULL
+	spInstrumentationIsThreadRegistered = isThreadExitKeyCreated &&
+			pthread_setspecific(threadExitKey, spInstrumentationCounters) == 0;
+	return spInstrumentationIsThreadRegistered;
+}
+
+uint64_t spInstrumentationNow() {
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (uint64_t) now.tv_sec * NSEC_PER_SEC + (uint64_t) now.tv_nsec;
+}
+
+void spInstrumentationAddPhaseTime(SP_INSTR_PHASE phase, uint64_t nanoseconds) {
+	__atomic_fetch_add(&(phaseCalls[phase]), 1, __ATOMIC_RELAXED);
+	__atomic_fetch_add(&(phaseTotalTime[phase]), nanoseconds, __ATOMIC_RELAXED);
+	atomicMax(&(phaseMaxTime[phase]), nanoseconds);
+}
+
+void spInstrumentationQueryBegin() {
+	memcpy(queryStartCounters, spInstrumentationCounters, sizeof(queryStartCounters));
+	queryStartTime = spInstrumentationNow();
+	isInQuery = true;
+}
+
+void spInstrumentationQueryEnd() {
+	uint64_t queryCount;
+	int i;
+
+	if (!isInQuery)
+		return;
+	isInQuery = false;
+	spInstrumentationAddPhaseTime(SP_INSTR_QUERY, spInstrumentationNow() - queryStartTime);
+	for (i = 0; i < SP_INSTR_NUM_OF_COUNTERS; i++) {
+		queryCount = spInstrumentationCounters[i] - queryStartCounters[i];
+		__atomic_fetch_add(&(counterQueriesTotals[i]), queryCount, __ATOMIC_RELAXED);
+		atomicMax(&(counterQueryMax[i]), queryCount);
+	}
+	__atomic_fetch_add(&numOfQueries, 1, __ATOMIC_RELAXED);
+	addThreadCounters();
+}
+
+/*
+ * Writes the JSON object of the process statistics (as documented at spInstrumentationDump)
+ *
+ * @return false if a write failed, true otherwise
+ */
+static bool writeStatistics(FILE* output) {
+	uint64_t calls, maxTime, queries = __atomic_load_n(&numOfQueries, __ATOMIC_RELAXED);
+	double totalTime;
+	bool isWritten;
+	int i;
+
+	isWritten = fprintf(output, JSON_START, queries) >= 0 &&
+			fprintf(output, JSON_PHASES_START) >= 0;
+	for (i = 0; isWritten && i < SP_INSTR_NUM_OF_PHASES; i++) {
+		calls = __atomic_load_n(&(phaseCalls[i]), __ATOMIC_RELAXED);
+		totalTime = __atomic_load_n(&(phaseTotalTime[i]), __ATOMIC_RELAXED) / NSEC_PER_MSEC;
+		maxTime = __atomic_load_n(&(phaseMaxTime[i]), __ATOMIC_RELAXED);
+		isWritten = fprintf(output, JSON_PHASE, phaseNames[i], calls, totalTime,
+				calls > 0 ? totalTime / calls : 0.0, maxTime / NSEC_PER_MSEC,
+				i < SP_INSTR_NUM_OF_PHASES - 1 ? "," : "") >= 0;
+	}
+
+	isWritten = isWritten && fprintf(output, JSON_COUNTERS_START) >= 0;
+	for (i = 0; isWritten && i < SP_INSTR_NUM_OF_COUNTERS; i++) {
+		isWritten = fprintf(output, JSON_COUNTER, counterNames[i],
+				__atomic_load_n(&(counterTotals[i]), __ATOMIC_RELAXED), queries > 0 ?
+				(double) __atomic_load_n(&(counterQueriesTotals[i]), __ATOMIC_RELAXED) /
+				queries : 0.0, __atomic_load_n(&(counterQueryMax[i]), __ATOMIC_RELAXED),
+				i < SP_INSTR_NUM_OF_COUNTERS - 1 ? "," : "") >= 0;
+	}
+	return isWritten && fprintf(output, JSON_END) >= 0;
+}
+
+bool spInstrumentationDump(const char* filename) {
+	FILE* output = stdout;
+	bool isWritten;
+
+	addThreadCounters();
+	if (filename != NULL && (output = fopen(filename, INSTRUMENTATION_OPEN_MODE)) == NULL) {
+		spLoggerSafePrintWarning(WARNING_WRITING_INSTRUMENTATION, __FILE__, __FUNCTION__,
+				__LINE__);
+		return false;
+	}
+
+	isWritten = writeStatistics(output);
+	if (filename != NULL)
+		isWritten = fclose(output) == 0 && isWritten;
+	else
+		isWritten = fflush(output) == 0 && isWritten;
+
+	spValWarning(isWritten, WARNING_WRITING_INSTRUMENTATION, , );
+	return isWritten;
+}
+
+void spInstrumentationReset() {
+	int i;
+	for (i = 0; i < SP_INSTR_NUM_OF_PHASES; i++) {
+		__atomic_store_n(&(phaseCalls[i]), 0, __ATOMIC_RELAXED);
+		__atomic_store_n(&(phaseTotalTime[i]), 0, __ATOMIC_RELAXED);
+		__atomic_store_n(&(phaseMaxTime[i]), 0, __ATOMIC_RELAXED);
+	}
+	for (i = 0; i < SP_INSTR_NUM_OF_COUNTERS; i++) {
+		__atomic_store_n(&(counterTotals[i]), 0, __ATOMIC_RELAXED);
+		__atomic_store_n(&(counterQueriesTotals[i]), 0, __ATOMIC_RELAXED);
+		__atomic_store_n(&(counterQueryMax[i]), 0, __ATOMIC_RELAXED);
+		spInstrumentationCounters[i] = addedCounters[i] = 0;
+	}
+	__atomic_store_n(&numOfQueries, 0, __ATOMIC_RELAXED);
+	isInQuery = false;
+}
@@ -0,0 +1,149 @@
+#ifndef SPINSTRUMENTATION_H_
+#define SPINSTRUMENTATION_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * SP Instrumentation summary
+ *
+ * Timers of the program phases (on the monotonic clock) and counters of the search work,
+ * aggregated per process and per query, and written as JSON on request.
+ *
+ * The instrumentation points are compiled only when SP_INSTRUMENTATION is defined, e.g. by
+ * 'make INSTRUMENTATION_FLAG=-DSP_INSTRUMENTATION'. Otherwise all the macros below expand
+ * to nothing, so the instrumented code costs nothing at run time (the functions are
+ * always compiled, but nothing calls them).
+ *
+ * A counter is incremented in a thread local copy, and the copy is added to the process
+ * totals when the thread ends a query, dumps the statistics or exits (a thread is
+ * registered for its exit by its first count), so the work of a scan thread of an index
+ * is counted once it exits. Timers are added to the process totals when they stop.
+ *
+ * A query is the work of a thread between spInstrQueryBegin and spInstrQueryEnd, for
+ * every counter the mean and max of the queries are kept, and the query time is the
+ * SP_INSTR_QUERY phase.
+ *
+ * The following macros are supported:
+ * spInstrTimerStart	- Declares a local timer and starts it
+ * spInstrTimerStop		- Adds the time passed since the timer started to a phase
+ * spInstrCount			- Increments a counter of the calling thread
+ * spInstrCountN		- Adds a number to a counter of the calling thread
+ * spInstrQueryBegin	- Starts a query of the calling thread
+ * spInstrQueryEnd		- Ends the query of the calling thread
+ * spInstrDump			- Writes the process statistics as JSON to a file
+ * spInstrReset			- Resets the process statistics
+ */
+
+/** The timed phases of the program **/
+typedef enum sp_instr_phase_t {
+	SP_INSTR_CONFIG_LOAD,
+	SP_INSTR_PCA_LOAD,
+	SP_INSTR_FEATS_PARSE,
+	SP_INSTR_INDEX_BUILD,
+	SP_INSTR_IMAGE_DECODE, // of an image, at the capped resolution if there is a cap
+	SP_INSTR_FEATURES_EXTRACTION, // SIFT of a query image
+	SP_INSTR_PCA_PROJECTION, // of the SIFT descriptors of a query image
+	SP_INSTR_KNN_SEARCH,
+	SP_INSTR_RANKING,
+	SP_INSTR_QUERY, // from spInstrQueryBegin to spInstrQueryEnd
+	SP_INSTR_NUM_OF_PHASES
+} SP_INSTR_PHASE;
+
+/** The counters of the search work **/
+typedef enum sp_instr_counter_t {
+	SP_INSTR_NODES_VISITED, // KD-tree nodes visited by kNearestNeighbors
+	SP_INSTR_LEAVES_SCANNED, // KD-tree leaves visited by kNearestNeighbors
+	SP_INSTR_DISTANCE_EVALS,
+	SP_INSTR_QUEUE_INSERTS, // elements inserted into a bounded priority queue
+	SP_INSTR_QUEUE_REJECTIONS, // elements rejected by a full bounded priority queue
+	SP_INSTR_QUERY_CACHE_HITS, // query images whose descriptors were found in the cache
+	SP_INSTR_QUERY_CACHE_MISSES, // query images whose descriptors were not cached
+	SP_INSTR_TRUNCATED_QUERIES, // searches stopped by their deadline
+	SP_INSTR_NUM_OF_COUNTERS
+} SP_INSTR_COUNTER;
+
+// the counters of the calling thread, use spInstrCount rather than the array
+extern __thread uint64_t spInstrumentationCounters[SP_INSTR_NUM_OF_COUNTERS];
+
+// whether the counters of the calling thread are added to the process totals on its exit
+extern __thread bool spInstrumentationIsThreadRegistered;
+
+/*
+ * Returns the monotonic clock time in nanoseconds
+ */
+uint64_t spInstrumentationNow();
+
+/*
+ * Adds a call of the given duration to the phase statistics
+ */
+void spInstrumentationAddPhaseTime(SP_INSTR_PHASE phase, uint64_t nanoseconds);
+
+/*
+ * Registers the calling thread so its counters are added to the process totals when it
+ * exits, spInstrCount registers the thread by its first count
+ *
+ * @return true if the thread is registered, false if the registration failed (the
+ * counters are then added only by spInstrumentationQueryEnd and spInstrumentationDump)
+ */
+bool spInstrumentationRegisterThread();
+
+/*
+ * Starts a query of the calling thread, a query that was not ended is discarded
+ */
+void spInstrumentationQueryBegin();
+
+/*
+ * Ends the query of the calling thread, and adds its counters and its time to the
+ * process statistics. If the thread has no query nothing happens.
+ */
+void spInstrumentationQueryEnd();
+
+/*
+ * Writes the process statistics as a JSON object to the given file, after the counters
+ * of the calling thread are added to them. The object has the number of queries, the
+ * calls, total, mean and max milliseconds of every phase, and the total, per query mean
+ * and per query max of every counter.
+ *
+ * @param filename - the file to write, or NULL for stdout
+ *
+ * @return false if the file could not be written, true otherwise
+ *
+ * @logger - a warning is logged if the file could not be written
+ */
+bool spInstrumentationDump(const char* filename);
+
+/*
+ * Resets the process statistics and the counters of the calling thread
+ */
+void spInstrumentationReset();
+
+#ifdef SP_INSTRUMENTATION
+
+#define spInstrTimerStart(timer) uint64_t timer = spInstrumentationNow()
+#define spInstrTimerStop(timer, phase) \
+	spInstrumentationAddPhaseTime(phase, spInstrumentationNow() - (timer))
+#define spInstrRegisterThread() \
+	((void) (spInstrumentationIsThreadRegistered || spInstrumentationRegisterThread()))
+#define spInstrCount(counter) (spInstrRegisterThread(), spInstrumentationCounters[counter]++)
+#define spInstrCountN(counter, n) (spInstrRegisterThread(), \
+	spInstrumentationCounters[counter] += (uint64_t) (n))
+#define spInstrQueryBegin() spInstrumentationQueryBegin()
+#define spInstrQueryEnd() spInstrumentationQueryEnd()
+#define spInstrDump(filename) ((void) spInstrumentationDump(filename))
+#define spInstrReset() spInstrumentationReset()
+
+#else
+
+#define spInstrTimerStart(timer)
+#define spInstrTimerStop(timer, phase) ((void) 0)
+#define spInstrCount(counter) ((void) 0)
+#define spInstrCountN(counter, n) ((void) 0)
+#define spInstrQueryBegin() ((void) 0)
+#define spInstrQueryEnd() ((void) 0)
+#define spInstrDump(filename) ((void) 0)
+#define spInstrReset() ((void) 0)
+
+#endif
+
+#endif /* SPINSTRUMENTATION_H_ */
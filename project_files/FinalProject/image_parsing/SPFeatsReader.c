@@ -0,0 +1,307 @@
+#define _POSIX_C_SOURCE 200809L // open and read under -std=c99
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include "SPFeatsReader.h"
+#include "../SPLogger.h"
+#include "../general_utils/SPUtils.h"
+
+#define FEATS_READ_BLOCK_SIZE				65536 // the initial buffer, it grows to hold a longer line
+#define FEATS_INITIAL_ROW_SIZE				128
+#define MAX_EXACT_MANTISSA					9007199254740992ULL // 2^53
+#define MAX_MANTISSA_DIGITS					19 // fit in uint64_t
+#define MAX_EXACT_POWER_OF_TEN				22 // 10^22 is the largest power of ten a double holds exactly
+#define MAX_NUMBER_LEN						512 // of a number that is parsed by strtod
+#define MAX_INT_VALUE						1000000000
+#define FIELD_SEPARATOR						','
+#define LINE_SEPARATOR						'\n'
+#define DECIMAL_POINT						'.'
+#define MINUS_SIGN							'-'
+#define END_OF_STRING						'\0'
+
+#define FAILED_OPEN_FILE					"Could not open file"
+#define FAILED_READING_FILE					"Failed while reading from file"
+#define FAILED_LOADING_IMAGE_DATA			"Failed at loading an image data"
+#define FAILED_NOT_MATCHING_CONFIG			"Failed loading image data, configuration data does not match"
+#define FAILED_STRING_PARSING_WRONG_FORMAT	"Wrong format in image2string parsing"
+#define FAILED_PARSING_STRING_TO_POINT		"Failed parsing point from string"
+
+static const double powersOfTen[MAX_EXACT_POWER_OF_TEN + 1] = { 1e0, 1e1, 1e2, 1e3, 1e4,
+		1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11, 1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19,
+		1e20, 1e21, 1e22 };
+
+/*
+ * The read buffer of a file, the unread data is data[start..end)
+ */
+typedef struct feats_buffer_t {
+	int fd;
+	char* data;
+	size_t size; // one byte more than the data it can hold, for a terminator
+	size_t start;
+	size_t end;
+	bool isEOF;
+} FeatsBuffer;
+
+/*
+ * A line of the buffer, [start..end) without the line separator, and *end is a
+ * character that is not part of a number (the separator or a terminator)
+ */
+typedef struct feats_line_t {
+	const char* start;
+	const char* end;
+} FeatsLine;
+
+/*
+ * Moves the unread data to the start of the buffer, grows the buffer if it is full, and
+ * reads the next block of the file after the unread data
+ *
+ * @return SP_DP_SUCCESS, SP_DP_MEMORY_FAILURE or SP_DP_FILE_READ_ERROR
+ */
+static SP_DP_MESSAGES readBlock(FeatsBuffer* buffer) {
+	char* data = NULL;
+	ssize_t bytesRead;
+
+	if (buffer->start > 0) {
+		memmove(buffer->data, buffer->data + buffer->start, buffer->end - buffer->start);
+		buffer->end -= buffer->start;
+		buffer->start = 0;
+	}
+	if (buffer->end == buffer->size - 1) {
+		if ((data = (char*) realloc(buffer->data, buffer->size * 2)) == NULL)
+			return SP_DP_MEMORY_FAILURE;
+		buffer->data = data;
+		buffer->size *= 2;
+	}
+
+	do {
+		bytesRead = read(buffer->fd, buffer->data + buffer->end, buffer->size - 1 - buffer->end);
+	} while (bytesRead < 0 && errno == EINTR);
+	if (bytesRead < 0)
+		return SP_DP_FILE_READ_ERROR;
+
+	buffer->isEOF = bytesRead == 0;
+	buffer->end += (size_t) bytesRead;
+	return SP_DP_SUCCESS;
+}
+
+/*
+ * Gets the next line of the file, the last line of the file may have no separator
+ *
+ * @return SP_DP_SUCCESS, SP_DP_MEMORY_FAILURE, SP_DP_FILE_READ_ERROR, or SP_DP_FORMAT_ERROR
+ * if the file has no more lines
+ */
+static SP_DP_MESSAGES nextLine(FeatsBuffer* buffer, FeatsLine* line) {
+	SP_DP_MESSAGES message = SP_DP_SUCCESS;
+	char* separator = NULL;
+	size_t searched = 0; // bytes of the unread data that have no separator
+
+	while ((separator = memchr(buffer->data + buffer->start + searched, LINE_SEPARATOR,
+			buffer->end - buffer->start - searched)) == NULL && !buffer->isEOF) {
+		searched = buffer->end - buffer->start;
+		if ((message = readBlock(buffer)) != SP_DP_SUCCESS)
+			return message;
+	}
+
+	if (separator == NULL) { // the end of the file
+		if (buffer->start == buffer->end)
+			return SP_DP_FORMAT_ERROR;
+		separator = buffer->data + buffer->end;
+		*separator = END_OF_STRING;
+	}
+
+	line->start = buffer->data + buffer->start;
+	line->end = separator;
+	buffer->start = separator - buffer->data + (separator < buffer->data + buffer->end);
+	return SP_DP_SUCCESS;
+}
+
+/*
+ * Parses a non negative int of at most 10 digits that starts at start
+ *
+ * @return NULL if there is no such int at start, otherwise the first character after it
+ */
+static const char* parseInt(const char* start, int* value) {
+	const char* current = start;
+	int64_t result = 0;
+
+	while (*current >= '0' && *current <= '9' && current - start <= 10)
+		result = result * 10 + (*current++ - '0');
+	if (current == start || result > MAX_INT_VALUE)
+		return NULL;
+	*value = (int) result;
+	return current;
+}
+
+/*
+ * Parses a number that has too many digits for the exact division by strtod, the number
+ * is [start..end)
+ */
+static const char* parseLongNumber(const char* start, const char* end, double* value) {
+	char number[MAX_NUMBER_LEN];
+	if (end - start >= MAX_NUMBER_LEN)
+		return NULL;
+	memcpy(number, start, end - start);
+	number[end - start] = END_OF_STRING;
+	*value = strtod(number, NULL);
+	return end;
+}
+
+const char* spFeatsReaderParseNumber(const char* start, double* value) {
+	const char *current = start, *firstDigit;
+	uint64_t mantissa = 0;
+	int digits = 0, fractionDigits = 0;
+	bool isNegative = *current == MINUS_SIGN;
+
+	current += isNegative;
+	firstDigit = current;
+	for (; *current >= '0' && *current <= '9'; current++, digits++)
+		mantissa = mantissa * 10 + (uint64_t) (*current - '0');
+	if (current == firstDigit)
+		return NULL;
+
+	if (*current == DECIMAL_POINT) {
+		for (current++; *current >= '0' && *current <= '9'; current++, fractionDigits++)
+			mantissa = mantissa * 10 + (uint64_t) (*current - '0');
+	}
+
+	// both operands are exact doubles, so the division is rounded once, as strtod rounds
+	if (digits + fractionDigits > MAX_MANTISSA_DIGITS || mantissa > MAX_EXACT_MANTISSA ||
+			fractionDigits > MAX_EXACT_POWER_OF_TEN)
+		return parseLongNumber(start, current, value);
+	*value = (double) mantissa / powersOfTen[fractionDigits];
+	*value = isNegative ? -*value : *value;
+	return current;
+}
+
+/*
+ * Parses the header line "<index>,<number of features>" into imageData, the index must be
+ * the index of imageData
+ */
+static SP_DP_MESSAGES parseHeader(FeatsLine* line, SPImageData imageData) {
+	const char* current = line->start;
+	int index = 0, numOfFeatures = 0;
+
+	if ((current = parseInt(current, &index)) == NULL || index != imageData->index ||
+			*current++ != FIELD_SEPARATOR ||
+			(current = parseInt(current, &numOfFeatures)) == NULL || current != line->end) {
+		spLoggerSafePrintWarning(FAILED_STRING_PARSING_WRONG_FORMAT, __FILE__, __FUNCTION__,
+				__LINE__);
+		return SP_DP_FORMAT_ERROR;
+	}
+	imageData->numOfFeatures = numOfFeatures;
+	return SP_DP_SUCCESS;
+}
+
+/*
+ * Parses a feature line "<dimension>,<coordinate>,...,<coordinate>" into a new point,
+ * the coordinates are parsed into *row, which grows to the dimension if needed
+ */
+static SP_DP_MESSAGES parseFeature(FeatsLine* line, int index, double** row, int* rowSize,
+		SPPoint* feature) {
+	const char* current = line->start;
+	double* grownRow = NULL;
+	int i, dim = 0;
+
+	// every coordinate takes at least two characters, so a longer dimension is not allocated
+	if ((current = parseInt(current, &dim)) == NULL || dim == 0 || dim > (line->end - current) / 2)
+		return SP_DP_FORMAT_ERROR;
+	if (dim > *rowSize) {
+		if ((grownRow = (double*) realloc(*row, dim * sizeof(double))) == NULL)
+			return SP_DP_MEMORY_FAILURE;
+		*row = grownRow;
+		*rowSize = dim;
+	}
+
+	for (i = 0; i < dim; i++) {
+		if (*current++ != FIELD_SEPARATOR ||
+				(current = spFeatsReaderParseNumber(current, *row + i)) == NULL)
+			return SP_DP_FORMAT_ERROR;
+	}
+	if (current != line->end)
+		return SP_DP_FORMAT_ERROR;
+
+	return (*feature = spPointCreate(*row, dim, index)) == NULL ?
+			SP_DP_MEMORY_FAILURE : SP_DP_SUCCESS;
+}
+
+/*
+ * Reads the file of the buffer into imageData (see spFeatsReaderLoad)
+ */
+static SP_DP_MESSAGES readImageData(FeatsBuffer* buffer, const char* configSignature,
+		SPImageData imageData) {
+	SP_DP_MESSAGES message = SP_DP_SUCCESS;
+	FeatsLine line;
+	double* row = NULL;
+	int i, rowSize = FEATS_INITIAL_ROW_SIZE;
+
+	// the signature is compared with its line separator, as the getLine line is
+	if ((message = nextLine(buffer, &line)) != SP_DP_SUCCESS)
+		return message;
+	if ((size_t) (line.end - line.start) + (*line.end == LINE_SEPARATOR) !=
+			strlen(configSignature) || strncmp(line.start, configSignature,
+			line.end - line.start + (*line.end == LINE_SEPARATOR)) != 0) {
+		spLoggerSafePrintWarning(FAILED_NOT_MATCHING_CONFIG, __FILE__, __FUNCTION__, __LINE__);
+		return SP_DP_FORMAT_ERROR;
+	}
+
+	if ((message = nextLine(buffer, &line)) != SP_DP_SUCCESS ||
+			(message = parseHeader(&line, imageData)) != SP_DP_SUCCESS)
+		return message;
+
+	spCallocEr(imageData->featuresArray, SPPoint, imageData->numOfFeatures,
+			FAILED_LOADING_IMAGE_DATA, SP_DP_MEMORY_FAILURE);
+	spCallocErWcRCb(row, double, rowSize, FAILED_LOADING_IMAGE_DATA,
+			spFree(imageData->featuresArray), SP_DP_MEMORY_FAILURE);
+
+	for (i = 0; i < imageData->numOfFeatures && message == SP_DP_SUCCESS; i++) {
+		message = nextLine(buffer, &line);
+		if (message == SP_DP_SUCCESS)
+			message = parseFeature(&line, imageData->index, &row, &rowSize,
+					imageData->featuresArray + i);
+	}
+	free(row);
+
+	if (message != SP_DP_SUCCESS) {
+		spLoggerSafePrintWarning(FAILED_PARSING_STRING_TO_POINT, __FILE__, __FUNCTION__,
+				__LINE__);
+		freeFeatures(imageData->featuresArray, i - 1); // the failed feature was not created
+		spFree(imageData->featuresArray);
+	}
+	return message;
+}
+
+SP_DP_MESSAGES spFeatsReaderLoad(const char* configSignature, const char* imageDataPath,
+		SPImageData imageData) {
+	SP_DP_MESSAGES message = SP_DP_SUCCESS;
+	FeatsBuffer buffer;
+
+	spVerifyArgumentsNc(configSignature != NULL && imageDataPath != NULL && imageData != NULL,
+			FAILED_LOADING_IMAGE_DATA, SP_DP_INVALID_ARGUMENT);
+	imageData->featuresArray = NULL;
+	imageData->numOfFeatures = 0;
+
+	memset(&buffer, 0, sizeof(buffer));
+	spValWcNc((buffer.fd = open(imageDataPath, O_RDONLY)) >= 0, FAILED_OPEN_FILE,
+			spLoggerSafePrintWarning(FAILED_LOADING_IMAGE_DATA, __FILE__, __FUNCTION__,
+					__LINE__), SP_DP_FILE_READ_ERROR);
+	buffer.size = FEATS_READ_BLOCK_SIZE + 1;
+	spCallocErWcRCb(buffer.data, char, buffer.size, FAILED_LOADING_IMAGE_DATA,
+			close(buffer.fd), SP_DP_MEMORY_FAILURE);
+
+	message = readImageData(&buffer, configSignature, imageData);
+	if (message == SP_DP_FILE_READ_ERROR)
+		spLoggerSafePrintError(FAILED_READING_FILE, __FILE__, __FUNCTION__, __LINE__);
+	if (message != SP_DP_SUCCESS) {
+		imageData->numOfFeatures = 0;
+		spLoggerSafePrintWarning(FAILED_LOADING_IMAGE_DATA, __FILE__, __FUNCTION__, __LINE__);
+	}
+
+	free(buffer.data);
+	close(buffer.fd);
+	return message;
+}
@@ -0,0 +1,68 @@
+#ifndef SPFEATSREADER_H_
+#define SPFEATSREADER_H_
+
+#include "SPImagesParser.h"
+#include "SPImageData.h"
+
+/**
+ * SP Feats Reader summary
+ *
+ * A streaming reader of the text .feats files that writeImageDataToFile writes:
+ * 		<configuration signature line>
+ * 		<image index>,<number of features>
+ * 		<dimension>,<coordinate>,...,<coordinate>		(one line per feature)
+ *
+ * The file is read in large blocks straight into a single buffer that holds at least a
+ * whole line, and the numbers are parsed in place: a coordinate written by "%f" (at most
+ * 15 significant digits) is converted exactly by a single division, without the C
+ * locale and without copying it, and only longer numbers are copied to strtod.
+ * The coordinates of a feature are parsed into a row that is reused by all the features
+ * of the file, so the only allocations per feature are the ones of spPointCreate.
+ *
+ * The reader is strict: a file that writeImageDataToFile could not have written (a bad
+ * number, a feature with too few or too many coordinates, less features than its header
+ * says) is a format error, where the getLine based loader may have loaded it partly.
+ *
+ * The following functions are supported:
+ *
+ * spFeatsReaderLoad			- Loads the image data of a .feats file
+ * spFeatsReaderParseNumber		- Parses a number of a .feats file
+ */
+
+/*
+ * Loads the image data of a .feats file into an allocated SPImageData item, the same
+ * as loadKnownImageData does.
+ * On failure the features that were read are destroyed, and imageData->featuresArray
+ * is NULL and imageData->numOfFeatures is 0.
+ *
+ * @param configSignature - the signature line that the file must start with
+ * @param imageDataPath - the file path
+ * @param imageData - an allocated SPImageData item whose index is the index in the file
+ *
+ * @return -
+ * SP_DP_INVALID_ARGUMENT - if an argument is NULL
+ * SP_DP_MEMORY_FAILURE - memory allocation failure
+ * SP_DP_FILE_READ_ERROR - the file could not be opened or read
+ * SP_DP_FORMAT_ERROR - the file is not in the correct format, or has another signature
+ * or image index
+ * SP_DP_SUCCESS - image data loaded successfully
+ *
+ * @logger - Prints relevant errors and warnings to the logger.
+ */
+SP_DP_MESSAGES spFeatsReaderLoad(const char* configSignature, const char* imageDataPath,
+		SPImageData imageData);
+
+/*
+ * Parses a number of the form [-]digits[.digits] that starts at 'start'. The number
+ * ends at the first character that is not part of it (so the string must go on after
+ * it, e.g. with a ',', a '\n' or a '\0'), and the value is exactly the one that strtod
+ * would return.
+ *
+ * @param start - the first character of the number
+ * @param value - the parsed number is written to *value
+ *
+ * @returns NULL if there is no number at start, otherwise the first character after it
+ */
+const char* spFeatsReaderParseNumber(const char* start, double* value);
+
+#endif /* SPFEATSREADER_H_ */
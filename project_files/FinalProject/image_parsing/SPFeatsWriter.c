@@ -0,0 +1,360 @@
+#define _POSIX_C_SOURCE 200809L // open and write under -std=c99
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+#include "SPFeatsWriter.h"
+#include "../SPLogger.h"
+#include "../general_utils/SPUtils.h"
+
+#define FEATS_COORDINATE_ESTIMATE			16 // the length of a typical ",%f" coordinate
+#define FEATS_LINE_ESTIMATE					16 // the length of a header or a dimension
+#define TEMP_FILE_SUFFIX					".tmp"
+#define TEMP_FILE_MODE						0666
+#define HEADER_STRING_FORMAT				"%d,%d\n"
+#define DIMENSION_STRING_FORMAT				"%d"
+#define COORDINATE_STRING_FORMAT			",%f"
+#define LINE_SEPARATOR						'\n'
+
+#define FAILED_OPEN_FILE					"Could not open file"
+#define FAILED_WRITING_FILE					"Failed writing to file"
+#define FAILED_RENAMING_FILE				"Failed renaming the temporary file to the .feats file"
+#define FAILED_WRITING_IMAGE_DATA			"Failed at writing an image data"
+#define FAILED_CONVERTING_IMAGE_TO_STRING	"Failed converting image data to string"
+#define FAILED_CREATING_FEATS_WRITER		"Failed creating the .feats writer"
+#define FAILED_SUBMITTING_IMAGE_DATA		"Failed submitting an image data to the .feats writer"
+#define WARNING_SAVE_THREADS_NOT_CREATED	"Could not create all the saving threads, the images are saved by less threads"
+#define WARNING_IMAGE_NOT_SAVED				"Could not save an image .feats file"
+#define WARNING_IMAGE_NOT_COMMITTED			"Could not record a saved image in the features manifest"
+
+/*
+ * A growing text buffer, data[0..length) is the text and data[length] is '\0'
+ */
+typedef struct feats_text_t {
+	char* data;
+	size_t length;
+	size_t capacity;
+} FeatsText;
+
+/*
+ * A structure used for the .feats writer
+ * pending - the submitted images, pending[nextToSave..numOfSubmitted) are not saved yet
+ * numOfFails - the number of images that were not saved
+ * message - the message of the first failure, or of a memory failure if there was one
+ * isFinishing - set by spFeatsWriterFinish, the threads exit once pending is empty
+ * isFinished - the threads are joined
+ * lock - guards all the fields the threads change
+ * hasWork - signaled when an image is submitted or the writer is finishing
+ */
+struct sp_feats_writer_t {
+	SPConfig config;
+	SPManifest manifest;
+	char* configSignature;
+	SPImageData* pending;
+	int capacity;
+	int numOfSubmitted;
+	int nextToSave;
+	int numOfFails;
+	SP_DP_MESSAGES message;
+	bool isFinishing;
+	bool isFinished;
+	pthread_t* threads;
+	int numOfThreads;
+	pthread_mutex_t lock;
+	pthread_cond_t hasWork;
+};
+
+//-----------------------------------------------serialize---------------------------------------------
+
+/*
+ * Appends formatted text to the buffer, grows the buffer if needed
+ *
+ * @return SP_DP_SUCCESS, SP_DP_MEMORY_FAILURE or SP_DP_FORMAT_ERROR
+ */
+static SP_DP_MESSAGES appendFormatted(FeatsText* text, const char* format, ...) {
+	va_list args;
+	int length;
+	size_t capacity;
+	char* data;
+
+	while (true) {
+		va_start(args, format);
+		length = vsnprintf(text->data + text->length, text->capacity - text->length,
+				format, args);
+		va_end(args);
+		if (length < 0)
+			return SP_DP_FORMAT_ERROR;
+		if ((size_t) length < text->capacity - text->length) {
+			text->length += length;
+			return SP_DP_SUCCESS;
+		}
+		capacity = 2 * text->capacity > text->length + length + 1 ?
+				2 * text->capacity : text->length + length + 1;
+		if ((data = (char*) realloc(text->data, capacity)) == NULL)
+			return SP_DP_MEMORY_FAILURE;
+		text->data = data;
+		text->capacity = capacity;
+	}
+}
+
+/*
+ * Appends the line of a feature: its dimension and its coordinates
+ *
+ * @return SP_DP_SUCCESS, SP_DP_MEMORY_FAILURE or SP_DP_FORMAT_ERROR
+ */
+static SP_DP_MESSAGES appendFeature(FeatsText* text, SPPoint feature) {
+	SP_DP_MESSAGES message;
+	int j, dim = spPointGetDimension(feature);
+
+	if ((message = appendFormatted(text, DIMENSION_STRING_FORMAT, dim)) != SP_DP_SUCCESS)
+		return message;
+	for (j = 0; j < dim; j++) {
+		if ((message = appendFormatted(text, COORDINATE_STRING_FORMAT,
+				spPointGetAxisCoor(feature, j))) != SP_DP_SUCCESS)
+			return message;
+	}
+	return appendFormatted(text, "%c", LINE_SEPARATOR);
+}
+
+char* spFeatsWriterSerialize(const char* configSignature, SPImageData imageData,
+		size_t* length, SP_DP_MESSAGES* message) {
+	FeatsText text;
+	int i;
+
+	spVerifyArgumentsRnNc(message != NULL, FAILED_CONVERTING_IMAGE_TO_STRING);
+	spVerifyArgumentsWcRnNc(configSignature != NULL && imageData != NULL && length != NULL
+			&& imageData->numOfFeatures >= 0 &&
+			(imageData->featuresArray != NULL || imageData->numOfFeatures == 0),
+			FAILED_CONVERTING_IMAGE_TO_STRING, *message = SP_DP_INVALID_ARGUMENT);
+	for (i = 0; i < imageData->numOfFeatures; i++)
+		spVerifyArgumentsWcRnNc(imageData->featuresArray[i] != NULL,
+				FAILED_CONVERTING_IMAGE_TO_STRING, *message = SP_DP_INVALID_ARGUMENT);
+
+	// an estimate, the buffer grows if it is too small
+	text.length = 0;
+	text.capacity = strlen(configSignature) + FEATS_LINE_ESTIMATE + 1;
+	for (i = 0; i < imageData->numOfFeatures; i++)
+		text.capacity += FEATS_LINE_ESTIMATE + (size_t) FEATS_COORDINATE_ESTIMATE *
+				spPointGetDimension(imageData->featuresArray[i]);
+	spCallocErWc(text.data, char, text.capacity, FAILED_CONVERTING_IMAGE_TO_STRING,
+			*message = SP_DP_MEMORY_FAILURE);
+
+	*message = appendFormatted(&text, "%s", configSignature);
+	if (*message == SP_DP_SUCCESS)
+		*message = appendFormatted(&text, HEADER_STRING_FORMAT, imageData->index,
+				imageData->numOfFeatures);
+	for (i = 0; i < imageData->numOfFeatures && *message == SP_DP_SUCCESS; i++)
+		*message = appendFeature(&text, imageData->featuresArray[i]);
+
+	spValWcRnNc(*message == SP_DP_SUCCESS, FAILED_CONVERTING_IMAGE_TO_STRING,
+			free(text.data));
+	*length = text.length;
+	return text.data;
+}
+
+//-------------------------------------------------save------------------------------------------------
+
+/*
+ * Writes all the content to the file, retrying partial and interrupted writes
+ *
+ * @returns false if the write failed, true otherwise
+ */
+static bool writeAll(int fd, const char* content, size_t length) {
+	ssize_t written;
+	while (length > 0) {
+		if ((written = write(fd, content, length)) < 0) {
+			if (errno == EINTR)
+				continue;
+			return false;
+		}
+		content += written;
+		length -= written;
+	}
+	return true;
+}
+
+SP_DP_MESSAGES spFeatsWriterSave(const char* configSignature, const char* imageDataPath,
+		SPImageData imageData) {
+	SP_DP_MESSAGES message = SP_DP_SUCCESS;
+	char *content, *tempPath;
+	size_t length;
+	int fd;
+	bool isWritten;
+
+	spVerifyArgumentsNc(configSignature != NULL && imageDataPath != NULL && imageData != NULL,
+			FAILED_WRITING_IMAGE_DATA, SP_DP_INVALID_ARGUMENT);
+
+	content = spFeatsWriterSerialize(configSignature, imageData, &length, &message);
+	spValNc(content != NULL, FAILED_WRITING_IMAGE_DATA, message);
+	spCallocErWcRCb(tempPath, char, strlen(imageDataPath) + strlen(TEMP_FILE_SUFFIX) + 1,
+			FAILED_WRITING_IMAGE_DATA, free(content), SP_DP_MEMORY_FAILURE);
+	strcpy(tempPath, imageDataPath);
+	strcat(tempPath, TEMP_FILE_SUFFIX);
+
+	spValWcNc((fd = open(tempPath, O_WRONLY | O_CREAT | O_TRUNC, TEMP_FILE_MODE)) >= 0,
+			FAILED_OPEN_FILE,
+			spLoggerSafePrintWarning(FAILED_WRITING_IMAGE_DATA, __FILE__, __FUNCTION__,
+					__LINE__);
+			free(content); free(tempPath), SP_DP_FILE_WRITE_ERROR);
+	isWritten = writeAll(fd, content, length);
+	isWritten = close(fd) == 0 && isWritten;
+	free(content);
+
+	// the .feats file is replaced only by a fully written file
+	if (!isWritten) {
+		spLoggerSafePrintWarning(FAILED_WRITING_FILE, __FILE__, __FUNCTION__, __LINE__);
+		message = SP_DP_FILE_WRITE_ERROR;
+	} else if (rename(tempPath, imageDataPath) != 0) {
+		spLoggerSafePrintWarning(FAILED_RENAMING_FILE, __FILE__, __FUNCTION__, __LINE__);
+		message = SP_DP_FILE_WRITE_ERROR;
+	}
+	if (message != SP_DP_SUCCESS)
+		unlink(tempPath);
+	free(tempPath);
+	return message;
+}
+
+//-------------------------------------------------pool------------------------------------------------
+
+/*
+ * Saves the submitted images until the writer is finishing and no image is pending,
+ * the thread that finishes the writer is one of the saving threads
+ */
+static void* saveImagesWorker(void* data) {
+	SPFeatsWriter writer = (SPFeatsWriter) data;
+	SP_DP_MESSAGES message;
+	SPImageData imageData;
+
+	pthread_mutex_lock(&(writer->lock));
+	while (true) {
+		while (writer->nextToSave == writer->numOfSubmitted && !writer->isFinishing)
+			pthread_cond_wait(&(writer->hasWork), &(writer->lock));
+		if (writer->nextToSave == writer->numOfSubmitted)
+			break;
+		imageData = writer->pending[writer->nextToSave++];
+		pthread_mutex_unlock(&(writer->lock));
+
+		message = saveImageData(writer->config, writer->configSignature, imageData);
+		if (message != SP_DP_SUCCESS)
+			spLoggerSafePrintWarning(WARNING_IMAGE_NOT_SAVED, __FILE__, __FUNCTION__,
+					__LINE__);
+		// an image that is not recorded is only extracted again by the next update
+		else if (writer->manifest != NULL && spManifestCommit(writer->manifest,
+				imageData->index, imageData->numOfFeatures) != SP_DP_SUCCESS)
+			spLoggerSafePrintWarning(WARNING_IMAGE_NOT_COMMITTED, __FILE__, __FUNCTION__,
+					__LINE__);
+
+		pthread_mutex_lock(&(writer->lock));
+		if (message != SP_DP_SUCCESS) {
+			writer->numOfFails++;
+			if (writer->message == SP_DP_SUCCESS || message == SP_DP_MEMORY_FAILURE)
+				writer->message = message;
+		}
+	}
+	pthread_mutex_unlock(&(writer->lock));
+	return NULL;
+}
+
+SPFeatsWriter spFeatsWriterCreate(const SPConfig config, SPManifest manifest) {
+	SP_CONFIG_MSG configMessage = SP_CONFIG_SUCCESS;
+	SPFeatsWriter writer = NULL;
+	int t, numOfThreads, numOfImages;
+
+	spVerifyArgumentsRn(config != NULL, FAILED_CREATING_FEATS_WRITER);
+	numOfThreads = spConfigGetSaveThreads(config, &configMessage);
+	numOfImages = spConfigGetNumOfImages(config, &configMessage);
+	spValRn(configMessage == SP_CONFIG_SUCCESS, FAILED_CREATING_FEATS_WRITER);
+
+	spCallocEr(writer, struct sp_feats_writer_t, 1, FAILED_CREATING_FEATS_WRITER, NULL);
+	writer->config = config;
+	writer->manifest = manifest;
+	writer->capacity = numOfImages > 0 ? numOfImages : 1;
+	writer->message = SP_DP_SUCCESS;
+	spCallocErWc(writer->pending, SPImageData, writer->capacity,
+			FAILED_CREATING_FEATS_WRITER, free(writer));
+	spCallocErWc(writer->threads, pthread_t, numOfThreads, FAILED_CREATING_FEATS_WRITER,
+			free(writer->pending); free(writer));
+	spValWcRn((writer->configSignature = getSignature(config)) != NULL,
+			FAILED_CREATING_FEATS_WRITER,
+			free(writer->threads); free(writer->pending); free(writer));
+	spValWcRn(pthread_mutex_init(&(writer->lock), NULL) == 0, FAILED_CREATING_FEATS_WRITER,
+			free(writer->configSignature); free(writer->threads); free(writer->pending);
+			free(writer));
+	spValWcRn(pthread_cond_init(&(writer->hasWork), NULL) == 0, FAILED_CREATING_FEATS_WRITER,
+			pthread_mutex_destroy(&(writer->lock)); free(writer->configSignature);
+			free(writer->threads); free(writer->pending); free(writer));
+
+	for (t = 0; t < numOfThreads; t++) {
+		if (pthread_create(&(writer->threads[t]), NULL, saveImagesWorker, writer) != 0)
+			break;
+		writer->numOfThreads++;
+	}
+	// the images of the threads that were not created are saved by the others
+	if (writer->numOfThreads < numOfThreads)
+		spLoggerSafePrintWarning(WARNING_SAVE_THREADS_NOT_CREATED, __FILE__, __FUNCTION__,
+				__LINE__);
+	return writer;
+}
+
+SP_DP_MESSAGES spFeatsWriterSubmit(SPFeatsWriter writer, SPImageData imageData) {
+	SPImageData* pending;
+	int capacity;
+
+	spVerifyArguments(writer != NULL && imageData != NULL, FAILED_SUBMITTING_IMAGE_DATA,
+			SP_DP_INVALID_ARGUMENT);
+
+	pthread_mutex_lock(&(writer->lock));
+	spValWc(!writer->isFinishing, FAILED_SUBMITTING_IMAGE_DATA,
+			pthread_mutex_unlock(&(writer->lock)), SP_DP_INVALID_ARGUMENT);
+	if (writer->numOfSubmitted == writer->capacity) {
+		capacity = 2 * writer->capacity;
+		spValWc((pending = (SPImageData*) realloc(writer->pending,
+				capacity * sizeof(SPImageData))) != NULL, FAILED_SUBMITTING_IMAGE_DATA,
+				pthread_mutex_unlock(&(writer->lock)), SP_DP_MEMORY_FAILURE);
+		writer->pending = pending;
+		writer->capacity = capacity;
+	}
+	writer->pending[writer->numOfSubmitted++] = imageData;
+	pthread_cond_signal(&(writer->hasWork));
+	pthread_mutex_unlock(&(writer->lock));
+	return SP_DP_SUCCESS;
+}
+
+SP_DP_MESSAGES spFeatsWriterFinish(SPFeatsWriter writer, int maxFailsAllowed) {
+	int t;
+
+	spVerifyArguments(writer != NULL, FAILED_WRITING_IMAGE_DATA, SP_DP_INVALID_ARGUMENT);
+
+	if (!writer->isFinished) {
+		pthread_mutex_lock(&(writer->lock));
+		writer->isFinishing = true;
+		pthread_cond_broadcast(&(writer->hasWork));
+		pthread_mutex_unlock(&(writer->lock));
+
+		saveImagesWorker(writer);
+		for (t = 0; t < writer->numOfThreads; t++)
+			pthread_join(writer->threads[t], NULL);
+		writer->isFinished = true;
+	}
+
+	if (writer->message == SP_DP_MEMORY_FAILURE || writer->numOfFails > maxFailsAllowed)
+		return writer->message;
+	return SP_DP_SUCCESS;
+}
+
+void spFeatsWriterDestroy(SPFeatsWriter writer) {
+	if (writer == NULL)
+		return;
+	spFeatsWriterFinish(writer, writer->numOfSubmitted);
+	pthread_cond_destroy(&(writer->hasWork));
+	pthread_mutex_destroy(&(writer->lock));
+	free(writer->configSignature);
+	free(writer->threads);
+	free(writer->pending);
+	free(writer);
+}
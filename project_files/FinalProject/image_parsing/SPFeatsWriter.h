@@ -0,0 +1,134 @@
+#ifndef SPFEATSWRITER_H_
+#define SPFEATSWRITER_H_
+
+#include <stddef.h>
+#include "SPImagesParser.h"
+#include "SPImageData.h"
+#include "SPManifest.h"
+
+/**
+ * SP Feats Writer summary
+ *
+ * Writes the text .feats files that SPFeatsReader reads. An image is serialized into a
+ * single memory buffer, which is written to a temporary file next to the .feats file by
+ * a single write call, and the temporary file is renamed over the .feats file, so a
+ * reader never sees a partly written file.
+ *
+ * The writer can also save the images on a pool of background threads: the images are
+ * submitted as their features are extracted, and the threads save them meanwhile, so
+ * the disk is not idle during the extraction. The submitted images must not be changed
+ * or freed until spFeatsWriterFinish returns. Every image the pool saves is committed to
+ * the features manifest (if one is given), so an interrupted extraction can be resumed.
+ *
+ * The following functions are supported:
+ *
+ * spFeatsWriterSerialize		- Serializes an image data into the .feats format
+ * spFeatsWriterSave			- Saves an image data to a .feats file
+ * spFeatsWriterCreate			- Starts a pool of saving threads
+ * spFeatsWriterSubmit			- Submits an image to be saved by the pool
+ * spFeatsWriterFinish			- Waits for all the submitted images to be saved
+ * spFeatsWriterDestroy			- Stops the pool and frees it
+ */
+
+/*
+ * Serializes an image data into the content of its .feats file
+ *
+ * @param configSignature - the signature line the content starts with
+ * @param imageData - the image data, imageData->featuresArray may be NULL only if
+ * imageData->numOfFeatures is 0
+ * @param length - the length of the content (without the '\0') is written to *length
+ * @param message - the result message is written to *message:
+ * SP_DP_INVALID_ARGUMENT - if an argument or a feature is NULL
+ * SP_DP_MEMORY_FAILURE - memory allocation failure
+ * SP_DP_FORMAT_ERROR - a number could not be formatted
+ * SP_DP_SUCCESS - otherwise
+ *
+ * @returns NULL in case of an error, otherwise the '\0' terminated content
+ *
+ * @logger - Prints relevant errors and warnings to the logger.
+ */
+char* spFeatsWriterSerialize(const char* configSignature, SPImageData imageData,
+		size_t* length, SP_DP_MESSAGES* message);
+
+/*
+ * Saves an image data to a .feats file by a single write to a temporary file
+ * (imageDataPath with a ".tmp" suffix) that is renamed over imageDataPath.
+ * On failure imageDataPath is left unchanged and the temporary file is removed.
+ *
+ * @param configSignature - the signature line the file starts with
+ * @param imageDataPath - the .feats file path
+ * @param imageData - the image data to save
+ *
+ * @return -
+ * SP_DP_INVALID_ARGUMENT - if an argument or a feature is NULL
+ * SP_DP_MEMORY_FAILURE - memory allocation failure
+ * SP_DP_FORMAT_ERROR - a number could not be formatted
+ * SP_DP_FILE_WRITE_ERROR - the file could not be written or renamed
+ * SP_DP_SUCCESS - the file was saved
+ *
+ * @logger - Prints relevant errors and warnings to the logger.
+ */
+SP_DP_MESSAGES spFeatsWriterSave(const char* configSignature, const char* imageDataPath,
+		SPImageData imageData);
+
+/*
+ * Starts spSaveThreads threads that save the submitted images to their .feats files
+ * (by saveImageData) with the signature of the configuration.
+ * If some of the threads could not be created the others save their images, and
+ * if none was created the images are saved by spFeatsWriterFinish.
+ *
+ * @param config - the configuration, it must stay valid until the writer is destroyed
+ * @param manifest - the manifest the saved images are committed to, their image files
+ * must have been checked by spManifestCheckImage; NULL if there is no manifest. It must
+ * stay valid until the writer is destroyed
+ *
+ * @returns NULL in case of invalid argument or memory allocation error, otherwise the
+ * writer
+ *
+ * @logger - Prints relevant errors and warnings to the logger.
+ */
+SPFeatsWriter spFeatsWriterCreate(const SPConfig config, SPManifest manifest);
+
+/*
+ * Submits an image to be saved by the writer threads, the images are saved in the
+ * order of their submission. The image must not be changed or freed until
+ * spFeatsWriterFinish returns.
+ *
+ * @param writer - the writer
+ * @param imageData - the image to save
+ *
+ * @return -
+ * SP_DP_INVALID_ARGUMENT - if an argument is NULL or the writer is finished
+ * SP_DP_MEMORY_FAILURE - memory allocation failure
+ * SP_DP_SUCCESS - the image was submitted
+ *
+ * @logger - Prints relevant errors to the logger.
+ */
+SP_DP_MESSAGES spFeatsWriterSubmit(SPFeatsWriter writer, SPImageData imageData);
+
+/*
+ * Waits until all the submitted images are saved and stops the writer threads, no
+ * images can be submitted afterwards. The images that were not saved are counted
+ * against the given failure budget. Calling it again returns the same result.
+ *
+ * @param writer - the writer
+ * @param maxFailsAllowed - the number of images that may fail to be saved
+ *
+ * @return -
+ * SP_DP_INVALID_ARGUMENT - if writer is NULL
+ * SP_DP_SUCCESS - if no image failed with a memory failure and at most maxFailsAllowed
+ * images failed, otherwise the message of the first failure (or of a memory failure)
+ *
+ * @logger - a warning is logged for every image that was not saved
+ */
+SP_DP_MESSAGES spFeatsWriterFinish(SPFeatsWriter writer, int maxFailsAllowed);
+
+/*
+ * Waits for the submitted images to be saved (if spFeatsWriterFinish was not called) and
+ * frees all the resources of the writer. If writer is NULL nothing happens.
+ *
+ * @param writer - the writer
+ */
+void spFeatsWriterDestroy(SPFeatsWriter writer);
+
+#endif /* SPFEATSWRITER_H_ */
@@ -3,8 +3,12 @@
 #include <stdlib.h>
 #include <string.h>
 #include <assert.h>
+#include <pthread.h>
 #include "SPImagesParser.h"
+#include "SPFeatsReader.h"
+#include "SPFeatsWriter.h"
 #include "../general_utils/SPUtils.h"
+#include "../general_utils/SPInstrumentation.h"
 
 #define DOUBLE_PRECISION 						   6
 
@@ -17,17 +21,16 @@
 #define MAX_ERRORS_PERCENTAGE_AT_SAVE_PROCESS	   20
 #define MAX_ERRORS_PERCENTAGE_AT_LOAD_PROCESS	   20
 
+//the number of consecutive images a loading thread takes at once
+#define LOAD_THREAD_CHUNK						   8
+
 #define HEADER_STRING_FORMAT                       "%d,%d\n"
 #define POINT_STRING_FORMAT                        "%d%s\n"
 #define INTERNAL_POINT_DATA_STRING_FORMAT          ",%f%s"
-#define CREATE_IF_NOT_EXISTS_FILE_MODE		       "ab+"
 #define READ_FILE_MODE		       				   "r"
 
-#define FAILED_OPEN_FILE                            "Could not open file"
 #define FAILED_WRITING_FILE                         "Failed writing to file"
 #define FAILED_READING_FILE                         "Failed while reading from file"
-#define FAILED_GETTING_HEADER                       "Failed creating header"
-#define FAILED_TRANSLATING_POINT                    "Failed translating point to CSV string"
 #define FAILED_STRING_PARSING_WRONG_FORMAT          "Wrong format in image2string parsing"
 #define FAILED_GETTING_PATH                         "Failed creating file path"
 #define FAILED_ANALYZING_FEATURES                   "Failed while analyzing features"
@@ -53,8 +56,8 @@
 #define WARNING_CONFIG_SHOULD_NOT_BE_NULL		   "Warning, could not extract config data, when config should not be null"
 #define WARNING_FEATURES_NULL_PRE_DATABASE		   "Warning, features matrix is null pre database creation"
 #define WARNING_VERY_LONG_LINE 			   	   	   "Warning : A very long line is being read from a features file\n"
-#define WARNING_SAVE_IMAGE_FEAT_LIMIT_NOT_REACHED  "Could not save image .feat file\n max limit of saves errors has not yet been reached."
 #define WARNING_LOAD_IMAGE_FEAT_LIMIT_NOT_REACHED  "Could not load image .feat file\n max limit of load errors has not yet been reached."
+#define WARNING_LOAD_THREADS_NOT_CREATED		   "Could not create all the loading threads, the images are loaded by less threads"
 
 #define DEBUG_GET_LINE_BUFFER_DOUBLED  			   "Get line buffer doubled"
 #define DEBUG_LOADING_IMAGE_FROM_FEAT_INDEX 	   "Loading image from .feat file at index - "
@@ -290,36 +293,139 @@ SP_DP_MESSAGES loadImageDataFromHeader(char* header, SPImageData image){
 	return SP_DP_SUCCESS;
 }
 
+/*
+ * The state shared by the threads that load the images data
+ * nextImage - the first image no thread has taken yet
+ * maxFailsAllowed - the number of images that may still fail to load
+ * message - the error that stops the loading, SP_DP_SUCCESS while there is none
+ * lock - guards nextImage, maxFailsAllowed and message
+ */
+typedef struct images_data_loader_t {
+	SPConfig config;
+	char* configSignature;
+	SPImageData* allImagesData;
+	int numOfImages;
+	int nextImage;
+	int maxFailsAllowed;
+	SP_DP_MESSAGES message;
+	pthread_mutex_t lock;
+} ImagesDataLoader;
+
+/*
+ * Counts a failure to load an image against the failure budget. Within the budget the
+ * image is treated as having no features, otherwise the loading is stopped.
+ */
+static void handleLoadFailure(ImagesDataLoader* loader, int imageIndex,
+		SP_DP_MESSAGES message) {
+	bool isWithinBudget = false;
+
+	pthread_mutex_lock(&(loader->lock));
+	if (loader->message == SP_DP_SUCCESS) {
+		if (loader->maxFailsAllowed == 0 || message == SP_DP_MEMORY_FAILURE) {
+			loader->message = message;
+		} else {
+			loader->maxFailsAllowed--;
+			isWithinBudget = true;
+		}
+	}
+	pthread_mutex_unlock(&(loader->lock));
+
+	if (isWithinBudget) {
+		spLoggerSafePrintWarning(WARNING_LOAD_IMAGE_FEAT_LIMIT_NOT_REACHED,
+				__FILE__, __FUNCTION__, __LINE__);
+		resetImageData(loader->allImagesData[imageIndex]); //treat as no features
+	}
+}
+
+/*
+ * Loads chunks of consecutive images until all of them are taken or the loading is
+ * stopped, the calling thread is one of the loading threads. Each image is loaded into
+ * its own slot of allImagesData, so the threads share only the loader state.
+ */
+static void* loadImagesDataWorker(void* data) {
+	ImagesDataLoader* loader = (ImagesDataLoader*) data;
+	SP_DP_MESSAGES message;
+	int i, first;
+
+	while (true) {
+		pthread_mutex_lock(&(loader->lock));
+		first = loader->nextImage;
+		loader->nextImage += LOAD_THREAD_CHUNK;
+		if (loader->message != SP_DP_SUCCESS)
+			first = loader->numOfImages;
+		pthread_mutex_unlock(&(loader->lock));
+		if (first >= loader->numOfImages)
+			break;
+
+		for (i = first; i < first + LOAD_THREAD_CHUNK && i < loader->numOfImages; i++) {
+			if ((message = loadImageData(loader->config, loader->configSignature, i,
+					loader->allImagesData)) != SP_DP_SUCCESS)
+				handleLoadFailure(loader, i, message);
+		}
+	}
+	return NULL;
+}
+
+/*
+ * Runs the loading threads, the calling thread is one of them
+ */
+static void runLoadWorkers(ImagesDataLoader* loader, int numOfThreads) {
+	int t, numOfCreated = 0;
+	pthread_t* threads = NULL;
+
+	if (numOfThreads > 1 && (threads = (pthread_t*) calloc(numOfThreads,
+			sizeof(pthread_t))) != NULL) {
+		for (t = 1; t < numOfThreads; t++) {
+			if (pthread_create(&(threads[t]), NULL, loadImagesDataWorker, loader) != 0)
+				break;
+			numOfCreated++;
+		}
+	}
+	loadImagesDataWorker(loader);
+	for (t = 1; t <= numOfCreated; t++)
+		pthread_join(threads[t], NULL);
+
+	// the images of the threads that were not created were loaded by the others
+	if (numOfCreated < numOfThreads - 1)
+		spLoggerSafePrintWarning(WARNING_LOAD_THREADS_NOT_CREATED, __FILE__,
+				__FUNCTION__, __LINE__);
+	free(threads);
+}
+
 SP_DP_MESSAGES loadAllImagesData(const SPConfig config,char* configSignature, SPImageData* allImagesData){
 	SP_CONFIG_MSG configMessage = SP_CONFIG_SUCCESS;
-	SP_DP_MESSAGES message = SP_DP_SUCCESS;
-	int i, numOfImages, maxFailsAllowed;
+	ImagesDataLoader loader;
+	int numOfThreads, numOfChunks;
 
 	spVerifyArguments(allImagesData != NULL && config != NULL && configSignature != NULL,
 			FAILED_LOADING_IMAGES_DATA, SP_DP_INVALID_ARGUMENT);
 
-	numOfImages = spConfigGetNumOfImages(config, &configMessage);
+	loader.numOfImages = spConfigGetNumOfImages(config, &configMessage);
+	spVal(configMessage == SP_CONFIG_SUCCESS, FAILED_LOADING_IMAGES_DATA,
+			SP_DP_INVALID_ARGUMENT);
+	numOfThreads = spConfigGetLoadThreads(config, &configMessage);
 	spVal(configMessage == SP_CONFIG_SUCCESS, FAILED_LOADING_IMAGES_DATA,
 			SP_DP_INVALID_ARGUMENT);
 
-	maxFailsAllowed = numOfImages * MAX_ERRORS_PERCENTAGE_AT_SAVE_PROCESS / 100;
-
-	for (i = 0 ; i < numOfImages ; i++){
-		if ((message = loadImageData(config, configSignature, i , allImagesData)) != SP_DP_SUCCESS){
-			if (maxFailsAllowed == 0 || message == SP_DP_MEMORY_FAILURE){ //reached limit - report error and return message
-				spLoggerSafePrintError(FAILED_LOADING_IMAGES_DATA,
-									__FILE__, __FUNCTION__, __LINE__);
-				return message;
-
-			} else { //report warning
-				spLoggerSafePrintWarning(WARNING_LOAD_IMAGE_FEAT_LIMIT_NOT_REACHED,
-										__FILE__, __FUNCTION__, __LINE__);
-				resetImageData(allImagesData[i]); //treat as no features
-				maxFailsAllowed--;
-			}
-
-		}
-	}
+	// no more threads than chunks of images
+	numOfChunks = (loader.numOfImages + LOAD_THREAD_CHUNK - 1) / LOAD_THREAD_CHUNK;
+	if (numOfThreads > numOfChunks)
+		numOfThreads = numOfChunks;
+
+	loader.config = config;
+	loader.configSignature = configSignature;
+	loader.allImagesData = allImagesData;
+	loader.nextImage = 0;
+	loader.maxFailsAllowed = loader.numOfImages * MAX_ERRORS_PERCENTAGE_AT_SAVE_PROCESS / 100;
+	loader.message = SP_DP_SUCCESS;
+	spVal(pthread_mutex_init(&(loader.lock), NULL) == 0, FAILED_LOADING_IMAGES_DATA,
+			SP_DP_MEMORY_FAILURE);
+
+	runLoadWorkers(&loader, numOfThreads);
+
+	pthread_mutex_destroy(&(loader.lock));
+	//reached the limit or a critical error - report error and return message
+	spVal(loader.message == SP_DP_SUCCESS, FAILED_LOADING_IMAGES_DATA, loader.message);
 	return SP_DP_SUCCESS;
 }
 
@@ -356,18 +462,8 @@ SP_DP_MESSAGES readFeaturesFromFile(FILE* imageFile, SPImageData imageData){
 }
 
 SP_DP_MESSAGES loadKnownImageData(char* configSignature, char* imageDataPath, SPImageData imageData){
-	SP_DP_MESSAGES message = SP_DP_SUCCESS;
-	FILE* imageFile = NULL;
-	spValWcNc((imageFile = fopen(imageDataPath, READ_FILE_MODE)) != NULL,
-			FAILED_OPEN_FILE, spLoggerSafePrintWarning(FAILED_LOADING_IMAGE_DATA,
-					__FILE__,__FUNCTION__, __LINE__),
-			SP_DP_FILE_READ_ERROR);
-
-	message = loadImageDataFromFile(configSignature, imageFile, imageData);
-
-	fclose(imageFile);
-	imageFile = NULL;
-	return message;
+	// the streaming reader parses the blocks of the file in place, rather than line by line
+	return spFeatsReaderLoad(configSignature, imageDataPath, imageData);
 }
 
 SP_DP_MESSAGES loadImageDataFromFile(char* configSignature, FILE* imageFile, SPImageData imageData){
@@ -403,7 +499,7 @@ SP_DP_MESSAGES loadImageDataFromFile(char* configSignature, FILE* imageFile, SPI
 			FAILED_LOADING_IMAGE_DATA, SP_DP_MEMORY_FAILURE);
 
 	spValWcNc((message = readFeaturesFromFile(imageFile, imageData)) == SP_DP_SUCCESS,
-			FAILED_LOADING_IMAGE_DATA, free(imageData->featuresArray), message);
+			FAILED_LOADING_IMAGE_DATA, spFree(imageData->featuresArray), message);
 
 	return message;
 }
@@ -433,50 +529,24 @@ SP_DP_MESSAGES loadImageData(const SPConfig config, char* configSignature, int i
 SP_DP_MESSAGES writeImageDataToFile(FILE* imageFile, SPImageData imageData, char* configSignature){
 	assert(imageFile != NULL && imageData != NULL && configSignature != NULL);
 	SP_DP_MESSAGES message = SP_DP_SUCCESS;
-	int i;
-	char *line = NULL;
-	//write config signature to file
-	spValNc(fputs(configSignature,imageFile) >= 0, FAILED_WRITING_IMAGE_DATA, SP_DP_FILE_WRITE_ERROR);
-
-	fflush(imageFile);
+	char *content = NULL;
+	size_t length;
 
-	//write header to file
-	line = getImageStringHeader(imageData, &message);
+	//serialize the whole image and write it at once
+	content = spFeatsWriterSerialize(configSignature, imageData, &length, &message);
+	spValNc(content != NULL, FAILED_WRITING_IMAGE_DATA, message);
 
-	spValWcNc(line != NULL, FAILED_GETTING_HEADER,
-			spLoggerSafePrintWarning(FAILED_WRITING_IMAGE_DATA,
-					__FILE__,__FUNCTION__, __LINE__),
-			SP_DP_INVALID_ARGUMENT);
-
-	spValWcNc(fputs(line,imageFile) >= 0 ,FAILED_WRITING_IMAGE_DATA,
-			free(line),
+	spValWcNc(fwrite(content, 1, length, imageFile) == length, FAILED_WRITING_IMAGE_DATA,
+			free(content),
 			SP_DP_FILE_WRITE_ERROR);
 
-	fflush(imageFile);
-	free(line);
-	//write features to file
-	for (i = 0; i < imageData->numOfFeatures ; i++){
-		line = pointToString(imageData->featuresArray[i], &message);
-
-		spValWcNc(message == SP_DP_SUCCESS && line != NULL, FAILED_TRANSLATING_POINT,
-				free(line),
-				SP_DP_INVALID_ARGUMENT);
-
-		spValWcNc(fputs(line,imageFile) >= 0 , FAILED_WRITING_IMAGE_DATA,
-				free(line),
-				SP_DP_FILE_WRITE_ERROR);
-
-		fflush(imageFile);
-		free(line);
-	}
-
+	free(content);
 	return SP_DP_SUCCESS;
 }
 
 SP_DP_MESSAGES saveImageData(const SPConfig config,char* configSignature, SPImageData imageData){
 	SP_DP_MESSAGES outputMessage = SP_DP_SUCCESS;
 	char* filePath;
-	FILE* imageFile;
 
 	spVerifyArgumentsNc(config != NULL && imageData != NULL, FAILED_WRITING_IMAGE_DATA, SP_DP_INVALID_ARGUMENT);
 
@@ -489,24 +559,38 @@ SP_DP_MESSAGES saveImageData(const SPConfig config,char* configSignature, SPImag
 		return outputMessage;
 	}
 
-	remove(filePath); //remove old files if exists
+	//replaces an old file if exists
+	outputMessage = spFeatsWriterSave(configSignature, filePath, imageData);
 
-	spValWcNc((imageFile = fopen(filePath, CREATE_IF_NOT_EXISTS_FILE_MODE)) != NULL, FAILED_OPEN_FILE,
-			spLoggerSafePrintWarning(FAILED_WRITING_IMAGE_DATA, __FILE__,__FUNCTION__, __LINE__);
-			free(filePath), SP_DP_FILE_WRITE_ERROR);
+	free(filePath);
+	return outputMessage;
+}
 
+/*
+ * Waits for the writer the images data were submitted to, with the failure budget of
+ * saveAllImagesData
+ */
+static SP_DP_MESSAGES finishSavingImagesData(const SPConfig config, SPFeatsWriter featsWriter){
+	SP_CONFIG_MSG configMessage = SP_CONFIG_SUCCESS;
+	SP_DP_MESSAGES outputMessage;
+	int numOfImages;
 
-	outputMessage = writeImageDataToFile(imageFile, imageData, configSignature);
+	numOfImages = spConfigGetNumOfImages(config, &configMessage);
+	spVal(configMessage == SP_CONFIG_SUCCESS, FAILED_WRITING_IMAGES_DATA,
+			SP_DP_INVALID_ARGUMENT);
 
-	fclose(imageFile);
-	free(filePath);
-	return outputMessage;
+	outputMessage = spFeatsWriterFinish(featsWriter,
+			numOfImages * MAX_ERRORS_PERCENTAGE_AT_SAVE_PROCESS / 100);
+	//reached the limit or a critical error - log error and return message
+	spVal(outputMessage == SP_DP_SUCCESS, FAILED_WRITING_IMAGES_DATA, outputMessage);
+	return SP_DP_SUCCESS;
 }
 
 SP_DP_MESSAGES saveAllImagesData(const SPConfig config, char* configSignature, SPImageData* imagesData){
 	SP_DP_MESSAGES outputMessage = SP_DP_SUCCESS;
 	SP_CONFIG_MSG configMessage;
-	int i, numOfImages, maxFailsAllowed;
+	SPFeatsWriter featsWriter;
+	int i, numOfImages;
 
 	spVerifyArguments(config != NULL && imagesData != NULL && configSignature != NULL,
 			FAILED_WRITING_IMAGES_DATA, SP_DP_INVALID_ARGUMENT);
@@ -518,31 +602,24 @@ SP_DP_MESSAGES saveAllImagesData(const SPConfig config, char* configSignature, S
 			spLoggerSafePrintWarning(WARNING_CONFIG_SHOULD_NOT_BE_NULL, __FILE__,__FUNCTION__, __LINE__),
 					SP_DP_INVALID_ARGUMENT);
 
-	maxFailsAllowed = numOfImages * MAX_ERRORS_PERCENTAGE_AT_SAVE_PROCESS / 100;
+	spVal((featsWriter = spFeatsWriterCreate(config, NULL)) != NULL, FAILED_WRITING_IMAGES_DATA,
+			SP_DP_MEMORY_FAILURE);
 
-	for (i = 0 ; i < numOfImages ; i++){
+	for (i = 0 ; i < numOfImages && outputMessage == SP_DP_SUCCESS ; i++){
 		spLoggerSafePrintDebugWithIndex(DEBUG_SAVING_IMAGE_TO_FEAT_INDEX, i,
 					__FILE__, __FUNCTION__, __LINE__);
-		outputMessage = saveImageData(config, configSignature, imagesData[i]);
-		if (outputMessage != SP_DP_SUCCESS){
-			if (maxFailsAllowed == 0 || outputMessage == SP_DP_MEMORY_FAILURE){
-				spLoggerSafePrintError(FAILED_WRITING_IMAGES_DATA,
-									__FILE__, __FUNCTION__, __LINE__);
-				return outputMessage;
-				//log error and return message
-			} else {
-				spLoggerSafePrintWarning(WARNING_SAVE_IMAGE_FEAT_LIMIT_NOT_REACHED,
-										__FILE__, __FUNCTION__, __LINE__);
-				//log warning
-				maxFailsAllowed--;
-			}
-		}
+		outputMessage = spFeatsWriterSubmit(featsWriter, imagesData[i]);
 	}
 
+	if (outputMessage == SP_DP_SUCCESS)
+		outputMessage = finishSavingImagesData(config, featsWriter);
+	spFeatsWriterDestroy(featsWriter);
+	spVal(outputMessage == SP_DP_SUCCESS, FAILED_WRITING_IMAGES_DATA, outputMessage);
 	return SP_DP_SUCCESS;
 }
 
-SP_DP_MESSAGES spImagesParserStartParsingProcess(const SPConfig config, SPImageData* allImagesData){
+SP_DP_MESSAGES spImagesParserStartParsingProcess(const SPConfig config, SPImageData* allImagesData,
+		SPFeatsWriter featsWriter){
 	SP_DP_MESSAGES msg = SP_DP_SUCCESS;
 	SP_CONFIG_MSG configMsg = SP_CONFIG_SUCCESS;
 	char* configSignature = NULL;
@@ -562,17 +639,22 @@ SP_DP_MESSAGES spImagesParserStartParsingProcess(const SPConfig config, SPImageD
 	configSignature = getSignature(config);
 	spVal(configSignature != NULL, FAILED_AT_IMAGE_PARSING_PROCESS, SP_DP_INVALID_ARGUMENT);
 
-	if (!createDatabase) {
+	if (!createDatabase && featsWriter == NULL) {
 		spLoggerSafePrintDebug(DEBUG_LOADING_IMAGES_DATA,
 					__FILE__, __FUNCTION__, __LINE__);
+		spInstrTimerStart(parseTimer);
 		msg = loadAllImagesData(config, configSignature, allImagesData);
+		spInstrTimerStop(parseTimer, SP_INSTR_FEATS_PARSE);
 		spLoggerSafePrintDebug(DEBUG_DONE_LOADING_IMAGES_DATA,
 					__FILE__, __FUNCTION__, __LINE__);
 	} else {
 		// already loaded allImagesData at main
 		spLoggerSafePrintDebug(DEBUG_SAVING_IMAGES_DATA,
 					__FILE__, __FUNCTION__, __LINE__);
-		msg = saveAllImagesData(config, configSignature, allImagesData);
+		if (featsWriter != NULL)
+			msg = finishSavingImagesData(config, featsWriter);
+		else
+			msg = saveAllImagesData(config, configSignature, allImagesData);
 		spLoggerSafePrintDebug(DEBUG_DONE_SAVING_IMAGES_DATA,
 					__FILE__, __FUNCTION__, __LINE__);
 	}
@@ -19,6 +19,9 @@ typedef enum sp_data_parse_messages {
 	SP_DP_FEATURE_EXTRACTION_ERROR
 } SP_DP_MESSAGES;
 
+/** Type of the background .feats writer, see SPFeatsWriter.h **/
+typedef struct sp_feats_writer_t* SPFeatsWriter;
+
 /*
  * The method gets a pre-allocated char array and returns
  * true if it represents a line i.e ends with '\n'
@@ -201,6 +204,9 @@ SP_DP_MESSAGES loadImageDataFromHeader(char* header, SPImageData image);
  * The method loads the images data into allImagesData, thus fills the ImageData array containing the features data.
  * in case of failure no data will be created,
  * and all the images data that has been created so far would be destroyed.
+ * The images are loaded by spLoadThreads threads, each taking chunks of consecutive images
+ * and loading them into their own slots, and up to MAX_ERRORS_PERCENTAGE_AT_SAVE_PROCESS
+ * percent of the images may fail to load (they are left with no features).
  *
  * @param config - the configurations data
  * @param configSignature - a string signature of the config file
@@ -299,6 +305,7 @@ SP_DP_MESSAGES loadImageData(const SPConfig config, char* configSignature, int i
 
 /*
  * The method gets an opened file pointer and an image data item and writes the image data to the file.
+ * The image data is serialized into memory and written by a single write.
  *
  * @param imageFile - a pointer to the file that the data should be written to
  * @param imageData - an item that contains the image data
@@ -317,7 +324,8 @@ SP_DP_MESSAGES writeImageDataToFile(FILE* imageFile, SPImageData imageData, char
 
 /*
  * The method saves to the disk an image data item at a CSV format.
- * The method will override an existing file with the same name.
+ * The method will override an existing file with the same name, the file is written
+ * to a temporary file that is renamed over it (see spFeatsWriterSave).
  *
  * @param config - the configurations data
  * @param configSignature - a string representing a signature of the config file
@@ -339,9 +347,10 @@ SP_DP_MESSAGES saveImageData(const SPConfig config,char* configSignature, SPImag
  * The method will consider a success if it can write more than a given percentage of .feats file,
  * this percentage is defined with the macro 'MAX_ERRORS_PERCENTAGE_AT_SAVE_PROCESS',
  * if more than MAX_ERRORS_PERCENTAGE_AT_SAVE_PROCESS % of the images fails, the method will announce
- * a failure and return the last failure message reason
+ * a failure and return the first failure message reason
  *
- * In case of failure the method will stop writing files, those who were written would not be deleted
+ * The images are saved by spSaveThreads threads (see SPFeatsWriter.h), all of them are tried
+ * and the files that were written would not be deleted
  *
  *
  * @param config - the configurations data.
@@ -361,9 +370,16 @@ SP_DP_MESSAGES saveAllImagesData(const SPConfig config, char* configSignature, S
 
 /*
  * The main method that starts and loads all the images data according to the configurations
+ * In extraction mode the images data are saved: if featsWriter is not NULL the images
+ * were submitted to it during the extraction and the method waits for it to finish,
+ * otherwise they are saved by saveAllImagesData. In both cases the failure budget of
+ * saveAllImagesData applies. If featsWriter is not NULL out of extraction mode (an
+ * update run) the images data were already loaded or extracted, and it is waited for
+ * the same way.
  *
  * @param config - the config file
  * @imagesData - a list of images data, the method will fill all the relevant data into it
+ * @param featsWriter - the writer the extracted images were submitted to, or NULL
  *
  * @returns :
  * 	    SP_DP_INVALID_ARGUMENT - config is NULL,
@@ -376,7 +392,8 @@ SP_DP_MESSAGES saveAllImagesData(const SPConfig config, char* configSignature, S
  *
  * @logger - Prints relevant errors and warnings to the logger.
  */
-SP_DP_MESSAGES spImagesParserStartParsingProcess(const SPConfig config, SPImageData* imagesData);
+SP_DP_MESSAGES spImagesParserStartParsingProcess(const SPConfig config, SPImageData* imagesData,
+		SPFeatsWriter featsWriter);
 
 
 #endif /* SPIMAGESPARSER_H_ */
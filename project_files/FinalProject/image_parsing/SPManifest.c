@@ -0,0 +1,417 @@
+#define _POSIX_C_SOURCE 200809L // stat under -std=c99
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <pthread.h>
+#include "SPManifest.h"
+#include "SPFeatsReader.h"
+#include "../SPLogger.h"
+#include "../general_utils/SPUtils.h"
+
+#define MANIFEST_HEADER						"SPCBIR features manifest 2\n"
+#define ENTRY_NUMBERS_FORMAT				"%d %lld %lld %llx %d %d %d %d %llx%n"
+#define ENTRY_FORMAT						"%d %lld %lld %016llx %d %d %d %d %016llx\t%s\t%s\n"
+#define SIGNATURE_LINE_FORMAT				"%s\n"
+#define TEMP_PATH_FORMAT					"%s%s"
+#define TEMP_FILE_SUFFIX					".tmp"
+#define READ_MODE							"r"
+#define WRITE_MODE							"w"
+#define APPEND_MODE							"a"
+#define ENTRY_NUMBERS_COUNT					9
+#define SIGNATURE_LENGTH					(2 * MAX_PATH_LEN) // as allocated by getSignature
+#define MANIFEST_LINE_LENGTH				(4 * MAX_PATH_LEN)
+#define HASH_BLOCK_SIZE						8192
+#define FNV_OFFSET_BASIS					14695981039346656037ULL
+#define FNV_PRIME							1099511628211ULL
+#define FIELD_SEPARATOR						'\t'
+#define LINE_SEPARATOR						'\n'
+#define END_OF_STRING						'\0'
+
+#define FAILED_HASHING_FILE					"Failed hashing a file"
+#define FAILED_CREATING_MANIFEST			"Failed creating the features manifest"
+#define FAILED_OPEN_MANIFEST				"Could not open the features manifest file for writing"
+#define FAILED_CHECKING_IMAGE				"Failed checking an image against the features manifest"
+#define FAILED_LOADING_UNCHANGED_IMAGE		"Failed loading the .feats file of an unchanged image"
+#define FAILED_COMMITTING_ENTRY				"Failed committing an image to the features manifest"
+#define FAILED_APPENDING_ENTRY				"Failed appending an entry to the features manifest file"
+#define FAILED_SAVING_MANIFEST				"Failed saving the features manifest file"
+#define WARNING_PCA_NOT_HASHED				"Could not hash the PCA file, all the images are extracted"
+#define WARNING_MANIFEST_NOT_LOADED			"The features manifest file has another format, all the images are extracted"
+#define WARNING_IMAGE_NOT_READ				"Could not read an image file, it is not recorded in the features manifest"
+#define WARNING_ENTRY_NOT_UPDATED			"Could not update the features manifest entry of a touched image"
+
+/*
+ * The entry of an image in the manifest, see the summary at SPManifest.h
+ * isSet - the image has an entry
+ * signature - the signature line (without the '\n') the .feats file was saved with
+ */
+typedef struct manifest_entry_t {
+	bool isSet;
+	long long size;
+	long long mtime;
+	unsigned long long hash;
+	int numOfFeatures;
+	int maxFeatures;
+	int PCADim;
+	int maxDimension;
+	unsigned long long PCAHash;
+	char path[MAX_PATH_LEN];
+	char signature[SIGNATURE_LENGTH];
+} ManifestEntry;
+
+/*
+ * The image file as spManifestCheckImage found it, the next commit of the image records it
+ */
+typedef struct manifest_observation_t {
+	bool isObserved;
+	long long size;
+	long long mtime;
+	unsigned long long hash;
+	char path[MAX_PATH_LEN];
+} ManifestObservation;
+
+/*
+ * A structure used for the features manifest
+ * signature - the signature of the configuration without its '\n'
+ * journal - the manifest file, open for appending the committed entries
+ * lock - guards the entries and the journal, the observations are changed only by the
+ * thread that checks the images
+ */
+struct sp_manifest_t {
+	SPConfig config;
+	char path[MAX_PATH_LEN];
+	char* signature;
+	int numOfImages;
+	int maxFeatures;
+	int PCADim;
+	int maxDimension;
+	unsigned long long PCAHash;
+	bool hasPCAHash;
+	ManifestEntry* entries;
+	ManifestObservation* observed;
+	FILE* journal;
+	pthread_mutex_t lock;
+};
+
+SP_DP_MESSAGES spManifestHashFile(const char* path, unsigned long long* hash) {
+	unsigned char block[HASH_BLOCK_SIZE];
+	unsigned long long value = FNV_OFFSET_BASIS;
+	size_t length, i;
+	FILE* file;
+	bool isRead;
+
+	spVerifyArguments(path != NULL && hash != NULL, FAILED_HASHING_FILE,
+			SP_DP_INVALID_ARGUMENT);
+	spValNc((file = fopen(path, READ_MODE)) != NULL, FAILED_HASHING_FILE,
+			SP_DP_FILE_READ_ERROR);
+
+	while ((length = fread(block, 1, HASH_BLOCK_SIZE, file)) > 0) {
+		for (i = 0; i < length; i++)
+			value = (value ^ block[i]) * FNV_PRIME;
+	}
+	isRead = !ferror(file);
+	fclose(file);
+	spValNc(isRead, FAILED_HASHING_FILE, SP_DP_FILE_READ_ERROR);
+
+	*hash = value;
+	return SP_DP_SUCCESS;
+}
+
+/*
+ * Parses a manifest line into the entry of its image
+ *
+ * @return false if the line is not a whole entry line of an image of the configuration
+ */
+static bool parseEntry(SPManifest manifest, char* line) {
+	ManifestEntry entry;
+	char *path, *signature;
+	size_t length = strlen(line);
+	int index, consumed = 0;
+
+	if (length == 0 || line[length - 1] != LINE_SEPARATOR) // a broken last line
+		return false;
+	line[length - 1] = END_OF_STRING;
+
+	if (sscanf(line, ENTRY_NUMBERS_FORMAT, &index, &(entry.size), &(entry.mtime),
+			&(entry.hash), &(entry.numOfFeatures), &(entry.maxFeatures), &(entry.PCADim),
+			&(entry.maxDimension), &(entry.PCAHash), &consumed) != ENTRY_NUMBERS_COUNT ||
+			line[consumed] != FIELD_SEPARATOR || index < 0 ||
+			index >= manifest->numOfImages)
+		return false;
+
+	path = line + consumed + 1;
+	if ((signature = strchr(path, FIELD_SEPARATOR)) == NULL)
+		return false;
+	*(signature++) = END_OF_STRING;
+	if (strchr(signature, FIELD_SEPARATOR) != NULL || strlen(path) >= MAX_PATH_LEN ||
+			strlen(signature) >= SIGNATURE_LENGTH)
+		return false;
+
+	strcpy(entry.path, path);
+	strcpy(entry.signature, signature);
+	entry.isSet = true;
+	manifest->entries[index] = entry;
+	return true;
+}
+
+/*
+ * Loads the entries of the manifest file, the lines that are not entries are skipped
+ *
+ * @param isLastLineBroken - *isLastLineBroken is set to true if the file does not end
+ * with a whole line, then the next entry is appended after a line separator
+ *
+ * @return false if the file does not exist or has another header
+ */
+static bool loadManifestFile(SPManifest manifest, bool* isLastLineBroken) {
+	char line[MANIFEST_LINE_LENGTH];
+	bool isLineStart = true, isLineEnd;
+	FILE* file;
+
+	if ((file = fopen(manifest->path, READ_MODE)) == NULL)
+		return false;
+	if (fgets(line, MANIFEST_LINE_LENGTH, file) == NULL || strcmp(line, MANIFEST_HEADER)) {
+		fclose(file);
+		spLoggerSafePrintWarning(WARNING_MANIFEST_NOT_LOADED, __FILE__, __FUNCTION__,
+				__LINE__);
+		return false;
+	}
+
+	while (fgets(line, MANIFEST_LINE_LENGTH, file) != NULL) {
+		// the rest of a line that is too long is not parsed as a line of its own
+		isLineEnd = line[strlen(line) - 1] == LINE_SEPARATOR;
+		if (isLineStart)
+			parseEntry(manifest, line);
+		isLineStart = isLineEnd;
+	}
+	fclose(file);
+	*isLastLineBroken = !isLineStart;
+	return true;
+}
+
+/*
+ * Writes an entry line to a manifest file
+ *
+ * @return true if the line was written
+ */
+static bool writeEntry(FILE* file, int index, const ManifestEntry* entry) {
+	return fprintf(file, ENTRY_FORMAT, index, entry->size, entry->mtime, entry->hash,
+			entry->numOfFeatures, entry->maxFeatures, entry->PCADim, entry->maxDimension,
+			entry->PCAHash, entry->path, entry->signature) >= 0;
+}
+
+SPManifest spManifestCreate(const SPConfig config) {
+	SP_CONFIG_MSG configMessage = SP_CONFIG_SUCCESS;
+	SPManifest manifest = NULL;
+	char PCAPath[MAX_PATH_LEN];
+	size_t length;
+	bool isLoaded, isLastLineBroken = false;
+
+	spVerifyArgumentsRn(config != NULL, FAILED_CREATING_MANIFEST);
+
+	spCallocEr(manifest, struct sp_manifest_t, 1, FAILED_CREATING_MANIFEST, NULL);
+	manifest->config = config;
+	manifest->numOfImages = spConfigGetNumOfImages(config, &configMessage);
+	manifest->maxFeatures = spConfigGetNumOfFeatures(config, &configMessage);
+	manifest->PCADim = spConfigGetPCADim(config, &configMessage);
+	manifest->maxDimension = spConfigGetMaxImageDimension(config, &configMessage);
+	spValWcRn(configMessage == SP_CONFIG_SUCCESS && manifest->numOfImages > 0 &&
+			spConfigGetManifestPath(manifest->path, config) == SP_CONFIG_SUCCESS &&
+			spConfigGetPCAPath(PCAPath, config) == SP_CONFIG_SUCCESS,
+			FAILED_CREATING_MANIFEST, free(manifest));
+
+	spValWcRn((manifest->signature = getSignature(config)) != NULL,
+			FAILED_CREATING_MANIFEST, free(manifest));
+	length = strlen(manifest->signature);
+	if (length > 0 && manifest->signature[length - 1] == LINE_SEPARATOR)
+		manifest->signature[length - 1] = END_OF_STRING;
+
+	spCallocErWc(manifest->entries, ManifestEntry, manifest->numOfImages,
+			FAILED_CREATING_MANIFEST, free(manifest->signature); free(manifest));
+	spCallocErWc(manifest->observed, ManifestObservation, manifest->numOfImages,
+			FAILED_CREATING_MANIFEST,
+			free(manifest->entries); free(manifest->signature); free(manifest));
+	spValWcRn(pthread_mutex_init(&(manifest->lock), NULL) == 0, FAILED_CREATING_MANIFEST,
+			free(manifest->observed); free(manifest->entries); free(manifest->signature);
+			free(manifest));
+
+	// no entry is unchanged if the PCA file is unknown
+	manifest->hasPCAHash = spManifestHashFile(PCAPath, &(manifest->PCAHash)) ==
+			SP_DP_SUCCESS;
+	if (!manifest->hasPCAHash)
+		spLoggerSafePrintWarning(WARNING_PCA_NOT_HASHED, __FILE__, __FUNCTION__, __LINE__);
+
+	isLoaded = loadManifestFile(manifest, &isLastLineBroken);
+	manifest->journal = fopen(manifest->path, isLoaded ? APPEND_MODE : WRITE_MODE);
+	spValWcRn(manifest->journal != NULL && (isLoaded ||
+			fputs(MANIFEST_HEADER, manifest->journal) >= 0) && (!isLastLineBroken ||
+			fputc(LINE_SEPARATOR, manifest->journal) != EOF) &&
+			fflush(manifest->journal) == 0, FAILED_OPEN_MANIFEST,
+			spManifestDestroy(manifest));
+
+	return manifest;
+}
+
+bool spManifestCheckImage(SPManifest manifest, int index) {
+	ManifestObservation* observation;
+	ManifestEntry* entry;
+	struct stat status;
+	bool isSameExtraction, isSameFile;
+
+	spVerifyArguments(manifest != NULL && index >= 0 && index < manifest->numOfImages,
+			FAILED_CHECKING_IMAGE, false);
+
+	observation = &(manifest->observed[index]);
+	observation->isObserved = false;
+	spValNc(spConfigGetImagePath(observation->path, manifest->config, index) ==
+			SP_CONFIG_SUCCESS && stat(observation->path, &status) == 0,
+			WARNING_IMAGE_NOT_READ, false);
+	observation->size = (long long) status.st_size;
+	observation->mtime = (long long) status.st_mtime;
+
+	pthread_mutex_lock(&(manifest->lock));
+	entry = &(manifest->entries[index]);
+	isSameExtraction = entry->isSet && manifest->hasPCAHash &&
+			entry->PCAHash == manifest->PCAHash &&
+			entry->maxFeatures == manifest->maxFeatures &&
+			entry->PCADim == manifest->PCADim && entry->maxDimension == manifest->maxDimension &&
+			!strcmp(entry->path, observation->path);
+	isSameFile = isSameExtraction && entry->size == observation->size &&
+			entry->mtime == observation->mtime;
+	if (isSameFile)
+		observation->hash = entry->hash;
+	pthread_mutex_unlock(&(manifest->lock));
+
+	// the size and the modification time are trusted, the contents are hashed otherwise
+	if (!isSameFile) {
+		spValNc(spManifestHashFile(observation->path, &(observation->hash)) ==
+				SP_DP_SUCCESS, WARNING_IMAGE_NOT_READ, false);
+		pthread_mutex_lock(&(manifest->lock));
+		isSameFile = isSameExtraction && entry->hash == observation->hash;
+		pthread_mutex_unlock(&(manifest->lock));
+	}
+	observation->isObserved = true;
+	return isSameFile;
+}
+
+SP_DP_MESSAGES spManifestLoadImageData(SPManifest manifest, SPImageData imageData,
+		bool* isSaveNeeded) {
+	char featsPath[MAX_PATH_LEN], signature[SIGNATURE_LENGTH + 1];
+	ManifestObservation* observation;
+	ManifestEntry* entry;
+	SP_DP_MESSAGES message;
+	bool isTouched, isSignatureChanged;
+
+	spVerifyArguments(manifest != NULL && imageData != NULL && isSaveNeeded != NULL &&
+			imageData->index >= 0 && imageData->index < manifest->numOfImages,
+			FAILED_LOADING_UNCHANGED_IMAGE, SP_DP_INVALID_ARGUMENT);
+
+	observation = &(manifest->observed[imageData->index]);
+	pthread_mutex_lock(&(manifest->lock));
+	entry = &(manifest->entries[imageData->index]);
+	if (entry->isSet)
+		sprintf(signature, SIGNATURE_LINE_FORMAT, entry->signature);
+	pthread_mutex_unlock(&(manifest->lock));
+	spVerifyArguments(entry->isSet && observation->isObserved,
+			FAILED_LOADING_UNCHANGED_IMAGE, SP_DP_INVALID_ARGUMENT);
+
+	spVal(spConfigGetImagePathFeats(featsPath, manifest->config, imageData->index, true) ==
+			SP_CONFIG_SUCCESS, FAILED_LOADING_UNCHANGED_IMAGE, SP_DP_INVALID_ARGUMENT);
+	spValNc((message = spFeatsReaderLoad(signature, featsPath, imageData)) == SP_DP_SUCCESS,
+			FAILED_LOADING_UNCHANGED_IMAGE, message);
+
+	pthread_mutex_lock(&(manifest->lock));
+	message = imageData->numOfFeatures == entry->numOfFeatures ? SP_DP_SUCCESS :
+			SP_DP_FORMAT_ERROR;
+	isSignatureChanged = strcmp(entry->signature, manifest->signature) != 0;
+	isTouched = entry->size != observation->size || entry->mtime != observation->mtime;
+	pthread_mutex_unlock(&(manifest->lock));
+	spValWcNc(message == SP_DP_SUCCESS, FAILED_LOADING_UNCHANGED_IMAGE,
+			resetImageData(imageData), message);
+
+	// an image that is saved again is committed by its save
+	*isSaveNeeded = isSignatureChanged;
+	if (!isSignatureChanged && isTouched && spManifestCommit(manifest, imageData->index,
+			imageData->numOfFeatures) != SP_DP_SUCCESS)
+		spLoggerSafePrintWarning(WARNING_ENTRY_NOT_UPDATED, __FILE__, __FUNCTION__,
+				__LINE__);
+	return SP_DP_SUCCESS;
+}
+
+SP_DP_MESSAGES spManifestCommit(SPManifest manifest, int index, int numOfFeatures) {
+	ManifestObservation* observation;
+	ManifestEntry* entry;
+	bool isWritten;
+
+	spVerifyArguments(manifest != NULL && index >= 0 && index < manifest->numOfImages &&
+			manifest->observed[index].isObserved, FAILED_COMMITTING_ENTRY,
+			SP_DP_INVALID_ARGUMENT);
+
+	observation = &(manifest->observed[index]);
+	pthread_mutex_lock(&(manifest->lock));
+	entry = &(manifest->entries[index]);
+	entry->isSet = true;
+	entry->size = observation->size;
+	entry->mtime = observation->mtime;
+	entry->hash = observation->hash;
+	entry->numOfFeatures = numOfFeatures;
+	entry->maxFeatures = manifest->maxFeatures;
+	entry->PCADim = manifest->PCADim;
+	entry->maxDimension = manifest->maxDimension;
+	entry->PCAHash = manifest->PCAHash;
+	strcpy(entry->path, observation->path);
+	strcpy(entry->signature, manifest->signature);
+	isWritten = manifest->journal != NULL && writeEntry(manifest->journal, index, entry) &&
+			fflush(manifest->journal) == 0;
+	pthread_mutex_unlock(&(manifest->lock));
+
+	spVal(isWritten, FAILED_APPENDING_ENTRY, SP_DP_FILE_WRITE_ERROR);
+	return SP_DP_SUCCESS;
+}
+
+SP_DP_MESSAGES spManifestSave(SPManifest manifest) {
+	char tempPath[MAX_PATH_LEN + sizeof(TEMP_FILE_SUFFIX)];
+	FILE* file;
+	bool isWritten;
+	int i;
+
+	spVerifyArguments(manifest != NULL, FAILED_SAVING_MANIFEST, SP_DP_INVALID_ARGUMENT);
+
+	sprintf(tempPath, TEMP_PATH_FORMAT, manifest->path, TEMP_FILE_SUFFIX);
+	spVal((file = fopen(tempPath, WRITE_MODE)) != NULL, FAILED_SAVING_MANIFEST,
+			SP_DP_FILE_WRITE_ERROR);
+
+	pthread_mutex_lock(&(manifest->lock));
+	isWritten = fputs(MANIFEST_HEADER, file) >= 0;
+	for (i = 0; i < manifest->numOfImages && isWritten; i++) {
+		if (manifest->entries[i].isSet)
+			isWritten = writeEntry(file, i, &(manifest->entries[i]));
+	}
+	isWritten = fclose(file) == 0 && isWritten;
+	if (isWritten && rename(tempPath, manifest->path) == 0) {
+		if (manifest->journal != NULL)
+			fclose(manifest->journal);
+		manifest->journal = fopen(manifest->path, APPEND_MODE);
+	} else {
+		remove(tempPath);
+		isWritten = false;
+	}
+	pthread_mutex_unlock(&(manifest->lock));
+
+	spVal(isWritten, FAILED_SAVING_MANIFEST, SP_DP_FILE_WRITE_ERROR);
+	spVal(manifest->journal != NULL, FAILED_OPEN_MANIFEST, SP_DP_FILE_WRITE_ERROR);
+	return SP_DP_SUCCESS;
+}
+
+void spManifestDestroy(SPManifest manifest) {
+	if (manifest == NULL)
+		return;
+	if (manifest->journal != NULL)
+		fclose(manifest->journal);
+	pthread_mutex_destroy(&(manifest->lock));
+	free(manifest->observed);
+	free(manifest->entries);
+	free(manifest->signature);
+	free(manifest);
+}
@@ -0,0 +1,141 @@
+#ifndef SPMANIFEST_H_
+#define SPMANIFEST_H_
+
+#include <stdbool.h>
+#include "SPImagesParser.h"
+#include "SPImageData.h"
+
+/**
+ * SP Manifest summary
+ *
+ * The features manifest records, for every image whose .feats file was saved, the image
+ * file it was extracted from and the extraction parameters, one text line per image:
+ * 		<index> <size> <mtime> <content hash> <number of features> <spNumOfFeatures>
+ * 		<PCA dimension> <spMaxImageDimension> <PCA file hash>\t<image path>\t<.feats signature>
+ * The hashes are 64 bit FNV-1a hashes of the whole file contents, in hex.
+ *
+ * An image is unchanged if it has an entry with its current path and extraction
+ * parameters, and either its size and modification time match the entry or (after a
+ * touch or a copy) its content hash does. The descriptors of an unchanged image are
+ * loaded from its .feats file instead of being extracted again.
+ *
+ * An entry is appended to the manifest file (and flushed) as soon as its .feats file is
+ * saved, so an extraction that crashed is resumed by an update run from the images that
+ * were saved. Later lines override earlier ones, and a broken last line is ignored.
+ * spManifestSave rewrites the file with one line per image.
+ *
+ * The following functions are supported:
+ *
+ * spManifestHashFile			- Hashes the contents of a file
+ * spManifestCreate				- Loads the manifest of the configuration
+ * spManifestCheckImage			- Checks if an image is unchanged since its entry
+ * spManifestLoadImageData		- Loads the descriptors of an unchanged image
+ * spManifestCommit				- Records the entry of a saved image
+ * spManifestSave				- Rewrites the manifest file
+ * spManifestDestroy			- Frees the manifest
+ */
+
+/** Type for defining the manifest **/
+typedef struct sp_manifest_t* SPManifest;
+
+/*
+ * Hashes the contents of a file by 64 bit FNV-1a
+ *
+ * @param path - the file path
+ * @param hash - the hash is written to *hash
+ *
+ * @return -
+ * SP_DP_INVALID_ARGUMENT - if an argument is NULL
+ * SP_DP_FILE_READ_ERROR - the file could not be opened or read
+ * SP_DP_SUCCESS - otherwise
+ */
+SP_DP_MESSAGES spManifestHashFile(const char* path, unsigned long long* hash);
+
+/*
+ * Loads the manifest file of the configuration (spManifestFilename in the images
+ * directory) if it exists, hashes the PCA file and opens the manifest file for appending
+ * the entries of the saved images.
+ * The PCA file must already be the one the images are extracted with.
+ *
+ * @param config - the configuration, it must stay valid until the manifest is destroyed
+ *
+ * @returns NULL in case of invalid argument, memory allocation error or if the manifest
+ * file could not be opened for writing, otherwise the manifest
+ *
+ * @logger - Prints relevant errors and warnings to the logger.
+ */
+SPManifest spManifestCreate(const SPConfig config);
+
+/*
+ * Stats (and if needed hashes) the image file of the given index, and records it for the
+ * next commit of the image.
+ *
+ * @param manifest - the manifest
+ * @param index - the image index
+ *
+ * @returns true if the image is unchanged since its entry, false otherwise or if the
+ * image file could not be read (then the image can not be committed)
+ */
+bool spManifestCheckImage(SPManifest manifest, int index);
+
+/*
+ * Loads the descriptors of an unchanged image from its .feats file, which was saved with
+ * the signature of its entry. If the image file was only touched its entry is updated.
+ * On failure the image should be extracted again.
+ *
+ * @param manifest - the manifest
+ * @param imageData - an allocated SPImageData item of a checked image
+ * @param isSaveNeeded - *isSaveNeeded is set to true if the .feats file has another
+ * signature than the current configuration, so the image has to be saved again
+ *
+ * @return -
+ * SP_DP_INVALID_ARGUMENT - if an argument is NULL or the image has no entry
+ * SP_DP_FORMAT_ERROR - the .feats file does not have the features of the entry
+ * the messages of spFeatsReaderLoad otherwise
+ *
+ * @logger - Prints relevant errors and warnings to the logger.
+ */
+SP_DP_MESSAGES spManifestLoadImageData(SPManifest manifest, SPImageData imageData,
+		bool* isSaveNeeded);
+
+/*
+ * Records the entry of an image whose .feats file was saved with the signature of the
+ * configuration, and appends it to the manifest file. It is thread safe.
+ *
+ * @param manifest - the manifest
+ * @param index - the image index, it must have been checked
+ * @param numOfFeatures - the number of features that were saved
+ *
+ * @return -
+ * SP_DP_INVALID_ARGUMENT - if manifest is NULL or the image was not checked
+ * SP_DP_FILE_WRITE_ERROR - the entry could not be appended
+ * SP_DP_SUCCESS - otherwise
+ *
+ * @logger - Prints relevant errors to the logger.
+ */
+SP_DP_MESSAGES spManifestCommit(SPManifest manifest, int index, int numOfFeatures);
+
+/*
+ * Rewrites the manifest file with the current entries, through a temporary file that is
+ * renamed over it, and reopens it for appending.
+ *
+ * @param manifest - the manifest
+ *
+ * @return -
+ * SP_DP_INVALID_ARGUMENT - if manifest is NULL
+ * SP_DP_FILE_WRITE_ERROR - the file could not be written, it is left unchanged
+ * SP_DP_SUCCESS - otherwise
+ *
+ * @logger - Prints relevant errors to the logger.
+ */
+SP_DP_MESSAGES spManifestSave(SPManifest manifest);
+
+/*
+ * Frees all the resources of the manifest, the manifest file keeps the committed
+ * entries. If manifest is NULL nothing happens.
+ *
+ * @param manifest - the manifest
+ */
+void spManifestDestroy(SPManifest manifest);
+
+#endif /* SPMANIFEST_H_ */
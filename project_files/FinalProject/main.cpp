@@ -10,10 +10,13 @@ extern "C" {
 #include "SPLogger.h"
 #include "SPPoint.h"
 #include "image_parsing/SPImagesParser.h"
+#include "image_parsing/SPFeatsWriter.h"
+#include "image_parsing/SPManifest.h"
 #include "main_and_ui/SPImageQuery.h"
+#include "main_and_ui/SPQueryCache.h"
 #include "main_and_ui/SPMainAux.h"
-#include "data_structures/bpqueue_ds/SPBPriorityQueue.h"
-#include "data_structures/kd_ds/SPKDTreeNode.h"
+#include "data_structures/index_ds/SPSearchIndex.h"
+#include "general_utils/SPInstrumentation.h"
 }
 
 #define QUERY_EXIT_INPUT 							"<>"
@@ -22,7 +25,15 @@ extern "C" {
 #define ERROR_INIT_CONFIG 							"Error initializing settings"
 #define ERROR_INIT_IMAGES 							"Error at initialize images data items process"
 #define ERROR_INIT_KDTREE_OR_DATA 					"Error building the data structures"
-#define REQUEST_QUERY_AGAIN							"Please enter a valid file path, or <> to exit.\n"
+#define ERROR_SAVING_IMAGES_DATA 					"Error at saving the extracted images data"
+#define ERROR_INIT_MANIFEST 						"Error at loading the features manifest"
+#define ERROR_INIT_QUERY_CACHE 						"Error creating the query cache"
+#define REQUEST_QUERY_AGAIN							"Please enter a valid file path, + to add the next image, -<index> to remove an image, or <> to exit.\n"
+#define IMAGE_ADDED									"Image %d (%s) was added to the database\n"
+#define IMAGE_NOT_ADDED								"The next image (index %d) could not be added to the database\n"
+#define IMAGE_REMOVED								"Image %d was removed from the database\n"
+#define IMAGE_NOT_REMOVED							"Image %d could not be removed from the database\n"
+#define QUERY_TRUNCATED								"The search reached its time limit, the results are based on the strongest features of the query image\n"
 #define	FAIL_SEARCHING_IMAGES						"Failed during querying the database, thus similar images could not be found"
 #define WRONG_USER_QUERY 							"Wrong user input. neither a valid image path, nor exit request"
 #define DEBUG_IMAGES_PRESENTED_GUI					"Similar images are being presented - GUI mode"
@@ -42,8 +53,10 @@ extern "C" {
 #define INITIALIZATION_FINISHED_SUCCESSFUL  		"Initialization finished successful"
 #define SIMILAR_IMAGES_PRESENTED					"Similar images to the last query has been presented to the user"
 #define QUERY_HAS_BEEN_INSERTED 					"A legal query has been inserted by the user : "
+#define INDEX_UPDATE_HAS_BEEN_INSERTED 				"An index update has been inserted by the user : "
 #define ILLEGAL_QUERY_HAS_BEEN_INSERTED 			"An illegal query has been inserted by the user : "
 #define INTERNAL_DATA_AND_LOGIC_CREATED 			"Internal data and logic layer has been created successfully, the user can start querying now"
+#define DEBUG_UNCHANGED_IMAGE_REUSED				"The .feats file of an unchanged image is reused at index - "
 /*-------------------------------------------------------------------------------------------------------------------------------------------------*/
 
 /*
@@ -52,7 +65,7 @@ extern "C" {
  */
 #define spMainAction(action, returnValue) do { \
                 if(!((action))) { \
-					endControlFlow(config, currentImageData, isCurrentImageFeaturesArrayAllocated, kdTree, bpq, returnValue);\
+					endControlFlow(config, currentImageData, isCurrentImageFeaturesArrayAllocated, searchIndex, queryContext, queryCache, returnValue);\
 					delete imageProcObject;\
 					return returnValue; \
                 } \
@@ -63,6 +76,9 @@ extern "C" {
  * The method initializes the project, loads the settings, the logger, the images data and build's
  * the KD data structure with the images data, it loads the data into the pointers that are
  * given as parameters
+ * In extraction mode and in an update run ("--update") the extracted images are recorded in the
+ * features manifest, and an update run extracts only the images that changed since they were
+ * recorded, the others are loaded from their .feats files.
  *
  * @param argc - the count of arguments from the main method
  * @param argv - the arguments from the main method
@@ -71,10 +87,11 @@ extern "C" {
  * @param numOfSimilarImages - a pointer to the number of similar images integer
  * @param extractFlag - a pointer to the extraction flag
  * @param GUIFlag - a pointer to the GUI flag
- * @param bpq - a pointer for the priority queue
+ * @param queryContext - a pointer for the query context
  * @param currentImageData - a pointer for an image data that needs to be allocated
- * @param kdTree - a pointer to the kd-tree
+ * @param searchIndex - a pointer to the search index
  * @param imageProbObject - a pointer to the image proc object pointer
+ * @param queryCache - a pointer to the query cache
  *
  * @returns :
  * '-1' - configuration or logger initialization failed
@@ -83,13 +100,17 @@ extern "C" {
  * '0'  - success
  */
 int spMainInitialize(int argc, char** argv, SPConfig* config, int* numOfImages,
-		int* numOfSimilarImages, bool* extractFlag, bool* GUIFlag, SPBPQueue* bpq,
-		SPImageData* currentImageData, SPKDTreeNode* kdTree, sp::ImageProc** imageProcObject){
+		int* numOfSimilarImages, bool* extractFlag, bool* GUIFlag, SPQueryContext* queryContext,
+		SPImageData* currentImageData, SPSearchIndex* searchIndex, sp::ImageProc** imageProcObject,
+		SPQueryCache* queryCache){
 	int i;
 	char tempPath[MAX_PATH_LEN];
 	SPImageData* imagesDataList = NULL;
+	SPFeatsWriter featsWriter = NULL;
+	SPManifest manifest = NULL;
+	bool updateFlag = false, isUnchanged, isSaveNeeded;
 
-	if(!initConfigAndLogger(argc, argv, config)) {
+	if(!initConfigAndLogger(argc, argv, config, &updateFlag)) {
 		return INIT_CONFIG_OR_LOGGER_ERROR_RETURN_VALUE;
 	}
 
@@ -104,25 +125,64 @@ int spMainInitialize(int argc, char** argv, SPConfig* config, int* numOfImages,
 
 	//build features database
 	(*imageProcObject) = new sp::ImageProc(*config);
-	if (*extractFlag) {
+	if (*extractFlag || updateFlag) {
+		//the manifest hashes the PCA file, so it is created after the PCA is
+		spValWc((manifest = spManifestCreate(*config)) != NULL, ERROR_INIT_MANIFEST,
+				freeAllImagesData(imagesDataList, *numOfImages, true),
+				IMAGE_DATA_LOGIC_ERROR_RETURN_VALUE);
+		//the extracted images are saved to their .feats files meanwhile
+		spValWc((featsWriter = spFeatsWriterCreate(*config, manifest)) != NULL,
+				ERROR_SAVING_IMAGES_DATA,
+				spManifestDestroy(manifest);
+				freeAllImagesData(imagesDataList, *numOfImages, true),
+				IMAGE_DATA_LOGIC_ERROR_RETURN_VALUE);
 		for (i = 0; i < *numOfImages; i++){
 			spValWc((spConfigGetImagePath(tempPath, *config, i) == SP_CONFIG_SUCCESS),
 					ERROR_LOADING_IMAGE_PATH,
+					spFeatsWriterDestroy(featsWriter);
+					spManifestDestroy(manifest);
+					freeAllImagesData(imagesDataList, *numOfImages,true),
+					IMAGE_DATA_LOGIC_ERROR_RETURN_VALUE);
+			//every image is checked, so the manifest can record it once it is saved
+			isSaveNeeded = true;
+			isUnchanged = spManifestCheckImage(manifest, i) && updateFlag &&
+					spManifestLoadImageData(manifest, imagesDataList[i], &isSaveNeeded) ==
+					SP_DP_SUCCESS;
+			if (isUnchanged)
+				spLoggerSafePrintDebugWithIndex(DEBUG_UNCHANGED_IMAGE_REUSED, i, __FILE__,
+						__FUNCTION__, __LINE__);
+			else
+				imagesDataList[i]->featuresArray = (*imageProcObject)->getImageFeatures(
+						tempPath, i, &(imagesDataList[i]->numOfFeatures));
+			//an unchanged image is saved again only if its .feats file has another signature
+			spValWc(!isSaveNeeded ||
+					spFeatsWriterSubmit(featsWriter, imagesDataList[i]) == SP_DP_SUCCESS,
+					ERROR_SAVING_IMAGES_DATA,
+					spFeatsWriterDestroy(featsWriter);
+					spManifestDestroy(manifest);
 					freeAllImagesData(imagesDataList, *numOfImages,true),
 					IMAGE_DATA_LOGIC_ERROR_RETURN_VALUE);
-			imagesDataList[i]->featuresArray = (*imageProcObject)->getImageFeatures(tempPath,
-					i, &(imagesDataList[i]->numOfFeatures));
 		}
 		spLoggerSafePrintInfo(EXTRACTED_IMAGES_DATA);
 	}
 
-	spValWc((initializeWorkingImageKDTreeAndBPQueue(*config, imagesDataList,
-		currentImageData, kdTree, bpq, *numOfImages)), ERROR_INIT_KDTREE_OR_DATA,
+	spValWc((initializeWorkingImageKDTreeAndQueryContext(*config, imagesDataList, featsWriter,
+		currentImageData, searchIndex, queryContext, *numOfImages)), ERROR_INIT_KDTREE_OR_DATA,
+			spFeatsWriterDestroy(featsWriter);
+			spManifestDestroy(manifest);
 			freeAllImagesData(imagesDataList, *numOfImages, true),
 			IMAGE_DATA_LOGIC_ERROR_RETURN_VALUE);
 
+	spFeatsWriterDestroy(featsWriter);
+	//the manifest file has one line per image from now on, the failure is logged by the manifest
+	if (manifest != NULL)
+		spManifestSave(manifest);
+	spManifestDestroy(manifest);
 	freeAllImagesData(imagesDataList, *numOfImages, false);
 
+	spVal((*queryCache = spQueryCacheCreate(*config)) != NULL, ERROR_INIT_QUERY_CACHE,
+			IMAGE_DATA_LOGIC_ERROR_RETURN_VALUE);
+
 	spLoggerSafePrintInfo(INTERNAL_DATA_AND_LOGIC_CREATED);
 
 
@@ -133,31 +193,55 @@ int spMainInitialize(int argc, char** argv, SPConfig* config, int* numOfImages,
 /*
  * The method gets a pre-validated query for an image path, requests the data layer i.e. the KD data-structure
  * for the similar images and presents them.
+ * The descriptors of a query image are taken from the query cache if the image was queried recently,
+ * otherwise they are extracted (in tiles if the image is large, see getQueryImageFeatures) and cached.
+ * The query is bounded by the spQueryDeadline latency budget, which starts with the query: once it is
+ * spent the search stops, and the images are ranked by the features that were searched (the strongest
+ * features of the query image are searched first).
  * In case of a problem at presenting a specific image, a warning will be logged and a relevant message will
  * be shown, yet the process will keep running and try to present the next image.
  *
  * @param config - the configuration data
  * @param currentImageData - a pre-allocated image data to work with
  * @param imageProbObject - a pointer to the image proc object pointer
- * @param kdTree - the KD tree of the current images database
+ * @param searchIndex - the search index of the current images database
  * @param numOfImages - the number of images in the database
  * @param numOfSimilarImages - the number of similar images to present for each user query
- * @param bpq - a pre-allocated priority queue
+ * @param queryContext - a pre-allocated query context
+ * @param queryCache - the query cache
  * @param GUIFlag - a flag that indicates if the program runs at minimal gui mode
  *
  */
 void proccessQueryAndPresentImages(SPConfig config, SPImageData currentImageData, sp::ImageProc** imageProcObject,
-		SPKDTreeNode kdTree, int numOfImages, int numOfSimilarImages, SPBPQueue bpq, char* workingImagePath, bool GUIFlag){
+		SPSearchIndex searchIndex, int numOfImages, int numOfSimilarImages, SPQueryContext queryContext, SPQueryCache queryCache,
+		char* workingImagePath, bool GUIFlag){
 	int *similarImagesIndices = NULL, i;
 	char tempPath[MAX_PATH_LEN];
+	uint64_t deadline;
+	bool isTruncated = false;
 
 	spLoggerSafePrintInfo(QUERY_HAS_BEEN_INSERTED);
 	spLoggerSafePrintInfo(workingImagePath);
 
-	currentImageData->featuresArray = (*imageProcObject)->getImageFeatures(workingImagePath,0,&(currentImageData->numOfFeatures));
+	spInstrQueryBegin();
+	deadline = getQueryDeadline(config);
+	currentImageData->featuresArray = spQueryCacheGet(queryCache, workingImagePath, &(currentImageData->numOfFeatures));
+	if (currentImageData->featuresArray == NULL) {
+		currentImageData->featuresArray = (*imageProcObject)->getQueryImageFeatures(workingImagePath,&(currentImageData->numOfFeatures));
+		//a failure to cache is logged by the cache, the query goes on
+		if (currentImageData->featuresArray != NULL)
+			spQueryCacheInsert(queryCache, workingImagePath, currentImageData->featuresArray,
+					currentImageData->numOfFeatures);
+	}
+
+	similarImagesIndices = searchSimilarImages(currentImageData, searchIndex, numOfImages,
+			numOfSimilarImages, queryContext, deadline, &isTruncated);
+	//a failed query is part of the query statistics as well
+	spInstrQueryEnd();
+	spValNc(similarImagesIndices != NULL , FAIL_SEARCHING_IMAGES, ); //on error returns
 
-	spValNc((similarImagesIndices = searchSimilarImages(currentImageData, kdTree, numOfImages,
-			numOfSimilarImages, bpq)) != NULL , FAIL_SEARCHING_IMAGES, ); //on error returns
+	if (isTruncated)
+		printf(QUERY_TRUNCATED);
 
 	if (GUIFlag) {
 		spLoggerSafePrintDebug(DEBUG_IMAGES_PRESENTED_GUI,
@@ -177,25 +261,71 @@ void proccessQueryAndPresentImages(SPConfig config, SPImageData currentImageData
 	spFree(similarImagesIndices);
 }
 
+/*
+ * The method handles an index update query: "+" extracts the features of the next image of the images
+ * directory and adds them to the search index, "-<index>" removes the image of the given index from the
+ * search results. The index is updated in place, without rebuilding it. The update lasts for the current
+ * run only, the configuration file and the .feats files are not changed.
+ *
+ * @param config - the configuration data
+ * @param searchIndex - the search index of the current images database
+ * @param imageProbObject - a pointer to the image proc object pointer
+ * @param query - the update query
+ * @param isAddition - true for an addition query, false for a removal query
+ * @param imageIndex - the index of the image to remove, relevant only for a removal query
+ */
+void proccessIndexUpdate(SPConfig config, SPSearchIndex searchIndex, sp::ImageProc** imageProcObject,
+		char* query, bool isAddition, int imageIndex){
+	char tempPath[MAX_PATH_LEN];
+	SPPoint* features;
+	int numOfFeatures = 0;
+
+	spLoggerSafePrintInfo(INDEX_UPDATE_HAS_BEEN_INSERTED);
+	spLoggerSafePrintInfo(query);
+
+	if (!isAddition) {
+		if (spSearchIndexRemoveImage(searchIndex, imageIndex))
+			printf(IMAGE_REMOVED, imageIndex);
+		else
+			printf(IMAGE_NOT_REMOVED, imageIndex);
+		return;
+	}
+
+	if (!prepareImageAddition(config, searchIndex, tempPath, &imageIndex)) {
+		printf(IMAGE_NOT_ADDED, imageIndex);
+		return;
+	}
+	features = (*imageProcObject)->getImageFeatures(tempPath, imageIndex, &numOfFeatures);
+	if (addImageToSearchIndex(config, searchIndex, imageIndex, features, numOfFeatures))
+		printf(IMAGE_ADDED, imageIndex, tempPath);
+	else
+		printf(IMAGE_NOT_ADDED, imageIndex);
+}
+
 /*
  * The method is used for the user interaction process, it receives the relevant data that is loaded
  * and asks the user for image queries and handles them accordingly.
+ * Besides image paths, the user can add and remove database images (see proccessIndexUpdate).
  *
  *
  * @param config - the configuration data
  * @param currentImageData - a pre-allocated image data to work with
- * @param kdTree - the KD tree of the current images database
+ * @param searchIndex - the search index of the current images database
  * @param numOfImages - the number of images in the database
  * @param numOfSimilarImages - the number of similar images to present for each user query
- * @param bpq - a pre-allocated priority queue
+ * @param queryContext - a pre-allocated query context
+ * @param queryCache - the query cache
  * @param GUIFlag - a flag that indicates if the program runs at minimal gui mode
  * @param imageProbObject - a pointer to the image proc object pointer
  * @param oneImageWasSet - a pointer to a flag that indicates that one image query was loaded,
  * 							this is needed for memory deallocation.
  */
-void spMainStartUserInteraction(SPConfig config,SPImageData currentImageData, SPKDTreeNode kdTree,int numOfImages,
-		int numOfSimilarImages, SPBPQueue bpq, bool GUIFlag, sp::ImageProc** imageProcObject, bool* isCurrentImageFeaturesArrayAllocated){
+void spMainStartUserInteraction(SPConfig config,SPImageData currentImageData, SPSearchIndex searchIndex,int numOfImages,
+		int numOfSimilarImages, SPQueryContext queryContext, SPQueryCache queryCache, bool GUIFlag, sp::ImageProc** imageProcObject,
+		bool* isCurrentImageFeaturesArrayAllocated){
 	char workingImagePath[MAX_PATH_LEN];
+	bool isAddition;
+	int imageIndex;
 
 
 	// first run must always happen
@@ -206,7 +336,14 @@ void spMainStartUserInteraction(SPConfig config,SPImageData currentImageData, SP
 		resetImageData(currentImageData);
 		*isCurrentImageFeaturesArrayAllocated = false; //indicate we should not free currentImageData->features again
 
-		while (strcmp(workingImagePath, QUERY_EXIT_INPUT) && !verifyPathAndAvailableFile(workingImagePath)){
+		if (parseIndexUpdateQuery(workingImagePath, &isAddition, &imageIndex)) {
+			proccessIndexUpdate(config, searchIndex, imageProcObject, workingImagePath, isAddition, imageIndex);
+			getQuery(workingImagePath);
+			continue;
+		}
+
+		while (strcmp(workingImagePath, QUERY_EXIT_INPUT) && !verifyPathAndAvailableFile(workingImagePath) &&
+				!parseIndexUpdateQuery(workingImagePath, &isAddition, &imageIndex)){
 		spLoggerSafePrintInfo(ILLEGAL_QUERY_HAS_BEEN_INSERTED);
 			spLoggerSafePrintInfo(workingImagePath);
 
@@ -217,10 +354,13 @@ void spMainStartUserInteraction(SPConfig config,SPImageData currentImageData, SP
 		if (!strcmp(workingImagePath, QUERY_EXIT_INPUT)){ // query == '<>'
 			return;
 		}
+		if (parseIndexUpdateQuery(workingImagePath, &isAddition, &imageIndex)){ // handled by the next iteration
+			continue;
+		}
 
 		*isCurrentImageFeaturesArrayAllocated = true;
-		proccessQueryAndPresentImages(config, currentImageData, imageProcObject, kdTree, numOfImages,
-				numOfSimilarImages, bpq, workingImagePath, GUIFlag);
+		proccessQueryAndPresentImages(config, currentImageData, imageProcObject, searchIndex, numOfImages,
+				numOfSimilarImages, queryContext, queryCache, workingImagePath, GUIFlag);
 
 		getQuery(workingImagePath);
 	}
@@ -234,7 +374,8 @@ void spMainStartUserInteraction(SPConfig config,SPImageData currentImageData, SP
  *
  * All errors data that can, will be written to the log file
  *
- * specific settings file will be loaded using the parameter '-c'
+ * specific settings file will be loaded using the parameter '-c', and a last parameter '--update'
+ * extracts only the images that changed since the last extraction
  *
  * @param argc - the arguments count
  * @param argv - the main arguments
@@ -253,13 +394,14 @@ int main(int argc, char** argv) {
 	int numOfSimilarImages, numOfImages = 0;
 	SPImageData currentImageData = NULL;
 	bool extractFlag, GUIFlag, isCurrentImageFeaturesArrayAllocated = false;
-	SPKDTreeNode kdTree = NULL;
-	SPBPQueue bpq = NULL;
+	SPSearchIndex searchIndex = NULL;
+	SPQueryContext queryContext = NULL;
+	SPQueryCache queryCache = NULL;
 	sp::ImageProc* imageProcObject = NULL;
 
 	if ((flowFlag = spMainInitialize(argc, argv, &config, &numOfImages,
-			&numOfSimilarImages, &extractFlag, &GUIFlag, &bpq,
-			&currentImageData, &kdTree, &imageProcObject))
+			&numOfSimilarImages, &extractFlag, &GUIFlag, &queryContext,
+			&currentImageData, &searchIndex, &imageProcObject, &queryCache))
 			== INIT_CONFIG_OR_LOGGER_ERROR_RETURN_VALUE) {
 		spConfigDestroy(config);
 		return flowFlag;
@@ -269,8 +411,8 @@ int main(int argc, char** argv) {
 
 	spLoggerSafePrintInfo(INITIALIZATION_FINISHED_SUCCESSFUL);
 
-	spMainStartUserInteraction(config,currentImageData, kdTree,numOfImages, numOfSimilarImages,
-			bpq, GUIFlag, &imageProcObject, &isCurrentImageFeaturesArrayAllocated);
+	spMainStartUserInteraction(config,currentImageData, searchIndex,numOfImages, numOfSimilarImages,
+			queryContext, queryCache, GUIFlag, &imageProcObject, &isCurrentImageFeaturesArrayAllocated);
 
 	spLoggerSafePrintInfo(USER_INTERACTION_FINISHED_SUCCESSFULLY);
 	// end control flow
@@ -4,21 +4,40 @@
 #include <stdbool.h>
 
 #include "SPImageQuery.h"
-#include "../data_structures/kd_ds/SPKDTreeNodeKNN.h"
+#include "../data_structures/index_ds/SPSearchIndex.h"
 #include "../SPLogger.h"
 #include "../general_utils/SPUtils.h"
+#include "../general_utils/SPInstrumentation.h"
+
+#define FEATURES_BATCH_SIZE							64 // features searched together by the index
 
 #define ERROR_EMPTY_QUEUE 							"Queue is empty"
 #define ERROR_K_NEAREST_NEIGHBORS 					"Error in kNearestNeighbors func"
 #define ERROR_GET_SIMILAR_IMAGES_INDICES_TO_FEAURE 	"Error in getSimilarImagesIndicesToFeature func"
 #define ERROR_UPDATE_COUNTER_ARRAY_PER_FEATURE 		"Error in updateCounterArrayPerFeature func"
 #define ERROR_GENERATING_SIMILAR_IMAGES				"Error generating similar images"
+#define ERROR_CREATING_FEATURES_QUEUES				"Error creating the features queues"
+#define ERROR_CREATING_QUERY_CONTEXT				"Error creating the query context"
 
 #define WARNING_ZERO_IN_TOP_ITEMS_ARRAY				"Some image will appear in results even though \
 it did not have any feature which was one of the k nearest neighbors of any of the query image features"
 
 #define DEBUG_SIMILAR_IMAGES_ENDED 					"Similar images search process ended, selecting best images"
 #define DEBUG_SIMILAR_IMAGES_SEARCH_STARTED 		"Similar images search process started"
+#define DEBUG_SIMILAR_IMAGES_SEARCH_TRUNCATED		"Similar images search stopped at its deadline, ranking by the features searched so far"
+
+/*
+ * A structure used for the query context
+ * bpqs - FEATURES_BATCH_SIZE features queues of capacity knn, each feature of a batch is
+ * 		  searched with its own queue
+ * counterArraySize - the size of counterArray, at least the number of images of a query
+ * counterArray - the number of nearest features of each image
+ */
+struct sp_query_context_t {
+	SPBPQueue* bpqs;
+	int counterArraySize;
+	int* counterArray;
+};
 
 
 int* initializeCounterArray(int size) {
@@ -35,9 +54,7 @@ int* initializeCounterArray(int size) {
 
 SP_BPQUEUE_MSG popFromQueueToIndicesArray(SPBPQueue bpq, int* indicesArray,
 		int arrayIndex) {
-	SPListElement elem = spBPQueuePeek(bpq);
-	indicesArray[arrayIndex] = spListElementGetIndex(elem);
-	spListElementDestroy(elem);
+	indicesArray[arrayIndex] = spBPQueueMinIndex(bpq);
 	return spBPQueueDequeue(bpq);
 }
 
@@ -56,9 +73,9 @@ int* createSimImagesToFeatureIndicesArray(SPBPQueue bpq, int originalQueueSize)
 	return indicesArray;
 }
 
-int* getSimilarImagesIndicesToFeature(SPPoint relevantFeature, SPKDTreeNode kdTree,
+int* getSimilarImagesIndicesToFeature(SPPoint relevantFeature, SPSearchIndex searchIndex,
 		SPBPQueue bpq, int* finalQueueSize) {
-	spValRn(kNearestNeighbors(kdTree, bpq, relevantFeature), ERROR_K_NEAREST_NEIGHBORS);
+	spValRn(spSearchIndexKNN(searchIndex, bpq, relevantFeature), ERROR_K_NEAREST_NEIGHBORS);
 
 	*finalQueueSize = spBPQueueSize(bpq);
 
@@ -66,10 +83,10 @@ int* getSimilarImagesIndicesToFeature(SPPoint relevantFeature, SPKDTreeNode kdTr
 }
 
 bool updateCounterArrayPerFeature(int* counterArray, SPPoint relevantFeature,
-		SPKDTreeNode kdTree, SPBPQueue bpq) {
+		SPSearchIndex searchIndex, SPBPQueue bpq) {
 	int j, finalQueueSize, *similarImagesIndices;
 
-	spVal((similarImagesIndices = getSimilarImagesIndicesToFeature(relevantFeature, kdTree,
+	spVal((similarImagesIndices = getSimilarImagesIndicesToFeature(relevantFeature, searchIndex,
 			bpq, &finalQueueSize)), ERROR_GET_SIMILAR_IMAGES_INDICES_TO_FEAURE, false);
 
 	for (j = 0; j < finalQueueSize; j++)
@@ -81,6 +98,64 @@ bool updateCounterArrayPerFeature(int* counterArray, SPPoint relevantFeature,
 	return true;
 }
 
+/*
+ * Counts the neighbours in the first 'numOfQueues' queues of 'bpqs' per image, the
+ * queues are emptied in place, their nodes are reused by the next batch
+ */
+static void countFeaturesQueues(int* counterArray, SPBPQueue* bpqs, int numOfQueues) {
+	int i;
+	for (i = 0; i < numOfQueues; i++) {
+		while (!spBPQueueIsEmpty(bpqs[i])) {
+			counterArray[spBPQueueMinIndex(bpqs[i])]++;
+			spBPQueueDequeue(bpqs[i]);
+		}
+	}
+}
+
+bool updateCounterArrayPerFeaturesBatch(int* counterArray, SPPoint* features,
+		int numOfFeatures, SPSearchIndex searchIndex, SPBPQueue* bpqs) {
+	spVal(spSearchIndexKNNBatch(searchIndex, bpqs, features, numOfFeatures),
+			ERROR_K_NEAREST_NEIGHBORS, false);
+
+	countFeaturesQueues(counterArray, bpqs, numOfFeatures);
+	return true;
+}
+
+bool updateCounterArrayPerFeaturesBatchWithDeadline(int* counterArray, SPPoint* features,
+		int numOfFeatures, SPSearchIndex searchIndex, SPBPQueue* bpqs, uint64_t deadline,
+		bool* isExpired) {
+	int numOfSearched;
+
+	spVal(spSearchIndexKNNBatchWithDeadline(searchIndex, bpqs, features, numOfFeatures,
+			deadline, &numOfSearched, isExpired), ERROR_K_NEAREST_NEIGHBORS, false);
+
+	countFeaturesQueues(counterArray, bpqs, numOfSearched);
+	return true;
+}
+
+void destroyFeaturesQueues(SPBPQueue* bpqs, int numOfQueues) {
+	int i;
+	if (bpqs == NULL)
+		return;
+	for (i = 0; i < numOfQueues; i++)
+		spBPQueueDestroy(bpqs[i]);
+	free(bpqs);
+}
+
+SPBPQueue* createFeaturesQueues(SPBPQueue bpq, int numOfQueues) {
+	int i;
+	SPBPQueue* bpqs;
+
+	spCalloc(bpqs, SPBPQueue, numOfQueues);
+
+	for (i = 0; i < numOfQueues; i++) {
+		spValWcRn((bpqs[i] = spBPQueueCopy(bpq)), ERROR_CREATING_FEATURES_QUEUES,
+				destroyFeaturesQueues(bpqs, i));
+	}
+
+	return bpqs;
+}
+
 int* getTopItems(int* counterArray, int counterArraySize, int retArraySize) {
 	int i, j, tempMaxIndex, *topItems;
 
@@ -108,31 +183,152 @@ int* getTopItems(int* counterArray, int counterArraySize, int retArraySize) {
 	return topItems;
 }
 
-int* getSimilarImages(SPImageData workingImage, SPKDTreeNode kdTree, int numOfImages,
+void destroyQueryContext(SPQueryContext context) {
+	if (context == NULL)
+		return;
+	destroyFeaturesQueues(context->bpqs, FEATURES_BATCH_SIZE);
+	spFree(context->counterArray);
+	free(context);
+}
+
+SPQueryContext createQueryContext(int knn, int numOfImages) {
+	SPQueryContext context;
+	SPBPQueue bpq;
+	spVerifyArguments(knn > 0 && numOfImages > 0, ERROR_CREATING_QUERY_CONTEXT, NULL);
+
+	spCalloc(context, struct sp_query_context_t, 1);
+	context->counterArraySize = numOfImages;
+	spValWcRn((context->counterArray = initializeCounterArray(numOfImages)),
+			ERROR_CREATING_QUERY_CONTEXT, destroyQueryContext(context));
+	spValWcRn((bpq = spBPQueueCreate(knn)), ERROR_CREATING_QUERY_CONTEXT,
+			destroyQueryContext(context));
+	context->bpqs = createFeaturesQueues(bpq, FEATURES_BATCH_SIZE);
+	spBPQueueDestroy(bpq);
+	spValWcRn(context->bpqs, ERROR_CREATING_QUERY_CONTEXT, destroyQueryContext(context));
+
+	return context;
+}
+
+/*
+ * Sets the first 'numOfImages' cells of the context counter array to 0, the array is
+ * reallocated if it is too small
+ *
+ * @returns false in case of memory allocation failure, true otherwise
+ */
+static bool resetCounterArray(SPQueryContext context, int numOfImages) {
+	int i, *counterArray;
+
+	if (numOfImages > context->counterArraySize) {
+		spVal((counterArray = initializeCounterArray(numOfImages)),
+				ERROR_ALLOCATING_MEMORY, false);
+		free(context->counterArray);
+		context->counterArray = counterArray;
+		context->counterArraySize = numOfImages;
+		return true;
+	}
+
+	for (i = 0; i < numOfImages; i++)
+		context->counterArray[i] = 0;
+	return true;
+}
+
+/*
+ * Empties the context features queues, a failed search may leave features in them
+ */
+static void clearFeaturesQueues(SPQueryContext context) {
+	int i;
+	for (i = 0; i < FEATURES_BATCH_SIZE; i++)
+		spBPQueueClear(context->bpqs[i]);
+}
+
+int* getSimilarImages(SPImageData workingImage, SPSearchIndex searchIndex, int numOfImages,
 		int numOfSimilarImages, SPBPQueue bpq) {
-	int i, *topItems, *counterArray;
-	spVerifyArguments(workingImage != NULL && kdTree != NULL && bpq != NULL,
+	int* topItems;
+	SPQueryContext context;
+	spVerifyArguments(workingImage != NULL && searchIndex != NULL && bpq != NULL,
 			ERROR_GENERATING_SIMILAR_IMAGES, NULL);
 
-	// create an index-counter array for the images
-	spValRn((counterArray = initializeCounterArray(numOfImages)),
+	spValRn((context = createQueryContext(spBPQueueGetMaxSize(bpq), numOfImages)),
 			ERROR_GENERATING_SIMILAR_IMAGES);
 
+	topItems = getSimilarImagesInContext(context, workingImage, searchIndex, numOfImages,
+			numOfSimilarImages);
+
+	destroyQueryContext(context);
+	return topItems;
+}
+
+int* getSimilarImagesInContext(SPQueryContext context, SPImageData workingImage,
+		SPSearchIndex searchIndex, int numOfImages, int numOfSimilarImages) {
+	return getSimilarImagesWithDeadline(context, workingImage, searchIndex, numOfImages,
+			numOfSimilarImages, SP_SEARCH_INDEX_NO_DEADLINE, NULL);
+}
+
+int* getSimilarImagesWithDeadline(SPQueryContext context, SPImageData workingImage,
+		SPSearchIndex searchIndex, int numOfImages, int numOfSimilarImages,
+		uint64_t deadline, bool* isTruncated) {
+	int i, batchSize, numOfIndexedImages, *topItems;
+	bool isExpired = false;
+	spVerifyArguments(context != NULL && workingImage != NULL && searchIndex != NULL,
+			ERROR_GENERATING_SIMILAR_IMAGES, NULL);
+
+	if (isTruncated != NULL)
+		*isTruncated = false;
+
 	spLoggerSafePrintDebug(DEBUG_SIMILAR_IMAGES_SEARCH_STARTED, __FILE__, __FUNCTION__,
 			__LINE__);
+	spInstrTimerStart(searchTimer);
+
+	// an image level index ranks the images itself, one vocabulary lookup per feature
+	if (spSearchIndexIsImageLevel(searchIndex)) {
+		topItems = spSearchIndexSimilarImages(searchIndex, workingImage->featuresArray,
+				workingImage->numOfFeatures, numOfSimilarImages);
+		spInstrTimerStop(searchTimer, SP_INSTR_KNN_SEARCH);
+		spValRn(topItems, ERROR_GENERATING_SIMILAR_IMAGES);
+		spLoggerSafePrintDebug(DEBUG_SIMILAR_IMAGES_ENDED, __FILE__, __FUNCTION__, __LINE__);
+		return topItems;
+	}
 
-	for (i = 0; i < workingImage->numOfFeatures; i++) {
-		spValWcRn((updateCounterArrayPerFeature(counterArray,
-				(workingImage->featuresArray)[i], kdTree, bpq)),
-				ERROR_UPDATE_COUNTER_ARRAY_PER_FEATURE, free(counterArray));
+	// images may have been added to the index since it was built
+	numOfIndexedImages = spSearchIndexGetNumOfImages(searchIndex);
+	if (numOfIndexedImages > numOfImages)
+		numOfImages = numOfIndexedImages;
+
+	spValWcRn(resetCounterArray(context, numOfImages), ERROR_GENERATING_SIMILAR_IMAGES,
+			spInstrTimerStop(searchTimer, SP_INSTR_KNN_SEARCH));
+
+	// the features are searched in batches, each feature with its own queue, in their
+	// order (the strongest first) until the deadline
+	for (i = 0; i < workingImage->numOfFeatures && !isExpired; i += batchSize) {
+		batchSize = workingImage->numOfFeatures - i < FEATURES_BATCH_SIZE ?
+				workingImage->numOfFeatures - i : FEATURES_BATCH_SIZE;
+		spValWcRn((updateCounterArrayPerFeaturesBatchWithDeadline(context->counterArray,
+				workingImage->featuresArray + i, batchSize, searchIndex, context->bpqs,
+				deadline, &isExpired)),
+				ERROR_UPDATE_COUNTER_ARRAY_PER_FEATURE, clearFeaturesQueues(context);
+				spInstrTimerStop(searchTimer, SP_INSTR_KNN_SEARCH));
+	}
+	spInstrTimerStop(searchTimer, SP_INSTR_KNN_SEARCH);
+
+	if (isExpired) {
+		spInstrCount(SP_INSTR_TRUNCATED_QUERIES);
+		spLoggerSafePrintDebug(DEBUG_SIMILAR_IMAGES_SEARCH_TRUNCATED, __FILE__, __FUNCTION__,
+				__LINE__);
+		if (isTruncated != NULL)
+			*isTruncated = true;
 	}
 
-	spLoggerSafePrintDebug(DEBUG_SIMILAR_IMAGES_ENDED, __FILE__, __FUNCTION__, __LINE__);
+	// removed images are ranked after all the others
+	for (i = 0; i < numOfImages; i++) {
+		if (spSearchIndexIsImageRemoved(searchIndex, i))
+			context->counterArray[i] = -1;
+	}
 
-	topItems = getTopItems(counterArray, numOfImages, numOfSimilarImages);
+	spInstrTimerStart(rankingTimer);
+	topItems = getTopItems(context->counterArray, numOfImages, numOfSimilarImages);
+	spInstrTimerStop(rankingTimer, SP_INSTR_RANKING);
 
-	// if we get here counterArray is valid
-	free(counterArray);
+	spLoggerSafePrintDebug(DEBUG_SIMILAR_IMAGES_ENDED, __FILE__, __FUNCTION__, __LINE__);
 
 	return topItems;
 }
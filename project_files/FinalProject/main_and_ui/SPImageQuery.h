@@ -3,7 +3,39 @@
 
 #include "../image_parsing/SPImagesParser.h"
 #include "../data_structures/bpqueue_ds/SPBPriorityQueue.h"
-#include "../data_structures/kd_ds/SPKDTreeNode.h"
+#include "../data_structures/index_ds/SPSearchIndex.h"
+
+/**
+ * A query context holds the working memory of a similar images search: the features
+ * queues and the images counter array. The search index is only read by a search, so
+ * threads that search the same index at the same time, each with its own context, do not
+ * share any mutable state and need no locks (a sharded index serializes its own socket
+ * exchanges). A context is reused by the queries of its thread.
+ */
+
+/** Type for defining the query context **/
+typedef struct sp_query_context_t* SPQueryContext;
+
+/*
+ * Allocates a query context for searches of the 'knn' nearest features of each query
+ * feature in an index of 'numOfImages' images (the counter array grows if images are
+ * added to the index later)
+ *
+ * @param knn - the number of nearest features of each query feature, at least 1
+ * @param numOfImages - the number of images, at least 1
+ *
+ * @returns NULL in case of invalid arguments or memory allocation failure, otherwise the
+ * new context
+ *
+ * @logger - in case of any type of failure the relevant error is logged to the logger
+ */
+SPQueryContext createQueryContext(int knn, int numOfImages);
+
+/*
+ * Frees all the memory of the given query context.
+ * If context is NULL nothing happens.
+ */
+void destroyQueryContext(SPQueryContext context);
 
 /*
  * Allocates a counterArray of size 'size' and initialize each cell in it to 0
@@ -58,11 +90,11 @@ int* createSimImagesToFeatureIndicesArray(SPBPQueue bpq, int originalQueueSize);
  * to the given feature 'relevantFeature', creates an integer array containing them and
  * eventually returns it.
  *
- * pre assumptions - relevantFeature, kdTree and bpq are valid,
+ * pre assumptions - relevantFeature, searchIndex and bpq are valid,
  * 					 finalQueueSize is a valid pointer
  *
- * @param relevantFeature - the feature we compare the elements in 'kdTree' to
- * @param kdTree - a KDTree instance representing the KDTree created from all the features
+ * @param relevantFeature - the feature we compare the elements in 'searchIndex' to
+ * @param searchIndex - the search index created from all the features
  * of all the images whose paths were given in the configuration file
  * @param bpq - a priority queue used to store the nearest features to the given feature
  * 'relevantFeature'
@@ -74,17 +106,17 @@ int* createSimImagesToFeatureIndicesArray(SPBPQueue bpq, int originalQueueSize);
  *
  * @logger - in case of any type of failure the relevant error is logged to the logger
  */
-int* getSimilarImagesIndicesToFeature(SPPoint relevantFeature, SPKDTreeNode kdTree,
+int* getSimilarImagesIndicesToFeature(SPPoint relevantFeature, SPSearchIndex searchIndex,
 		SPBPQueue bpq, int* finalQueueSize);
 
 /*
  * Updates 'counterArray' according to the indices of the images containing the features
  * that are the most similar to the given feature 'relevantFeature'.
  *
- * pre assumptions - counterArray, relevantFeature, kdTree and bpq are valid
+ * pre assumptions - counterArray, relevantFeature, searchIndex and bpq are valid
  *
- * @param relevantFeature - the feature we compare the elements in 'kdTree' to
- * @param kdTree - a KDTree instance representing the KDTree created from all the features
+ * @param relevantFeature - the feature we compare the elements in 'searchIndex' to
+ * @param searchIndex - the search index created from all the features
  * of all the images whose paths were given in the configuration file
  * @param bpq - a priority queue used to store the nearest features to the given feature
  * 'relevantFeature'
@@ -95,7 +127,75 @@ int* getSimilarImagesIndicesToFeature(SPPoint relevantFeature, SPKDTreeNode kdTr
  * @logger - in case of any type of failure the relevant error is logged to the logger
  */
 bool updateCounterArrayPerFeature(int* counterArray, SPPoint relevantFeature,
-		SPKDTreeNode kdTree, SPBPQueue bpq);
+		SPSearchIndex searchIndex, SPBPQueue bpq);
+
+/*
+ * Updates 'counterArray' according to the indices of the images containing the features
+ * that are the most similar to each of the given features, all of them searched in a
+ * single call to the search index.
+ *
+ * pre assumptions - counterArray, features, searchIndex and bpqs are valid,
+ * 					 the queues are empty
+ *
+ * @param counterArray - the counter array to update
+ * @param features - the features we compare the elements in 'searchIndex' to
+ * @param numOfFeatures - the size of 'features'
+ * @param searchIndex - the search index created from all the features
+ * of all the images whose paths were given in the configuration file
+ * @param bpqs - 'numOfFeatures' priority queues, bpqs[i] is used to store the nearest
+ * features to features[i], they are emptied before the function returns
+ *
+ * @returns false in case of failure in one of the internal function, otherwise true
+ *
+ * @logger - in case of any type of failure the relevant error is logged to the logger
+ */
+bool updateCounterArrayPerFeaturesBatch(int* counterArray, SPPoint* features,
+		int numOfFeatures, SPSearchIndex searchIndex, SPBPQueue* bpqs);
+
+/*
+ * Same as updateCounterArrayPerFeaturesBatch, except that the features are searched in
+ * their order until the given deadline (see spSearchIndexKNNBatchWithDeadline), and only
+ * the neighbours of the features that were searched are counted.
+ *
+ * pre assumptions - counterArray, features, searchIndex, bpqs and isExpired are valid,
+ * 					 the queues are empty
+ *
+ * @param counterArray - the counter array to update
+ * @param features - the features we compare the elements in 'searchIndex' to
+ * @param numOfFeatures - the size of 'features'
+ * @param searchIndex - the search index created from all the features
+ * of all the images whose paths were given in the configuration file
+ * @param bpqs - 'numOfFeatures' priority queues, they are emptied before the function
+ * returns
+ * @param deadline - the spInstrumentationNow time to stop at, SP_SEARCH_INDEX_NO_DEADLINE
+ * if none
+ * @param isExpired - set to true iff the search was stopped by the deadline
+ *
+ * @returns false in case of failure in one of the internal function, otherwise true
+ *
+ * @logger - in case of any type of failure the relevant error is logged to the logger
+ */
+bool updateCounterArrayPerFeaturesBatchWithDeadline(int* counterArray, SPPoint* features,
+		int numOfFeatures, SPSearchIndex searchIndex, SPBPQueue* bpqs, uint64_t deadline,
+		bool* isExpired);
+
+/*
+ * Allocates an array of 'numOfQueues' empty copies of the given priority queue 'bpq'
+ *
+ * @param bpq - the queue to copy, its capacity is the capacity of the copies
+ * @param numOfQueues - the size of the returned array
+ *
+ * @returns NULL in case of memory allocation failure, otherwise the queues array
+ *
+ * @logger - in case of any type of failure the relevant error is logged to the logger
+ */
+SPBPQueue* createFeaturesQueues(SPBPQueue bpq, int numOfQueues);
+
+/*
+ * Frees the first 'numOfQueues' queues of 'bpqs' and the array itself.
+ * If bpqs is NULL nothing happens.
+ */
+void destroyFeaturesQueues(SPBPQueue* bpqs, int numOfQueues);
 
 /*
  * Returns an integer array of size 'retArraySize' containing the indices of 'counterArray'
@@ -118,16 +218,21 @@ int* getTopItems(int* counterArray, int counterArraySize, int retArraySize);
  * Returns an integer array of size 'numOfSimilarImages' containing the indices of
  * the images that contained the most features that were the most similar to the features
  * of the given image 'workingImage'
+ * If 'searchIndex' is an image level index (bag of visual words) the images are ranked
+ * by the index itself and 'bpq' is not used.
+ * Images added to the index since it was built are ranked as well, and removed images
+ * are ranked after all the others.
  *
  * @param workingImage - the SPImageData instance containing the features of the given
  * image
- * @param kdTree - a KDTree instance representing the KDTree created from all the features
+ * @param searchIndex - the search index created from all the features
  * of all the images whose paths were given in the configuration file
  * @param numOfImages - the number of images whose paths were given in the configuration
  * file
  * @param numOfSimilarImages - the size of the returned array
- * @param bpq - a priority queue used to store the nearest features to each feature of the
- * working image
+ * @param bpq - a priority queue, its capacity is the number of nearest features to each
+ * feature of the working image (they are stored in queues of the query context that is
+ * allocated for this query)
  *
  * @returns NULL in case of failure in an internal function, otherwise returns the desired
  * array
@@ -135,8 +240,63 @@ int* getTopItems(int* counterArray, int counterArraySize, int retArraySize);
  * @logger - in case of any type of failure the relevant error is logged to the logger
  * debug prints are also printed to the logger
  */
-int* getSimilarImages(SPImageData workingImage, SPKDTreeNode kdTree, int numOfImages,
+int* getSimilarImages(SPImageData workingImage, SPSearchIndex searchIndex, int numOfImages,
 		int numOfSimilarImages, SPBPQueue bpq);
 
+/*
+ * Same as getSimilarImages, except that the working memory of the search is the one of
+ * the given query context instead of memory allocated for a single query.
+ * The function may be called by several threads with the same search index at the same
+ * time, as long as each thread uses its own context and the index is not updated.
+ *
+ * @param context - the query context of the calling thread
+ * @param workingImage - the SPImageData instance containing the features of the given
+ * image
+ * @param searchIndex - the search index created from all the features
+ * of all the images whose paths were given in the configuration file
+ * @param numOfImages - the number of images whose paths were given in the configuration
+ * file
+ * @param numOfSimilarImages - the size of the returned array
+ *
+ * @returns NULL in case of failure in an internal function, otherwise returns the desired
+ * array
+ *
+ * @logger - in case of any type of failure the relevant error is logged to the logger
+ * debug prints are also printed to the logger
+ */
+int* getSimilarImagesInContext(SPQueryContext context, SPImageData workingImage,
+		SPSearchIndex searchIndex, int numOfImages, int numOfSimilarImages);
+
+/*
+ * Same as getSimilarImagesInContext, except that the search stops at the given deadline
+ * and the images are ranked by the features that were searched until then. The features
+ * are searched in their order, so the query features should be ordered by importance
+ * (the query images features are ordered by descending keypoint response). The ranking
+ * of a search that is stopped is the best one of the searched features, and it has
+ * 'numOfSimilarImages' images as any other ranking.
+ * An image level index ranks the images in a single step, which is not stopped.
+ *
+ * @param context - the query context of the calling thread
+ * @param workingImage - the SPImageData instance containing the features of the given
+ * image
+ * @param searchIndex - the search index created from all the features
+ * of all the images whose paths were given in the configuration file
+ * @param numOfImages - the number of images whose paths were given in the configuration
+ * file
+ * @param numOfSimilarImages - the size of the returned array
+ * @param deadline - the spInstrumentationNow time to stop at, SP_SEARCH_INDEX_NO_DEADLINE
+ * if none
+ * @param isTruncated - if not NULL, set to true iff the search was stopped by the deadline
+ *
+ * @returns NULL in case of failure in an internal function, otherwise returns the desired
+ * array
+ *
+ * @logger - in case of any type of failure the relevant error is logged to the logger
+ * debug prints are also printed to the logger
+ */
+int* getSimilarImagesWithDeadline(SPQueryContext context, SPImageData workingImage,
+		SPSearchIndex searchIndex, int numOfImages, int numOfSimilarImages,
+		uint64_t deadline, bool* isTruncated);
+
 
 #endif /* SPIMAGEQUERY_H_ */
@@ -2,26 +2,31 @@
 #include <stdlib.h>
 #include <string.h>
 #include <assert.h>
+#include <ctype.h>
+#include <limits.h>
 
 #include "SPMainAux.h"
 #include "SPImageQuery.h"
 #include "../SPLogger.h"
-#include "../data_structures/kd_ds/SPKDTreeNode.h"
+#include "../data_structures/index_ds/SPSearchIndex.h"
 #include "../data_structures/bpqueue_ds/SPBPriorityQueue.h"
 #include "../general_utils/SPUtils.h"
+#include "../general_utils/SPInstrumentation.h"
 
 
 #define DEFAULT_CONFIG_FILE										"spcbir.config"
 #define CANNOT_OPEN_MSG 										"The configuration file %s couldn't be open\n"
 #define ENTER_A_QUERY_IMAGE_OR_TO_TERMINATE 					"Please enter image path:\n"
-#define INVALID_CMD_LINE										"Invalid command line : use -c <config_filename>\n"
+#define INVALID_CMD_LINE										"Invalid command line : use -c <config_filename> [--update]\n"
 #define STDOUT													"stdout"
 #define CLOSEST_IMAGES 											"Best candidates for - %s - are:\n"
 #define EXITING 												"Exiting...\n"
 #define QUERY_IMAGE_DEFAULT_INDEX 								0
 #define QUERY_STRING_ERROR 										"Query is not in the correct format, or file is not available\n"
 #define CONFIG_FILE_PATH_ARG									"-c"
+#define UPDATE_ARG												"--update"
 #define READ_FILE_MODE											"r"
+#define NSEC_PER_MSEC											1000000ULL
 
 #define WARNING_CONFIG_ARG										"Warning, program is running with unknown arguments, did you mean -c ?\n"
 #define WARNING_ZERO_FEATURES_FROM_IMAGE						"Warning, some images have zero features"
@@ -45,9 +50,10 @@
 #define ERROR_PARSING_IMAGES_DATA 								"Failed at images parsing process"
 #define ERROR_INITIALIZING_QUERY_IMAGE 							"Failed to initialize query image item"
 #define ERROR_CREATING_FEATURES_ARRAY 							"Failed to create features array"
-#define ERROR_CREATING_KD_TREE 									"Failed to create the KD-tree"
-#define ERROR_INITIALIZING_BP_QUEUE 							"Failed to initialize priority queue"
+#define ERROR_CREATING_SEARCH_INDEX 							"Failed to create the search index"
+#define ERROR_INITIALIZING_QUERY_CONTEXT 						"Failed to initialize query context"
 #define ERROR_AT_IMAGES_COUNTS									"Error at verifying images counts numbers limits (from settings)"
+#define ERROR_ADDING_IMAGE_TO_SEARCH_INDEX						"Failed to add the image to the search index"
 
 #define MAIN_RETURNED_ERROR										"An error has been encountered, please check the log file for more information.\n"
 
@@ -56,15 +62,21 @@
 #define DEBUG_WORKING_IMAGE_INITIALIZED 						"Working image initialized successfully"
 #define DEBUG_NUMBER_OF_FEATURES_CALCULATED						"Total number of features calculated"
 #define DEBUG_FEATURES_ARRAY_INITIALIZED						"Features array initialized"
-#define DEBUG_KD_TREE_INITIALIZED  								"KD Tree initialized"
-#define DEBUG_PRIORITY_QUEUE_INITIALIZED						"Priority Queue initialized"
+#define DEBUG_SEARCH_INDEX_INITIALIZED  						"Search index initialized"
+#define DEBUG_QUERY_CONTEXT_INITIALIZED							"Query context initialized"
 #define DEBUG_PCA_PATH_IS_VERIFIED 								"PCA path is verified"
 #define DEBUG_IMAGE_FILE_IS_VERIFIED_AT_INDEX 					"Image file is verified at index - "
 #define DEBUG_IMAGE_FEAT_FILE_IS_VERIFIED_AT_INDEX				"Image .feats file is verified at index - "
 #define DEBUG_LOGGER_HAS_BEEN_CREATED  							"Logger has been created"
 #define DEBUG_RELEVANT_SETTINGS_DATA_LOADED						"Relevant settings data loaded"
+#define DEBUG_UPDATE_MODE										"Update run, only the changed images are extracted"
 
-char* getConfigFilename(int argc, char** argv) {
+#define DECIMAL_BASE											10
+
+char* getConfigFilename(int argc, char** argv, bool* updateFlag) {
+	*updateFlag = argc > 1 && !strcmp(argv[argc - 1], UPDATE_ARG);
+	if (*updateFlag)
+		argc--;
 	if (argc == 1)
 		return DEFAULT_CONFIG_FILE;
 	if (argc == 3) {
@@ -80,7 +92,9 @@ char* getConfigFilename(int argc, char** argv) {
 
 SPConfig getConfigFromFile(const char* configFilename, SP_CONFIG_MSG* msg) {
 	SPConfig config;
+	spInstrTimerStart(configTimer);
 	config = spConfigCreate(configFilename, msg);
+	spInstrTimerStop(configTimer, SP_INSTR_CONFIG_LOAD);
 	if (*msg == SP_CONFIG_CANNOT_OPEN_FILE)
 		printf(CANNOT_OPEN_MSG, configFilename);
 	return config;
@@ -107,16 +121,20 @@ void getAsString(const char* message, char* destination) {
 }
 
 void endControlFlow(SPConfig config, SPImageData image,
-		bool isCurrentImageFeaturesArrayAllocated, SPKDTreeNode kdTree, SPBPQueue bpq,
-		int returnValue) {
+		bool isCurrentImageFeaturesArrayAllocated, SPSearchIndex searchIndex,
+		SPQueryContext queryContext, SPQueryCache queryCache, int returnValue) {
+	SP_CONFIG_MSG configMsg = SP_CONFIG_SUCCESS;
 	if (returnValue < 0) {
 		printf(MAIN_RETURNED_ERROR);
 	}
 	printf("%s", EXITING);
+	if (config != NULL && spConfigGetInstrumentationFilename(config, &configMsg) != NULL)
+		spInstrDump(spConfigGetInstrumentationFilename(config, &configMsg));
+	spQueryCacheDestroy(queryCache); // uses the configuration
 	spConfigDestroy(config);
 	freeImageData(image, !isCurrentImageFeaturesArrayAllocated, true);
-	spKDTreeDestroy(kdTree, true);
-	spBPQueueDestroy(bpq);
+	spSearchIndexDestroy(searchIndex);
+	destroyQueryContext(queryContext);
 	spLoggerDestroy();
 }
 
@@ -169,14 +187,25 @@ SPPoint* initializeAllFeaturesArray(SPImageData* workingImagesDatabase, int numO
 	return featuresArray;
 }
 
-int* searchSimilarImages(SPImageData workingImage, SPKDTreeNode kdTree, int numOfImages,
-		int numOfSimilarImages, SPBPQueue bpq) {
-	return getSimilarImages(workingImage, kdTree, numOfImages, numOfSimilarImages, bpq);
+int* searchSimilarImages(SPImageData workingImage, SPSearchIndex searchIndex, int numOfImages,
+		int numOfSimilarImages, SPQueryContext queryContext, uint64_t deadline,
+		bool* isTruncated) {
+	return getSimilarImagesWithDeadline(queryContext, workingImage, searchIndex, numOfImages,
+			numOfSimilarImages, deadline, isTruncated);
+}
+
+uint64_t getQueryDeadline(const SPConfig config) {
+	SP_CONFIG_MSG msg = SP_CONFIG_SUCCESS;
+	int budget = spConfigGetQueryDeadline(config, &msg);
+	if (msg != SP_CONFIG_SUCCESS || budget <= 0)
+		return SP_SEARCH_INDEX_NO_DEADLINE;
+	return spInstrumentationNow() + (uint64_t) budget * NSEC_PER_MSEC;
 }
 
 SP_CONFIG_MSG loadRelevantSettingsData(const SPConfig config, int* numOfImages,
 		int* numOfSimilar, bool* extractFlag, bool* GUIFlag) {
 	SP_CONFIG_MSG rslt = SP_CONFIG_SUCCESS;
+	SP_POINT_PRECISION precision;
 	assert(config != NULL);
 
 	*numOfImages = spConfigGetNumOfImages(config, &rslt);
@@ -191,6 +220,11 @@ SP_CONFIG_MSG loadRelevantSettingsData(const SPConfig config, int* numOfImages,
 	*GUIFlag = spConfigMinimalGui(config, &rslt);
 	spVal(rslt == SP_CONFIG_SUCCESS, ERROR_READING_SETTINGS, rslt);
 
+	// all the descriptors (database and query) are stored at the configured precision
+	precision = spConfigGetDescriptorPrecision(config, &rslt);
+	spVal(rslt == SP_CONFIG_SUCCESS, ERROR_READING_SETTINGS, rslt);
+	spPointSetDefaultPrecision(precision);
+
 	return rslt;
 }
 
@@ -217,15 +251,15 @@ SPImageData initializeWorkingImage() {
 	return workingImage;
 }
 
-bool initializeWorkingImageKDTreeAndBPQueue(const SPConfig config,
-		SPImageData* imagesDataList, SPImageData* currentImageData, SPKDTreeNode* kdTree,
-		SPBPQueue* bpq, int numOfImages) {
+bool initializeWorkingImageKDTreeAndQueryContext(const SPConfig config,
+		SPImageData* imagesDataList, SPFeatsWriter featsWriter, SPImageData* currentImageData,
+		SPSearchIndex* searchIndex, SPQueryContext* queryContext, int numOfImages) {
 	SP_CONFIG_MSG configMessage = SP_CONFIG_SUCCESS;
 	int totalNumOfFeatures, knn;
 	SPPoint* allFeaturesArray;
-	SP_KDTREE_SPLIT_METHOD splitMethod;
 
-	spVal(spImagesParserStartParsingProcess(config, imagesDataList) == SP_DP_SUCCESS,
+	spVal(spImagesParserStartParsingProcess(config, imagesDataList, featsWriter) ==
+			SP_DP_SUCCESS,
 			ERROR_PARSING_IMAGES_DATA, false);
 
 	spLoggerSafePrintDebug(DEBUG_IMAGES_PARSER_FINISHED, __FILE__, __FUNCTION__, __LINE__);
@@ -247,14 +281,12 @@ bool initializeWorkingImageKDTreeAndBPQueue(const SPConfig config,
 	spLoggerSafePrintDebug(DEBUG_FEATURES_ARRAY_INITIALIZED, __FILE__, __FUNCTION__,
 			__LINE__);
 
-	splitMethod = spConfigGetSplitMethod(config, &configMessage);
-	spValWc(configMessage == SP_CONFIG_SUCCESS, ERROR_READING_SETTINGS,
-			free(allFeaturesArray), false);
-
-	spValWc((*kdTree = InitKDTreeFromPoints(allFeaturesArray, totalNumOfFeatures,
-			splitMethod)), ERROR_CREATING_KD_TREE, free(allFeaturesArray), false);
+	spInstrTimerStart(buildTimer);
+	spValWc((*searchIndex = spSearchIndexCreate(config, allFeaturesArray,
+			totalNumOfFeatures)), ERROR_CREATING_SEARCH_INDEX, free(allFeaturesArray), false);
+	spInstrTimerStop(buildTimer, SP_INSTR_INDEX_BUILD);
 
-	spLoggerSafePrintDebug(DEBUG_KD_TREE_INITIALIZED, __FILE__, __FUNCTION__, __LINE__);
+	spLoggerSafePrintDebug(DEBUG_SEARCH_INDEX_INITIALIZED, __FILE__, __FUNCTION__, __LINE__);
 
 	free(allFeaturesArray);
 
@@ -262,9 +294,10 @@ bool initializeWorkingImageKDTreeAndBPQueue(const SPConfig config,
 
 	spVal(configMessage == SP_CONFIG_SUCCESS, ERROR_READING_SETTINGS, false);
 
-	spVal((*bpq = spBPQueueCreate(knn)), ERROR_INITIALIZING_BP_QUEUE, false);
+	spVal((*queryContext = createQueryContext(knn, numOfImages)),
+			ERROR_INITIALIZING_QUERY_CONTEXT, false);
 
-	spLoggerSafePrintDebug(DEBUG_PRIORITY_QUEUE_INITIALIZED, __FILE__, __FUNCTION__,
+	spLoggerSafePrintDebug(DEBUG_QUERY_CONTEXT_INITIALIZED, __FILE__, __FUNCTION__,
 			__LINE__);
 
 	return true;
@@ -326,13 +359,13 @@ bool verifyImagesNumbersLimits(SPConfig config, int numOfImages, int* numOfSimil
 }
 
 
-bool initConfigAndLogger(int argc, char** argv, SPConfig* config) {
+bool initConfigAndLogger(int argc, char** argv, SPConfig* config, bool* updateFlag) {
 	char *configFilename, *loggerFilename;
 	SP_CONFIG_MSG configMsg = SP_CONFIG_SUCCESS;
 	SP_LOGGER_LEVEL loggerLevel;
 	SP_LOGGER_MSG loggerMsg;
 
-	if (!(configFilename = getConfigFilename(argc, argv))) {
+	if (!(configFilename = getConfigFilename(argc, argv, updateFlag))) {
 		printf(INVALID_CMD_LINE);
 		return false;
 	}
@@ -356,8 +389,12 @@ bool initConfigAndLogger(int argc, char** argv, SPConfig* config) {
 		return false;
 	}
 
-	loggerMsg = spLoggerCreate(!strcmp(loggerFilename, STDOUT) ? NULL : loggerFilename,
-			loggerLevel);
+	if (spConfigIsLoggerAsync(*config, &configMsg))
+		loggerMsg = spLoggerCreateAsync(!strcmp(loggerFilename, STDOUT) ? NULL :
+				loggerFilename, loggerLevel);
+	else
+		loggerMsg = spLoggerCreate(!strcmp(loggerFilename, STDOUT) ? NULL : loggerFilename,
+				loggerLevel);
 
 	if (loggerMsg != SP_LOGGER_SUCCESS) {
 		printf(ERROR_AT_CREATE_LOGGER, loggerMsgToStr(loggerMsg));
@@ -366,6 +403,12 @@ bool initConfigAndLogger(int argc, char** argv, SPConfig* config) {
 	spLoggerSafePrintDebug(DEBUG_LOGGER_HAS_BEEN_CREATED, __FILE__, __FUNCTION__,
 			__LINE__);
 
+	// an update keeps the PCA of the last extraction, extraction mode would compute it again
+	if (*updateFlag) {
+		spConfigSetExtractionMode(*config, false);
+		spLoggerSafePrintDebug(DEBUG_UPDATE_MODE, __FILE__, __FUNCTION__, __LINE__);
+	}
+
 	return true;
 }
 
@@ -383,3 +426,58 @@ bool initSettings(SPConfig config, int* numOfImages, int* numOfSimilarImages,
 			verifyImagesFiles(config, *numOfImages, *extractFlag);
 }
 
+bool parseIndexUpdateQuery(const char* query, bool* isAddition, int* imageIndex) {
+	char* end;
+	long index;
+
+	if (!strcmp(query, ADD_IMAGE_QUERY)) {
+		*isAddition = true;
+		*imageIndex = -1;
+		return true;
+	}
+
+	// only "-" followed by decimal digits, so paths are never taken for removals
+	if (query[0] != REMOVE_IMAGE_QUERY_PREFIX || !isdigit((unsigned char) query[1]))
+		return false;
+	index = strtol(query + 1, &end, DECIMAL_BASE);
+	if (*end != '\0' || index > INT_MAX)
+		return false;
+
+	*isAddition = false;
+	*imageIndex = (int) index;
+	return true;
+}
+
+bool prepareImageAddition(SPConfig config, SPSearchIndex searchIndex, char* path,
+		int* imageIndex) {
+	SP_CONFIG_MSG msg = SP_CONFIG_SUCCESS;
+	int numOfImages = spConfigGetNumOfImages(config, &msg);
+
+	*imageIndex = spSearchIndexGetNumOfImages(searchIndex);
+	spConfigSetImagesNum(config, *imageIndex + 1);
+
+	if (spConfigGetImagePath(path, config, *imageIndex) != SP_CONFIG_SUCCESS ||
+			!verifyPathAndAvailableFile(path)) {
+		spConfigSetImagesNum(config, numOfImages);
+		return false;
+	}
+	return true;
+}
+
+bool addImageToSearchIndex(SPConfig config, SPSearchIndex searchIndex, int imageIndex,
+		SPPoint* features, int numOfFeatures) {
+	if (features != NULL && spSearchIndexAddImage(searchIndex, imageIndex, features,
+			numOfFeatures)) {
+		free(features);
+		return true;
+	}
+
+	spLoggerSafePrintError(ERROR_ADDING_IMAGE_TO_SEARCH_INDEX, __FILE__, __FUNCTION__,
+			__LINE__);
+	if (features != NULL) {
+		freeFeatures(features, numOfFeatures);
+		free(features);
+	}
+	spConfigSetImagesNum(config, imageIndex);
+	return false;
+}
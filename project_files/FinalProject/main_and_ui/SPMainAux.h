@@ -4,15 +4,20 @@
 #include "../SPConfig.h"
 #include "../image_parsing/SPImagesParser.h"
 #include "../data_structures/bpqueue_ds/SPBPriorityQueue.h"
-#include "../data_structures/kd_ds/SPKDTreeNode.h"
+#include "../data_structures/index_ds/SPSearchIndex.h"
+#include "SPImageQuery.h"
+#include "SPQueryCache.h"
 #include "../general_utils/SPUtils.h"
 
 //these macros are required at SPMainAux and at main.cpp
 #define WARNING_COULD_NOT_LOAD_IMAGE_PATH						"Warning, could not load image path"
 #define RELEVANT_IMAGE_INDEX_IS									"Could not present image properly, image index is %d\n"
+#define ADD_IMAGE_QUERY											"+"
+#define REMOVE_IMAGE_QUERY_PREFIX								'-'
 
 /*
- * Extracts the configuration filename from the command line arguments of the program
+ * Extracts the configuration filename from the command line arguments of the program,
+ * which may end with "--update"
  *
  * pre assumptions - argv is valid and argc is its length
  *
@@ -20,11 +25,12 @@
  * including the name of the program
  * @param argv - an array containing all the arguments the program received in the command
  * line
+ * @param updateFlag - *updateFlag is set to true if the last argument is "--update"
  *
  * @return the configuration filename extracted from the command line arguments if they
  * were given in a valid way, NULL otherwise.
  */
-char* getConfigFilename(int argc, char** argv);
+char* getConfigFilename(int argc, char** argv, bool* updateFlag);
 
 /*
  * Builds a configuration structure instance based on the given configuration filename
@@ -79,8 +85,9 @@ void getAsString(const char* message, char* destination);
  * @param config - the config item to be freed
  * @param image - an image to be freed
  * @param isCurrentImageFeaturesArrayAllocated - indicates that image->features is not NULL
- * @param kdTree - the KDTree item to be freed
- * @param bpq - the priority queue item to be freed
+ * @param searchIndex - the search index to be freed
+ * @param queryContext - the query context to be freed
+ * @param queryCache - the query cache to be destroyed (it spills its images)
  * @param returnValue - an integer that indicates if the program finished its work
  * 						successfully
  *
@@ -88,8 +95,8 @@ void getAsString(const char* message, char* destination);
  * in case we try to free a null pointer a relevant warning is logged to the logger
  */
 void endControlFlow(SPConfig config, SPImageData image,
-		bool isCurrentImageFeaturesArrayAllocated, SPKDTreeNode kdTree, SPBPQueue bpq,
-		int returnValue);
+		bool isCurrentImageFeaturesArrayAllocated, SPSearchIndex searchIndex,
+		SPQueryContext queryContext, SPQueryCache queryCache, int returnValue);
 
 /*
  * The method prints the result to the user in non-minimal GUI mode in the requested format
@@ -146,12 +153,15 @@ SPPoint* initializeAllFeaturesArray(SPImageData* workingImagesDatabase, int numO
  * representing the closest images found to the query image
  *
  * @param workingImage - image item to query
- * @param kdTree - a KDTree instance representing the KDTree created from all the features
+ * @param searchIndex - the search index created from all the features
  * of all the images whose paths were given in the configuration file
  * @param numOfImages - the total number of images in the database
  * @param numOfSimilarImages - the size of the returned array
- * @param bpq - a priority queue used to store the nearest features to each feature of the
- * working image
+ * @param queryContext - the query context of the calling thread, holds the working memory
+ * of the search
+ * @param deadline - the time the search stops at (see getQueryDeadline), the images are
+ * ranked by the query features that were searched until then
+ * @param isTruncated - if not NULL, set to true iff the search was stopped by the deadline
  *
  * @returns
  * NULL on memory allocation error, or error in an internal function
@@ -160,11 +170,27 @@ SPPoint* initializeAllFeaturesArray(SPImageData* workingImagesDatabase, int numO
  *
  * @logger - in case of any type of failure the relevant error is logged to the logger
  */
-int* searchSimilarImages(SPImageData workingImage, SPKDTreeNode kdTree, int numOfImages,
-		int numOfSimilarImages, SPBPQueue bpq);
+int* searchSimilarImages(SPImageData workingImage, SPSearchIndex searchIndex, int numOfImages,
+		int numOfSimilarImages, SPQueryContext queryContext, uint64_t deadline,
+		bool* isTruncated);
+
+/*
+ * The method returns the deadline of a query that starts now, according to the
+ * spQueryDeadline latency budget of the configuration
+ *
+ * @param config - the configurations item
+ *
+ * @returns the spInstrumentationNow time the query should end at, or
+ * SP_SEARCH_INDEX_NO_DEADLINE if the query has no budget or the budget could not be read
+ *
+ * @logger - in case of any type of failure the relevant error is logged to the logger
+ */
+uint64_t getQueryDeadline(const SPConfig config);
 
 /*
  * The method load some settings from the config item into given pointers.
+ * It also sets the default storage precision of the points (descriptors)
+ * according to spDescriptorPrecision.
  *
  * pre assumptions - config, numOfImages, numOfSimilar, extractFlag, GUIFlag are all valid
  *
@@ -210,19 +236,22 @@ SPImageData initializeWorkingImage();
 
 /*
  * Initializes SPImageData addressed by given SPImageData pointer 'currentImageData',
- * creates KDTree according to the given SPImageData pointers list 'imagesDataList'
- * and initializes a priority queue with max size using given configuration structure
- * instance 'config'
+ * creates the configured search index (KD-tree by default) according to the given
+ * SPImageData pointers list 'imagesDataList'
+ * and initializes a query context for searches of the configured number of nearest
+ * features using given configuration structure instance 'config'
  *
- * pre assumptions - currentImageData, kdTree and bpq are valid
+ * pre assumptions - currentImageData, searchIndex and queryContext are valid
  *
  * @param config - configuration structure instance
  * @param imagesDataList - list of SPImageData pointers according to which the function
- * creates the KDTree
+ * creates the search index
+ * @param featsWriter - in extraction mode, the writer the extracted images were submitted
+ * to (the function waits for it to save them), or NULL to save them in the function
  * @param currentImageData - pointer to address to initialize SPImageData in
- * @param kdTree - pointer to a SPKDTreeNode which will be the root of the KDTree to be
+ * @param searchIndex - pointer to a SPSearchIndex which will hold the search index to be
  * built in the function
- * @param bpq - pointer to SPBPQueue to be initialized in the function
+ * @param queryContext - pointer to SPQueryContext to be initialized in the function
  * @param numOfImages - the number of images in workingImagesDatabase (the size of the
  * SPImageData instances array)
  *
@@ -233,9 +262,9 @@ SPImageData initializeWorkingImage();
  * in case of any type of error or warning a relevant message is written to the logger
  * debug prints are also printed to the logger
  */
-bool initializeWorkingImageKDTreeAndBPQueue(const SPConfig config,
-		SPImageData* imagesDataList, SPImageData* currentImageData, SPKDTreeNode* kdTree,
-		SPBPQueue* bpq, int numOfImages);
+bool initializeWorkingImageKDTreeAndQueryContext(const SPConfig config,
+		SPImageData* imagesDataList, SPFeatsWriter featsWriter, SPImageData* currentImageData,
+		SPSearchIndex* searchIndex, SPQueryContext* queryContext, int numOfImages);
 
 /*
  * Verifies that the PCA file path and images files paths extracted from 'config' are valid
@@ -286,12 +315,14 @@ bool verifyImagesNumbersLimits(SPConfig config, int numOfImages, int* numOfSimil
  * line
  * @param config - pointer to a configuration structure instance to be initialized in the
  * function
+ * @param updateFlag - *updateFlag is set to true for an update run ("--update"), then
+ * the configuration is set out of extraction mode so the PCA file is kept
  *
  * @returns false if failed in any stage of the operation, otherwise returns true
  *
  * a debug print is printed to the logger (after it is initiated)
  */
-bool initConfigAndLogger(int argc, char** argv, SPConfig* config);
+bool initConfigAndLogger(int argc, char** argv, SPConfig* config, bool* updateFlag);
 
 /*
  * Initializes the values of the settings pointed by: 'numOfImages', 'numOfSimilarImages',
@@ -319,5 +350,64 @@ bool initConfigAndLogger(int argc, char** argv, SPConfig* config);
 bool initSettings(SPConfig config, int* numOfImages, int* numOfSimilarImages,
 		bool* extractFlag, bool* GUIFlag);
 
+/*
+ * The method checks whether the user query is an index update request rather than an
+ * image path: "+" adds the next image of the images directory to the search index, and
+ * "-<index>" (e.g. "-7") removes the image of the given index from the search results.
+ *
+ * pre assumptions - query, isAddition and imageIndex are valid
+ *
+ * @param query - the user query
+ * @param isAddition - pointer to a boolean to contain true for an addition request and
+ * false for a removal request
+ * @param imageIndex - pointer to an integer to contain the index of the image to remove,
+ * -1 for an addition request
+ *
+ * @returns true iff the query is an index update request
+ */
+bool parseIndexUpdateQuery(const char* query, bool* isAddition, int* imageIndex);
+
+/*
+ * The method prepares the addition of the next image to the search index: the image
+ * takes the next index, the number of images of the configuration is increased to
+ * include it, and the path of its file is generated and verified.
+ * The number of images is restored if the file is not available.
+ *
+ * pre assumptions - config, searchIndex, path and imageIndex are valid
+ *
+ * @param config - the configuration structure instance
+ * @param searchIndex - the search index to add the image to
+ * @param path - an allocated string to contain the path of the new image
+ * @param imageIndex - pointer to an integer to contain the index of the new image
+ *
+ * @returns true iff the new image file is available
+ *
+ * @logger - in case of any type of warning a relevant message is written to the logger
+ */
+bool prepareImageAddition(SPConfig config, SPSearchIndex searchIndex, char* path,
+		int* imageIndex);
+
+/*
+ * The method adds the features of the image prepared by prepareImageAddition to the
+ * search index. The features array is freed in any case, the features themselves are
+ * owned by the index on success and destroyed on failure, in which case the number of
+ * images of the configuration is restored.
+ *
+ * pre assumptions - config and searchIndex are valid, the image was prepared
+ *
+ * @param config - the configuration structure instance
+ * @param searchIndex - the search index to add the image to
+ * @param imageIndex - the index of the new image
+ * @param features - the features extracted from the new image (may be NULL on
+ * extraction failure)
+ * @param numOfFeatures - the size of features
+ *
+ * @returns true iff the image was added
+ *
+ * @logger - in case of any type of failure the relevant error is logged to the logger
+ */
+bool addImageToSearchIndex(SPConfig config, SPSearchIndex searchIndex, int imageIndex,
+		SPPoint* features, int numOfFeatures);
+
 #endif /* SPMAINAUX_H_ */
 
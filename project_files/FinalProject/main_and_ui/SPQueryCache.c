@@ -0,0 +1,458 @@
+#define _POSIX_C_SOURCE 200809L // stat under -std=c99
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <sys/stat.h>
+
+#include "SPQueryCache.h"
+#include "../SPLogger.h"
+#include "../image_parsing/SPImageData.h"
+#include "../image_parsing/SPFeatsReader.h"
+#include "../image_parsing/SPFeatsWriter.h"
+#include "../image_parsing/SPManifest.h"
+#include "../general_utils/SPUtils.h"
+#include "../general_utils/SPInstrumentation.h"
+
+#define BYTES_PER_MEGABYTE					(1024 * 1024)
+#define POINT_OVERHEAD_BYTES				48 // the point struct, its allocations and its slot
+#define SPILL_PATH_FORMAT					"%s%016llx.feats"
+#define SPILL_SIGNATURE_FORMAT				"==[%s][%lld][%lld][%d][%d][%d][%d][%016llx]==\n"
+#define SPILL_SIGNATURE_LENGTH				(MAX_PATH_LEN + 128)
+#define SPILLED_IMAGE_INDEX					0 // the index of the query images
+#define FNV_OFFSET_BASIS					14695981039346656037ULL
+#define FNV_PRIME							1099511628211ULL
+#define INITIAL_NUM_OF_BUCKETS				64 // a power of 2, doubled once every bucket is used
+
+#define FAILED_CREATING_QUERY_CACHE			"Failed creating the query cache"
+#define FAILED_GETTING_CACHED_QUERY			"Failed getting the cached descriptors of a query image"
+#define FAILED_CACHING_QUERY				"Failed caching the descriptors of a query image"
+#define WARNING_QUERY_IMAGE_NOT_READ		"Could not read a query image file, it is not cached"
+#define WARNING_PCA_NOT_HASHED_FOR_CACHE	"Could not hash the PCA file, the query cache is not spilled"
+#define WARNING_QUERY_NOT_SPILLED			"Could not spill the descriptors of a query image"
+
+#define DEBUG_QUERY_CACHE_HIT				"The descriptors of the query image were found in the query cache"
+
+/*
+ * A cached image, an item of the list of the cached images
+ * isSpilled - the image has a spilled file
+ * bytes - the estimated memory of the descriptors
+ * moreRecent, lessRecent - the neighbors in the list, by the time they were used
+ * nextInBucket - the next image whose path falls in the same bucket
+ */
+typedef struct query_cache_entry_t {
+	char path[MAX_PATH_LEN];
+	long long size;
+	long long mtime;
+	SPPoint* features;
+	int numOfFeatures;
+	size_t bytes;
+	bool isSpilled;
+	struct query_cache_entry_t* moreRecent;
+	struct query_cache_entry_t* lessRecent;
+	struct query_cache_entry_t* nextInBucket;
+} QueryCacheEntry;
+
+/*
+ * A structure used for the query cache
+ * budget, usedBytes - the memory budget and the estimated memory of the cached images
+ * mostRecent, leastRecent - the ends of the list of the cached images
+ * buckets - the cached images by the hash of their path, numOfBuckets chains
+ * numOfEntries - the number of cached images
+ * spillDirectory - the spill directory of the configuration, NULL if nothing is spilled
+ * PCADim, PCAHash - the PCA the descriptors are projected by, part of the spill signature
+ * maxImageDimension - the resolution the descriptors are extracted at, part of the spill
+ * signature too
+ * tileSize, tileOverlap - the detection tiles of the query images, part of the spill
+ * signature too
+ */
+struct sp_query_cache_t {
+	size_t budget;
+	size_t usedBytes;
+	QueryCacheEntry* mostRecent;
+	QueryCacheEntry* leastRecent;
+	QueryCacheEntry** buckets;
+	int numOfBuckets;
+	int numOfEntries;
+	const char* spillDirectory;
+	int PCADim;
+	unsigned long long PCAHash;
+	int maxImageDimension;
+	int tileSize;
+	int tileOverlap;
+	int hits;
+	int misses;
+};
+
+/*
+ * Gets the size and the modification time of a file
+ *
+ * @returns false if the file could not be stat-ed, true otherwise
+ */
+static bool statImage(const char* imagePath, long long* size, long long* mtime) {
+	struct stat status;
+
+	if (stat(imagePath, &status) != 0)
+		return false;
+	*size = (long long) status.st_size;
+	*mtime = (long long) status.st_mtime;
+	return true;
+}
+
+/*
+ * Estimates the memory of the given descriptors
+ */
+static size_t featuresBytes(SPPoint* features, int numOfFeatures) {
+	size_t bytes = 0, coordinateBytes;
+	int i;
+
+	for (i = 0; i < numOfFeatures; i++) {
+		switch (spPointGetPrecision(features[i])) {
+		case SP_POINT_PRECISION_FLOAT:
+			coordinateBytes = sizeof(float);
+			break;
+		case SP_POINT_PRECISION_HALF:
+			coordinateBytes = sizeof(uint16_t);
+			break;
+		default:
+			coordinateBytes = sizeof(double);
+		}
+		bytes += POINT_OVERHEAD_BYTES + coordinateBytes *
+				(size_t) spPointGetDimension(features[i]);
+	}
+	return bytes;
+}
+
+/*
+ * Copies the given descriptors
+ *
+ * @returns NULL in case of memory allocation error, otherwise the copy
+ */
+static SPPoint* copyFeatures(SPPoint* features, int numOfFeatures) {
+	SPPoint* copy = NULL;
+	int i;
+
+	spCalloc(copy, SPPoint, numOfFeatures);
+	for (i = 0; i < numOfFeatures; i++) {
+		if ((copy[i] = spPointCopy(features[i])) == NULL) {
+			freeFeatures(copy, i);
+			free(copy);
+			return NULL;
+		}
+	}
+	return copy;
+}
+
+/*
+ * Returns the FNV-1a hash of a string
+ */
+static unsigned long long hashString(const char* string) {
+	unsigned long long hash = FNV_OFFSET_BASIS;
+	int i;
+
+	for (i = 0; string[i] != '\0'; i++)
+		hash = (hash ^ (unsigned char) string[i]) * FNV_PRIME;
+	return hash;
+}
+
+/*
+ * Writes the spill file path and the spill signature of an image
+ */
+static void getSpillPathAndSignature(SPQueryCache cache, const char* imagePath,
+		long long size, long long mtime, char* spillPath, char* signature) {
+	snprintf(signature, SPILL_SIGNATURE_LENGTH, SPILL_SIGNATURE_FORMAT, imagePath, size,
+			mtime, cache->PCADim, cache->maxImageDimension, cache->tileSize, cache->tileOverlap,
+			cache->PCAHash);
+	snprintf(spillPath, MAX_PATH_LEN, SPILL_PATH_FORMAT, cache->spillDirectory,
+			hashString(signature));
+}
+
+/*
+ * Returns the bucket of the given path, the head of its chain
+ */
+static QueryCacheEntry** getBucket(SPQueryCache cache, const char* imagePath) {
+	return &(cache->buckets[hashString(imagePath) & (cache->numOfBuckets - 1)]);
+}
+
+/*
+ * Doubles the number of buckets and moves the images to their new buckets. On memory
+ * allocation failure the buckets are kept as they are, the chains just grow longer.
+ */
+static void growBuckets(SPQueryCache cache) {
+	QueryCacheEntry **oldBuckets = cache->buckets, *entry, **bucket;
+	int b, oldNumOfBuckets = cache->numOfBuckets;
+
+	if ((cache->buckets = (QueryCacheEntry**) calloc(2 * oldNumOfBuckets,
+			sizeof(QueryCacheEntry*))) == NULL) {
+		cache->buckets = oldBuckets;
+		return;
+	}
+	cache->numOfBuckets = 2 * oldNumOfBuckets;
+	for (b = 0; b < oldNumOfBuckets; b++) {
+		while ((entry = oldBuckets[b]) != NULL) {
+			oldBuckets[b] = entry->nextInBucket;
+			bucket = getBucket(cache, entry->path);
+			entry->nextInBucket = *bucket;
+			*bucket = entry;
+		}
+	}
+	free(oldBuckets);
+}
+
+/*
+ * Spills an image to its .feats file if it was not spilled yet, a failure is logged
+ */
+static void spillEntry(SPQueryCache cache, QueryCacheEntry* entry) {
+	char spillPath[MAX_PATH_LEN], signature[SPILL_SIGNATURE_LENGTH];
+	SPImageData imageData = NULL;
+
+	if (cache->spillDirectory == NULL || entry->isSpilled)
+		return;
+	if ((imageData = createImageData(SPILLED_IMAGE_INDEX)) == NULL) {
+		spLoggerSafePrintWarning(WARNING_QUERY_NOT_SPILLED, __FILE__, __FUNCTION__, __LINE__);
+		return;
+	}
+	getSpillPathAndSignature(cache, entry->path, entry->size, entry->mtime, spillPath,
+			signature);
+	imageData->featuresArray = entry->features;
+	imageData->numOfFeatures = entry->numOfFeatures;
+	entry->isSpilled = spFeatsWriterSave(signature, spillPath, imageData) == SP_DP_SUCCESS;
+	if (!entry->isSpilled)
+		spLoggerSafePrintWarning(WARNING_QUERY_NOT_SPILLED, __FILE__, __FUNCTION__, __LINE__);
+	imageData->featuresArray = NULL; // the features stay in the entry
+	freeImageData(imageData, true, false);
+}
+
+static void unlinkEntry(SPQueryCache cache, QueryCacheEntry* entry) {
+	if (entry->moreRecent != NULL)
+		entry->moreRecent->lessRecent = entry->lessRecent;
+	else
+		cache->mostRecent = entry->lessRecent;
+	if (entry->lessRecent != NULL)
+		entry->lessRecent->moreRecent = entry->moreRecent;
+	else
+		cache->leastRecent = entry->moreRecent;
+	entry->moreRecent = entry->lessRecent = NULL;
+}
+
+static void linkEntryAsMostRecent(SPQueryCache cache, QueryCacheEntry* entry) {
+	entry->lessRecent = cache->mostRecent;
+	entry->moreRecent = NULL;
+	if (cache->mostRecent != NULL)
+		cache->mostRecent->moreRecent = entry;
+	else
+		cache->leastRecent = entry;
+	cache->mostRecent = entry;
+}
+
+/*
+ * Unlinks an image from the cache and frees it
+ */
+static void removeEntry(SPQueryCache cache, QueryCacheEntry* entry) {
+	QueryCacheEntry** link = getBucket(cache, entry->path);
+
+	while (*link != entry)
+		link = &((*link)->nextInBucket);
+	*link = entry->nextInBucket;
+	cache->numOfEntries--;
+	unlinkEntry(cache, entry);
+	cache->usedBytes -= entry->bytes;
+	freeFeatures(entry->features, entry->numOfFeatures);
+	free(entry->features);
+	free(entry);
+}
+
+/*
+ * Finds the cached image of a path, an image of the path with another size or
+ * modification time is removed
+ *
+ * @returns NULL if the image is not in memory, otherwise its entry
+ */
+static QueryCacheEntry* findEntry(SPQueryCache cache, const char* imagePath,
+		long long size, long long mtime) {
+	QueryCacheEntry* entry = *getBucket(cache, imagePath);
+
+	for (; entry != NULL; entry = entry->nextInBucket) {
+		if (strcmp(entry->path, imagePath))
+			continue;
+		if (entry->size == size && entry->mtime == mtime)
+			return entry;
+		removeEntry(cache, entry);
+		return NULL;
+	}
+	return NULL;
+}
+
+/*
+ * Adds an image as the most recently used, and evicts (and spills) the least recently
+ * used images while the cache is over its budget. The features are owned by the cache
+ * afterwards, and if the image is larger than the budget they are freed.
+ *
+ * @returns NULL if the image was not added, otherwise its entry
+ */
+static QueryCacheEntry* addEntry(SPQueryCache cache, const char* imagePath, long long size,
+		long long mtime, SPPoint* features, int numOfFeatures, bool isSpilled) {
+	QueryCacheEntry *entry = NULL, **bucket;
+	size_t bytes = sizeof(QueryCacheEntry) + featuresBytes(features, numOfFeatures);
+
+	if (bytes > cache->budget || (entry = (QueryCacheEntry*) calloc(1,
+			sizeof(QueryCacheEntry))) == NULL) {
+		freeFeatures(features, numOfFeatures);
+		free(features);
+		return NULL;
+	}
+	strncpy(entry->path, imagePath, MAX_PATH_LEN - 1);
+	entry->size = size;
+	entry->mtime = mtime;
+	entry->features = features;
+	entry->numOfFeatures = numOfFeatures;
+	entry->bytes = bytes;
+	entry->isSpilled = isSpilled;
+
+	while (cache->usedBytes + bytes > cache->budget) {
+		spillEntry(cache, cache->leastRecent);
+		removeEntry(cache, cache->leastRecent);
+	}
+	linkEntryAsMostRecent(cache, entry);
+	cache->usedBytes += bytes;
+
+	if (++(cache->numOfEntries) > cache->numOfBuckets)
+		growBuckets(cache);
+	bucket = getBucket(cache, imagePath);
+	entry->nextInBucket = *bucket;
+	*bucket = entry;
+	return entry;
+}
+
+/*
+ * Loads an image from its spilled file, if it has one, and adds it to the cache
+ *
+ * @returns NULL if the image was not loaded, otherwise its entry
+ */
+static QueryCacheEntry* loadSpilledEntry(SPQueryCache cache, const char* imagePath,
+		long long size, long long mtime) {
+	char spillPath[MAX_PATH_LEN], signature[SPILL_SIGNATURE_LENGTH];
+	struct stat status;
+	SPImageData imageData = NULL;
+	QueryCacheEntry* entry = NULL;
+
+	if (cache->spillDirectory == NULL)
+		return NULL;
+	getSpillPathAndSignature(cache, imagePath, size, mtime, spillPath, signature);
+	// most misses have no spilled file, and the reader logs a missing file as an error
+	if (stat(spillPath, &status) != 0 || (imageData = createImageData(
+			SPILLED_IMAGE_INDEX)) == NULL)
+		return NULL;
+	if (spFeatsReaderLoad(signature, spillPath, imageData) == SP_DP_SUCCESS &&
+			imageData->numOfFeatures > 0) {
+		entry = addEntry(cache, imagePath, size, mtime, imageData->featuresArray,
+				imageData->numOfFeatures, true);
+		imageData->featuresArray = NULL; // owned by the entry, or freed by addEntry
+	}
+	freeImageData(imageData, true, true);
+	return entry;
+}
+
+SPQueryCache spQueryCacheCreate(const SPConfig config) {
+	SPQueryCache cache = NULL;
+	SP_CONFIG_MSG configMsg = SP_CONFIG_SUCCESS;
+	char pcaPath[MAX_PATH_LEN];
+	int cacheSize, PCADim, maxImageDimension, tileSize, tileOverlap;
+	char* spillDirectory;
+
+	spVerifyArgumentsRn(config != NULL, FAILED_CREATING_QUERY_CACHE);
+	cacheSize = spConfigGetQueryCacheSize(config, &configMsg);
+	PCADim = spConfigGetPCADim(config, &configMsg);
+	maxImageDimension = spConfigGetMaxImageDimension(config, &configMsg);
+	tileSize = spConfigGetDetectionTileSize(config, &configMsg);
+	tileOverlap = spConfigGetDetectionTileOverlap(config, &configMsg);
+	spillDirectory = spConfigGetQueryCacheDirectory(config, &configMsg);
+	spValRn(configMsg == SP_CONFIG_SUCCESS, FAILED_CREATING_QUERY_CACHE);
+
+	spCallocErWc(cache, struct sp_query_cache_t, 1, FAILED_CREATING_QUERY_CACHE, );
+	spCallocErWc(cache->buckets, QueryCacheEntry*, INITIAL_NUM_OF_BUCKETS,
+			FAILED_CREATING_QUERY_CACHE, free(cache));
+	cache->numOfBuckets = INITIAL_NUM_OF_BUCKETS;
+	cache->budget = (size_t) cacheSize * BYTES_PER_MEGABYTE;
+	cache->PCADim = PCADim;
+	cache->maxImageDimension = maxImageDimension;
+	cache->tileSize = tileSize;
+	cache->tileOverlap = tileOverlap;
+	cache->spillDirectory = cache->budget > 0 ? spillDirectory : NULL;
+	if (cache->spillDirectory != NULL && (spConfigGetPCAPath(pcaPath, config) !=
+			SP_CONFIG_SUCCESS || spManifestHashFile(pcaPath, &(cache->PCAHash)) !=
+			SP_DP_SUCCESS)) {
+		spLoggerSafePrintWarning(WARNING_PCA_NOT_HASHED_FOR_CACHE, __FILE__, __FUNCTION__,
+				__LINE__);
+		cache->spillDirectory = NULL;
+	}
+	return cache;
+}
+
+SPPoint* spQueryCacheGet(SPQueryCache cache, const char* imagePath, int* numOfFeatures) {
+	QueryCacheEntry* entry = NULL;
+	SPPoint* features = NULL;
+	long long size, mtime;
+
+	spVerifyArgumentsRn(cache != NULL && imagePath != NULL && numOfFeatures != NULL,
+			FAILED_GETTING_CACHED_QUERY);
+	*numOfFeatures = 0;
+
+	if (cache->budget > 0 && statImage(imagePath, &size, &mtime) &&
+			(entry = findEntry(cache, imagePath, size, mtime)) == NULL)
+		entry = loadSpilledEntry(cache, imagePath, size, mtime);
+	if (entry == NULL) {
+		cache->misses++;
+		spInstrCount(SP_INSTR_QUERY_CACHE_MISSES);
+		return NULL;
+	}
+
+	unlinkEntry(cache, entry);
+	linkEntryAsMostRecent(cache, entry);
+	spValRn((features = copyFeatures(entry->features, entry->numOfFeatures)) != NULL,
+			FAILED_GETTING_CACHED_QUERY);
+	cache->hits++;
+	spInstrCount(SP_INSTR_QUERY_CACHE_HITS);
+	spLoggerSafePrintDebug(DEBUG_QUERY_CACHE_HIT, __FILE__, __FUNCTION__, __LINE__);
+	*numOfFeatures = entry->numOfFeatures;
+	return features;
+}
+
+bool spQueryCacheInsert(SPQueryCache cache, const char* imagePath, SPPoint* features,
+		int numOfFeatures) {
+	QueryCacheEntry* entry = NULL;
+	SPPoint* copy = NULL;
+	long long size, mtime;
+
+	spVerifyArguments(cache != NULL && imagePath != NULL && features != NULL &&
+			numOfFeatures > 0, FAILED_CACHING_QUERY, false);
+	if (cache->budget == 0)
+		return false;
+	spValNc(statImage(imagePath, &size, &mtime), WARNING_QUERY_IMAGE_NOT_READ, false);
+
+	if ((entry = findEntry(cache, imagePath, size, mtime)) != NULL)
+		removeEntry(cache, entry);
+	spVal((copy = copyFeatures(features, numOfFeatures)) != NULL, FAILED_CACHING_QUERY,
+			false);
+	return addEntry(cache, imagePath, size, mtime, copy, numOfFeatures, false) != NULL;
+}
+
+int spQueryCacheGetHits(SPQueryCache cache) {
+	return cache != NULL ? cache->hits : -1;
+}
+
+int spQueryCacheGetMisses(SPQueryCache cache) {
+	return cache != NULL ? cache->misses : -1;
+}
+
+void spQueryCacheDestroy(SPQueryCache cache) {
+	if (cache == NULL)
+		return;
+	while (cache->mostRecent != NULL) {
+		spillEntry(cache, cache->mostRecent);
+		removeEntry(cache, cache->mostRecent);
+	}
+	free(cache->buckets);
+	free(cache);
+}
@@ -0,0 +1,106 @@
+#ifndef SPQUERYCACHE_H_
+#define SPQUERYCACHE_H_
+
+#include <stdbool.h>
+#include "../SPConfig.h"
+#include "../SPPoint.h"
+
+/**
+ * SP Query Cache summary
+ *
+ * Keeps the projected descriptors of the recent query images, so a query image that is
+ * queried again is not extracted again. An image is identified by its path, size and
+ * modification time, so an image file that was changed is extracted again.
+ *
+ * The descriptors are kept in memory up to spQueryCacheSize megabytes (by an estimate
+ * of the memory of their points), and the least recently used images are evicted first.
+ * If spQueryCacheDirectory is set, an evicted image (and every image that is still cached
+ * when the cache is destroyed) is spilled to a .feats file in that directory, and a query
+ * image that is not in memory is loaded from its spilled file, which is a cache hit too.
+ * A spilled file is saved with the PCA dimension, the hash of the PCA file, the
+ * maximal image dimension and the detection tiles, so the files of another PCA,
+ * resolution or tiling are not loaded.
+ * The spill directory is never pruned.
+ *
+ * The cache is not thread safe, it is used by the thread that handles the user queries.
+ *
+ * The following functions are supported:
+ *
+ * spQueryCacheCreate			- Creates a cache by the configuration
+ * spQueryCacheGet				- Gets the cached descriptors of a query image
+ * spQueryCacheInsert			- Caches the descriptors of a query image
+ * spQueryCacheGetHits			- Returns the number of cache hits
+ * spQueryCacheGetMisses		- Returns the number of cache misses
+ * spQueryCacheDestroy			- Spills the cached images and frees the cache
+ */
+
+/** Type for defining the query cache **/
+typedef struct sp_query_cache_t* SPQueryCache;
+
+/*
+ * Creates an empty cache with a memory budget of spQueryCacheSize megabytes, that spills
+ * to spQueryCacheDirectory if it is set. If the budget is 0 nothing is cached.
+ * If the PCA file could not be hashed the images are not spilled.
+ *
+ * @param config - the configuration, it must stay valid until the cache is destroyed
+ *
+ * @returns NULL in case of invalid argument, configuration reading error or memory
+ * allocation error, otherwise the cache
+ *
+ * @logger - Prints relevant errors and warnings to the logger.
+ */
+SPQueryCache spQueryCacheCreate(const SPConfig config);
+
+/*
+ * Gets a copy of the cached descriptors of an image file, if its path, size and
+ * modification time match a cached image, and marks the image as the most recently used.
+ *
+ * @param cache - the cache
+ * @param imagePath - the path of the query image
+ * @param numOfFeatures - the number of descriptors is written to *numOfFeatures,
+ * 0 in case of a miss
+ *
+ * @returns NULL in case of invalid argument, memory allocation error or a cache miss,
+ * otherwise the descriptors, which the caller should free
+ *
+ * @logger - Prints relevant errors and warnings to the logger.
+ */
+SPPoint* spQueryCacheGet(SPQueryCache cache, const char* imagePath, int* numOfFeatures);
+
+/*
+ * Caches a copy of the descriptors of an image file as the most recently used image,
+ * and evicts the least recently used images while the cache is over its budget.
+ * An image that is larger than the whole budget is not cached.
+ *
+ * @param cache - the cache
+ * @param imagePath - the path of the query image
+ * @param features - the descriptors of the image, they are not changed
+ * @param numOfFeatures - the number of descriptors
+ *
+ * @returns true if the image was cached, false otherwise
+ *
+ * @logger - Prints relevant errors and warnings to the logger.
+ */
+bool spQueryCacheInsert(SPQueryCache cache, const char* imagePath, SPPoint* features,
+		int numOfFeatures);
+
+/*
+ * Returns the number of spQueryCacheGet calls that found the image, -1 if cache is NULL
+ */
+int spQueryCacheGetHits(SPQueryCache cache);
+
+/*
+ * Returns the number of spQueryCacheGet calls that did not find the image, -1 if cache
+ * is NULL
+ */
+int spQueryCacheGetMisses(SPQueryCache cache);
+
+/*
+ * Spills the cached images that were not spilled yet (if there is a spill directory)
+ * and frees all the resources of the cache. If cache is NULL nothing happens.
+ *
+ * @param cache - the cache
+ */
+void spQueryCacheDestroy(SPQueryCache cache);
+
+#endif /* SPQUERYCACHE_H_ */
@@ -271,11 +271,23 @@ static bool testBPQueueMinMaxValue() {
 
 	ASSERT_TRUE(spBPQueueMinValue(queue2) == 1);
 	ASSERT_TRUE(spBPQueueMaxValue(queue2) == 4);
+	ASSERT_TRUE(spBPQueueMinIndex(queue2) == 1);
 
+	// the maximum is updated in place as items are dequeued and enqueued
+	quickDequeue(queue2, 3);
+	ASSERT_TRUE(spBPQueueMinIndex(queue2) == 4);
+	ASSERT_TRUE(spBPQueueMaxValue(queue2) == 4);
+	quickDequeue(queue2, 1);
+	ASSERT_TRUE(spBPQueueMinIndex(queue2) == DEFAULT_INVALID_NUMBER);
+	ASSERT_TRUE(spBPQueueMaxValue(queue2) == DEFAULT_INVALID_NUMBER);
+	ASSERT_TRUE(spBPQueueEnqueueValues(queue2, 9, 0.5) == SP_BPQUEUE_SUCCESS);
+	ASSERT_TRUE(spBPQueueMinIndex(queue2) == 9);
+	ASSERT_TRUE(spBPQueueMaxValue(queue2) == 0.5);
 
 	//test invalid arguments
 	ASSERT_TRUE(spBPQueueMinValue(NULL) == DEFAULT_INVALID_NUMBER);
 	ASSERT_TRUE(spBPQueueMaxValue(NULL) == DEFAULT_INVALID_NUMBER);
+	ASSERT_TRUE(spBPQueueMinIndex(NULL) == DEFAULT_INVALID_NUMBER);
 
 	spBPQueueDestroy(queue);
 	spBPQueueDestroy(queue2);
@@ -549,6 +561,27 @@ static bool testBPQueueSorted() {
 }
 
 
+bool verifySameQueues(SPBPQueue first, SPBPQueue second) {
+	SPListElement a, b;
+	bool same;
+	if (spBPQueueSize(first) != spBPQueueSize(second))
+		return false;
+	while (!spBPQueueIsEmpty(first)) {
+		a = spBPQueuePeek(first);
+		b = spBPQueuePeek(second);
+		same = a != NULL && b != NULL &&
+				spListElementGetIndex(a) == spListElementGetIndex(b) &&
+				spListElementGetValue(a) == spListElementGetValue(b);
+		spListElementDestroy(a);
+		spListElementDestroy(b);
+		if (!same)
+			return false;
+		spBPQueueDequeue(first);
+		spBPQueueDequeue(second);
+	}
+	return spBPQueueIsEmpty(second);
+}
+
 void runBPQueueTests() {
 	srand(time(NULL));
 	RUN_TEST(testBPQueueCreate);
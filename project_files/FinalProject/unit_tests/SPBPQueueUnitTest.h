@@ -2,8 +2,16 @@
 #ifndef SPBPQUEUEUNITTEST_H_
 #define SPBPQUEUEUNITTEST_H_
 
+#include <stdbool.h>
+#include "../data_structures/bpqueue_ds/SPBPriorityQueue.h"
+
 void runBPQueueTests();
 
+/*
+ * Returns true iff both queues hold the same indices with the same values, in the same
+ * order. Both queues are emptied.
+ */
+bool verifySameQueues(SPBPQueue first, SPBPQueue second);
 
 
 #endif /* SPBPQUEUEUNITTEST_H_ */
@@ -0,0 +1,180 @@
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "unit_test_util.h"
+#include "SPBoVWIndexUnitTest.h"
+#include "../data_structures/index_ds/SPBoVWIndex.h"
+#include "SPKDArrayUnitTest.h"
+#include "../SPPoint.h"
+
+#define BOVW_TESTS_DIM						10
+#define BOVW_TESTS_IMAGES					8
+#define BOVW_TESTS_FEATURES_PER_IMAGE		40
+#define BOVW_TESTS_SIZE						(BOVW_TESTS_IMAGES * BOVW_TESTS_FEATURES_PER_IMAGE)
+#define BOVW_TESTS_BRANCHING				4
+#define BOVW_TESTS_DEPTH					3
+#define BOVW_TESTS_WORDS					64 // BOVW_TESTS_BRANCHING ^ BOVW_TESTS_DEPTH
+#define BOVW_RANDOM_TESTS_COUNT				5
+
+/*
+ * Generates BOVW_TESTS_FEATURES_PER_IMAGE random descriptors for each image, the
+ * descriptors of image i are at [i * BOVW_TESTS_FEATURES_PER_IMAGE, ...)
+ */
+static SPPoint* generateImagesDescriptors() {
+	int i;
+	SPPoint* points = (SPPoint*) calloc(BOVW_TESTS_SIZE, sizeof(SPPoint));
+	if (points == NULL)
+		return NULL;
+	for (i = 0; i < BOVW_TESTS_SIZE; i++) {
+		points[i] = generateRandomPoint(BOVW_TESTS_DIM, i / BOVW_TESTS_FEATURES_PER_IMAGE);
+		if (points[i] == NULL) {
+			destroyPointsArray(points, i);
+			return NULL;
+		}
+	}
+	return points;
+}
+
+//invalid arguments test
+static bool bovwIndexInvalidArgumentsTest() {
+	SPPoint* points = generateImagesDescriptors();
+	SPPoint queryPoint = generateRandomPoint(BOVW_TESTS_DIM + 1, 0);
+	SPPoint outOfRangePoint = generateRandomPoint(BOVW_TESTS_DIM, BOVW_TESTS_IMAGES);
+	SPPoint validPoint;
+	SPBoVWIndex index;
+	ASSERT_TRUE(points != NULL && queryPoint != NULL && outOfRangePoint != NULL);
+
+	ASSERT_TRUE(spBoVWIndexCreate(NULL, BOVW_TESTS_SIZE, BOVW_TESTS_IMAGES, 2, 1, 1) == NULL);
+	ASSERT_TRUE(spBoVWIndexCreate(points, 0, BOVW_TESTS_IMAGES, 2, 1, 1) == NULL);
+	ASSERT_TRUE(spBoVWIndexCreate(points, BOVW_TESTS_SIZE, 0, 2, 1, 1) == NULL);
+	ASSERT_TRUE(spBoVWIndexCreate(points, BOVW_TESTS_SIZE, BOVW_TESTS_IMAGES, 1, 1, 1) == NULL);
+	ASSERT_TRUE(spBoVWIndexCreate(points, BOVW_TESTS_SIZE, BOVW_TESTS_IMAGES, 65, 1, 1) == NULL);
+	ASSERT_TRUE(spBoVWIndexCreate(points, BOVW_TESTS_SIZE, BOVW_TESTS_IMAGES, 2, 0, 1) == NULL);
+	ASSERT_TRUE(spBoVWIndexCreate(points, BOVW_TESTS_SIZE, BOVW_TESTS_IMAGES, 2, 21, 1) == NULL);
+	ASSERT_TRUE(spBoVWIndexCreate(points, BOVW_TESTS_SIZE, BOVW_TESTS_IMAGES, 2, 1, 0) == NULL);
+
+	// a descriptor of an unknown image
+	validPoint = points[BOVW_TESTS_SIZE - 1];
+	points[BOVW_TESTS_SIZE - 1] = outOfRangePoint;
+	ASSERT_TRUE(spBoVWIndexCreate(points, BOVW_TESTS_SIZE, BOVW_TESTS_IMAGES, 2, 1,
+			BOVW_TESTS_SIZE) == NULL);
+	points[BOVW_TESTS_SIZE - 1] = validPoint;
+	spPointDestroy(outOfRangePoint);
+	spBoVWIndexDestroy(NULL);
+
+	// a failed creation does not take ownership, a successful one does
+	index = spBoVWIndexCreate(points, BOVW_TESTS_SIZE, BOVW_TESTS_IMAGES,
+			BOVW_TESTS_BRANCHING, BOVW_TESTS_DEPTH, BOVW_TESTS_SIZE);
+	ASSERT_TRUE(index != NULL);
+	free(points);
+
+	ASSERT_TRUE(spBoVWIndexGetNumOfWords(NULL) == -1);
+	ASSERT_TRUE(spBoVWIndexQuantize(index, queryPoint) == -1); // dimension mismatch
+	ASSERT_TRUE(spBoVWIndexQuantize(NULL, queryPoint) == -1);
+	ASSERT_TRUE(spBoVWIndexSimilarImages(index, &queryPoint, 1, 1) == NULL);
+	ASSERT_TRUE(spBoVWIndexSimilarImages(index, &queryPoint, 0, 0) == NULL);
+	ASSERT_TRUE(spBoVWIndexSimilarImages(index, &queryPoint, 0,
+			BOVW_TESTS_IMAGES + 1) == NULL);
+
+	spBoVWIndexDestroy(index);
+	spPointDestroy(queryPoint);
+	return true;
+}
+
+//the vocabulary has branching ^ depth words and every descriptor maps to one of them
+static bool bovwIndexVocabularyTest() {
+	int i, word;
+	SPPoint* points = generateImagesDescriptors();
+	SPPoint* copies = points == NULL ? NULL : copyPointsArray(points, BOVW_TESTS_SIZE);
+	SPBoVWIndex index;
+	ASSERT_TRUE(points != NULL && copies != NULL);
+
+	// a small training sample, most of the vocabulary tree nodes get few vectors
+	index = spBoVWIndexCreate(points, BOVW_TESTS_SIZE, BOVW_TESTS_IMAGES,
+			BOVW_TESTS_BRANCHING, BOVW_TESTS_DEPTH, BOVW_TESTS_WORDS / 2);
+	ASSERT_TRUE(index != NULL);
+	free(points);
+	ASSERT_TRUE(spBoVWIndexGetNumOfWords(index) == BOVW_TESTS_WORDS);
+
+	for (i = 0; i < BOVW_TESTS_SIZE; i++) {
+		word = spBoVWIndexQuantize(index, copies[i]);
+		ASSERT_TRUE(word >= 0 && word < BOVW_TESTS_WORDS);
+		ASSERT_TRUE(spBoVWIndexQuantize(index, copies[i]) == word);
+	}
+
+	spBoVWIndexDestroy(index);
+	destroyPointsArray(copies, BOVW_TESTS_SIZE);
+	return true;
+}
+
+//an image is the most similar image to itself, and the ranking follows the scores
+static bool bovwIndexSelfRetrievalTest() {
+	int i, j, *similarImages;
+	double scores[BOVW_TESTS_IMAGES];
+	SPPoint* points = generateImagesDescriptors();
+	SPPoint* copies = points == NULL ? NULL : copyPointsArray(points, BOVW_TESTS_SIZE);
+	SPPoint* imageFeatures;
+	SPBoVWIndex index;
+	ASSERT_TRUE(points != NULL && copies != NULL);
+
+	index = spBoVWIndexCreate(points, BOVW_TESTS_SIZE, BOVW_TESTS_IMAGES,
+			BOVW_TESTS_BRANCHING, BOVW_TESTS_DEPTH, BOVW_TESTS_SIZE);
+	ASSERT_TRUE(index != NULL);
+	free(points);
+
+	for (i = 0; i < BOVW_TESTS_IMAGES; i++) {
+		imageFeatures = copies + i * BOVW_TESTS_FEATURES_PER_IMAGE;
+		similarImages = spBoVWIndexSimilarImages(index, imageFeatures,
+				BOVW_TESTS_FEATURES_PER_IMAGE, BOVW_TESTS_IMAGES);
+		ASSERT_TRUE(similarImages != NULL);
+		ASSERT_TRUE(similarImages[0] == i);
+
+		ASSERT_TRUE(spBoVWIndexScoreImages(index, imageFeatures,
+				BOVW_TESTS_FEATURES_PER_IMAGE, scores));
+		for (j = 1; j < BOVW_TESTS_IMAGES; j++) {
+			ASSERT_TRUE(scores[similarImages[j - 1]] > scores[similarImages[j]] ||
+					(scores[similarImages[j - 1]] == scores[similarImages[j]] &&
+					similarImages[j - 1] < similarImages[j]));
+		}
+		free(similarImages);
+	}
+
+	spBoVWIndexDestroy(index);
+	destroyPointsArray(copies, BOVW_TESTS_SIZE);
+	return true;
+}
+
+//a query without features scores 0 for all the images, they are ranked by index
+static bool bovwIndexEmptyQueryTest() {
+	int i, *similarImages;
+	SPPoint* points = generateImagesDescriptors();
+	SPBoVWIndex index;
+	ASSERT_TRUE(points != NULL);
+
+	index = spBoVWIndexCreate(points, BOVW_TESTS_SIZE, BOVW_TESTS_IMAGES,
+			BOVW_TESTS_BRANCHING, BOVW_TESTS_DEPTH, BOVW_TESTS_SIZE);
+	ASSERT_TRUE(index != NULL);
+	free(points);
+
+	similarImages = spBoVWIndexSimilarImages(index, NULL, 0, BOVW_TESTS_IMAGES / 2);
+	ASSERT_TRUE(similarImages != NULL);
+	for (i = 0; i < BOVW_TESTS_IMAGES / 2; i++)
+		ASSERT_TRUE(similarImages[i] == i);
+
+	free(similarImages);
+	spBoVWIndexDestroy(index);
+	return true;
+}
+
+void runBoVWIndexTests() {
+	int i;
+	srand(time(NULL));
+	RUN_TEST(bovwIndexInvalidArgumentsTest);
+	for (i = 0; i < BOVW_RANDOM_TESTS_COUNT; i++) {
+		RUN_TEST(bovwIndexVocabularyTest);
+		RUN_TEST(bovwIndexSelfRetrievalTest);
+		RUN_TEST(bovwIndexEmptyQueryTest);
+	}
+}
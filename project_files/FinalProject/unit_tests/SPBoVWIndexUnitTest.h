@@ -0,0 +1,8 @@
+#ifndef SPBOVWINDEXUNITTEST_H_
+#define SPBOVWINDEXUNITTEST_H_
+
+
+
+void runBoVWIndexTests();
+
+#endif /* SPBOVWINDEXUNITTEST_H_ */
@@ -0,0 +1,206 @@
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "unit_test_util.h"
+#include "SPBruteForceIndexUnitTest.h"
+#include "../data_structures/index_ds/SPBruteForceIndex.h"
+#include "../data_structures/kd_ds/SPKDTreeNode.h"
+#include "../data_structures/kd_ds/SPKDTreeNodeKNN.h"
+#include "SPKDArrayUnitTest.h"
+#include "SPBPQueueUnitTest.h"
+#include "../data_structures/bpqueue_ds/SPBPriorityQueue.h"
+#include "../SPPoint.h"
+
+#define BRUTE_TESTS_DIM						12
+#define BRUTE_TESTS_SIZE					3000 // more than one scan chunk per thread
+#define BRUTE_TESTS_SMALL_SIZE				100
+#define BRUTE_TESTS_K						7
+#define BRUTE_TESTS_THREADS					4
+#define BRUTE_TESTS_QUERIES					21 // not a multiple of the query block
+#define BRUTE_RANDOM_TESTS_COUNT			5
+
+/*
+ * Builds a brute force index and a KD-tree over the same random points, stored at the
+ * given precision, and verifies that both find the same neighbours
+ */
+static bool verifyKDTreeAgreement(int size, int numOfThreads,
+		SP_POINT_PRECISION precision) {
+	int i;
+	SPPoint *points, *copies, *queries;
+	spPointSetDefaultPrecision(precision);
+	points = generateRandomPointsArray(BRUTE_TESTS_DIM, size);
+	spPointSetDefaultPrecision(SP_POINT_PRECISION_DOUBLE);
+	copies = points == NULL ? NULL : copyPointsArray(points, size);
+	queries = generateRandomPointsArray(BRUTE_TESTS_DIM, BRUTE_TESTS_QUERIES);
+	SPBPQueue treeQueue = spBPQueueCreate(BRUTE_TESTS_K);
+	SPBPQueue indexQueue = spBPQueueCreate(BRUTE_TESTS_K);
+	SPBruteForceIndex index;
+	SPKDTreeNode tree;
+	ASSERT_TRUE(points != NULL && copies != NULL && queries != NULL &&
+			treeQueue != NULL && indexQueue != NULL);
+
+	tree = InitKDTreeFromPoints(copies, size, MAX_SPREAD);
+	ASSERT_TRUE(tree != NULL);
+	index = spBruteForceIndexCreate(points, size, numOfThreads);
+	ASSERT_TRUE(index != NULL);
+	free(points);
+
+	for (i = 0; i < BRUTE_TESTS_QUERIES; i++) {
+		ASSERT_TRUE(kNearestNeighbors(tree, treeQueue, queries[i]));
+		ASSERT_TRUE(spBruteForceIndexKNN(index, indexQueue, queries[i]));
+		ASSERT_TRUE(verifySameQueues(treeQueue, indexQueue));
+	}
+
+	spBruteForceIndexDestroy(index);
+	spKDTreeDestroy(tree, true);
+	free(copies);
+	destroyPointsArray(queries, BRUTE_TESTS_QUERIES);
+	spBPQueueDestroy(treeQueue);
+	spBPQueueDestroy(indexQueue);
+	return true;
+}
+
+//invalid arguments test
+static bool bruteForceIndexInvalidArgumentsTest() {
+	SPPoint* points = generateRandomPointsArray(BRUTE_TESTS_DIM, BRUTE_TESTS_SMALL_SIZE);
+	SPPoint queryPoint = generateRandomPoint(BRUTE_TESTS_DIM + 1, 0);
+	SPPoint validQuery = generateRandomPoint(BRUTE_TESTS_DIM, 0);
+	SPPoint queries[2];
+	SPBPQueue queue = spBPQueueCreate(BRUTE_TESTS_K);
+	SPBPQueue queues[2];
+	SPBruteForceIndex index;
+	ASSERT_TRUE(points != NULL && queryPoint != NULL && validQuery != NULL &&
+			queue != NULL);
+
+	ASSERT_TRUE(spBruteForceIndexCreate(NULL, BRUTE_TESTS_SMALL_SIZE, 1) == NULL);
+	ASSERT_TRUE(spBruteForceIndexCreate(points, 0, 1) == NULL);
+	ASSERT_TRUE(spBruteForceIndexCreate(points, BRUTE_TESTS_SMALL_SIZE, 0) == NULL);
+	spBruteForceIndexDestroy(NULL);
+
+	// a failed creation does not take ownership, a successful one does
+	index = spBruteForceIndexCreate(points, BRUTE_TESTS_SMALL_SIZE, 1);
+	ASSERT_TRUE(index != NULL);
+	free(points);
+
+	// dimension mismatch
+	ASSERT_FALSE(spBruteForceIndexKNN(index, queue, queryPoint));
+	ASSERT_FALSE(spBruteForceIndexKNN(NULL, queue, validQuery));
+	ASSERT_FALSE(spBruteForceIndexKNN(index, NULL, validQuery));
+
+	// a single invalid query fails the whole batch
+	queries[0] = validQuery;
+	queries[1] = queryPoint;
+	queues[0] = queue;
+	queues[1] = queue;
+	ASSERT_FALSE(spBruteForceIndexKNNBatch(index, queues, queries, 2));
+	ASSERT_FALSE(spBruteForceIndexKNNBatch(index, queues, queries, 0));
+	ASSERT_TRUE(spBPQueueIsEmpty(queue));
+
+	spBruteForceIndexDestroy(index);
+	spPointDestroy(queryPoint);
+	spPointDestroy(validQuery);
+	spBPQueueDestroy(queue);
+	return true;
+}
+
+//a single scan thread finds the same neighbours as the KD-tree
+static bool bruteForceIndexSingleThreadTest() {
+	return verifyKDTreeAgreement(BRUTE_TESTS_SIZE, 1, SP_POINT_PRECISION_DOUBLE);
+}
+
+//several scan threads find the same neighbours as the KD-tree
+static bool bruteForceIndexMultiThreadTest() {
+	return verifyKDTreeAgreement(BRUTE_TESTS_SIZE, BRUTE_TESTS_THREADS,
+			SP_POINT_PRECISION_DOUBLE);
+}
+
+//a database smaller than a single row block
+static bool bruteForceIndexSmallDatabaseTest() {
+	return verifyKDTreeAgreement(BRUTE_TESTS_SMALL_SIZE, BRUTE_TESTS_THREADS,
+			SP_POINT_PRECISION_DOUBLE);
+}
+
+//a database stored as float or float16 finds the same neighbours as the KD-tree over it
+static bool bruteForceIndexReducedPrecisionTest() {
+	return verifyKDTreeAgreement(BRUTE_TESTS_SIZE, BRUTE_TESTS_THREADS,
+			SP_POINT_PRECISION_FLOAT) && verifyKDTreeAgreement(BRUTE_TESTS_SIZE,
+			BRUTE_TESTS_THREADS, SP_POINT_PRECISION_HALF);
+}
+
+//a batch search equals searching the queries one at a time, whatever the k of each query
+static bool bruteForceIndexBatchTest() {
+	int i;
+	bool rslt = true;
+	SPPoint* points = generateRandomPointsArray(BRUTE_TESTS_DIM, BRUTE_TESTS_SIZE);
+	SPPoint* queries = generateRandomPointsArray(BRUTE_TESTS_DIM, BRUTE_TESTS_QUERIES);
+	SPBPQueue batchQueues[BRUTE_TESTS_QUERIES], singleQueue;
+	SPBruteForceIndex index;
+	ASSERT_TRUE(points != NULL && queries != NULL);
+
+	index = spBruteForceIndexCreate(points, BRUTE_TESTS_SIZE, BRUTE_TESTS_THREADS);
+	ASSERT_TRUE(index != NULL);
+	free(points);
+
+	for (i = 0; i < BRUTE_TESTS_QUERIES; i++)
+		ASSERT_TRUE((batchQueues[i] = spBPQueueCreate(1 + i % BRUTE_TESTS_K)) != NULL);
+	ASSERT_TRUE(spBruteForceIndexKNNBatch(index, batchQueues, queries,
+			BRUTE_TESTS_QUERIES));
+
+	for (i = 0; i < BRUTE_TESTS_QUERIES; i++) {
+		ASSERT_TRUE((singleQueue = spBPQueueCreate(1 + i % BRUTE_TESTS_K)) != NULL);
+		ASSERT_TRUE(spBruteForceIndexKNN(index, singleQueue, queries[i]));
+		rslt = rslt && spBPQueueIsFull(batchQueues[i]) &&
+				verifySameQueues(batchQueues[i], singleQueue);
+		spBPQueueDestroy(singleQueue);
+		spBPQueueDestroy(batchQueues[i]);
+	}
+	ASSERT_TRUE(rslt);
+
+	spBruteForceIndexDestroy(index);
+	destroyPointsArray(queries, BRUTE_TESTS_QUERIES);
+	return true;
+}
+
+//a query that is a database point is its own nearest neighbour, at distance 0
+static bool bruteForceIndexSelfQueryTest() {
+	int i;
+	SPPoint* points = generateRandomPointsArray(BRUTE_TESTS_DIM, BRUTE_TESTS_SMALL_SIZE);
+	SPPoint* copies = points == NULL ? NULL : copyPointsArray(points,
+			BRUTE_TESTS_SMALL_SIZE);
+	SPBPQueue queue = spBPQueueCreate(1);
+	SPBruteForceIndex index;
+	ASSERT_TRUE(points != NULL && copies != NULL && queue != NULL);
+
+	index = spBruteForceIndexCreate(points, BRUTE_TESTS_SMALL_SIZE, 1);
+	ASSERT_TRUE(index != NULL);
+	free(points);
+
+	for (i = 0; i < BRUTE_TESTS_SMALL_SIZE; i++) {
+		ASSERT_TRUE(spBruteForceIndexKNN(index, queue, copies[i]));
+		ASSERT_TRUE(spBPQueueSize(queue) == 1);
+		ASSERT_TRUE(spBPQueueMinValue(queue) == 0);
+		ASSERT_TRUE(spBPQueueMaxValue(queue) == 0);
+		spBPQueueClear(queue);
+	}
+
+	spBruteForceIndexDestroy(index);
+	destroyPointsArray(copies, BRUTE_TESTS_SMALL_SIZE);
+	spBPQueueDestroy(queue);
+	return true;
+}
+
+void runBruteForceIndexTests() {
+	int i;
+	srand(time(NULL));
+	RUN_TEST(bruteForceIndexInvalidArgumentsTest);
+	RUN_TEST(bruteForceIndexSelfQueryTest);
+	for (i = 0; i < BRUTE_RANDOM_TESTS_COUNT; i++) {
+		RUN_TEST(bruteForceIndexSingleThreadTest);
+		RUN_TEST(bruteForceIndexMultiThreadTest);
+		RUN_TEST(bruteForceIndexSmallDatabaseTest);
+		RUN_TEST(bruteForceIndexReducedPrecisionTest);
+		RUN_TEST(bruteForceIndexBatchTest);
+	}
+}
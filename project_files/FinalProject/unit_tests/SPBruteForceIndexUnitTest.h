@@ -0,0 +1,8 @@
+#ifndef SPBRUTEFORCEINDEXUNITTEST_H_
+#define SPBRUTEFORCEINDEXUNITTEST_H_
+
+
+
+void runBruteForceIndexTests();
+
+#endif /* SPBRUTEFORCEINDEXUNITTEST_H_ */
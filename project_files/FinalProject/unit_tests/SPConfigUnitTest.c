@@ -6,7 +6,7 @@
 #include "stdlib.h"
 
 bool testGivenConfFile() {
-	char imagePath[100], pcaPath[100];
+	char imagePath[100], pcaPath[100], manifestPath[100];
 	SP_CONFIG_MSG msg = SP_CONFIG_SUCCESS;
 	SPConfig config = spConfigCreate("./unit_tests/spcbirTestCase1.config", &msg);
 
@@ -114,6 +114,17 @@ bool testGivenConfFile() {
 	ASSERT_TRUE(spConfigGetPCAPath(pcaPath, NULL) == SP_CONFIG_INVALID_ARGUMENT);
 	ASSERT_TRUE(spConfigGetPCAPath(NULL, NULL) == SP_CONFIG_INVALID_ARGUMENT);
 
+	ASSERT_TRUE(!strcmp(spConfigGetManifestFilename(config, &msg), "features.manifest"));
+	ASSERT_TRUE(msg == SP_CONFIG_SUCCESS);
+	ASSERT_TRUE(spConfigGetManifestPath(manifestPath, config) == SP_CONFIG_SUCCESS);
+	ASSERT_TRUE(!strcmp(manifestPath, "./images/features.manifest"));
+	ASSERT_TRUE(spConfigGetManifestPath(NULL, config) == SP_CONFIG_INVALID_ARGUMENT);
+	ASSERT_TRUE(spConfigGetManifestPath(manifestPath, NULL) == SP_CONFIG_INVALID_ARGUMENT);
+
+	ASSERT_TRUE(spConfigSetExtractionMode(config, false) == SP_CONFIG_SUCCESS);
+	ASSERT_TRUE(spConfigIsExtractionMode(config, &msg) == false);
+	ASSERT_TRUE(spConfigSetExtractionMode(NULL, true) == SP_CONFIG_INVALID_ARGUMENT);
+
 	spConfigDestroy(config);
 
 	return true;
@@ -223,6 +234,18 @@ bool testDefault() {
 	ASSERT_TRUE(spConfigGetImagesPrefix(config, &msg) == NULL);
 	ASSERT_TRUE(spConfigGetImagesSuffix(config, &msg) == NULL);
 	ASSERT_TRUE(spConfigGetNumOfImages(config, &msg) == 0);
+	ASSERT_TRUE(spConfigGetNumOfShards(config, &msg) == 1);
+	ASSERT_TRUE(spConfigGetLoadThreads(config, &msg) == 1);
+	ASSERT_TRUE(spConfigGetSaveThreads(config, &msg) == 1);
+	ASSERT_TRUE(spConfigGetQueryCacheSize(config, &msg) == 16);
+	ASSERT_TRUE(spConfigGetQueryCacheDirectory(config, &msg) == NULL);
+	ASSERT_TRUE(spConfigGetMaxImageDimension(config, &msg) == 0);
+	ASSERT_TRUE(spConfigGetDetectionTileSize(config, &msg) == 0);
+	ASSERT_TRUE(spConfigGetDetectionTileOverlap(config, &msg) == 32);
+	ASSERT_TRUE(spConfigGetDetectionThreads(config, &msg) == 4);
+	ASSERT_TRUE(spConfigGetQueryDeadline(config, &msg) == 0);
+	ASSERT_FALSE(spConfigIsLoggerAsync(config, &msg));
+	ASSERT_TRUE(spConfigGetInstrumentationFilename(config, &msg) == NULL);
 
 	ASSERT_TRUE(parameterSetCheck(config, &msg, "a", 1, NULL) == NULL);
 	ASSERT_TRUE(msg == SP_CONFIG_MISSING_DIR);
@@ -297,6 +320,7 @@ bool testDefault() {
 bool testHandler() {
 	SPConfig config = (SPConfig)calloc(1, spConfigGetConfigStructSize());
 	SP_CONFIG_MSG msg = SP_CONFIG_SUCCESS;
+	char hnswPath[100], *signature = NULL;
 
 	ASSERT_TRUE(config != NULL);
 
@@ -373,6 +397,18 @@ bool testHandler() {
 	ASSERT_TRUE(msg == SP_CONFIG_INVALID_BOOLEAN);
 	msg = SP_CONFIG_SUCCESS;
 
+	ASSERT_FALSE(handleVariable(config, "a", 1, "spIndexType", "kd_tree", &msg));
+	ASSERT_TRUE(msg == SP_CONFIG_INVALID_INDEX_TYPE);
+	msg = SP_CONFIG_SUCCESS;
+
+	ASSERT_FALSE(handleVariable(config, "a", 1, "spPQCentroids", "257", &msg));
+	ASSERT_TRUE(msg == SP_CONFIG_INVALID_INTEGER);
+	msg = SP_CONFIG_SUCCESS;
+
+	ASSERT_FALSE(handleVariable(config, "a", 1, "spPQReRank", "-1", &msg));
+	ASSERT_TRUE(msg == SP_CONFIG_INVALID_INTEGER);
+	msg = SP_CONFIG_SUCCESS;
+
 	ASSERT_TRUE(handleVariable(config, "a", 1, "spImagesDirectory", "C:\\Documents\\",
 			&msg));
 	ASSERT_TRUE(msg == SP_CONFIG_SUCCESS);
@@ -403,6 +439,172 @@ bool testHandler() {
 	ASSERT_TRUE(msg == SP_CONFIG_SUCCESS);
 	ASSERT_TRUE(spConfigGetSplitMethod(config, &msg) == INCREMENTAL);
 
+	ASSERT_TRUE(handleVariable(config, "a", 1, "spIndexType", "PQ", &msg));
+	ASSERT_TRUE(msg == SP_CONFIG_SUCCESS);
+	ASSERT_TRUE(spConfigGetIndexType(config, &msg) == SP_INDEX_PQ);
+
+	ASSERT_TRUE(handleVariable(config, "a", 1, "spPQCentroids", "256", &msg));
+	ASSERT_TRUE(msg == SP_CONFIG_SUCCESS);
+	ASSERT_TRUE(spConfigGetPQCentroids(config, &msg) == 256);
+
+	ASSERT_TRUE(handleVariable(config, "a", 1, "spPQReRank", "0", &msg));
+	ASSERT_TRUE(msg == SP_CONFIG_SUCCESS);
+	ASSERT_TRUE(spConfigGetPQReRank(config, &msg) == 0);
+
+	ASSERT_TRUE(handleVariable(config, "a", 1, "spIndexType", "IVF", &msg));
+	ASSERT_TRUE(msg == SP_CONFIG_SUCCESS);
+	ASSERT_TRUE(spConfigGetIndexType(config, &msg) == SP_INDEX_IVF);
+
+	ASSERT_TRUE(handleVariable(config, "a", 1, "spIVFProbes", "16", &msg));
+	ASSERT_TRUE(msg == SP_CONFIG_SUCCESS);
+	ASSERT_TRUE(spConfigGetIVFProbes(config, &msg) == 16);
+
+	ASSERT_TRUE(handleVariable(config, "a", 1, "spIndexType", "HNSW", &msg));
+	ASSERT_TRUE(msg == SP_CONFIG_SUCCESS);
+	ASSERT_TRUE(spConfigGetIndexType(config, &msg) == SP_INDEX_HNSW);
+
+	ASSERT_TRUE(handleVariable(config, "a", 1, "spHNSWM", "12", &msg));
+	ASSERT_TRUE(msg == SP_CONFIG_SUCCESS);
+	ASSERT_TRUE(spConfigGetHNSWM(config, &msg) == 12);
+
+	ASSERT_FALSE(handleVariable(config, "a", 1, "spHNSWM", "1", &msg));
+	ASSERT_TRUE(msg == SP_CONFIG_INVALID_INTEGER);
+	ASSERT_TRUE(spConfigGetHNSWM(config, &msg) == 12);
+
+	ASSERT_TRUE(handleVariable(config, "a", 1, "spHNSWBuildThreads", "4", &msg));
+	ASSERT_TRUE(msg == SP_CONFIG_SUCCESS);
+	ASSERT_TRUE(spConfigGetHNSWBuildThreads(config, &msg) == 4);
+
+	ASSERT_TRUE(spConfigGetHNSWPath(hnswPath, config) == SP_CONFIG_INVALID_ARGUMENT);
+	ASSERT_TRUE(handleVariable(config, "a", 1, "spHNSWFilename", "hnsw.idx", &msg));
+	ASSERT_TRUE(msg == SP_CONFIG_SUCCESS);
+	ASSERT_TRUE(!strcmp(spConfigGetHNSWFilename(config, &msg), "hnsw.idx"));
+
+	ASSERT_TRUE(handleVariable(config, "a", 1, "spIndexType", "BOVW", &msg));
+	ASSERT_TRUE(msg == SP_CONFIG_SUCCESS);
+	ASSERT_TRUE(spConfigGetIndexType(config, &msg) == SP_INDEX_BOVW);
+
+	ASSERT_TRUE(handleVariable(config, "a", 1, "spBoVWBranching", "8", &msg));
+	ASSERT_TRUE(msg == SP_CONFIG_SUCCESS);
+	ASSERT_TRUE(spConfigGetBoVWBranching(config, &msg) == 8);
+
+	ASSERT_FALSE(handleVariable(config, "a", 1, "spBoVWBranching", "1", &msg));
+	ASSERT_TRUE(msg == SP_CONFIG_INVALID_INTEGER);
+	ASSERT_TRUE(spConfigGetBoVWBranching(config, &msg) == 8);
+
+	ASSERT_TRUE(handleVariable(config, "a", 1, "spBoVWDepth", "3", &msg));
+	ASSERT_TRUE(msg == SP_CONFIG_SUCCESS);
+	ASSERT_TRUE(spConfigGetBoVWDepth(config, &msg) == 3);
+
+	ASSERT_TRUE(handleVariable(config, "a", 1, "spIndexType", "BRUTE", &msg));
+	ASSERT_TRUE(msg == SP_CONFIG_SUCCESS);
+	ASSERT_TRUE(spConfigGetIndexType(config, &msg) == SP_INDEX_BRUTE_FORCE);
+
+	ASSERT_TRUE(handleVariable(config, "a", 1, "spBruteForceThreads", "8", &msg));
+	ASSERT_TRUE(msg == SP_CONFIG_SUCCESS);
+	ASSERT_TRUE(spConfigGetBruteForceThreads(config, &msg) == 8);
+
+	ASSERT_FALSE(handleVariable(config, "a", 1, "spBruteForceThreads", "0", &msg));
+	ASSERT_TRUE(msg == SP_CONFIG_INVALID_INTEGER);
+	ASSERT_TRUE(spConfigGetBruteForceThreads(config, &msg) == 8);
+
+	ASSERT_TRUE(handleVariable(config, "a", 1, "spNumOfShards", "4", &msg));
+	ASSERT_TRUE(msg == SP_CONFIG_SUCCESS);
+	ASSERT_TRUE(spConfigGetNumOfShards(config, &msg) == 4);
+
+	ASSERT_FALSE(handleVariable(config, "a", 1, "spNumOfShards", "65", &msg));
+	ASSERT_TRUE(msg == SP_CONFIG_INVALID_INTEGER);
+	ASSERT_TRUE(spConfigGetNumOfShards(config, &msg) == 4);
+
+	msg = SP_CONFIG_SUCCESS;
+	ASSERT_TRUE(handleVariable(config, "a", 1, "spLoadThreads", "16", &msg));
+	ASSERT_TRUE(msg == SP_CONFIG_SUCCESS);
+	ASSERT_TRUE(spConfigGetLoadThreads(config, &msg) == 16);
+
+	ASSERT_FALSE(handleVariable(config, "a", 1, "spLoadThreads", "0", &msg));
+	ASSERT_TRUE(msg == SP_CONFIG_INVALID_INTEGER);
+	ASSERT_TRUE(spConfigGetLoadThreads(config, &msg) == 16);
+
+	msg = SP_CONFIG_SUCCESS;
+	ASSERT_TRUE(handleVariable(config, "a", 1, "spSaveThreads", "4", &msg));
+	ASSERT_TRUE(msg == SP_CONFIG_SUCCESS);
+	ASSERT_TRUE(spConfigGetSaveThreads(config, &msg) == 4);
+
+	ASSERT_FALSE(handleVariable(config, "a", 1, "spSaveThreads", "65", &msg));
+	ASSERT_TRUE(msg == SP_CONFIG_INVALID_INTEGER);
+	ASSERT_TRUE(spConfigGetSaveThreads(config, &msg) == 4);
+
+	msg = SP_CONFIG_SUCCESS;
+	ASSERT_TRUE(handleVariable(config, "a", 1, "spManifestFilename", "db.manifest", &msg));
+	ASSERT_TRUE(msg == SP_CONFIG_SUCCESS);
+	ASSERT_TRUE(!strcmp(spConfigGetManifestFilename(config, &msg), "db.manifest"));
+
+	ASSERT_TRUE(handleVariable(config, "a", 1, "spQueryCacheSize", "0", &msg));
+	ASSERT_TRUE(msg == SP_CONFIG_SUCCESS);
+	ASSERT_TRUE(spConfigGetQueryCacheSize(config, &msg) == 0);
+
+	ASSERT_FALSE(handleVariable(config, "a", 1, "spQueryCacheSize", "4097", &msg));
+	ASSERT_TRUE(msg == SP_CONFIG_INVALID_INTEGER);
+	ASSERT_TRUE(spConfigGetQueryCacheSize(config, &msg) == 0);
+
+	msg = SP_CONFIG_SUCCESS;
+	ASSERT_TRUE(handleVariable(config, "a", 1, "spQueryCacheDirectory", "./cache/", &msg));
+	ASSERT_TRUE(msg == SP_CONFIG_SUCCESS);
+	ASSERT_TRUE(!strcmp(spConfigGetQueryCacheDirectory(config, &msg), "./cache/"));
+
+	ASSERT_TRUE((signature = getSignature(config)) != NULL);
+	ASSERT_TRUE(strstr(signature, "][640]==") == NULL);
+	free(signature);
+	ASSERT_TRUE(handleVariable(config, "a", 1, "spMaxImageDimension", "640", &msg));
+	ASSERT_TRUE(msg == SP_CONFIG_SUCCESS);
+	ASSERT_TRUE(spConfigGetMaxImageDimension(config, &msg) == 640);
+	ASSERT_TRUE((signature = getSignature(config)) != NULL);
+	ASSERT_TRUE(strstr(signature, "][640]==\n") != NULL);
+	free(signature);
+
+	ASSERT_FALSE(handleVariable(config, "a", 1, "spMaxImageDimension", "-1", &msg));
+	ASSERT_TRUE(msg == SP_CONFIG_INVALID_INTEGER);
+	ASSERT_TRUE(spConfigGetMaxImageDimension(config, &msg) == 640);
+	msg = SP_CONFIG_SUCCESS;
+
+	ASSERT_TRUE(handleVariable(config, "a", 1, "spDetectionTileSize", "1024", &msg));
+	ASSERT_TRUE(handleVariable(config, "a", 1, "spDetectionTileOverlap", "0", &msg));
+	ASSERT_TRUE(handleVariable(config, "a", 1, "spDetectionThreads", "8", &msg));
+	ASSERT_TRUE(msg == SP_CONFIG_SUCCESS);
+	ASSERT_TRUE(spConfigGetDetectionTileSize(config, &msg) == 1024);
+	ASSERT_TRUE(spConfigGetDetectionTileOverlap(config, &msg) == 0);
+	ASSERT_TRUE(spConfigGetDetectionThreads(config, &msg) == 8);
+
+	ASSERT_FALSE(handleVariable(config, "a", 1, "spDetectionThreads", "0", &msg));
+	ASSERT_TRUE(msg == SP_CONFIG_INVALID_INTEGER);
+	ASSERT_FALSE(handleVariable(config, "a", 1, "spDetectionTileOverlap", "1025", &msg));
+	ASSERT_TRUE(msg == SP_CONFIG_INVALID_INTEGER);
+	ASSERT_TRUE(spConfigGetDetectionThreads(config, &msg) == 8);
+	ASSERT_TRUE(spConfigGetDetectionTileOverlap(config, &msg) == 0);
+	msg = SP_CONFIG_SUCCESS;
+
+	ASSERT_TRUE(handleVariable(config, "a", 1, "spQueryDeadline", "250", &msg));
+	ASSERT_TRUE(msg == SP_CONFIG_SUCCESS);
+	ASSERT_TRUE(spConfigGetQueryDeadline(config, &msg) == 250);
+	ASSERT_FALSE(handleVariable(config, "a", 1, "spQueryDeadline", "-1", &msg));
+	ASSERT_TRUE(msg == SP_CONFIG_INVALID_INTEGER);
+	ASSERT_TRUE(spConfigGetQueryDeadline(config, &msg) == 250);
+	msg = SP_CONFIG_SUCCESS;
+
+	ASSERT_TRUE(handleVariable(config, "a", 1, "spLoggerAsync", "true", &msg));
+	ASSERT_TRUE(msg == SP_CONFIG_SUCCESS);
+	ASSERT_TRUE(spConfigIsLoggerAsync(config, &msg));
+
+	ASSERT_FALSE(handleVariable(config, "a", 1, "spLoggerAsync", "yes", &msg));
+	ASSERT_TRUE(msg == SP_CONFIG_INVALID_BOOLEAN);
+	ASSERT_TRUE(spConfigIsLoggerAsync(config, &msg));
+
+	msg = SP_CONFIG_SUCCESS;
+	ASSERT_TRUE(handleVariable(config, "a", 1, "spInstrumentationFilename", "stats.json",
+			&msg));
+	ASSERT_TRUE(msg == SP_CONFIG_SUCCESS);
+	ASSERT_TRUE(!strcmp(spConfigGetInstrumentationFilename(config, &msg), "stats.json"));
+
 	spConfigDestroy(config);
 	return true;
 }
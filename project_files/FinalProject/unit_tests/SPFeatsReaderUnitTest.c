@@ -0,0 +1,251 @@
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "unit_test_util.h"
+#include "SPFeatsReaderUnitTest.h"
+#include "../SPPoint.h"
+#include "../image_parsing/SPImageData.h"
+#include "../image_parsing/SPImagesParser.h"
+#include "../image_parsing/SPFeatsReader.h"
+
+#define FEATS_READER_TESTS_FILE				"./unit_tests/featsReaderTest.feats"
+#define FEATS_READER_TESTS_SIGNATURE		"==[featsReaderTest][7][50][28]==\n"
+#define FEATS_READER_TESTS_INDEX			7
+#define FEATS_READER_TESTS_FEATURES			50
+#define FEATS_READER_TESTS_DIM				28
+#define FEATS_READER_TESTS_LONG_DIM			12000
+#define FEATS_READER_TESTS_NUMBERS			10000
+#define FEATS_READER_TESTS_MAX_NUMBER_LEN	512
+
+/*
+ * Returns a random coordinate in [-range,range]
+ */
+static double randomCoordinate(double range) {
+	return range * (2.0 * rand() / RAND_MAX - 1.0);
+}
+
+/*
+ * Creates an image data item with random features of the given dimension
+ */
+static SPImageData createRandomImageData(int numOfFeatures, int dim) {
+	int i, j;
+	double* data;
+	SPImageData imageData = createImageData(FEATS_READER_TESTS_INDEX);
+	if (imageData == NULL)
+		return NULL;
+	data = (double*) malloc(dim * sizeof(double));
+	imageData->featuresArray = (SPPoint*) calloc(numOfFeatures, sizeof(SPPoint));
+	if (data == NULL || imageData->featuresArray == NULL) {
+		free(data);
+		freeImageData(imageData, true, true);
+		return NULL;
+	}
+	imageData->numOfFeatures = numOfFeatures;
+	for (i = 0; i < numOfFeatures; i++) {
+		for (j = 0; j < dim; j++)
+			data[j] = randomCoordinate(500.0);
+		imageData->featuresArray[i] = spPointCreate(data, dim, FEATS_READER_TESTS_INDEX);
+	}
+	free(data);
+	return imageData;
+}
+
+/*
+ * Writes the image data to the test file with the test signature
+ */
+static bool writeTestFile(SPImageData imageData) {
+	SP_DP_MESSAGES msg;
+	FILE* file = fopen(FEATS_READER_TESTS_FILE, "w");
+	if (file == NULL)
+		return false;
+	msg = writeImageDataToFile(file, imageData, FEATS_READER_TESTS_SIGNATURE);
+	fclose(file);
+	return msg == SP_DP_SUCCESS;
+}
+
+/*
+ * Writes the given text to the test file
+ */
+static bool writeTestText(const char* text) {
+	FILE* file = fopen(FEATS_READER_TESTS_FILE, "w");
+	if (file == NULL)
+		return false;
+	fputs(text, file);
+	fclose(file);
+	return true;
+}
+
+/*
+ * Returns true if both image data items have exactly the same features
+ */
+static bool identicalFeatures(SPImageData first, SPImageData second) {
+	int i, j;
+	if (first->numOfFeatures != second->numOfFeatures)
+		return false;
+	for (i = 0; i < first->numOfFeatures; i++) {
+		if (spPointGetDimension(first->featuresArray[i]) !=
+				spPointGetDimension(second->featuresArray[i]) ||
+				spPointGetIndex(first->featuresArray[i]) !=
+				spPointGetIndex(second->featuresArray[i]))
+			return false;
+		for (j = 0; j < spPointGetDimension(first->featuresArray[i]); j++)
+			if (spPointGetAxisCoor(first->featuresArray[i], j) !=
+					spPointGetAxisCoor(second->featuresArray[i], j))
+				return false;
+	}
+	return true;
+}
+
+/*
+ * Returns the result of spFeatsReaderLoad of the test file, and checks that a failure
+ * leaves no features
+ */
+static SP_DP_MESSAGES loadTestFile(int index) {
+	SP_DP_MESSAGES msg;
+	SPImageData imageData = createImageData(index);
+	if (imageData == NULL)
+		return SP_DP_MEMORY_FAILURE;
+	msg = spFeatsReaderLoad(FEATS_READER_TESTS_SIGNATURE, FEATS_READER_TESTS_FILE, imageData);
+	if (msg != SP_DP_SUCCESS && (imageData->featuresArray != NULL ||
+			imageData->numOfFeatures != 0))
+		msg = SP_DP_SUCCESS; // reported as an unexpected success
+	freeImageData(imageData, true, true);
+	return msg;
+}
+
+static bool featsReaderParseNumberTest() {
+	int i;
+	double value;
+	char number[FEATS_READER_TESTS_MAX_NUMBER_LEN];
+	const char* end;
+
+	end = spFeatsReaderParseNumber("-12.500000,", &value);
+	ASSERT_TRUE(end != NULL && *end == ',' && value == -12.5);
+	end = spFeatsReaderParseNumber("13413\n", &value);
+	ASSERT_TRUE(end != NULL && *end == '\n' && value == 13413.0);
+	end = spFeatsReaderParseNumber("0.000000", &value);
+	ASSERT_TRUE(end != NULL && *end == '\0' && value == 0.0);
+	ASSERT_TRUE(spFeatsReaderParseNumber("abc", &value) == NULL);
+	ASSERT_TRUE(spFeatsReaderParseNumber("-,", &value) == NULL);
+	ASSERT_TRUE(spFeatsReaderParseNumber(".5", &value) == NULL);
+
+	// the values of "%f" numbers, and of longer numbers, are the ones of strtod
+	for (i = 0; i < FEATS_READER_TESTS_NUMBERS; i++) {
+		sprintf(number, "%f", randomCoordinate(i % 2 == 0 ? 1000.0 : 1e12));
+		end = spFeatsReaderParseNumber(number, &value);
+		ASSERT_TRUE(end == number + strlen(number));
+		ASSERT_TRUE(value == strtod(number, NULL));
+	}
+	sprintf(number, "%f", 1e300);
+	end = spFeatsReaderParseNumber(number, &value);
+	ASSERT_TRUE(end == number + strlen(number) && value == strtod(number, NULL));
+	sprintf(number, "-%s", "0.1234567890123456789012345678901234567890");
+	end = spFeatsReaderParseNumber(number, &value);
+	ASSERT_TRUE(end == number + strlen(number) && value == strtod(number, NULL));
+	return true;
+}
+
+/*
+ * Writes the image data to the test file, and checks that the reader loads the same
+ * features from it as the getLine based loader
+ */
+static bool writeAndLoadTest(SPImageData expected) {
+	bool isIdentical;
+	FILE* file;
+	SPImageData loaded, legacy;
+
+	if (!writeTestFile(expected))
+		return false;
+	loaded = createImageData(FEATS_READER_TESTS_INDEX);
+	legacy = createImageData(FEATS_READER_TESTS_INDEX);
+	file = fopen(FEATS_READER_TESTS_FILE, "r");
+	isIdentical = loaded != NULL && legacy != NULL && file != NULL &&
+			spFeatsReaderLoad(FEATS_READER_TESTS_SIGNATURE, FEATS_READER_TESTS_FILE,
+					loaded) == SP_DP_SUCCESS &&
+			loadImageDataFromFile(FEATS_READER_TESTS_SIGNATURE, file, legacy) == SP_DP_SUCCESS &&
+			loaded->numOfFeatures == expected->numOfFeatures &&
+			identicalFeatures(loaded, legacy);
+	if (file != NULL)
+		fclose(file);
+	freeImageData(loaded, true, true);
+	freeImageData(legacy, true, true);
+	remove(FEATS_READER_TESTS_FILE);
+	return isIdentical;
+}
+
+static bool featsReaderLoadTest() {
+	SPImageData expected = createRandomImageData(FEATS_READER_TESTS_FEATURES,
+			FEATS_READER_TESTS_DIM);
+	ASSERT_TRUE(expected != NULL);
+	ASSERT_TRUE(writeAndLoadTest(expected));
+	freeImageData(expected, true, true);
+	return true;
+}
+
+static bool featsReaderLongLineTest() {
+	// feature lines that are longer than the initial buffer
+	SPImageData expected = createRandomImageData(2, FEATS_READER_TESTS_LONG_DIM);
+	ASSERT_TRUE(expected != NULL);
+	ASSERT_TRUE(writeAndLoadTest(expected));
+	freeImageData(expected, true, true);
+	return true;
+}
+
+static bool featsReaderNoNewLineTest() {
+	ASSERT_TRUE(writeTestText(FEATS_READER_TESTS_SIGNATURE "7,2\n2,1.5,2.5\n1,-3.25"));
+	ASSERT_TRUE(loadTestFile(FEATS_READER_TESTS_INDEX) == SP_DP_SUCCESS);
+	remove(FEATS_READER_TESTS_FILE);
+	return true;
+}
+
+static bool featsReaderInvalidTest() {
+	SPImageData imageData = createImageData(FEATS_READER_TESTS_INDEX);
+	ASSERT_TRUE(imageData != NULL);
+	ASSERT_TRUE(spFeatsReaderLoad(NULL, FEATS_READER_TESTS_FILE, imageData) ==
+			SP_DP_INVALID_ARGUMENT);
+	ASSERT_TRUE(spFeatsReaderLoad(FEATS_READER_TESTS_SIGNATURE, NULL, imageData) ==
+			SP_DP_INVALID_ARGUMENT);
+	ASSERT_TRUE(spFeatsReaderLoad(FEATS_READER_TESTS_SIGNATURE, FEATS_READER_TESTS_FILE,
+			NULL) == SP_DP_INVALID_ARGUMENT);
+	freeImageData(imageData, true, true);
+
+	remove(FEATS_READER_TESTS_FILE);
+	ASSERT_TRUE(loadTestFile(FEATS_READER_TESTS_INDEX) == SP_DP_FILE_READ_ERROR);
+
+	// another signature
+	ASSERT_TRUE(writeTestText("==[other][7][50][28]==\n7,1\n2,1.5,2.5\n"));
+	ASSERT_TRUE(loadTestFile(FEATS_READER_TESTS_INDEX) == SP_DP_FORMAT_ERROR);
+
+	// another image index
+	ASSERT_TRUE(writeTestText(FEATS_READER_TESTS_SIGNATURE "7,1\n2,1.5,2.5\n"));
+	ASSERT_TRUE(loadTestFile(FEATS_READER_TESTS_INDEX + 1) == SP_DP_FORMAT_ERROR);
+
+	// less features than the header says
+	ASSERT_TRUE(writeTestText(FEATS_READER_TESTS_SIGNATURE "7,3\n2,1.5,2.5\n2,1.0,2.0\n"));
+	ASSERT_TRUE(loadTestFile(FEATS_READER_TESTS_INDEX) == SP_DP_FORMAT_ERROR);
+
+	// too few and too many coordinates
+	ASSERT_TRUE(writeTestText(FEATS_READER_TESTS_SIGNATURE "7,1\n3,1.5,2.5\n"));
+	ASSERT_TRUE(loadTestFile(FEATS_READER_TESTS_INDEX) == SP_DP_FORMAT_ERROR);
+	ASSERT_TRUE(writeTestText(FEATS_READER_TESTS_SIGNATURE "7,1\n1,1.5,2.5\n"));
+	ASSERT_TRUE(loadTestFile(FEATS_READER_TESTS_INDEX) == SP_DP_FORMAT_ERROR);
+
+	// a bad number and a bad dimension
+	ASSERT_TRUE(writeTestText(FEATS_READER_TESTS_SIGNATURE "7,1\n2,1.5,abc\n"));
+	ASSERT_TRUE(loadTestFile(FEATS_READER_TESTS_INDEX) == SP_DP_FORMAT_ERROR);
+	ASSERT_TRUE(writeTestText(FEATS_READER_TESTS_SIGNATURE "7,1\n0\n"));
+	ASSERT_TRUE(loadTestFile(FEATS_READER_TESTS_INDEX) == SP_DP_FORMAT_ERROR);
+
+	remove(FEATS_READER_TESTS_FILE);
+	return true;
+}
+
+void runFeatsReaderTests() {
+	RUN_TEST(featsReaderParseNumberTest);
+	RUN_TEST(featsReaderLoadTest);
+	RUN_TEST(featsReaderLongLineTest);
+	RUN_TEST(featsReaderNoNewLineTest);
+	RUN_TEST(featsReaderInvalidTest);
+}
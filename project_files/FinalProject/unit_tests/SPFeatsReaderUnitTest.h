@@ -0,0 +1,8 @@
+#ifndef SPFEATSREADERUNITTEST_H_
+#define SPFEATSREADERUNITTEST_H_
+
+
+
+void runFeatsReaderTests();
+
+#endif /* SPFEATSREADERUNITTEST_H_ */
@@ -0,0 +1,232 @@
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "unit_test_util.h"
+#include "SPFeatsWriterUnitTest.h"
+#include "../SPPoint.h"
+#include "../SPConfig.h"
+#include "../image_parsing/SPImageData.h"
+#include "../image_parsing/SPImagesParser.h"
+#include "../image_parsing/SPFeatsReader.h"
+#include "../image_parsing/SPFeatsWriter.h"
+
+#define FEATS_WRITER_TESTS_FILE			"./unit_tests/featsWriterTest.feats"
+#define FEATS_WRITER_TESTS_TEMP_FILE	"./unit_tests/featsWriterTest.feats.tmp"
+#define FEATS_WRITER_TESTS_BAD_FILE		"./unit_tests/no_such_dir/featsWriterTest.feats"
+#define FEATS_WRITER_TESTS_SIGNATURE	"==[featsWriterTest][20][3][28]==\n"
+#define FEATS_WRITER_TESTS_CONFIG_FILE	"./unit_tests/featsWriterTest.config"
+#define FEATS_WRITER_TESTS_CONFIG		"spImagesDirectory = ./unit_tests/\nspImagesPrefix = writeTest\n" \
+										"spImagesSuffix = .png\nspNumOfImages = 20\nspSaveThreads = 3\n"
+#define FEATS_WRITER_TESTS_NUM_OF_IMAGES	20
+#define FEATS_WRITER_TESTS_FEATURES		3
+#define FEATS_WRITER_TESTS_DIM			28
+#define FEATS_WRITER_TESTS_MAX_LEN		4096
+#define FEATS_WRITER_TESTS_PATH_LEN		64
+
+/*
+ * Creates an image data item with numOfFeatures features whose coordinates depend on the
+ * index, if isBad the last feature is NULL
+ */
+static SPImageData createTestImageData(int index, int numOfFeatures, bool isBad) {
+	double data[FEATS_WRITER_TESTS_DIM];
+	SPImageData imageData;
+	int i, j;
+
+	if ((imageData = createImageData(index)) == NULL)
+		return NULL;
+	if ((imageData->featuresArray = (SPPoint*) calloc(numOfFeatures, sizeof(SPPoint))) == NULL) {
+		freeImageData(imageData, true, true);
+		return NULL;
+	}
+	imageData->numOfFeatures = numOfFeatures;
+	for (i = 0; i < numOfFeatures - (isBad ? 1 : 0); i++) {
+		for (j = 0; j < FEATS_WRITER_TESTS_DIM; j++)
+			data[j] = index * 1000.0 + i * 10.0 - j / 8.0;
+		imageData->featuresArray[i] = spPointCreate(data, FEATS_WRITER_TESTS_DIM, index);
+	}
+	return imageData;
+}
+
+/*
+ * Reads the whole file into buffer
+ */
+static bool readFile(const char* filename, char* buffer) {
+	size_t length;
+	FILE* file = fopen(filename, "r");
+	if (file == NULL)
+		return false;
+	length = fread(buffer, 1, FEATS_WRITER_TESTS_MAX_LEN - 1, file);
+	buffer[length] = '\0';
+	fclose(file);
+	return true;
+}
+
+/*
+ * Returns true if the .feats file has the features of the image data
+ */
+static bool isSaved(const char* signature, const char* filename, SPImageData expected) {
+	bool successFlag;
+	int i;
+	SPImageData loaded = createImageData(expected->index);
+	if (loaded == NULL)
+		return false;
+	successFlag = spFeatsReaderLoad(signature, filename, loaded) == SP_DP_SUCCESS &&
+			loaded->numOfFeatures == expected->numOfFeatures;
+	for (i = 0; successFlag && i < loaded->numOfFeatures; i++)
+		successFlag = spPointL2SquaredDistance(loaded->featuresArray[i],
+				expected->featuresArray[i]) == 0;
+	freeImageData(loaded, true, true);
+	return successFlag;
+}
+
+static bool featsWriterSerializeTest() {
+	double data1[] = {1, 3, 5, 4};
+	double data2[] = {4, 5.5, 13413, 92, 1};
+	double data3[] = {0, 0, 0};
+	SPPoint points[3];
+	struct sp_image_data imageData;
+	SP_DP_MESSAGES msg;
+	size_t length;
+	char* content;
+	char expected[FEATS_WRITER_TESTS_MAX_LEN];
+
+	// the same content as the legacy test file
+	points[0] = spPointCreate(data1, 4, 5);
+	points[1] = spPointCreate(data2, 5, 5);
+	points[2] = spPointCreate(data3, 3, 5);
+	imageData.index = 5;
+	imageData.numOfFeatures = 3;
+	imageData.featuresArray = points;
+	ASSERT_TRUE(readFile("./unit_tests/images/test1.feats", expected));
+	content = spFeatsWriterSerialize("==[./unit_tests/images/img21.png][22][100][20]==\n",
+			&imageData, &length, &msg);
+	ASSERT_TRUE(content != NULL && msg == SP_DP_SUCCESS);
+	ASSERT_TRUE(length == strlen(content) && !strcmp(content, expected));
+	free(content);
+
+	// a NULL feature
+	spPointDestroy(points[2]);
+	points[2] = NULL;
+	ASSERT_TRUE(spFeatsWriterSerialize(FEATS_WRITER_TESTS_SIGNATURE, &imageData, &length,
+			&msg) == NULL);
+	ASSERT_TRUE(msg == SP_DP_INVALID_ARGUMENT);
+
+	// no features
+	imageData.numOfFeatures = 0;
+	imageData.featuresArray = NULL;
+	content = spFeatsWriterSerialize(FEATS_WRITER_TESTS_SIGNATURE, &imageData, &length, &msg);
+	ASSERT_TRUE(content != NULL && !strcmp(content, FEATS_WRITER_TESTS_SIGNATURE "5,0\n"));
+	free(content);
+
+	spPointDestroy(points[0]);
+	spPointDestroy(points[1]);
+	return true;
+}
+
+static bool featsWriterSaveTest() {
+	SPImageData imageData = createTestImageData(7, FEATS_WRITER_TESTS_FEATURES, false);
+	SPImageData badImageData = createTestImageData(7, FEATS_WRITER_TESTS_FEATURES, true);
+	ASSERT_TRUE(imageData != NULL && badImageData != NULL);
+
+	ASSERT_TRUE(spFeatsWriterSave(FEATS_WRITER_TESTS_SIGNATURE, FEATS_WRITER_TESTS_FILE,
+			imageData) == SP_DP_SUCCESS);
+	ASSERT_TRUE(isSaved(FEATS_WRITER_TESTS_SIGNATURE, FEATS_WRITER_TESTS_FILE, imageData));
+	ASSERT_TRUE(access(FEATS_WRITER_TESTS_TEMP_FILE, F_OK) != 0);
+
+	// a failed save leaves the old file and no temporary file
+	ASSERT_TRUE(spFeatsWriterSave(FEATS_WRITER_TESTS_SIGNATURE, FEATS_WRITER_TESTS_FILE,
+			badImageData) == SP_DP_INVALID_ARGUMENT);
+	ASSERT_TRUE(isSaved(FEATS_WRITER_TESTS_SIGNATURE, FEATS_WRITER_TESTS_FILE, imageData));
+	ASSERT_TRUE(access(FEATS_WRITER_TESTS_TEMP_FILE, F_OK) != 0);
+	ASSERT_TRUE(spFeatsWriterSave(FEATS_WRITER_TESTS_SIGNATURE, FEATS_WRITER_TESTS_BAD_FILE,
+			imageData) == SP_DP_FILE_WRITE_ERROR);
+
+	remove(FEATS_WRITER_TESTS_FILE);
+	freeImageData(imageData, true, true);
+	freeImageData(badImageData, true, true);
+	return true;
+}
+
+/*
+ * Saves the test images by a writer, where numOfBad of them cannot be saved, and checks
+ * the result of spFeatsWriterFinish with the given budget
+ */
+static bool writeTestImages(SPConfig config, char* signature, int numOfBad,
+		int maxFailsAllowed, SP_DP_MESSAGES expected) {
+	SPImageData allImagesData[FEATS_WRITER_TESTS_NUM_OF_IMAGES];
+	char path[FEATS_WRITER_TESTS_PATH_LEN];
+	SPFeatsWriter writer;
+	bool isBad, successFlag = true;
+	int i;
+
+	if ((writer = spFeatsWriterCreate(config, NULL)) == NULL)
+		return false;
+	for (i = 0; i < FEATS_WRITER_TESTS_NUM_OF_IMAGES; i++) {
+		isBad = i % 4 == 2 && i / 4 < numOfBad;
+		successFlag &= (allImagesData[i] = createTestImageData(i,
+				FEATS_WRITER_TESTS_FEATURES, isBad)) != NULL;
+		successFlag &= spFeatsWriterSubmit(writer, allImagesData[i]) == SP_DP_SUCCESS;
+	}
+	successFlag &= spFeatsWriterFinish(writer, maxFailsAllowed) == expected;
+	successFlag &= spFeatsWriterFinish(writer, maxFailsAllowed) == expected;
+	successFlag &= spFeatsWriterSubmit(writer, allImagesData[0]) == SP_DP_INVALID_ARGUMENT;
+	spFeatsWriterDestroy(writer);
+
+	for (i = 0; i < FEATS_WRITER_TESTS_NUM_OF_IMAGES; i++) {
+		isBad = i % 4 == 2 && i / 4 < numOfBad;
+		spConfigGetImagePathFeats(path, config, i, true);
+		successFlag &= isBad || isSaved(signature, path, allImagesData[i]);
+		remove(path);
+		freeImageData(allImagesData[i], true, true);
+	}
+	return successFlag;
+}
+
+static bool featsWriterPoolTest() {
+	SP_CONFIG_MSG configMsg = SP_CONFIG_SUCCESS;
+	SPImageData allImagesData[FEATS_WRITER_TESTS_NUM_OF_IMAGES];
+	char path[FEATS_WRITER_TESTS_PATH_LEN];
+	char* signature;
+	SPConfig config;
+	FILE* file;
+	int i;
+
+	file = fopen(FEATS_WRITER_TESTS_CONFIG_FILE, "w");
+	ASSERT_TRUE(file != NULL);
+	fputs(FEATS_WRITER_TESTS_CONFIG, file);
+	fclose(file);
+	config = spConfigCreate(FEATS_WRITER_TESTS_CONFIG_FILE, &configMsg);
+	ASSERT_TRUE(config != NULL && spConfigGetSaveThreads(config, &configMsg) == 3);
+	signature = getSignature(config);
+	ASSERT_TRUE(signature != NULL);
+
+	ASSERT_TRUE(writeTestImages(config, signature, 0, 0, SP_DP_SUCCESS));
+	ASSERT_TRUE(writeTestImages(config, signature, 4, 4, SP_DP_SUCCESS));
+	ASSERT_TRUE(writeTestImages(config, signature, 5, 4, SP_DP_INVALID_ARGUMENT));
+
+	// saveAllImagesData saves through a writer too
+	for (i = 0; i < FEATS_WRITER_TESTS_NUM_OF_IMAGES; i++)
+		ASSERT_TRUE((allImagesData[i] = createTestImageData(i, 1, false)) != NULL);
+	ASSERT_TRUE(saveAllImagesData(config, signature, allImagesData) == SP_DP_SUCCESS);
+	for (i = 0; i < FEATS_WRITER_TESTS_NUM_OF_IMAGES; i++) {
+		spConfigGetImagePathFeats(path, config, i, true);
+		ASSERT_TRUE(isSaved(signature, path, allImagesData[i]));
+		remove(path);
+		freeImageData(allImagesData[i], true, true);
+	}
+
+	spFeatsWriterDestroy(NULL);
+	remove(FEATS_WRITER_TESTS_CONFIG_FILE);
+	free(signature);
+	spConfigDestroy(config);
+	return true;
+}
+
+void runFeatsWriterTests() {
+	RUN_TEST(featsWriterSerializeTest);
+	RUN_TEST(featsWriterSaveTest);
+	RUN_TEST(featsWriterPoolTest);
+}
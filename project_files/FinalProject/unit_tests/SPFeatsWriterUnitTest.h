@@ -0,0 +1,8 @@
+#ifndef SPFEATSWRITERUNITTEST_H_
+#define SPFEATSWRITERUNITTEST_H_
+
+
+
+void runFeatsWriterTests();
+
+#endif /* SPFEATSWRITERUNITTEST_H_ */
@@ -0,0 +1,227 @@
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "unit_test_util.h"
+#include "SPHNSWIndexUnitTest.h"
+#include "../data_structures/index_ds/SPHNSWIndex.h"
+#include "SPKDArrayUnitTest.h"
+#include "SPKDTreeNodeKNNUnitTest.h"
+#include "../data_structures/bpqueue_ds/SPBPriorityQueue.h"
+#include "../SPPoint.h"
+#include "../general_utils/SPUtils.h"
+
+#define HNSW_TESTS_DIM						10
+#define HNSW_TESTS_SIZE						300
+#define HNSW_TESTS_K						6
+#define HNSW_TESTS_M						8
+#define HNSW_TESTS_THREADS					4
+#define HNSW_TESTS_QUERIES					10
+#define HNSW_TESTS_FILE						"./unit_tests/hnswTest.idx"
+#define HNSW_RANDOM_TESTS_COUNT				5
+
+/*
+ * Computes the exact nearest neighbours of every query before the index takes
+ * ownership of the points
+ */
+static bool getExpectedResults(SPPoint* points, SPPoint* queries,
+		int expected[][HNSW_TESTS_K]) {
+	int i;
+	for (i = 0; i < HNSW_TESTS_QUERIES; i++) {
+		if (!getExactKNN(points, HNSW_TESTS_SIZE, queries[i], HNSW_TESTS_K, expected[i]))
+			return false;
+	}
+	return true;
+}
+
+/*
+ * Returns true iff the index search equals the exact search for all the queries
+ */
+static bool verifyQueries(SPHNSWIndex index, SPPoint* queries,
+		int expected[][HNSW_TESTS_K]) {
+	int i;
+	SPBPQueue queue = spBPQueueCreate(HNSW_TESTS_K);
+	ASSERT_TRUE(queue != NULL);
+	for (i = 0; i < HNSW_TESTS_QUERIES; i++) {
+		ASSERT_TRUE(spHNSWIndexKNN(index, queue, queries[i]));
+		ASSERT_TRUE(verifyQueueOrder(queue, expected[i], HNSW_TESTS_K));
+	}
+	spBPQueueDestroy(queue);
+	return true;
+}
+
+/*
+ * Builds an index over random points stored at the given precision, and verifies that
+ * the search equals the exact search. The candidates lists cover the whole database,
+ * so the search is exhaustive over the (connected) graph.
+ */
+static bool verifyExactHNSWSearch(int numOfThreads, SP_POINT_PRECISION precision) {
+	int expected[HNSW_TESTS_QUERIES][HNSW_TESTS_K];
+	SPHNSWIndex index;
+	SPPoint* points;
+	SPPoint* queries = generateRandomPointsArray(HNSW_TESTS_DIM, HNSW_TESTS_QUERIES);
+	spPointSetDefaultPrecision(precision);
+	points = generateRandomPointsArray(HNSW_TESTS_DIM, HNSW_TESTS_SIZE);
+	spPointSetDefaultPrecision(SP_POINT_PRECISION_DOUBLE);
+	ASSERT_TRUE(points != NULL && queries != NULL);
+	ASSERT_TRUE(getExpectedResults(points, queries, expected));
+
+	index = spHNSWIndexCreate(points, HNSW_TESTS_SIZE, HNSW_TESTS_M, HNSW_TESTS_SIZE,
+			HNSW_TESTS_SIZE, numOfThreads);
+	ASSERT_TRUE(index != NULL);
+	free(points);
+
+	ASSERT_TRUE(verifyQueries(index, queries, expected));
+
+	spHNSWIndexDestroy(index);
+	destroyPointsArray(queries, HNSW_TESTS_QUERIES);
+	return true;
+}
+
+//invalid arguments test
+static bool hnswIndexInvalidArgumentsTest() {
+	SPPoint* points = generateRandomPointsArray(HNSW_TESTS_DIM, HNSW_TESTS_SIZE);
+	SPPoint queryPoint = generateRandomPoint(HNSW_TESTS_DIM + 1, 0);
+	SPBPQueue queue = spBPQueueCreate(HNSW_TESTS_K);
+	SPHNSWIndex index;
+	ASSERT_TRUE(points != NULL && queryPoint != NULL && queue != NULL);
+
+	ASSERT_TRUE(spHNSWIndexCreate(NULL, HNSW_TESTS_SIZE, 2, 1, 1, 1) == NULL);
+	ASSERT_TRUE(spHNSWIndexCreate(points, 0, 2, 1, 1, 1) == NULL);
+	ASSERT_TRUE(spHNSWIndexCreate(points, HNSW_TESTS_SIZE, 1, 1, 1, 1) == NULL);
+	ASSERT_TRUE(spHNSWIndexCreate(points, HNSW_TESTS_SIZE, 2, 0, 1, 1) == NULL);
+	ASSERT_TRUE(spHNSWIndexCreate(points, HNSW_TESTS_SIZE, 2, 1, 0, 1) == NULL);
+	ASSERT_TRUE(spHNSWIndexCreate(points, HNSW_TESTS_SIZE, 2, 1, 1, 0) == NULL);
+	ASSERT_TRUE(spHNSWIndexLoad(NULL, points, HNSW_TESTS_SIZE, 2, 1, 1) == NULL);
+	spHNSWIndexDestroy(NULL);
+
+	// a failed creation does not take ownership, a successful one does
+	index = spHNSWIndexCreate(points, HNSW_TESTS_SIZE, HNSW_TESTS_M, HNSW_TESTS_K,
+			HNSW_TESTS_K, 1);
+	ASSERT_TRUE(index != NULL);
+	free(points);
+
+	// dimension mismatch
+	ASSERT_FALSE(spHNSWIndexKNN(index, queue, queryPoint));
+	ASSERT_FALSE(spHNSWIndexKNN(NULL, queue, queryPoint));
+	ASSERT_TRUE(spBPQueueIsEmpty(queue));
+	ASSERT_FALSE(spHNSWIndexSave(index, NULL));
+	ASSERT_FALSE(spHNSWIndexSave(NULL, HNSW_TESTS_FILE));
+
+	spHNSWIndexDestroy(index);
+	spPointDestroy(queryPoint);
+	spBPQueueDestroy(queue);
+	return true;
+}
+
+//a single build thread
+static bool hnswIndexSingleThreadTest() {
+	return verifyExactHNSWSearch(1, SP_POINT_PRECISION_DOUBLE);
+}
+
+//the nodes are inserted by several threads
+static bool hnswIndexMultiThreadTest() {
+	return verifyExactHNSWSearch(HNSW_TESTS_THREADS, SP_POINT_PRECISION_DOUBLE);
+}
+
+//the nodes are stored as float or float16
+static bool hnswIndexReducedPrecisionTest() {
+	return verifyExactHNSWSearch(HNSW_TESTS_THREADS, SP_POINT_PRECISION_FLOAT) &&
+			verifyExactHNSWSearch(HNSW_TESTS_THREADS, SP_POINT_PRECISION_HALF);
+}
+
+//a saved index (of float16 nodes) is loaded back only for the points and the parameters
+//it was built with
+static bool hnswIndexSaveLoadTest() {
+	int expected[HNSW_TESTS_QUERIES][HNSW_TESTS_K];
+	SPHNSWIndex index;
+	SPPoint *points, *otherPoints;
+	SPPoint* copies = (SPPoint*) calloc(HNSW_TESTS_SIZE, sizeof(SPPoint));
+	SPPoint* queries = generateRandomPointsArray(HNSW_TESTS_DIM, HNSW_TESTS_QUERIES);
+	int i;
+	spPointSetDefaultPrecision(SP_POINT_PRECISION_HALF);
+	points = generateRandomPointsArray(HNSW_TESTS_DIM, HNSW_TESTS_SIZE);
+	otherPoints = generateRandomPointsArray(HNSW_TESTS_DIM, HNSW_TESTS_SIZE);
+	spPointSetDefaultPrecision(SP_POINT_PRECISION_DOUBLE);
+	ASSERT_TRUE(points != NULL && copies != NULL && queries != NULL &&
+			otherPoints != NULL);
+	for (i = 0; i < HNSW_TESTS_SIZE; i++)
+		ASSERT_TRUE((copies[i] = spPointCopy(points[i])) != NULL);
+	ASSERT_TRUE(getExpectedResults(points, queries, expected));
+
+	index = spHNSWIndexCreate(points, HNSW_TESTS_SIZE, HNSW_TESTS_M, HNSW_TESTS_SIZE,
+			HNSW_TESTS_SIZE, HNSW_TESTS_THREADS);
+	ASSERT_TRUE(index != NULL);
+	free(points);
+	ASSERT_TRUE(spHNSWIndexSave(index, HNSW_TESTS_FILE));
+	spHNSWIndexDestroy(index);
+
+	// different points, a different size or different parameters do not match the file
+	ASSERT_TRUE(spHNSWIndexLoad(HNSW_TESTS_FILE, otherPoints, HNSW_TESTS_SIZE,
+			HNSW_TESTS_M, HNSW_TESTS_SIZE, HNSW_TESTS_SIZE) == NULL);
+	ASSERT_TRUE(spHNSWIndexLoad(HNSW_TESTS_FILE, copies, HNSW_TESTS_SIZE - 1,
+			HNSW_TESTS_M, HNSW_TESTS_SIZE, HNSW_TESTS_SIZE) == NULL);
+	ASSERT_TRUE(spHNSWIndexLoad(HNSW_TESTS_FILE, copies, HNSW_TESTS_SIZE,
+			HNSW_TESTS_M + 1, HNSW_TESTS_SIZE, HNSW_TESTS_SIZE) == NULL);
+	ASSERT_TRUE(spHNSWIndexLoad(HNSW_TESTS_FILE, copies, HNSW_TESTS_SIZE,
+			HNSW_TESTS_M, HNSW_TESTS_SIZE - 1, HNSW_TESTS_SIZE) == NULL);
+
+	index = spHNSWIndexLoad(HNSW_TESTS_FILE, copies, HNSW_TESTS_SIZE, HNSW_TESTS_M,
+			HNSW_TESTS_SIZE, HNSW_TESTS_SIZE);
+	ASSERT_TRUE(index != NULL);
+	free(copies);
+	ASSERT_TRUE(verifyQueries(index, queries, expected));
+
+	spHNSWIndexDestroy(index);
+	remove(HNSW_TESTS_FILE);
+	destroyPointsArray(queries, HNSW_TESTS_QUERIES);
+	destroyPointsArray(otherPoints, HNSW_TESTS_SIZE);
+	return true;
+}
+
+//nodes inserted after the build (and after a search) are found as the built ones
+static bool hnswIndexAddPointsTest() {
+	int expected[HNSW_TESTS_QUERIES][HNSW_TESTS_K];
+	SPHNSWIndex index;
+	SPPoint* points = generateRandomPointsArray(HNSW_TESTS_DIM, HNSW_TESTS_SIZE);
+	SPPoint* queries = generateRandomPointsArray(HNSW_TESTS_DIM, HNSW_TESTS_QUERIES);
+	SPPoint otherPoint = generateRandomPoint(HNSW_TESTS_DIM + 1, 0);
+	SPBPQueue queue = spBPQueueCreate(HNSW_TESTS_K);
+	ASSERT_TRUE(points != NULL && queries != NULL && otherPoint != NULL && queue != NULL);
+	ASSERT_TRUE(getExpectedResults(points, queries, expected));
+
+	index = spHNSWIndexCreate(points, HNSW_TESTS_SIZE / 2, HNSW_TESTS_M, HNSW_TESTS_SIZE,
+			HNSW_TESTS_SIZE, HNSW_TESTS_THREADS);
+	ASSERT_TRUE(index != NULL);
+	ASSERT_FALSE(spHNSWIndexAddPoints(NULL, points + HNSW_TESTS_SIZE / 2, 1));
+	ASSERT_FALSE(spHNSWIndexAddPoints(index, points + HNSW_TESTS_SIZE / 2, 0));
+	ASSERT_FALSE(spHNSWIndexAddPoints(index, &otherPoint, 1));
+	ASSERT_TRUE(spHNSWIndexKNN(index, queue, queries[0]));
+	ASSERT_TRUE(spHNSWIndexAddPoints(index, points + HNSW_TESTS_SIZE / 2, 1));
+	ASSERT_TRUE(spHNSWIndexKNN(index, queue, queries[0]));
+	ASSERT_TRUE(spHNSWIndexAddPoints(index, points + HNSW_TESTS_SIZE / 2 + 1,
+			HNSW_TESTS_SIZE - HNSW_TESTS_SIZE / 2 - 1));
+	free(points);
+
+	ASSERT_TRUE(verifyQueries(index, queries, expected));
+
+	spHNSWIndexDestroy(index);
+	spPointDestroy(otherPoint);
+	spBPQueueDestroy(queue);
+	destroyPointsArray(queries, HNSW_TESTS_QUERIES);
+	return true;
+}
+
+void runHNSWIndexTests() {
+	int i;
+	srand(time(NULL));
+	RUN_TEST(hnswIndexInvalidArgumentsTest);
+	for (i = 0; i < HNSW_RANDOM_TESTS_COUNT; i++) {
+		RUN_TEST(hnswIndexSingleThreadTest);
+		RUN_TEST(hnswIndexMultiThreadTest);
+		RUN_TEST(hnswIndexReducedPrecisionTest);
+		RUN_TEST(hnswIndexSaveLoadTest);
+		RUN_TEST(hnswIndexAddPointsTest);
+	}
+}
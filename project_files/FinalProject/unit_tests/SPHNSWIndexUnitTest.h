@@ -0,0 +1,8 @@
+#ifndef SPHNSWINDEXUNITTEST_H_
+#define SPHNSWINDEXUNITTEST_H_
+
+
+
+void runHNSWIndexTests();
+
+#endif /* SPHNSWINDEXUNITTEST_H_ */
@@ -0,0 +1,151 @@
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "unit_test_util.h"
+#include "SPIVFIndexUnitTest.h"
+#include "../data_structures/index_ds/SPIVFIndex.h"
+#include "SPKDArrayUnitTest.h"
+#include "SPKDTreeNodeKNNUnitTest.h"
+#include "../data_structures/bpqueue_ds/SPBPriorityQueue.h"
+#include "../SPPoint.h"
+#include "../general_utils/SPUtils.h"
+
+#define IVF_TESTS_DIM						10
+#define IVF_TESTS_SIZE						300
+#define IVF_TESTS_K							6
+#define IVF_TESTS_LISTS						12
+#define IVF_RANDOM_TESTS_COUNT				5
+
+/*
+ * Builds an index over random points stored at the given precision, and verifies that
+ * the search equals the exact search, which holds whenever all the lists are probed
+ */
+static bool verifyExactIVFSearch(int numOfLists, int numOfProbes,
+		SP_POINT_PRECISION precision) {
+	int expected[IVF_TESTS_K];
+	SPIVFIndex index;
+	SPPoint* points;
+	SPPoint queryPoint = generateRandomPoint(IVF_TESTS_DIM, 0);
+	SPBPQueue queue = spBPQueueCreate(IVF_TESTS_K);
+	spPointSetDefaultPrecision(precision);
+	points = generateRandomPointsArray(IVF_TESTS_DIM, IVF_TESTS_SIZE);
+	spPointSetDefaultPrecision(SP_POINT_PRECISION_DOUBLE);
+	ASSERT_TRUE(points != NULL && queryPoint != NULL && queue != NULL);
+	ASSERT_TRUE(getExactKNN(points, IVF_TESTS_SIZE, queryPoint, IVF_TESTS_K, expected));
+
+	index = spIVFIndexCreate(points, IVF_TESTS_SIZE, numOfLists, numOfProbes,
+			IVF_TESTS_SIZE);
+	ASSERT_TRUE(index != NULL);
+	free(points);
+
+	ASSERT_TRUE(spIVFIndexKNN(index, queue, queryPoint));
+	ASSERT_TRUE(verifyQueueOrder(queue, expected, IVF_TESTS_K));
+
+	spIVFIndexDestroy(index);
+	spPointDestroy(queryPoint);
+	spBPQueueDestroy(queue);
+	return true;
+}
+
+//points added in groups after the creation are searched as if they were indexed by it
+static bool ivfIndexAddPointsTest() {
+	int expected[IVF_TESTS_K];
+	SPIVFIndex index;
+	SPPoint* points = generateRandomPointsArray(IVF_TESTS_DIM, 2 * IVF_TESTS_SIZE);
+	SPPoint queryPoint = generateRandomPoint(IVF_TESTS_DIM, 0);
+	SPPoint otherPoint = generateRandomPoint(IVF_TESTS_DIM + 1, 0);
+	SPBPQueue queue = spBPQueueCreate(IVF_TESTS_K);
+	ASSERT_TRUE(points != NULL && queryPoint != NULL && otherPoint != NULL &&
+			queue != NULL);
+	ASSERT_TRUE(getExactKNN(points, 2 * IVF_TESTS_SIZE, queryPoint, IVF_TESTS_K,
+			expected));
+
+	index = spIVFIndexCreate(points, IVF_TESTS_SIZE, IVF_TESTS_LISTS, IVF_TESTS_LISTS,
+			IVF_TESTS_SIZE);
+	ASSERT_TRUE(index != NULL);
+	ASSERT_FALSE(spIVFIndexAddPoints(NULL, points + IVF_TESTS_SIZE, 1));
+	ASSERT_FALSE(spIVFIndexAddPoints(index, points + IVF_TESTS_SIZE, 0));
+	ASSERT_FALSE(spIVFIndexAddPoints(index, &otherPoint, 1));
+	ASSERT_TRUE(spIVFIndexAddPoints(index, points + IVF_TESTS_SIZE, 1));
+	ASSERT_TRUE(spIVFIndexAddPoints(index, points + IVF_TESTS_SIZE + 1,
+			IVF_TESTS_SIZE - 1));
+	free(points);
+
+	ASSERT_TRUE(spIVFIndexKNN(index, queue, queryPoint));
+	ASSERT_TRUE(verifyQueueOrder(queue, expected, IVF_TESTS_K));
+
+	spIVFIndexDestroy(index);
+	spPointDestroy(queryPoint);
+	spPointDestroy(otherPoint);
+	spBPQueueDestroy(queue);
+	return true;
+}
+
+//invalid arguments test
+static bool ivfIndexInvalidArgumentsTest() {
+	SPPoint* points = generateRandomPointsArray(IVF_TESTS_DIM, IVF_TESTS_SIZE);
+	SPPoint queryPoint = generateRandomPoint(IVF_TESTS_DIM + 1, 0);
+	SPBPQueue queue = spBPQueueCreate(IVF_TESTS_K);
+	SPIVFIndex index;
+	ASSERT_TRUE(points != NULL && queryPoint != NULL && queue != NULL);
+
+	ASSERT_TRUE(spIVFIndexCreate(NULL, IVF_TESTS_SIZE, 1, 1, 1) == NULL);
+	ASSERT_TRUE(spIVFIndexCreate(points, IVF_TESTS_SIZE, 0, 1, 1) == NULL);
+	ASSERT_TRUE(spIVFIndexCreate(points, IVF_TESTS_SIZE, 1, 0, 1) == NULL);
+	ASSERT_TRUE(spIVFIndexCreate(points, IVF_TESTS_SIZE, 1, 1, 0) == NULL);
+	spIVFIndexDestroy(NULL);
+
+	// a failed creation does not take ownership, a successful one does
+	index = spIVFIndexCreate(points, IVF_TESTS_SIZE, IVF_TESTS_LISTS, 1, IVF_TESTS_SIZE);
+	ASSERT_TRUE(index != NULL);
+	free(points);
+
+	// dimension mismatch
+	ASSERT_FALSE(spIVFIndexKNN(index, queue, queryPoint));
+	ASSERT_FALSE(spIVFIndexKNN(NULL, queue, queryPoint));
+	ASSERT_TRUE(spBPQueueIsEmpty(queue));
+
+	spIVFIndexDestroy(index);
+	spPointDestroy(queryPoint);
+	spBPQueueDestroy(queue);
+	return true;
+}
+
+//a single list holds the whole database
+static bool ivfIndexSingleListTest() {
+	return verifyExactIVFSearch(1, 1, SP_POINT_PRECISION_DOUBLE);
+}
+
+//probing all the lists is an exact search
+static bool ivfIndexAllProbesTest() {
+	return verifyExactIVFSearch(IVF_TESTS_LISTS, IVF_TESTS_LISTS,
+			SP_POINT_PRECISION_DOUBLE);
+}
+
+//lists stored as float or float16 are searched exactly over the stored values
+static bool ivfIndexReducedPrecisionTest() {
+	return verifyExactIVFSearch(IVF_TESTS_LISTS, IVF_TESTS_LISTS,
+			SP_POINT_PRECISION_FLOAT) && verifyExactIVFSearch(IVF_TESTS_LISTS,
+			IVF_TESTS_LISTS, SP_POINT_PRECISION_HALF);
+}
+
+//more probes than lists are clamped to the number of lists
+static bool ivfIndexExcessProbesTest() {
+	return verifyExactIVFSearch(IVF_TESTS_LISTS, IVF_TESTS_LISTS * 4,
+			SP_POINT_PRECISION_DOUBLE);
+}
+
+void runIVFIndexTests() {
+	int i;
+	srand(time(NULL));
+	RUN_TEST(ivfIndexInvalidArgumentsTest);
+	for (i = 0; i < IVF_RANDOM_TESTS_COUNT; i++) {
+		RUN_TEST(ivfIndexSingleListTest);
+		RUN_TEST(ivfIndexAllProbesTest);
+		RUN_TEST(ivfIndexExcessProbesTest);
+		RUN_TEST(ivfIndexReducedPrecisionTest);
+		RUN_TEST(ivfIndexAddPointsTest);
+	}
+}
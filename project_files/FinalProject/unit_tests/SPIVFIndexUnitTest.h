@@ -0,0 +1,8 @@
+#ifndef SPIVFINDEXUNITTEST_H_
+#define SPIVFINDEXUNITTEST_H_
+
+
+
+void runIVFIndexTests();
+
+#endif /* SPIVFINDEXUNITTEST_H_ */
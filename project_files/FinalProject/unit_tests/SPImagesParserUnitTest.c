@@ -11,6 +11,14 @@
 #include "../SPConfig.h"
 #include "SPImagesParserUnitTest.h"
 
+#define LOAD_TEST_CONFIG_FILE		"./unit_tests/loadTest.config"
+#define LOAD_TEST_CONFIG			"spImagesDirectory = ./unit_tests/\nspImagesPrefix = loadTest\n" \
+									"spImagesSuffix = .png\nspNumOfImages = 20\n" \
+									"spExtractionMode = false\nspLoadThreads = 4\n"
+#define LOAD_TEST_NUM_OF_IMAGES		20
+#define LOAD_TEST_MAX_FAILS			4 // 20 percent of the images
+#define LOAD_TEST_PATH_LEN			64
+
 typedef struct configData {
 	SPConfig config;
 	char* configSign;
@@ -264,6 +272,99 @@ bool testGetLine(char* configSign){
 	return true;
 }
 
+/*
+ * Writes the .feats file of an image with two features. A bad file has a header of
+ * another image.
+ */
+static bool writeLoadTestImage(SPConfig config, char* configSign, int index, bool isBad){
+	char path[LOAD_TEST_PATH_LEN];
+	double data[] = {index, -0.5, 2.25};
+	SPPoint points[2];
+	struct sp_image_data imageData;
+	SP_DP_MESSAGES msg;
+	FILE* file;
+
+	if (spConfigGetImagePathFeats(path, config, index, true) != SP_CONFIG_SUCCESS ||
+			(file = fopen(path, "w")) == NULL)
+		return false;
+	points[0] = spPointCreate(data, 3, index);
+	points[1] = spPointCreate(data, 2, index);
+	imageData.index = isBad ? index + 1 : index;
+	imageData.numOfFeatures = 2;
+	imageData.featuresArray = points;
+	msg = writeImageDataToFile(file, &imageData, configSign);
+	fclose(file);
+	spPointDestroy(points[0]);
+	spPointDestroy(points[1]);
+	return msg == SP_DP_SUCCESS;
+}
+
+/*
+ * Loads the test images with loadAllImagesData, where numOfBad of them are bad, and
+ * checks that the good ones are loaded and the bad ones have no features
+ */
+static bool loadAllTestImages(SPConfig config, char* configSign, int numOfBad,
+		SP_DP_MESSAGES expected){
+	SPImageData allImagesData[LOAD_TEST_NUM_OF_IMAGES];
+	bool isBad, successFlag = true;
+	int i;
+
+	for (i = 0; i < LOAD_TEST_NUM_OF_IMAGES; i++){
+		// the bad images are spread between the chunks of the loading threads
+		isBad = i % 3 == 1 && i / 3 < numOfBad;
+		successFlag &= writeLoadTestImage(config, configSign, i, isBad);
+		successFlag &= (allImagesData[i] = createImageData(i)) != NULL;
+	}
+	successFlag &= loadAllImagesData(config, configSign, allImagesData) == expected;
+
+	for (i = 0; i < LOAD_TEST_NUM_OF_IMAGES; i++){
+		isBad = i % 3 == 1 && i / 3 < numOfBad;
+		if (expected == SP_DP_SUCCESS && isBad)
+			successFlag &= allImagesData[i]->numOfFeatures == 0 &&
+					allImagesData[i]->featuresArray == NULL;
+		else if (expected == SP_DP_SUCCESS)
+			successFlag &= allImagesData[i]->numOfFeatures == 2 &&
+					spPointGetDimension(allImagesData[i]->featuresArray[0]) == 3 &&
+					spPointGetAxisCoor(allImagesData[i]->featuresArray[0], 0) == i &&
+					spPointGetIndex(allImagesData[i]->featuresArray[1]) == i;
+		freeImageData(allImagesData[i], true, true);
+	}
+	return successFlag;
+}
+
+static bool testLoadAllImagesData(){
+	SP_CONFIG_MSG configMsg = SP_CONFIG_SUCCESS;
+	char path[LOAD_TEST_PATH_LEN];
+	char* configSign;
+	SPConfig config;
+	FILE* file;
+	int i;
+
+	file = fopen(LOAD_TEST_CONFIG_FILE, "w");
+	ASSERT_TRUE(file != NULL);
+	fputs(LOAD_TEST_CONFIG, file);
+	fclose(file);
+	config = spConfigCreate(LOAD_TEST_CONFIG_FILE, &configMsg);
+	ASSERT_TRUE(config != NULL && spConfigGetLoadThreads(config, &configMsg) == 4);
+	configSign = getSignature(config);
+	ASSERT_TRUE(configSign != NULL);
+
+	// the failure budget is shared by the loading threads
+	ASSERT_TRUE(loadAllTestImages(config, configSign, 0, SP_DP_SUCCESS));
+	ASSERT_TRUE(loadAllTestImages(config, configSign, LOAD_TEST_MAX_FAILS, SP_DP_SUCCESS));
+	ASSERT_TRUE(loadAllTestImages(config, configSign, LOAD_TEST_MAX_FAILS + 1,
+			SP_DP_FORMAT_ERROR));
+
+	for (i = 0; i < LOAD_TEST_NUM_OF_IMAGES; i++){
+		spConfigGetImagePathFeats(path, config, i, true);
+		remove(path);
+	}
+	remove(LOAD_TEST_CONFIG_FILE);
+	free(configSign);
+	spConfigDestroy(config);
+	return true;
+}
+
 void runImagesParserTests(SPConfig config){
 	char* configSign = NULL;
 	configSign = getSignature(config);
@@ -282,5 +383,6 @@ void runImagesParserTests(SPConfig config){
 	RUN_TEST_WITH_PARAM(testSaveImageData, configData);
 	RUN_TEST_WITH_PARAM(testLoadKnownImageData, configSign);
 	RUN_TEST_WITH_PARAM(testGetLine, configSign);
+	RUN_TEST(testLoadAllImagesData);
 	free(configSign);
 }
@@ -0,0 +1,157 @@
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+#include <pthread.h>
+
+#include "unit_test_util.h"
+#include "SPInstrumentationUnitTest.h"
+#include "../general_utils/SPInstrumentation.h"
+
+#define INSTRUMENTATION_TESTS_FILE			"./unit_tests/instrumentationTest.json"
+#define INSTRUMENTATION_TESTS_MAX_LEN		4096
+#define NSEC_PER_MSEC						1000000
+
+/*
+ * Reads the whole test JSON file into buffer
+ */
+static bool readDump(char* buffer) {
+	size_t length;
+	FILE* file = fopen(INSTRUMENTATION_TESTS_FILE, "r");
+	if (file == NULL)
+		return false;
+	length = fread(buffer, 1, INSTRUMENTATION_TESTS_MAX_LEN - 1, file);
+	buffer[length] = '\0';
+	fclose(file);
+	return length > 0;
+}
+
+static bool instrumentationClockTest() {
+	uint64_t first = spInstrumentationNow();
+	uint64_t second = spInstrumentationNow();
+	ASSERT_TRUE(second >= first);
+	return true;
+}
+
+static bool instrumentationEmptyDumpTest() {
+	char dump[INSTRUMENTATION_TESTS_MAX_LEN];
+
+	spInstrumentationReset();
+	ASSERT_TRUE(spInstrumentationDump(INSTRUMENTATION_TESTS_FILE));
+	ASSERT_TRUE(readDump(dump));
+	ASSERT_TRUE(strstr(dump, "\"queries\": 0,") != NULL);
+	ASSERT_TRUE(strstr(dump, "\"config_load\": {\"calls\": 0, \"total_ms\": 0.000, "
+			"\"mean_ms\": 0.000, \"max_ms\": 0.000},") != NULL);
+	ASSERT_TRUE(strstr(dump, "\"query\": {\"calls\": 0") != NULL);
+	ASSERT_TRUE(strstr(dump, "\"queue_rejections\": {\"total\": 0, \"per_query_mean\": 0.0, "
+			"\"per_query_max\": 0},\n") != NULL);
+	ASSERT_TRUE(strstr(dump, "\"query_cache_misses\": {\"total\": 0, "
+			"\"per_query_mean\": 0.0, \"per_query_max\": 0},\n") != NULL);
+	ASSERT_TRUE(strstr(dump, "\"truncated_queries\": {\"total\": 0, "
+			"\"per_query_mean\": 0.0, \"per_query_max\": 0}\n") != NULL);
+	remove(INSTRUMENTATION_TESTS_FILE);
+	return true;
+}
+
+static bool instrumentationPhasesTest() {
+	char dump[INSTRUMENTATION_TESTS_MAX_LEN];
+
+	spInstrumentationReset();
+	spInstrumentationAddPhaseTime(SP_INSTR_INDEX_BUILD, 2 * NSEC_PER_MSEC);
+	spInstrumentationAddPhaseTime(SP_INSTR_INDEX_BUILD, 4 * NSEC_PER_MSEC);
+	spInstrumentationAddPhaseTime(SP_INSTR_PCA_LOAD, 1 * NSEC_PER_MSEC);
+	ASSERT_TRUE(spInstrumentationDump(INSTRUMENTATION_TESTS_FILE));
+	ASSERT_TRUE(readDump(dump));
+	ASSERT_TRUE(strstr(dump, "\"index_build\": {\"calls\": 2, \"total_ms\": 6.000, "
+			"\"mean_ms\": 3.000, \"max_ms\": 4.000},") != NULL);
+	ASSERT_TRUE(strstr(dump, "\"pca_load\": {\"calls\": 1, \"total_ms\": 1.000, ") != NULL);
+	ASSERT_TRUE(strstr(dump, "\"config_load\": {\"calls\": 0,") != NULL);
+	remove(INSTRUMENTATION_TESTS_FILE);
+	return true;
+}
+
+static bool instrumentationQueriesTest() {
+	char dump[INSTRUMENTATION_TESTS_MAX_LEN];
+
+	spInstrumentationReset();
+	spInstrumentationCounters[SP_INSTR_NODES_VISITED] += 5; // outside of any query
+
+	spInstrumentationQueryBegin();
+	spInstrumentationCounters[SP_INSTR_NODES_VISITED] += 10;
+	spInstrumentationCounters[SP_INSTR_QUEUE_INSERTS] += 3;
+	spInstrumentationQueryEnd();
+
+	spInstrumentationQueryBegin();
+	spInstrumentationCounters[SP_INSTR_NODES_VISITED] += 20;
+	spInstrumentationQueryEnd();
+	spInstrumentationQueryEnd(); // no query, ignored
+
+	spInstrumentationQueryBegin(); // not ended, not counted as a query
+	spInstrumentationCounters[SP_INSTR_LEAVES_SCANNED] += 7;
+
+	ASSERT_TRUE(spInstrumentationDump(INSTRUMENTATION_TESTS_FILE));
+	ASSERT_TRUE(readDump(dump));
+	ASSERT_TRUE(strstr(dump, "\"queries\": 2,") != NULL);
+	ASSERT_TRUE(strstr(dump, "\"query\": {\"calls\": 2,") != NULL);
+	ASSERT_TRUE(strstr(dump, "\"nodes_visited\": {\"total\": 35, \"per_query_mean\": 15.0, "
+			"\"per_query_max\": 20},") != NULL);
+	ASSERT_TRUE(strstr(dump, "\"leaves_scanned\": {\"total\": 7, \"per_query_mean\": 0.0, "
+			"\"per_query_max\": 0},") != NULL);
+	ASSERT_TRUE(strstr(dump, "\"queue_inserts\": {\"total\": 3, \"per_query_mean\": 1.5, "
+			"\"per_query_max\": 3},") != NULL);
+
+	// the counters are added once
+	ASSERT_TRUE(spInstrumentationDump(INSTRUMENTATION_TESTS_FILE));
+	ASSERT_TRUE(readDump(dump));
+	ASSERT_TRUE(strstr(dump, "\"nodes_visited\": {\"total\": 35,") != NULL);
+
+	spInstrumentationReset();
+	remove(INSTRUMENTATION_TESTS_FILE);
+	return true;
+}
+
+/*
+ * Counts the work of a thread that never ends a query or dumps the statistics
+ */
+static void* countInThread(void* arg) {
+	if (!spInstrumentationRegisterThread())
+		return NULL;
+	spInstrumentationCounters[SP_INSTR_DISTANCE_EVALS] += 40;
+	spInstrumentationCounters[SP_INSTR_LEAVES_SCANNED] += 2;
+	return NULL;
+}
+
+//checks the counters of a thread are added to the process totals when it exits
+static bool instrumentationThreadExitTest() {
+	char dump[INSTRUMENTATION_TESTS_MAX_LEN];
+	pthread_t threads[2];
+	int i;
+
+	spInstrumentationReset();
+	for (i = 0; i < 2; i++)
+		ASSERT_TRUE(pthread_create(&(threads[i]), NULL, countInThread, NULL) == 0);
+	for (i = 0; i < 2; i++)
+		pthread_join(threads[i], NULL);
+
+	ASSERT_TRUE(spInstrumentationDump(INSTRUMENTATION_TESTS_FILE));
+	ASSERT_TRUE(readDump(dump));
+	ASSERT_TRUE(strstr(dump, "\"distance_evals\": {\"total\": 80,") != NULL);
+	ASSERT_TRUE(strstr(dump, "\"leaves_scanned\": {\"total\": 4,") != NULL);
+
+	spInstrumentationReset();
+	remove(INSTRUMENTATION_TESTS_FILE);
+	return true;
+}
+
+static bool instrumentationInvalidFileTest() {
+	ASSERT_FALSE(spInstrumentationDump("./unit_tests/no_such_dir/instrumentation.json"));
+	return true;
+}
+
+void runInstrumentationTests() {
+	RUN_TEST(instrumentationClockTest);
+	RUN_TEST(instrumentationEmptyDumpTest);
+	RUN_TEST(instrumentationPhasesTest);
+	RUN_TEST(instrumentationQueriesTest);
+	RUN_TEST(instrumentationThreadExitTest);
+	RUN_TEST(instrumentationInvalidFileTest);
+}
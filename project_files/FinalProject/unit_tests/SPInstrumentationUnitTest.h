@@ -0,0 +1,8 @@
+#ifndef SPINSTRUMENTATIONUNITTEST_H_
+#define SPINSTRUMENTATIONUNITTEST_H_
+
+
+
+void runInstrumentationTests();
+
+#endif /* SPINSTRUMENTATIONUNITTEST_H_ */
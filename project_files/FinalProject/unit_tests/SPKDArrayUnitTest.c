@@ -144,6 +144,20 @@ void destroyPointsArray(SPPoint* array, int numOfItems){
 	}
 }
 
+SPPoint* copyPointsArray(SPPoint* points, int size) {
+	int i;
+	SPPoint* copies = (SPPoint*) calloc(size, sizeof(SPPoint));
+	if (copies == NULL)
+		return NULL;
+	for (i = 0; i < size; i++) {
+		if ((copies[i] = spPointCopy(points[i])) == NULL) {
+			destroyPointsArray(copies, i);
+			return NULL;
+		}
+	}
+	return copies;
+}
+
 SPPoint generateRandomPoint(int dim, int index) {
 	int i;
 	SPPoint p;
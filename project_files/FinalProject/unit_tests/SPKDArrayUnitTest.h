@@ -11,4 +11,9 @@ SPPoint generateRandomPoint(int dim, int index);
 
 void destroyPointsArray(SPPoint* array, int numOfItems);
 
+/*
+ * Returns a deep copy of the points array, or NULL in case of memory allocation error
+ */
+SPPoint* copyPointsArray(SPPoint* points, int size);
+
 #endif /* SPKDARRAYUNITTEST_H_ */
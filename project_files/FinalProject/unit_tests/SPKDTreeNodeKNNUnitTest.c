@@ -11,6 +11,7 @@
 #include "../data_structures/bpqueue_ds/SPBPriorityQueue.h"
 #include "../SPPoint.h"
 #include "../general_utils/SPUtils.h"
+#include "../general_utils/SPInstrumentation.h"
 
 #define COULD_NOT_CREATE_POINTS_ARRAY 						"Could not create points array"
 #define COULD_NOT_INITIALIZE_KD_ARRAY 						"Could not initialize kd-array"
@@ -25,6 +26,13 @@
 #define RANDOM_TESTS_DIM_RANGE 								50
 #define RANDOM_TESTS_COUNT 									10
 
+//deadline test case macros
+#define DEADLINE_TESTS_SIZE									300
+#define DEADLINE_TESTS_DIM									8
+#define DEADLINE_TESTS_K									5
+#define DEADLINE_TESTS_FUTURE								3600000000000ULL // an hour
+#define DEADLINE_TESTS_PAST									1 // long before the clock start
+
 typedef struct knn_test_case_data {
 	SPKDTreeNode tree;
 	SPPoint* points;
@@ -78,9 +86,22 @@ distanceWithPoint* createAndSortDistancesArray(int size, SPPoint queryPoint, SPP
 	return distancesArray;
 }
 
-int* getRealRsltsArray(int k,SPPoint* pointsArray,SPPoint queryPoint,int size){
+bool getExactKNN(SPPoint* pointsArray, int size, SPPoint queryPoint, int k, int* rslts){
 	int i;
 	distanceWithPoint* distancesArray;
+
+	distancesArray = createAndSortDistancesArray(size,queryPoint, pointsArray);
+	if (distancesArray  == NULL)
+		return false;
+
+	for (i = 0; i < k; i++)
+		rslts[i] = spPointGetIndex((distancesArray[i]).point);
+
+	free(distancesArray);
+	return true;
+}
+
+int* getRealRsltsArray(int k,SPPoint* pointsArray,SPPoint queryPoint,int size){
 	int *outputArray = (int*)calloc(k, sizeof(int));
 
 	if (outputArray == NULL)
@@ -89,27 +110,35 @@ int* getRealRsltsArray(int k,SPPoint* pointsArray,SPPoint queryPoint,int size){
 		return NULL;
 	}
 
-	distancesArray = createAndSortDistancesArray(size,queryPoint, pointsArray);
-
-	if (distancesArray  == NULL) {
+	if (!getExactKNN(pointsArray, size, queryPoint, k, outputArray)) {
 		free(outputArray);
 		return NULL;
 	}
-
-	for (i = 0; i < k; i++)
-		outputArray[i] = spPointGetIndex((distancesArray[i]).point);
-
-	free(distancesArray);
 	return outputArray;
 }
 
+bool verifyQueueOrder(SPBPQueue queue, int* expected, int k){
+	int i;
+	SPListElement element;
+	if (spBPQueueSize(queue) != k)
+		return false;
+	for (i = 0; i < k; i++) {
+		if ((element = spBPQueuePeek(queue)) == NULL)
+			return false;
+		if (spListElementGetIndex(element) != expected[i]) {
+			spListElementDestroy(element);
+			return false;
+		}
+		spListElementDestroy(element);
+		spBPQueueDequeue(queue);
+	}
+	return spBPQueueIsEmpty(queue);
+}
+
 //general test
 bool verifyKNN(SPBPQueue rsltQueue, int k,SPPoint* pointsArray,SPPoint queryPoint, int numOfPoints){
 	SPBPQueue workingQueue = NULL;
-	SPListElement tempElement = NULL;
-	SP_BPQUEUE_MSG msg;
-	bool emptyFlag;
-	int i, queueSize;
+	bool rslt;
 	int* rsltsArray;
 
 	if (rsltQueue == NULL || pointsArray == NULL || queryPoint == NULL)
@@ -127,28 +156,10 @@ bool verifyKNN(SPBPQueue rsltQueue, int k,SPPoint* pointsArray,SPPoint queryPoin
 		return false;
 	}
 
-	queueSize = spBPQueueSize(workingQueue);
-	for (i = 0; i< queueSize ; i++){
-		tempElement = spBPQueuePeek(workingQueue);
-
-		if (spListElementGetIndex(tempElement) != rsltsArray[i]){
-			free(rsltsArray);
-			spBPQueueDestroy(workingQueue);
-			return false;
-		}
-		spListElementDestroy(tempElement);
-
-		msg = spBPQueueDequeue(workingQueue);
-		if (msg != SP_BPQUEUE_SUCCESS){
-			free(rsltsArray);
-			spBPQueueDestroy(workingQueue);
-			return false;
-		}
-	}
-	emptyFlag = spBPQueueIsEmpty(workingQueue);
+	rslt = verifyQueueOrder(workingQueue, rsltsArray, spBPQueueSize(workingQueue));
 	spBPQueueDestroy(workingQueue);
 	free(rsltsArray);
-	return emptyFlag;
+	return rslt;
 }
 
 void destroyCaseData(SPKDTreeNode tree,SPKDArray kdArr,SPPoint* pointsArray,int size,
@@ -691,6 +702,46 @@ bool runRandomKnnTest(){
 
 
 
+//deadline test
+bool runKnnDeadlineTest(){
+	bool successFlag, isExpired = true;
+	SPPoint* pointsArray = NULL;
+	SPPoint queryPoint = NULL;
+	SPBPQueue queue = NULL;
+	SPKDArray kdArr = NULL;
+	SPKDTreeNode tree = NULL;
+
+	pointsArray = generateRandomPointsArray(DEADLINE_TESTS_DIM, DEADLINE_TESTS_SIZE);
+	queryPoint = generateRandomPoint(DEADLINE_TESTS_DIM, DEADLINE_TESTS_SIZE);
+	queue = spBPQueueCreate(DEADLINE_TESTS_K);
+	if (pointsArray == NULL || queryPoint == NULL || queue == NULL ||
+			(kdArr = Init(pointsArray, DEADLINE_TESTS_SIZE)) == NULL ||
+			(tree = InitKDTree(kdArr, MAX_SPREAD)) == NULL){
+		destroyCaseData(tree,kdArr,pointsArray,DEADLINE_TESTS_SIZE,queue,queryPoint);
+		FAIL(COULD_NOT_CREATE_CASE_DATA);
+		return false;
+	}
+
+	//a deadline that does not pass is an exact search
+	successFlag = kNearestNeighborsWithDeadline(tree, queue, queryPoint,
+			spInstrumentationNow() + DEADLINE_TESTS_FUTURE, &isExpired) && !isExpired &&
+			verifyKNN(queue, DEADLINE_TESTS_K, pointsArray, queryPoint, DEADLINE_TESTS_SIZE);
+
+	//a deadline that passed stops the search after a batch of leaves, with a full queue
+	spBPQueueClear(queue);
+	successFlag = successFlag && kNearestNeighborsWithDeadline(tree, queue, queryPoint,
+			DEADLINE_TESTS_PAST, &isExpired) && isExpired && spBPQueueIsFull(queue);
+
+	spBPQueueClear(queue);
+	successFlag = successFlag && kNearestNeighborsWithDeadline(tree, queue, queryPoint,
+			SP_KNN_NO_DEADLINE, &isExpired) && !isExpired &&
+			verifyKNN(queue, DEADLINE_TESTS_K, pointsArray, queryPoint, DEADLINE_TESTS_SIZE);
+
+	destroyCaseData(tree,kdArr,pointsArray,DEADLINE_TESTS_SIZE,queue,queryPoint);
+	ASSERT_TRUE(successFlag);
+	return true;
+}
+
 void runKDTreeNodeKNNTests(){
 	int i;
 	knnTestCaseData case1Data = NULL, case2Data = NULL, edgeCase1Data = NULL;
@@ -717,6 +768,8 @@ void runKDTreeNodeKNNTests(){
 	RUN_TEST_WITH_PARAM(runKnnEdgeTestCase1, edgeCase1Data);
 	destroyCaseDataByWrapperTestCase(edgeCase1Data);
 
+	//deadline case
+	RUN_TEST(runKnnDeadlineTest);
 
 	//random tests
 	for (i = 0 ; i< RANDOM_TESTS_COUNT;i++)
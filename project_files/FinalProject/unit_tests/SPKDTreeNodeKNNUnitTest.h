@@ -1,8 +1,22 @@
 #ifndef SPKDTREENODEKNNUNITTEST_H_
 #define SPKDTREENODEKNNUNITTEST_H_
 
-
+#include <stdbool.h>
+#include "../SPPoint.h"
+#include "../data_structures/bpqueue_ds/SPBPriorityQueue.h"
 
 void runKDTreeNodeKNNTests();
 
+/*
+ * Fills 'rslts' with the indices of the k nearest points to queryPoint, by a full scan
+ * (ties are broken by the smaller index, as the queue does)
+ */
+bool getExactKNN(SPPoint* pointsArray, int size, SPPoint queryPoint, int k, int* rslts);
+
+/*
+ * Returns true iff the queue holds exactly the given indices in the given order.
+ * The queue is emptied.
+ */
+bool verifyQueueOrder(SPBPQueue queue, int* expected, int k);
+
 #endif /* SPKDTREENODEKNNUNITTEST_H_ */
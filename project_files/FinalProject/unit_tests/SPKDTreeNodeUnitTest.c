@@ -381,6 +381,35 @@ bool runRandomKDTreeTest(){
 	return successFlag;
 }
 
+//points added to a tree are in the rebuilt tree, which keeps all the tree invariants
+bool runKDTreeAddPointsTest(){
+	int maxDim, size, added;
+	bool successFlag;
+	SPPoint* pointsArray = NULL;
+	SPKDTreeNode tree = NULL;
+	SP_KDTREE_SPLIT_METHOD splitMethod;
+
+	maxDim = 1 + (int)(rand() % RANDOM_TESTS_DIM_RANGE);
+	size = 2 + (int)(rand() % RANDOM_TESTS_SIZE_RANGE);
+	added = 1 + (int)(rand() % RANDOM_TESTS_SIZE_RANGE);
+	splitMethod = (int)(rand()%3);
+
+	pointsArray = generateRandomPointsArray(maxDim, size + added);
+	ASSERT_TRUE(pointsArray != NULL);
+	tree = InitKDTreeFromPoints(pointsArray, size, splitMethod);
+	ASSERT_TRUE(tree != NULL);
+
+	ASSERT_TRUE(spKDTreeAddPoints(NULL, pointsArray + size, added, splitMethod) == NULL);
+	ASSERT_TRUE(spKDTreeAddPoints(tree, pointsArray + size, 0, splitMethod) == NULL);
+	tree = spKDTreeAddPoints(tree, pointsArray + size, added, splitMethod);
+	ASSERT_TRUE(tree != NULL);
+
+	successFlag = testKDTree(tree, maxDim, splitMethod, pointsArray, size + added);
+
+	spKDTreeDestroy(tree, false);
+	destroyPointsArray(pointsArray, size + added);
+	return successFlag;
+}
 
 //null test
 bool verifyNullArgument(){
@@ -754,4 +783,7 @@ void runKDTreeNodeTests(){
 	//random tests
 	for (i = 0 ; i< RANDOM_TESTS_COUNT;i++)
 		RUN_TEST(runRandomKDTreeTest);
+
+	//adding points
+	RUN_TEST(runKDTreeAddPointsTest);
 }
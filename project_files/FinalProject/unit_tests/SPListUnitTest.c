@@ -340,6 +340,46 @@ static bool testListClear() {
 	return true;
 }
 
+//the nodes of a cleared list are reused, with the values of the new elements
+static bool testListReuseAfterClear() {
+	int i, round;
+	SPListElement elem, current;
+	SPList list = spListCreate();
+	ASSERT_TRUE(list != NULL);
+
+	for (round = 0; round < 3; round++) {
+		for (i = 0; i < 10 + round; i++) {
+			elem = spListElementCreate(round * 100 + i, (double) i);
+			ASSERT_TRUE(spListInsertLast(list, elem) == SP_LIST_SUCCESS);
+			spListElementDestroy(elem);
+		}
+		ASSERT_TRUE(spListGetSize(list) == 10 + round);
+		for (i = 0, current = spListGetFirst(list); current != NULL;
+				i++, current = spListGetNext(list)) {
+			ASSERT_TRUE(spListElementGetIndex(current) == round * 100 + i);
+			ASSERT_TRUE(spListElementGetValue(current) == (double) i);
+		}
+		ASSERT_TRUE(i == 10 + round);
+
+		// a single removed node is reused as well
+		spListGetFirst(list);
+		ASSERT_TRUE(spListRemoveCurrent(list) == SP_LIST_SUCCESS);
+		elem = spListElementCreate(7, 7.0);
+		ASSERT_TRUE(spListInsertFirst(list, elem) == SP_LIST_SUCCESS);
+		spListElementDestroy(elem);
+		current = spListGetFirst(list);
+		ASSERT_TRUE(spListElementGetIndex(current) == 7);
+		ASSERT_TRUE(spListElementGetValue(current) == 7.0);
+
+		ASSERT_TRUE(spListClear(list) == SP_LIST_SUCCESS);
+		ASSERT_TRUE(spListGetSize(list) == 0);
+		ASSERT_TRUE(spListGetFirst(list) == NULL);
+	}
+
+	spListDestroy(list);
+	return true;
+}
+
 static bool testListDestroy() {
 	spListDestroy(NULL);
 	return true;
@@ -363,6 +403,7 @@ void runListTests() {
 	RUN_TEST(testListInsertBeforeCurrent);
 	RUN_TEST(testListInsertAfterCurrent);
 	RUN_TEST(testListClear);
+	RUN_TEST(testListReuseAfterClear);
 	RUN_TEST(testListDestroy);
 }
 
@@ -0,0 +1,235 @@
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/wait.h>
+
+#include "unit_test_util.h"
+#include "SPLoggerUnitTest.h"
+#include "../SPLogger.h"
+
+#define LOGGER_TESTS_FILE					"./unit_tests/loggerTest.log"
+#define LOGGER_TESTS_LINE_LEN				1100
+#define LOGGER_TESTS_MESSAGES				2000 // more than the ring of the async logger
+#define LOGGER_TESTS_THREADS				4
+#define LOGGER_TESTS_THREAD_MESSAGES		600
+#define LOGGER_TESTS_MSG_FORMAT				"message %d %d"
+#define LOGGER_TESTS_LONG_MSG_LEN			3000
+
+typedef struct logger_test_thread_t {
+	int id;
+	bool success;
+} LoggerTestThread;
+
+/*
+ * Reads the next line of the file into line without its new line
+ * @return false at the end of the file
+ */
+static bool readLine(FILE* file, char* line) {
+	size_t len;
+	if (fgets(line, LOGGER_TESTS_LINE_LEN, file) == NULL)
+		return false;
+	len = strlen(line);
+	if (len > 0 && line[len - 1] == '\n')
+		line[len - 1] = '\0';
+	return true;
+}
+
+/*
+ * Counts the lines of the test log file that contain the given text
+ */
+static int countLinesWith(const char* text) {
+	char line[LOGGER_TESTS_LINE_LEN];
+	int count = 0;
+	FILE* file = fopen(LOGGER_TESTS_FILE, "r");
+	if (file == NULL)
+		return -1;
+	while (readLine(file, line))
+		count += strstr(line, text) != NULL;
+	fclose(file);
+	return count;
+}
+
+static bool loggerLevelCheckTest() {
+	ASSERT_TRUE(spLoggerIsLevelEnabled(SP_LOGGER_DEBUG_INFO_WARNING_ERROR_LEVEL));
+	ASSERT_TRUE(spLoggerPrintInfo("undefined") == SP_LOGGER_UNDIFINED);
+
+	ASSERT_TRUE(spLoggerCreate(LOGGER_TESTS_FILE, SP_LOGGER_WARNING_ERROR_LEVEL) ==
+			SP_LOGGER_SUCCESS);
+	ASSERT_TRUE(spLoggerCreateAsync(LOGGER_TESTS_FILE, SP_LOGGER_WARNING_ERROR_LEVEL) ==
+			SP_LOGGER_DEFINED);
+	ASSERT_TRUE(spLoggerIsLevelEnabled(SP_LOGGER_ERROR_LEVEL));
+	ASSERT_TRUE(spLoggerIsLevelEnabled(SP_LOGGER_WARNING_ERROR_LEVEL));
+	ASSERT_FALSE(spLoggerIsLevelEnabled(SP_LOGGER_INFO_WARNING_ERROR_LEVEL));
+	ASSERT_FALSE(spLoggerIsLevelEnabled(SP_LOGGER_DEBUG_INFO_WARNING_ERROR_LEVEL));
+	spLoggerSafePrintDebug(NULL, NULL, NULL, -1); // skipped by the inline check
+	spLoggerSafePrintInfo(NULL);
+	spLoggerDestroy();
+
+	ASSERT_TRUE(spLoggerIsLevelEnabled(SP_LOGGER_DEBUG_INFO_WARNING_ERROR_LEVEL));
+	remove(LOGGER_TESTS_FILE);
+	return true;
+}
+
+static bool asyncLoggerFormatTest() {
+	ASSERT_TRUE(spLoggerCreateAsync(LOGGER_TESTS_FILE, SP_LOGGER_INFO_WARNING_ERROR_LEVEL) ==
+			SP_LOGGER_SUCCESS);
+	ASSERT_TRUE(spLoggerPrintError("an error", "file.c", "func", 7) == SP_LOGGER_SUCCESS);
+	ASSERT_TRUE(spLoggerPrintWarning("a warning", "file.c", "func", 8) == SP_LOGGER_SUCCESS);
+	ASSERT_TRUE(spLoggerPrintInfo("an info") == SP_LOGGER_SUCCESS);
+	ASSERT_TRUE(spLoggerPrintDebug("a debug", "file.c", "func", 9) == SP_LOGGER_SUCCESS);
+	ASSERT_TRUE(spLoggerPrintMsg("a message") == SP_LOGGER_SUCCESS);
+	ASSERT_TRUE(spLoggerPrintError(NULL, "file.c", "func", 7) == SP_LOGGER_INVAlID_ARGUMENT);
+	ASSERT_TRUE(spLoggerPrintInfo(NULL) == SP_LOGGER_INVAlID_ARGUMENT);
+	spLoggerSafePrintInfo("a safe info");
+	spLoggerDestroy();
+
+	ASSERT_TRUE(countLinesWith("---ERROR---") == 1);
+	ASSERT_TRUE(countLinesWith("---WARNING---") == 1);
+	ASSERT_TRUE(countLinesWith("---INFO---") == 2);
+	ASSERT_TRUE(countLinesWith("---DEBUG---") == 0);
+	ASSERT_TRUE(countLinesWith("- file: file.c") == 2);
+	ASSERT_TRUE(countLinesWith("- function: func") == 2);
+	ASSERT_TRUE(countLinesWith("- line: 8") == 1);
+	ASSERT_TRUE(countLinesWith("- message: an error") == 1);
+	ASSERT_TRUE(countLinesWith("- message: an info") == 1);
+	ASSERT_TRUE(countLinesWith("a message") == 1);
+	ASSERT_TRUE(countLinesWith("a safe info") == 1);
+	ASSERT_TRUE(countLinesWith("- message: a safe info") == 0); // after the timestamp
+	remove(LOGGER_TESTS_FILE);
+	return true;
+}
+
+static bool asyncLoggerOrderTest() {
+	char line[LOGGER_TESTS_LINE_LEN], expected[LOGGER_TESTS_LINE_LEN];
+	char longMsg[LOGGER_TESTS_LONG_MSG_LEN];
+	FILE* file;
+	int i;
+
+	memset(longMsg, 'a', LOGGER_TESTS_LONG_MSG_LEN - 1);
+	longMsg[LOGGER_TESTS_LONG_MSG_LEN - 1] = '\0';
+
+	ASSERT_TRUE(spLoggerCreateAsync(LOGGER_TESTS_FILE, SP_LOGGER_ERROR_LEVEL) ==
+			SP_LOGGER_SUCCESS);
+	for (i = 0; i < LOGGER_TESTS_MESSAGES; i++) {
+		sprintf(line, LOGGER_TESTS_MSG_FORMAT, 0, i);
+		ASSERT_TRUE(spLoggerPrintMsg(line) == SP_LOGGER_SUCCESS);
+	}
+	ASSERT_TRUE(spLoggerPrintMsg(longMsg) == SP_LOGGER_SUCCESS);
+	spLoggerDestroy();
+
+	file = fopen(LOGGER_TESTS_FILE, "r");
+	ASSERT_TRUE(file != NULL);
+	for (i = 0; i < LOGGER_TESTS_MESSAGES; i++) {
+		sprintf(expected, LOGGER_TESTS_MSG_FORMAT, 0, i);
+		ASSERT_TRUE(readLine(file, line));
+		ASSERT_TRUE(!strcmp(line, expected));
+	}
+	ASSERT_TRUE(readLine(file, line)); // truncated
+	ASSERT_TRUE(strlen(line) > 0 && strlen(line) < LOGGER_TESTS_LONG_MSG_LEN - 1);
+	ASSERT_FALSE(readLine(file, line));
+	fclose(file);
+	remove(LOGGER_TESTS_FILE);
+	return true;
+}
+
+static void* runLoggerThread(void* data) {
+	char msg[LOGGER_TESTS_LINE_LEN];
+	int i;
+	LoggerTestThread* thread = (LoggerTestThread*) data;
+
+	thread->success = true;
+	for (i = 0; thread->success && i < LOGGER_TESTS_THREAD_MESSAGES; i++) {
+		sprintf(msg, LOGGER_TESTS_MSG_FORMAT, thread->id, i);
+		thread->success = spLoggerPrintMsg(msg) == SP_LOGGER_SUCCESS;
+	}
+	return NULL;
+}
+
+/*
+ * Several threads print at once to an async logger, every message must be written
+ * whole, once, and after the previous messages of its thread
+ */
+static bool asyncLoggerConcurrentPrintsTest() {
+	pthread_t threadIds[LOGGER_TESTS_THREADS];
+	LoggerTestThread threads[LOGGER_TESTS_THREADS];
+	int t, id, index, next[LOGGER_TESTS_THREADS] = { 0 };
+	char line[LOGGER_TESTS_LINE_LEN];
+	bool rslt = true;
+	FILE* file;
+
+	ASSERT_TRUE(spLoggerCreateAsync(LOGGER_TESTS_FILE, SP_LOGGER_ERROR_LEVEL) ==
+			SP_LOGGER_SUCCESS);
+	for (t = 0; t < LOGGER_TESTS_THREADS; t++) {
+		threads[t].id = t;
+		ASSERT_TRUE(pthread_create(&(threadIds[t]), NULL, runLoggerThread, &(threads[t])) == 0);
+	}
+	for (t = 0; t < LOGGER_TESTS_THREADS; t++) {
+		pthread_join(threadIds[t], NULL);
+		rslt = rslt && threads[t].success;
+	}
+	spLoggerDestroy();
+	ASSERT_TRUE(rslt);
+
+	file = fopen(LOGGER_TESTS_FILE, "r");
+	ASSERT_TRUE(file != NULL);
+	while (rslt && readLine(file, line)) {
+		rslt = sscanf(line, LOGGER_TESTS_MSG_FORMAT, &id, &index) == 2 && id >= 0 &&
+				id < LOGGER_TESTS_THREADS && index == next[id]++;
+	}
+	fclose(file);
+	ASSERT_TRUE(rslt);
+	for (t = 0; t < LOGGER_TESTS_THREADS; t++)
+		ASSERT_TRUE(next[t] == LOGGER_TESTS_THREAD_MESSAGES);
+	remove(LOGGER_TESTS_FILE);
+	return true;
+}
+
+/*
+ * A child forked while the writer thread is busy writes its own message once, and
+ * none of the messages its parent printed before the fork
+ */
+static bool asyncLoggerForkTest() {
+	int i, id, index, status, next[2] = { 0 };
+	char line[LOGGER_TESTS_LINE_LEN];
+	bool rslt = true;
+	pid_t child;
+	FILE* file;
+
+	ASSERT_TRUE(spLoggerCreateAsync(LOGGER_TESTS_FILE, SP_LOGGER_ERROR_LEVEL) ==
+			SP_LOGGER_SUCCESS);
+	for (i = 0; i < LOGGER_TESTS_MESSAGES; i++) {
+		sprintf(line, LOGGER_TESTS_MSG_FORMAT, 0, i);
+		ASSERT_TRUE(spLoggerPrintMsg(line) == SP_LOGGER_SUCCESS);
+	}
+	ASSERT_TRUE((child = fork()) >= 0);
+	if (child == 0) {
+		sprintf(line, LOGGER_TESTS_MSG_FORMAT, 1, 0);
+		exit(spLoggerPrintMsg(line) == SP_LOGGER_SUCCESS ? EXIT_SUCCESS : EXIT_FAILURE);
+	}
+	ASSERT_TRUE(waitpid(child, &status, 0) == child);
+	spLoggerDestroy();
+	ASSERT_TRUE(WIFEXITED(status) && WEXITSTATUS(status) == EXIT_SUCCESS);
+
+	file = fopen(LOGGER_TESTS_FILE, "r");
+	ASSERT_TRUE(file != NULL);
+	while (rslt && readLine(file, line)) {
+		rslt = sscanf(line, LOGGER_TESTS_MSG_FORMAT, &id, &index) == 2 && id >= 0 &&
+				id < 2 && index == next[id]++;
+	}
+	fclose(file);
+	ASSERT_TRUE(rslt);
+	ASSERT_TRUE(next[0] == LOGGER_TESTS_MESSAGES && next[1] == 1);
+	remove(LOGGER_TESTS_FILE);
+	return true;
+}
+
+void runLoggerTests() {
+	RUN_TEST(loggerLevelCheckTest);
+	RUN_TEST(asyncLoggerFormatTest);
+	RUN_TEST(asyncLoggerOrderTest);
+	RUN_TEST(asyncLoggerConcurrentPrintsTest);
+	RUN_TEST(asyncLoggerForkTest);
+}
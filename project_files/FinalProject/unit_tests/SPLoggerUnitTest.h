@@ -0,0 +1,12 @@
+#ifndef SPLOGGERUNITTEST_H_
+#define SPLOGGERUNITTEST_H_
+
+
+
+/*
+ * The tests create and destroy their own loggers, thus they must run while the
+ * logger is undefined
+ */
+void runLoggerTests();
+
+#endif /* SPLOGGERUNITTEST_H_ */
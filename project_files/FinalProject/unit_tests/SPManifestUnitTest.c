@@ -0,0 +1,241 @@
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <utime.h>
+
+#include "unit_test_util.h"
+#include "SPManifestUnitTest.h"
+#include "../SPPoint.h"
+#include "../SPConfig.h"
+#include "../image_parsing/SPImageData.h"
+#include "../image_parsing/SPImagesParser.h"
+#include "../image_parsing/SPFeatsWriter.h"
+#include "../image_parsing/SPManifest.h"
+
+#define MANIFEST_TESTS_HASH_FILE		"./unit_tests/manifestHashTest.txt"
+#define MANIFEST_TESTS_CONFIG_FILE		"./unit_tests/manifestTest.config"
+#define MANIFEST_TESTS_CONFIG			"spImagesDirectory = ./unit_tests/\nspImagesPrefix = manifestTest\n" \
+										"spImagesSuffix = .png\nspPCAFilename = manifestTest.yml\n" \
+										"spManifestFilename = manifestTest.manifest\nspSaveThreads = 2\n" \
+										"spNumOfImages = "
+#define MANIFEST_TESTS_PCA_FILE			"./unit_tests/manifestTest.yml"
+#define MANIFEST_TESTS_MANIFEST_FILE	"./unit_tests/manifestTest.manifest"
+#define MANIFEST_TESTS_NUM_OF_IMAGES	4
+#define MANIFEST_TESTS_DIM				20
+#define MANIFEST_TESTS_OLD_MTIME		1000000
+#define MANIFEST_TESTS_PATH_LEN			64
+#define MANIFEST_TESTS_LINE_LEN			4096
+
+/*
+ * Counts the lines of a file
+ */
+static int countLines(const char* filename) {
+	char line[MANIFEST_TESTS_LINE_LEN];
+	int count = 0;
+	FILE* file = fopen(filename, "r");
+	if (file == NULL)
+		return -1;
+	while (fgets(line, MANIFEST_TESTS_LINE_LEN, file) != NULL)
+		count++;
+	fclose(file);
+	return count;
+}
+
+/*
+ * Creates the test configuration with the given number of images, and their image files
+ */
+static SPConfig createTestConfig(int numOfImages) {
+	SP_CONFIG_MSG configMsg = SP_CONFIG_SUCCESS;
+	char content[MANIFEST_TESTS_LINE_LEN], path[MANIFEST_TESTS_PATH_LEN];
+	int i;
+
+	sprintf(content, "%s%d\n", MANIFEST_TESTS_CONFIG, numOfImages);
+	if (!writeFile(MANIFEST_TESTS_CONFIG_FILE, content))
+		return NULL;
+	for (i = 0; i < numOfImages; i++) {
+		sprintf(path, "./unit_tests/manifestTest%d.png", i);
+		sprintf(content, "the pixels of image %d", i);
+		if (access(path, F_OK) != 0 && !writeFile(path, content))
+			return NULL;
+	}
+	return spConfigCreate(MANIFEST_TESTS_CONFIG_FILE, &configMsg);
+}
+
+/*
+ * Creates an image data item with index + 1 features whose coordinates depend on the index
+ */
+static SPImageData createTestImageData(int index) {
+	double data[MANIFEST_TESTS_DIM];
+	SPImageData imageData;
+	int i, j;
+
+	if ((imageData = createImageData(index)) == NULL)
+		return NULL;
+	if ((imageData->featuresArray = (SPPoint*) calloc(index + 1, sizeof(SPPoint))) == NULL) {
+		freeImageData(imageData, true, true);
+		return NULL;
+	}
+	imageData->numOfFeatures = index + 1;
+	for (i = 0; i < index + 1; i++) {
+		for (j = 0; j < MANIFEST_TESTS_DIM; j++)
+			data[j] = index * 100.0 + i - j / 4.0;
+		imageData->featuresArray[i] = spPointCreate(data, MANIFEST_TESTS_DIM, index);
+	}
+	return imageData;
+}
+
+/*
+ * Loads the descriptors of an unchanged image, and checks they are the ones of
+ * createTestImageData
+ */
+static bool isReused(SPManifest manifest, int index, bool expectedIsSaveNeeded) {
+	SPImageData loaded = createImageData(index), expected = createTestImageData(index);
+	bool isSaveNeeded = !expectedIsSaveNeeded, successFlag;
+	int i;
+
+	successFlag = loaded != NULL && expected != NULL &&
+			spManifestLoadImageData(manifest, loaded, &isSaveNeeded) == SP_DP_SUCCESS &&
+			isSaveNeeded == expectedIsSaveNeeded &&
+			loaded->numOfFeatures == expected->numOfFeatures;
+	for (i = 0; successFlag && i < loaded->numOfFeatures; i++)
+		successFlag = spPointL2SquaredDistance(loaded->featuresArray[i],
+				expected->featuresArray[i]) < 1e-6;
+	freeImageData(loaded, true, true);
+	freeImageData(expected, true, true);
+	return successFlag;
+}
+
+/*
+ * Removes all the files of the test configuration
+ */
+static void removeTestFiles(SPConfig config, int numOfImages) {
+	char path[MANIFEST_TESTS_PATH_LEN];
+	int i;
+
+	for (i = 0; i < numOfImages; i++) {
+		spConfigGetImagePath(path, config, i);
+		remove(path);
+		spConfigGetImagePathFeats(path, config, i, true);
+		remove(path);
+	}
+	remove(MANIFEST_TESTS_PCA_FILE);
+	remove(MANIFEST_TESTS_MANIFEST_FILE);
+	remove(MANIFEST_TESTS_CONFIG_FILE);
+}
+
+static bool manifestHashTest() {
+	unsigned long long hash = 0;
+
+	ASSERT_TRUE(writeFile(MANIFEST_TESTS_HASH_FILE, ""));
+	ASSERT_TRUE(spManifestHashFile(MANIFEST_TESTS_HASH_FILE, &hash) == SP_DP_SUCCESS);
+	ASSERT_TRUE(hash == 0xcbf29ce484222325ULL);
+	ASSERT_TRUE(writeFile(MANIFEST_TESTS_HASH_FILE, "a"));
+	ASSERT_TRUE(spManifestHashFile(MANIFEST_TESTS_HASH_FILE, &hash) == SP_DP_SUCCESS);
+	ASSERT_TRUE(hash == 0xaf63dc4c8601ec8cULL);
+	remove(MANIFEST_TESTS_HASH_FILE);
+
+	ASSERT_TRUE(spManifestHashFile(MANIFEST_TESTS_HASH_FILE, &hash) == SP_DP_FILE_READ_ERROR);
+	ASSERT_TRUE(spManifestHashFile(NULL, &hash) == SP_DP_INVALID_ARGUMENT);
+	ASSERT_TRUE(spManifestHashFile(MANIFEST_TESTS_HASH_FILE, NULL) == SP_DP_INVALID_ARGUMENT);
+	return true;
+}
+
+static bool manifestUpdateTest() {
+	SPImageData allImagesData[MANIFEST_TESTS_NUM_OF_IMAGES];
+	char path[MANIFEST_TESTS_PATH_LEN];
+	struct utimbuf times = { MANIFEST_TESTS_OLD_MTIME, MANIFEST_TESTS_OLD_MTIME };
+	SPFeatsWriter writer;
+	SPManifest manifest;
+	SPConfig config;
+	SP_CONFIG_MSG configMsg = SP_CONFIG_SUCCESS;
+	FILE* file;
+	int i;
+
+	ASSERT_TRUE(writeFile(MANIFEST_TESTS_PCA_FILE, "the PCA"));
+	ASSERT_TRUE((config = createTestConfig(MANIFEST_TESTS_NUM_OF_IMAGES)) != NULL);
+	ASSERT_TRUE(spManifestCreate(NULL) == NULL);
+
+	// a full extraction, the writer commits the saved images
+	ASSERT_TRUE((manifest = spManifestCreate(config)) != NULL);
+	ASSERT_TRUE(countLines(MANIFEST_TESTS_MANIFEST_FILE) == 1);
+	ASSERT_TRUE((writer = spFeatsWriterCreate(config, manifest)) != NULL);
+	for (i = 0; i < MANIFEST_TESTS_NUM_OF_IMAGES; i++) {
+		ASSERT_FALSE(spManifestCheckImage(manifest, i));
+		ASSERT_TRUE((allImagesData[i] = createTestImageData(i)) != NULL);
+		ASSERT_TRUE(spFeatsWriterSubmit(writer, allImagesData[i]) == SP_DP_SUCCESS);
+	}
+	ASSERT_TRUE(spFeatsWriterFinish(writer, 0) == SP_DP_SUCCESS);
+	spFeatsWriterDestroy(writer);
+	for (i = 0; i < MANIFEST_TESTS_NUM_OF_IMAGES; i++)
+		freeImageData(allImagesData[i], true, true);
+	ASSERT_TRUE(spManifestCommit(manifest, MANIFEST_TESTS_NUM_OF_IMAGES, 1) ==
+			SP_DP_INVALID_ARGUMENT);
+	// the manifest is not saved, as if the extraction crashed, and a line is broken
+	spManifestDestroy(manifest);
+	ASSERT_TRUE(countLines(MANIFEST_TESTS_MANIFEST_FILE) == 1 + MANIFEST_TESTS_NUM_OF_IMAGES);
+	file = fopen(MANIFEST_TESTS_MANIFEST_FILE, "a");
+	ASSERT_TRUE(file != NULL);
+	fputs("0 12 34", file);
+	fclose(file);
+
+	// an update reuses all the images
+	ASSERT_TRUE((manifest = spManifestCreate(config)) != NULL);
+	for (i = 0; i < MANIFEST_TESTS_NUM_OF_IMAGES; i++) {
+		ASSERT_TRUE(spManifestCheckImage(manifest, i));
+		ASSERT_TRUE(isReused(manifest, i, false));
+	}
+	ASSERT_TRUE(spManifestSave(manifest) == SP_DP_SUCCESS);
+	ASSERT_TRUE(countLines(MANIFEST_TESTS_MANIFEST_FILE) == 1 + MANIFEST_TESTS_NUM_OF_IMAGES);
+	spManifestDestroy(manifest);
+
+	// a changed image, a touched image and a missing .feats file
+	ASSERT_TRUE(writeFile("./unit_tests/manifestTest1.png", "the new pixels of image 1"));
+	ASSERT_TRUE(utime("./unit_tests/manifestTest2.png", &times) == 0);
+	spConfigGetImagePathFeats(path, config, 3, true);
+	remove(path);
+	ASSERT_TRUE((manifest = spManifestCreate(config)) != NULL);
+	ASSERT_TRUE(spManifestCheckImage(manifest, 0) && isReused(manifest, 0, false));
+	ASSERT_FALSE(spManifestCheckImage(manifest, 1));
+	ASSERT_TRUE(spManifestCheckImage(manifest, 2) && isReused(manifest, 2, false));
+	ASSERT_TRUE(spManifestCheckImage(manifest, 3) && !isReused(manifest, 3, false));
+	spManifestDestroy(manifest);
+	// the entry of the touched image has its new time, the others are unchanged
+	ASSERT_TRUE(countLines(MANIFEST_TESTS_MANIFEST_FILE) == 2 + MANIFEST_TESTS_NUM_OF_IMAGES);
+
+	// another PCA file changes all the descriptors
+	ASSERT_TRUE(writeFile(MANIFEST_TESTS_PCA_FILE, "another PCA"));
+	ASSERT_TRUE((manifest = spManifestCreate(config)) != NULL);
+	ASSERT_FALSE(spManifestCheckImage(manifest, 0));
+	ASSERT_FALSE(spManifestCheckImage(manifest, 2));
+	spManifestDestroy(manifest);
+	ASSERT_TRUE(writeFile(MANIFEST_TESTS_PCA_FILE, "the PCA"));
+
+	// so does another resolution
+	ASSERT_TRUE(handleVariable(config, "a", 1, "spMaxImageDimension", "640", &configMsg));
+	ASSERT_TRUE((manifest = spManifestCreate(config)) != NULL);
+	ASSERT_FALSE(spManifestCheckImage(manifest, 0));
+	spManifestDestroy(manifest);
+	ASSERT_TRUE(handleVariable(config, "a", 1, "spMaxImageDimension", "0", &configMsg));
+
+	// a new image changes the signature, the unchanged images are saved again
+	spConfigDestroy(config);
+	ASSERT_TRUE((config = createTestConfig(MANIFEST_TESTS_NUM_OF_IMAGES + 1)) != NULL);
+	ASSERT_TRUE((manifest = spManifestCreate(config)) != NULL);
+	ASSERT_TRUE(spManifestCheckImage(manifest, 0) && isReused(manifest, 0, true));
+	ASSERT_TRUE(spManifestCheckImage(manifest, 2) && isReused(manifest, 2, true));
+	ASSERT_FALSE(spManifestCheckImage(manifest, MANIFEST_TESTS_NUM_OF_IMAGES));
+	ASSERT_FALSE(spManifestCheckImage(manifest, MANIFEST_TESTS_NUM_OF_IMAGES + 1));
+	spManifestDestroy(manifest);
+	spManifestDestroy(NULL);
+
+	removeTestFiles(config, MANIFEST_TESTS_NUM_OF_IMAGES + 1);
+	spConfigDestroy(config);
+	return true;
+}
+
+void runManifestTests() {
+	RUN_TEST(manifestHashTest);
+	RUN_TEST(manifestUpdateTest);
+}
@@ -0,0 +1,8 @@
+#ifndef SPMANIFESTUNITTEST_H_
+#define SPMANIFESTUNITTEST_H_
+
+
+
+void runManifestTests();
+
+#endif /* SPMANIFESTUNITTEST_H_ */
@@ -0,0 +1,169 @@
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "unit_test_util.h"
+#include "SPPCAFileUnitTest.h"
+#include "../SPPCAProjection.h"
+#include "../SPPCAFile.h"
+
+#define PCA_FILE_TESTS_PATH			"./unit_tests/pcaFileTest.yml" SP_PCA_BINARY_SUFFIX
+#define PCA_FILE_TESTS_INPUT_DIM	128
+#define PCA_FILE_TESTS_DIM			20
+#define PCA_FILE_TESTS_ROWS			10
+#define PCA_FILE_TESTS_CORRUPTED	1000 // a byte offset inside the eigenvectors
+#define PCA_FILE_TESTS_HASH			0x0123456789ABCDEFULL // the hash of the YAML PCA file
+
+static float eigenvectors[PCA_FILE_TESTS_DIM * PCA_FILE_TESTS_INPUT_DIM];
+static float eigenvalues[PCA_FILE_TESTS_DIM];
+static float mean[PCA_FILE_TESTS_INPUT_DIM];
+static float rows[PCA_FILE_TESTS_ROWS * PCA_FILE_TESTS_INPUT_DIM];
+
+/*
+ * Fills the PCA and the rows with random floats
+ */
+static void initRandomPCA() {
+	int i;
+	srand(17);
+	for (i = 0; i < PCA_FILE_TESTS_DIM * PCA_FILE_TESTS_INPUT_DIM; i++)
+		eigenvectors[i] = (float) rand() / RAND_MAX - 0.5f;
+	for (i = 0; i < PCA_FILE_TESTS_DIM; i++)
+		eigenvalues[i] = (float) (PCA_FILE_TESTS_DIM - i);
+	for (i = 0; i < PCA_FILE_TESTS_INPUT_DIM; i++)
+		mean[i] = (float) rand() / RAND_MAX * 10;
+	for (i = 0; i < PCA_FILE_TESTS_ROWS * PCA_FILE_TESTS_INPUT_DIM; i++)
+		rows[i] = (float) rand() / RAND_MAX * 100;
+}
+
+/*
+ * Returns true if two projections project the rows on the first dim components the same
+ */
+static bool isSameProjection(SPPCAProjection loaded, SPPCAProjection expected, int dim) {
+	float loadedRows[PCA_FILE_TESTS_ROWS * PCA_FILE_TESTS_DIM];
+	float expectedRows[PCA_FILE_TESTS_ROWS * PCA_FILE_TESTS_DIM];
+	return spPCAProjectionGetDim(loaded) == dim &&
+			spPCAProjectionGetInputDim(loaded) == PCA_FILE_TESTS_INPUT_DIM &&
+			spPCAProjectionProject(loaded, rows, PCA_FILE_TESTS_ROWS, loadedRows) &&
+			spPCAProjectionProject(expected, rows, PCA_FILE_TESTS_ROWS, expectedRows) &&
+			memcmp(loadedRows, expectedRows, PCA_FILE_TESTS_ROWS * dim * sizeof(float)) == 0;
+}
+
+/*
+ * Changes a byte of a file, or truncates it to that byte
+ */
+static bool damageFile(const char* path, long offset, bool isTruncated) {
+	unsigned char buffer[PCA_FILE_TESTS_CORRUPTED * 16];
+	size_t length;
+	FILE* file = fopen(path, "rb");
+	if (file == NULL)
+		return false;
+	length = fread(buffer, 1, sizeof(buffer), file);
+	fclose(file);
+	if ((long) length <= offset)
+		return false;
+	if (isTruncated)
+		length = (size_t) offset;
+	else
+		buffer[offset] ^= 0x01;
+	file = fopen(path, "wb");
+	if (file == NULL)
+		return false;
+	fwrite(buffer, 1, length, file);
+	fclose(file);
+	return true;
+}
+
+static bool pcaFileArgumentsTest() {
+	ASSERT_FALSE(spPCAFileSave(NULL, mean, eigenvectors, eigenvalues, 2, 1,
+			PCA_FILE_TESTS_HASH));
+	ASSERT_FALSE(spPCAFileSave(PCA_FILE_TESTS_PATH, NULL, eigenvectors, eigenvalues, 2, 1,
+			PCA_FILE_TESTS_HASH));
+	ASSERT_FALSE(spPCAFileSave(PCA_FILE_TESTS_PATH, mean, eigenvectors, eigenvalues, 0, 1,
+			PCA_FILE_TESTS_HASH));
+	ASSERT_TRUE(spPCAFileLoad(NULL, 1, PCA_FILE_TESTS_HASH) == NULL);
+	ASSERT_TRUE(spPCAFileLoad(PCA_FILE_TESTS_PATH, 0, PCA_FILE_TESTS_HASH) == NULL);
+	remove(PCA_FILE_TESTS_PATH);
+	ASSERT_TRUE(spPCAFileLoad(PCA_FILE_TESTS_PATH, 1, PCA_FILE_TESTS_HASH) == NULL); // no file
+	return true;
+}
+
+//checks a saved PCA is loaded into the same projection, on all or on some components
+static bool pcaFileRoundTripTest() {
+	SPPCAProjection loaded = NULL, expected = NULL;
+	initRandomPCA();
+	ASSERT_TRUE(spPCAFileSave(PCA_FILE_TESTS_PATH, mean, eigenvectors, eigenvalues,
+			PCA_FILE_TESTS_INPUT_DIM, PCA_FILE_TESTS_DIM, PCA_FILE_TESTS_HASH));
+
+	loaded = spPCAFileLoad(PCA_FILE_TESTS_PATH, PCA_FILE_TESTS_DIM, PCA_FILE_TESTS_HASH);
+	expected = spPCAProjectionCreate(eigenvectors, mean, PCA_FILE_TESTS_INPUT_DIM,
+			PCA_FILE_TESTS_DIM);
+	ASSERT_TRUE(loaded != NULL && expected != NULL);
+	ASSERT_TRUE(isSameProjection(loaded, expected, PCA_FILE_TESTS_DIM));
+	spPCAProjectionDestroy(loaded);
+	spPCAProjectionDestroy(expected);
+
+	loaded = spPCAFileLoad(PCA_FILE_TESTS_PATH, PCA_FILE_TESTS_DIM / 2, PCA_FILE_TESTS_HASH);
+	expected = spPCAProjectionCreate(eigenvectors, mean, PCA_FILE_TESTS_INPUT_DIM,
+			PCA_FILE_TESTS_DIM / 2);
+	ASSERT_TRUE(loaded != NULL && expected != NULL);
+	ASSERT_TRUE(isSameProjection(loaded, expected, PCA_FILE_TESTS_DIM / 2));
+	spPCAProjectionDestroy(loaded);
+	spPCAProjectionDestroy(expected);
+
+	// more components than the file has
+	ASSERT_TRUE(spPCAFileLoad(PCA_FILE_TESTS_PATH, PCA_FILE_TESTS_DIM + 1,
+			PCA_FILE_TESTS_HASH) == NULL);
+	remove(PCA_FILE_TESTS_PATH);
+	return true;
+}
+
+//checks a corrupted or truncated file is not loaded
+static bool pcaFileDamagedTest() {
+	initRandomPCA();
+	ASSERT_TRUE(spPCAFileSave(PCA_FILE_TESTS_PATH, mean, eigenvectors, eigenvalues,
+			PCA_FILE_TESTS_INPUT_DIM, PCA_FILE_TESTS_DIM, PCA_FILE_TESTS_HASH));
+	ASSERT_TRUE(damageFile(PCA_FILE_TESTS_PATH, PCA_FILE_TESTS_CORRUPTED, false));
+	ASSERT_TRUE(spPCAFileLoad(PCA_FILE_TESTS_PATH, PCA_FILE_TESTS_DIM,
+			PCA_FILE_TESTS_HASH) == NULL);
+
+	ASSERT_TRUE(spPCAFileSave(PCA_FILE_TESTS_PATH, mean, eigenvectors, eigenvalues,
+			PCA_FILE_TESTS_INPUT_DIM, PCA_FILE_TESTS_DIM, PCA_FILE_TESTS_HASH));
+	ASSERT_TRUE(damageFile(PCA_FILE_TESTS_PATH, 0, false)); // the magic
+	ASSERT_TRUE(spPCAFileLoad(PCA_FILE_TESTS_PATH, PCA_FILE_TESTS_DIM,
+			PCA_FILE_TESTS_HASH) == NULL);
+
+	ASSERT_TRUE(spPCAFileSave(PCA_FILE_TESTS_PATH, mean, eigenvectors, eigenvalues,
+			PCA_FILE_TESTS_INPUT_DIM, PCA_FILE_TESTS_DIM, PCA_FILE_TESTS_HASH));
+	ASSERT_TRUE(damageFile(PCA_FILE_TESTS_PATH, PCA_FILE_TESTS_CORRUPTED, true));
+	ASSERT_TRUE(spPCAFileLoad(PCA_FILE_TESTS_PATH, PCA_FILE_TESTS_DIM,
+			PCA_FILE_TESTS_HASH) == NULL);
+	remove(PCA_FILE_TESTS_PATH);
+	return true;
+}
+
+//checks a file saved with another YAML PCA file is not loaded, and is loaded again
+//once it is saved with the current one
+static bool pcaFileSourceHashTest() {
+	SPPCAProjection loaded = NULL;
+	initRandomPCA();
+	ASSERT_TRUE(spPCAFileSave(PCA_FILE_TESTS_PATH, mean, eigenvectors, eigenvalues,
+			PCA_FILE_TESTS_INPUT_DIM, PCA_FILE_TESTS_DIM, PCA_FILE_TESTS_HASH));
+	ASSERT_TRUE(spPCAFileLoad(PCA_FILE_TESTS_PATH, PCA_FILE_TESTS_DIM,
+			PCA_FILE_TESTS_HASH + 1) == NULL);
+
+	ASSERT_TRUE(spPCAFileSave(PCA_FILE_TESTS_PATH, mean, eigenvectors, eigenvalues,
+			PCA_FILE_TESTS_INPUT_DIM, PCA_FILE_TESTS_DIM, PCA_FILE_TESTS_HASH + 1));
+	loaded = spPCAFileLoad(PCA_FILE_TESTS_PATH, PCA_FILE_TESTS_DIM, PCA_FILE_TESTS_HASH + 1);
+	ASSERT_TRUE(loaded != NULL);
+	spPCAProjectionDestroy(loaded);
+	remove(PCA_FILE_TESTS_PATH);
+	return true;
+}
+
+void runPCAFileTests() {
+	RUN_TEST(pcaFileArgumentsTest);
+	RUN_TEST(pcaFileRoundTripTest);
+	RUN_TEST(pcaFileDamagedTest);
+	RUN_TEST(pcaFileSourceHashTest);
+}
@@ -0,0 +1,8 @@
+#ifndef SPPCAFILEUNITTEST_H_
+#define SPPCAFILEUNITTEST_H_
+
+
+
+void runPCAFileTests();
+
+#endif /* SPPCAFILEUNITTEST_H_ */
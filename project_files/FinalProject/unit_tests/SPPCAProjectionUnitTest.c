@@ -0,0 +1,236 @@
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <pthread.h>
+
+#include "unit_test_util.h"
+#include "SPPCAProjectionUnitTest.h"
+#include "../SPPoint.h"
+#include "../SPPCAProjection.h"
+
+#define PCA_PROJECTION_TESTS_INPUT_DIM	130 // not a multiple of the input panels
+#define PCA_PROJECTION_TESTS_DIM		20
+#define PCA_PROJECTION_TESTS_ROWS		77 // not a multiple of the row blocks
+#define PCA_PROJECTION_TESTS_EPSILON	0.001
+#define PCA_PROJECTION_TESTS_HALF_EPSILON	0.05
+#define PCA_PROJECTION_TESTS_THREADS	4
+
+/*
+ * The arguments of a thread that projects the shared rows with the shared projection
+ */
+typedef struct projection_thread_args_t {
+	SPPCAProjection projection;
+	const float* rows;
+	float* projected;
+	bool isProjected;
+} projection_thread_args_t;
+
+/*
+ * Returns a random float in [-range, range]
+ */
+static float randomFloat(float range) {
+	return range * (2.0f * rand() / RAND_MAX - 1.0f);
+}
+
+/*
+ * Fills an array with random floats in [-range, range]
+ */
+static void randomFloats(float* data, int count, float range) {
+	int i;
+	for (i = 0; i < count; i++)
+		data[i] = randomFloat(range);
+}
+
+/*
+ * Projects the rows one by one the way the definition reads
+ */
+static void naiveProject(const float* eigenvectors, const float* mean, const float* rows,
+		int numOfRows, int inputDim, int dim, double* projected) {
+	int r, k, j;
+	for (r = 0; r < numOfRows; r++)
+		for (k = 0; k < dim; k++) {
+			projected[r * dim + k] = 0;
+			for (j = 0; j < inputDim; j++)
+				projected[r * dim + k] += (double) eigenvectors[k * inputDim + j] *
+						((double) rows[r * inputDim + j] - mean[j]);
+		}
+}
+
+static bool pcaProjectionArgumentsTest() {
+	float eigenvectors[6] = { 1, 0, 0, 0, 1, 0 }, mean[3] = { 0 }, row[3] = { 1, 2, 3 },
+			projected[2];
+	SPPCAProjection projection = NULL;
+	SPPoint* points = NULL;
+	ASSERT_TRUE(spPCAProjectionCreate(NULL, mean, 3, 2) == NULL);
+	ASSERT_TRUE(spPCAProjectionCreate(eigenvectors, NULL, 3, 2) == NULL);
+	ASSERT_TRUE(spPCAProjectionCreate(eigenvectors, mean, 0, 2) == NULL);
+	ASSERT_TRUE(spPCAProjectionCreate(eigenvectors, mean, 3, 0) == NULL);
+	ASSERT_TRUE(spPCAProjectionGetDim(NULL) == -1);
+	ASSERT_TRUE(spPCAProjectionGetInputDim(NULL) == -1);
+	ASSERT_FALSE(spPCAProjectionProject(NULL, row, 1, projected));
+	ASSERT_TRUE(spPCAProjectionCreatePoints(NULL, row, 1, 0) == NULL);
+
+	projection = spPCAProjectionCreate(eigenvectors, mean, 3, 2);
+	ASSERT_TRUE(projection != NULL);
+	ASSERT_TRUE(spPCAProjectionGetDim(projection) == 2);
+	ASSERT_TRUE(spPCAProjectionGetInputDim(projection) == 3);
+	ASSERT_FALSE(spPCAProjectionProject(projection, NULL, 1, projected));
+	ASSERT_FALSE(spPCAProjectionProject(projection, row, -1, projected));
+	ASSERT_TRUE(spPCAProjectionProject(projection, NULL, 0, NULL));
+	ASSERT_TRUE(spPCAProjectionCreatePoints(projection, row, 1, -1) == NULL);
+	ASSERT_TRUE(spPCAProjectionProject(projection, row, 1, projected));
+	ASSERT_TRUE(projected[0] == 1 && projected[1] == 2);
+
+	// no descriptors give an array with a single empty slot
+	points = spPCAProjectionCreatePoints(projection, NULL, 0, 0);
+	ASSERT_TRUE(points != NULL && points[0] == NULL);
+	free(points);
+	spPCAProjectionDestroy(projection);
+	spPCAProjectionDestroy(NULL);
+	return true;
+}
+
+//checks the blocked projection against the naive one, for partial blocks and panels
+static bool pcaProjectionBlockedTest() {
+	const int inputDim = PCA_PROJECTION_TESTS_INPUT_DIM, dim = PCA_PROJECTION_TESTS_DIM;
+	float *eigenvectors = NULL, *mean = NULL, *rows = NULL, *projected = NULL;
+	double* expected = NULL;
+	SPPCAProjection projection = NULL;
+	int r, k, numOfRows;
+	bool isMatching = true;
+	srand(7);
+	eigenvectors = (float*) malloc(dim * inputDim * sizeof(float));
+	mean = (float*) malloc(inputDim * sizeof(float));
+	rows = (float*) malloc(PCA_PROJECTION_TESTS_ROWS * inputDim * sizeof(float));
+	projected = (float*) malloc(PCA_PROJECTION_TESTS_ROWS * dim * sizeof(float));
+	expected = (double*) malloc(PCA_PROJECTION_TESTS_ROWS * dim * sizeof(double));
+	ASSERT_TRUE(eigenvectors && mean && rows && projected && expected);
+	randomFloats(eigenvectors, dim * inputDim, 0.2f);
+	randomFloats(mean, inputDim, 10.0f);
+	randomFloats(rows, PCA_PROJECTION_TESTS_ROWS * inputDim, 100.0f);
+	projection = spPCAProjectionCreate(eigenvectors, mean, inputDim, dim);
+	ASSERT_TRUE(projection != NULL);
+
+	// a single row, a single partial block, and several blocks with a partial one
+	for (numOfRows = 1; numOfRows <= PCA_PROJECTION_TESTS_ROWS; numOfRows += 38) {
+		naiveProject(eigenvectors, mean, rows, numOfRows, inputDim, dim, expected);
+		ASSERT_TRUE(spPCAProjectionProject(projection, rows, numOfRows, projected));
+		for (r = 0; r < numOfRows; r++)
+			for (k = 0; k < dim; k++)
+				isMatching = isMatching && fabs(projected[r * dim + k] - expected[r * dim + k]) <
+						PCA_PROJECTION_TESTS_EPSILON * (1 + fabs(expected[r * dim + k]));
+		ASSERT_TRUE(isMatching);
+	}
+
+	spPCAProjectionDestroy(projection);
+	free(eigenvectors);
+	free(mean);
+	free(rows);
+	free(projected);
+	free(expected);
+	return true;
+}
+
+//checks the points are created at the default precision with the projected coordinates
+static bool pcaProjectionPointsTest() {
+	const SP_POINT_PRECISION precisions[3] = { SP_POINT_PRECISION_DOUBLE,
+			SP_POINT_PRECISION_FLOAT, SP_POINT_PRECISION_HALF };
+	const int inputDim = PCA_PROJECTION_TESTS_INPUT_DIM, dim = PCA_PROJECTION_TESTS_DIM,
+			numOfRows = 5;
+	const SP_POINT_PRECISION defaultPrecision = spPointGetDefaultPrecision();
+	float eigenvectors[PCA_PROJECTION_TESTS_DIM * PCA_PROJECTION_TESTS_INPUT_DIM],
+			mean[PCA_PROJECTION_TESTS_INPUT_DIM], rows[5 * PCA_PROJECTION_TESTS_INPUT_DIM];
+	double expected[5 * PCA_PROJECTION_TESTS_DIM];
+	SPPCAProjection projection = NULL;
+	SPPoint* points = NULL;
+	int p, r, k;
+	srand(11);
+	randomFloats(eigenvectors, dim * inputDim, 0.1f);
+	randomFloats(mean, inputDim, 1.0f);
+	randomFloats(rows, numOfRows * inputDim, 1.0f);
+	naiveProject(eigenvectors, mean, rows, numOfRows, inputDim, dim, expected);
+	projection = spPCAProjectionCreate(eigenvectors, mean, inputDim, dim);
+	ASSERT_TRUE(projection != NULL);
+
+	for (p = 0; p < 3; p++) {
+		spPointSetDefaultPrecision(precisions[p]);
+		points = spPCAProjectionCreatePoints(projection, rows, numOfRows, 4);
+		ASSERT_TRUE(points != NULL);
+		for (r = 0; r < numOfRows; r++) {
+			ASSERT_TRUE(spPointGetPrecision(points[r]) == precisions[p]);
+			ASSERT_TRUE(spPointGetIndex(points[r]) == 4);
+			ASSERT_TRUE(spPointGetDimension(points[r]) == dim);
+			for (k = 0; k < dim; k++)
+				ASSERT_TRUE(fabs(spPointGetAxisCoor(points[r], k) - expected[r * dim + k]) <
+						(precisions[p] == SP_POINT_PRECISION_HALF ?
+								PCA_PROJECTION_TESTS_HALF_EPSILON : PCA_PROJECTION_TESTS_EPSILON));
+			spPointDestroy(points[r]);
+		}
+		free(points);
+	}
+
+	spPointSetDefaultPrecision(defaultPrecision);
+	spPCAProjectionDestroy(projection);
+	return true;
+}
+
+static void* projectionThread(void* args) {
+	projection_thread_args_t* threadArgs = (projection_thread_args_t*) args;
+	threadArgs->isProjected = spPCAProjectionProject(threadArgs->projection, threadArgs->rows,
+			PCA_PROJECTION_TESTS_ROWS, threadArgs->projected);
+	return NULL;
+}
+
+//checks a single projection projects the same rows from several threads at once
+static bool pcaProjectionConcurrentTest() {
+	const int inputDim = PCA_PROJECTION_TESTS_INPUT_DIM, dim = PCA_PROJECTION_TESTS_DIM;
+	const size_t outputSize = PCA_PROJECTION_TESTS_ROWS * dim * sizeof(float);
+	float *eigenvectors = NULL, *mean = NULL, *rows = NULL, *expected = NULL;
+	projection_thread_args_t args[PCA_PROJECTION_TESTS_THREADS];
+	pthread_t threads[PCA_PROJECTION_TESTS_THREADS];
+	SPPCAProjection projection = NULL;
+	int t;
+	srand(13);
+	eigenvectors = (float*) malloc(dim * inputDim * sizeof(float));
+	mean = (float*) malloc(inputDim * sizeof(float));
+	rows = (float*) malloc(PCA_PROJECTION_TESTS_ROWS * inputDim * sizeof(float));
+	expected = (float*) malloc(outputSize);
+	ASSERT_TRUE(eigenvectors && mean && rows && expected);
+	randomFloats(eigenvectors, dim * inputDim, 0.2f);
+	randomFloats(mean, inputDim, 10.0f);
+	randomFloats(rows, PCA_PROJECTION_TESTS_ROWS * inputDim, 100.0f);
+	projection = spPCAProjectionCreate(eigenvectors, mean, inputDim, dim);
+	ASSERT_TRUE(projection != NULL);
+	ASSERT_TRUE(spPCAProjectionProject(projection, rows, PCA_PROJECTION_TESTS_ROWS, expected));
+
+	for (t = 0; t < PCA_PROJECTION_TESTS_THREADS; t++) {
+		args[t].projection = projection;
+		args[t].rows = rows;
+		args[t].isProjected = false;
+		args[t].projected = (float*) malloc(outputSize);
+		ASSERT_TRUE(args[t].projected != NULL);
+		ASSERT_TRUE(pthread_create(&threads[t], NULL, projectionThread, &args[t]) == 0);
+	}
+	for (t = 0; t < PCA_PROJECTION_TESTS_THREADS; t++) {
+		pthread_join(threads[t], NULL);
+		ASSERT_TRUE(args[t].isProjected);
+		ASSERT_TRUE(memcmp(args[t].projected, expected, outputSize) == 0);
+		free(args[t].projected);
+	}
+
+	spPCAProjectionDestroy(projection);
+	free(eigenvectors);
+	free(mean);
+	free(rows);
+	free(expected);
+	return true;
+}
+
+void runPCAProjectionTests() {
+	RUN_TEST(pcaProjectionArgumentsTest);
+	RUN_TEST(pcaProjectionBlockedTest);
+	RUN_TEST(pcaProjectionPointsTest);
+	RUN_TEST(pcaProjectionConcurrentTest);
+}
@@ -0,0 +1,8 @@
+#ifndef SPPCAPROJECTIONUNITTEST_H_
+#define SPPCAPROJECTIONUNITTEST_H_
+
+
+
+void runPCAProjectionTests();
+
+#endif /* SPPCAPROJECTIONUNITTEST_H_ */
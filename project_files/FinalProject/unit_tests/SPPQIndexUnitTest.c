@@ -0,0 +1,170 @@
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "unit_test_util.h"
+#include "SPPQIndexUnitTest.h"
+#include "../data_structures/index_ds/SPPQIndex.h"
+#include "SPKDArrayUnitTest.h"
+#include "SPKDTreeNodeKNNUnitTest.h"
+#include "../data_structures/bpqueue_ds/SPBPriorityQueue.h"
+#include "../SPPoint.h"
+#include "../general_utils/SPUtils.h"
+
+#define PQ_TESTS_DIM						8
+#define PQ_TESTS_SUBSPACES					4
+#define PQ_TESTS_K							5
+#define PQ_RERANK_TEST_SIZE					200
+#define PQ_RERANK_TEST_CENTROIDS			16
+#define PQ_LOSSLESS_TEST_SIZE				32
+#define PQ_LOSSLESS_TEST_CENTROIDS			256
+#define PQ_RANDOM_TESTS_COUNT				5
+
+//invalid arguments test
+static bool pqIndexInvalidArgumentsTest() {
+	SPPoint* points = generateRandomPointsArray(PQ_TESTS_DIM, PQ_LOSSLESS_TEST_SIZE);
+	SPPoint queryPoint = generateRandomPoint(PQ_TESTS_DIM, 0);
+	SPBPQueue queue = spBPQueueCreate(PQ_TESTS_K);
+	ASSERT_TRUE(points != NULL && queryPoint != NULL && queue != NULL);
+
+	ASSERT_TRUE(spPQIndexCreate(NULL, PQ_LOSSLESS_TEST_SIZE, 1, 1, 1, 0) == NULL);
+	ASSERT_TRUE(spPQIndexCreate(points, 0, 1, 1, 1, 0) == NULL);
+	ASSERT_TRUE(spPQIndexCreate(points, PQ_LOSSLESS_TEST_SIZE, PQ_TESTS_DIM + 1, 1, 1,
+			0) == NULL);
+	ASSERT_TRUE(spPQIndexCreate(points, PQ_LOSSLESS_TEST_SIZE, 1, 257, 1, 0) == NULL);
+	ASSERT_TRUE(spPQIndexCreate(points, PQ_LOSSLESS_TEST_SIZE, 1, 1, 1, -1) == NULL);
+	ASSERT_FALSE(spPQIndexKNN(NULL, queue, queryPoint));
+	ASSERT_TRUE(spBPQueueIsEmpty(queue));
+	spPQIndexDestroy(NULL);
+
+	// failed creation does not take ownership of the points
+	destroyPointsArray(points, PQ_LOSSLESS_TEST_SIZE);
+	spPointDestroy(queryPoint);
+	spBPQueueDestroy(queue);
+	return true;
+}
+
+//a codebook that is at least as large as the database encodes it without loss
+static bool pqIndexLosslessTest() {
+	int expected[PQ_TESTS_K];
+	SPPQIndex index;
+	SPPoint* points = generateRandomPointsArray(PQ_TESTS_DIM, PQ_LOSSLESS_TEST_SIZE);
+	SPPoint queryPoint = generateRandomPoint(PQ_TESTS_DIM, 0);
+	SPBPQueue queue = spBPQueueCreate(PQ_TESTS_K);
+	ASSERT_TRUE(points != NULL && queryPoint != NULL && queue != NULL);
+	ASSERT_TRUE(getExactKNN(points, PQ_LOSSLESS_TEST_SIZE, queryPoint, PQ_TESTS_K,
+			expected));
+
+	// no re-rank - the index destroys the points
+	index = spPQIndexCreate(points, PQ_LOSSLESS_TEST_SIZE, PQ_TESTS_SUBSPACES,
+			PQ_LOSSLESS_TEST_CENTROIDS, PQ_LOSSLESS_TEST_SIZE, 0);
+	ASSERT_TRUE(index != NULL);
+	free(points);
+
+	ASSERT_TRUE(spPQIndexKNN(index, queue, queryPoint));
+	ASSERT_TRUE(verifyQueueOrder(queue, expected, PQ_TESTS_K));
+
+	spPQIndexDestroy(index);
+	spPointDestroy(queryPoint);
+	spBPQueueDestroy(queue);
+	return true;
+}
+
+//re-ranking the whole database gives the exact nearest neighbours
+static bool pqIndexFullReRankTest() {
+	int expected[PQ_TESTS_K];
+	SPPQIndex index;
+	SPPoint* points = generateRandomPointsArray(PQ_TESTS_DIM, PQ_RERANK_TEST_SIZE);
+	SPPoint queryPoint = generateRandomPoint(PQ_TESTS_DIM, 0);
+	SPBPQueue queue = spBPQueueCreate(PQ_TESTS_K);
+	ASSERT_TRUE(points != NULL && queryPoint != NULL && queue != NULL);
+	ASSERT_TRUE(getExactKNN(points, PQ_RERANK_TEST_SIZE, queryPoint, PQ_TESTS_K,
+			expected));
+
+	index = spPQIndexCreate(points, PQ_RERANK_TEST_SIZE, PQ_TESTS_SUBSPACES,
+			PQ_RERANK_TEST_CENTROIDS, PQ_RERANK_TEST_SIZE / 2, PQ_RERANK_TEST_SIZE);
+	ASSERT_TRUE(index != NULL);
+	free(points);
+
+	ASSERT_TRUE(spPQIndexKNN(index, queue, queryPoint));
+	ASSERT_TRUE(verifyQueueOrder(queue, expected, PQ_TESTS_K));
+
+	spPQIndexDestroy(index);
+	spPointDestroy(queryPoint);
+	spBPQueueDestroy(queue);
+	return true;
+}
+
+//a re-rank smaller than k still re-ranks k candidates, thus finds k neighbours
+static bool pqIndexSmallReRankTest() {
+	int expected[PQ_TESTS_K];
+	SPPQIndex index;
+	SPPoint* points = generateRandomPointsArray(PQ_TESTS_DIM, PQ_LOSSLESS_TEST_SIZE);
+	SPPoint queryPoint = generateRandomPoint(PQ_TESTS_DIM, 0);
+	SPBPQueue queue = spBPQueueCreate(PQ_TESTS_K);
+	ASSERT_TRUE(points != NULL && queryPoint != NULL && queue != NULL);
+	ASSERT_TRUE(getExactKNN(points, PQ_LOSSLESS_TEST_SIZE, queryPoint, PQ_TESTS_K,
+			expected));
+
+	index = spPQIndexCreate(points, PQ_LOSSLESS_TEST_SIZE, PQ_TESTS_SUBSPACES,
+			PQ_LOSSLESS_TEST_CENTROIDS, PQ_LOSSLESS_TEST_SIZE, 1);
+	ASSERT_TRUE(index != NULL);
+	free(points);
+
+	// twice, the second query reuses the working memory of the first
+	ASSERT_TRUE(spPQIndexKNN(index, queue, queryPoint));
+	ASSERT_TRUE(verifyQueueOrder(queue, expected, PQ_TESTS_K));
+	ASSERT_TRUE(spPQIndexKNN(index, queue, queryPoint));
+	ASSERT_TRUE(verifyQueueOrder(queue, expected, PQ_TESTS_K));
+
+	spPQIndexDestroy(index);
+	spPointDestroy(queryPoint);
+	spBPQueueDestroy(queue);
+	return true;
+}
+
+//points added after the creation are encoded and re-ranked as the indexed ones
+static bool pqIndexAddPointsTest() {
+	int expected[PQ_TESTS_K];
+	SPPQIndex index;
+	SPPoint* points = generateRandomPointsArray(PQ_TESTS_DIM, PQ_RERANK_TEST_SIZE);
+	SPPoint queryPoint = generateRandomPoint(PQ_TESTS_DIM, 0);
+	SPPoint otherPoint = generateRandomPoint(PQ_TESTS_DIM + 1, 0);
+	SPBPQueue queue = spBPQueueCreate(PQ_TESTS_K);
+	ASSERT_TRUE(points != NULL && queryPoint != NULL && otherPoint != NULL &&
+			queue != NULL);
+	ASSERT_TRUE(getExactKNN(points, PQ_RERANK_TEST_SIZE, queryPoint, PQ_TESTS_K,
+			expected));
+
+	index = spPQIndexCreate(points, PQ_RERANK_TEST_SIZE / 2, PQ_TESTS_SUBSPACES,
+			PQ_RERANK_TEST_CENTROIDS, PQ_RERANK_TEST_SIZE / 2, PQ_RERANK_TEST_SIZE);
+	ASSERT_TRUE(index != NULL);
+	ASSERT_FALSE(spPQIndexAddPoints(NULL, points + PQ_RERANK_TEST_SIZE / 2, 1));
+	ASSERT_FALSE(spPQIndexAddPoints(index, points + PQ_RERANK_TEST_SIZE / 2, 0));
+	ASSERT_FALSE(spPQIndexAddPoints(index, &otherPoint, 1));
+	ASSERT_TRUE(spPQIndexAddPoints(index, points + PQ_RERANK_TEST_SIZE / 2,
+			PQ_RERANK_TEST_SIZE / 2));
+	free(points);
+
+	ASSERT_TRUE(spPQIndexKNN(index, queue, queryPoint));
+	ASSERT_TRUE(verifyQueueOrder(queue, expected, PQ_TESTS_K));
+
+	spPQIndexDestroy(index);
+	spPointDestroy(queryPoint);
+	spPointDestroy(otherPoint);
+	spBPQueueDestroy(queue);
+	return true;
+}
+
+void runPQIndexTests() {
+	int i;
+	srand(time(NULL));
+	RUN_TEST(pqIndexInvalidArgumentsTest);
+	for (i = 0; i < PQ_RANDOM_TESTS_COUNT; i++) {
+		RUN_TEST(pqIndexLosslessTest);
+		RUN_TEST(pqIndexFullReRankTest);
+		RUN_TEST(pqIndexSmallReRankTest);
+		RUN_TEST(pqIndexAddPointsTest);
+	}
+}
@@ -0,0 +1,8 @@
+#ifndef SPPQINDEXUNITTEST_H_
+#define SPPQINDEXUNITTEST_H_
+
+
+
+void runPQIndexTests();
+
+#endif /* SPPQINDEXUNITTEST_H_ */
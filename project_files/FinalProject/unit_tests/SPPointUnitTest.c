@@ -231,6 +231,76 @@ bool pointDestroyInvalidArgumentsTest() {
 	return true;
 }
 
+//tests that float and float16 storage keep the values (up to the precision) and copies
+bool pointPrecisionTest() {
+	int i;
+	double data[4] = { 1.0, -2.5, 0.125, 1000.0 };
+	double zeros[4] = { 0.0, 0.0, 0.0, 0.0 };
+	float floatData[4] = { 1.0f, -2.5f, 0.125f, 1000.0f };
+	SPPoint pd = spPointCreateWithPrecision(data, 4, 1, SP_POINT_PRECISION_DOUBLE);
+	SPPoint pf = spPointCreateWithPrecision(data, 4, 1, SP_POINT_PRECISION_FLOAT);
+	SPPoint ph = spPointCreateWithPrecision(data, 4, 1, SP_POINT_PRECISION_HALF);
+	SPPoint qh = spPointCreateWithPrecision(zeros, 4, 1, SP_POINT_PRECISION_HALF);
+	SPPoint pfl = spPointCreateFromFloat(floatData, 4, 1);
+	SPPoint copy = spPointCopy(ph);
+
+	ASSERT_TRUE(spPointGetPrecision(pf) == SP_POINT_PRECISION_FLOAT);
+	ASSERT_TRUE(spPointGetPrecision(copy) == SP_POINT_PRECISION_HALF);
+	ASSERT_TRUE(spPointGetPrecision(pfl) == spPointGetDefaultPrecision());
+	for (i = 0; i < 4; i++) {
+		// all values are exactly representable at binary16
+		ASSERT_TRUE(spPointGetAxisCoor(pf, i) == data[i]);
+		ASSERT_TRUE(spPointGetAxisCoor(ph, i) == data[i]);
+		ASSERT_TRUE(spPointGetAxisCoor(pfl, i) == data[i]);
+	}
+	ASSERT_TRUE(spPointCompare(ph, copy));
+	ASSERT_TRUE(spPointCompare(pd, pf));
+	ASSERT_TRUE(spPointL2SquaredDistance(ph, qh) - spPointL2SquaredDistance(pd, qh) <= epsilon);
+	ASSERT_TRUE(spPointL2SquaredDistance(pf, ph) == 0);
+
+	spPointDestroy(pd);
+	spPointDestroy(pf);
+	spPointDestroy(ph);
+	spPointDestroy(qh);
+	spPointDestroy(pfl);
+	spPointDestroy(copy);
+	return true;
+}
+
+//tests that rows keep the point values at their precision and the row distance
+bool pointRowTest() {
+	int i;
+	double data[4] = { 1.0, -2.5, 0.125, 1000.0 };
+	double query[4] = { 0.0, 1.0, 0.0, 999.0 };
+	double vector[4];
+	float floatRow[4];
+	unsigned short halfRow[4];
+	double doubleRow[4];
+	SPPoint pd = spPointCreateWithPrecision(data, 4, 1, SP_POINT_PRECISION_DOUBLE);
+	SPPoint ph = spPointCreateWithPrecision(data, 4, 1, SP_POINT_PRECISION_HALF);
+	SPPoint q = spPointCreateWithPrecision(query, 4, 1, SP_POINT_PRECISION_DOUBLE);
+
+	ASSERT_TRUE(spPointGetCoorSize(SP_POINT_PRECISION_HALF) == sizeof(halfRow[0]));
+	spPointCopyToRow(pd, floatRow, SP_POINT_PRECISION_FLOAT);
+	spPointCopyToRow(pd, halfRow, SP_POINT_PRECISION_HALF);
+	spPointCopyToRow(ph, doubleRow, SP_POINT_PRECISION_DOUBLE);
+	spPointRowToVector(halfRow, 4, SP_POINT_PRECISION_HALF, vector);
+	for (i = 0; i < 4; i++) {
+		ASSERT_TRUE(floatRow[i] == data[i]);
+		ASSERT_TRUE(doubleRow[i] == data[i]);
+		ASSERT_TRUE(vector[i] == data[i]);
+	}
+	ASSERT_TRUE(spPointRowL2SquaredDistance(query, halfRow, 4, SP_POINT_PRECISION_HALF)
+			== spPointL2SquaredDistance(ph, q));
+	ASSERT_TRUE(spPointRowL2SquaredDistance(query, floatRow, 4, SP_POINT_PRECISION_FLOAT)
+			== spPointL2SquaredDistance(pd, q));
+
+	spPointDestroy(pd);
+	spPointDestroy(ph);
+	spPointDestroy(q);
+	return true;
+}
+
 void runPointTests() {
 	RUN_TEST(pointBasicCopyTest);
 	RUN_TEST(pointBasicL2Distance);
@@ -239,6 +309,8 @@ void runPointTests() {
 	RUN_TEST(pointBasicL2Distance2);
 	RUN_TEST(pointCreateInvalidArgumentsTest);
 	RUN_TEST(pointDestroyInvalidArgumentsTest);
+	RUN_TEST(pointPrecisionTest);
+	RUN_TEST(pointRowTest);
 
 	RUN_TEST(pointTestTriangleInequality);
 	RUN_TEST(pointTestDistanceSymmetric);
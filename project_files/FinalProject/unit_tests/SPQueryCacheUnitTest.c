@@ -0,0 +1,312 @@
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <dirent.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include "unit_test_util.h"
+#include "SPQueryCacheUnitTest.h"
+#include "../SPPoint.h"
+#include "../SPConfig.h"
+#include "../image_parsing/SPImageData.h"
+#include "../main_and_ui/SPQueryCache.h"
+
+#define QUERY_CACHE_TESTS_CONFIG_FILE	"./unit_tests/queryCacheTest.config"
+#define QUERY_CACHE_TESTS_CONFIG		"spImagesDirectory = ./unit_tests/\nspImagesPrefix = queryCacheTest\n" \
+										"spImagesSuffix = .png\nspNumOfImages = 1\n" \
+										"spPCAFilename = queryCacheTest.yml\n" \
+										"spQueryCacheDirectory = ./unit_tests/queryCacheTest/\n" \
+										"spQueryCacheSize = "
+#define QUERY_CACHE_TESTS_PCA_FILE		"./unit_tests/queryCacheTest.yml"
+#define QUERY_CACHE_TESTS_SPILL_DIR		"./unit_tests/queryCacheTest/"
+#define QUERY_CACHE_TESTS_IMAGE_FORMAT	"./unit_tests/queryCacheTest%c.png"
+#define QUERY_CACHE_TESTS_NUMBERED_FORMAT	"./unit_tests/queryCacheTest%d.png"
+#define QUERY_CACHE_TESTS_MANY_IMAGES	200 // several times the initial number of buckets
+#define QUERY_CACHE_TESTS_NUM_OF_IMAGES	5
+#define QUERY_CACHE_TESTS_DIM			128
+#define QUERY_CACHE_TESTS_FEATURES		300 // about 0.3 megabytes of double descriptors
+#define QUERY_CACHE_TESTS_LARGE			2000 // more than a megabyte
+#define QUERY_CACHE_TESTS_PATH_LEN		128
+#define QUERY_CACHE_TESTS_LINE_LEN		1024
+
+/*
+ * Writes the path of the test image of the given letter
+ */
+static void getImagePath(char* path, char letter) {
+	sprintf(path, QUERY_CACHE_TESTS_IMAGE_FORMAT, letter);
+}
+
+/*
+ * Creates the test configuration with the given cache size, the PCA file, the spill
+ * directory and the test images 'A', 'B', ...
+ */
+static SPConfig createTestConfig(int cacheSize) {
+	SP_CONFIG_MSG configMsg = SP_CONFIG_SUCCESS;
+	char content[QUERY_CACHE_TESTS_LINE_LEN], path[QUERY_CACHE_TESTS_PATH_LEN];
+	int i;
+
+	sprintf(content, "%s%d\n", QUERY_CACHE_TESTS_CONFIG, cacheSize);
+	if (!writeFile(QUERY_CACHE_TESTS_CONFIG_FILE, content) ||
+			(access(QUERY_CACHE_TESTS_PCA_FILE, F_OK) != 0 &&
+			!writeFile(QUERY_CACHE_TESTS_PCA_FILE, "the PCA")))
+		return NULL;
+	mkdir(QUERY_CACHE_TESTS_SPILL_DIR, 0755);
+	for (i = 0; i < QUERY_CACHE_TESTS_NUM_OF_IMAGES; i++) {
+		getImagePath(path, 'A' + i);
+		sprintf(content, "the pixels of image %c", 'A' + i);
+		if (access(path, F_OK) != 0 && !writeFile(path, content))
+			return NULL;
+	}
+	return spConfigCreate(QUERY_CACHE_TESTS_CONFIG_FILE, &configMsg);
+}
+
+/*
+ * Removes the test files and the spill directory
+ */
+static void removeTestFiles() {
+	char path[QUERY_CACHE_TESTS_PATH_LEN + 256];
+	struct dirent* entry;
+	DIR* directory;
+	int i;
+
+	for (i = 0; i < QUERY_CACHE_TESTS_NUM_OF_IMAGES; i++) {
+		getImagePath(path, 'A' + i);
+		remove(path);
+	}
+	if ((directory = opendir(QUERY_CACHE_TESTS_SPILL_DIR)) != NULL) {
+		while ((entry = readdir(directory)) != NULL) {
+			if (entry->d_name[0] == '.')
+				continue;
+			sprintf(path, "%s%s", QUERY_CACHE_TESTS_SPILL_DIR, entry->d_name);
+			remove(path);
+		}
+		closedir(directory);
+	}
+	rmdir(QUERY_CACHE_TESTS_SPILL_DIR);
+	remove(QUERY_CACHE_TESTS_PCA_FILE);
+	remove(QUERY_CACHE_TESTS_CONFIG_FILE);
+}
+
+/*
+ * Creates numOfFeatures descriptors whose coordinates depend on the seed, they are exact
+ * in the .feats format
+ */
+static SPPoint* createTestFeatures(int seed, int numOfFeatures) {
+	double data[QUERY_CACHE_TESTS_DIM];
+	SPPoint* features;
+	int i, j;
+
+	if ((features = (SPPoint*) calloc(numOfFeatures, sizeof(SPPoint))) == NULL)
+		return NULL;
+	for (i = 0; i < numOfFeatures; i++) {
+		for (j = 0; j < QUERY_CACHE_TESTS_DIM; j++)
+			data[j] = seed * 100.0 + i - j / 4.0;
+		features[i] = spPointCreate(data, QUERY_CACHE_TESTS_DIM, 0);
+	}
+	return features;
+}
+
+static void destroyTestFeatures(SPPoint* features, int numOfFeatures) {
+	if (features == NULL)
+		return;
+	freeFeatures(features, numOfFeatures);
+	free(features);
+}
+
+/*
+ * Caches the test descriptors of the given seed as the descriptors of an image
+ */
+static bool insertTestImage(SPQueryCache cache, char letter, int seed, int numOfFeatures) {
+	char path[QUERY_CACHE_TESTS_PATH_LEN];
+	SPPoint* features = createTestFeatures(seed, numOfFeatures);
+	bool isInserted;
+
+	getImagePath(path, letter);
+	isInserted = features != NULL && spQueryCacheInsert(cache, path, features,
+			numOfFeatures);
+	destroyTestFeatures(features, numOfFeatures);
+	return isInserted;
+}
+
+/*
+ * Checks that the cache has the test descriptors of the given seed for an image
+ */
+static bool isCached(SPQueryCache cache, char letter, int seed) {
+	char path[QUERY_CACHE_TESTS_PATH_LEN];
+	SPPoint *features, *expected = createTestFeatures(seed, QUERY_CACHE_TESTS_FEATURES);
+	int i, numOfFeatures = -1;
+	bool successFlag;
+
+	getImagePath(path, letter);
+	features = spQueryCacheGet(cache, path, &numOfFeatures);
+	successFlag = features != NULL && expected != NULL &&
+			numOfFeatures == QUERY_CACHE_TESTS_FEATURES;
+	for (i = 0; successFlag && i < numOfFeatures; i++)
+		successFlag = spPointGetDimension(features[i]) == QUERY_CACHE_TESTS_DIM &&
+				spPointL2SquaredDistance(features[i], expected[i]) < 1e-6;
+	destroyTestFeatures(features, features != NULL ? numOfFeatures : 0);
+	destroyTestFeatures(expected, QUERY_CACHE_TESTS_FEATURES);
+	return successFlag;
+}
+
+/*
+ * Checks that an image is a cache miss
+ */
+static bool isMiss(SPQueryCache cache, char letter) {
+	char path[QUERY_CACHE_TESTS_PATH_LEN];
+	int numOfFeatures = -1;
+
+	getImagePath(path, letter);
+	return spQueryCacheGet(cache, path, &numOfFeatures) == NULL && numOfFeatures == 0;
+}
+
+static bool queryCacheArgumentsTest() {
+	SPQueryCache cache = NULL;
+	SPConfig config = NULL;
+	SPPoint* features = NULL;
+	int numOfFeatures = 1;
+
+	ASSERT_TRUE(spQueryCacheCreate(NULL) == NULL);
+	ASSERT_TRUE((config = createTestConfig(1)) != NULL);
+	ASSERT_TRUE((cache = spQueryCacheCreate(config)) != NULL);
+	ASSERT_TRUE((features = createTestFeatures(0, numOfFeatures)) != NULL);
+
+	ASSERT_TRUE(spQueryCacheGet(NULL, "a.png", &numOfFeatures) == NULL);
+	ASSERT_TRUE(spQueryCacheGet(cache, NULL, &numOfFeatures) == NULL);
+	ASSERT_TRUE(spQueryCacheGet(cache, "a.png", NULL) == NULL);
+	ASSERT_FALSE(spQueryCacheInsert(NULL, "a.png", features, numOfFeatures));
+	ASSERT_FALSE(spQueryCacheInsert(cache, "a.png", NULL, numOfFeatures));
+	ASSERT_FALSE(spQueryCacheInsert(cache, "a.png", features, 0));
+	// an image file that does not exist is not cached
+	ASSERT_FALSE(spQueryCacheInsert(cache, "./unit_tests/noSuchImage.png", features,
+			numOfFeatures));
+	ASSERT_TRUE(spQueryCacheGetHits(NULL) == -1);
+	ASSERT_TRUE(spQueryCacheGetMisses(NULL) == -1);
+	ASSERT_TRUE(spQueryCacheGetHits(cache) == 0);
+	ASSERT_TRUE(spQueryCacheGetMisses(cache) == 0);
+
+	destroyTestFeatures(features, numOfFeatures);
+	spQueryCacheDestroy(cache);
+	spQueryCacheDestroy(NULL);
+	spConfigDestroy(config);
+	removeTestFiles();
+	return true;
+}
+
+static bool queryCacheEvictionTest() {
+	SPQueryCache cache = NULL;
+	SPConfig config = NULL;
+	char path[QUERY_CACHE_TESTS_PATH_LEN];
+
+	ASSERT_TRUE((config = createTestConfig(1)) != NULL);
+	ASSERT_TRUE((cache = spQueryCacheCreate(config)) != NULL);
+
+	ASSERT_TRUE(isMiss(cache, 'A'));
+	ASSERT_TRUE(insertTestImage(cache, 'A', 0, QUERY_CACHE_TESTS_FEATURES));
+	ASSERT_TRUE(isCached(cache, 'A', 0));
+	ASSERT_TRUE(spQueryCacheGetHits(cache) == 1);
+	ASSERT_TRUE(spQueryCacheGetMisses(cache) == 1);
+
+	// three images fit in a megabyte, the least recently used one is evicted and spilled
+	ASSERT_TRUE(insertTestImage(cache, 'B', 1, QUERY_CACHE_TESTS_FEATURES));
+	ASSERT_TRUE(insertTestImage(cache, 'C', 2, QUERY_CACHE_TESTS_FEATURES));
+	ASSERT_TRUE(isCached(cache, 'A', 0));
+	ASSERT_TRUE(insertTestImage(cache, 'D', 3, QUERY_CACHE_TESTS_FEATURES));
+	ASSERT_TRUE(isCached(cache, 'B', 1)); // loaded from its spilled file
+	ASSERT_TRUE(isCached(cache, 'A', 0));
+	ASSERT_TRUE(spQueryCacheGetHits(cache) == 4);
+
+	// an image that is larger than the budget is not cached
+	ASSERT_FALSE(insertTestImage(cache, 'E', 4, QUERY_CACHE_TESTS_LARGE));
+	ASSERT_TRUE(isMiss(cache, 'E'));
+
+	// a changed image file is a miss
+	getImagePath(path, 'A');
+	ASSERT_TRUE(writeFile(path, "the new pixels of image A"));
+	ASSERT_TRUE(isMiss(cache, 'A'));
+	ASSERT_TRUE(spQueryCacheGetMisses(cache) == 3);
+	spQueryCacheDestroy(cache);
+
+	// the cached images were spilled, and are found by another run
+	ASSERT_TRUE((cache = spQueryCacheCreate(config)) != NULL);
+	ASSERT_TRUE(isCached(cache, 'C', 2));
+	ASSERT_TRUE(isCached(cache, 'D', 3));
+	ASSERT_TRUE(isMiss(cache, 'A'));
+	spQueryCacheDestroy(cache);
+
+	// the spilled images of another PCA are not loaded
+	ASSERT_TRUE(writeFile(QUERY_CACHE_TESTS_PCA_FILE, "another PCA"));
+	ASSERT_TRUE((cache = spQueryCacheCreate(config)) != NULL);
+	ASSERT_TRUE(isMiss(cache, 'C'));
+	spQueryCacheDestroy(cache);
+
+	spConfigDestroy(config);
+	removeTestFiles();
+	return true;
+}
+
+//many images are all found, while the cache grows its path lookup table
+static bool queryCacheManyImagesTest() {
+	SPQueryCache cache = NULL;
+	SPConfig config = NULL;
+	SPPoint *features = NULL, *cached = NULL;
+	char path[QUERY_CACHE_TESTS_PATH_LEN];
+	int i, numOfFeatures = -1;
+	bool successFlag = true;
+
+	ASSERT_TRUE((config = createTestConfig(1)) != NULL);
+	ASSERT_TRUE((cache = spQueryCacheCreate(config)) != NULL);
+	for (i = 0; successFlag && i < QUERY_CACHE_TESTS_MANY_IMAGES; i++) {
+		sprintf(path, QUERY_CACHE_TESTS_NUMBERED_FORMAT, i);
+		successFlag = writeFile(path, "the pixels of a numbered image") &&
+				(features = createTestFeatures(i, 1)) != NULL &&
+				spQueryCacheInsert(cache, path, features, 1);
+		destroyTestFeatures(features, 1);
+		features = NULL;
+	}
+	for (i = 0; successFlag && i < QUERY_CACHE_TESTS_MANY_IMAGES; i++) {
+		sprintf(path, QUERY_CACHE_TESTS_NUMBERED_FORMAT, i);
+		successFlag = (cached = spQueryCacheGet(cache, path, &numOfFeatures)) != NULL &&
+				numOfFeatures == 1 && (features = createTestFeatures(i, 1)) != NULL &&
+				spPointL2SquaredDistance(cached[0], features[0]) < 1e-6;
+		destroyTestFeatures(cached, cached != NULL ? numOfFeatures : 0);
+		destroyTestFeatures(features, 1);
+		cached = features = NULL;
+	}
+	ASSERT_TRUE(successFlag);
+	ASSERT_TRUE(spQueryCacheGetHits(cache) == QUERY_CACHE_TESTS_MANY_IMAGES);
+	spQueryCacheDestroy(cache);
+
+	for (i = 0; i < QUERY_CACHE_TESTS_MANY_IMAGES; i++) {
+		sprintf(path, QUERY_CACHE_TESTS_NUMBERED_FORMAT, i);
+		remove(path);
+	}
+	spConfigDestroy(config);
+	removeTestFiles();
+	return true;
+}
+
+static bool queryCacheDisabledTest() {
+	SPQueryCache cache = NULL;
+	SPConfig config = NULL;
+
+	ASSERT_TRUE((config = createTestConfig(0)) != NULL);
+	ASSERT_TRUE((cache = spQueryCacheCreate(config)) != NULL);
+	ASSERT_FALSE(insertTestImage(cache, 'A', 0, QUERY_CACHE_TESTS_FEATURES));
+	ASSERT_TRUE(isMiss(cache, 'A'));
+	ASSERT_TRUE(spQueryCacheGetMisses(cache) == 1);
+	spQueryCacheDestroy(cache);
+
+	spConfigDestroy(config);
+	removeTestFiles();
+	return true;
+}
+
+void runQueryCacheTests() {
+	RUN_TEST(queryCacheArgumentsTest);
+	RUN_TEST(queryCacheEvictionTest);
+	RUN_TEST(queryCacheManyImagesTest);
+	RUN_TEST(queryCacheDisabledTest);
+}
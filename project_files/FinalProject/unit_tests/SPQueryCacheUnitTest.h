@@ -0,0 +1,8 @@
+#ifndef SPQUERYCACHEUNITTEST_H_
+#define SPQUERYCACHEUNITTEST_H_
+
+
+
+void runQueryCacheTests();
+
+#endif /* SPQUERYCACHEUNITTEST_H_ */
@@ -0,0 +1,714 @@
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <pthread.h>
+
+#include "unit_test_util.h"
+#include "SPSearchIndexUnitTest.h"
+#include "../data_structures/index_ds/SPSearchIndex.h"
+#include "../data_structures/index_ds/SPBruteForceIndex.h"
+#include "../data_structures/bpqueue_ds/SPBPriorityQueue.h"
+#include "../main_and_ui/SPMainAux.h"
+#include "../main_and_ui/SPImageQuery.h"
+#include "SPKDArrayUnitTest.h"
+#include "SPBPQueueUnitTest.h"
+#include "../SPConfig.h"
+#include "../SPPoint.h"
+#include "../general_utils/SPInstrumentation.h"
+
+#define SEARCH_TESTS_DIM					10
+#define SEARCH_TESTS_IMAGES					10
+#define SEARCH_TESTS_FEATURES_PER_IMAGE		40
+#define SEARCH_TESTS_K						6
+#define SEARCH_TESTS_QUERIES				20
+#define SEARCH_TESTS_ADDED_IMAGES			3
+#define SEARCH_TESTS_MERGED_FEATURES		1500 // per added image, the delta is merged at 4096
+#define SEARCH_RANDOM_TESTS_COUNT			5
+#define SEARCH_TESTS_QUERY_THREADS			4
+#define SEARCH_TESTS_THREAD_SEARCHES		200 // per thread, while the index is updated
+#define SEARCH_TESTS_QUERY_IMAGES			6
+#define SEARCH_TESTS_SIMILAR_IMAGES			3
+#define SEARCH_TESTS_FUTURE					3600000000000ULL // an hour
+#define SEARCH_TESTS_PAST					1 // long before the clock start
+
+#define KD_TREE_INDEX_TYPE					"KD_TREE"
+#define BRUTE_FORCE_INDEX_TYPE				"BRUTE"
+#define HNSW_INDEX_TYPE						"HNSW"
+
+/*
+ * A query thread data, the thread searches all the query images with its own context
+ */
+typedef struct search_query_thread_t {
+	SPSearchIndex index;
+	struct sp_image_data* queryImages;
+	int* similarImages[SEARCH_TESTS_QUERY_IMAGES];
+	bool success;
+} SearchQueryThread;
+
+/*
+ * A search thread data, the thread searches the index while it is updated
+ */
+typedef struct search_update_thread_t {
+	SPSearchIndex index;
+	SPPoint* queries;
+	bool success;
+} SearchUpdateThread;
+
+/*
+ * Returns the random features of the images [firstImage, firstImage + numOfImages),
+ * each with numOfFeatures features
+ */
+static SPPoint* generateImagesFeatures(int firstImage, int numOfImages,
+		int numOfFeatures) {
+	int i;
+	SPPoint* features = (SPPoint*) calloc(numOfImages * numOfFeatures, sizeof(SPPoint));
+	if (features == NULL)
+		return NULL;
+	for (i = 0; i < numOfImages * numOfFeatures; i++) {
+		if ((features[i] = generateRandomPoint(SEARCH_TESTS_DIM,
+				firstImage + i / numOfFeatures)) == NULL) {
+			destroyPointsArray(features, i);
+			return NULL;
+		}
+	}
+	return features;
+}
+
+/*
+ * Copies the points into 'destination' (starting at index 'offset')
+ */
+static bool copyPoints(SPPoint* destination, int offset, SPPoint* points, int size) {
+	int i;
+	for (i = 0; i < size; i++) {
+		if ((destination[offset + i] = spPointCopy(points[i])) == NULL)
+			return false;
+	}
+	return true;
+}
+
+/*
+ * Returns true iff the queue holds no neighbour of the given image. The queue is emptied.
+ */
+static bool verifyImageNotInQueue(SPBPQueue bpq, int imageIndex) {
+	SPListElement element;
+	bool found = false;
+	while (!spBPQueueIsEmpty(bpq)) {
+		element = spBPQueuePeek(bpq);
+		found = found || element == NULL || spListElementGetIndex(element) == imageIndex;
+		spListElementDestroy(element);
+		spBPQueueDequeue(bpq);
+	}
+	return !found;
+}
+
+/*
+ * Builds a search index of the given type over random images, adds images of
+ * numOfFeatures features to it one at a time and verifies that it finds the same
+ * neighbours as a brute force index that is built over all the images
+ */
+static bool verifyAddedImagesSearch(char* indexType, int numOfFeatures) {
+	int i, size = SEARCH_TESTS_IMAGES * SEARCH_TESTS_FEATURES_PER_IMAGE;
+	int totalSize = size + SEARCH_TESTS_ADDED_IMAGES * numOfFeatures;
+	SPConfig config = createDefaultConfig(SEARCH_TESTS_IMAGES, "spIndexType", indexType);
+	SPPoint* points = generateImagesFeatures(0, SEARCH_TESTS_IMAGES,
+			SEARCH_TESTS_FEATURES_PER_IMAGE);
+	SPPoint* allPoints = (SPPoint*) calloc(totalSize, sizeof(SPPoint));
+	SPPoint* queries = generateRandomPointsArray(SEARCH_TESTS_DIM, SEARCH_TESTS_QUERIES);
+	SPPoint* features;
+	SPBPQueue indexQueue = spBPQueueCreate(SEARCH_TESTS_K);
+	SPBPQueue truthQueue = spBPQueueCreate(SEARCH_TESTS_K);
+	SPSearchIndex index;
+	SPBruteForceIndex truth;
+	ASSERT_TRUE(config != NULL && points != NULL && allPoints != NULL &&
+			queries != NULL && indexQueue != NULL && truthQueue != NULL);
+	ASSERT_TRUE(copyPoints(allPoints, 0, points, size));
+
+	index = spSearchIndexCreate(config, points, size);
+	ASSERT_TRUE(index != NULL);
+	free(points);
+
+	for (i = 0; i < SEARCH_TESTS_ADDED_IMAGES; i++) {
+		features = generateImagesFeatures(SEARCH_TESTS_IMAGES + i, 1, numOfFeatures);
+		ASSERT_TRUE(features != NULL);
+		ASSERT_TRUE(copyPoints(allPoints, size, features, numOfFeatures));
+		size += numOfFeatures;
+		ASSERT_TRUE(spSearchIndexAddImage(index, SEARCH_TESTS_IMAGES + i, features,
+				numOfFeatures));
+		free(features);
+	}
+	ASSERT_TRUE(spSearchIndexGetNumOfImages(index) ==
+			SEARCH_TESTS_IMAGES + SEARCH_TESTS_ADDED_IMAGES);
+
+	truth = spBruteForceIndexCreate(allPoints, totalSize, 1);
+	ASSERT_TRUE(truth != NULL);
+	free(allPoints);
+
+	for (i = 0; i < SEARCH_TESTS_QUERIES; i++) {
+		ASSERT_TRUE(spSearchIndexKNN(index, indexQueue, queries[i]));
+		ASSERT_TRUE(spBruteForceIndexKNN(truth, truthQueue, queries[i]));
+		ASSERT_TRUE(verifySameQueues(indexQueue, truthQueue));
+	}
+
+	spSearchIndexDestroy(index);
+	spBruteForceIndexDestroy(truth);
+	destroyPointsArray(queries, SEARCH_TESTS_QUERIES);
+	spBPQueueDestroy(indexQueue);
+	spBPQueueDestroy(truthQueue);
+	spConfigDestroy(config);
+	return true;
+}
+
+//invalid arguments test
+static bool searchIndexUpdatesInvalidArgumentsTest() {
+	int size = SEARCH_TESTS_IMAGES * SEARCH_TESTS_FEATURES_PER_IMAGE;
+	SPConfig config = createDefaultConfig(SEARCH_TESTS_IMAGES,
+			"spIndexType", KD_TREE_INDEX_TYPE);
+	SPPoint* points = generateImagesFeatures(0, SEARCH_TESTS_IMAGES,
+			SEARCH_TESTS_FEATURES_PER_IMAGE);
+	SPPoint* features = generateImagesFeatures(SEARCH_TESTS_IMAGES, 1, 1);
+	SPPoint wrongDim = generateRandomPoint(SEARCH_TESTS_DIM + 1, SEARCH_TESTS_IMAGES);
+	SPSearchIndex index;
+	ASSERT_TRUE(config != NULL && points != NULL && features != NULL && wrongDim != NULL);
+
+	index = spSearchIndexCreate(config, points, size);
+	ASSERT_TRUE(index != NULL);
+	free(points);
+
+	ASSERT_FALSE(spSearchIndexAddImage(NULL, SEARCH_TESTS_IMAGES, features, 1));
+	ASSERT_FALSE(spSearchIndexAddImage(index, SEARCH_TESTS_IMAGES, NULL, 1));
+	ASSERT_FALSE(spSearchIndexAddImage(index, SEARCH_TESTS_IMAGES, features, 0));
+	// only the next image index can be added, and the features must carry it
+	ASSERT_FALSE(spSearchIndexAddImage(index, SEARCH_TESTS_IMAGES - 1, features, 1));
+	ASSERT_FALSE(spSearchIndexAddImage(index, SEARCH_TESTS_IMAGES + 1, features, 1));
+	ASSERT_FALSE(spSearchIndexAddImage(index, SEARCH_TESTS_IMAGES, &wrongDim, 1));
+	ASSERT_TRUE(spSearchIndexGetNumOfImages(index) == SEARCH_TESTS_IMAGES);
+
+	ASSERT_FALSE(spSearchIndexRemoveImage(NULL, 0));
+	ASSERT_FALSE(spSearchIndexRemoveImage(index, -1));
+	ASSERT_FALSE(spSearchIndexRemoveImage(index, SEARCH_TESTS_IMAGES));
+	ASSERT_FALSE(spSearchIndexIsImageRemoved(index, SEARCH_TESTS_IMAGES));
+	ASSERT_TRUE(spSearchIndexGetNumOfImages(NULL) == -1);
+
+	// a failed addition does not take ownership of the features
+	ASSERT_TRUE(spSearchIndexAddImage(index, SEARCH_TESTS_IMAGES, features, 1));
+	free(features);
+	ASSERT_TRUE(spSearchIndexGetNumOfImages(index) == SEARCH_TESTS_IMAGES + 1);
+
+	spSearchIndexDestroy(index);
+	spPointDestroy(wrongDim);
+	spConfigDestroy(config);
+	return true;
+}
+
+//images added to a KD-tree index are found as if the tree was built with them
+static bool searchIndexAddToKDTreeTest() {
+	return verifyAddedImagesSearch(KD_TREE_INDEX_TYPE, SEARCH_TESTS_FEATURES_PER_IMAGE);
+}
+
+//images added to a brute force index are found as if the index was built with them
+static bool searchIndexAddToBruteForceTest() {
+	return verifyAddedImagesSearch(BRUTE_FORCE_INDEX_TYPE, SEARCH_TESTS_FEATURES_PER_IMAGE);
+}
+
+//images merged into the KD-tree are still found as if the tree was built with them
+static bool searchIndexMergeIntoKDTreeTest() {
+	return verifyAddedImagesSearch(KD_TREE_INDEX_TYPE, SEARCH_TESTS_MERGED_FEATURES);
+}
+
+//a removed image is never returned, removing it again has no effect
+static bool searchIndexRemoveImageTest() {
+	int i, size = SEARCH_TESTS_IMAGES * SEARCH_TESTS_FEATURES_PER_IMAGE;
+	int removedImage = rand() % SEARCH_TESTS_IMAGES;
+	SPConfig config = createDefaultConfig(SEARCH_TESTS_IMAGES,
+			"spIndexType", KD_TREE_INDEX_TYPE);
+	SPPoint* points = generateImagesFeatures(0, SEARCH_TESTS_IMAGES,
+			SEARCH_TESTS_FEATURES_PER_IMAGE);
+	SPPoint* copies = (SPPoint*) calloc(size, sizeof(SPPoint));
+	SPBPQueue queue = spBPQueueCreate(SEARCH_TESTS_K);
+	SPSearchIndex index;
+	ASSERT_TRUE(config != NULL && points != NULL && copies != NULL && queue != NULL);
+	ASSERT_TRUE(copyPoints(copies, 0, points, size));
+
+	index = spSearchIndexCreate(config, points, size);
+	ASSERT_TRUE(index != NULL);
+	free(points);
+
+	ASSERT_FALSE(spSearchIndexIsImageRemoved(index, removedImage));
+	ASSERT_TRUE(spSearchIndexRemoveImage(index, removedImage));
+	ASSERT_TRUE(spSearchIndexRemoveImage(index, removedImage));
+	ASSERT_TRUE(spSearchIndexIsImageRemoved(index, removedImage));
+	ASSERT_TRUE(spSearchIndexGetNumOfImages(index) == SEARCH_TESTS_IMAGES);
+
+	// even the features of the removed image itself find other images
+	for (i = 0; i < size; i++) {
+		ASSERT_TRUE(spSearchIndexKNN(index, queue, copies[i]));
+		ASSERT_TRUE(spBPQueueSize(queue) > 0);
+		ASSERT_TRUE(verifyImageNotInQueue(queue, removedImage));
+	}
+
+	spSearchIndexDestroy(index);
+	destroyPointsArray(copies, size);
+	spBPQueueDestroy(queue);
+	spConfigDestroy(config);
+	return true;
+}
+
+//removing an added image restores the results of the original index
+static bool searchIndexRemoveAddedImageTest() {
+	int i, size = SEARCH_TESTS_IMAGES * SEARCH_TESTS_FEATURES_PER_IMAGE;
+	SPConfig config = createDefaultConfig(SEARCH_TESTS_IMAGES,
+			"spIndexType", BRUTE_FORCE_INDEX_TYPE);
+	SPPoint* points = generateImagesFeatures(0, SEARCH_TESTS_IMAGES,
+			SEARCH_TESTS_FEATURES_PER_IMAGE);
+	SPPoint* copies = (SPPoint*) calloc(size, sizeof(SPPoint));
+	// no more added features than k, so the queue never misses live neighbours
+	SPPoint* features = generateImagesFeatures(SEARCH_TESTS_IMAGES, 1, SEARCH_TESTS_K);
+	SPPoint* queries = generateRandomPointsArray(SEARCH_TESTS_DIM, SEARCH_TESTS_QUERIES);
+	SPBPQueue indexQueue = spBPQueueCreate(SEARCH_TESTS_K);
+	SPBPQueue truthQueue = spBPQueueCreate(SEARCH_TESTS_K);
+	SPSearchIndex index;
+	SPBruteForceIndex truth;
+	ASSERT_TRUE(config != NULL && points != NULL && copies != NULL && features != NULL &&
+			queries != NULL && indexQueue != NULL && truthQueue != NULL);
+	ASSERT_TRUE(copyPoints(copies, 0, points, size));
+
+	index = spSearchIndexCreate(config, points, size);
+	ASSERT_TRUE(index != NULL);
+	free(points);
+	truth = spBruteForceIndexCreate(copies, size, 1);
+	ASSERT_TRUE(truth != NULL);
+	free(copies);
+
+	ASSERT_TRUE(spSearchIndexAddImage(index, SEARCH_TESTS_IMAGES, features,
+			SEARCH_TESTS_K));
+	free(features);
+	ASSERT_TRUE(spSearchIndexRemoveImage(index, SEARCH_TESTS_IMAGES));
+
+	for (i = 0; i < SEARCH_TESTS_QUERIES; i++) {
+		ASSERT_TRUE(spSearchIndexKNN(index, indexQueue, queries[i]));
+		ASSERT_TRUE(spBruteForceIndexKNN(truth, truthQueue, queries[i]));
+		ASSERT_TRUE(verifySameQueues(indexQueue, truthQueue));
+	}
+
+	spSearchIndexDestroy(index);
+	spBruteForceIndexDestroy(truth);
+	destroyPointsArray(queries, SEARCH_TESTS_QUERIES);
+	spBPQueueDestroy(indexQueue);
+	spBPQueueDestroy(truthQueue);
+	spConfigDestroy(config);
+	return true;
+}
+
+//a batch search of an updated index equals searching the queries one at a time
+static bool searchIndexUpdatedBatchTest() {
+	int i, size = SEARCH_TESTS_IMAGES * SEARCH_TESTS_FEATURES_PER_IMAGE;
+	bool rslt = true;
+	SPConfig config = createDefaultConfig(SEARCH_TESTS_IMAGES,
+			"spIndexType", BRUTE_FORCE_INDEX_TYPE);
+	SPPoint* points = generateImagesFeatures(0, SEARCH_TESTS_IMAGES,
+			SEARCH_TESTS_FEATURES_PER_IMAGE);
+	SPPoint* features = generateImagesFeatures(SEARCH_TESTS_IMAGES, 1,
+			SEARCH_TESTS_FEATURES_PER_IMAGE);
+	SPPoint* queries = generateRandomPointsArray(SEARCH_TESTS_DIM, SEARCH_TESTS_QUERIES);
+	SPBPQueue batchQueues[SEARCH_TESTS_QUERIES], singleQueue;
+	SPSearchIndex index;
+	ASSERT_TRUE(config != NULL && points != NULL && features != NULL && queries != NULL);
+
+	index = spSearchIndexCreate(config, points, size);
+	ASSERT_TRUE(index != NULL);
+	free(points);
+	ASSERT_TRUE(spSearchIndexAddImage(index, SEARCH_TESTS_IMAGES, features,
+			SEARCH_TESTS_FEATURES_PER_IMAGE));
+	free(features);
+	ASSERT_TRUE(spSearchIndexRemoveImage(index, 0));
+
+	for (i = 0; i < SEARCH_TESTS_QUERIES; i++)
+		ASSERT_TRUE((batchQueues[i] = spBPQueueCreate(SEARCH_TESTS_K)) != NULL);
+	ASSERT_TRUE(spSearchIndexKNNBatch(index, batchQueues, queries, SEARCH_TESTS_QUERIES));
+
+	for (i = 0; i < SEARCH_TESTS_QUERIES; i++) {
+		ASSERT_TRUE((singleQueue = spBPQueueCreate(SEARCH_TESTS_K)) != NULL);
+		ASSERT_TRUE(spSearchIndexKNN(index, singleQueue, queries[i]));
+		rslt = rslt && verifySameQueues(batchQueues[i], singleQueue);
+		spBPQueueDestroy(singleQueue);
+		spBPQueueDestroy(batchQueues[i]);
+	}
+	ASSERT_TRUE(rslt);
+
+	spSearchIndexDestroy(index);
+	destroyPointsArray(queries, SEARCH_TESTS_QUERIES);
+	spConfigDestroy(config);
+	return true;
+}
+
+/*
+ * Searches the queries with a deadline that passed, one that does not pass and none,
+ * and verifies that only the searches that are not stopped equal spSearchIndexKNN
+ */
+static bool verifyDeadlineBatch(char* indexType) {
+	int i, numOfSearched, size = SEARCH_TESTS_IMAGES * SEARCH_TESTS_FEATURES_PER_IMAGE;
+	bool isExpired, rslt = true;
+	SPConfig config = createDefaultConfig(SEARCH_TESTS_IMAGES, "spIndexType", indexType);
+	SPPoint* points = generateImagesFeatures(0, SEARCH_TESTS_IMAGES,
+			SEARCH_TESTS_FEATURES_PER_IMAGE);
+	SPPoint* queries = generateRandomPointsArray(SEARCH_TESTS_DIM, SEARCH_TESTS_QUERIES);
+	SPBPQueue batchQueues[SEARCH_TESTS_QUERIES], singleQueue;
+	SPSearchIndex index;
+	ASSERT_TRUE(config != NULL && points != NULL && queries != NULL);
+
+	index = spSearchIndexCreate(config, points, size);
+	ASSERT_TRUE(index != NULL);
+	free(points);
+	for (i = 0; i < SEARCH_TESTS_QUERIES; i++)
+		ASSERT_TRUE((batchQueues[i] = spBPQueueCreate(SEARCH_TESTS_K)) != NULL);
+
+	ASSERT_FALSE(spSearchIndexKNNBatchWithDeadline(index, batchQueues, queries,
+			SEARCH_TESTS_QUERIES, SEARCH_TESTS_PAST, NULL, &isExpired));
+	ASSERT_TRUE(spSearchIndexKNNBatchWithDeadline(index, batchQueues, queries,
+			SEARCH_TESTS_QUERIES, SEARCH_TESTS_PAST, &numOfSearched, &isExpired));
+	ASSERT_TRUE(numOfSearched == 0 && isExpired);
+	for (i = 0; i < SEARCH_TESTS_QUERIES; i++)
+		ASSERT_TRUE(spBPQueueIsEmpty(batchQueues[i]));
+
+	ASSERT_TRUE(spSearchIndexKNNBatchWithDeadline(index, batchQueues, queries,
+			SEARCH_TESTS_QUERIES, spInstrumentationNow() + SEARCH_TESTS_FUTURE,
+			&numOfSearched, &isExpired));
+	ASSERT_TRUE(numOfSearched == SEARCH_TESTS_QUERIES && !isExpired);
+	for (i = 0; i < SEARCH_TESTS_QUERIES; i++) {
+		ASSERT_TRUE((singleQueue = spBPQueueCreate(SEARCH_TESTS_K)) != NULL);
+		ASSERT_TRUE(spSearchIndexKNN(index, singleQueue, queries[i]));
+		rslt = rslt && verifySameQueues(batchQueues[i], singleQueue);
+		spBPQueueClear(batchQueues[i]);
+		spBPQueueDestroy(singleQueue);
+	}
+	ASSERT_TRUE(rslt);
+
+	ASSERT_TRUE(spSearchIndexKNNBatchWithDeadline(index, batchQueues, queries,
+			SEARCH_TESTS_QUERIES, SP_SEARCH_INDEX_NO_DEADLINE, &numOfSearched, &isExpired));
+	ASSERT_TRUE(numOfSearched == SEARCH_TESTS_QUERIES && !isExpired);
+
+	for (i = 0; i < SEARCH_TESTS_QUERIES; i++)
+		spBPQueueDestroy(batchQueues[i]);
+	spSearchIndexDestroy(index);
+	destroyPointsArray(queries, SEARCH_TESTS_QUERIES);
+	spConfigDestroy(config);
+	return true;
+}
+
+//a KD-tree batch search stops at its deadline
+static bool searchIndexKDTreeDeadlineTest() {
+	return verifyDeadlineBatch(KD_TREE_INDEX_TYPE);
+}
+
+//a brute force batch search, which is a single pass, stops at its deadline
+static bool searchIndexBruteForceDeadlineTest() {
+	return verifyDeadlineBatch(BRUTE_FORCE_INDEX_TYPE);
+}
+
+//a query that is stopped at its deadline still ranks the images
+static bool queryDeadlineTest() {
+	int i, *expected, *topItems;
+	int size = SEARCH_TESTS_IMAGES * SEARCH_TESTS_FEATURES_PER_IMAGE;
+	bool isTruncated = false, rslt = true;
+	SP_CONFIG_MSG msg = SP_CONFIG_SUCCESS;
+	SPConfig config = createDefaultConfig(SEARCH_TESTS_IMAGES,
+			"spIndexType", KD_TREE_INDEX_TYPE);
+	SPPoint* points = generateImagesFeatures(0, SEARCH_TESTS_IMAGES,
+			SEARCH_TESTS_FEATURES_PER_IMAGE);
+	SPQueryContext context = createQueryContext(SEARCH_TESTS_K, SEARCH_TESTS_IMAGES);
+	SPSearchIndex index;
+	struct sp_image_data queryImage;
+	ASSERT_TRUE(config != NULL && points != NULL && context != NULL);
+
+	index = spSearchIndexCreate(config, points, size);
+	ASSERT_TRUE(index != NULL);
+	free(points);
+	queryImage.index = 0;
+	queryImage.numOfFeatures = SEARCH_TESTS_FEATURES_PER_IMAGE * 2;
+	ASSERT_TRUE((queryImage.featuresArray = generateRandomPointsArray(SEARCH_TESTS_DIM,
+			queryImage.numOfFeatures)) != NULL);
+
+	ASSERT_TRUE((expected = getSimilarImagesInContext(context, &queryImage, index,
+			SEARCH_TESTS_IMAGES, SEARCH_TESTS_SIMILAR_IMAGES)) != NULL);
+	ASSERT_TRUE((topItems = getSimilarImagesWithDeadline(context, &queryImage, index,
+			SEARCH_TESTS_IMAGES, SEARCH_TESTS_SIMILAR_IMAGES,
+			spInstrumentationNow() + SEARCH_TESTS_FUTURE, &isTruncated)) != NULL);
+	ASSERT_FALSE(isTruncated);
+	for (i = 0; i < SEARCH_TESTS_SIMILAR_IMAGES; i++)
+		rslt = rslt && topItems[i] == expected[i];
+	free(topItems);
+	ASSERT_TRUE(rslt);
+
+	ASSERT_TRUE((topItems = getSimilarImagesWithDeadline(context, &queryImage, index,
+			SEARCH_TESTS_IMAGES, SEARCH_TESTS_SIMILAR_IMAGES, SEARCH_TESTS_PAST,
+			&isTruncated)) != NULL);
+	ASSERT_TRUE(isTruncated);
+	for (i = 0; i < SEARCH_TESTS_SIMILAR_IMAGES; i++)
+		rslt = rslt && topItems[i] >= 0 && topItems[i] < SEARCH_TESTS_IMAGES;
+	free(topItems);
+	ASSERT_TRUE(rslt);
+
+	// the deadline of a query starts with the query, and only if there is a budget
+	ASSERT_TRUE(getQueryDeadline(config) == SP_SEARCH_INDEX_NO_DEADLINE);
+	ASSERT_TRUE(handleVariable(config, "a", 1, "spQueryDeadline", "100", &msg));
+	ASSERT_TRUE(getQueryDeadline(config) > spInstrumentationNow());
+
+	free(expected);
+	destroyPointsArray(queryImage.featuresArray, queryImage.numOfFeatures);
+	destroyQueryContext(context);
+	spSearchIndexDestroy(index);
+	spConfigDestroy(config);
+	return true;
+}
+
+/*
+ * Searches the similar images of every query image with a context of the thread
+ */
+static void* runQueryThread(void* data) {
+	int i;
+	SearchQueryThread* thread = (SearchQueryThread*) data;
+	SPQueryContext context = createQueryContext(SEARCH_TESTS_K, SEARCH_TESTS_IMAGES);
+
+	thread->success = context != NULL;
+	for (i = 0; thread->success && i < SEARCH_TESTS_QUERY_IMAGES; i++) {
+		thread->success = (thread->similarImages[i] = getSimilarImagesInContext(context,
+				&(thread->queryImages[i]), thread->index, SEARCH_TESTS_IMAGES,
+				SEARCH_TESTS_SIMILAR_IMAGES)) != NULL;
+	}
+
+	destroyQueryContext(context);
+	return NULL;
+}
+
+/*
+ * Searches the same index with several threads at once, each with its own query context,
+ * and verifies that every thread gets the images of a single threaded search
+ */
+static bool verifyConcurrentQueries(char* indexType) {
+	int i, j, t, *expected[SEARCH_TESTS_QUERY_IMAGES];
+	int size = SEARCH_TESTS_IMAGES * SEARCH_TESTS_FEATURES_PER_IMAGE;
+	bool rslt = true;
+	SPConfig config = createDefaultConfig(SEARCH_TESTS_IMAGES, "spIndexType", indexType);
+	SPPoint* points = generateImagesFeatures(0, SEARCH_TESTS_IMAGES,
+			SEARCH_TESTS_FEATURES_PER_IMAGE);
+	SPBPQueue bpq = spBPQueueCreate(SEARCH_TESTS_K);
+	struct sp_image_data queryImages[SEARCH_TESTS_QUERY_IMAGES];
+	SearchQueryThread threads[SEARCH_TESTS_QUERY_THREADS];
+	pthread_t threadIds[SEARCH_TESTS_QUERY_THREADS];
+	SPSearchIndex index;
+	ASSERT_TRUE(config != NULL && points != NULL && bpq != NULL);
+
+	index = spSearchIndexCreate(config, points, size);
+	ASSERT_TRUE(index != NULL);
+	free(points);
+
+	// the reference results, one query at a time
+	for (i = 0; i < SEARCH_TESTS_QUERY_IMAGES; i++) {
+		queryImages[i].index = 0;
+		queryImages[i].numOfFeatures = SEARCH_TESTS_FEATURES_PER_IMAGE * (i + 1);
+		ASSERT_TRUE((queryImages[i].featuresArray = generateRandomPointsArray(
+				SEARCH_TESTS_DIM, queryImages[i].numOfFeatures)) != NULL);
+		ASSERT_TRUE((expected[i] = getSimilarImages(&(queryImages[i]), index,
+				SEARCH_TESTS_IMAGES, SEARCH_TESTS_SIMILAR_IMAGES, bpq)) != NULL);
+	}
+
+	for (t = 0; t < SEARCH_TESTS_QUERY_THREADS; t++) {
+		threads[t].index = index;
+		threads[t].queryImages = queryImages;
+		threads[t].success = false;
+		for (i = 0; i < SEARCH_TESTS_QUERY_IMAGES; i++)
+			threads[t].similarImages[i] = NULL;
+		ASSERT_TRUE(pthread_create(&(threadIds[t]), NULL, runQueryThread, &(threads[t])) == 0);
+	}
+	for (t = 0; t < SEARCH_TESTS_QUERY_THREADS; t++) {
+		pthread_join(threadIds[t], NULL);
+		rslt = rslt && threads[t].success;
+		for (i = 0; i < SEARCH_TESTS_QUERY_IMAGES; i++) {
+			for (j = 0; rslt && j < SEARCH_TESTS_SIMILAR_IMAGES; j++)
+				rslt = threads[t].similarImages[i][j] == expected[i][j];
+			free(threads[t].similarImages[i]);
+		}
+	}
+	ASSERT_TRUE(rslt);
+
+	for (i = 0; i < SEARCH_TESTS_QUERY_IMAGES; i++) {
+		free(expected[i]);
+		destroyPointsArray(queryImages[i].featuresArray, queryImages[i].numOfFeatures);
+	}
+	spSearchIndexDestroy(index);
+	spBPQueueDestroy(bpq);
+	spConfigDestroy(config);
+	return true;
+}
+
+/*
+ * Searches the query points over and over
+ */
+static void* runSearchThread(void* data) {
+	int i;
+	SearchUpdateThread* thread = (SearchUpdateThread*) data;
+	SPBPQueue bpq = spBPQueueCreate(SEARCH_TESTS_K);
+
+	thread->success = bpq != NULL;
+	for (i = 0; thread->success && i < SEARCH_TESTS_THREAD_SEARCHES; i++) {
+		thread->success = spSearchIndexKNN(thread->index, bpq,
+				thread->queries[i % SEARCH_TESTS_QUERIES]);
+		spBPQueueClear(bpq);
+	}
+
+	spBPQueueDestroy(bpq);
+	return NULL;
+}
+
+//images are added (and merged into the tree) and removed while other threads search
+static bool searchIndexConcurrentUpdatesTest() {
+	int i, t, size = SEARCH_TESTS_IMAGES * SEARCH_TESTS_FEATURES_PER_IMAGE;
+	bool rslt = true;
+	SPConfig config = createDefaultConfig(SEARCH_TESTS_IMAGES,
+			"spIndexType", KD_TREE_INDEX_TYPE);
+	SPPoint* points = generateImagesFeatures(0, SEARCH_TESTS_IMAGES,
+			SEARCH_TESTS_FEATURES_PER_IMAGE);
+	SPPoint* queries = generateRandomPointsArray(SEARCH_TESTS_DIM, SEARCH_TESTS_QUERIES);
+	SPPoint* features;
+	SearchUpdateThread threads[SEARCH_TESTS_QUERY_THREADS];
+	pthread_t threadIds[SEARCH_TESTS_QUERY_THREADS];
+	SPSearchIndex index;
+	ASSERT_TRUE(config != NULL && points != NULL && queries != NULL);
+
+	index = spSearchIndexCreate(config, points, size);
+	ASSERT_TRUE(index != NULL);
+	free(points);
+
+	for (t = 0; t < SEARCH_TESTS_QUERY_THREADS; t++) {
+		threads[t].index = index;
+		threads[t].queries = queries;
+		threads[t].success = false;
+		ASSERT_TRUE(pthread_create(&(threadIds[t]), NULL, runSearchThread,
+				&(threads[t])) == 0);
+	}
+	for (i = 0; rslt && i < SEARCH_TESTS_ADDED_IMAGES; i++) {
+		rslt = (features = generateImagesFeatures(SEARCH_TESTS_IMAGES + i, 1,
+				SEARCH_TESTS_MERGED_FEATURES)) != NULL;
+		rslt = rslt && spSearchIndexAddImage(index, SEARCH_TESTS_IMAGES + i, features,
+				SEARCH_TESTS_MERGED_FEATURES);
+		rslt = rslt && spSearchIndexRemoveImage(index, i);
+		free(features);
+	}
+	for (t = 0; t < SEARCH_TESTS_QUERY_THREADS; t++) {
+		pthread_join(threadIds[t], NULL);
+		rslt = rslt && threads[t].success;
+	}
+	ASSERT_TRUE(rslt);
+	ASSERT_TRUE(spSearchIndexGetNumOfImages(index) ==
+			SEARCH_TESTS_IMAGES + SEARCH_TESTS_ADDED_IMAGES);
+
+	spSearchIndexDestroy(index);
+	destroyPointsArray(queries, SEARCH_TESTS_QUERIES);
+	spConfigDestroy(config);
+	return true;
+}
+
+//concurrent queries of a KD-tree each with its own context
+static bool searchIndexConcurrentKDTreeQueriesTest() {
+	return verifyConcurrentQueries(KD_TREE_INDEX_TYPE);
+}
+
+//concurrent queries of a graph index each with its own context
+static bool searchIndexConcurrentHNSWQueriesTest() {
+	return verifyConcurrentQueries(HNSW_INDEX_TYPE);
+}
+
+//a query context is reused by the queries and grows with the number of images
+static bool queryContextTest() {
+	int i, *topItems;
+	int size = SEARCH_TESTS_IMAGES * SEARCH_TESTS_FEATURES_PER_IMAGE;
+	SPConfig config = createDefaultConfig(SEARCH_TESTS_IMAGES,
+			"spIndexType", KD_TREE_INDEX_TYPE);
+	SPPoint* points = generateImagesFeatures(0, SEARCH_TESTS_IMAGES,
+			SEARCH_TESTS_FEATURES_PER_IMAGE);
+	SPPoint* features = generateImagesFeatures(SEARCH_TESTS_IMAGES, 1,
+			SEARCH_TESTS_FEATURES_PER_IMAGE);
+	SPPoint queryFeatures[SEARCH_TESTS_FEATURES_PER_IMAGE];
+	SPQueryContext context;
+	SPSearchIndex index;
+	struct sp_image_data queryImage;
+	ASSERT_TRUE(config != NULL && points != NULL && features != NULL);
+	ASSERT_TRUE(copyPoints(queryFeatures, 0, features, SEARCH_TESTS_FEATURES_PER_IMAGE));
+
+	ASSERT_TRUE(createQueryContext(0, SEARCH_TESTS_IMAGES) == NULL);
+	ASSERT_TRUE(createQueryContext(SEARCH_TESTS_K, 0) == NULL);
+	destroyQueryContext(NULL);
+	ASSERT_TRUE((context = createQueryContext(SEARCH_TESTS_K, 1)) != NULL);
+
+	index = spSearchIndexCreate(config, points, size);
+	ASSERT_TRUE(index != NULL);
+	free(points);
+
+	// the query features are the features of the added image, which is the most similar
+	ASSERT_TRUE(spSearchIndexAddImage(index, SEARCH_TESTS_IMAGES, features,
+			SEARCH_TESTS_FEATURES_PER_IMAGE));
+	queryImage.index = 0;
+	queryImage.numOfFeatures = SEARCH_TESTS_FEATURES_PER_IMAGE;
+	queryImage.featuresArray = queryFeatures;
+	for (i = 0; i < 2; i++) {
+		topItems = getSimilarImagesInContext(context, &queryImage, index,
+				SEARCH_TESTS_IMAGES, 1);
+		ASSERT_TRUE(topItems != NULL && topItems[0] == SEARCH_TESTS_IMAGES);
+		free(topItems);
+	}
+	ASSERT_TRUE(getSimilarImagesInContext(NULL, &queryImage, index, SEARCH_TESTS_IMAGES,
+			1) == NULL);
+
+	free(features);
+	for (i = 0; i < SEARCH_TESTS_FEATURES_PER_IMAGE; i++)
+		spPointDestroy(queryFeatures[i]);
+	destroyQueryContext(context);
+	spSearchIndexDestroy(index);
+	spConfigDestroy(config);
+	return true;
+}
+
+//the user queries that update the index
+static bool indexUpdateQueryTest() {
+	bool isAddition = false;
+	int imageIndex = 0;
+
+	ASSERT_TRUE(parseIndexUpdateQuery("+", &isAddition, &imageIndex));
+	ASSERT_TRUE(isAddition && imageIndex == -1);
+	ASSERT_TRUE(parseIndexUpdateQuery("-17", &isAddition, &imageIndex));
+	ASSERT_TRUE(!isAddition && imageIndex == 17);
+	ASSERT_TRUE(parseIndexUpdateQuery("-0", &isAddition, &imageIndex));
+	ASSERT_TRUE(!isAddition && imageIndex == 0);
+
+	ASSERT_FALSE(parseIndexUpdateQuery("++", &isAddition, &imageIndex));
+	ASSERT_FALSE(parseIndexUpdateQuery("-", &isAddition, &imageIndex));
+	ASSERT_FALSE(parseIndexUpdateQuery("-1a", &isAddition, &imageIndex));
+	ASSERT_FALSE(parseIndexUpdateQuery("--1", &isAddition, &imageIndex));
+	ASSERT_FALSE(parseIndexUpdateQuery("-99999999999", &isAddition, &imageIndex));
+	ASSERT_FALSE(parseIndexUpdateQuery("./images/img1.png", &isAddition, &imageIndex));
+	ASSERT_FALSE(parseIndexUpdateQuery("<>", &isAddition, &imageIndex));
+	return true;
+}
+
+void runSearchIndexTests() {
+	int i;
+	srand(time(NULL));
+	RUN_TEST(searchIndexUpdatesInvalidArgumentsTest);
+	RUN_TEST(indexUpdateQueryTest);
+	for (i = 0; i < SEARCH_RANDOM_TESTS_COUNT; i++) {
+		RUN_TEST(searchIndexAddToKDTreeTest);
+		RUN_TEST(searchIndexAddToBruteForceTest);
+		RUN_TEST(searchIndexMergeIntoKDTreeTest);
+		RUN_TEST(searchIndexRemoveImageTest);
+		RUN_TEST(searchIndexRemoveAddedImageTest);
+		RUN_TEST(searchIndexUpdatedBatchTest);
+		RUN_TEST(searchIndexConcurrentKDTreeQueriesTest);
+		RUN_TEST(searchIndexConcurrentHNSWQueriesTest);
+		RUN_TEST(searchIndexConcurrentUpdatesTest);
+		RUN_TEST(queryContextTest);
+		RUN_TEST(searchIndexKDTreeDeadlineTest);
+		RUN_TEST(searchIndexBruteForceDeadlineTest);
+		RUN_TEST(queryDeadlineTest);
+	}
+}
@@ -0,0 +1,8 @@
+#ifndef SPSEARCHINDEXUNITTEST_H_
+#define SPSEARCHINDEXUNITTEST_H_
+
+
+
+void runSearchIndexTests();
+
+#endif /* SPSEARCHINDEXUNITTEST_H_ */
@@ -0,0 +1,284 @@
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "unit_test_util.h"
+#include "SPShardedIndexUnitTest.h"
+#include "../data_structures/index_ds/SPShardedIndex.h"
+#include "../data_structures/index_ds/SPSearchIndex.h"
+#include "../data_structures/kd_ds/SPKDTreeNode.h"
+#include "../data_structures/kd_ds/SPKDTreeNodeKNN.h"
+#include "../data_structures/bpqueue_ds/SPBPriorityQueue.h"
+#include "../main_and_ui/SPImageQuery.h"
+#include "SPKDArrayUnitTest.h"
+#include "SPBPQueueUnitTest.h"
+#include "../SPConfig.h"
+#include "../SPPoint.h"
+
+#define SHARDED_TESTS_DIM					12
+#define SHARDED_TESTS_SIZE					2000
+#define SHARDED_TESTS_IMAGES				17 // not a multiple of the number of shards
+#define SHARDED_TESTS_SHARDS				4
+#define SHARDED_TESTS_K						7
+#define SHARDED_TESTS_QUERIES				21
+#define SHARDED_TESTS_SIMILAR_IMAGES		5
+#define SHARDED_RANDOM_TESTS_COUNT			3
+
+/*
+ * Returns size random points, point i belongs to image i % numOfImages
+ */
+static SPPoint* generateImagesPoints(int size, int numOfImages) {
+	int i;
+	SPPoint* points = (SPPoint*) calloc(size, sizeof(SPPoint));
+	if (points == NULL)
+		return NULL;
+	for (i = 0; i < size; i++) {
+		if ((points[i] = generateRandomPoint(SHARDED_TESTS_DIM, i % numOfImages)) == NULL) {
+			destroyPointsArray(points, i);
+			return NULL;
+		}
+	}
+	return points;
+}
+
+/*
+ * Builds a sharded index and a single KD-tree over the same random points, and verifies
+ * that both find exactly the same neighbours, one query at a time and in a batch
+ */
+static bool verifyKDTreeAgreement(int numOfImages, int numOfShards) {
+	int i;
+	SPPoint* points = generateImagesPoints(SHARDED_TESTS_SIZE, numOfImages);
+	SPPoint* copies = points == NULL ? NULL : copyPointsArray(points, SHARDED_TESTS_SIZE);
+	SPPoint* queries = generateRandomPointsArray(SHARDED_TESTS_DIM, SHARDED_TESTS_QUERIES);
+	SPBPQueue treeQueue = spBPQueueCreate(SHARDED_TESTS_K);
+	SPBPQueue indexQueue = spBPQueueCreate(SHARDED_TESTS_K);
+	SPBPQueue batchQueues[SHARDED_TESTS_QUERIES];
+	SPShardedIndex index;
+	SPKDTreeNode tree;
+	ASSERT_TRUE(points != NULL && copies != NULL && queries != NULL &&
+			treeQueue != NULL && indexQueue != NULL);
+
+	tree = InitKDTreeFromPoints(copies, SHARDED_TESTS_SIZE, MAX_SPREAD);
+	ASSERT_TRUE(tree != NULL);
+	index = spShardedIndexCreate(points, SHARDED_TESTS_SIZE, numOfImages, numOfShards,
+			MAX_SPREAD);
+	ASSERT_TRUE(index != NULL);
+	free(points);
+
+	for (i = 0; i < SHARDED_TESTS_QUERIES; i++) {
+		ASSERT_TRUE(kNearestNeighbors(tree, treeQueue, queries[i]));
+		ASSERT_TRUE(spShardedIndexKNN(index, indexQueue, queries[i]));
+		ASSERT_TRUE(verifySameQueues(treeQueue, indexQueue));
+	}
+
+	// a different k for each query of the batch
+	for (i = 0; i < SHARDED_TESTS_QUERIES; i++)
+		ASSERT_TRUE((batchQueues[i] = spBPQueueCreate(1 + i % SHARDED_TESTS_K)) != NULL);
+	ASSERT_TRUE(spShardedIndexKNNBatch(index, batchQueues, queries, SHARDED_TESTS_QUERIES));
+	for (i = 0; i < SHARDED_TESTS_QUERIES; i++) {
+		spBPQueueDestroy(treeQueue);
+		ASSERT_TRUE((treeQueue = spBPQueueCreate(1 + i % SHARDED_TESTS_K)) != NULL);
+		ASSERT_TRUE(kNearestNeighbors(tree, treeQueue, queries[i]));
+		ASSERT_TRUE(verifySameQueues(treeQueue, batchQueues[i]));
+		spBPQueueDestroy(batchQueues[i]);
+	}
+
+	spShardedIndexDestroy(index);
+	spKDTreeDestroy(tree, true);
+	free(copies);
+	destroyPointsArray(queries, SHARDED_TESTS_QUERIES);
+	spBPQueueDestroy(treeQueue);
+	spBPQueueDestroy(indexQueue);
+	return true;
+}
+
+//invalid arguments test
+static bool shardedIndexInvalidArgumentsTest() {
+	SPPoint* points = generateImagesPoints(SHARDED_TESTS_SIZE, SHARDED_TESTS_IMAGES);
+	SPPoint queryPoint = generateRandomPoint(SHARDED_TESTS_DIM + 1, 0);
+	SPBPQueue queue = spBPQueueCreate(SHARDED_TESTS_K);
+	SPShardedIndex index;
+	ASSERT_TRUE(points != NULL && queryPoint != NULL && queue != NULL);
+
+	ASSERT_TRUE(spShardedIndexCreate(NULL, SHARDED_TESTS_SIZE, SHARDED_TESTS_IMAGES,
+			SHARDED_TESTS_SHARDS, MAX_SPREAD) == NULL);
+	ASSERT_TRUE(spShardedIndexCreate(points, 0, SHARDED_TESTS_IMAGES,
+			SHARDED_TESTS_SHARDS, MAX_SPREAD) == NULL);
+	ASSERT_TRUE(spShardedIndexCreate(points, SHARDED_TESTS_SIZE, SHARDED_TESTS_IMAGES,
+			0, MAX_SPREAD) == NULL);
+	// an image index out of range
+	ASSERT_TRUE(spShardedIndexCreate(points, SHARDED_TESTS_SIZE, SHARDED_TESTS_IMAGES - 1,
+			SHARDED_TESTS_SHARDS, MAX_SPREAD) == NULL);
+	ASSERT_TRUE(spShardedIndexGetNumOfShards(NULL) == -1);
+	spShardedIndexDestroy(NULL);
+
+	// a failed creation does not take ownership, a successful one does
+	index = spShardedIndexCreate(points, SHARDED_TESTS_SIZE, SHARDED_TESTS_IMAGES,
+			SHARDED_TESTS_SHARDS, MAX_SPREAD);
+	ASSERT_TRUE(index != NULL);
+	free(points);
+	ASSERT_TRUE(spShardedIndexGetNumOfShards(index) == SHARDED_TESTS_SHARDS);
+
+	// dimension mismatch
+	ASSERT_FALSE(spShardedIndexKNN(index, queue, queryPoint));
+	ASSERT_FALSE(spShardedIndexKNN(NULL, queue, queryPoint));
+	ASSERT_FALSE(spShardedIndexKNNBatch(index, &queue, &queryPoint, 0));
+	ASSERT_TRUE(spBPQueueIsEmpty(queue));
+
+	spShardedIndexDestroy(index);
+	spPointDestroy(queryPoint);
+	spBPQueueDestroy(queue);
+	return true;
+}
+
+//the shards find the same neighbours as a single KD-tree
+static bool shardedIndexAgreementTest() {
+	return verifyKDTreeAgreement(SHARDED_TESTS_IMAGES, SHARDED_TESTS_SHARDS);
+}
+
+//more shards than images, each image is a shard of its own
+static bool shardedIndexMoreShardsThanImagesTest() {
+	return verifyKDTreeAgreement(3, SHARDED_TESTS_SHARDS * 2);
+}
+
+//a shard without descriptors has no worker, and the other shards still answer
+static bool shardedIndexEmptyShardTest() {
+	int i;
+	SPPoint* points = generateImagesPoints(SHARDED_TESTS_SIZE, SHARDED_TESTS_IMAGES / 2);
+	SPPoint* copies = points == NULL ? NULL : copyPointsArray(points, SHARDED_TESTS_SIZE);
+	SPPoint* queries = generateRandomPointsArray(SHARDED_TESTS_DIM, SHARDED_TESTS_QUERIES);
+	SPBPQueue treeQueue = spBPQueueCreate(SHARDED_TESTS_K);
+	SPBPQueue indexQueue = spBPQueueCreate(SHARDED_TESTS_K);
+	SPShardedIndex index;
+	SPKDTreeNode tree;
+	ASSERT_TRUE(points != NULL && copies != NULL && queries != NULL &&
+			treeQueue != NULL && indexQueue != NULL);
+
+	// the upper images, and the shards that hold them, have no descriptors
+	tree = InitKDTreeFromPoints(copies, SHARDED_TESTS_SIZE, MAX_SPREAD);
+	ASSERT_TRUE(tree != NULL);
+	index = spShardedIndexCreate(points, SHARDED_TESTS_SIZE, SHARDED_TESTS_IMAGES,
+			SHARDED_TESTS_SHARDS, MAX_SPREAD);
+	ASSERT_TRUE(index != NULL);
+	free(points);
+
+	for (i = 0; i < SHARDED_TESTS_QUERIES; i++) {
+		ASSERT_TRUE(kNearestNeighbors(tree, treeQueue, queries[i]));
+		ASSERT_TRUE(spShardedIndexKNN(index, indexQueue, queries[i]));
+		ASSERT_TRUE(verifySameQueues(treeQueue, indexQueue));
+	}
+
+	spShardedIndexDestroy(index);
+	spKDTreeDestroy(tree, true);
+	free(copies);
+	destroyPointsArray(queries, SHARDED_TESTS_QUERIES);
+	spBPQueueDestroy(treeQueue);
+	spBPQueueDestroy(indexQueue);
+	return true;
+}
+
+//points added to the smallest shards are found as a single KD-tree finds them
+static bool shardedIndexAddPointsTest() {
+	int i, added = SHARDED_TESTS_SIZE / 4;
+	SPPoint* points = generateImagesPoints(SHARDED_TESTS_SIZE, SHARDED_TESTS_IMAGES);
+	SPPoint* copies = points == NULL ? NULL : copyPointsArray(points, SHARDED_TESTS_SIZE);
+	SPPoint* queries = generateRandomPointsArray(SHARDED_TESTS_DIM, SHARDED_TESTS_QUERIES);
+	SPPoint otherPoint = generateRandomPoint(SHARDED_TESTS_DIM + 1, 0);
+	SPBPQueue treeQueue = spBPQueueCreate(SHARDED_TESTS_K);
+	SPBPQueue indexQueue = spBPQueueCreate(SHARDED_TESTS_K);
+	SPShardedIndex index;
+	SPKDTreeNode tree;
+	ASSERT_TRUE(points != NULL && copies != NULL && queries != NULL &&
+			otherPoint != NULL && treeQueue != NULL && indexQueue != NULL);
+
+	// the last points are added in two groups after the index is created
+	tree = InitKDTreeFromPoints(copies, SHARDED_TESTS_SIZE, MAX_SPREAD);
+	ASSERT_TRUE(tree != NULL);
+	index = spShardedIndexCreate(points, SHARDED_TESTS_SIZE - 2 * added,
+			SHARDED_TESTS_IMAGES, SHARDED_TESTS_SHARDS, MAX_SPREAD);
+	ASSERT_TRUE(index != NULL);
+
+	ASSERT_FALSE(spShardedIndexAddPoints(NULL, points, 1));
+	ASSERT_FALSE(spShardedIndexAddPoints(index, points, 0));
+	ASSERT_FALSE(spShardedIndexAddPoints(index, &otherPoint, 1));
+	ASSERT_TRUE(spShardedIndexAddPoints(index, points + SHARDED_TESTS_SIZE - 2 * added,
+			added));
+	ASSERT_TRUE(spShardedIndexAddPoints(index, points + SHARDED_TESTS_SIZE - added,
+			added));
+	free(points);
+
+	for (i = 0; i < SHARDED_TESTS_QUERIES; i++) {
+		ASSERT_TRUE(kNearestNeighbors(tree, treeQueue, queries[i]));
+		ASSERT_TRUE(spShardedIndexKNN(index, indexQueue, queries[i]));
+		ASSERT_TRUE(verifySameQueues(treeQueue, indexQueue));
+	}
+
+	spShardedIndexDestroy(index);
+	spKDTreeDestroy(tree, true);
+	free(copies);
+	destroyPointsArray(queries, SHARDED_TESTS_QUERIES);
+	spPointDestroy(otherPoint);
+	spBPQueueDestroy(treeQueue);
+	spBPQueueDestroy(indexQueue);
+	return true;
+}
+
+//the images selected through a sharded search index are the single process ones
+static bool shardedIndexSimilarImagesTest() {
+	int i, *singleImages, *shardedImages;
+	SPConfig singleConfig = createDefaultConfig(SHARDED_TESTS_IMAGES, "spNumOfShards", "1");
+	SPConfig shardedConfig = createDefaultConfig(SHARDED_TESTS_IMAGES, "spNumOfShards", "4");
+	SPPoint* points = generateImagesPoints(SHARDED_TESTS_SIZE, SHARDED_TESTS_IMAGES);
+	SPPoint* copies = points == NULL ? NULL : copyPointsArray(points, SHARDED_TESTS_SIZE);
+	SPBPQueue bpq = spBPQueueCreate(SHARDED_TESTS_K);
+	SPSearchIndex singleIndex, shardedIndex;
+	sp_image_data workingImage;
+	ASSERT_TRUE(singleConfig != NULL && shardedConfig != NULL && points != NULL &&
+			copies != NULL && bpq != NULL);
+
+	singleIndex = spSearchIndexCreate(singleConfig, points, SHARDED_TESTS_SIZE);
+	ASSERT_TRUE(singleIndex != NULL);
+	free(points);
+	shardedIndex = spSearchIndexCreate(shardedConfig, copies, SHARDED_TESTS_SIZE);
+	ASSERT_TRUE(shardedIndex != NULL);
+	free(copies);
+
+	// more features than a single search batch
+	workingImage.index = 0;
+	workingImage.numOfFeatures = 100;
+	workingImage.featuresArray = generateRandomPointsArray(SHARDED_TESTS_DIM,
+			workingImage.numOfFeatures);
+	ASSERT_TRUE(workingImage.featuresArray != NULL);
+
+	singleImages = getSimilarImages(&workingImage, singleIndex, SHARDED_TESTS_IMAGES,
+			SHARDED_TESTS_SIMILAR_IMAGES, bpq);
+	shardedImages = getSimilarImages(&workingImage, shardedIndex, SHARDED_TESTS_IMAGES,
+			SHARDED_TESTS_SIMILAR_IMAGES, bpq);
+	ASSERT_TRUE(singleImages != NULL && shardedImages != NULL);
+	for (i = 0; i < SHARDED_TESTS_SIMILAR_IMAGES; i++)
+		ASSERT_TRUE(singleImages[i] == shardedImages[i]);
+
+	free(singleImages);
+	free(shardedImages);
+	destroyPointsArray(workingImage.featuresArray, workingImage.numOfFeatures);
+	spSearchIndexDestroy(singleIndex);
+	spSearchIndexDestroy(shardedIndex);
+	spBPQueueDestroy(bpq);
+	spConfigDestroy(singleConfig);
+	spConfigDestroy(shardedConfig);
+	return true;
+}
+
+void runShardedIndexTests() {
+	int i;
+	srand(time(NULL));
+	RUN_TEST(shardedIndexInvalidArgumentsTest);
+	for (i = 0; i < SHARDED_RANDOM_TESTS_COUNT; i++) {
+		RUN_TEST(shardedIndexAgreementTest);
+		RUN_TEST(shardedIndexMoreShardsThanImagesTest);
+		RUN_TEST(shardedIndexEmptyShardTest);
+		RUN_TEST(shardedIndexAddPointsTest);
+		RUN_TEST(shardedIndexSimilarImagesTest);
+	}
+}
@@ -0,0 +1,8 @@
+#ifndef SPSHARDEDINDEXUNITTEST_H_
+#define SPSHARDEDINDEXUNITTEST_H_
+
+
+
+void runShardedIndexTests();
+
+#endif /* SPSHARDEDINDEXUNITTEST_H_ */
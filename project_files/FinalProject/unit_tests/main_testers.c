@@ -34,6 +34,21 @@ Please read the following regarding the unit tests:
 #include "SPListUnitTest.h"
 #include "SPBPQueueUnitTest.h"
 #include "SPKDTreeNodeKNNUnitTest.h"
+#include "SPPQIndexUnitTest.h"
+#include "SPIVFIndexUnitTest.h"
+#include "SPHNSWIndexUnitTest.h"
+#include "SPBoVWIndexUnitTest.h"
+#include "SPBruteForceIndexUnitTest.h"
+#include "SPSearchIndexUnitTest.h"
+#include "SPShardedIndexUnitTest.h"
+#include "SPLoggerUnitTest.h"
+#include "SPInstrumentationUnitTest.h"
+#include "SPFeatsReaderUnitTest.h"
+#include "SPFeatsWriterUnitTest.h"
+#include "SPManifestUnitTest.h"
+#include "SPQueryCacheUnitTest.h"
+#include "SPPCAProjectionUnitTest.h"
+#include "SPPCAFileUnitTest.h"
 
 
 #define TESTS_START_DECORATION		"-------------%s Tests Start-------------\n"
@@ -42,13 +57,28 @@ Please read the following regarding the unit tests:
 #define MAIN_FAILURE_RET_VAL		-1
 #define STDOUT						"stdout"
 #define	IMAGES_PARSER_SEC_NAME		"Images Parser"
+#define	FEATS_READER_SEC_NAME		"Feats Reader"
+#define	FEATS_WRITER_SEC_NAME		"Feats Writer"
+#define	MANIFEST_SEC_NAME			"Manifest"
+#define	QUERY_CACHE_SEC_NAME		"Query Cache"
 #define	CONFIG_SEC_NAME				"Configuration"
 #define	KDARRAY_SEC_NAME			"KDArray"
 #define	KDTREE_NODE_SEC_NAME		"KDTree Node"
 #define	KDTREE_NODE_KNN_SEC_NAME	"KDTree Node KNN"
 #define	LIST_SEC_NAME				"List"
 #define	POINT_SEC_NAME				"Point"
+#define	PCA_PROJECTION_SEC_NAME		"PCA Projection"
+#define	PCA_FILE_SEC_NAME			"PCA File"
 #define	BPQ_SEC_NAME				"B Priority Queue"
+#define	PQ_INDEX_SEC_NAME			"PQ Index"
+#define	IVF_INDEX_SEC_NAME			"IVF Index"
+#define	HNSW_INDEX_SEC_NAME			"HNSW Index"
+#define	BOVW_INDEX_SEC_NAME			"BoVW Index"
+#define	BRUTE_INDEX_SEC_NAME		"Brute Force Index"
+#define	SEARCH_INDEX_SEC_NAME		"Search Index"
+#define	SHARDED_INDEX_SEC_NAME		"Sharded Index"
+#define	LOGGER_SEC_NAME				"Logger"
+#define	INSTRUMENTATION_SEC_NAME	"Instrumentation"
 
 #define testDecorator(testFunction, sectionName) do {				\
 	printf(TESTS_START_DECORATION, sectionName);	\
@@ -68,15 +98,30 @@ int main() {
 	spLoggerCreate(!strcmp(loggerFilename, STDOUT) ? NULL : loggerFilename,
 			spConfigGetLoggerLevel(config, &msg));
 	testDecorator(runImagesParserTests(config), IMAGES_PARSER_SEC_NAME);
+	testDecorator(runFeatsReaderTests(), FEATS_READER_SEC_NAME);
+	testDecorator(runFeatsWriterTests(), FEATS_WRITER_SEC_NAME);
+	testDecorator(runManifestTests(), MANIFEST_SEC_NAME);
+	testDecorator(runQueryCacheTests(), QUERY_CACHE_SEC_NAME);
 	testDecorator(runConfigTests(), CONFIG_SEC_NAME);
 	testDecorator(runKDArrayTests(), KDARRAY_SEC_NAME);
 	testDecorator(runKDTreeNodeTests(), KDTREE_NODE_SEC_NAME);
 	testDecorator(runKDTreeNodeKNNTests(), KDTREE_NODE_KNN_SEC_NAME);
 	testDecorator(runListTests(), LIST_SEC_NAME);
 	testDecorator(runPointTests(), POINT_SEC_NAME);
+	testDecorator(runPCAProjectionTests(), PCA_PROJECTION_SEC_NAME);
+	testDecorator(runPCAFileTests(), PCA_FILE_SEC_NAME);
 	testDecorator(runBPQueueTests(), BPQ_SEC_NAME);
+	testDecorator(runPQIndexTests(), PQ_INDEX_SEC_NAME);
+	testDecorator(runIVFIndexTests(), IVF_INDEX_SEC_NAME);
+	testDecorator(runHNSWIndexTests(), HNSW_INDEX_SEC_NAME);
+	testDecorator(runBoVWIndexTests(), BOVW_INDEX_SEC_NAME);
+	testDecorator(runBruteForceIndexTests(), BRUTE_INDEX_SEC_NAME);
+	testDecorator(runSearchIndexTests(), SEARCH_INDEX_SEC_NAME);
+	testDecorator(runShardedIndexTests(), SHARDED_INDEX_SEC_NAME);
+	testDecorator(runInstrumentationTests(), INSTRUMENTATION_SEC_NAME);
 	spConfigDestroy(config);
 	spLoggerDestroy();
+	testDecorator(runLoggerTests(), LOGGER_SEC_NAME); // creates its own loggers
 	return 0;
 }
 */
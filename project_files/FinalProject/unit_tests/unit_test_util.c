@@ -0,0 +1,26 @@
+#include <stdlib.h>
+#include "unit_test_util.h"
+
+SPConfig createDefaultConfig(int numOfImages, char* variableName, char* value) {
+	SP_CONFIG_MSG msg = SP_CONFIG_SUCCESS;
+	SPConfig config = (SPConfig) calloc(1, spConfigGetConfigStructSize());
+	if (config == NULL)
+		return NULL;
+	initConfigToDefault(config);
+	spConfigSetImagesNum(config, numOfImages);
+	if (variableName != NULL && !handleVariable(config, "a", 1, variableName, value,
+			&msg)) {
+		spConfigDestroy(config);
+		return NULL;
+	}
+	return config;
+}
+
+bool writeFile(const char* filename, const char* content) {
+	FILE* file = fopen(filename, "w");
+	if (file == NULL)
+		return false;
+	fputs(content, file);
+	fclose(file);
+	return true;
+}
@@ -5,6 +5,8 @@
 extern "C" {
 #endif
 #include <stdio.h>
+#include <stdbool.h>
+#include "../SPConfig.h"
 
 
 #define FAIL(msg) do {\
@@ -39,9 +41,18 @@ extern "C" {
 			}else{ fprintf(stderr, "%s  FAIL\n",#f);\
 			} }while (0)
 
-
-
-
+/*
+ * Returns a default configuration of numOfImages images in which the given variable is
+ * set to value (as if it was read from a configuration file), or NULL in case of an
+ * error. No variable is set if variableName is NULL.
+ */
+SPConfig createDefaultConfig(int numOfImages, char* variableName, char* value);
+
+/*
+ * Writes the given content to a file, an existing file is replaced.
+ * Returns false if the file could not be opened.
+ */
+bool writeFile(const char* filename, const char* content);
 
 #ifdef __cplusplus
 }